@@ -0,0 +1,3 @@
+
+#include "boost/system/system_error.hpp"
+
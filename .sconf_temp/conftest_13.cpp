@@ -0,0 +1,3 @@
+
+#include "boost/thread.hpp"
+
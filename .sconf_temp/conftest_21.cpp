@@ -0,0 +1,3 @@
+
+#include "boost/archive/text_oarchive.hpp"
+
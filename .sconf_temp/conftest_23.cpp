@@ -0,0 +1,3 @@
+
+#include "boost/date_time/date.hpp"
+
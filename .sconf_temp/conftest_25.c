@@ -0,0 +1,8 @@
+
+#include <boost/version.hpp>
+#include <stdio.h>
+
+int main(int argc, char* argv[]) {
+    printf("%d\n", BOOST_VERSION);
+    return 0;
+}
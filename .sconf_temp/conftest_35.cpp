@@ -0,0 +1,9 @@
+
+
+#include "lua.hpp"
+
+int
+main() {
+  
+return 0;
+}
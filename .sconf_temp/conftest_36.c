@@ -0,0 +1,3 @@
+
+#include "avahi-client/client.h"
+
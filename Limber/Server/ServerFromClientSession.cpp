@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -75,7 +75,9 @@ void ServerFromClientSession::handleElement(std::shared_ptr<ToplevelElement> ele
         }
         else if (IQ* iq = dynamic_cast<IQ*>(element.get())) {
             if (std::shared_ptr<ResourceBind> resourceBind = iq->getPayload<ResourceBind>()) {
-                setRemoteJID(JID(user_, getLocalJID().getDomain(), resourceBind->getResource()));
+                // Clients that do not ask for a resource get the session ID
+                std::string resource = resourceBind->getResource().empty() ? id_ : resourceBind->getResource();
+                setRemoteJID(JID(user_, getLocalJID().getDomain(), resource));
                 std::shared_ptr<ResourceBind> resultResourceBind(new ResourceBind());
                 resultResourceBind->setJID(getRemoteJID());
                 getXMPPLayer()->writeElement(IQ::createResult(JID(), iq->getID(), resultResourceBind));
@@ -109,6 +111,11 @@ void ServerFromClientSession::handleStreamStart(const ProtocolHeader& incomingHe
     getXMPPLayer()->writeElement(features);
 }
 
+void ServerFromClientSession::handleStreamEnd() {
+    // Close our side of the stream when the client closes theirs
+    finishSession();
+}
+
 void ServerFromClientSession::setInitialized() {
     initialized = true;
     onSessionStarted();
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,6 +16,8 @@
 #include <Swiften/Network/Connection.h>
 #include <Swiften/Session/Session.h>
 
+#include <Limber/Server/ServerSession.h>
+
 namespace Swift {
     class ProtocolHeader;
     class ToplevelElement;
@@ -29,7 +31,7 @@ namespace Swift {
     class Connection;
     class XMLParserFactory;
 
-    class ServerFromClientSession : public Session {
+    class ServerFromClientSession : public Session, public ServerSession {
         public:
             ServerFromClientSession(
                     const std::string& id,
@@ -42,9 +44,22 @@ namespace Swift {
             boost::signals2::signal<void ()> onSessionStarted;
             void setAllowSASLEXTERNAL();
 
+            virtual const JID& getJID() const {
+                return getRemoteJID();
+            }
+
+            virtual int getPriority() const {
+                return 0;
+            }
+
+            virtual void sendStanza(std::shared_ptr<Stanza> stanza) {
+                sendElement(stanza);
+            }
+
         private:
             void handleElement(std::shared_ptr<ToplevelElement>);
             void handleStreamStart(const ProtocolHeader& header);
+            void handleStreamEnd();
 
             void setInitialized();
             bool isInitialized() const {
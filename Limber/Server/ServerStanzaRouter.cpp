@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -60,7 +60,7 @@ bool ServerStanzaRouter::routeStanza(std::shared_ptr<Stanza> stanza) {
     }
 
     // Find the session with the highest priority
-    std::vector<ServerSession*>::const_iterator i = std::max_element(clientSessions_.begin(), clientSessions_.end(), PriorityLessThan());
+    std::vector<ServerSession*>::const_iterator i = std::max_element(candidateSessions.begin(), candidateSessions.end(), PriorityLessThan());
     (*i)->sendStanza(stanza);
     return true;
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -21,6 +21,7 @@ class ServerStanzaRouterTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testRouteStanza_FullJIDWithOnlyBareJIDMatchingSession);
         CPPUNIT_TEST(testRouteStanza_BareJIDWithoutMatchingSession);
         CPPUNIT_TEST(testRouteStanza_BareJIDWithMultipleSessions);
+        CPPUNIT_TEST(testRouteStanza_BareJIDWithSessionsOfOtherUsers);
         CPPUNIT_TEST(testRouteStanza_BareJIDWithOnlyNegativePriorities);
         CPPUNIT_TEST(testRouteStanza_BareJIDWithChangingPresence);
         CPPUNIT_TEST_SUITE_END();
@@ -98,6 +99,20 @@ class ServerStanzaRouterTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(session3.sentStanzas.size()));
         }
 
+        void testRouteStanza_BareJIDWithSessionsOfOtherUsers() {
+            ServerStanzaRouter testling;
+            MockServerSession session1(JID("foo@bar.com/Bla"), 1);
+            testling.addClientSession(&session1);
+            MockServerSession session2(JID("baz@bar.com/Bla"), 8);
+            testling.addClientSession(&session2);
+
+            bool result = testling.routeStanza(createMessageTo("foo@bar.com"));
+
+            CPPUNIT_ASSERT(result);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(session1.sentStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(session2.sentStanzas.size()));
+        }
+
         void testRouteStanza_BareJIDWithOnlyNegativePriorities() {
             ServerStanzaRouter testling;
             MockServerSession session(JID("foo@bar.com/Bla"), -1);
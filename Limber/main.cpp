@@ -1,13 +1,15 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
+#include <iostream>
 #include <memory>
 #include <string>
 
 #include <boost/bind.hpp>
+#include <boost/program_options.hpp>
 
 #include <Swiften/Base/IDGenerator.h>
 #include <Swiften/Elements/IQ.h>
@@ -26,14 +28,15 @@
 #include <Swiften/Serializer/PayloadSerializers/FullPayloadSerializerCollection.h>
 
 #include <Limber/Server/ServerFromClientSession.h>
+#include <Limber/Server/ServerStanzaRouter.h>
 #include <Limber/Server/SimpleUserRegistry.h>
 
 using namespace Swift;
 
 class Server {
     public:
-        Server(UserRegistry* userRegistry, EventLoop* eventLoop) : userRegistry_(userRegistry) {
-            serverFromClientConnectionServer_ = BoostConnectionServer::create(5222, boostIOServiceThread_.getIOService(), eventLoop);
+        Server(UserRegistry* userRegistry, EventLoop* eventLoop, int port) : userRegistry_(userRegistry) {
+            serverFromClientConnectionServer_ = BoostConnectionServer::create(port, boostIOServiceThread_.getIOService(), eventLoop);
             serverFromClientConnectionServer_->onNewConnection.connect(boost::bind(&Server::handleNewConnection, this, _1));
             serverFromClientConnectionServer_->start();
         }
@@ -43,11 +46,13 @@ class Server {
             std::shared_ptr<ServerFromClientSession> session(new ServerFromClientSession(idGenerator_.generateID(), c, &payloadParserFactories_, &payloadSerializers_, &xmlParserFactory, userRegistry_));
             serverFromClientSessions_.push_back(session);
             session->onElementReceived.connect(boost::bind(&Server::handleElementReceived, this, _1, session));
+            session->onSessionStarted.connect(boost::bind(&ServerStanzaRouter::addClientSession, &stanzaRouter_, session.get()));
             session->onSessionFinished.connect(boost::bind(&Server::handleSessionFinished, this, session));
             session->startSession();
         }
 
         void handleSessionFinished(std::shared_ptr<ServerFromClientSession> session) {
+            stanzaRouter_.removeClientSession(session.get());
             serverFromClientSessions_.erase(std::remove(serverFromClientSessions_.begin(), serverFromClientSessions_.end(), session), serverFromClientSessions_.end());
         }
 
@@ -65,7 +70,7 @@ class Server {
                     if (iq->getPayload<RosterPayload>()) {
                         session->sendElement(IQ::createResult(iq->getFrom(), iq->getID(), std::make_shared<RosterPayload>()));
                     }
-                    if (iq->getPayload<VCard>()) {
+                    else if (iq->getPayload<VCard>()) {
                         if (iq->getType() == IQ::Get) {
                             std::shared_ptr<VCard> vcard(new VCard());
                             vcard->setNickname(iq->getFrom().getNode());
@@ -80,6 +85,12 @@ class Server {
                     }
                 }
             }
+            else if (!stanzaRouter_.routeStanza(stanza)) {
+                std::shared_ptr<IQ> iq = std::dynamic_pointer_cast<IQ>(stanza);
+                if (iq && (iq->getType() == IQ::Get || iq->getType() == IQ::Set)) {
+                    session->sendElement(IQ::createError(iq->getFrom(), iq->getID(), ErrorPayload::ServiceUnavailable, ErrorPayload::Cancel));
+                }
+            }
         }
 
     private:
@@ -89,18 +100,48 @@ class Server {
         BoostIOServiceThread boostIOServiceThread_;
         std::shared_ptr<BoostConnectionServer> serverFromClientConnectionServer_;
         std::vector< std::shared_ptr<ServerFromClientSession> > serverFromClientSessions_;
+        ServerStanzaRouter stanzaRouter_;
         FullPayloadParserFactoryCollection payloadParserFactories_;
         FullPayloadSerializerCollection payloadSerializers_;
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+    int port = 5222;
+    int userCount = 0;
+    std::string domain;
+    std::string password;
+    boost::program_options::options_description desc("Options");
+    desc.add_options()
+        ("help", "Show this help message")
+        ("port", boost::program_options::value<int>(&port)->default_value(port), "Port to listen on")
+        ("users", boost::program_options::value<int>(&userCount)->default_value(userCount), "Number of extra users user1 ... userN to accept, e.g. for BenchTool")
+        ("domain", boost::program_options::value<std::string>(&domain)->default_value("localhost"), "Domain of the extra users")
+        ("password", boost::program_options::value<std::string>(&password)->default_value("password"), "Password of the extra users")
+        ;
+    boost::program_options::variables_map vm;
+    try {
+        boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
+        boost::program_options::notify(vm);
+    }
+    catch (const boost::program_options::error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+    if (vm.count("help") > 0) {
+        std::cout << "Usage: " << argv[0] << " [OPTIONS]" << std::endl << desc << std::endl;
+        return 0;
+    }
+
     SimpleEventLoop eventLoop;
     SimpleUserRegistry userRegistry;
     userRegistry.addUser(JID("remko@localhost"), "remko");
     userRegistry.addUser(JID("kevin@localhost"), "kevin");
     userRegistry.addUser(JID("remko@limber.swift.im"), "remko");
     userRegistry.addUser(JID("kevin@limber.swift.im"), "kevin");
-    Server server(&userRegistry, &eventLoop);
+    for (int i = 1; i <= userCount; ++i) {
+        userRegistry.addUser(JID("user" + std::to_string(i), domain), password);
+    }
+    Server server(&userRegistry, &eventLoop, port);
     eventLoop.run();
     return 0;
 }
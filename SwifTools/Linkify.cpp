@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,11 +9,17 @@
 #include <iostream>
 #include <sstream>
 
-#include <boost/regex.hpp>
-
 namespace Swift {
 
-static boost::regex linkifyRegexp("^(https?://|xmpp:).*");
+static bool startsLink(const std::string& input, size_t position) {
+    static const std::string prefixes[] = { "http://", "https://", "xmpp:" };
+    for (const auto& prefix : prefixes) {
+        if (input.compare(position, prefix.size(), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
 std::string Linkify::linkify(const std::string& input) {
     std::ostringstream result;
@@ -34,7 +40,7 @@ std::string Linkify::linkify(const std::string& input) {
             }
         }
         else {
-            if (boost::regex_match(input.substr(i, 8), linkifyRegexp)) {
+            if (startsLink(input, i)) {
                 currentURL.push_back(c);
                 inURL = true;
             }
@@ -76,7 +82,7 @@ std::pair<std::vector<std::string>, size_t> Linkify::splitLink(const std::string
             }
         }
         else {
-            if (boost::regex_match(input.substr(i, 8), linkifyRegexp)) {
+            if (startsLink(input, i)) {
                 urlStartsAt = i;
                 inURL = true;
                 if (i > 0) {
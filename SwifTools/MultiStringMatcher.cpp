@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <SwifTools/MultiStringMatcher.h>
+
+#include <algorithm>
+#include <deque>
+
+namespace Swift {
+
+static const size_t NO_NODE = static_cast<size_t>(-1);
+
+MultiStringMatcher::MultiStringMatcher() : caseInsensitive_(false), nodes_(1) {
+}
+
+MultiStringMatcher::MultiStringMatcher(const std::vector<std::string>& patterns, bool caseInsensitive) : caseInsensitive_(caseInsensitive), nodes_(1) {
+    // Build the trie of all patterns
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        patternLengths_.push_back(patterns[i].size());
+        if (patterns[i].empty()) {
+            continue;
+        }
+        size_t node = 0;
+        for (char c : patterns[i]) {
+            unsigned char normalized = normalize(c);
+            size_t next = findTransition(node, normalized);
+            if (next == NO_NODE) {
+                next = nodes_.size();
+                std::vector<std::pair<unsigned char, size_t> >& transitions = nodes_[node].transitions;
+                auto position = std::lower_bound(transitions.begin(), transitions.end(), std::make_pair(normalized, static_cast<size_t>(0)));
+                transitions.insert(position, std::make_pair(normalized, next));
+                nodes_.push_back(Node());
+            }
+            node = next;
+        }
+        nodes_[node].patterns.push_back(i);
+    }
+
+    // Compute the failure links breadth first, so the failure target of a
+    // node is always complete before the node itself is visited
+    std::deque<size_t> queue;
+    for (const auto& transition : nodes_[0].transitions) {
+        queue.push_back(transition.second);
+    }
+    while (!queue.empty()) {
+        size_t node = queue.front();
+        queue.pop_front();
+        for (const auto& transition : nodes_[node].transitions) {
+            size_t child = transition.second;
+            size_t failure = nodes_[node].failure;
+            size_t next = findTransition(failure, transition.first);
+            while (next == NO_NODE && failure != 0) {
+                failure = nodes_[failure].failure;
+                next = findTransition(failure, transition.first);
+            }
+            nodes_[child].failure = (next == NO_NODE) ? 0 : next;
+            const std::vector<size_t>& inherited = nodes_[nodes_[child].failure].patterns;
+            nodes_[child].patterns.insert(nodes_[child].patterns.end(), inherited.begin(), inherited.end());
+            queue.push_back(child);
+        }
+    }
+}
+
+bool MultiStringMatcher::isEmpty() const {
+    return nodes_.size() == 1;
+}
+
+std::vector<MultiStringMatcher::Match> MultiStringMatcher::findAll(const std::string& text) const {
+    std::vector<Match> result;
+    if (isEmpty()) {
+        return result;
+    }
+    size_t node = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = normalize(text[i]);
+        size_t next = findTransition(node, c);
+        while (next == NO_NODE && node != 0) {
+            node = nodes_[node].failure;
+            next = findTransition(node, c);
+        }
+        node = (next == NO_NODE) ? 0 : next;
+        for (size_t pattern : nodes_[node].patterns) {
+            result.push_back(Match(pattern, i + 1 - patternLengths_[pattern], i + 1));
+        }
+    }
+    return result;
+}
+
+size_t MultiStringMatcher::findTransition(size_t node, unsigned char c) const {
+    const std::vector<std::pair<unsigned char, size_t> >& transitions = nodes_[node].transitions;
+    auto i = std::lower_bound(transitions.begin(), transitions.end(), std::make_pair(c, static_cast<size_t>(0)));
+    if (i != transitions.end() && i->first == c) {
+        return i->second;
+    }
+    return NO_NODE;
+}
+
+unsigned char MultiStringMatcher::normalize(char c) const {
+    unsigned char result = static_cast<unsigned char>(c);
+    if (caseInsensitive_ && result >= 'A' && result <= 'Z') {
+        result = static_cast<unsigned char>(result - 'A' + 'a');
+    }
+    return result;
+}
+
+}
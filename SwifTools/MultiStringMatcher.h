@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Swift {
+    /**
+     * Finds all occurrences of a fixed set of strings in a text, in a single
+     * pass over the text (using an Aho-Corasick automaton).
+     *
+     * The automaton is built once, when the matcher is constructed; create a
+     * new matcher when the set of strings changes.
+     */
+    class MultiStringMatcher {
+        public:
+            struct Match {
+                Match(size_t pattern, size_t begin, size_t end) : pattern(pattern), begin(begin), end(end) {}
+
+                /** The index of the matching string in the list passed to the constructor */
+                size_t pattern;
+                size_t begin;
+                size_t end;
+            };
+
+        public:
+            MultiStringMatcher();
+
+            /**
+             * Empty strings never match. When \p caseInsensitive is set, ASCII
+             * letters match regardless of their case.
+             */
+            MultiStringMatcher(const std::vector<std::string>& patterns, bool caseInsensitive = false);
+
+            bool isEmpty() const;
+
+            /**
+             * Returns all (possibly overlapping) occurrences of the strings in
+             * \p text, ordered by their end position.
+             */
+            std::vector<Match> findAll(const std::string& text) const;
+
+        private:
+            struct Node {
+                std::vector<std::pair<unsigned char, size_t> > transitions;
+                size_t failure = 0;
+                std::vector<size_t> patterns;
+            };
+
+            size_t findTransition(size_t node, unsigned char c) const;
+            unsigned char normalize(char c) const;
+
+        private:
+            bool caseInsensitive_;
+            std::vector<size_t> patternLengths_;
+            std::vector<Node> nodes_;
+    };
+}
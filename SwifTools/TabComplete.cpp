@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,43 +12,89 @@
 
 namespace Swift {
 
+TabComplete::TabComplete() : nextStamp_(0) {
+}
+
 void TabComplete::addWord(const std::string& word) {
-    words_.erase(std::remove(words_.begin(), words_.end(), word), words_.end());
-    words_.insert(words_.begin(), word);
-    if (boost::starts_with(boost::to_lower_copy(word), lastShort_)) {
-        lastCompletionCandidates_.insert(lastCompletionCandidates_.begin(), word);
+    auto i = words_.find(word);
+    if (i == words_.end()) {
+        i = words_.insert(std::make_pair(word, index_.insert(std::make_pair(std::make_pair(boost::to_lower_copy(word), word), 0)).first)).first;
+    }
+    else {
+        Candidates::iterator candidate = findCandidate(i->second->second);
+        if (candidate != lastCompletionCandidates_.end()) {
+            lastCompletionCandidates_.erase(candidate);
+        }
+    }
+    Index::iterator entry = i->second;
+    entry->second = nextStamp_++;
+    if (lastShort_ && boost::starts_with(entry->first.first, *lastShort_)) {
+        lastCompletionCandidates_.push_back(entry);
     }
 }
 
 void TabComplete::removeWord(const std::string& word) {
-    words_.erase(std::remove(words_.begin(), words_.end(), word), words_.end());
-    lastCompletionCandidates_.erase(std::remove(lastCompletionCandidates_.begin(), lastCompletionCandidates_.end(), word), lastCompletionCandidates_.end());
+    auto i = words_.find(word);
+    if (i == words_.end()) {
+        return;
+    }
+    Candidates::iterator candidate = findCandidate(i->second->second);
+    if (candidate != lastCompletionCandidates_.end()) {
+        lastCompletionCandidates_.erase(candidate);
+    }
+    index_.erase(i->second);
+    words_.erase(i);
 }
 
 std::string TabComplete::completeWord(const std::string& word) {
-    if (word == lastCompletion_) {
+    if (lastShort_ && word == lastCompletion_) {
         if (!lastCompletionCandidates_.empty()) {
-            size_t match = 0;
-            for (match = 0; match < lastCompletionCandidates_.size(); match++) {
-                if (lastCompletionCandidates_[match] == lastCompletion_) {
-                    break;
+            // Move on to the candidate added before the last completion, or
+            // start over from the most recent one.
+            Candidates::iterator next = lastCompletionCandidates_.end();
+            auto current = words_.find(lastCompletion_);
+            if (current != words_.end()) {
+                Candidates::iterator candidate = findCandidate(current->second->second);
+                if (candidate != lastCompletionCandidates_.begin() && candidate != lastCompletionCandidates_.end()) {
+                    next = candidate;
                 }
             }
-            size_t nextIndex = match + 1;
-            nextIndex = nextIndex >= lastCompletionCandidates_.size() ? 0 : nextIndex;
-            lastCompletion_ = lastCompletionCandidates_[nextIndex];
+            lastCompletion_ = (*--next)->first.second;
         }
     } else {
-        lastShort_ = boost::to_lower_copy(word);
+        findCandidates(boost::to_lower_copy(word));
+        lastCompletion_ = !lastCompletionCandidates_.empty() ? lastCompletionCandidates_.back()->first.second : word;
+    }
+    return lastCompletion_;
+}
+
+void TabComplete::findCandidates(const std::string& folded) {
+    if (lastShort_ && boost::starts_with(folded, *lastShort_)) {
+        // The word was extended, so the candidates are among the previous ones
+        lastCompletionCandidates_.erase(std::remove_if(lastCompletionCandidates_.begin(), lastCompletionCandidates_.end(), [&](const Index::const_iterator& candidate) {
+            return !boost::starts_with(candidate->first.first, folded);
+        }), lastCompletionCandidates_.end());
+    }
+    else {
         lastCompletionCandidates_.clear();
-        for (auto&& candidate : words_) {
-            if (boost::starts_with(boost::to_lower_copy(candidate), boost::to_lower_copy(word))) {
-                lastCompletionCandidates_.push_back(candidate);
-            }
+        for (auto i = index_.lower_bound(std::make_pair(folded, std::string())); i != index_.end() && boost::starts_with(i->first.first, folded); ++i) {
+            lastCompletionCandidates_.push_back(i);
         }
-        lastCompletion_ = !lastCompletionCandidates_.empty() ? lastCompletionCandidates_[0] : word;
+        std::sort(lastCompletionCandidates_.begin(), lastCompletionCandidates_.end(), [](const Index::const_iterator& a, const Index::const_iterator& b) {
+            return a->second < b->second;
+        });
     }
-    return lastCompletion_;
+    lastShort_ = folded;
+}
+
+TabComplete::Candidates::iterator TabComplete::findCandidate(uint64_t stamp) {
+    Candidates::iterator candidate = std::lower_bound(lastCompletionCandidates_.begin(), lastCompletionCandidates_.end(), stamp, [](const Index::const_iterator& candidate, uint64_t stamp) {
+        return candidate->second < stamp;
+    });
+    if (candidate != lastCompletionCandidates_.end() && (*candidate)->second != stamp) {
+        return lastCompletionCandidates_.end();
+    }
+    return candidate;
 }
 
 }
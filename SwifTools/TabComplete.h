@@ -1,24 +1,54 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <cstdint>
+#include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <boost/optional.hpp>
+
 namespace Swift {
+    /**
+     * Completes words case-insensitively, offering the most recently added
+     * words first.
+     *
+     * The words are kept in an index sorted on their lowercase form, so
+     * adding and removing words takes logarithmic time. The candidates of
+     * the completion in progress are kept up to date as words are added and
+     * removed, and are reused when the word being completed is extended.
+     */
     class TabComplete {
         public:
+            TabComplete();
+
             void addWord(const std::string& word);
             void removeWord(const std::string& word);
             std::string completeWord(const std::string& word);
+
+        private:
+            // When each word was last added, by its lowercase form and the word
+            typedef std::map<std::pair<std::string, std::string>, uint64_t> Index;
+
+            // Ordered on stamp, so the most recently added word is last
+            typedef std::vector<Index::const_iterator> Candidates;
+
+            void findCandidates(const std::string& folded);
+            Candidates::iterator findCandidate(uint64_t stamp);
+
         private:
-            std::vector<std::string> words_;
+            Index index_;
+            std::unordered_map<std::string, Index::iterator> words_;
+            uint64_t nextStamp_;
             std::string lastCompletion_;
-            std::string lastShort_;
-            std::vector<std::string> lastCompletionCandidates_;
+            boost::optional<std::string> lastShort_;
+            Candidates lastCompletionCandidates_;
     };
 }
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <SwifTools/MultiStringMatcher.h>
+
+using namespace Swift;
+
+class MultiStringMatcherTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(MultiStringMatcherTest);
+        CPPUNIT_TEST(testFindAll_NoPatterns);
+        CPPUNIT_TEST(testFindAll_NoMatch);
+        CPPUNIT_TEST(testFindAll_MultipleOccurrences);
+        CPPUNIT_TEST(testFindAll_OverlappingPatterns);
+        CPPUNIT_TEST(testFindAll_FailureTransitions);
+        CPPUNIT_TEST(testFindAll_CaseSensitive);
+        CPPUNIT_TEST(testFindAll_CaseInsensitive);
+        CPPUNIT_TEST(testFindAll_EmptyPatternIgnored);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void testFindAll_NoPatterns() {
+            MultiStringMatcher testling;
+
+            CPPUNIT_ASSERT(testling.isEmpty());
+            CPPUNIT_ASSERT(testling.findAll("foo").empty());
+        }
+
+        void testFindAll_NoMatch() {
+            MultiStringMatcher testling({":)", ":("});
+
+            CPPUNIT_ASSERT(testling.findAll("no smileys here").empty());
+        }
+
+        void testFindAll_MultipleOccurrences() {
+            MultiStringMatcher testling({":)", ":("});
+
+            std::vector<MultiStringMatcher::Match> matches = testling.findAll(":) and :( and :)");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), matches.size());
+            assertMatch(0, 0, 2, matches[0]);
+            assertMatch(1, 7, 9, matches[1]);
+            assertMatch(0, 14, 16, matches[2]);
+        }
+
+        void testFindAll_OverlappingPatterns() {
+            MultiStringMatcher testling({"he", "she", "hers"});
+
+            std::vector<MultiStringMatcher::Match> matches = testling.findAll("ushers");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), matches.size());
+            assertMatch(1, 1, 4, matches[0]);
+            assertMatch(0, 2, 4, matches[1]);
+            assertMatch(2, 2, 6, matches[2]);
+        }
+
+        void testFindAll_FailureTransitions() {
+            MultiStringMatcher testling({"abcd", "bce"});
+
+            std::vector<MultiStringMatcher::Match> matches = testling.findAll("abce");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), matches.size());
+            assertMatch(1, 1, 4, matches[0]);
+        }
+
+        void testFindAll_CaseSensitive() {
+            MultiStringMatcher testling({"Alice"});
+
+            CPPUNIT_ASSERT(testling.findAll("alice").empty());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.findAll("Alice").size());
+        }
+
+        void testFindAll_CaseInsensitive() {
+            MultiStringMatcher testling({"Alice"}, true);
+
+            std::vector<MultiStringMatcher::Match> matches = testling.findAll("aLiCe and ALICE");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), matches.size());
+            assertMatch(0, 0, 5, matches[0]);
+            assertMatch(0, 10, 15, matches[1]);
+        }
+
+        void testFindAll_EmptyPatternIgnored() {
+            MultiStringMatcher testling({"", "b"});
+
+            std::vector<MultiStringMatcher::Match> matches = testling.findAll("abc");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), matches.size());
+            assertMatch(1, 1, 2, matches[0]);
+        }
+
+    private:
+        void assertMatch(size_t pattern, size_t begin, size_t end, const MultiStringMatcher::Match& match) {
+            CPPUNIT_ASSERT_EQUAL(pattern, match.pattern);
+            CPPUNIT_ASSERT_EQUAL(begin, match.begin);
+            CPPUNIT_ASSERT_EQUAL(end, match.end);
+        }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MultiStringMatcherTest);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -21,6 +21,11 @@ class TabCompleteTest : public CppUnit::TestFixture {
     CPPUNIT_TEST(testRemoveDuringComplete);
     CPPUNIT_TEST(testAddDuringComplete);
     CPPUNIT_TEST(testSwiftRoomSample);
+    CPPUNIT_TEST(testCaseInsensitive);
+    CPPUNIT_TEST(testReaddedWordFirst);
+    CPPUNIT_TEST(testExtendWord);
+    CPPUNIT_TEST(testExtendWord_AddDuringComplete);
+    CPPUNIT_TEST(testShortenWord);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -256,7 +261,58 @@ public:
 
     }
 
+    void testCaseInsensitive() {
+        completer_.addWord("alice");
+        completer_.addWord("ALBERT");
+        completer_.addWord("Bob");
 
+        CPPUNIT_ASSERT_EQUAL(std::string("ALBERT"), completer_.completeWord("aL"));
+        CPPUNIT_ASSERT_EQUAL(std::string("alice"), completer_.completeWord("ALBERT"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Bob"), completer_.completeWord("b"));
+    }
+
+    void testReaddedWordFirst() {
+        completer_.addWord("Kevin");
+        completer_.addWord("Kevlar");
+        completer_.addWord("Kevin");
+
+        CPPUNIT_ASSERT_EQUAL(std::string("Kevin"), completer_.completeWord("Kev"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Kevlar"), completer_.completeWord("Kevin"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Kevin"), completer_.completeWord("Kevlar"));
+    }
+
+    void testExtendWord() {
+        completer_.addWord("Remko");
+        completer_.addWord("Remove");
+        completer_.addWord("Rebecca");
+
+        CPPUNIT_ASSERT_EQUAL(std::string("Rebecca"), completer_.completeWord("Re"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Remove"), completer_.completeWord("Rem"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Remko"), completer_.completeWord("Remove"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Remko"), completer_.completeWord("Remk"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Remko"), completer_.completeWord("Remko"));
+    }
+
+    void testExtendWord_AddDuringComplete() {
+        completer_.addWord("Remko");
+        CPPUNIT_ASSERT_EQUAL(std::string("Remko"), completer_.completeWord("R"));
+
+        completer_.addWord("Remedial");
+        completer_.addWord("Rubbish");
+        completer_.removeWord("Remko");
+
+        CPPUNIT_ASSERT_EQUAL(std::string("Remedial"), completer_.completeWord("Re"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Remedial"), completer_.completeWord("Remedial"));
+    }
+
+    void testShortenWord() {
+        completer_.addWord("Remko");
+        completer_.addWord("Rubbish");
+
+        CPPUNIT_ASSERT_EQUAL(std::string("Remko"), completer_.completeWord("Re"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Rubbish"), completer_.completeWord("R"));
+        CPPUNIT_ASSERT_EQUAL(std::string("Remko"), completer_.completeWord("Rubbish"));
+    }
 
 private:
     TabComplete completer_;
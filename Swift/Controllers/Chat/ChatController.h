@@ -9,6 +9,7 @@
 #include <map>
 #include <string>
 
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Base/Tristate.h>
 
 #include <Swift/Controllers/Chat/ChatControllerBase.h>
@@ -112,6 +113,7 @@ namespace Swift {
             boost::signals2::scoped_connection blockingOnItemAddedConnection_;
             boost::signals2::scoped_connection blockingOnItemRemovedConnection_;
             boost::signals2::scoped_connection continuationsBrokenConnection_;
+            ScopedSignalConnection stanzaAckedConnection_;
 
             boost::optional<ChatWindow::AlertID> deliveryReceiptAlert_;
             boost::optional<ChatWindow::AlertID> blockedContactAlert_;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2017 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,24 +7,44 @@
 #include <Swift/Controllers/Chat/ChatMessageParser.h>
 
 #include <algorithm>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
-#include <boost/regex.hpp>
 
-#include <Swiften/Base/Regex.h>
 #include <Swiften/Base/String.h>
 
 #include <SwifTools/Linkify.h>
 
 namespace Swift {
 
-    ChatMessageParser::ChatMessageParser(const std::map<std::string, std::string>& emoticons, std::shared_ptr<HighlightConfiguration> highlightConfiguration, Mode mode) : emoticons_(emoticons), highlightConfiguration_(highlightConfiguration), mode_(mode) {
+    typedef std::pair<std::string, std::string> StringPair;
+
+    static bool isWhitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
     }
 
-    typedef std::pair<std::string, std::string> StringPair;
+    static bool isWordCharacter(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    /* Whether there is a word boundary (as \b in a regular expression) at the given position */
+    static bool isWordBoundary(const std::string& text, size_t position) {
+        bool wordBefore = position > 0 && isWordCharacter(text[position - 1]);
+        bool wordAfter = position < text.size() && isWordCharacter(text[position]);
+        return wordBefore != wordAfter;
+    }
+
+    ChatMessageParser::ChatMessageParser(const std::map<std::string, std::string>& emoticons, std::shared_ptr<HighlightConfiguration> highlightConfiguration, Mode mode) : emoticons_(emoticons.begin(), emoticons.end()), highlightConfiguration_(highlightConfiguration), mode_(mode) {
+        std::vector<std::string> emoticonTexts;
+        for (const auto& emoticon : emoticons_) {
+            emoticonTexts.push_back(emoticon.first);
+        }
+        emoticonMatcher_ = MultiStringMatcher(emoticonTexts);
+    }
 
     ChatWindow::ChatMessage ChatMessageParser::parseMessageBody(const std::string& body, const std::string& senderNickname, bool senderIsSelf) {
         ChatWindow::ChatMessage parsedMessage;
@@ -74,159 +94,191 @@ namespace Swift {
     }
 
     ChatWindow::ChatMessage ChatMessageParser::emoticonHighlight(const ChatWindow::ChatMessage& message) {
-        ChatWindow::ChatMessage parsedMessage = message;
+        if (emoticonMatcher_.isEmpty()) {
+            return message;
+        }
 
-        std::string regexString;
         /* Parse two, emoticons */
-        for (StringPair emoticon : emoticons_) {
-            /* Construct a regexp that finds an instance of any of the emoticons inside a group
-             * at the start or end of the line, or beside whitespace.
-             */
-            regexString += regexString.empty() ? "" : "|";
-            std::string escaped = "(" + Regex::escape(emoticon.first) + ")";
-            regexString += "^" + escaped + "|";
-            regexString += escaped + "$|";
-            regexString += "\\s" + escaped + "|";
-            regexString += escaped + "\\s";
-
-        }
-        if (!regexString.empty()) {
-            regexString += "";
-            boost::regex emoticonRegex(regexString);
-
-            ChatWindow::ChatMessage newMessage;
-            for (const auto& part : parsedMessage.getParts()) {
-                std::shared_ptr<ChatWindow::ChatTextMessagePart> textPart;
-                if ((textPart = std::dynamic_pointer_cast<ChatWindow::ChatTextMessagePart>(part))) {
-                    try {
-                        boost::match_results<std::string::const_iterator> match;
-                        const std::string& text = textPart->text;
-                        std::string::const_iterator start = text.begin();
-                        while (regex_search(start, text.end(), match, emoticonRegex)) {
-                            int matchIndex = 0;
-                            for (matchIndex = 1; matchIndex < static_cast<int>(match.size()); matchIndex++) {
-                                if (match[matchIndex].length() > 0) {
-                                    //This is the matching subgroup
-                                    break;
-                                }
-                            }
-                            std::string::const_iterator matchStart = match[matchIndex].first;
-                            std::string::const_iterator matchEnd = match[matchIndex].second;
-                            if (start != matchStart) {
-                                /* If we're skipping over plain text since the previous emoticon, record it as plain text */
-                                newMessage.append(std::make_shared<ChatWindow::ChatTextMessagePart>(std::string(start, matchStart)));
-                            }
-                            std::shared_ptr<ChatWindow::ChatEmoticonMessagePart> emoticonPart = std::make_shared<ChatWindow::ChatEmoticonMessagePart>();
-                            std::string matchString = match[matchIndex].str();
-                            std::map<std::string, std::string>::const_iterator emoticonIterator = emoticons_.find(matchString);
-                            assert (emoticonIterator != emoticons_.end());
-                            const StringPair& emoticon = *emoticonIterator;
-                            emoticonPart->imagePath = emoticon.second;
-                            emoticonPart->alternativeText = emoticon.first;
-                            newMessage.append(emoticonPart);
-                            start = matchEnd;
-                        }
-                        if (start != text.end()) {
-                            /* If there's plain text after the last emoticon, record it */
-                            newMessage.append(std::make_shared<ChatWindow::ChatTextMessagePart>(std::string(start, text.end())));
-                        }
+        ChatWindow::ChatMessage newMessage;
+        for (const auto& part : message.getParts()) {
+            std::shared_ptr<ChatWindow::ChatTextMessagePart> textPart = std::dynamic_pointer_cast<ChatWindow::ChatTextMessagePart>(part);
+            if (!textPart) {
+                newMessage.append(part);
+                continue;
+            }
+            const std::string& text = textPart->text;
+            std::vector<MultiStringMatcher::Match> matches = emoticonMatcher_.findAll(text);
+            if (matches.empty()) {
+                newMessage.append(part);
+                continue;
+            }
+            std::sort(matches.begin(), matches.end(), [](const MultiStringMatcher::Match& a, const MultiStringMatcher::Match& b) {
+                return a.begin < b.begin || (a.begin == b.begin && a.pattern < b.pattern);
+            });
 
+            size_t start = 0;
+            size_t next = 0;
+            while (true) {
+                /* An emoticon has to be at the start or end of the text (or right after the previous emoticon), or beside
+                 * whitespace. The first one found wins, counting a leading whitespace as part of it; emoticons found at the
+                 * same position are taken in the order of the emoticon map.
+                 */
+                while (next < matches.size() && matches[next].begin < start) {
+                    next++;
+                }
+                const MultiStringMatcher::Match* emoticonMatch = nullptr;
+                size_t emoticonMatchStart = 0;
+                for (size_t i = next; i < matches.size() && (!emoticonMatch || matches[i].begin <= emoticonMatchStart + 1); i++) {
+                    const MultiStringMatcher::Match& match = matches[i];
+                    size_t matchStart = 0;
+                    if (match.begin > start && isWhitespace(text[match.begin - 1])) {
+                        matchStart = match.begin - 1;
+                    }
+                    else if (match.begin == start || match.end == text.size() || isWhitespace(text[match.end])) {
+                        matchStart = match.begin;
+                    }
+                    else {
+                        continue;
                     }
-                    catch (const std::runtime_error&) {
-                        /* Basically too expensive to compute the regex results and it gave up, so pass through as text */
-                        newMessage.append(part);
+                    if (!emoticonMatch || matchStart < emoticonMatchStart || (matchStart == emoticonMatchStart && match.pattern < emoticonMatch->pattern)) {
+                        emoticonMatch = &match;
+                        emoticonMatchStart = matchStart;
                     }
                 }
-                else {
-                    newMessage.append(part);
+                if (!emoticonMatch) {
+                    break;
                 }
+                if (start != emoticonMatch->begin) {
+                    /* If we're skipping over plain text since the previous emoticon, record it as plain text */
+                    newMessage.append(std::make_shared<ChatWindow::ChatTextMessagePart>(text.substr(start, emoticonMatch->begin - start)));
+                }
+                std::shared_ptr<ChatWindow::ChatEmoticonMessagePart> emoticonPart = std::make_shared<ChatWindow::ChatEmoticonMessagePart>();
+                const StringPair& emoticon = emoticons_[emoticonMatch->pattern];
+                emoticonPart->imagePath = emoticon.second;
+                emoticonPart->alternativeText = emoticon.first;
+                newMessage.append(emoticonPart);
+                start = emoticonMatch->end;
+            }
+            if (start != text.size()) {
+                /* If there's plain text after the last emoticon, record it */
+                newMessage.append(std::make_shared<ChatWindow::ChatTextMessagePart>(text.substr(start)));
             }
-            parsedMessage.setParts(newMessage.getParts());
         }
 
+        ChatWindow::ChatMessage parsedMessage = message;
+        parsedMessage.setParts(newMessage.getParts());
         return parsedMessage;
     }
 
     ChatWindow::ChatMessage ChatMessageParser::splitHighlight(const ChatWindow::ChatMessage& message) {
-        auto keywordToRegEx = [](const std::string& keyword, bool matchCaseSensitive) {
-            std::string escaped = Regex::escape(keyword);
-            boost::regex::flag_type flags = boost::regex::normal;
-            if (!matchCaseSensitive) {
-                flags |= boost::regex::icase;
-            }
-            return boost::regex("\\b" + escaped + "\\b", flags);
-        };
-
-        auto highlightKeywordInChatMessage = [&](const ChatWindow::ChatMessage& message, const std::string& keyword, bool matchCaseSensitive, const HighlightAction& action) {
-            ChatWindow::ChatMessage resultMessage;
-
-            for (const auto& part : message.getParts()) {
-                std::shared_ptr<ChatWindow::ChatTextMessagePart> textPart;
-                if ((textPart = std::dynamic_pointer_cast<ChatWindow::ChatTextMessagePart>(part))) {
-                    try {
-                        boost::match_results<std::string::const_iterator> match;
-                        const std::string& text = textPart->text;
-                        std::string::const_iterator start = text.begin();
-                        while (regex_search(start, text.end(), match, keywordToRegEx(keyword, matchCaseSensitive))) {
-                            std::string::const_iterator matchStart = match[0].first;
-                            std::string::const_iterator matchEnd = match[0].second;
-                            if (start != matchStart) {
-                                /* If we're skipping over plain text since the previous emoticon, record it as plain text */
-                                resultMessage.append(std::make_shared<ChatWindow::ChatTextMessagePart>(std::string(start, matchStart)));
-                            }
-                            std::shared_ptr<ChatWindow::ChatHighlightingMessagePart> highlightPart = std::make_shared<ChatWindow::ChatHighlightingMessagePart>();
-                            highlightPart->text = match.str();
-                            highlightPart->action = action;
-                            resultMessage.append(highlightPart);
-                            start = matchEnd;
-                        }
-                        if (start != text.end()) {
-                            /* If there's plain text after the last emoticon, record it */
-                            resultMessage.append(std::make_shared<ChatWindow::ChatTextMessagePart>(std::string(start, text.end())));
-                        }
-                    }
-                    catch (const std::runtime_error&) {
-                        /* Basically too expensive to compute the regex results and it gave up, so pass through as text */
-                        resultMessage.append(part);
-                    }
-                } else {
-                    resultMessage.append(part);
-                }
-            }
-            return resultMessage;
+        struct KeywordRule {
+            const std::string* keyword;
+            bool matchCaseSensitive;
+            const HighlightAction* action;
         };
 
-        ChatWindow::ChatMessage parsedMessage = message;
-
-        // detect mentions of own nickname
+        // Mentions of the own nickname take precedence over the keywords, which take precedence in the order they are configured.
         HighlightAction ownMentionKeywordAction = highlightConfiguration_->ownMentionAction;
         ownMentionKeywordAction.setSoundFilePath(boost::optional<std::string>());
         ownMentionKeywordAction.setSystemNotificationEnabled(false);
-        if (!getNick().empty() && !highlightConfiguration_->ownMentionAction.isEmpty()) {
-            auto nicknameHighlightedMessage = highlightKeywordInChatMessage(parsedMessage, nick_, false, ownMentionKeywordAction);
-            auto highlightedParts = nicknameHighlightedMessage.getParts();
-            auto ownNicknamePart = std::find_if(highlightedParts.begin(), highlightedParts.end(), [&](std::shared_ptr<ChatWindow::ChatMessagePart>& part){
-                auto highlightPart = std::dynamic_pointer_cast<ChatWindow::ChatHighlightingMessagePart>(part);
-                if (highlightPart && highlightPart->text == nick_) {
-                    return true;
-                }
-                return false;
-            });
-            if (ownNicknamePart != highlightedParts.end()) {
-                parsedMessage.setHighlightActionOwnMention(highlightConfiguration_->ownMentionAction);
-            }
-            parsedMessage.setParts(nicknameHighlightedMessage.getParts());
-        }
+        bool detectOwnMentions = !getNick().empty() && !highlightConfiguration_->ownMentionAction.isEmpty();
 
-        // detect keywords
+        std::vector<KeywordRule> rules;
+        if (detectOwnMentions) {
+            rules.push_back({&nick_, false, &ownMentionKeywordAction});
+        }
         for (const auto& keywordHighlight : highlightConfiguration_->keywordHighlights) {
             if (keywordHighlight.keyword.empty() || keywordHighlight.action.isEmpty()) {
                 continue;
             }
-            auto newMessage = highlightKeywordInChatMessage(parsedMessage, keywordHighlight.keyword, keywordHighlight.matchCaseSensitive, keywordHighlight.action);
-            parsedMessage.setParts(newMessage.getParts());
+            rules.push_back({&keywordHighlight.keyword, keywordHighlight.matchCaseSensitive, &keywordHighlight.action});
+        }
+        if (rules.empty()) {
+            return message;
+        }
+
+        bool keywordsChanged = rules.size() != highlightKeywords_.size() || !std::equal(rules.begin(), rules.end(), highlightKeywords_.begin(), [](const KeywordRule& rule, const std::string& keyword) {
+            return *rule.keyword == keyword;
+        });
+        if (keywordsChanged) {
+            highlightKeywords_.clear();
+            for (const auto& rule : rules) {
+                highlightKeywords_.push_back(*rule.keyword);
+            }
+            // Case sensitive keywords are checked against the matched text afterwards
+            highlightMatcher_ = MultiStringMatcher(highlightKeywords_, true);
+        }
+
+        ChatWindow::ChatMessage parsedMessage = message;
+        ChatWindow::ChatMessage newMessage;
+        bool ownMentionFound = false;
+        for (const auto& part : message.getParts()) {
+            std::shared_ptr<ChatWindow::ChatTextMessagePart> textPart = std::dynamic_pointer_cast<ChatWindow::ChatTextMessagePart>(part);
+            if (!textPart) {
+                newMessage.append(part);
+                continue;
+            }
+            const std::string& text = textPart->text;
+            std::vector<MultiStringMatcher::Match> matches = highlightMatcher_.findAll(text);
+
+            // Each rule takes its leftmost non-overlapping matches from the text not yet claimed by the rules before it.
+            // The matches of a single keyword are already ordered by position.
+            std::stable_sort(matches.begin(), matches.end(), [](const MultiStringMatcher::Match& a, const MultiStringMatcher::Match& b) {
+                return a.pattern < b.pattern;
+            });
+            std::map<size_t, const MultiStringMatcher::Match*> highlights;
+            size_t rule = rules.size();
+            size_t searchStart = 0;
+            for (const auto& match : matches) {
+                if (match.pattern != rule) {
+                    rule = match.pattern;
+                    searchStart = 0;
+                }
+                if (match.begin < searchStart || !isWordBoundary(text, match.begin) || !isWordBoundary(text, match.end)) {
+                    continue;
+                }
+                if (rules[rule].matchCaseSensitive && text.compare(match.begin, match.end - match.begin, *rules[rule].keyword) != 0) {
+                    continue;
+                }
+                auto following = highlights.lower_bound(match.begin);
+                if (following != highlights.end() && following->first < match.end) {
+                    continue;
+                }
+                if (following != highlights.begin() && std::prev(following)->second->end > match.begin) {
+                    continue;
+                }
+                highlights[match.begin] = &match;
+                searchStart = match.end;
+            }
+            if (highlights.empty()) {
+                newMessage.append(part);
+                continue;
+            }
+
+            size_t start = 0;
+            for (const auto& highlight : highlights) {
+                const MultiStringMatcher::Match& match = *highlight.second;
+                if (start != match.begin) {
+                    newMessage.append(std::make_shared<ChatWindow::ChatTextMessagePart>(text.substr(start, match.begin - start)));
+                }
+                std::shared_ptr<ChatWindow::ChatHighlightingMessagePart> highlightPart = std::make_shared<ChatWindow::ChatHighlightingMessagePart>();
+                highlightPart->text = text.substr(match.begin, match.end - match.begin);
+                highlightPart->action = *rules[match.pattern].action;
+                if (detectOwnMentions && match.pattern == 0 && highlightPart->text == nick_) {
+                    ownMentionFound = true;
+                }
+                newMessage.append(highlightPart);
+                start = match.end;
+            }
+            if (start != text.size()) {
+                newMessage.append(std::make_shared<ChatWindow::ChatTextMessagePart>(text.substr(start)));
+            }
         }
 
+        if (ownMentionFound) {
+            parsedMessage.setHighlightActionOwnMention(highlightConfiguration_->ownMentionAction);
+        }
+        parsedMessage.setParts(newMessage.getParts());
         return parsedMessage;
     }
 
@@ -1,13 +1,18 @@
 /*
- * Copyright (c) 2013-2017 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <SwifTools/MultiStringMatcher.h>
 
 #include <Swift/Controllers/Highlighting/HighlightConfiguration.h>
 #include <Swift/Controllers/UIInterfaces/ChatWindow.h>
@@ -17,6 +22,9 @@ namespace Swift {
     /**
      * @brief The ChatMessageParser class takes an emoticon map, a \ref HighlightConfiguration, and a boolean that indicates if the message context is in a MUC or not.
      * The class handles parsing a message string and identifies emoticons, URLs, and various highlights.
+     *
+     * Emoticons and highlight keywords are each found in a single pass over the message text. The emoticon matcher is built
+     * once, and the keyword matcher whenever the nickname or highlight keywords change.
      */
     class ChatMessageParser {
         public:
@@ -36,7 +44,12 @@ namespace Swift {
             ChatWindow::ChatMessage fullMessageHighlight(const ChatWindow::ChatMessage& parsedMessage, const std::string& sender);
 
         private:
-            std::map<std::string, std::string> emoticons_;
+            /** The emoticons and their image paths, in the order of the emoticon matcher's patterns */
+            std::vector<std::pair<std::string, std::string> > emoticons_;
+            MultiStringMatcher emoticonMatcher_;
+            /** The keywords the highlight matcher was built from */
+            std::vector<std::string> highlightKeywords_;
+            MultiStringMatcher highlightMatcher_;
             std::shared_ptr<HighlightConfiguration> highlightConfiguration_;
             Mode mode_;
             std::string nick_;
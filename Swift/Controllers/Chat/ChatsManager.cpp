@@ -41,6 +41,7 @@
 #include <Swift/Controllers/Chat/ChatMessageParser.h>
 #include <Swift/Controllers/Chat/MUCController.h>
 #include <Swift/Controllers/Chat/MUCSearchController.h>
+#include <Swift/Controllers/Chat/RecentChatsSerializer.h>
 #include <Swift/Controllers/Chat/UserSearchController.h>
 #include <Swift/Controllers/FileTransfer/FileTransferController.h>
 #include <Swift/Controllers/FileTransfer/FileTransferOverview.h>
@@ -189,8 +190,6 @@ ChatsManager::~ChatsManager() {
 
 #ifndef NOT_YET
 void ChatsManager::saveRecents() {
-    std::stringstream serializeStream;
-    boost::archive::text_oarchive oa(serializeStream);
     std::vector<ChatListWindow::Chat> recentsLimited = std::vector<ChatListWindow::Chat>(recentChats_.begin(), recentChats_.end());
     if (recentsLimited.size() > 25) {
         recentsLimited.erase(recentsLimited.begin() + 25, recentsLimited.end());
@@ -210,9 +209,13 @@ void ChatsManager::saveRecents() {
 
     recentsLimited.erase(std::remove_if(recentsLimited.begin(), recentsLimited.end(), RemoveRecent::ifPrivateMessage), recentsLimited.end());
 
-    oa & recentsLimited;
-    std::string serializedStr = Base64::encode(createByteArray(serializeStream.str()));
-    profileSettings_->storeString(RECENT_CHATS, serializedStr);
+    std::string serializedStr = Base64::encode(RecentChatsSerializer::serialize(recentsLimited));
+    // Recents are saved on all chat activity, most of which does not change
+    // what is stored.
+    if (serializedStr != savedRecents_) {
+        profileSettings_->storeString(RECENT_CHATS, serializedStr);
+        savedRecents_ = serializedStr;
+    }
 }
 
 void ChatsManager::handleClearRecentsRequested() {
@@ -303,16 +306,27 @@ void ChatsManager::loadRecents() {
             prependRecent(chat);
         }
     } else if (!recentsString.empty()){
-        // boost searilaize based format
         ByteArray debase64 = Base64::decode(recentsString);
         std::vector<ChatListWindow::Chat> recentChats;
-        std::stringstream deserializeStream(std::string(reinterpret_cast<const char*>(vecptr(debase64)), debase64.size()));
-        try {
-            boost::archive::text_iarchive ia(deserializeStream);
-            ia >> recentChats;
-        } catch (const boost::archive::archive_exception& e) {
-            SWIFT_LOG(debug) << "Failed to load recents: " << e.what() << std::endl;
-            return;
+        if (RecentChatsSerializer::canDeserialize(debase64)) {
+            boost::optional<std::vector<ChatListWindow::Chat> > chats = RecentChatsSerializer::deserialize(debase64);
+            if (!chats) {
+                SWIFT_LOG(debug) << "Failed to load recents" << std::endl;
+                return;
+            }
+            recentChats = *chats;
+            savedRecents_ = recentsString;
+        }
+        else {
+            // boost serialize based format
+            std::stringstream deserializeStream(std::string(reinterpret_cast<const char*>(vecptr(debase64)), debase64.size()));
+            try {
+                boost::archive::text_iarchive ia(deserializeStream);
+                ia >> recentChats;
+            } catch (const boost::archive::archive_exception& e) {
+                SWIFT_LOG(debug) << "Failed to load recents: " << e.what() << std::endl;
+                return;
+            }
         }
         recentChats.erase(std::remove(recentChats.begin(), recentChats.end(), ChatListWindow::Chat()), recentChats.end());
         for (auto chat : recentChats) {
@@ -182,6 +182,7 @@ namespace Swift {
             MUCSearchController* mucSearchController_;
 #ifndef NOT_YET
             std::list<ChatListWindow::Chat> recentChats_;
+            std::string savedRecents_;
 #endif
             ProfileSettingsProvider* profileSettings_;
             FileTransferOverview* ftOverview_;
@@ -57,6 +57,8 @@
 #include <Swift/Controllers/XMPPEvents/EventController.h>
 
 #define MUC_JOIN_WARNING_TIMEOUT_MILLISECONDS 60000
+#define MUC_JOIN_PART_UPDATE_INTERVAL_MILLISECONDS 250
+#define MUC_JOIN_PART_MAX_LISTED_NICKS 10
 
 namespace Swift {
 
@@ -152,6 +154,11 @@ MUCController::MUCController (
     else {
         chatWindow_->addSystemMessage(chatMessageParser_->parseMessageBody(QT_TRANSLATE_NOOP("", "You are currently offline. You will enter this room when you are connected.")), ChatWindow::DefaultDirection);
     }
+    if (timerFactory) {
+        // Join/part summaries are re-rendered at most once per interval, so large rooms don't repaint the window on every presence
+        joinPartsTimer_ = std::shared_ptr<Timer>(timerFactory->createTimer(MUC_JOIN_PART_UPDATE_INTERVAL_MILLISECONDS));
+        joinPartsTimer_->onTick.connect(boost::bind(&MUCController::handleJoinPartsTimerTick, this));
+    }
     if (isImpromptu) {
         muc_->onUnlocked.connect(boost::bind(&MUCController::handleRoomUnlocked, this));
         chatWindow_->convertToMUC(ChatWindow::ImpromptuMUC);
@@ -191,11 +198,15 @@ MUCController::~MUCController() {
     if (loginCheckTimer_) {
         loginCheckTimer_->stop();
     }
+    if (joinPartsTimer_) {
+        joinPartsTimer_->stop();
+    }
     chatWindow_->setTabComplete(nullptr);
     delete completer_;
 }
 
 void MUCController::cancelReplaces() {
+    flushJoinPartsUpdate();
     lastWasPresence_ = false;
 }
 
@@ -441,7 +452,7 @@ void MUCController::handleOccupantJoined(const MUCOccupant& occupant) {
     }
     currentOccupants_.insert(occupant.getNick());
     NickJoinPart event(occupant.getNick(), Join);
-    appendToJoinParts(joinParts_, event);
+    appendToJoinParts(joinParts_, joinPartIndexes_, event);
     MUCOccupant::Role role = MUCOccupant::Participant;
     MUCOccupant::Affiliation affiliation = MUCOccupant::NoAffiliation;
     if (!isImpromptu_) {
@@ -453,16 +464,17 @@ void MUCController::handleOccupantJoined(const MUCOccupant& occupant) {
     roster_->applyOnItems(SetMUC(jid, role, affiliation));
     roster_->getGroup(groupName)->setManualSort(roleToSortName(role));
     if (joined_) {
-        std::string joinString;
-        if (role != MUCOccupant::NoRole && role != MUCOccupant::Participant) {
-            joinString = str(format(QT_TRANSLATE_NOOP("", "%1% has entered the %3% as a %2%.")) % occupant.getNick() % roleToFriendlyName(role) % (isImpromptu_ ? QT_TRANSLATE_NOOP("", "chat") : QT_TRANSLATE_NOOP("", "room")));
+        if (shouldUpdateJoinParts()) {
+            scheduleJoinPartsUpdate();
         }
         else {
-            joinString = str(format(QT_TRANSLATE_NOOP("", "%1% has entered the %2%.")) % occupant.getNick() % (isImpromptu_ ? QT_TRANSLATE_NOOP("", "chat") : QT_TRANSLATE_NOOP("", "room")));
-        }
-        if (shouldUpdateJoinParts()) {
-            updateJoinParts();
-        } else {
+            std::string joinString;
+            if (role != MUCOccupant::NoRole && role != MUCOccupant::Participant) {
+                joinString = str(format(QT_TRANSLATE_NOOP("", "%1% has entered the %3% as a %2%.")) % occupant.getNick() % roleToFriendlyName(role) % (isImpromptu_ ? QT_TRANSLATE_NOOP("", "chat") : QT_TRANSLATE_NOOP("", "room")));
+            }
+            else {
+                joinString = str(format(QT_TRANSLATE_NOOP("", "%1% has entered the %2%.")) % occupant.getNick() % (isImpromptu_ ? QT_TRANSLATE_NOOP("", "chat") : QT_TRANSLATE_NOOP("", "room")));
+            }
             addPresenceMessage(joinString);
         }
 
@@ -474,6 +486,7 @@ void MUCController::handleOccupantJoined(const MUCOccupant& occupant) {
 }
 
 void MUCController::addPresenceMessage(const std::string& message) {
+    flushJoinPartsUpdate();
     lastWasPresence_ = true;
     chatWindow_->addPresenceMessage(chatMessageParser_->parseMessageBody(message), ChatWindow::DefaultDirection);
 }
@@ -502,8 +515,10 @@ void MUCController::setAvailableRoomActions(const MUCOccupant::Affiliation& affi
 }
 
 void MUCController::clearPresenceQueue() {
+    flushJoinPartsUpdate();
     lastWasPresence_ = false;
     joinParts_.clear();
+    joinPartIndexes_.clear();
 }
 
 std::string MUCController::roleToFriendlyName(MUCOccupant::Role role) {
@@ -710,7 +725,7 @@ bool MUCController::shouldUpdateJoinParts() {
 
 void MUCController::handleOccupantLeft(const MUCOccupant& occupant, MUC::LeavingType type, const std::string& reason) {
     NickJoinPart event(occupant.getNick(), Part);
-    appendToJoinParts(joinParts_, event);
+    appendToJoinParts(joinParts_, joinPartIndexes_, event);
     currentOccupants_.erase(occupant.getNick());
     completer_->removeWord(occupant.getNick());
     std::string partMessage;
@@ -758,7 +773,7 @@ void MUCController::handleOccupantLeft(const MUCOccupant& occupant, MUC::Leaving
 
     if (occupant.getNick() != nick_) {
         if (shouldUpdateJoinParts()) {
-            updateJoinParts();
+            scheduleJoinPartsUpdate();
         } else {
             addPresenceMessage(partMessage);
         }
@@ -841,48 +856,94 @@ boost::optional<boost::posix_time::ptime> MUCController::getMessageTimestamp(std
 }
 
 void MUCController::updateJoinParts() {
-    chatWindow_->replaceLastMessage(chatMessageParser_->parseMessageBody(generateJoinPartString(joinParts_, isImpromptu())), ChatWindow::UpdateTimestamp);
-}
-
-void MUCController::appendToJoinParts(std::vector<NickJoinPart>& joinParts, const NickJoinPart& newEvent) {
-    std::vector<NickJoinPart>::iterator it = joinParts.begin();
-    bool matched = false;
-    for (; it != joinParts.end(); ++it) {
-        if ((*it).nick == newEvent.nick) {
-            matched = true;
-            JoinPart type = (*it).type;
-            switch (newEvent.type) {
-                case Join: type = (type == Part) ? PartThenJoin : Join; break;
-                case Part: type = (type == Join) ? JoinThenPart : Part; break;
-                case PartThenJoin: break;
-                case JoinThenPart: break;
-            }
-            (*it).type = type;
-            break;
+    chatWindow_->replaceLastMessage(chatMessageParser_->parseMessageBody(generateJoinPartString(joinParts_, isImpromptu(), MUC_JOIN_PART_MAX_LISTED_NICKS)), ChatWindow::UpdateTimestamp);
+}
+
+void MUCController::scheduleJoinPartsUpdate() {
+    if (!joinPartsTimer_) {
+        updateJoinParts();
+        return;
+    }
+    if (joinPartsTimerRunning_) {
+        joinPartsUpdatePending_ = true;
+        return;
+    }
+    // Render the first update straight away, and coalesce the ones that follow it within the interval
+    updateJoinParts();
+    joinPartsTimerRunning_ = true;
+    joinPartsTimer_->start();
+}
+
+void MUCController::flushJoinPartsUpdate() {
+    if (!joinPartsTimerRunning_) {
+        return;
+    }
+    joinPartsTimerRunning_ = false;
+    joinPartsTimer_->stop();
+    if (joinPartsUpdatePending_) {
+        joinPartsUpdatePending_ = false;
+        if (shouldUpdateJoinParts()) {
+            updateJoinParts();
         }
     }
-    if (!matched) {
+}
+
+void MUCController::handleJoinPartsTimerTick() {
+    joinPartsTimerRunning_ = false;
+    if (joinPartsUpdatePending_) {
+        joinPartsUpdatePending_ = false;
+        if (shouldUpdateJoinParts()) {
+            updateJoinParts();
+        }
+        // Keep coalescing for as long as the updates keep coming
+        joinPartsTimerRunning_ = true;
+        joinPartsTimer_->start();
+    }
+}
+
+static JoinPart combineJoinParts(JoinPart previous, JoinPart next) {
+    switch (next) {
+        case Join: return (previous == Part) ? PartThenJoin : Join;
+        case Part: return (previous == Join) ? JoinThenPart : Part;
+        case PartThenJoin: break;
+        case JoinThenPart: break;
+    }
+    return previous;
+}
+
+void MUCController::appendToJoinParts(std::vector<NickJoinPart>& joinParts, std::unordered_map<std::string, size_t>& joinPartIndexes, const NickJoinPart& newEvent) {
+    auto inserted = joinPartIndexes.insert(std::make_pair(newEvent.nick, joinParts.size()));
+    if (inserted.second) {
         joinParts.push_back(newEvent);
     }
+    else {
+        NickJoinPart& event = joinParts[inserted.first->second];
+        event.type = combineJoinParts(event.type, newEvent.type);
+    }
 }
 
-std::string MUCController::concatenateListOfNames(const std::vector<NickJoinPart>& joinParts) {
+std::string MUCController::concatenateListOfNames(const std::vector<NickJoinPart>& joinParts, size_t maxListedNicks) {
+    // Naming a single remaining nick takes no more room than counting it
+    size_t listed = (joinParts.size() > maxListedNicks && joinParts.size() - maxListedNicks > 1) ? maxListedNicks : joinParts.size();
+    size_t others = joinParts.size() - listed;
     std::string result;
-    for (size_t i = 0; i < joinParts.size(); i++) {
+    for (size_t i = 0; i < listed; i++) {
         if (i > 0) {
-            if (i < joinParts.size() - 1) {
+            if (i < listed - 1 || others > 0) {
                 result += ", ";
             } else {
                 result += QT_TRANSLATE_NOOP("", " and ");
             }
         }
-        NickJoinPart event = joinParts[i];
-        result += event.nick;
+        result += joinParts[i].nick;
+    }
+    if (others > 0) {
+        result += str(format(QT_TRANSLATE_NOOP("", " and %1% others")) % others);
     }
     return result;
 }
 
-std::string MUCController::generateJoinPartString(const std::vector<NickJoinPart>& joinParts, bool isImpromptu) {
+std::string MUCController::generateJoinPartString(const std::vector<NickJoinPart>& joinParts, bool isImpromptu, size_t maxListedNicks) {
     std::vector<NickJoinPart> sorted[4];
     std::string eventStrings[4];
     for (const auto& event : joinParts) {
@@ -891,7 +952,7 @@ std::string MUCController::generateJoinPartString(const std::vector<NickJoinPart
     std::string result;
     std::vector<JoinPart> populatedEvents;
     for (size_t i = 0; i < 4; i++) {
-        std::string names = concatenateListOfNames(sorted[i]);
+        std::string names = concatenateListOfNames(sorted[i], maxListedNicks);
         if (!names.empty()) {
             std::string eventString;
             switch (i) {
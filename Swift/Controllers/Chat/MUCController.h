@@ -6,10 +6,12 @@
 
 #pragma once
 
+#include <limits>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 
 #include <boost/signals2.hpp>
 #include <boost/signals2/connection.hpp>
@@ -62,9 +64,9 @@ namespace Swift {
             virtual void setOnline(bool online) override;
             virtual void setAvailableServerFeatures(std::shared_ptr<DiscoInfo> info) override;
             void rejoin();
-            static void appendToJoinParts(std::vector<NickJoinPart>& joinParts, const NickJoinPart& newEvent);
-            static std::string generateJoinPartString(const std::vector<NickJoinPart>& joinParts, bool isImpromptu);
-            static std::string concatenateListOfNames(const std::vector<NickJoinPart>& joinParts);
+            static void appendToJoinParts(std::vector<NickJoinPart>& joinParts, std::unordered_map<std::string, size_t>& joinPartIndexes, const NickJoinPart& newEvent);
+            static std::string generateJoinPartString(const std::vector<NickJoinPart>& joinParts, bool isImpromptu, size_t maxListedNicks = std::numeric_limits<size_t>::max());
+            static std::string concatenateListOfNames(const std::vector<NickJoinPart>& joinParts, size_t maxListedNicks = std::numeric_limits<size_t>::max());
             static std::string generateNicknameChangeString(const std::string& oldNickname, const std::string& newNickname);
             bool isJoined();
             const std::string& getNick();
@@ -114,6 +116,9 @@ namespace Swift {
             void receivedActivity();
             bool messageTargetsMe(std::shared_ptr<Message> message);
             void updateJoinParts();
+            void scheduleJoinPartsUpdate();
+            void flushJoinPartsUpdate();
+            void handleJoinPartsTimerTick();
             bool shouldUpdateJoinParts();
             virtual void dayTicked() override { clearPresenceQueue(); }
             void processUserPart();
@@ -165,6 +170,10 @@ namespace Swift {
             std::shared_ptr<Timer> loginCheckTimer_;
             std::set<std::string> currentOccupants_;
             std::vector<NickJoinPart> joinParts_;
+            std::unordered_map<std::string, size_t> joinPartIndexes_;
+            std::shared_ptr<Timer> joinPartsTimer_;
+            bool joinPartsTimerRunning_ = false;
+            bool joinPartsUpdatePending_ = false;
             boost::posix_time::ptime lastActivity_;
             boost::optional<std::string> password_;
             XMPPRoster* xmppRoster_;
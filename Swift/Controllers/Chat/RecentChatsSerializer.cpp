@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swift/Controllers/Chat/RecentChatsSerializer.h>
+
+#include <algorithm>
+#include <string>
+
+using namespace Swift;
+
+/*
+ * The data starts with a magic string and a format version, followed by the
+ * number of chats and a record per chat. Integers are stored as unsigned
+ * LEB128 varints, and strings are length-prefixed.
+ */
+static const std::string Magic("SWRC", 4);
+static const unsigned char FormatVersion = 1;
+
+enum ChatFlags {
+    IsMUCFlag = 0x1,
+    IsPrivateMessageFlag = 0x2,
+    HasPasswordFlag = 0x4
+};
+
+static void appendVarint(ByteArray& data, size_t value) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<unsigned char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<unsigned char>(value));
+}
+
+static void appendString(ByteArray& data, const std::string& value) {
+    appendVarint(data, value.size());
+    data.insert(data.end(), value.begin(), value.end());
+}
+
+static ByteArray serializeChat(const ChatListWindow::Chat& chat) {
+    ByteArray result;
+    result.push_back(static_cast<unsigned char>((chat.isMUC ? IsMUCFlag : 0) | (chat.isPrivateMessage ? IsPrivateMessageFlag : 0) | (chat.password ? HasPasswordFlag : 0)));
+    appendString(result, chat.jid.toString());
+    appendString(result, chat.chatName);
+    appendString(result, chat.activity);
+    appendString(result, chat.nick);
+    if (chat.password) {
+        appendString(result, *chat.password);
+    }
+    appendVarint(result, chat.impromptuJIDs.size());
+    for (const auto& impromptuJID : chat.impromptuJIDs) {
+        appendString(result, impromptuJID.first);
+        appendString(result, impromptuJID.second.toString());
+    }
+    appendVarint(result, chat.inviteesNames.size());
+    for (const auto& invitee : chat.inviteesNames) {
+        appendString(result, invitee.first.toString());
+        appendString(result, invitee.second);
+    }
+    return result;
+}
+
+namespace {
+    class Reader {
+        public:
+            Reader(const unsigned char* begin, const unsigned char* end) : position(begin), end(end) {
+            }
+
+            bool readByte(unsigned char& value) {
+                if (position == end) {
+                    return false;
+                }
+                value = *position++;
+                return true;
+            }
+
+            bool readVarint(size_t& value) {
+                value = 0;
+                for (unsigned int shift = 0; shift < 8 * sizeof(size_t); shift += 7) {
+                    unsigned char byte = 0;
+                    if (!readByte(byte)) {
+                        return false;
+                    }
+                    value |= static_cast<size_t>(byte & 0x7F) << shift;
+                    if (!(byte & 0x80)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool readBytes(size_t size, const unsigned char*& begin) {
+                if (static_cast<size_t>(end - position) < size) {
+                    return false;
+                }
+                begin = position;
+                position += size;
+                return true;
+            }
+
+            bool readString(std::string& value) {
+                size_t size = 0;
+                const unsigned char* begin = nullptr;
+                if (!readVarint(size) || !readBytes(size, begin)) {
+                    return false;
+                }
+                value.assign(reinterpret_cast<const char*>(begin), size);
+                return true;
+            }
+
+            bool readJID(JID& value) {
+                std::string jid;
+                if (!readString(jid)) {
+                    return false;
+                }
+                value = JID(jid);
+                return true;
+            }
+
+        private:
+            const unsigned char* position;
+            const unsigned char* end;
+    };
+}
+
+static bool parseChat(Reader& reader, ChatListWindow::Chat& chat) {
+    unsigned char flags = 0;
+    if (!reader.readByte(flags) || !reader.readJID(chat.jid) || !reader.readString(chat.chatName) || !reader.readString(chat.activity) || !reader.readString(chat.nick)) {
+        return false;
+    }
+    chat.isMUC = (flags & IsMUCFlag) != 0;
+    chat.isPrivateMessage = (flags & IsPrivateMessageFlag) != 0;
+    if (flags & HasPasswordFlag) {
+        std::string password;
+        if (!reader.readString(password)) {
+            return false;
+        }
+        chat.password = password;
+    }
+    size_t count = 0;
+    if (!reader.readVarint(count)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        std::string name;
+        JID jid;
+        if (!reader.readString(name) || !reader.readJID(jid)) {
+            return false;
+        }
+        chat.impromptuJIDs[name] = jid;
+    }
+    if (!reader.readVarint(count)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        JID jid;
+        std::string name;
+        if (!reader.readJID(jid) || !reader.readString(name)) {
+            return false;
+        }
+        chat.inviteesNames[jid] = name;
+    }
+    return true;
+}
+
+ByteArray RecentChatsSerializer::serialize(const std::vector<ChatListWindow::Chat>& chats) {
+    ByteArray result(Magic.begin(), Magic.end());
+    result.push_back(FormatVersion);
+    appendVarint(result, chats.size());
+    for (const auto& chat : chats) {
+        ByteArray record = serializeChat(chat);
+        appendVarint(result, record.size());
+        result.insert(result.end(), record.begin(), record.end());
+    }
+    return result;
+}
+
+bool RecentChatsSerializer::canDeserialize(const ByteArray& data) {
+    return data.size() > Magic.size() && std::equal(Magic.begin(), Magic.end(), data.begin());
+}
+
+boost::optional<std::vector<ChatListWindow::Chat> > RecentChatsSerializer::deserialize(const ByteArray& data) {
+    if (!canDeserialize(data)) {
+        return boost::none;
+    }
+    Reader reader(vecptr(data) + Magic.size(), vecptr(data) + data.size());
+    unsigned char version = 0;
+    size_t count = 0;
+    if (!reader.readByte(version) || version < 1 || !reader.readVarint(count)) {
+        return boost::none;
+    }
+    std::vector<ChatListWindow::Chat> chats;
+    for (size_t i = 0; i < count; ++i) {
+        size_t size = 0;
+        const unsigned char* record = nullptr;
+        if (!reader.readVarint(size) || !reader.readBytes(size, record)) {
+            return boost::none;
+        }
+        Reader recordReader(record, record + size);
+        ChatListWindow::Chat chat;
+        if (!parseChat(recordReader, chat)) {
+            return boost::none;
+        }
+        chats.push_back(chat);
+    }
+    return chats;
+}
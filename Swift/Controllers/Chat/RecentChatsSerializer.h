@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <Swiften/Base/ByteArray.h>
+
+#include <Swift/Controllers/UIInterfaces/ChatListWindow.h>
+
+namespace Swift {
+    /**
+     * Serializes the recent chats list in a compact, versioned binary format.
+     *
+     * Every chat is stored as a length-prefixed record, so fields added to
+     * the end of a record by later versions are skipped by older ones.
+     */
+    class RecentChatsSerializer {
+        public:
+            static ByteArray serialize(const std::vector<ChatListWindow::Chat>& chats);
+
+            /**
+             * Returns whether \p data is in this format (as opposed to the
+             * Boost text archives stored by earlier versions).
+             */
+            static bool canDeserialize(const ByteArray& data);
+
+            /**
+             * Returns boost::none if \p data is not in this format, or is
+             * corrupt.
+             */
+            static boost::optional<std::vector<ChatListWindow::Chat> > deserialize(const ByteArray& data);
+    };
+}
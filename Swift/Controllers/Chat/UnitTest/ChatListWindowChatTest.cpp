@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017 Isode Limited.
+ * Copyright (c) 2017-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -17,6 +17,7 @@
 #include <Swiften/StringCodecs/Base64.h>
 
 #include <Swift/Controllers/Chat/ChatListWindowChatBoostSerialize.h>
+#include <Swift/Controllers/Chat/RecentChatsSerializer.h>
 #include <Swift/Controllers/UIInterfaces/ChatListWindow.h>
 
 using namespace Swift;
@@ -290,3 +291,70 @@ TEST_F(ChatListWindowChatTest, testVersionsSerialization) {
     }
 }
 
+
+TEST_F(ChatListWindowChatTest, testBinarySerialization) {
+    ChatListWindow::Chat chat1("swift@rooms.swift.im", "swift@rooms.swift.im", "Some text 0", 0, StatusShow::None, "", true, false, "Nick Name", std::string("pass"));
+    ChatListWindow::Chat chat2("testuser1@domain.com", "Test User", "Some text 1", 0, StatusShow::None, "", false);
+    ChatListWindow::Chat chat3("room@rooms.swift.im", "room", "", 0, StatusShow::None, "", true, false, "Nick Name");
+    chat3.impromptuJIDs["testuser1@domain.com"] = "testuser1@domain.com";
+    chat3.impromptuJIDs["Test User 2"] = "testuser2@domain.com";
+    chat3.inviteesNames["user1@domain.com"] = "User 1";
+
+    auto restoredChats = RecentChatsSerializer::deserialize(RecentChatsSerializer::serialize({chat1, chat2, chat3}));
+    ASSERT_TRUE(restoredChats.is_initialized());
+    ASSERT_EQ(3, restoredChats->size());
+
+    EXPECT_TRUE((*restoredChats)[0].isMUC);
+    EXPECT_EQ("swift@rooms.swift.im", (*restoredChats)[0].jid);
+    EXPECT_EQ("swift@rooms.swift.im", (*restoredChats)[0].chatName);
+    EXPECT_EQ("Some text 0", (*restoredChats)[0].activity);
+    EXPECT_EQ("Nick Name", (*restoredChats)[0].nick);
+    EXPECT_EQ("pass", (*restoredChats)[0].password.get_value_or(""));
+
+    EXPECT_FALSE((*restoredChats)[1].isMUC);
+    EXPECT_EQ("testuser1@domain.com", (*restoredChats)[1].jid);
+    EXPECT_EQ("Test User", (*restoredChats)[1].chatName);
+    EXPECT_FALSE((*restoredChats)[1].password.is_initialized());
+
+    ASSERT_EQ(2, (*restoredChats)[2].impromptuJIDs.size());
+    EXPECT_EQ("testuser2@domain.com", (*restoredChats)[2].impromptuJIDs["Test User 2"]);
+    ASSERT_EQ(1, (*restoredChats)[2].inviteesNames.size());
+    EXPECT_EQ("User 1", (*restoredChats)[2].inviteesNames["user1@domain.com"]);
+    EXPECT_EQ(chat3.getTitle(), (*restoredChats)[2].getTitle());
+}
+
+TEST_F(ChatListWindowChatTest, testBinarySerialization_TrailingFields) {
+    ChatListWindow::Chat chat("testuser1@domain.com", "Test User", "Some text 1", 0, StatusShow::None, "", false);
+    ByteArray data = RecentChatsSerializer::serialize({chat});
+
+    // A field added to the chat record by a later version
+    ByteArray extendedData(data.begin(), data.begin() + 6);
+    extendedData.push_back(static_cast<unsigned char>(data[6] + 3));
+    extendedData.insert(extendedData.end(), data.begin() + 7, data.end());
+    extendedData.push_back(2);
+    extendedData.push_back('x');
+    extendedData.push_back('y');
+
+    auto restoredChats = RecentChatsSerializer::deserialize(extendedData);
+    ASSERT_TRUE(restoredChats.is_initialized());
+    ASSERT_EQ(1, restoredChats->size());
+    EXPECT_EQ("Some text 1", (*restoredChats)[0].activity);
+}
+
+TEST_F(ChatListWindowChatTest, testBinaryDeserialization_Truncated) {
+    ChatListWindow::Chat chat("testuser1@domain.com", "Test User", "Some text 1", 0, StatusShow::None, "", false);
+    ByteArray data = RecentChatsSerializer::serialize({chat, chat});
+    data.resize(data.size() - 1);
+
+    EXPECT_TRUE(RecentChatsSerializer::canDeserialize(data));
+    EXPECT_FALSE(RecentChatsSerializer::deserialize(data).is_initialized());
+}
+
+TEST_F(ChatListWindowChatTest, testBinaryDeserialization_BoostArchive) {
+    ChatListWindow::Chat chat("testuser1@domain.com", "Test User", "Some text 1", 0, StatusShow::None, "", false);
+
+    ByteArray data = Base64::decode(chatsSerialise({chat}));
+
+    EXPECT_FALSE(RecentChatsSerializer::canDeserialize(data));
+    EXPECT_FALSE(RecentChatsSerializer::deserialize(data).is_initialized());
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2017 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -157,6 +157,43 @@ TEST_F(ChatMessageParserTest, testMultipleCaseSensitiveKeywordHighlights) {
     assertHighlight(result, 1, "tHrEe", config->keywordHighlights[0].action);
 }
 
+TEST_F(ChatMessageParserTest, testOverlappingKeywordHighlights) {
+    auto config = mergeHighlightConfig(highlightConfigFromKeyword("one two", false), highlightConfigFromKeyword("two three", false));
+    config->keywordHighlights[1].action.setFrontColor(std::string("#343434"));
+    auto testling = ChatMessageParser(emoticons_, config);
+    auto result = testling.parseMessageBody("one two three, two three");
+    assertHighlight(result, 0, "one two", config->keywordHighlights[0].action);
+    assertText(result, 1, " three, ");
+    assertHighlight(result, 2, "two three", config->keywordHighlights[1].action);
+}
+
+TEST_F(ChatMessageParserTest, testKeywordHighlightsFollowConfigurationChanges) {
+    auto config = highlightConfigFromKeyword("one", false);
+    auto testling = ChatMessageParser(emoticons_, config);
+    auto result = testling.parseMessageBody("one two");
+    assertHighlight(result, 0, "one", config->keywordHighlights[0].action);
+    assertText(result, 1, " two");
+
+    config->keywordHighlights[0].keyword = "two";
+    result = testling.parseMessageBody("one two");
+    assertText(result, 0, "one ");
+    assertHighlight(result, 1, "two", config->keywordHighlights[0].action);
+}
+
+TEST_F(ChatMessageParserTest, testOwnMentionTakesPrecedenceOverKeyword) {
+    auto config = highlightConfigFromKeyword("juliet", false);
+    config->ownMentionAction.setFrontColor(std::string("#f0f0f0"));
+    auto ownMentionActionForPart = config->ownMentionAction;
+    ownMentionActionForPart.setSystemNotificationEnabled(false);
+    auto testling = ChatMessageParser(emoticons_, config);
+    testling.setNick("Juliet");
+    auto result = testling.parseMessageBody("Where is Juliet?", "Romeo");
+    assertText(result, 0, "Where is ");
+    assertHighlight(result, 1, "Juliet", ownMentionActionForPart);
+    assertText(result, 2, "?");
+    ASSERT_EQ(config->ownMentionAction, result.getHighlightActionOwnMention());
+}
+
 TEST_F(ChatMessageParserTest, testOneEmoticon) {
     auto testling = ChatMessageParser(emoticons_, std::make_shared<HighlightConfiguration>());
     auto result = testling.parseMessageBody(" :) ");
@@ -192,6 +229,14 @@ TEST_F(ChatMessageParserTest, testBoundedEmoticons) {
     assertEmoticon(result, 2, smile2_, smile2Path_);
 }
 
+TEST_F(ChatMessageParserTest, testAdjacentEmoticons) {
+    auto testling = ChatMessageParser(emoticons_, std::make_shared<HighlightConfiguration>());
+    auto result = testling.parseMessageBody("Lazy :):(");
+    assertText(result, 0, "Lazy ");
+    assertEmoticon(result, 1, smile1_, smile1Path_);
+    assertEmoticon(result, 2, smile2_, smile2Path_);
+}
+
 TEST_F(ChatMessageParserTest, testEmoticonParenthesis) {
     auto testling = ChatMessageParser(emoticons_, std::make_shared<HighlightConfiguration>());
     auto result = testling.parseMessageBody("(Like this :))");
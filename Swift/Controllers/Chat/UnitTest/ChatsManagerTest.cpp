@@ -44,11 +44,13 @@
 #include <Swiften/Presence/StanzaChannelPresenceSender.h>
 #include <Swiften/Queries/DummyIQChannel.h>
 #include <Swiften/Roster/XMPPRosterImpl.h>
+#include <Swiften/StringCodecs/Base64.h>
 #include <Swiften/VCards/VCardManager.h>
 #include <Swiften/VCards/VCardMemoryStorage.h>
 #include <Swiften/Whiteboard/WhiteboardSessionManager.h>
 
 #include <Swift/Controllers/Chat/ChatController.h>
+#include <Swift/Controllers/Chat/ChatListWindowChatBoostSerialize.h>
 #include <Swift/Controllers/Chat/ChatsManager.h>
 #include <Swift/Controllers/Chat/Chattables.h>
 #include <Swift/Controllers/Chat/MUCController.h>
@@ -163,6 +165,10 @@ class ChatsManagerTest : public CppUnit::TestFixture {
     CPPUNIT_TEST(testReceivingBookmarksWithBareJID);
     CPPUNIT_TEST(testReceivingBookmarksWithFullJID);
 
+    // Recent chats tests
+    CPPUNIT_TEST(testRecentChatsRestoredOnRestart);
+    CPPUNIT_TEST(testRecentChatsLoadedFromBoostArchive);
+
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -1190,6 +1196,8 @@ public:
             presence->addPayload(userPayload);
             stanzaChannel_->onPresenceReceived(presence);
         }
+        // Updates that follow each other closely are rendered together
+        timerFactory_->setTime(1000);
         CPPUNIT_ASSERT_EQUAL(std::string(), window->bodyFromMessage(window->lastAddedPresence_));
         CPPUNIT_ASSERT_EQUAL(std::string("someDifferentNickname, Romeo and Juliet have entered the room"), window->bodyFromMessage(window->lastReplacedLastMessage_));
     }
@@ -1704,7 +1712,55 @@ public:
         stanzaChannel_->onIQReceived(response);
     }
 
+    void testRecentChatsRestoredOnRestart() {
+        JID messageJID("testling@test.com/resource1");
+
+        MockChatWindow* window = new MockChatWindow();
+        mocks_->ExpectCall(chatWindowFactory_, ChatWindowFactory::createChatWindow).With(messageJID, uiEventStream_).Return(window);
+
+        std::shared_ptr<Message> message(new Message());
+        message->setFrom(messageJID);
+        message->setBody("Hello");
+        manager_->handleIncomingMessage(message);
+
+        recreateManager();
+
+        auto recentChats = manager_->getRecentChats();
+        CPPUNIT_ASSERT_EQUAL(size_t(1), recentChats.size());
+        CPPUNIT_ASSERT_EQUAL(messageJID.toBare(), recentChats[0].jid);
+        CPPUNIT_ASSERT_EQUAL(std::string("Hello"), recentChats[0].activity);
+    }
+
+    void testRecentChatsLoadedFromBoostArchive() {
+        std::vector<ChatListWindow::Chat> chats;
+        chats.push_back(ChatListWindow::Chat(JID("testling@test.com"), "testling", "Hello", 0, StatusShow::None, "", false));
+        chats.push_back(ChatListWindow::Chat(JID("room@rooms.test.com"), "room", "", 0, StatusShow::None, "", true, false, "Nick"));
+        std::stringstream stream;
+        {
+            boost::archive::text_oarchive archive(stream);
+            archive << chats;
+        }
+        profileSettings_->storeString("recent_chats", Base64::encode(createByteArray(stream.str())));
+
+        recreateManager();
+
+        auto recentChats = manager_->getRecentChats();
+        CPPUNIT_ASSERT_EQUAL(size_t(2), recentChats.size());
+        CPPUNIT_ASSERT_EQUAL(JID("testling@test.com"), recentChats[0].jid);
+        CPPUNIT_ASSERT_EQUAL(std::string("Hello"), recentChats[0].activity);
+        CPPUNIT_ASSERT_EQUAL(JID("room@rooms.test.com"), recentChats[1].jid);
+        CPPUNIT_ASSERT(recentChats[1].isMUC);
+        CPPUNIT_ASSERT_EQUAL(std::string("Nick"), recentChats[1].nick);
+    }
+
 private:
+    void recreateManager() {
+        delete manager_;
+        mocks_->ExpectCall(chatListWindowFactory_, ChatListWindowFactory::createChatListWindow).With(uiEventStream_).Return(chatListWindow_);
+        manager_ = new ChatsManager(jid_, stanzaChannel_, iqRouter_, eventController_, chatWindowFactory_, joinMUCWindowFactory_, nickResolver_, presenceOracle_, directedPresenceSender_, uiEventStream_, chatListWindowFactory_, true, timerFactory_, mucRegistry_, entityCapsProvider_, mucManager_, mucSearchWindowFactory_, profileSettings_, ftOverview_, xmppRoster_, false, settings_, nullptr, wbManager_, highlightManager_, clientBlockListManager_, emoticons_, vcardManager_, *chattables_);
+        manager_->setAvatarManager(avatarManager_);
+    }
+
     std::shared_ptr<Message> makeDeliveryReceiptTestMessage(const JID& from, const std::string& id) {
         std::shared_ptr<Message> message = std::make_shared<Message>();
         message->setFrom(from);
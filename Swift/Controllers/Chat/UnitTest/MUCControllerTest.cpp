@@ -7,6 +7,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <memory>
+#include <unordered_map>
 
 #include <gtest/gtest.h>
 #include <hippomocks.h>
@@ -22,7 +23,7 @@
 #include <Swiften/Elements/Thread.h>
 #include <Swiften/MUC/MUCBookmarkManager.h>
 #include <Swiften/MUC/UnitTest/MockMUC.h>
-#include <Swiften/Network/TimerFactory.h>
+#include <Swiften/Network/DummyTimerFactory.h>
 #include <Swiften/Presence/DirectedPresenceSender.h>
 #include <Swiften/Presence/PresenceOracle.h>
 #include <Swiften/Presence/StanzaChannelPresenceSender.h>
@@ -73,7 +74,7 @@ class MUCControllerTest : public ::testing::Test {
             directedPresenceSender_ = new DirectedPresenceSender(presenceSender_);
             uiEventStream_ = new UIEventStream();
             avatarManager_ = new NullAvatarManager();
-            TimerFactory* timerFactory = nullptr;
+            timerFactory_ = new DummyTimerFactory();
             window_ = new MockChatWindow();
             mucRegistry_ = new MUCRegistry();
             entityCapsProvider_ = new DummyEntityCapsProvider();
@@ -89,11 +90,12 @@ class MUCControllerTest : public ::testing::Test {
             clientBlockListManager_ = new ClientBlockListManager(iqRouter_);
             mucBookmarkManager_ = new MUCBookmarkManager(iqRouter_);
             chattables_ = std::make_unique<Chattables>();
-            controller_ = new MUCController (self_, muc_, boost::optional<std::string>(), nick_, stanzaChannel_, iqRouter_, chatWindowFactory_, nickResolver_, presenceOracle_, avatarManager_, uiEventStream_, false, timerFactory, eventController_, entityCapsProvider_, nullptr, nullptr, mucRegistry_, highlightManager_, clientBlockListManager_, chatMessageParser_, false, nullptr, vcardManager_, mucBookmarkManager_, settings_, *chattables_);
+            controller_ = new MUCController (self_, muc_, boost::optional<std::string>(), nick_, stanzaChannel_, iqRouter_, chatWindowFactory_, nickResolver_, presenceOracle_, avatarManager_, uiEventStream_, false, timerFactory_, eventController_, entityCapsProvider_, nullptr, nullptr, mucRegistry_, highlightManager_, clientBlockListManager_, chatMessageParser_, false, nullptr, vcardManager_, mucBookmarkManager_, settings_, *chattables_);
         }
 
         void TearDown() {
             delete controller_;
+            delete timerFactory_;
             delete mucBookmarkManager_;
             delete clientBlockListManager_;
             delete nickResolver_;
@@ -246,6 +248,7 @@ class MUCControllerTest : public ::testing::Test {
         MUCBookmarkManager* mucBookmarkManager_;
         XMPPRoster* xmppRoster_;
         std::unique_ptr<Chattables> chattables_;
+        DummyTimerFactory* timerFactory_;
 };
 
 TEST_F(MUCControllerTest, testAddressedToSelf) {
@@ -408,38 +411,38 @@ TEST_F(MUCControllerTest, testCorrectMessageWithLabelItem) {
 
 TEST_F(MUCControllerTest, testAppendToJoinParts) {
     std::vector<NickJoinPart> list;
+    std::unordered_map<std::string, size_t> indexes;
     std::vector<NickJoinPart> gold;
-    MUCController::appendToJoinParts(list, NickJoinPart("Kev", Join));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Kev", Join));
     gold.push_back(NickJoinPart("Kev", Join));
     checkEqual(gold, list);
-    MUCController::appendToJoinParts(list, NickJoinPart("Remko", Join));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Remko", Join));
     gold.push_back(NickJoinPart("Remko", Join));
     checkEqual(gold, list);
-    MUCController::appendToJoinParts(list, NickJoinPart("Bert", Join));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Bert", Join));
     gold.push_back(NickJoinPart("Bert", Join));
     checkEqual(gold, list);
-    MUCController::appendToJoinParts(list, NickJoinPart("Bert", Part));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Bert", Part));
     gold[2].type = JoinThenPart;
     checkEqual(gold, list);
-    MUCController::appendToJoinParts(list, NickJoinPart("Kev", Part));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Kev", Part));
     gold[0].type = JoinThenPart;
     checkEqual(gold, list);
-    MUCController::appendToJoinParts(list, NickJoinPart("Remko", Part));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Remko", Part));
     gold[1].type = JoinThenPart;
     checkEqual(gold, list);
-    MUCController::appendToJoinParts(list, NickJoinPart("Ernie", Part));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Ernie", Part));
     gold.push_back(NickJoinPart("Ernie", Part));
     checkEqual(gold, list);
-    MUCController::appendToJoinParts(list, NickJoinPart("Ernie", Join));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Ernie", Join));
     gold[3].type = PartThenJoin;
     checkEqual(gold, list);
-    MUCController::appendToJoinParts(list, NickJoinPart("Kev", Join));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Kev", Join));
     gold[0].type = Join;
     checkEqual(gold, list);
-    MUCController::appendToJoinParts(list, NickJoinPart("Ernie", Part));
+    MUCController::appendToJoinParts(list, indexes, NickJoinPart("Ernie", Part));
     gold[3].type = Part;
     checkEqual(gold, list);
-
 }
 
 TEST_F(MUCControllerTest, testJoinPartStringContructionSimple) {
@@ -466,6 +469,51 @@ TEST_F(MUCControllerTest, testJoinPartStringContructionMixed) {
     ASSERT_EQ(std::string("Remko has left the room, Kev and Ernie have entered then left the room and Bert has left then returned to the room"), MUCController::generateJoinPartString(list, false));
 }
 
+TEST_F(MUCControllerTest, testJoinPartStringConstructionCapped) {
+    std::vector<NickJoinPart> list;
+    list.push_back(NickJoinPart("Kev", Join));
+    list.push_back(NickJoinPart("Remko", Join));
+    list.push_back(NickJoinPart("Bert", Join));
+    ASSERT_EQ(std::string("Kev, Remko and Bert have entered the room"), MUCController::generateJoinPartString(list, false, 2));
+    list.push_back(NickJoinPart("Ernie", Join));
+    list.push_back(NickJoinPart("Tom", Part));
+    ASSERT_EQ(std::string("Kev, Remko and 2 others have entered the room and Tom has left the room"), MUCController::generateJoinPartString(list, false, 2));
+}
+
+TEST_F(MUCControllerTest, testJoinPartsCoalesced) {
+    muc_->insertOccupant(MUCOccupant(nick_, MUCOccupant::Participant, MUCOccupant::Owner));
+    muc_->onJoinComplete(nick_);
+
+    muc_->insertOccupant(MUCOccupant("Kev", MUCOccupant::Participant, MUCOccupant::NoAffiliation));
+    ASSERT_EQ(std::string("Kev has entered the room."), window_->bodyFromMessage(window_->lastAddedPresence_));
+    muc_->insertOccupant(MUCOccupant("Remko", MUCOccupant::Participant, MUCOccupant::NoAffiliation));
+    ASSERT_EQ(std::string("Kev and Remko have entered the room"), window_->bodyFromMessage(window_->lastReplacedLastMessage_));
+    muc_->insertOccupant(MUCOccupant("Bert", MUCOccupant::Participant, MUCOccupant::NoAffiliation));
+    muc_->insertOccupant(MUCOccupant("Ernie", MUCOccupant::Participant, MUCOccupant::NoAffiliation));
+    ASSERT_EQ(std::string("Kev and Remko have entered the room"), window_->bodyFromMessage(window_->lastReplacedLastMessage_));
+
+    timerFactory_->setTime(1000);
+    ASSERT_EQ(std::string("Kev, Remko, Bert and Ernie have entered the room"), window_->bodyFromMessage(window_->lastReplacedLastMessage_));
+}
+
+TEST_F(MUCControllerTest, testJoinPartsFlushedBeforeMessage) {
+    muc_->insertOccupant(MUCOccupant(nick_, MUCOccupant::Participant, MUCOccupant::Owner));
+    muc_->onJoinComplete(nick_);
+
+    muc_->insertOccupant(MUCOccupant("Kev", MUCOccupant::Participant, MUCOccupant::NoAffiliation));
+    muc_->insertOccupant(MUCOccupant("Remko", MUCOccupant::Participant, MUCOccupant::NoAffiliation));
+    muc_->insertOccupant(MUCOccupant("Bert", MUCOccupant::Participant, MUCOccupant::NoAffiliation));
+
+    Message::ref message = createTestMessageWithoutSecurityLabel();
+    controller_->handleIncomingMessage(std::make_shared<MessageEvent>(message));
+    ASSERT_EQ(std::string("Kev, Remko and Bert have entered the room"), window_->bodyFromMessage(window_->lastReplacedLastMessage_));
+    ASSERT_EQ(std::string("Do Not Read This Message"), window_->bodyFromMessage(window_->lastAddedMessage_));
+
+    window_->resetLastMessages();
+    timerFactory_->setTime(1000);
+    ASSERT_EQ(std::string(), window_->bodyFromMessage(window_->lastReplacedLastMessage_));
+}
+
 TEST_F(MUCControllerTest, testRoleAffiliationStates) {
 
     typedef std::map<std::string, MUCOccupant> occupant_map;
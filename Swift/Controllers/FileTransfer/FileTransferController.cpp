@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2015-2017 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -28,13 +28,13 @@
 
 namespace Swift {
 
-FileTransferController::FileTransferController(const JID& receipient, const std::string& filename, FileTransferManager* fileTransferManager) :
-    sending(true), otherParty(receipient), filename(filename), ftManager(fileTransferManager), ftProgressInfo(nullptr), chatWindow(nullptr), currentState(FileTransfer::State::WaitingForStart) {
+FileTransferController::FileTransferController(const JID& receipient, const std::string& filename, FileTransferManager* fileTransferManager, FileIOWorker::ref worker) :
+    sending(true), otherParty(receipient), filename(filename), worker(worker), fileWriteFailed(false), ftManager(fileTransferManager), ftProgressInfo(nullptr), chatWindow(nullptr), currentState(FileTransfer::State::WaitingForStart) {
 
 }
 
-FileTransferController::FileTransferController(IncomingFileTransfer::ref transfer) :
-    sending(false), otherParty(transfer->getSender()), filename(transfer->getFileName()), transfer(transfer), ftManager(nullptr), ftProgressInfo(nullptr), chatWindow(nullptr), currentState(FileTransfer::State::WaitingForStart) {
+FileTransferController::FileTransferController(IncomingFileTransfer::ref transfer, FileIOWorker::ref worker) :
+    sending(false), otherParty(transfer->getSender()), filename(transfer->getFileName()), transfer(transfer), worker(worker), fileWriteFailed(false), ftManager(nullptr), ftProgressInfo(nullptr), chatWindow(nullptr), currentState(FileTransfer::State::WaitingForStart) {
     transfer->onStateChanged.connect(boost::bind(&FileTransferController::handleFileTransferStateChange, this, _1));
 }
 
@@ -83,7 +83,12 @@ boost::uintmax_t FileTransferController::getSize() const {
 
 void FileTransferController::start(std::string& description) {
     SWIFT_LOG(debug) << "FileTransferController::start" << std::endl;
-    fileReadStream = std::make_shared<FileReadBytestream>(boost::filesystem::path(filename));
+    if (worker) {
+        fileReadStream = std::make_shared<FileReadBytestream>(boost::filesystem::path(filename), worker);
+    }
+    else {
+        fileReadStream = std::make_shared<FileReadBytestream>(boost::filesystem::path(filename));
+    }
     OutgoingFileTransfer::ref outgoingTransfer = ftManager->createOutgoingFileTransfer(otherParty, boost::filesystem::path(filename), description, fileReadStream);
     if (outgoingTransfer) {
         ftProgressInfo = new FileTransferProgressInfo(outgoingTransfer->getFileSizeInBytes());
@@ -101,7 +106,15 @@ void FileTransferController::accept(std::string& file) {
     SWIFT_LOG(debug) << "FileTransferController::accept" << std::endl;
     IncomingFileTransfer::ref incomingTransfer = std::dynamic_pointer_cast<IncomingFileTransfer>(transfer);
     if (incomingTransfer) {
-        fileWriteStream = std::make_shared<FileWriteBytestream>(boost::filesystem::path(file));
+        if (worker) {
+            fileWriteStream = std::make_shared<FileWriteBytestream>(boost::filesystem::path(file), worker);
+        }
+        else {
+            fileWriteStream = std::make_shared<FileWriteBytestream>(boost::filesystem::path(file));
+        }
+        fileWriteStream->setExpectedSize(transfer->getFileSizeInBytes());
+        fileWriteErrorConnection = fileWriteStream->onError.connect(boost::bind(&FileTransferController::handleFileWriteError, this));
+        fileWriteStreamClosedConnection = fileWriteStream->onClosed.connect(boost::bind(&FileTransferController::handleFileWriteStreamClosed, this, _1));
 
         ftProgressInfo = new FileTransferProgressInfo(transfer->getFileSizeInBytes());
         ftProgressInfo->onProgressPercentage.connect(boost::bind(&FileTransferController::handleProgressPercentageChange, this, _1));
@@ -134,13 +147,16 @@ void FileTransferController::handleFileTransferStateChange(FileTransfer::State s
             chatWindow->setFileTransferStatus(uiID, ChatWindow::Transferring);
             return;
         case FileTransfer::State::Canceled:
-            chatWindow->setFileTransferStatus(uiID, ChatWindow::Canceled);
+            chatWindow->setFileTransferStatus(uiID, fileWriteFailed ? ChatWindow::FTFailed : ChatWindow::Canceled);
             return;
         case FileTransfer::State::Finished:
-            chatWindow->setFileTransferStatus(uiID, ChatWindow::Finished);
             if (fileWriteStream) {
+                // The transfer only counts as finished once all data is on disk
                 fileWriteStream->close();
             }
+            else {
+                chatWindow->setFileTransferStatus(uiID, ChatWindow::Finished);
+            }
             return;
         case FileTransfer::State::Failed:
             chatWindow->setFileTransferStatus(uiID, ChatWindow::FTFailed);
@@ -160,4 +176,26 @@ void FileTransferController::handleProgressPercentageChange(int percentage) {
     chatWindow->setFileTransferProgress(uiID, percentage);
 }
 
+void FileTransferController::handleFileWriteError() {
+    SWIFT_LOG(warning) << "Unable to write received file data" << std::endl;
+    fileWriteFailed = true;
+    if (currentState.type != FileTransfer::State::Finished) {
+        transfer->cancel();
+    }
+}
+
+void FileTransferController::handleFileWriteStreamClosed(bool error) {
+    if (currentState.type != FileTransfer::State::Finished) {
+        return;
+    }
+    if (error) {
+        currentState = FileTransfer::State(FileTransfer::State::Failed);
+        onStateChanged();
+        chatWindow->setFileTransferStatus(uiID, ChatWindow::FTFailed);
+    }
+    else {
+        chatWindow->setFileTransferStatus(uiID, ChatWindow::Finished);
+    }
+}
+
 }
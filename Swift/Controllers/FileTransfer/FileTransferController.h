@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2015-2017 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,7 +16,9 @@
 #include <string>
 
 #include <boost/cstdint.hpp>
+#include <boost/signals2.hpp>
 
+#include <Swiften/FileTransfer/FileIOWorker.h>
 #include <Swiften/FileTransfer/FileReadBytestream.h>
 #include <Swiften/FileTransfer/FileTransfer.h>
 #include <Swiften/FileTransfer/FileWriteBytestream.h>
@@ -34,13 +36,14 @@ class FileTransferController {
 public:
     /**
      * For outgoing file transfers. It'll create a file transfer via FileTransferManager as soon as the descriptive information is available.
+     * If a worker is given, the file is read on the worker thread.
      */
-    FileTransferController(const JID&, const std::string&, FileTransferManager*);
+    FileTransferController(const JID&, const std::string&, FileTransferManager*, FileIOWorker::ref worker = FileIOWorker::ref());
 
     /**
-     * For incoming file transfers.
+     * For incoming file transfers. If a worker is given, the file is written on the worker thread.
      */
-    FileTransferController(IncomingFileTransfer::ref transfer);
+    FileTransferController(IncomingFileTransfer::ref transfer, FileIOWorker::ref worker = FileIOWorker::ref());
     ~FileTransferController();
 
     std::string setChatWindow(ChatWindow*, const std::string& nickname, const std::string& avatarPath);
@@ -62,6 +65,8 @@ public:
 private:
     void handleFileTransferStateChange(FileTransfer::State);
     void handleProgressPercentageChange(int percentage);
+    void handleFileWriteError();
+    void handleFileWriteStreamClosed(bool error);
 
 private:
     bool sending;
@@ -70,6 +75,10 @@ private:
     FileTransfer::ref transfer;
     std::shared_ptr<FileReadBytestream> fileReadStream;
     std::shared_ptr<FileWriteBytestream> fileWriteStream;
+    FileIOWorker::ref worker;
+    bool fileWriteFailed;
+    boost::signals2::scoped_connection fileWriteErrorConnection;
+    boost::signals2::scoped_connection fileWriteStreamClosedConnection;
     FileTransferManager* ftManager;
     FileTransferProgressInfo* ftProgressInfo;
     ChatWindow* chatWindow;
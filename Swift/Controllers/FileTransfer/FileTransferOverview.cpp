@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2015-2016 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -21,7 +21,7 @@
 
 namespace Swift {
 
-FileTransferOverview::FileTransferOverview(FileTransferManager* ftm) : fileTransferManager(ftm) {
+FileTransferOverview::FileTransferOverview(FileTransferManager* ftm, FileIOWorker::ref worker) : fileTransferManager(ftm), worker(worker) {
     fileTransferManager->onIncomingFileTransfer.connect(boost::bind(&FileTransferOverview::handleIncomingFileTransfer, this, _1));
     onNewFileTransferController.connect(boost::bind(&FileTransferOverview::handleNewFileTransferController, this, _1));
 }
@@ -36,13 +36,13 @@ FileTransferOverview::~FileTransferOverview() {
 
 void FileTransferOverview::sendFile(const JID& jid, const std::string& filename) {
     if (boost::filesystem::exists(filename) && boost::filesystem::file_size(filename) > 0) {
-        FileTransferController* controller = new FileTransferController(jid, filename, fileTransferManager);
+        FileTransferController* controller = new FileTransferController(jid, filename, fileTransferManager, worker);
         onNewFileTransferController(controller);
     }
 }
 
 void FileTransferOverview::handleIncomingFileTransfer(IncomingFileTransfer::ref transfer) {
-    FileTransferController* controller = new FileTransferController(transfer);
+    FileTransferController* controller = new FileTransferController(transfer, worker);
     onNewFileTransferController(controller);
 }
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2015-2016 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,6 +16,8 @@
 
 #include <boost/signals2.hpp>
 
+#include <Swiften/FileTransfer/FileIOWorker.h>
+
 #include <Swift/Controllers/FileTransfer/FileTransferController.h>
 
 namespace Swift {
@@ -25,7 +27,11 @@ class FileTransferManager;
 
 class FileTransferOverview {
 public:
-    FileTransferOverview(FileTransferManager*);
+    /**
+     * If a worker is given, the files of all transfers are read and written
+     * on the worker thread.
+     */
+    FileTransferOverview(FileTransferManager*, FileIOWorker::ref worker = FileIOWorker::ref());
     ~FileTransferOverview();
 
     void sendFile(const JID&, const std::string&);
@@ -44,6 +50,7 @@ private:
 private:
     std::vector<FileTransferController*> fileTransfers;
     FileTransferManager *fileTransferManager;
+    FileIOWorker::ref worker;
 };
 
 }
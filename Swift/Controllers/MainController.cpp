@@ -18,6 +18,7 @@
 #include <Swiften/Base/format.h>
 #include <Swiften/Client/Client.h>
 #include <Swiften/Client/ClientBlockListManager.h>
+#include <Swiften/Client/ClientStateManager.h>
 #include <Swiften/Client/ClientXMLTracer.h>
 #include <Swiften/Client/NickResolver.h>
 #include <Swiften/Client/StanzaChannel.h>
@@ -30,6 +31,7 @@
 #include <Swiften/Elements/DiscoInfo.h>
 #include <Swiften/Elements/Presence.h>
 #include <Swiften/Elements/VCardUpdate.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
 #include <Swiften/FileTransfer/FileTransferManager.h>
 #include <Swiften/Network/NetworkFactories.h>
 #include <Swiften/Network/TimerFactory.h>
@@ -98,6 +100,8 @@ namespace Swift {
 static const std::string CLIENT_NAME = "Swift";
 static const std::string CLIENT_NODE = "http://swift.im";
 
+const int MainController::SecondsInBackgroundBeforeInactive = 60;
+
 
 MainController::MainController(
         EventLoop* eventLoop,
@@ -228,6 +232,10 @@ MainController::MainController(
 
 MainController::~MainController() {
     idleDetector_->onIdleChanged.disconnect(boost::bind(&MainController::handleInputIdleChanged, this, _1));
+    if (applicationInactiveTimer_) {
+        applicationInactiveTimer_->stop();
+        applicationInactiveTimer_->onTick.disconnect(boost::bind(&MainController::handleApplicationInactiveTimerTick, this));
+    }
 
     purgeCachedCredentials();
     //setManagersOffline();
@@ -348,7 +356,7 @@ void MainController::handleConnected() {
     if (freshLogin) {
         profileController_ = new ProfileController(client_->getVCardManager(), uiFactory_, uiEventStream_);
         showProfileController_ = new ShowProfileController(client_->getVCardManager(), uiFactory_, uiEventStream_);
-        ftOverview_ = new FileTransferOverview(client_->getFileTransferManager());
+        ftOverview_ = new FileTransferOverview(client_->getFileTransferManager(), std::make_shared<FileIOWorker>(eventLoop_));
         fileTransferListController_->setFileTransferOverview(ftOverview_);
         chattables_ = std::make_unique<Chattables>();
         rosterController_ = new RosterController(boundJID_, client_->getRoster(), client_->getAvatarManager(), uiFactory_, client_->getNickManager(), client_->getNickResolver(), client_->getPresenceOracle(), client_->getSubscriptionManager(), eventController_, uiEventStream_, client_->getIQRouter(), settings_, client_->getEntityCapsProvider(), client_->getClientBlockListManager(), client_->getVCardManager(), *chattables_);
@@ -416,13 +424,17 @@ void MainController::handleConnected() {
     }
     loginWindow_->setIsLoggingIn(false);
 
-    client_->requestRoster();
+    /* A resumed stream keeps the roster, presences and server state we already have.
+     * Our presence is still sent, but the server won't probe our contacts again. */
+    if (!client_->isStreamResumed()) {
+        client_->requestRoster();
 
-    GetDiscoInfoRequest::ref discoInfoRequest = GetDiscoInfoRequest::create(JID(boundJID_.getDomain()), client_->getIQRouter());
-    discoInfoRequest->onResponse.connect(boost::bind(&MainController::handleServerDiscoInfoResponse, this, _1, _2));
-    discoInfoRequest->send();
+        GetDiscoInfoRequest::ref discoInfoRequest = GetDiscoInfoRequest::create(JID(boundJID_.getDomain()), client_->getIQRouter());
+        discoInfoRequest->onResponse.connect(boost::bind(&MainController::handleServerDiscoInfoResponse, this, _1, _2));
+        discoInfoRequest->send();
 
-    client_->getVCardManager()->requestOwnVCard();
+        client_->getVCardManager()->requestOwnVCard();
+    }
 
     rosterController_->setJID(boundJID_);
     rosterController_->setEnabled(true);
@@ -489,7 +501,41 @@ void MainController::sendPresence(std::shared_ptr<Presence> presence) {
     }
 }
 
+void MainController::setApplicationActive(bool active) {
+    if (active) {
+        if (applicationInactiveTimer_) {
+            applicationInactiveTimer_->stop();
+            applicationInactiveTimer_->onTick.disconnect(boost::bind(&MainController::handleApplicationInactiveTimerTick, this));
+            applicationInactiveTimer_.reset();
+        }
+        applicationActive_ = true;
+        updateClientState();
+    }
+    else if (applicationActive_ && !applicationInactiveTimer_) {
+        // On desktops, the application is not active whenever another window has the focus
+        applicationInactiveTimer_ = networkFactories_->getTimerFactory()->createTimer(SecondsInBackgroundBeforeInactive * 1000);
+        applicationInactiveTimer_->onTick.connect(boost::bind(&MainController::handleApplicationInactiveTimerTick, this));
+        applicationInactiveTimer_->start();
+    }
+}
+
+void MainController::handleApplicationInactiveTimerTick() {
+    applicationInactiveTimer_->onTick.disconnect(boost::bind(&MainController::handleApplicationInactiveTimerTick, this));
+    applicationInactiveTimer_.reset();
+    applicationActive_ = false;
+    updateClientState();
+}
+
+void MainController::updateClientState() {
+    if (client_) {
+        client_->getClientStateManager()->setClientState(applicationActive_ && !inputIdle_ ? ClientState::ClientStateType::Active : ClientState::ClientStateType::Inactive);
+    }
+}
+
 void MainController::handleInputIdleChanged(bool idle) {
+    inputIdle_ = idle;
+    updateClientState();
+
     if (!statusTracker_) {
         //Haven't logged in yet.
         return;
@@ -605,6 +651,7 @@ void MainController::performLoginFromCachedCredentials() {
         client_->onConnected.connect(boost::bind(&MainController::handleConnected, this));
 
         client_->setSoftwareVersion(CLIENT_NAME, buildVersion);
+        updateClientState();
 
         client_->getVCardManager()->onVCardChanged.connect(boost::bind(&MainController::handleVCardReceived, this, _1, _2));
         presenceNotifier_ = new PresenceNotifier(client_->getStanzaChannel(), notifier_, client_->getMUCRegistry(), client_->getAvatarManager(), client_->getNickResolver(), client_->getPresenceOracle(), networkFactories_->getTimerFactory());
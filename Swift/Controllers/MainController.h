@@ -101,6 +101,14 @@ namespace Swift {
                     bool useDelayForLatency);
             ~MainController();
 
+            /**
+             * Tells whether the application is active, i.e. has a window in
+             * the foreground. The client is marked inactive once the
+             * application has not been active for a while (so that briefly
+             * switching to another window does not count), or while the
+             * user is idle.
+             */
+            void setApplicationActive(bool active);
 
         private:
             void resetClient();
@@ -117,6 +125,8 @@ namespace Swift {
             void handlePurgeSavedLoginRequest(const std::string& username);
             void sendPresence(std::shared_ptr<Presence> presence);
             void handleInputIdleChanged(bool);
+            void updateClientState();
+            void handleApplicationInactiveTimerTick();
             void handleShowCertificateRequest();
             void logout();
             void signOut();
@@ -190,9 +200,13 @@ namespace Swift {
             Timer::ref reconnectTimer_;
             StatusTracker* statusTracker_;
             bool myStatusLooksOnline_ = false;
+            bool applicationActive_ = true;
+            bool inputIdle_ = false;
+            Timer::ref applicationInactiveTimer_;
             bool quitRequested_;
             bool offlineRequested_;
             static const int SecondsToWaitBeforeForceQuitting;
+            static const int SecondsInBackgroundBeforeInactive;
             FileTransferOverview* ftOverview_;
             WhiteboardManager* whiteboardManager_;
             HighlightManager* highlightManager_;
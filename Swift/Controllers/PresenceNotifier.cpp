@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -77,7 +77,7 @@ void PresenceNotifier::handlePresenceReceived(std::shared_ptr<Presence> presence
 }
 
 void PresenceNotifier::handleStanzaChannelAvailableChanged(bool available) {
-    if (available) {
+    if (available && !stanzaChannel->isStreamResumed()) {
         availableUsers.clear();
         justInitialized = true;
         if (timer) {
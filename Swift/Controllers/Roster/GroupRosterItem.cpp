@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swift/Controllers/Roster/GroupRosterItem.h>
 
+#include <algorithm>
 #include <memory>
 
 #include <boost/bind.hpp>
@@ -154,6 +155,13 @@ bool GroupRosterItem::sortDisplayed() {
     return true;
 }
 
+/**
+ * Inserts the item at its place in the (sorted) displayed children.
+ */
+void GroupRosterItem::insertDisplayed(RosterItem* item) {
+    displayedChildren_.insert(std::upper_bound(displayedChildren_.begin(), displayedChildren_.end(), item, sortByStatus_? itemLessThanWithStatus : itemLessThanWithoutStatus), item);
+}
+
 bool GroupRosterItem::itemLessThanWithoutStatus(const RosterItem* left, const RosterItem* right) {
     return left->getSortableDisplayName() < right->getSortableDisplayName();
 }
@@ -191,8 +199,7 @@ void GroupRosterItem::setDisplayed(RosterItem* item, bool displayed) {
         return;
     }
     if (displayed) {
-        displayedChildren_.push_back(item);
-        sortDisplayed();
+        insertDisplayed(item);
     } else {
         displayedChildren_.erase(std::remove(displayedChildren_.begin(), displayedChildren_.end(), item), displayedChildren_.end());
     }
@@ -200,10 +207,14 @@ void GroupRosterItem::setDisplayed(RosterItem* item, bool displayed) {
     onDataChanged();
 }
 
-void GroupRosterItem::handleDataChanged(RosterItem* /*item*/) {
-    if (sortDisplayed()) {
-        onChildrenChanged();
+void GroupRosterItem::handleDataChanged(RosterItem* item) {
+    // Only the changed item can be out of place, so move it instead of resorting all of them
+    auto it = std::find(displayedChildren_.begin(), displayedChildren_.end(), item);
+    if (it != displayedChildren_.end()) {
+        displayedChildren_.erase(it);
+        insertDisplayed(item);
     }
+    onChildrenChanged();
 }
 
 void GroupRosterItem::handleChildrenChanged(GroupRosterItem* group) {
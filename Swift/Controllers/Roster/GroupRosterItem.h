@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -43,6 +43,7 @@ class GroupRosterItem : public RosterItem {
         void handleChildrenChanged(GroupRosterItem* group);
         void handleDataChanged(RosterItem* item);
         bool sortDisplayed();
+        void insertDisplayed(RosterItem* item);
 
     private:
         std::string name_;
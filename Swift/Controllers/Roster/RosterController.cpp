@@ -126,6 +126,12 @@ void RosterController::setEnabled(bool enabled) {
     if (!enabled) {
         roster_->applyOnItems(AppearOffline());
     }
+    else {
+        /* After a resumed stream the presences are kept, but nobody resends them */
+        for (const auto& item : xmppRoster_->getItems()) {
+            applyAllPresenceTo(item.getJID());
+        }
+    }
 }
 
 void RosterController::handleShowOfflineToggled(bool state) {
@@ -16,7 +16,7 @@
 
 namespace Swift {
 
-AvatarFileStorage::AvatarFileStorage(const boost::filesystem::path& avatarsDir, const boost::filesystem::path& avatarsFile, CryptoProvider* crypto) : avatarsDir(avatarsDir), avatarsFile(avatarsFile), crypto(crypto) {
+AvatarFileStorage::AvatarFileStorage(const boost::filesystem::path& avatarsDir, const boost::filesystem::path& avatarsFile, CryptoProvider* crypto) : avatarsDir(avatarsDir), avatarsFile(avatarsFile), crypto(crypto), avatarsFileEntries(0) {
     if (boost::filesystem::exists(avatarsFile)) {
         try {
             boost::filesystem::ifstream file(avatarsFile);
@@ -27,7 +27,9 @@ AvatarFileStorage::AvatarFileStorage(const boost::filesystem::path& avatarsDir,
                     std::pair<std::string, std::string> r = String::getSplittedAtFirst(line, ' ');
                     JID jid(r.second);
                     if (jid.isValid()) {
-                        jidAvatars.insert(std::make_pair(jid, r.first));
+                        // Later entries in the log override earlier ones
+                        jidAvatars[jid] = r.first;
+                        avatarsFileEntries++;
                     }
                     else if (!r.first.empty() || !r.second.empty()) {
                         SWIFT_LOG(error) << "Invalid entry in avatars file: " << r.second << std::endl;
@@ -41,13 +43,31 @@ AvatarFileStorage::AvatarFileStorage(const boost::filesystem::path& avatarsDir,
     }
 }
 
+AvatarFileStorage::~AvatarFileStorage() {
+    flush();
+}
+
 bool AvatarFileStorage::hasAvatar(const std::string& hash) const {
-    return boost::filesystem::exists(getAvatarPath(hash));
+    if (storedAvatars.find(hash) != storedAvatars.end()) {
+        return true;
+    }
+    if (boost::filesystem::exists(getAvatarPath(hash))) {
+        storedAvatars.insert(hash);
+        return true;
+    }
+    return false;
 }
 
 void AvatarFileStorage::addAvatar(const std::string& hash, const ByteArray& avatar) {
     assert(Hexify::hexify(crypto->getSHA1Hash(avatar)) == hash);
 
+    avatarCache.insert(hash, avatar);
+
+    // Avatars are stored by their hash, so an existing file already has the right content.
+    if (hasAvatar(hash)) {
+        return;
+    }
+
     boost::filesystem::path avatarPath = getAvatarPath(hash);
     if (!boost::filesystem::exists(avatarPath.parent_path())) {
         try {
@@ -58,9 +78,20 @@ void AvatarFileStorage::addAvatar(const std::string& hash, const ByteArray& avat
         }
     }
 
+    // Write to a temporary file first, so a partially written avatar is never picked up by hash.
+    boost::filesystem::path temporaryPath = avatarPath;
+    temporaryPath += ".tmp";
     try {
-        boost::filesystem::ofstream file(avatarPath, boost::filesystem::ofstream::binary|boost::filesystem::ofstream::out);
-        file.write(reinterpret_cast<const char*>(vecptr(avatar)), static_cast<std::streamsize>(avatar.size()));
+        {
+            boost::filesystem::ofstream file(temporaryPath, boost::filesystem::ofstream::binary|boost::filesystem::ofstream::out);
+            file.write(reinterpret_cast<const char*>(vecptr(avatar)), static_cast<std::streamsize>(avatar.size()));
+            if (!file) {
+                SWIFT_LOG(error) << "Error writing avatar " << hash << std::endl;
+                return;
+            }
+        }
+        boost::filesystem::rename(temporaryPath, avatarPath);
+        storedAvatars.insert(hash);
     }
     catch (const boost::filesystem::filesystem_error& e) {
         SWIFT_LOG(error) << "filesystem error: " << e.what() << std::endl;
@@ -72,6 +103,11 @@ boost::filesystem::path AvatarFileStorage::getAvatarPath(const std::string& hash
 }
 
 ByteArray AvatarFileStorage::getAvatar(const std::string& hash) const {
+    boost::optional<ByteArray> avatar = avatarCache.get(hash, [this](const std::string& key) { return loadAvatar(key); });
+    return avatar ? *avatar : ByteArray();
+}
+
+boost::optional<ByteArray> AvatarFileStorage::loadAvatar(const std::string& hash) const {
     ByteArray data;
     try {
         readByteArrayFromFile(data, getAvatarPath(hash));
@@ -79,17 +115,24 @@ ByteArray AvatarFileStorage::getAvatar(const std::string& hash) const {
     catch (const boost::filesystem::filesystem_error& e) {
         SWIFT_LOG(error) << "filesystem error: " << e.what() << std::endl;
     }
+    if (data.empty()) {
+        return boost::optional<ByteArray>();
+    }
+    storedAvatars.insert(hash);
     return data;
 }
 
 void AvatarFileStorage::setAvatarForJID(const JID& jid, const std::string& hash) {
     std::pair<JIDAvatarMap::iterator, bool> r = jidAvatars.insert(std::make_pair(jid, hash));
-    if (r.second) {
-        saveJIDAvatars();
-    }
-    else if (r.first->second != hash) {
+    if (!r.second) {
+        if (r.first->second == hash) {
+            return;
+        }
         r.first->second = hash;
-        saveJIDAvatars();
+    }
+    pendingJIDAvatars[jid] = hash;
+    if (pendingJIDAvatars.size() >= MaxPendingJIDAvatars) {
+        flush();
     }
 }
 
@@ -98,13 +141,46 @@ std::string AvatarFileStorage::getAvatarForJID(const JID& jid) const {
     return i == jidAvatars.end() ? "" : i->second;
 }
 
-void AvatarFileStorage::saveJIDAvatars() {
+void AvatarFileStorage::flush() {
+    if (pendingJIDAvatars.empty()) {
+        return;
+    }
+    // Compact the log once most of its entries are stale
+    if (avatarsFileEntries + pendingJIDAvatars.size() > 2 * jidAvatars.size() + MaxPendingJIDAvatars) {
+        saveJIDAvatars();
+    }
+    else {
+        appendJIDAvatars();
+    }
+    pendingJIDAvatars.clear();
+}
+
+void AvatarFileStorage::appendJIDAvatars() {
     try {
-        boost::filesystem::ofstream file(avatarsFile);
-        for (JIDAvatarMap::const_iterator i = jidAvatars.begin(); i != jidAvatars.end(); ++i) {
-            file << i->second << " " << i->first.toString() << std::endl;
+        boost::filesystem::ofstream file(avatarsFile, boost::filesystem::ofstream::out|boost::filesystem::ofstream::app);
+        for (JIDAvatarMap::const_iterator i = pendingJIDAvatars.begin(); i != pendingJIDAvatars.end(); ++i) {
+            file << i->second << " " << i->first.toString() << "\n";
         }
         file.close();
+        avatarsFileEntries += pendingJIDAvatars.size();
+    }
+    catch (...) {
+        SWIFT_LOG(error) << "Error writing avatars file" << std::endl;
+    }
+}
+
+void AvatarFileStorage::saveJIDAvatars() {
+    boost::filesystem::path temporaryFile = avatarsFile;
+    temporaryFile += ".tmp";
+    try {
+        {
+            boost::filesystem::ofstream file(temporaryFile);
+            for (JIDAvatarMap::const_iterator i = jidAvatars.begin(); i != jidAvatars.end(); ++i) {
+                file << i->second << " " << i->first.toString() << "\n";
+            }
+        }
+        boost::filesystem::rename(temporaryFile, avatarsFile);
+        avatarsFileEntries = jidAvatars.size();
     }
     catch (...) {
         SWIFT_LOG(error) << "Error writing avatars file" << std::endl;
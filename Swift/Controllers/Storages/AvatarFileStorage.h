@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,20 +7,33 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <string>
 
 #include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
 
 #include <Swiften/Avatars/AvatarStorage.h>
 #include <Swiften/Base/ByteArray.h>
+#include <Swiften/Base/LRUCache.h>
 #include <Swiften/JID/JID.h>
 
 namespace Swift {
     class CryptoProvider;
 
+    /**
+     * Stores avatars content-addressed by their hash in \p avatarsDir, and
+     * the JID to avatar hash mapping in \p avatarsFile.
+     *
+     * The mapping file is an append-only log of "hash jid" lines, where later
+     * lines override earlier ones. Changes are coalesced in memory and
+     * appended in batches; the file is compacted when it holds many stale
+     * entries. Recently used avatars are kept in memory.
+     */
     class AvatarFileStorage : public AvatarStorage {
         public:
             AvatarFileStorage(const boost::filesystem::path& avatarsDir, const boost::filesystem::path& avatarsFile, CryptoProvider* crypto);
+            virtual ~AvatarFileStorage();
 
             virtual bool hasAvatar(const std::string& hash) const;
             virtual void addAvatar(const std::string& hash, const ByteArray& avatar);
@@ -31,15 +44,29 @@ namespace Swift {
             virtual void setAvatarForJID(const JID& jid, const std::string& hash);
             virtual std::string getAvatarForJID(const JID& jid) const;
 
+            /**
+             * Writes all pending JID to avatar changes to the avatars file.
+             */
+            void flush();
+
         private:
+            boost::optional<ByteArray> loadAvatar(const std::string& hash) const;
+            void appendJIDAvatars();
             void saveJIDAvatars();
 
         private:
+            static const size_t MaxPendingJIDAvatars = 64;
+            static const size_t MaxCachedAvatars = 64;
+
             boost::filesystem::path avatarsDir;
             boost::filesystem::path avatarsFile;
             CryptoProvider* crypto;
             typedef std::map<JID, std::string> JIDAvatarMap;
             JIDAvatarMap jidAvatars;
+            JIDAvatarMap pendingJIDAvatars;
+            size_t avatarsFileEntries;
+            mutable std::set<std::string> storedAvatars;
+            mutable LRUCache<std::string, ByteArray, MaxCachedAvatars> avatarCache;
     };
 
 }
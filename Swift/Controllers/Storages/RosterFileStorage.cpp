@@ -1,11 +1,16 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swift/Controllers/Storages/RosterFileStorage.h>
 
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <Swiften/Base/ByteArray.h>
+#include <Swiften/Base/Log.h>
 #include <Swiften/Entity/GenericPayloadPersister.h>
 #include <Swiften/Parser/PayloadParsers/RosterParser.h>
 #include <Swiften/Serializer/PayloadSerializers/RosterSerializer.h>
@@ -14,13 +19,339 @@ using namespace Swift;
 
 typedef GenericPayloadPersister<RosterPayload, RosterParser, RosterSerializer> RosterPersister;
 
-RosterFileStorage::RosterFileStorage(const boost::filesystem::path& path) : path(path) {
+/*
+ * The log starts with a magic string, followed by records. Each record is a
+ * type byte followed by its length-prefixed content. Integers are stored as
+ * 32-bit little endian, and strings are length-prefixed.
+ */
+static const std::string LogMagic("SWRL\x01", 5);
+
+enum RecordType {
+    ItemRecord = 'I',
+    RemoveRecord = 'R',
+    VersionRecord = 'V'
+};
+
+static void appendUInt32(std::string& data, size_t value) {
+    for (int i = 0; i < 4; ++i) {
+        data += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+static void appendString(std::string& data, const std::string& value) {
+    appendUInt32(data, value.size());
+    data += value;
+}
+
+static void appendRecord(std::string& data, RecordType type, const std::string& content) {
+    data += static_cast<char>(type);
+    appendString(data, content);
+}
+
+static std::string serializeItem(const RosterItemPayload& item) {
+    std::string result;
+    appendString(result, item.getJID().toString());
+    appendString(result, item.getName());
+    result += static_cast<char>(item.getSubscription());
+    result += static_cast<char>(item.getSubscriptionRequested() ? 1 : 0);
+    appendUInt32(result, item.getGroups().size());
+    for (const auto& group : item.getGroups()) {
+        appendString(result, group);
+    }
+    appendString(result, item.getUnknownContent());
+    return result;
+}
+
+namespace {
+    class LogReader {
+        public:
+            LogReader(const char* begin, const char* end) : position(begin), end(end) {
+            }
+
+            bool atEnd() const {
+                return position == end;
+            }
+
+            bool readByte(unsigned char& value) {
+                if (position == end) {
+                    return false;
+                }
+                value = static_cast<unsigned char>(*position++);
+                return true;
+            }
+
+            bool readUInt32(size_t& value) {
+                if (end - position < 4) {
+                    return false;
+                }
+                value = 0;
+                for (int i = 0; i < 4; ++i) {
+                    value |= static_cast<size_t>(static_cast<unsigned char>(*position++)) << (8 * i);
+                }
+                return true;
+            }
+
+            bool readBytes(size_t size, const char*& begin) {
+                if (static_cast<size_t>(end - position) < size) {
+                    return false;
+                }
+                begin = position;
+                position += size;
+                return true;
+            }
+
+            bool readString(std::string& value) {
+                size_t size = 0;
+                const char* begin = nullptr;
+                if (!readUInt32(size) || !readBytes(size, begin)) {
+                    return false;
+                }
+                value.assign(begin, size);
+                return true;
+            }
+
+        private:
+            const char* position;
+            const char* end;
+    };
+}
+
+static bool parseItem(LogReader& reader, RosterItemPayload& item) {
+    std::string jid, name, group, unknownContent;
+    unsigned char subscription = 0, ask = 0;
+    size_t groupCount = 0;
+    if (!reader.readString(jid) || !reader.readString(name) || !reader.readByte(subscription) || !reader.readByte(ask) || !reader.readUInt32(groupCount)) {
+        return false;
+    }
+    if (subscription >= RosterItemPayload::Remove) {
+        return false;
+    }
+    item.setJID(JID(jid));
+    item.setName(name);
+    item.setSubscription(static_cast<RosterItemPayload::Subscription>(subscription));
+    if (ask) {
+        item.setSubscriptionRequested();
+    }
+    for (size_t i = 0; i < groupCount; ++i) {
+        if (!reader.readString(group)) {
+            return false;
+        }
+        item.addGroup(group);
+    }
+    if (!reader.readString(unknownContent)) {
+        return false;
+    }
+    if (!unknownContent.empty()) {
+        item.addUnknownContent(unknownContent);
+    }
+    return item.getJID().isValid();
+}
+
+RosterFileStorage::RosterFileStorage(const boost::filesystem::path& path) : path(path), logPath(boost::filesystem::path(path).replace_extension(".dat")), loaded(false), hasRoster(false), logIntact(false), logRecords(0) {
 }
 
 std::shared_ptr<RosterPayload> RosterFileStorage::getRoster() const {
-    return RosterPersister().loadPayloadGeneric(path);
+    load();
+    if (!hasRoster) {
+        return std::shared_ptr<RosterPayload>();
+    }
+    std::shared_ptr<RosterPayload> roster = std::make_shared<RosterPayload>();
+    if (version) {
+        roster->setVersion(*version);
+    }
+    for (const auto& item : items) {
+        roster->addItem(item.second);
+    }
+    return roster;
 }
 
 void RosterFileStorage::setRoster(std::shared_ptr<RosterPayload> roster) {
-    RosterPersister().savePayload(roster, path);
+    // The stored roster is replaced, so there is no need to load it
+    loaded = true;
+    items.clear();
+    version.reset();
+    if (!roster) {
+        hasRoster = false;
+        logIntact = false;
+        try {
+            boost::filesystem::remove(logPath);
+            boost::filesystem::remove(path);
+        }
+        catch (const boost::filesystem::filesystem_error& e) {
+            SWIFT_LOG(error) << e.what() << std::endl;
+        }
+        return;
+    }
+    hasRoster = true;
+    version = roster->getVersion();
+    for (const auto& item : roster->getItems()) {
+        items[item.getJID()] = item;
+    }
+    writeSnapshot();
+}
+
+void RosterFileStorage::applyRosterPush(std::shared_ptr<RosterPayload> push) {
+    load();
+    // The pushed items alone are not a complete roster, and storing them with
+    // the push's version would keep the full roster from being fetched again
+    if (!hasRoster) {
+        return;
+    }
+    std::string records;
+    size_t recordCount = 0;
+    for (const auto& item : push->getItems()) {
+        if (item.getSubscription() == RosterItemPayload::Remove) {
+            items.erase(item.getJID());
+            appendRecord(records, RemoveRecord, item.getJID().toString());
+        }
+        else {
+            items[item.getJID()] = item;
+            appendRecord(records, ItemRecord, serializeItem(item));
+        }
+        recordCount++;
+    }
+    // The version goes last, so that an interrupted write leaves the old version
+    if (push->getVersion()) {
+        version = push->getVersion();
+        appendRecord(records, VersionRecord, *version);
+        recordCount++;
+    }
+
+    if (!logIntact || logRecords + recordCount > 2 * items.size() + MaxStaleRecords) {
+        writeSnapshot();
+    }
+    else {
+        appendToLog(records, recordCount);
+    }
+}
+
+void RosterFileStorage::load() const {
+    if (loaded) {
+        return;
+    }
+    loaded = true;
+    try {
+        if (boost::filesystem::exists(logPath)) {
+            logIntact = loadLog();
+        }
+        else if (boost::filesystem::exists(path)) {
+            loadXML();
+        }
+    }
+    catch (const boost::filesystem::filesystem_error& e) {
+        SWIFT_LOG(error) << e.what() << std::endl;
+    }
+}
+
+bool RosterFileStorage::loadLog() const {
+    ByteArray data;
+    readByteArrayFromFile(data, logPath);
+    const char* begin = reinterpret_cast<const char*>(vecptr(data));
+    LogReader reader(begin, begin + data.size());
+    const char* magic = nullptr;
+    if (!reader.readBytes(LogMagic.size(), magic) || std::string(magic, LogMagic.size()) != LogMagic) {
+        SWIFT_LOG(error) << "Unknown roster file format" << std::endl;
+        return false;
+    }
+    hasRoster = true;
+    while (!reader.atEnd()) {
+        unsigned char type = 0;
+        size_t size = 0;
+        const char* content = nullptr;
+        if (!reader.readByte(type) || !reader.readUInt32(size) || !reader.readBytes(size, content)) {
+            // Only the last write can have been interrupted, and its version
+            // record did not make it to the file.
+            SWIFT_LOG(warning) << "Truncated roster file" << std::endl;
+            return false;
+        }
+        LogReader recordReader(content, content + size);
+        logRecords++;
+        switch (type) {
+            case ItemRecord: {
+                RosterItemPayload item;
+                if (parseItem(recordReader, item)) {
+                    items[item.getJID()] = item;
+                }
+                else {
+                    SWIFT_LOG(error) << "Invalid item in roster file" << std::endl;
+                }
+                break;
+            }
+            case RemoveRecord:
+                items.erase(JID(std::string(content, size)));
+                break;
+            case VersionRecord:
+                version = std::string(content, size);
+                break;
+            default:
+                SWIFT_LOG(error) << "Unknown record in roster file" << std::endl;
+                break;
+        }
+    }
+    return true;
+}
+
+void RosterFileStorage::loadXML() const {
+    std::shared_ptr<RosterPayload> roster = RosterPersister().loadPayloadGeneric(path);
+    if (roster) {
+        hasRoster = true;
+        version = roster->getVersion();
+        for (const auto& item : roster->getItems()) {
+            items[item.getJID()] = item;
+        }
+    }
+}
+
+void RosterFileStorage::writeSnapshot() {
+    std::string data(LogMagic);
+    for (const auto& item : items) {
+        appendRecord(data, ItemRecord, serializeItem(item.second));
+    }
+    if (version) {
+        appendRecord(data, VersionRecord, *version);
+    }
+
+    boost::filesystem::path temporaryPath = logPath;
+    temporaryPath += ".tmp";
+    try {
+        if (!boost::filesystem::exists(logPath.parent_path())) {
+            boost::filesystem::create_directories(logPath.parent_path());
+        }
+        {
+            boost::filesystem::ofstream file(temporaryPath, boost::filesystem::ofstream::binary|boost::filesystem::ofstream::out);
+            file.write(data.c_str(), static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                SWIFT_LOG(error) << "Error writing roster file" << std::endl;
+                logIntact = false;
+                return;
+            }
+        }
+        boost::filesystem::rename(temporaryPath, logPath);
+        logIntact = true;
+        logRecords = items.size() + (version ? 1 : 0);
+
+        // The roster stored as XML by earlier versions is no longer current
+        boost::filesystem::remove(path);
+    }
+    catch (const boost::filesystem::filesystem_error& e) {
+        SWIFT_LOG(error) << e.what() << std::endl;
+        logIntact = false;
+    }
+}
+
+void RosterFileStorage::appendToLog(const std::string& records, size_t recordCount) {
+    try {
+        boost::filesystem::ofstream file(logPath, boost::filesystem::ofstream::binary|boost::filesystem::ofstream::out|boost::filesystem::ofstream::app);
+        file.write(records.c_str(), static_cast<std::streamsize>(records.size()));
+        if (!file) {
+            SWIFT_LOG(error) << "Error writing roster file" << std::endl;
+            logIntact = false;
+            return;
+        }
+        logRecords += recordCount;
+    }
+    catch (const boost::filesystem::filesystem_error& e) {
+        SWIFT_LOG(error) << e.what() << std::endl;
+        logIntact = false;
+    }
 }
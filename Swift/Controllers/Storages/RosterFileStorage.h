@@ -1,24 +1,59 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <map>
+#include <string>
+
 #include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
 
+#include <Swiften/Elements/RosterItemPayload.h>
+#include <Swiften/JID/JID.h>
 #include <Swiften/Roster/RosterStorage.h>
 
 namespace Swift {
+    /**
+     * Stores the roster in a binary, append-only log next to \p path.
+     *
+     * setRoster() writes a snapshot of the whole roster. Roster pushes are
+     * appended to the log as the changed and removed items, followed by the
+     * new version, so a push that was only partially written is applied
+     * again by the server. The log is compacted into a new snapshot once it
+     * holds many stale records.
+     *
+     * A roster stored as XML at \p path (by earlier versions) is still
+     * loaded, and replaced by a log on the next write.
+     */
     class RosterFileStorage : public RosterStorage {
         public:
             RosterFileStorage(const boost::filesystem::path& path);
 
             virtual std::shared_ptr<RosterPayload> getRoster() const;
             virtual void setRoster(std::shared_ptr<RosterPayload>);
+            virtual void applyRosterPush(std::shared_ptr<RosterPayload>);
+
+        private:
+            void load() const;
+            bool loadLog() const;
+            void loadXML() const;
+            void writeSnapshot();
+            void appendToLog(const std::string& records, size_t recordCount);
 
         private:
+            static const size_t MaxStaleRecords = 1000;
+
             boost::filesystem::path path;
+            boost::filesystem::path logPath;
+            mutable bool loaded;
+            mutable bool hasRoster;
+            mutable bool logIntact;
+            mutable size_t logRecords;
+            mutable boost::optional<std::string> version;
+            mutable std::map<JID, RosterItemPayload> items;
     };
 }
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <Swiften/Base/ByteArray.h>
+#include <QA/Checker/IO.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Crypto/CryptoProvider.h>
+#include <Swiften/Crypto/PlatformCryptoProvider.h>
+#include <Swiften/StringCodecs/Hexify.h>
+
+#include <Swift/Controllers/Storages/AvatarFileStorage.h>
+
+using namespace Swift;
+
+class AvatarFileStorageTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(AvatarFileStorageTest);
+        CPPUNIT_TEST(testAddAvatar);
+        CPPUNIT_TEST(testGetAvatar_Cached);
+        CPPUNIT_TEST(testGetAvatar_Unknown);
+        CPPUNIT_TEST(testSetAvatarForJID_PersistedOnDestruction);
+        CPPUNIT_TEST(testSetAvatarForJID_BatchesWrites);
+        CPPUNIT_TEST(testSetAvatarForJID_LaterEntryWins);
+        CPPUNIT_TEST(testSetAvatarForJID_CompactsFile);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp() {
+            crypto = std::shared_ptr<CryptoProvider>(PlatformCryptoProvider::create());
+            baseDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("avatar_file_storage_test_%%%%%%%%%%%%%%%%");
+            boost::filesystem::create_directories(baseDir);
+            avatarsDir = baseDir / "avatars";
+            avatarsFile = baseDir / "avatars.txt";
+        }
+
+        void tearDown() {
+            boost::filesystem::remove_all(baseDir);
+        }
+
+        void testAddAvatar() {
+            std::unique_ptr<AvatarFileStorage> testling(createTestling());
+            ByteArray avatar = createByteArray("avatar data");
+            std::string hash = Hexify::hexify(crypto->getSHA1Hash(avatar));
+
+            testling->addAvatar(hash, avatar);
+
+            CPPUNIT_ASSERT(testling->hasAvatar(hash));
+            ByteArray data;
+            readByteArrayFromFile(data, avatarsDir / hash);
+            CPPUNIT_ASSERT_EQUAL(avatar, data);
+            CPPUNIT_ASSERT(!boost::filesystem::exists(avatarsDir / (hash + ".tmp")));
+        }
+
+        void testGetAvatar_Cached() {
+            ByteArray avatar = createByteArray("avatar data");
+            std::string hash = Hexify::hexify(crypto->getSHA1Hash(avatar));
+            {
+                std::unique_ptr<AvatarFileStorage> testling(createTestling());
+                testling->addAvatar(hash, avatar);
+            }
+
+            std::unique_ptr<AvatarFileStorage> testling(createTestling());
+            CPPUNIT_ASSERT_EQUAL(avatar, testling->getAvatar(hash));
+            boost::filesystem::remove(avatarsDir / hash);
+
+            CPPUNIT_ASSERT_EQUAL(avatar, testling->getAvatar(hash));
+        }
+
+        void testGetAvatar_Unknown() {
+            std::unique_ptr<AvatarFileStorage> testling(createTestling());
+
+            CPPUNIT_ASSERT(!testling->hasAvatar("0123456789abcdef"));
+            CPPUNIT_ASSERT_EQUAL(ByteArray(), testling->getAvatar("0123456789abcdef"));
+        }
+
+        void testSetAvatarForJID_PersistedOnDestruction() {
+            {
+                std::unique_ptr<AvatarFileStorage> testling(createTestling());
+                testling->setAvatarForJID(JID("alice@wonderland.lit"), "abc");
+                testling->setAvatarForJID(JID("bob@wonderland.lit"), "def");
+                CPPUNIT_ASSERT(!boost::filesystem::exists(avatarsFile));
+            }
+
+            std::unique_ptr<AvatarFileStorage> testling(createTestling());
+            CPPUNIT_ASSERT_EQUAL(std::string("abc"), testling->getAvatarForJID(JID("alice@wonderland.lit")));
+            CPPUNIT_ASSERT_EQUAL(std::string("def"), testling->getAvatarForJID(JID("bob@wonderland.lit")));
+            CPPUNIT_ASSERT_EQUAL(std::string(""), testling->getAvatarForJID(JID("carol@wonderland.lit")));
+        }
+
+        void testSetAvatarForJID_BatchesWrites() {
+            std::unique_ptr<AvatarFileStorage> testling(createTestling());
+            for (size_t i = 0; i < 1000; ++i) {
+                testling->setAvatarForJID(createJID(i), "abc");
+            }
+            testling->flush();
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1000), getLineCount());
+            std::unique_ptr<AvatarFileStorage> reloaded(createTestling());
+            CPPUNIT_ASSERT_EQUAL(std::string("abc"), reloaded->getAvatarForJID(createJID(0)));
+            CPPUNIT_ASSERT_EQUAL(std::string("abc"), reloaded->getAvatarForJID(createJID(999)));
+        }
+
+        void testSetAvatarForJID_LaterEntryWins() {
+            {
+                std::unique_ptr<AvatarFileStorage> testling(createTestling());
+                testling->setAvatarForJID(JID("alice@wonderland.lit"), "abc");
+                testling->flush();
+                testling->setAvatarForJID(JID("alice@wonderland.lit"), "def");
+            }
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), getLineCount());
+            std::unique_ptr<AvatarFileStorage> testling(createTestling());
+            CPPUNIT_ASSERT_EQUAL(std::string("def"), testling->getAvatarForJID(JID("alice@wonderland.lit")));
+        }
+
+        void testSetAvatarForJID_CompactsFile() {
+            std::unique_ptr<AvatarFileStorage> testling(createTestling());
+            for (size_t i = 0; i < 1000; ++i) {
+                testling->setAvatarForJID(JID("alice@wonderland.lit"), std::to_string(i));
+                testling->flush();
+            }
+
+            CPPUNIT_ASSERT(getLineCount() < 100);
+            std::unique_ptr<AvatarFileStorage> reloaded(createTestling());
+            CPPUNIT_ASSERT_EQUAL(std::string("999"), reloaded->getAvatarForJID(JID("alice@wonderland.lit")));
+        }
+
+    private:
+        AvatarFileStorage* createTestling() {
+            return new AvatarFileStorage(avatarsDir, avatarsFile, crypto.get());
+        }
+
+        static JID createJID(size_t i) {
+            return JID("contact" + std::to_string(i) + "@wonderland.lit");
+        }
+
+        size_t getLineCount() {
+            boost::filesystem::ifstream file(avatarsFile);
+            size_t count = 0;
+            std::string line;
+            while (getline(file, line)) {
+                count++;
+            }
+            return count;
+        }
+
+    private:
+        std::shared_ptr<CryptoProvider> crypto;
+        boost::filesystem::path baseDir;
+        boost::filesystem::path avatarsDir;
+        boost::filesystem::path avatarsFile;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AvatarFileStorageTest);
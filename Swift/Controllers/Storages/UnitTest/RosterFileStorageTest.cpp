@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Elements/RosterItemPayload.h>
+#include <Swiften/Elements/RosterPayload.h>
+#include <Swiften/Entity/GenericPayloadPersister.h>
+#include <Swiften/Parser/PayloadParsers/RosterParser.h>
+#include <Swiften/Serializer/PayloadSerializers/RosterSerializer.h>
+
+#include <Swift/Controllers/Storages/RosterFileStorage.h>
+
+using namespace Swift;
+
+class RosterFileStorageTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(RosterFileStorageTest);
+        CPPUNIT_TEST(testGetRoster_NoRoster);
+        CPPUNIT_TEST(testSetRoster);
+        CPPUNIT_TEST(testSetRoster_Null);
+        CPPUNIT_TEST(testApplyRosterPush);
+        CPPUNIT_TEST(testApplyRosterPush_NoRoster);
+        CPPUNIT_TEST(testApplyRosterPush_AppendsToLog);
+        CPPUNIT_TEST(testApplyRosterPush_CompactsLog);
+        CPPUNIT_TEST(testGetRoster_TruncatedLog);
+        CPPUNIT_TEST(testGetRoster_XMLRoster);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp() {
+            baseDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("roster_file_storage_test_%%%%%%%%%%%%%%%%");
+            boost::filesystem::create_directories(baseDir);
+            xmlFile = baseDir / "roster.xml";
+            logFile = baseDir / "roster.dat";
+        }
+
+        void tearDown() {
+            boost::filesystem::remove_all(baseDir);
+        }
+
+        void testGetRoster_NoRoster() {
+            RosterFileStorage testling(xmlFile);
+
+            CPPUNIT_ASSERT(!testling.getRoster());
+        }
+
+        void testSetRoster() {
+            {
+                RosterFileStorage testling(xmlFile);
+                std::shared_ptr<RosterPayload> roster = std::make_shared<RosterPayload>();
+                roster->setVersion("ver1");
+                RosterItemPayload item(JID("alice@wonderland.lit"), "Alice", RosterItemPayload::Both);
+                item.addGroup("Friends");
+                item.addGroup("Wonderland");
+                roster->addItem(item);
+                RosterItemPayload item2(JID("bob@wonderland.lit"), "", RosterItemPayload::None);
+                item2.setSubscriptionRequested();
+                roster->addItem(item2);
+                testling.setRoster(roster);
+            }
+
+            RosterFileStorage testling(xmlFile);
+            std::shared_ptr<RosterPayload> roster = testling.getRoster();
+            CPPUNIT_ASSERT(roster);
+            CPPUNIT_ASSERT_EQUAL(std::string("ver1"), *roster->getVersion());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), roster->getItems().size());
+            boost::optional<RosterItemPayload> alice = roster->getItem(JID("alice@wonderland.lit"));
+            CPPUNIT_ASSERT(alice);
+            CPPUNIT_ASSERT_EQUAL(std::string("Alice"), alice->getName());
+            CPPUNIT_ASSERT_EQUAL(RosterItemPayload::Both, alice->getSubscription());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), alice->getGroups().size());
+            CPPUNIT_ASSERT_EQUAL(std::string("Wonderland"), alice->getGroups()[1]);
+            CPPUNIT_ASSERT(!alice->getSubscriptionRequested());
+            boost::optional<RosterItemPayload> bob = roster->getItem(JID("bob@wonderland.lit"));
+            CPPUNIT_ASSERT(bob);
+            CPPUNIT_ASSERT(bob->getSubscriptionRequested());
+        }
+
+        void testSetRoster_Null() {
+            RosterFileStorage testling(xmlFile);
+            testling.setRoster(createRoster("ver1", 2));
+
+            testling.setRoster(std::shared_ptr<RosterPayload>());
+
+            CPPUNIT_ASSERT(!testling.getRoster());
+            CPPUNIT_ASSERT(!RosterFileStorage(xmlFile).getRoster());
+        }
+
+        void testApplyRosterPush() {
+            {
+                RosterFileStorage testling(xmlFile);
+                testling.setRoster(createRoster("ver1", 3));
+                testling.applyRosterPush(createPush("ver2", RosterItemPayload(createJID(1), "Renamed", RosterItemPayload::To)));
+                testling.applyRosterPush(createPush("ver3", RosterItemPayload(createJID(2), "", RosterItemPayload::Remove)));
+                testling.applyRosterPush(createPush("ver4", RosterItemPayload(createJID(3), "New", RosterItemPayload::From)));
+            }
+
+            std::shared_ptr<RosterPayload> roster = RosterFileStorage(xmlFile).getRoster();
+            CPPUNIT_ASSERT_EQUAL(std::string("ver4"), *roster->getVersion());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), roster->getItems().size());
+            CPPUNIT_ASSERT(roster->getItem(createJID(0)));
+            CPPUNIT_ASSERT_EQUAL(std::string("Renamed"), roster->getItem(createJID(1))->getName());
+            CPPUNIT_ASSERT_EQUAL(RosterItemPayload::To, roster->getItem(createJID(1))->getSubscription());
+            CPPUNIT_ASSERT(!roster->getItem(createJID(2)));
+            CPPUNIT_ASSERT_EQUAL(std::string("New"), roster->getItem(createJID(3))->getName());
+        }
+
+        void testApplyRosterPush_NoRoster() {
+            {
+                RosterFileStorage testling(xmlFile);
+                testling.applyRosterPush(createPush("ver2", RosterItemPayload(createJID(1), "New", RosterItemPayload::Both)));
+
+                CPPUNIT_ASSERT(!testling.getRoster());
+            }
+
+            CPPUNIT_ASSERT(!RosterFileStorage(xmlFile).getRoster());
+        }
+
+        void testApplyRosterPush_AppendsToLog() {
+            RosterFileStorage testling(xmlFile);
+            testling.setRoster(createRoster("ver1", 100));
+            boost::uintmax_t snapshotSize = boost::filesystem::file_size(logFile);
+
+            testling.applyRosterPush(createPush("ver2", RosterItemPayload(createJID(1), "Renamed", RosterItemPayload::To)));
+
+            // Only the changed item and the version are written
+            boost::uintmax_t pushSize = boost::filesystem::file_size(logFile) - snapshotSize;
+            CPPUNIT_ASSERT(pushSize > 0);
+            CPPUNIT_ASSERT(pushSize < snapshotSize / 50);
+        }
+
+        void testApplyRosterPush_CompactsLog() {
+            RosterFileStorage testling(xmlFile);
+            testling.setRoster(createRoster("ver1", 10));
+            boost::uintmax_t snapshotSize = boost::filesystem::file_size(logFile);
+
+            for (int i = 0; i < 5000; ++i) {
+                testling.applyRosterPush(createPush("ver" + std::to_string(i + 2), RosterItemPayload(createJID(i % 10), "", RosterItemPayload::Both)));
+            }
+
+            CPPUNIT_ASSERT(boost::filesystem::file_size(logFile) < 100 * snapshotSize);
+            std::shared_ptr<RosterPayload> roster = RosterFileStorage(xmlFile).getRoster();
+            CPPUNIT_ASSERT_EQUAL(std::string("ver5001"), *roster->getVersion());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(10), roster->getItems().size());
+            CPPUNIT_ASSERT_EQUAL(std::string(""), roster->getItem(createJID(0))->getName());
+        }
+
+        void testGetRoster_TruncatedLog() {
+            boost::uintmax_t pushedSize = 0;
+            {
+                RosterFileStorage testling(xmlFile);
+                testling.setRoster(createRoster("ver1", 3));
+                testling.applyRosterPush(createPush("ver2", RosterItemPayload(createJID(3), "New", RosterItemPayload::Both)));
+                pushedSize = boost::filesystem::file_size(logFile);
+                testling.applyRosterPush(createPush("ver3", RosterItemPayload(createJID(4), "Newer", RosterItemPayload::Both)));
+            }
+            // Simulate a write that was interrupted halfway through the last push
+            boost::filesystem::resize_file(logFile, pushedSize + 10);
+
+            {
+                RosterFileStorage testling(xmlFile);
+                std::shared_ptr<RosterPayload> roster = testling.getRoster();
+                CPPUNIT_ASSERT_EQUAL(std::string("ver2"), *roster->getVersion());
+                CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), roster->getItems().size());
+
+                testling.applyRosterPush(createPush("ver3", RosterItemPayload(createJID(4), "Newer", RosterItemPayload::Both)));
+            }
+
+            std::shared_ptr<RosterPayload> roster = RosterFileStorage(xmlFile).getRoster();
+            CPPUNIT_ASSERT_EQUAL(std::string("ver3"), *roster->getVersion());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), roster->getItems().size());
+        }
+
+        void testGetRoster_XMLRoster() {
+            GenericPayloadPersister<RosterPayload, RosterParser, RosterSerializer>().savePayload(createRoster("ver1", 3), xmlFile);
+
+            {
+                RosterFileStorage testling(xmlFile);
+                std::shared_ptr<RosterPayload> roster = testling.getRoster();
+                CPPUNIT_ASSERT_EQUAL(std::string("ver1"), *roster->getVersion());
+                CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), roster->getItems().size());
+
+                testling.applyRosterPush(createPush("ver2", RosterItemPayload(createJID(3), "New", RosterItemPayload::Both)));
+            }
+
+            CPPUNIT_ASSERT(!boost::filesystem::exists(xmlFile));
+            std::shared_ptr<RosterPayload> roster = RosterFileStorage(xmlFile).getRoster();
+            CPPUNIT_ASSERT_EQUAL(std::string("ver2"), *roster->getVersion());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), roster->getItems().size());
+        }
+
+    private:
+        JID createJID(int i) {
+            return JID("contact" + std::to_string(i) + "@wonderland.lit");
+        }
+
+        std::shared_ptr<RosterPayload> createRoster(const std::string& version, int itemCount) {
+            std::shared_ptr<RosterPayload> roster = std::make_shared<RosterPayload>();
+            roster->setVersion(version);
+            for (int i = 0; i < itemCount; ++i) {
+                roster->addItem(RosterItemPayload(createJID(i), "Contact " + std::to_string(i), RosterItemPayload::Both, {"Group"}));
+            }
+            return roster;
+        }
+
+        std::shared_ptr<RosterPayload> createPush(const std::string& version, const RosterItemPayload& item) {
+            std::shared_ptr<RosterPayload> push = std::make_shared<RosterPayload>();
+            push->setVersion(version);
+            push->addItem(item);
+            return push;
+        }
+
+    private:
+        boost::filesystem::path baseDir;
+        boost::filesystem::path xmlFile;
+        boost::filesystem::path logFile;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RosterFileStorageTest);
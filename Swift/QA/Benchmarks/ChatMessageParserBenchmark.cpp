@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Parses a corpus of generated chat messages, containing emoticons, URLs, the
+ * own nickname and highlight keywords, with ChatMessageParser. For comparison,
+ * it also times the regular expression searches the parser used to run for
+ * each message (one alternation of all emoticons, and one word-bounded
+ * expression per keyword).
+ *
+ * Usage: ChatMessageParserBenchmark [message-count [keyword-count [emoticons-file]]]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/regex.hpp>
+
+#include <Swiften/Base/Regex.h>
+
+#include <Swift/Controllers/Chat/ChatMessageParser.h>
+#include <Swift/Controllers/Highlighting/HighlightConfiguration.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static std::map<std::string, std::string> loadEmoticons(const std::string& fileName) {
+    std::map<std::string, std::string> emoticons;
+    std::ifstream file(fileName.c_str());
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream tokens(line);
+        std::string emoticon, path, extra;
+        if ((tokens >> emoticon >> path) && !(tokens >> extra)) {
+            emoticons[emoticon] = path;
+        }
+    }
+    if (emoticons.empty()) {
+        for (const char* emoticon : {":)", ":-)", ":(", ":-(", ";)", ";-)", ":D", ":-D", ":P", ":-P", ":O", ":-O", ":/", ":-/", ":|", ":-|", "<3", "(:"}) {
+            emoticons[emoticon] = std::string("qrc:/emoticons/") + emoticon + ".png";
+        }
+    }
+    return emoticons;
+}
+
+static std::vector<std::string> createCorpus(int messageCount, const std::vector<std::string>& emoticons, const std::vector<std::string>& keywords, const std::string& nick) {
+    static const char* words[] = {
+        "the", "a", "meeting", "is", "at", "noon", "please", "review", "my", "patch", "build", "failed", "again",
+        "anyone", "seen", "this", "error", "before", "thanks", "lunch", "deploy", "tomorrow", "server", "logs"
+    };
+    std::mt19937 random(42);
+    std::uniform_int_distribution<size_t> wordCount(3, 40);
+    std::uniform_int_distribution<size_t> word(0, sizeof(words) / sizeof(words[0]) - 1);
+    std::uniform_int_distribution<size_t> emoticon(0, emoticons.size() - 1);
+    std::uniform_int_distribution<size_t> keyword(0, keywords.empty() ? 0 : keywords.size() - 1);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    std::vector<std::string> corpus;
+    for (int i = 0; i < messageCount; ++i) {
+        std::string message;
+        size_t count = wordCount(random);
+        for (size_t j = 0; j < count; ++j) {
+            if (!message.empty()) {
+                message += " ";
+            }
+            int kind = percent(random);
+            if (kind < 5) {
+                message += emoticons[emoticon(random)];
+            }
+            else if (kind < 7 && !keywords.empty()) {
+                message += keywords[keyword(random)];
+            }
+            else if (kind < 8) {
+                message += nick;
+            }
+            else if (kind < 9) {
+                message += "http://wonderland.lit/" + std::string(words[word(random)]);
+            }
+            else {
+                message += words[word(random)];
+            }
+        }
+        corpus.push_back(message);
+    }
+    return corpus;
+}
+
+static double runParser(const std::vector<std::string>& corpus, ChatMessageParser& parser, size_t& parts) {
+    parts = 0;
+    Clock::time_point start = Clock::now();
+    for (const auto& message : corpus) {
+        parts += parser.parseMessageBody(message, "Romeo").getParts().size();
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static double runRegularExpressions(const std::vector<std::string>& corpus, const std::map<std::string, std::string>& emoticons, const std::vector<std::string>& keywords, size_t& matches) {
+    matches = 0;
+    Clock::time_point start = Clock::now();
+    for (const auto& message : corpus) {
+        std::string regexString;
+        for (const auto& emoticon : emoticons) {
+            regexString += regexString.empty() ? "" : "|";
+            std::string escaped = "(" + Regex::escape(emoticon.first) + ")";
+            regexString += "^" + escaped + "|" + escaped + "$|\\s" + escaped + "|" + escaped + "\\s";
+        }
+        boost::regex emoticonRegex(regexString);
+        boost::match_results<std::string::const_iterator> match;
+        std::string::const_iterator position = message.begin();
+        while (boost::regex_search(position, message.end(), match, emoticonRegex)) {
+            matches++;
+            position = match[0].second;
+        }
+        for (const auto& keyword : keywords) {
+            boost::regex keywordRegex("\\b" + Regex::escape(keyword) + "\\b", boost::regex::normal | boost::regex::icase);
+            position = message.begin();
+            while (boost::regex_search(position, message.end(), match, keywordRegex)) {
+                matches++;
+                position = match[0].second;
+            }
+        }
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const std::string& name, size_t messageCount, double seconds, const std::string& details) {
+    std::cout << std::left << std::setw(20) << name << std::right
+        << std::setw(10) << std::fixed << std::setprecision(1) << (seconds * 1e3) << " ms"
+        << std::setw(10) << std::setprecision(2) << (seconds * 1e6 / messageCount) << " us/message"
+        << "    " << details << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int messageCount = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int keywordCount = argc > 2 ? std::atoi(argv[2]) : 20;
+    std::map<std::string, std::string> emoticons = loadEmoticons(argc > 3 ? argv[3] : "Swift/resources/emoticons/emoticons.txt");
+    std::string nick("Juliet");
+
+    std::shared_ptr<HighlightConfiguration> highlightConfiguration = std::make_shared<HighlightConfiguration>();
+    highlightConfiguration->ownMentionAction.setFrontColor(std::string("black"));
+    highlightConfiguration->ownMentionAction.setBackColor(std::string("yellow"));
+    std::vector<std::string> keywords;
+    for (int i = 0; i < keywordCount; ++i) {
+        HighlightConfiguration::KeywordHightlight keywordHighlight;
+        keywordHighlight.keyword = "keyword" + std::to_string(i);
+        keywordHighlight.matchCaseSensitive = (i % 2 == 0);
+        keywordHighlight.action.setFrontColor(std::string("#121212"));
+        highlightConfiguration->keywordHighlights.push_back(keywordHighlight);
+        keywords.push_back(keywordHighlight.keyword);
+    }
+
+    std::vector<std::string> emoticonTexts;
+    for (const auto& emoticon : emoticons) {
+        emoticonTexts.push_back(emoticon.first);
+    }
+    std::vector<std::string> corpus = createCorpus(messageCount, emoticonTexts, keywords, nick);
+
+    std::cout << "Parsing " << messageCount << " messages with " << emoticons.size() << " emoticons and " << keywordCount << " highlight keywords" << std::endl;
+
+    ChatMessageParser parser(emoticons, highlightConfiguration, ChatMessageParser::Mode::GroupChat);
+    parser.setNick(nick);
+    size_t parts = 0;
+    double parserSeconds = runParser(corpus, parser, parts);
+    report("ChatMessageParser", corpus.size(), parserSeconds, std::to_string(parts) + " message parts");
+
+    std::vector<std::string> regexKeywords(keywords);
+    regexKeywords.insert(regexKeywords.begin(), nick);
+    size_t matches = 0;
+    double regexSeconds = runRegularExpressions(corpus, emoticons, regexKeywords, matches);
+    report("regex searches", corpus.size(), regexSeconds, std::to_string(matches) + " matches");
+    return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Simulates joining a large room, followed by a burst of occupants entering
+ * it (e.g. after a netsplit), and reports how long the MUCController takes to
+ * process the presences and how often it re-renders the join/part summary.
+ * The burst is replayed with join/part updates coalesced on a timer, and with
+ * every update rendered immediately.
+ *
+ * Usage: MUCControllerBenchmark [occupant-count] [milliseconds-between-presences]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <Swiften/Avatars/NullAvatarManager.h>
+#include <Swiften/Client/ClientBlockListManager.h>
+#include <Swiften/Client/DummyStanzaChannel.h>
+#include <Swiften/Client/NickResolver.h>
+#include <Swiften/Crypto/CryptoProvider.h>
+#include <Swiften/Crypto/PlatformCryptoProvider.h>
+#include <Swiften/Disco/DummyEntityCapsProvider.h>
+#include <Swiften/Elements/MUCUserPayload.h>
+#include <Swiften/MUC/MUCBookmarkManager.h>
+#include <Swiften/MUC/MUCImpl.h>
+#include <Swiften/MUC/MUCRegistry.h>
+#include <Swiften/Network/DummyTimerFactory.h>
+#include <Swiften/Presence/DirectedPresenceSender.h>
+#include <Swiften/Presence/PresenceOracle.h>
+#include <Swiften/Presence/StanzaChannelPresenceSender.h>
+#include <Swiften/Queries/DummyIQChannel.h>
+#include <Swiften/Queries/IQRouter.h>
+#include <Swiften/Roster/XMPPRosterImpl.h>
+#include <Swiften/VCards/VCardManager.h>
+#include <Swiften/VCards/VCardMemoryStorage.h>
+
+#include <Swift/Controllers/Chat/ChatMessageParser.h>
+#include <Swift/Controllers/Chat/Chattables.h>
+#include <Swift/Controllers/Chat/MUCController.h>
+#include <Swift/Controllers/Highlighting/HighlightManager.h>
+#include <Swift/Controllers/Settings/DummySettingsProvider.h>
+#include <Swift/Controllers/UIEvents/UIEventStream.h>
+#include <Swift/Controllers/UIInterfaces/ChatWindowFactory.h>
+#include <Swift/Controllers/UnitTest/MockChatWindow.h>
+#include <Swift/Controllers/XMPPEvents/EventController.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+class CountingChatWindow : public MockChatWindow {
+    public:
+        virtual void replaceLastMessage(const ChatMessage& message, const TimestampBehaviour timestampBehaviour) override {
+            MockChatWindow::replaceLastMessage(message, timestampBehaviour);
+            renders++;
+            renderedCharacters += bodyFromMessage(message).size();
+        }
+
+        size_t renders = 0;
+        size_t renderedCharacters = 0;
+};
+
+class CountingChatWindowFactory : public ChatWindowFactory {
+    public:
+        virtual ChatWindow* createChatWindow(const JID&, UIEventStream*) override {
+            window = new CountingChatWindow();
+            return window;
+        }
+
+        CountingChatWindow* window = nullptr;
+};
+
+struct Result {
+    double joinSeconds;
+    double burstSeconds;
+    size_t renders;
+    size_t renderedCharacters;
+};
+
+static Presence::ref createOccupantPresence(const JID& room, const std::string& nick, bool self) {
+    Presence::ref presence = std::make_shared<Presence>();
+    presence->setFrom(room.withResource(nick));
+    MUCUserPayload::ref payload = std::make_shared<MUCUserPayload>();
+    payload->addItem(MUCItem(MUCOccupant::Member, MUCOccupant::Participant));
+    if (self) {
+        payload->addStatusCode(MUCUserPayload::StatusCode(110));
+    }
+    presence->addPayload(payload);
+    return presence;
+}
+
+static Result run(int occupantCount, int interval, bool coalesce) {
+    JID self("alice@wonderland.lit/rabbithole");
+    JID room("teaparty@rooms.wonderland.lit");
+    std::string nick("alice");
+
+    std::unique_ptr<CryptoProvider> crypto(PlatformCryptoProvider::create());
+    DummyStanzaChannel stanzaChannel;
+    DummyIQChannel iqChannel;
+    IQRouter iqRouter(&iqChannel);
+    XMPPRosterImpl xmppRoster;
+    PresenceOracle presenceOracle(&stanzaChannel, &xmppRoster);
+    StanzaChannelPresenceSender presenceSender(&stanzaChannel);
+    DirectedPresenceSender directedPresenceSender(&presenceSender);
+    UIEventStream uiEventStream;
+    NullAvatarManager avatarManager;
+    EventController eventController;
+    MUCRegistry mucRegistry;
+    DummyEntityCapsProvider entityCapsProvider;
+    DummySettingsProvider settings;
+    HighlightManager highlightManager(&settings);
+    highlightManager.resetToDefaultConfiguration();
+    VCardMemoryStorage vcardStorage(crypto.get());
+    VCardManager vcardManager(self, &iqRouter, &vcardStorage);
+    NickResolver nickResolver(self, &xmppRoster, &vcardManager, &mucRegistry);
+    ClientBlockListManager clientBlockListManager(&iqRouter);
+    MUCBookmarkManager mucBookmarkManager(&iqRouter);
+    Chattables chattables;
+    DummyTimerFactory timerFactory;
+    CountingChatWindowFactory chatWindowFactory;
+    std::shared_ptr<ChatMessageParser> chatMessageParser = std::make_shared<ChatMessageParser>(std::map<std::string, std::string>(), highlightManager.getConfiguration(), ChatMessageParser::Mode::GroupChat);
+    MUC::ref muc = std::make_shared<MUCImpl>(&stanzaChannel, &iqRouter, &directedPresenceSender, room, &mucRegistry);
+
+    MUCController controller(self, muc, boost::optional<std::string>(), nick, &stanzaChannel, &iqRouter, &chatWindowFactory, &nickResolver, &presenceOracle, &avatarManager, &uiEventStream, false, coalesce ? &timerFactory : nullptr, &eventController, &entityCapsProvider, nullptr, nullptr, &mucRegistry, &highlightManager, &clientBlockListManager, chatMessageParser, false, nullptr, &vcardManager, &mucBookmarkManager, &settings, chattables);
+
+    Result result = Result();
+
+    // The room sends the presence of everyone already in it, and ends with our own
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < occupantCount; ++i) {
+        stanzaChannel.onPresenceReceived(createOccupantPresence(room, "occupant" + std::to_string(i), false));
+    }
+    stanzaChannel.onPresenceReceived(createOccupantPresence(room, nick, true));
+    result.joinSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Someone says something, so the burst starts a new join/part summary
+    Message::ref message = std::make_shared<Message>();
+    message->setType(Message::Groupchat);
+    message->setFrom(room.withResource("occupant0"));
+    message->setBody("Hello");
+    controller.handleIncomingMessage(std::make_shared<MessageEvent>(message));
+
+    int time = 0;
+    start = Clock::now();
+    for (int i = 0; i < occupantCount; ++i) {
+        stanzaChannel.onPresenceReceived(createOccupantPresence(room, "newcomer" + std::to_string(i), false));
+        time += interval;
+        timerFactory.setTime(time);
+    }
+    timerFactory.setTime(time + 1000);
+    result.burstSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.renders = chatWindowFactory.window->renders;
+    result.renderedCharacters = chatWindowFactory.window->renderedCharacters;
+    return result;
+}
+
+static void report(const std::string& name, int occupantCount, const Result& result) {
+    std::cout << std::left << std::setw(12) << name << std::right
+        << std::setw(10) << std::fixed << std::setprecision(1) << (result.joinSeconds * 1e3) << " ms to join"
+        << std::setw(10) << (result.burstSeconds * 1e3) << " ms for the burst"
+        << std::setw(10) << (result.burstSeconds * 1e6 / occupantCount) << " us/presence"
+        << std::setw(8) << result.renders << " renders"
+        << std::setw(12) << result.renderedCharacters << " characters rendered" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int occupantCount = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int interval = argc > 2 ? std::atoi(argv[2]) : 1;
+
+    std::cout << "Joining a room with " << occupantCount << " occupants, followed by " << occupantCount << " more entering " << interval << " ms apart" << std::endl;
+    report("coalesced", occupantCount, run(occupantCount, interval, true));
+    report("immediate", occupantCount, run(occupantCount, interval, false));
+    return 0;
+}
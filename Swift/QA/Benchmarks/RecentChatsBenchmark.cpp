@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures storing and loading the recent chats list, as ChatsManager does on
+ * chat activity and on startup, with the Boost text archives used by earlier
+ * versions and with RecentChatsSerializer. Both include the Base64 encoding
+ * needed to store the list as a profile setting.
+ *
+ * Usage: RecentChatsBenchmark [chat-count [iterations]]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Swiften/Base/ByteArray.h>
+#include <Swiften/StringCodecs/Base64.h>
+
+#include <Swift/Controllers/Chat/ChatListWindowChatBoostSerialize.h>
+#include <Swift/Controllers/Chat/RecentChatsSerializer.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static std::vector<ChatListWindow::Chat> createChats(int chatCount) {
+    std::vector<ChatListWindow::Chat> chats;
+    for (int i = 0; i < chatCount; ++i) {
+        if (i % 4 == 0) {
+            ChatListWindow::Chat chat(JID("room" + std::to_string(i) + "@rooms.wonderland.lit"), "Room " + std::to_string(i), "", 0, StatusShow::None, "", true, false, "Alice");
+            if (i % 8 == 0) {
+                chat.impromptuJIDs["Contact " + std::to_string(i)] = JID("contact" + std::to_string(i) + "@wonderland.lit");
+                chat.inviteesNames[JID("contact" + std::to_string(i + 1) + "@wonderland.lit")] = "Contact " + std::to_string(i + 1);
+            }
+            chats.push_back(chat);
+        }
+        else {
+            chats.push_back(ChatListWindow::Chat(JID("contact" + std::to_string(i) + "@wonderland.lit"), "Contact " + std::to_string(i), "Did you see the rabbit go by? " + std::to_string(i), 0, StatusShow::None, "", false));
+        }
+    }
+    return chats;
+}
+
+static std::string saveBoost(const std::vector<ChatListWindow::Chat>& chats) {
+    std::stringstream stream;
+    boost::archive::text_oarchive archive(stream);
+    archive & chats;
+    return Base64::encode(createByteArray(stream.str()));
+}
+
+static std::vector<ChatListWindow::Chat> loadBoost(const std::string& data) {
+    ByteArray decoded = Base64::decode(data);
+    std::vector<ChatListWindow::Chat> chats;
+    std::stringstream stream(std::string(reinterpret_cast<const char*>(vecptr(decoded)), decoded.size()));
+    boost::archive::text_iarchive archive(stream);
+    archive >> chats;
+    return chats;
+}
+
+static std::string saveBinary(const std::vector<ChatListWindow::Chat>& chats) {
+    return Base64::encode(RecentChatsSerializer::serialize(chats));
+}
+
+static std::vector<ChatListWindow::Chat> loadBinary(const std::string& data) {
+    return RecentChatsSerializer::deserialize(Base64::decode(data)).get_value_or(std::vector<ChatListWindow::Chat>());
+}
+
+template<typename Save, typename Load>
+static void benchmark(const std::string& name, const std::vector<ChatListWindow::Chat>& chats, int iterations, Save save, Load load) {
+    std::string data;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        data = save(chats);
+    }
+    double saveSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    size_t loaded = 0;
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        loaded += load(data).size();
+    }
+    double loadSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (loaded != chats.size() * static_cast<size_t>(iterations)) {
+        std::cerr << "Unexpected number of chats loaded" << std::endl;
+    }
+
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+        << "save " << std::setw(10) << (saveSeconds * 1e6 / iterations) << " us"
+        << "    load " << std::setw(10) << (loadSeconds * 1e6 / iterations) << " us"
+        << "    setting " << std::setw(8) << data.size() << " bytes" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int chatCount = argc > 1 ? std::atoi(argv[1]) : 25;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    std::vector<ChatListWindow::Chat> chats = createChats(chatCount);
+    std::cout << "Storing and loading " << chatCount << " recent chats" << std::endl;
+    benchmark("Boost archive", chats, iterations, saveBoost, loadBoost);
+    benchmark("Binary", chats, iterations, saveBinary, loadBinary);
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Stores a large roster with RosterFileStorage, applies a series of roster
+ * pushes to it, and loads it again (as happens on startup). For comparison,
+ * the same is done with the XML file the roster used to be stored in, which
+ * was rewritten completely on every push.
+ *
+ * The roster is loaded in a separate process, because JID preparation is
+ * cached for the lifetime of a process.
+ *
+ * Usage: RosterStorageBenchmark [item-count [push-count]]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <Swiften/Elements/RosterItemPayload.h>
+#include <Swiften/Elements/RosterPayload.h>
+#include <Swiften/Entity/GenericPayloadPersister.h>
+#include <Swiften/Parser/PayloadParsers/RosterParser.h>
+#include <Swiften/Serializer/PayloadSerializers/RosterSerializer.h>
+
+#include <Swift/Controllers/Storages/RosterFileStorage.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+typedef GenericPayloadPersister<RosterPayload, RosterParser, RosterSerializer> RosterPersister;
+
+static JID createJID(int i) {
+    return JID("contact" + std::to_string(i) + "@wonderland.lit");
+}
+
+static std::shared_ptr<RosterPayload> createRoster(int itemCount) {
+    std::shared_ptr<RosterPayload> roster = std::make_shared<RosterPayload>();
+    roster->setVersion("ver0");
+    for (int i = 0; i < itemCount; ++i) {
+        roster->addItem(RosterItemPayload(createJID(i), "Contact " + std::to_string(i), RosterItemPayload::Both, {"Group " + std::to_string(i % 20)}));
+    }
+    return roster;
+}
+
+static std::shared_ptr<RosterPayload> createPush(int i, int itemCount) {
+    std::shared_ptr<RosterPayload> push = std::make_shared<RosterPayload>();
+    push->setVersion("ver" + std::to_string(i + 1));
+    push->addItem(RosterItemPayload(createJID((i * 7919) % itemCount), "Renamed " + std::to_string(i), RosterItemPayload::Both, {"Group"}));
+    return push;
+}
+
+// What XMPPRosterController used to store on every push
+static std::shared_ptr<RosterPayload> applyPush(std::shared_ptr<RosterPayload> roster, std::shared_ptr<RosterPayload> push) {
+    std::shared_ptr<RosterPayload> result = std::make_shared<RosterPayload>();
+    result->setVersion(*push->getVersion());
+    const RosterItemPayload& pushedItem = push->getItems()[0];
+    for (const auto& item : roster->getItems()) {
+        result->addItem(item.getJID() == pushedItem.getJID() ? pushedItem : item);
+    }
+    return result;
+}
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Loads the roster in a new process, and returns the time it took
+static double load(const std::string& program, const std::string& format, const boost::filesystem::path& path) {
+    std::string command = "\"" + program + "\" load-" + format + " \"" + path.string() + "\"";
+    FILE* output = popen(command.c_str(), "r");
+    double seconds = -1;
+    if (!output || fscanf(output, "%lf", &seconds) != 1) {
+        std::cerr << "Error loading roster" << std::endl;
+    }
+    if (output) {
+        pclose(output);
+    }
+    return seconds;
+}
+
+static int runLoad(const std::string& format, const boost::filesystem::path& path) {
+    Clock::time_point start = Clock::now();
+    std::shared_ptr<RosterPayload> roster = (format == "log" ? RosterFileStorage(path).getRoster() : RosterPersister().loadPayloadGeneric(path));
+    double seconds = secondsSince(start);
+    if (!roster) {
+        return 1;
+    }
+    std::cout << std::setprecision(9) << seconds << std::endl;
+    return 0;
+}
+
+static void report(const std::string& name, double pushSeconds, int pushCount, double loadSeconds, boost::uintmax_t fileSize) {
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(3)
+        << "push " << std::setw(10) << (pushSeconds * 1e3 / pushCount) << " ms"
+        << "    load " << std::setw(10) << (loadSeconds * 1e3) << " ms"
+        << "    file " << std::setw(10) << fileSize / 1024 << " KiB" << std::endl;
+}
+
+static void benchmarkLog(const std::string& program, const boost::filesystem::path& path, int itemCount, int pushCount) {
+    {
+        RosterFileStorage storage(path);
+        storage.setRoster(createRoster(itemCount));
+    }
+    boost::filesystem::path logPath = boost::filesystem::path(path).replace_extension(".dat");
+    RosterFileStorage storage(path);
+    storage.getRoster();
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < pushCount; ++i) {
+        storage.applyRosterPush(createPush(i, itemCount));
+    }
+    double pushSeconds = secondsSince(start);
+
+    report("RosterFileStorage", pushSeconds, pushCount, load(program, "log", path), boost::filesystem::file_size(logPath));
+}
+
+static void benchmarkXML(const std::string& program, const boost::filesystem::path& path, int itemCount, int pushCount) {
+    std::shared_ptr<RosterPayload> roster = createRoster(itemCount);
+    RosterPersister().savePayload(roster, path);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < pushCount; ++i) {
+        roster = applyPush(roster, createPush(i, itemCount));
+        RosterPersister().savePayload(roster, path);
+    }
+    double pushSeconds = secondsSince(start);
+
+    report("XML file", pushSeconds, pushCount, load(program, "xml", path), boost::filesystem::file_size(path));
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]).compare(0, 5, "load-") == 0) {
+        return runLoad(std::string(argv[1]).substr(5), argv[2]);
+    }
+    int itemCount = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int pushCount = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    boost::filesystem::path baseDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("roster_storage_benchmark_%%%%%%%%%%%%%%%%");
+    boost::filesystem::create_directories(baseDir);
+
+    std::cout << "Applying " << pushCount << " pushes to a roster of " << itemCount << " items" << std::endl;
+    benchmarkLog(argv[0], baseDir / "log" / "roster.xml", itemCount, pushCount);
+    benchmarkXML(argv[0], baseDir / "xml" / "roster.xml", itemCount, pushCount);
+
+    boost::filesystem::remove_all(baseDir);
+    return 0;
+}
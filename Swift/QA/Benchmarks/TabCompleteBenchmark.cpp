@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Feeds the nicks of a large room into a TabComplete the way MUCController
+ * does (every occupant on join, and again when they speak), completes nicks
+ * the way the chat window does on every press of tab, and finally removes
+ * all nicks again, reporting the time taken by each phase.
+ *
+ * Usage: TabCompleteBenchmark [nick-count [completion-count]]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <SwifTools/TabComplete.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void report(const std::string& phase, double milliseconds, int count) {
+    std::cout << std::left << std::setw(12) << phase << std::right << std::fixed << std::setprecision(3)
+        << std::setw(12) << milliseconds << " ms total" << std::setw(12) << (milliseconds * 1e3 / count) << " us each" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int nickCount = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int completionCount = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    // Nicks in mixed case, sharing prefixes like real nicks do
+    static const char* prefixes[] = { "Al", "al", "Bo", "Ch", "da", "El", "Fr", "Gu", "ha", "Iv", "Ja", "ke", "Lu", "Ma", "no", "Ol" };
+    std::vector<std::string> nicks;
+    for (int i = 0; i < nickCount; ++i) {
+        nicks.push_back(prefixes[i % 16] + std::string("ice") + std::to_string(i));
+    }
+
+    TabComplete completer;
+    std::cout << "Room with " << nickCount << " occupants" << std::endl;
+
+    Clock::time_point start = Clock::now();
+    for (const auto& nick : nicks) {
+        completer.addWord(nick);
+    }
+    report("join", millisecondsSince(start), nickCount);
+
+    start = Clock::now();
+    for (int i = 0; i < completionCount; ++i) {
+        completer.addWord(nicks[(static_cast<size_t>(i) * 7919) % nicks.size()]);
+    }
+    report("speak", millisecondsSince(start), completionCount);
+
+    // Type two letters and press tab, cycle through a few candidates, and
+    // type a third letter and press tab again
+    start = Clock::now();
+    size_t found = 0;
+    for (int i = 0; i < completionCount; ++i) {
+        std::string prefix = std::string(prefixes[i % 16]);
+        std::string completion = completer.completeWord(prefix);
+        for (int j = 0; j < 5; ++j) {
+            completion = completer.completeWord(completion);
+        }
+        completion = completer.completeWord(prefix + "i");
+        found += completion.size();
+        completer.addWord(nicks[(static_cast<size_t>(i) * 104729) % nicks.size()]);
+    }
+    report("complete", millisecondsSince(start), completionCount);
+    if (found == 0) {
+        std::cerr << "No completions found" << std::endl;
+    }
+
+    start = Clock::now();
+    for (const auto& nick : nicks) {
+        completer.removeWord(nick);
+    }
+    report("leave", millisecondsSince(start), nickCount);
+    return 0;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -335,6 +335,8 @@ QtSwift::QtSwift(const po::variables_map& options) : networkFactories_(&clientMa
     }
 
     connect(qApp, SIGNAL(aboutToQuit()), this, SLOT(handleAboutToQuit()));
+    connect(qApp, &QGuiApplication::applicationStateChanged, this, &QtSwift::handleApplicationStateChanged);
+    handleApplicationStateChanged(qApp->applicationState());
 }
 
 QtSwift::~QtSwift() {
@@ -372,6 +374,12 @@ void QtSwift::handleAboutToQuit() {
 #endif
 }
 
+void QtSwift::handleApplicationStateChanged(Qt::ApplicationState state) {
+    for (auto* controller : mainControllers_) {
+        controller->setApplicationActive(state == Qt::ApplicationActive);
+    }
+}
+
 void QtSwift::handleAutoUpdaterStateChanged(AutoUpdater::State updatedState) {
     switch (updatedState) {
     case AutoUpdater::State::NotCheckedForUpdatesYet:
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -66,6 +66,7 @@ namespace Swift {
 
         private slots:
             void handleAboutToQuit();
+            void handleApplicationStateChanged(Qt::ApplicationState state);
             void handleAutoUpdaterStateChanged(AutoUpdater::State updatedState);
 
         private:
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,6 +11,7 @@
 
 #include <Swiften/Avatars/AvatarProvider.h>
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Elements/ErrorPayload.h>
 #include <Swiften/Elements/Presence.h>
 #include <Swiften/Elements/VCard.h>
@@ -38,9 +39,11 @@ namespace Swift {
 
         private:
             VCardManager* vcardManager_;
+            StanzaChannel* stanzaChannel_;
             AvatarStorage* avatarStorage_;
             CryptoProvider* crypto_;
             MUCRegistry* mucRegistry_;
             std::map<JID, std::string> avatarHashes_;
+            ScopedSignalConnection presenceReceivedConnection_;
     };
 }
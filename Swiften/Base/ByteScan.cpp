@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Base/ByteScan.h>
+
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SWIFTEN_BYTESCAN_SSE2
+#include <emmintrin.h>
+// AVX2 code is compiled with function target attributes, and only used
+// when the CPU supports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SWIFTEN_BYTESCAN_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define SWIFTEN_BYTESCAN_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace Swift;
+using namespace Swift::ByteScan;
+
+namespace {
+    typedef size_t (*FindFunction)(const unsigned char*, size_t, CharacterClass);
+
+    template<CharacterClass characterClass>
+    inline bool matches(unsigned char c) {
+        switch (characterClass) {
+            case NonASCII: return c >= 0x80;
+            case XMLTextSpecial: return c == '&' || c == '<' || c == '>';
+            case XMLAttributeSpecial: return c == '&' || c == '<' || c == '>' || c == '\'' || c == '"';
+        }
+        return false;
+    }
+
+    template<CharacterClass characterClass>
+    size_t findFirstScalar(const unsigned char* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            if (matches<characterClass>(data[i])) {
+                return i;
+            }
+        }
+        return length;
+    }
+
+    template<template<CharacterClass> class Finder>
+    size_t findFirstOfClass(const unsigned char* data, size_t length, CharacterClass characterClass) {
+        switch (characterClass) {
+            case NonASCII: return Finder<NonASCII>::find(data, length);
+            case XMLTextSpecial: return Finder<XMLTextSpecial>::find(data, length);
+            case XMLAttributeSpecial: return Finder<XMLAttributeSpecial>::find(data, length);
+        }
+        assert(false);
+        return length;
+    }
+
+    template<CharacterClass characterClass>
+    struct ScalarFinder {
+        static size_t find(const unsigned char* data, size_t length) {
+            return findFirstScalar<characterClass>(data, length);
+        }
+    };
+
+#if defined(SWIFTEN_BYTESCAN_SSE2) || defined(SWIFTEN_BYTESCAN_AVX2)
+    inline size_t getFirstSetBit(unsigned int mask) {
+#if defined(__GNUC__)
+        return static_cast<size_t>(__builtin_ctz(mask));
+#else
+        size_t result = 0;
+        while (!(mask & 1)) {
+            mask >>= 1;
+            result++;
+        }
+        return result;
+#endif
+    }
+#endif
+
+#ifdef SWIFTEN_BYTESCAN_SSE2
+    template<CharacterClass characterClass>
+    inline __m128i matchSSE2(__m128i block) {
+        switch (characterClass) {
+            case NonASCII:
+                // Only the high bit of each byte is used
+                return block;
+            case XMLTextSpecial:
+                return _mm_or_si128(_mm_or_si128(
+                        _mm_cmpeq_epi8(block, _mm_set1_epi8('&')),
+                        _mm_cmpeq_epi8(block, _mm_set1_epi8('<'))),
+                        _mm_cmpeq_epi8(block, _mm_set1_epi8('>')));
+            case XMLAttributeSpecial:
+                return _mm_or_si128(_mm_or_si128(matchSSE2<XMLTextSpecial>(block),
+                        _mm_cmpeq_epi8(block, _mm_set1_epi8('\''))),
+                        _mm_cmpeq_epi8(block, _mm_set1_epi8('"')));
+        }
+        return _mm_setzero_si128();
+    }
+
+    template<CharacterClass characterClass>
+    struct SSE2Finder {
+        static size_t find(const unsigned char* data, size_t length) {
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(matchSSE2<characterClass>(block)));
+                if (mask) {
+                    return i + getFirstSetBit(mask);
+                }
+            }
+            return i + findFirstScalar<characterClass>(data + i, length - i);
+        }
+    };
+#endif
+
+#ifdef SWIFTEN_BYTESCAN_AVX2
+    template<CharacterClass characterClass>
+    __attribute__((target("avx2"))) inline __m256i matchAVX2(__m256i block) {
+        switch (characterClass) {
+            case NonASCII:
+                return block;
+            case XMLTextSpecial:
+                return _mm256_or_si256(_mm256_or_si256(
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('&')),
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('<'))),
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('>')));
+            case XMLAttributeSpecial:
+                return _mm256_or_si256(_mm256_or_si256(matchAVX2<XMLTextSpecial>(block),
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\''))),
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"')));
+        }
+        return _mm256_setzero_si256();
+    }
+
+    template<CharacterClass characterClass>
+    struct AVX2Finder {
+        __attribute__((target("avx2"))) static size_t find(const unsigned char* data, size_t length) {
+            size_t i = 0;
+            for (; i + 32 <= length; i += 32) {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(matchAVX2<characterClass>(block)));
+                if (mask) {
+                    return i + getFirstSetBit(mask);
+                }
+            }
+            return i + SSE2Finder<characterClass>::find(data + i, length - i);
+        }
+    };
+
+    bool isAVX2Supported() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+
+#ifdef SWIFTEN_BYTESCAN_NEON
+    template<CharacterClass characterClass>
+    inline uint8x16_t matchNEON(uint8x16_t block) {
+        switch (characterClass) {
+            case NonASCII:
+                return vcgeq_u8(block, vdupq_n_u8(0x80));
+            case XMLTextSpecial:
+                return vorrq_u8(vorrq_u8(
+                        vceqq_u8(block, vdupq_n_u8('&')),
+                        vceqq_u8(block, vdupq_n_u8('<'))),
+                        vceqq_u8(block, vdupq_n_u8('>')));
+            case XMLAttributeSpecial:
+                return vorrq_u8(vorrq_u8(matchNEON<XMLTextSpecial>(block),
+                        vceqq_u8(block, vdupq_n_u8('\''))),
+                        vceqq_u8(block, vdupq_n_u8('"')));
+        }
+        return vdupq_n_u8(0);
+    }
+
+    template<CharacterClass characterClass>
+    struct NEONFinder {
+        static size_t find(const unsigned char* data, size_t length) {
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16) {
+                if (vmaxvq_u8(matchNEON<characterClass>(vld1q_u8(data + i)))) {
+                    // NEON has no movemask, so locate the byte in the block
+                    return i + findFirstScalar<characterClass>(data + i, 16);
+                }
+            }
+            return i + findFirstScalar<characterClass>(data + i, length - i);
+        }
+    };
+#endif
+
+    FindFunction getFindFunction(Implementation implementation) {
+        switch (implementation) {
+            case Scalar: return &findFirstOfClass<ScalarFinder>;
+#ifdef SWIFTEN_BYTESCAN_SSE2
+            case SSE2: return &findFirstOfClass<SSE2Finder>;
+#endif
+#ifdef SWIFTEN_BYTESCAN_AVX2
+            case AVX2: return &findFirstOfClass<AVX2Finder>;
+#endif
+#ifdef SWIFTEN_BYTESCAN_NEON
+            case NEON: return &findFirstOfClass<NEONFinder>;
+#endif
+            default: break;
+        }
+        assert(false);
+        return &findFirstOfClass<ScalarFinder>;
+    }
+
+    FindFunction getDefaultFindFunction() {
+        static const FindFunction findFunction = getFindFunction(getSupportedImplementations().back());
+        return findFunction;
+    }
+}
+
+namespace Swift {
+namespace ByteScan {
+
+size_t findFirst(const unsigned char* data, size_t length, CharacterClass characterClass) {
+    return getDefaultFindFunction()(data, length, characterClass);
+}
+
+size_t findFirst(const unsigned char* data, size_t length, CharacterClass characterClass, Implementation implementation) {
+    return getFindFunction(implementation)(data, length, characterClass);
+}
+
+std::vector<Implementation> getSupportedImplementations() {
+    std::vector<Implementation> result;
+    result.push_back(Scalar);
+#ifdef SWIFTEN_BYTESCAN_SSE2
+    result.push_back(SSE2);
+#endif
+#ifdef SWIFTEN_BYTESCAN_AVX2
+    if (isAVX2Supported()) {
+        result.push_back(AVX2);
+    }
+#endif
+#ifdef SWIFTEN_BYTESCAN_NEON
+    result.push_back(NEON);
+#endif
+    return result;
+}
+
+}
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <Swiften/Base/API.h>
+
+namespace Swift {
+    /**
+     * Finds the first byte of a class in a buffer, using the widest vector
+     * instructions the CPU supports.
+     */
+    namespace ByteScan {
+        enum CharacterClass {
+            /** Bytes with the high bit set, i.e. not ASCII */
+            NonASCII,
+            /** The characters escaped in XML character data: & < > */
+            XMLTextSpecial,
+            /** The characters escaped in XML attribute values: & < > ' " */
+            XMLAttributeSpecial
+        };
+
+        enum Implementation {
+            Scalar,
+            SSE2,
+            AVX2,
+            NEON
+        };
+
+        /**
+         * Returns the offset of the first byte of \p characterClass in
+         * \p data, or \p length if there is none.
+         */
+        SWIFTEN_API size_t findFirst(const unsigned char* data, size_t length, CharacterClass characterClass);
+
+        inline size_t findFirst(const char* data, size_t length, CharacterClass characterClass) {
+            return findFirst(reinterpret_cast<const unsigned char*>(data), length, characterClass);
+        }
+
+        /**
+         * Same as above, but using a specific implementation, which has
+         * to be supported.
+         */
+        SWIFTEN_API size_t findFirst(const unsigned char* data, size_t length, CharacterClass characterClass, Implementation implementation);
+
+        /**
+         * Returns the implementations supported by this build and CPU.
+         * The last one is the one used by default.
+         */
+        SWIFTEN_API std::vector<Implementation> getSupportedImplementations();
+    }
+}
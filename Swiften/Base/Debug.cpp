@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2016 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -170,6 +170,9 @@ std::ostream& operator<<(std::ostream& os, Swift::ClientSession::State state) {
         case CS::State::EnablingSessionManagement:
             os << "ClientSession::State::EnablingSessionManagement";
             break;
+        case CS::State::ResumingStream:
+            os << "ClientSession::State::ResumingStream";
+            break;
         case CS::State::BindingResource:
             os << "ClientSession::State::BindingResource";
             break;
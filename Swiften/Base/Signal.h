@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace Swift {
+    namespace Detail {
+        class SignalSlotBase {
+            public:
+                SignalSlotBase() : connected(true) {}
+                virtual ~SignalSlotBase() {}
+
+                bool connected;
+        };
+    }
+
+    /**
+     * A handle to a slot connected to a Signal, which can be used to
+     * disconnect it. It stays valid after the signal is destroyed.
+     */
+    class SignalConnection {
+        public:
+            SignalConnection() {}
+            explicit SignalConnection(const std::weak_ptr<Detail::SignalSlotBase>& slot) : slot_(slot) {}
+
+            void disconnect() const {
+                if (std::shared_ptr<Detail::SignalSlotBase> slot = slot_.lock()) {
+                    slot->connected = false;
+                }
+            }
+
+            bool connected() const {
+                std::shared_ptr<Detail::SignalSlotBase> slot = slot_.lock();
+                return slot && slot->connected;
+            }
+
+        private:
+            std::weak_ptr<Detail::SignalSlotBase> slot_;
+    };
+
+    /**
+     * A SignalConnection that disconnects its slot when it is destroyed.
+     */
+    class ScopedSignalConnection : public SignalConnection, public boost::noncopyable {
+        public:
+            ScopedSignalConnection() {}
+            ScopedSignalConnection(const SignalConnection& connection) : SignalConnection(connection) {}
+
+            ~ScopedSignalConnection() {
+                disconnect();
+            }
+
+            ScopedSignalConnection& operator=(const SignalConnection& connection) {
+                disconnect();
+                SignalConnection::operator=(connection);
+                return *this;
+            }
+
+            /**
+             * Returns the connection, without disconnecting it when this
+             * object is destroyed.
+             */
+            SignalConnection release() {
+                SignalConnection connection = *this;
+                SignalConnection::operator=(SignalConnection());
+                return connection;
+            }
+    };
+
+    template<typename Signature> class Signal;
+
+    /**
+     * A signal for code that runs on a single thread (i.e. the event loop).
+     *
+     * This supports the subset of the boost::signals2::signal API that is
+     * used in Swiften, with connect() returning a SignalConnection. Unlike
+     * boost::signals2, emitting a signal does not lock a mutex or copy the
+     * list of slots, so it is a lot cheaper.
+     *
+     * Slots are not tracked: binding an object derived from
+     * boost::signals2::trackable does not disconnect the slot when the
+     * object is destroyed. Subscribers that don't outlive the signal have
+     * to disconnect explicitly, e.g. by holding a ScopedSignalConnection.
+     *
+     * Slots may be connected and disconnected during emission: slots that
+     * are connected are not called until the next emission, and slots that
+     * are disconnected are not called anymore. Disconnected slots (and the
+     * objects bound into them) are released on a later emission, connect()
+     * or disconnect() call. The signal may also be
+     * destroyed by one of its slots, in which case the remaining slots are
+     * not called.
+     */
+    template<typename... Args>
+    class Signal<void (Args...)> : public boost::noncopyable {
+        public:
+            typedef void result_type;
+            typedef boost::function<void (Args...)> slot_type;
+
+            Signal() : state_(new State()) {
+            }
+
+            ~Signal() {
+                for (const auto& slot : state_->slots) {
+                    slot->connected = false;
+                }
+                if (state_->emissions > 0) {
+                    // Deleted when the outermost emission finishes
+                    state_->destroyed = true;
+                }
+                else {
+                    delete state_;
+                }
+            }
+
+            SignalConnection connect(const slot_type& function) {
+                // Slots disconnected through their SignalConnection are only
+                // flagged, so purge them here as well for signals that are
+                // rarely emitted. Doing this when the list has doubled keeps
+                // connect() amortized constant time.
+                if (state_->slots.size() >= state_->compactionSize && state_->emissions == 0) {
+                    removeDisconnectedSlots(state_);
+                    state_->compactionSize = 2 * state_->slots.size();
+                    if (state_->compactionSize < MinimumCompactionSize) {
+                        state_->compactionSize = MinimumCompactionSize;
+                    }
+                }
+                std::shared_ptr<Slot> slot = std::make_shared<Slot>(function);
+                state_->slots.push_back(slot);
+                return SignalConnection(slot);
+            }
+
+            /**
+             * Disconnects all slots that compare equal to \p function (e.g.
+             * the result of the same boost::bind expression).
+             */
+            template<typename Function>
+            void disconnect(const Function& function) {
+                for (const auto& slot : state_->slots) {
+                    if (slot->connected && slot->function == function) {
+                        slot->connected = false;
+                    }
+                }
+                removeDisconnectedSlots(state_);
+            }
+
+            void disconnect_all_slots() {
+                for (const auto& slot : state_->slots) {
+                    slot->connected = false;
+                }
+                removeDisconnectedSlots(state_);
+            }
+
+            bool empty() const {
+                return num_slots() == 0;
+            }
+
+            size_t num_slots() const {
+                size_t result = 0;
+                for (const auto& slot : state_->slots) {
+                    result += slot->connected;
+                }
+                return result;
+            }
+
+            void operator()(Args... args) const {
+                State* state = state_;
+                Emission emission(state);
+                const size_t slotCount = state->slots.size();
+                for (size_t i = 0; i < slotCount && !state->destroyed; ++i) {
+                    // Slots are not removed from the list while emitting, and
+                    // are held by the list, so they stay valid while called
+                    Slot* slot = state->slots[i].get();
+                    if (slot->connected) {
+                        slot->function(args...);
+                    }
+                    else {
+                        emission.sawDisconnectedSlot = true;
+                    }
+                }
+            }
+
+        private:
+            class Slot : public Detail::SignalSlotBase {
+                public:
+                    Slot(const slot_type& function) : function(function) {}
+
+                    slot_type function;
+            };
+
+            enum { MinimumCompactionSize = 8 };
+
+            struct State {
+                State() : compactionSize(MinimumCompactionSize), emissions(0), destroyed(false) {}
+
+                std::vector< std::shared_ptr<Slot> > slots;
+                size_t compactionSize;
+                int emissions;
+                bool destroyed;
+            };
+
+            class Emission {
+                public:
+                    Emission(State* state) : sawDisconnectedSlot(false), state_(state) {
+                        ++state_->emissions;
+                    }
+
+                    ~Emission() {
+                        if (--state_->emissions == 0) {
+                            if (state_->destroyed) {
+                                delete state_;
+                            }
+                            else if (sawDisconnectedSlot) {
+                                removeDisconnectedSlots(state_);
+                            }
+                        }
+                    }
+
+                    bool sawDisconnectedSlot;
+
+                private:
+                    State* state_;
+            };
+
+            static void removeDisconnectedSlots(State* state) {
+                if (state->emissions > 0) {
+                    return;
+                }
+                size_t kept = 0;
+                for (size_t i = 0; i < state->slots.size(); ++i) {
+                    if (state->slots[i]->connected) {
+                        state->slots[kept++].swap(state->slots[i]);
+                    }
+                }
+                state->slots.resize(kept);
+            }
+
+        private:
+            State* state_;
+    };
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <Swiften/Base/ByteScan.h>
+
+using namespace Swift;
+
+namespace {
+    const ByteScan::CharacterClass characterClasses[] = { ByteScan::NonASCII, ByteScan::XMLTextSpecial, ByteScan::XMLAttributeSpecial };
+
+    void expectSameAsScalar(const std::vector<unsigned char>& data, size_t offset, size_t length, ByteScan::CharacterClass characterClass) {
+        size_t expected = ByteScan::findFirst(&data[offset], length, characterClass, ByteScan::Scalar);
+        for (auto implementation : ByteScan::getSupportedImplementations()) {
+            ASSERT_EQ(expected, ByteScan::findFirst(&data[offset], length, characterClass, implementation)) << "implementation " << implementation << ", class " << characterClass << ", offset " << offset << ", length " << length;
+        }
+        ASSERT_EQ(expected, ByteScan::findFirst(&data[offset], length, characterClass));
+    }
+}
+
+TEST(ByteScanTest, testFindFirst) {
+    std::string text("<message>Hello & welcome</message>");
+
+    ASSERT_EQ(0U, ByteScan::findFirst(text.data(), text.size(), ByteScan::XMLTextSpecial));
+    ASSERT_EQ(7U, ByteScan::findFirst(text.data() + 1, text.size() - 1, ByteScan::XMLTextSpecial));
+    ASSERT_EQ(text.size(), ByteScan::findFirst(text.data(), text.size(), ByteScan::NonASCII));
+}
+
+TEST(ByteScanTest, testFindFirst_Empty) {
+    for (auto characterClass : characterClasses) {
+        for (auto implementation : ByteScan::getSupportedImplementations()) {
+            ASSERT_EQ(0U, ByteScan::findFirst(static_cast<const unsigned char*>(nullptr), 0, characterClass, implementation));
+        }
+    }
+}
+
+TEST(ByteScanTest, testFindFirst_Classes) {
+    std::string text("a'b\"c&d<e>f\xc3\xa9");
+
+    ASSERT_EQ(1U, ByteScan::findFirst(text.data(), text.size(), ByteScan::XMLAttributeSpecial));
+    ASSERT_EQ(5U, ByteScan::findFirst(text.data(), text.size(), ByteScan::XMLTextSpecial));
+    ASSERT_EQ(11U, ByteScan::findFirst(text.data(), text.size(), ByteScan::NonASCII));
+}
+
+TEST(ByteScanTest, testGetSupportedImplementations) {
+    std::vector<ByteScan::Implementation> implementations = ByteScan::getSupportedImplementations();
+
+    ASSERT_FALSE(implementations.empty());
+    ASSERT_EQ(ByteScan::Scalar, implementations[0]);
+}
+
+// Every byte value at the start, middle and end of buffers up to several
+// vector widths long
+TEST(ByteScanTest, testFindFirst_AllBytes) {
+    const size_t maxLength = 70;
+    std::vector<unsigned char> data(maxLength, 'a');
+    for (auto characterClass : characterClasses) {
+        for (int byte = 0; byte < 256; ++byte) {
+            for (size_t length = 1; length <= maxLength; ++length) {
+                for (size_t position : {size_t(0), length / 2, length - 1}) {
+                    data[position] = static_cast<unsigned char>(byte);
+                    expectSameAsScalar(data, 0, length, characterClass);
+                    data[position] = 'a';
+                }
+            }
+        }
+    }
+}
+
+// A special character at every position of buffers up to several vector
+// widths long, starting at different alignments
+TEST(ByteScanTest, testFindFirst_AllPositions) {
+    const size_t maxLength = 70;
+    const size_t maxOffset = 32;
+    const unsigned char bytes[] = { '"', '<', 0x80 };
+    std::vector<unsigned char> data(maxOffset + maxLength, 'a');
+    for (auto characterClass : characterClasses) {
+        for (unsigned char byte : bytes) {
+            for (size_t offset = 0; offset < maxOffset; offset += 5) {
+                for (size_t length = 0; length <= maxLength; ++length) {
+                    expectSameAsScalar(data, offset, length, characterClass);
+                    for (size_t position = 0; position < length; ++position) {
+                        data[offset + position] = byte;
+                        expectSameAsScalar(data, offset, length, characterClass);
+                        data[offset + position] = 'a';
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(ByteScanTest, testFindFirst_Random) {
+    std::mt19937 random(0);
+    std::uniform_int_distribution<int> byteDistribution(0, 255);
+    std::uniform_int_distribution<size_t> lengthDistribution(0, 300);
+    for (int i = 0; i < 2000; ++i) {
+        std::vector<unsigned char> data(lengthDistribution(random) + 1, 'x');
+        // Sparse matches, so that most runs span several vectors
+        for (size_t j = 0; j < data.size(); ++j) {
+            if (random() % 64 == 0) {
+                data[j] = static_cast<unsigned char>(byteDistribution(random));
+            }
+        }
+        size_t offset = random() % data.size();
+        for (auto characterClass : characterClasses) {
+            expectSameAsScalar(data, offset, data.size() - offset, characterClass);
+        }
+    }
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <Swiften/Base/Signal.h>
+
+#include <gtest/gtest.h>
+
+using namespace Swift;
+
+namespace {
+    class Receiver {
+        public:
+            void handleValue(int value) {
+                values.push_back(value);
+            }
+
+            std::vector<int> values;
+    };
+}
+
+TEST(SignalTest, testEmit_CallsSlotsInConnectionOrder) {
+    Signal<void (int)> testling;
+    std::vector<std::string> calls;
+    testling.connect([&](int value) { calls.push_back("a" + std::to_string(value)); });
+    testling.connect([&](int value) { calls.push_back("b" + std::to_string(value)); });
+
+    testling(1);
+    testling(2);
+
+    ASSERT_EQ(std::vector<std::string>({"a1", "b1", "a2", "b2"}), calls);
+    ASSERT_EQ(2U, testling.num_slots());
+}
+
+TEST(SignalTest, testEmit_WithoutSlots) {
+    Signal<void (const std::string&)> testling;
+
+    testling("foo");
+
+    ASSERT_TRUE(testling.empty());
+}
+
+TEST(SignalTest, testDisconnect_Connection) {
+    Signal<void (int)> testling;
+    Receiver receiver;
+    SignalConnection connection = testling.connect(boost::bind(&Receiver::handleValue, &receiver, _1));
+
+    testling(1);
+    ASSERT_TRUE(connection.connected());
+    connection.disconnect();
+    testling(2);
+
+    ASSERT_FALSE(connection.connected());
+    ASSERT_EQ(std::vector<int>({1}), receiver.values);
+    ASSERT_TRUE(testling.empty());
+}
+
+TEST(SignalTest, testConnect_ReleasesSlotsDisconnectedThroughConnection) {
+    Signal<void (int)> testling;
+    std::shared_ptr<int> boundValue = std::make_shared<int>(0);
+    for (int i = 0; i < 100; ++i) {
+        testling.connect([boundValue](int) {}).disconnect();
+    }
+
+    // Only slots disconnected since the last compaction are still held
+    ASSERT_GT(boundValue.use_count(), 1);
+    ASSERT_LT(boundValue.use_count(), 10);
+    ASSERT_TRUE(testling.empty());
+}
+
+TEST(SignalTest, testDisconnect_BindExpression) {
+    Signal<void (int)> testling;
+    Receiver receiver1;
+    Receiver receiver2;
+    testling.connect(boost::bind(&Receiver::handleValue, &receiver1, _1));
+    testling.connect(boost::bind(&Receiver::handleValue, &receiver2, _1));
+
+    testling.disconnect(boost::bind(&Receiver::handleValue, &receiver1, _1));
+    testling(1);
+
+    ASSERT_TRUE(receiver1.values.empty());
+    ASSERT_EQ(std::vector<int>({1}), receiver2.values);
+    ASSERT_EQ(1U, testling.num_slots());
+}
+
+TEST(SignalTest, testDisconnectAllSlots) {
+    Signal<void (int)> testling;
+    Receiver receiver;
+    SignalConnection connection = testling.connect(boost::bind(&Receiver::handleValue, &receiver, _1));
+
+    testling.disconnect_all_slots();
+    testling(1);
+
+    ASSERT_FALSE(connection.connected());
+    ASSERT_TRUE(receiver.values.empty());
+}
+
+TEST(SignalTest, testDisconnectDuringEmission_SkipsLaterSlot) {
+    Signal<void (int)> testling;
+    Receiver receiver;
+    SignalConnection connection;
+    testling.connect([&](int) { connection.disconnect(); });
+    connection = testling.connect(boost::bind(&Receiver::handleValue, &receiver, _1));
+
+    testling(1);
+    testling(2);
+
+    ASSERT_TRUE(receiver.values.empty());
+    ASSERT_EQ(1U, testling.num_slots());
+}
+
+TEST(SignalTest, testDisconnectDuringEmission_Self) {
+    Signal<void (int)> testling;
+    int calls = 0;
+    SignalConnection connection;
+    connection = testling.connect([&](int) { ++calls; connection.disconnect(); });
+
+    testling(1);
+    testling(2);
+
+    ASSERT_EQ(1, calls);
+    ASSERT_TRUE(testling.empty());
+}
+
+TEST(SignalTest, testConnectDuringEmission_CalledOnNextEmission) {
+    Signal<void (int)> testling;
+    Receiver receiver;
+    bool connected = false;
+    testling.connect([&](int) {
+        if (!connected) {
+            connected = true;
+            testling.connect(boost::bind(&Receiver::handleValue, &receiver, _1));
+        }
+    });
+
+    testling(1);
+    testling(2);
+
+    ASSERT_EQ(std::vector<int>({2}), receiver.values);
+}
+
+TEST(SignalTest, testEmitDuringEmission) {
+    Signal<void (int)> testling;
+    Receiver receiver;
+    testling.connect([&](int value) {
+        if (value > 0) {
+            testling(value - 1);
+        }
+    });
+    testling.connect(boost::bind(&Receiver::handleValue, &receiver, _1));
+
+    testling(2);
+
+    ASSERT_EQ(std::vector<int>({0, 1, 2}), receiver.values);
+}
+
+TEST(SignalTest, testDestroyDuringEmission) {
+    std::unique_ptr<Signal<void (int)> > testling(new Signal<void (int)>());
+    Receiver receiver;
+    testling->connect([&](int) { testling.reset(); });
+    SignalConnection connection = testling->connect(boost::bind(&Receiver::handleValue, &receiver, _1));
+
+    (*testling)(1);
+
+    ASSERT_FALSE(testling);
+    ASSERT_FALSE(connection.connected());
+    ASSERT_TRUE(receiver.values.empty());
+}
+
+TEST(SignalTest, testConnectionOutlivesSignal) {
+    SignalConnection connection;
+    {
+        Signal<void (int)> testling;
+        connection = testling.connect([](int) {});
+    }
+
+    ASSERT_FALSE(connection.connected());
+    connection.disconnect();
+}
+
+TEST(SignalTest, testScopedConnection_DisconnectsOnDestruction) {
+    Signal<void (int)> testling;
+    Receiver receiver;
+    {
+        ScopedSignalConnection connection(testling.connect(boost::bind(&Receiver::handleValue, &receiver, _1)));
+        testling(1);
+    }
+    testling(2);
+
+    ASSERT_EQ(std::vector<int>({1}), receiver.values);
+    ASSERT_TRUE(testling.empty());
+}
+
+TEST(SignalTest, testScopedConnection_AssignDisconnectsPrevious) {
+    Signal<void (int)> testling;
+    Receiver receiver1;
+    Receiver receiver2;
+    ScopedSignalConnection connection;
+    connection = testling.connect(boost::bind(&Receiver::handleValue, &receiver1, _1));
+    connection = testling.connect(boost::bind(&Receiver::handleValue, &receiver2, _1));
+
+    testling(1);
+
+    ASSERT_TRUE(receiver1.values.empty());
+    ASSERT_EQ(std::vector<int>({1}), receiver2.values);
+}
+
+TEST(SignalTest, testScopedConnection_Release) {
+    Signal<void (int)> testling;
+    Receiver receiver;
+    SignalConnection released;
+    {
+        ScopedSignalConnection connection(testling.connect(boost::bind(&Receiver::handleValue, &receiver, _1)));
+        released = connection.release();
+    }
+    testling(1);
+
+    ASSERT_TRUE(released.connected());
+    ASSERT_EQ(std::vector<int>({1}), receiver.values);
+}
+
+TEST(SignalTest, testForwardToSignal) {
+    Signal<void (int)> source;
+    Signal<void (int)> target;
+    Receiver receiver;
+    source.connect(boost::ref(target));
+    target.connect(boost::bind(&Receiver::handleValue, &receiver, _1));
+
+    source(1);
+
+    ASSERT_EQ(std::vector<int>({1}), receiver.values);
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -56,7 +56,12 @@ namespace Swift {
         bool allowPLAINWithoutTLS = false;
 
         /**
-         * Use XEP-196 stream resumption when available.
+         * Use XEP-198 stream resumption when available.
+         *
+         * When the connection drops, the next connect() resumes the
+         * previous session instead of starting a new one, if the server
+         * still has it. Stanzas the server didn't acknowledge are sent
+         * again. An explicit disconnect() ends the session for good.
          *
          * Default: false
          */
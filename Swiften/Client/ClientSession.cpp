@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -21,6 +21,7 @@
 #include <Swiften/Elements/AuthRequest.h>
 #include <Swiften/Elements/AuthResponse.h>
 #include <Swiften/Elements/AuthSuccess.h>
+#include <Swiften/Elements/ClientStateIndication.h>
 #include <Swiften/Elements/CompressFailure.h>
 #include <Swiften/Elements/CompressRequest.h>
 #include <Swiften/Elements/Compressed.h>
@@ -37,6 +38,8 @@
 #include <Swiften/Elements/StreamFeatures.h>
 #include <Swiften/Elements/StreamManagementEnabled.h>
 #include <Swiften/Elements/StreamManagementFailed.h>
+#include <Swiften/Elements/StreamResume.h>
+#include <Swiften/Elements/StreamResumed.h>
 #include <Swiften/Elements/TLSProceed.h>
 #include <Swiften/Network/Timer.h>
 #include <Swiften/Network/TimerFactory.h>
@@ -121,6 +124,11 @@ void ClientSession::sendStanza(std::shared_ptr<Stanza> stanza) {
     }
 }
 
+void ClientSession::sendClientState(ClientState::ClientStateType state) {
+    // Not a stanza, so not counted for stream management
+    stream->writeElement(std::make_shared<ClientStateIndication>(state));
+}
+
 void ClientSession::handleStreamStart(const ProtocolHeader&) {
     CHECK_STATE_OR_RETURN(State::WaitingForStreamStart);
     state = State::Negotiating;
@@ -306,6 +314,7 @@ void ClientSession::handleElement(std::shared_ptr<ToplevelElement> element) {
         else {
             // Start the session
             rosterVersioningSupported = streamFeatures->hasRosterVersioning();
+            clientStateIndicationSupported = streamFeatures->hasClientStateIndication();
             stream->setWhitespacePingEnabled(true);
             needSessionStart = streamFeatures->hasSession();
             needResourceBind = streamFeatures->hasResourceBind();
@@ -314,7 +323,15 @@ void ClientSession::handleElement(std::shared_ptr<ToplevelElement> element) {
                 // Resource binding is a MUST
                 finishSession(Error::ResourceBindError);
             }
+            else if (needAcking && useStreamResumption && resumptionState_) {
+                state = State::ResumingStream;
+                std::shared_ptr<StreamResume> resume = std::make_shared<StreamResume>();
+                resume->setResumeID(resumptionState_->id);
+                resume->setHandledStanzasCount(resumptionState_->receivedStanzasCount);
+                stream->writeElement(resume);
+            }
             else {
+                abandonResumption();
                 continueSessionInitialization();
             }
         }
@@ -329,17 +346,43 @@ void ClientSession::handleElement(std::shared_ptr<ToplevelElement> element) {
     else if (std::dynamic_pointer_cast<CompressFailure>(element)) {
         finishSession(Error::CompressionFailedError);
     }
-    else if (std::dynamic_pointer_cast<StreamManagementEnabled>(element)) {
-        stanzaAckRequester_ = std::make_shared<StanzaAckRequester>();
-        stanzaAckRequester_->onRequestAck.connect(boost::bind(&ClientSession::requestAck, shared_from_this()));
-        stanzaAckRequester_->onStanzaAcked.connect(boost::bind(&ClientSession::handleStanzaAcked, shared_from_this(), _1));
-        stanzaAckResponder_ = std::make_shared<StanzaAckResponder>();
-        stanzaAckResponder_->onAck.connect(boost::bind(&ClientSession::ack, shared_from_this(), _1));
+    else if (std::shared_ptr<StreamManagementEnabled> enabled = std::dynamic_pointer_cast<StreamManagementEnabled>(element)) {
+        createStanzaAckHandlers(0, 0, std::deque<std::shared_ptr<Stanza> >());
+        if (useStreamResumption && enabled->getResumeSupported()) {
+            resumeID = enabled->getResumeID();
+        }
         needAcking = false;
         continueSessionInitialization();
     }
-    else if (std::dynamic_pointer_cast<StreamManagementFailed>(element)) {
+    else if (std::shared_ptr<StreamResumed> resumed = std::dynamic_pointer_cast<StreamResumed>(element)) {
+        CHECK_STATE_OR_RETURN(State::ResumingStream);
+        std::shared_ptr<ResumptionState> resumptionState = resumptionState_;
+        resumptionState_.reset();
+        localJID = resumptionState->localJID;
+        resumeID = resumptionState->id;
+        createStanzaAckHandlers(resumptionState->receivedStanzasCount, resumptionState->ackedStanzasCount, resumptionState->unackedStanzas);
+        if (resumed->getHandledStanzasCount()) {
+            stanzaAckRequester_->handleAckReceived(*resumed->getHandledStanzasCount());
+        }
         needAcking = false;
+        needResourceBind = false;
+        needSessionStart = false;
+        streamResumed = true;
+        state = State::Initialized;
+        // Whatever the server didn't get before the connection dropped is sent again
+        for (auto&& stanza : stanzaAckRequester_->takeUnackedStanzas()) {
+            sendStanza(stanza);
+        }
+        onInitialized();
+    }
+    else if (std::dynamic_pointer_cast<StreamManagementFailed>(element)) {
+        if (state == State::ResumingStream) {
+            SWIFT_LOG(debug) << "Stream resumption failed" << std::endl;
+            abandonResumption();
+        }
+        else {
+            needAcking = false;
+        }
         continueSessionInitialization();
     }
     else if (AuthChallenge* challenge = dynamic_cast<AuthChallenge*>(element.get())) {
@@ -403,7 +446,7 @@ void ClientSession::continueSessionInitialization() {
     }
     else if (needAcking) {
         state = State::EnablingSessionManagement;
-        stream->writeElement(std::make_shared<EnableStreamManagement>());
+        stream->writeElement(std::make_shared<EnableStreamManagement>(useStreamResumption));
     }
     else if (needSessionStart) {
         state = State::StartingSession;
@@ -411,10 +454,25 @@ void ClientSession::continueSessionInitialization() {
     }
     else {
         state = State::Initialized;
+        // The stanzas that the previous session didn't get acked are sent
+        // again, as the server may never have received them.
+        std::deque<std::shared_ptr<Stanza> > stanzas;
+        stanzas.swap(stanzasToResend);
+        for (auto&& stanza : stanzas) {
+            sendStanza(stanza);
+        }
         onInitialized();
     }
 }
 
+void ClientSession::abandonResumption() {
+    if (resumptionState_) {
+        SWIFT_LOG(debug) << "Not resuming; resending " << resumptionState_->unackedStanzas.size() << " unacked stanzas in the new session" << std::endl;
+        stanzasToResend = resumptionState_->unackedStanzas;
+        resumptionState_.reset();
+    }
+}
+
 bool ClientSession::checkState(State state) {
     if (this->state != state) {
         finishSession(Error::UnexpectedElementError);
@@ -498,6 +556,16 @@ void ClientSession::handleStreamClosed(std::shared_ptr<Swift::Error> streamError
         streamShutdownTimeout.reset();
     }
 
+    if (previousState == State::Initialized && !resumeID.empty() && stanzaAckRequester_ && stanzaAckResponder_) {
+        // The connection dropped without the stream being closed, so the server keeps the session around for us
+        resumptionState_ = std::make_shared<ResumptionState>();
+        resumptionState_->id = resumeID;
+        resumptionState_->localJID = localJID;
+        resumptionState_->receivedStanzasCount = stanzaAckResponder_->getHandledStanzasCount();
+        resumptionState_->ackedStanzasCount = stanzaAckRequester_->getHandledStanzasCount();
+        resumptionState_->unackedStanzas = stanzaAckRequester_->getUnackedStanzas();
+    }
+
     if (stanzaAckRequester_) {
         stanzaAckRequester_->onRequestAck.disconnect(boost::bind(&ClientSession::requestAck, shared_from_this()));
         stanzaAckRequester_->onStanzaAcked.disconnect(boost::bind(&ClientSession::handleStanzaAcked, shared_from_this(), _1));
@@ -569,6 +637,14 @@ void ClientSession::finishSession(std::shared_ptr<Swift::Error> error) {
     }
 }
 
+void ClientSession::createStanzaAckHandlers(unsigned int receivedStanzasCount, unsigned int ackedStanzasCount, const std::deque<std::shared_ptr<Stanza> >& unackedStanzas) {
+    stanzaAckRequester_ = std::make_shared<StanzaAckRequester>(ackedStanzasCount, unackedStanzas);
+    stanzaAckRequester_->onRequestAck.connect(boost::bind(&ClientSession::requestAck, shared_from_this()));
+    stanzaAckRequester_->onStanzaAcked.connect(boost::bind(&ClientSession::handleStanzaAcked, shared_from_this(), _1));
+    stanzaAckResponder_ = std::make_shared<StanzaAckResponder>(receivedStanzasCount);
+    stanzaAckResponder_->onAck.connect(boost::bind(&ClientSession::ack, shared_from_this(), _1));
+}
+
 void ClientSession::requestAck() {
     stream->writeElement(std::make_shared<StanzaAckRequest>());
 }
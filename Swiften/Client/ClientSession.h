@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <string>
 
@@ -13,6 +14,9 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/Error.h>
+#include <Swiften/Base/Signal.h>
+#include <Swiften/Client/ClientSessionResumptionState.h>
+#include <Swiften/Elements/ClientState.h>
 #include <Swiften/Elements/ToplevelElement.h>
 #include <Swiften/JID/JID.h>
 #include <Swiften/Session/SessionStream.h>
@@ -40,6 +44,7 @@ namespace Swift {
                 WaitingForCredentials,
                 Authenticating,
                 EnablingSessionManagement,
+                ResumingStream,
                 BindingResource,
                 StartingSession,
                 Initialized,
@@ -65,6 +70,8 @@ namespace Swift {
                 Error(Type type) : type(type) {}
             };
 
+            typedef ClientSessionResumptionState ResumptionState;
+
             enum UseTLS {
                 NeverUseTLS,
                 UseTLSWhenAvailable,
@@ -97,6 +104,35 @@ namespace Swift {
                 useAcks = b;
             }
 
+            void setUseStreamResumption(bool b) {
+                useStreamResumption = b;
+            }
+
+            /**
+             * Sets the state of a previous session, which will be resumed
+             * instead of binding a new resource if the server allows it.
+             * If it doesn't, the stanzas that the previous session didn't
+             * get acked are sent again once the new session is initialized.
+             */
+            void setResumptionState(std::shared_ptr<ResumptionState> state) {
+                resumptionState_ = state;
+            }
+
+            /**
+             * Returns the state with which this session can be resumed after
+             * the connection was lost, or a null pointer if it can't be resumed.
+             */
+            std::shared_ptr<ResumptionState> getResumptionState() const {
+                return resumptionState_;
+            }
+
+            /**
+             * Checks whether this session continues a previous session.
+             */
+            bool getStreamResumed() const {
+                return streamResumed;
+            }
+
             bool getStreamManagementEnabled() const {
                 // Explicitly convert to bool. In C++11, it would be cleaner to
                 // compare to nullptr.
@@ -107,6 +143,10 @@ namespace Swift {
                 return rosterVersioningSupported;
             }
 
+            bool getClientStateIndicationSupported() const {
+                return clientStateIndicationSupported;
+            }
+
             std::vector<Certificate::ref> getPeerCertificateChain() const {
                 return stream->getPeerCertificateChain();
             }
@@ -125,6 +165,12 @@ namespace Swift {
             void sendCredentials(const SafeByteArray& password);
             void sendStanza(std::shared_ptr<Stanza>);
 
+            /**
+             * Tells the server whether the user is actively using the
+             * client (XEP-0352).
+             */
+            void sendClientState(ClientState::ClientStateType state);
+
             void setCertificateTrustChecker(CertificateTrustChecker* checker) {
                 certificateTrustChecker = checker;
             }
@@ -149,8 +195,8 @@ namespace Swift {
             boost::signals2::signal<void ()> onNeedCredentials;
             boost::signals2::signal<void ()> onInitialized;
             boost::signals2::signal<void (std::shared_ptr<Swift::Error>)> onFinished;
-            boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaReceived;
-            boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
+            Signal<void (std::shared_ptr<Stanza>)> onStanzaReceived;
+            Signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
 
         private:
             ClientSession(
@@ -179,7 +225,9 @@ namespace Swift {
 
             bool checkState(State);
             void continueSessionInitialization();
+            void abandonResumption();
 
+            void createStanzaAckHandlers(unsigned int receivedStanzasCount, unsigned int ackedStanzasCount, const std::deque<std::shared_ptr<Stanza> >& unackedStanzas);
             void requestAck();
             void handleStanzaAcked(std::shared_ptr<Stanza> stanza);
             void ack(unsigned int handledStanzasCount);
@@ -200,10 +248,16 @@ namespace Swift {
             bool useStreamCompression;
             UseTLS useTLS;
             bool useAcks;
+            bool useStreamResumption = false;
+            bool streamResumed = false;
+            std::string resumeID;
+            std::shared_ptr<ResumptionState> resumptionState_;
+            std::deque<std::shared_ptr<Stanza> > stanzasToResend;
             bool needSessionStart;
             bool needResourceBind;
             bool needAcking;
             bool rosterVersioningSupported;
+            bool clientStateIndicationSupported = false;
             ClientAuthenticator* authenticator;
             std::shared_ptr<StanzaAckRequester> stanzaAckRequester_;
             std::shared_ptr<StanzaAckResponder> stanzaAckResponder_;
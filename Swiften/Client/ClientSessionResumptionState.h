@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/JID/JID.h>
+
+namespace Swift {
+    class Stanza;
+
+    /**
+     * The state needed to resume a stream that was dropped (XEP-0198).
+     *
+     * \see ClientSession::getResumptionState()
+     */
+    struct SWIFTEN_API ClientSessionResumptionState {
+        std::string id;
+        JID localJID;
+        unsigned int receivedStanzasCount = 0;
+        unsigned int ackedStanzasCount = 0;
+        std::deque<std::shared_ptr<Stanza> > unackedStanzas;
+    };
+}
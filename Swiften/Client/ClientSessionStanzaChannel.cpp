@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,9 +9,29 @@
 #include <boost/bind.hpp>
 
 #include <Swiften/Base/Log.h>
+#include <Swiften/Elements/MUCUserPayload.h>
+#include <Swiften/Elements/PubSubEvent.h>
 
 namespace Swift {
 
+// Beyond this, deferred stanzas are emitted anyway, to bound memory use during long inactivity
+static const size_t MAX_DEFERRED_STANZAS = 500;
+
+static bool isUrgent(std::shared_ptr<Stanza> stanza) {
+    if (std::shared_ptr<Presence> presence = std::dynamic_pointer_cast<Presence>(stanza)) {
+        if (presence->getType() != Presence::Available && presence->getType() != Presence::Unavailable) {
+            return true;
+        }
+        // Room occupant presence is part of joining a room, and has to come
+        // in before our own room presence that completes the join.
+        return !!presence->getPayload<MUCUserPayload>();
+    }
+    if (std::shared_ptr<Message> message = std::dynamic_pointer_cast<Message>(stanza)) {
+        return !message->getPayload<PubSubEvent>() || message->getBody();
+    }
+    return true;
+}
+
 ClientSessionStanzaChannel::~ClientSessionStanzaChannel() {
     if (session) {
         session->onFinished.disconnect(boost::bind(&ClientSessionStanzaChannel::handleSessionFinished, this, _1));
@@ -62,10 +82,93 @@ void ClientSessionStanzaChannel::handleSessionFinished(std::shared_ptr<Error>) {
     session->onInitialized.disconnect(boost::bind(&ClientSessionStanzaChannel::handleSessionInitialized, this));
     session.reset();
 
+    emitDeferredStanzas();
     onAvailableChanged(false);
 }
 
 void ClientSessionStanzaChannel::handleStanza(std::shared_ptr<Stanza> stanza) {
+    if (deferNonUrgentStanzas && !isUrgent(stanza)) {
+        deferStanza(stanza);
+    }
+    else {
+        // Keep the order of the stanzas from a single contact or room
+        emitDeferredStanzasFrom(stanza->getFrom());
+        dispatchStanza(stanza);
+    }
+}
+
+void ClientSessionStanzaChannel::deferStanza(std::shared_ptr<Stanza> stanza) {
+    if (std::dynamic_pointer_cast<Presence>(stanza)) {
+        auto i = deferredPresenceIndexes.insert(std::make_pair(stanza->getFrom().toString(), deferredStanzas.size()));
+        if (!i.second) {
+            // Newer presence replaces the one we are holding back
+            deferredStanzas[i.first->second] = stanza;
+            return;
+        }
+    }
+    deferredStanzas.push_back(stanza);
+    deferredSenders.insert(stanza->getFrom().toBare().toString());
+    if (deferredStanzas.size() >= MAX_DEFERRED_STANZAS) {
+        emitDeferredStanzas();
+    }
+}
+
+void ClientSessionStanzaChannel::emitDeferredStanzas() {
+    std::vector<std::shared_ptr<Stanza> > stanzas;
+    stanzas.swap(deferredStanzas);
+    deferredPresenceIndexes.clear();
+    deferredSenders.clear();
+    for (auto&& stanza : stanzas) {
+        dispatchStanza(stanza);
+    }
+}
+
+void ClientSessionStanzaChannel::emitDeferredStanzasFrom(const JID& sender) {
+    JID bareSender = sender.toBare();
+    if (deferredSenders.erase(bareSender.toString()) == 0) {
+        return;
+    }
+    std::vector<std::shared_ptr<Stanza> > stanzas;
+    std::vector<std::shared_ptr<Stanza> > remainingStanzas;
+    for (auto&& stanza : deferredStanzas) {
+        if (stanza->getFrom().toBare() == bareSender) {
+            stanzas.push_back(stanza);
+        }
+        else {
+            remainingStanzas.push_back(stanza);
+        }
+    }
+    deferredStanzas.swap(remainingStanzas);
+    deferredPresenceIndexes.clear();
+    for (size_t i = 0; i < deferredStanzas.size(); ++i) {
+        if (std::dynamic_pointer_cast<Presence>(deferredStanzas[i])) {
+            deferredPresenceIndexes[deferredStanzas[i]->getFrom().toString()] = i;
+        }
+    }
+    for (auto&& stanza : stanzas) {
+        dispatchStanza(stanza);
+    }
+}
+
+void ClientSessionStanzaChannel::setDeferNonUrgentStanzas(bool defer) {
+    deferNonUrgentStanzas = defer;
+    if (!defer) {
+        emitDeferredStanzas();
+    }
+}
+
+bool ClientSessionStanzaChannel::isClientStateIndicationSupported() const {
+    return session && session->getClientStateIndicationSupported();
+}
+
+void ClientSessionStanzaChannel::sendClientState(ClientState::ClientStateType state) {
+    if (!isAvailable()) {
+        return;
+    }
+    session->sendClientState(state);
+}
+
+void ClientSessionStanzaChannel::dispatchStanza(std::shared_ptr<Stanza> stanza) {
     std::shared_ptr<Message> message = std::dynamic_pointer_cast<Message>(stanza);
     if (message) {
         onMessageReceived(message);
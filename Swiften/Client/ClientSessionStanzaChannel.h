@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,10 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/IDGenerator.h>
@@ -36,17 +40,42 @@ namespace Swift {
                 return session && session->getState() == ClientSession::State::Initialized;
             }
 
+            virtual bool isStreamResumed() const {
+                return session && session->getStreamResumed();
+            }
+
+            bool isClientStateIndicationSupported() const;
+            void sendClientState(ClientState::ClientStateType state);
+
+            /**
+             * While set, incoming contact presence and PEP notifications are
+             * held back, and emitted together once it is unset again. Only the
+             * latest presence of every sender is kept. Messages, IQs,
+             * subscription requests and room presence are never held back.
+             * Before any of these is emitted, the stanzas held back from the
+             * same contact or room are emitted first.
+             */
+            void setDeferNonUrgentStanzas(bool defer);
+
         private:
             std::string getNewIQID();
             void send(std::shared_ptr<Stanza> stanza);
             void handleSessionFinished(std::shared_ptr<Error> error);
             void handleStanza(std::shared_ptr<Stanza> stanza);
+            void dispatchStanza(std::shared_ptr<Stanza> stanza);
+            void deferStanza(std::shared_ptr<Stanza> stanza);
+            void emitDeferredStanzas();
+            void emitDeferredStanzasFrom(const JID& sender);
             void handleStanzaAcked(std::shared_ptr<Stanza> stanza);
             void handleSessionInitialized();
 
         private:
             IDGenerator idGenerator;
             std::shared_ptr<ClientSession> session;
+            bool deferNonUrgentStanzas = false;
+            std::vector<std::shared_ptr<Stanza> > deferredStanzas;
+            std::unordered_map<std::string, size_t> deferredPresenceIndexes;
+            std::unordered_set<std::string> deferredSenders;
     };
 
 }
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Client/ClientStateManager.h>
+
+#include <boost/bind.hpp>
+
+#include <Swiften/Client/ClientSessionStanzaChannel.h>
+
+namespace Swift {
+
+ClientStateManager::ClientStateManager(ClientSessionStanzaChannel* stanzaChannel) : stanzaChannel(stanzaChannel), state(ClientState::ClientStateType::Active) {
+    stanzaChannel->onAvailableChanged.connect(boost::bind(&ClientStateManager::handleAvailableChanged, this, _1));
+}
+
+ClientStateManager::~ClientStateManager() {
+    stanzaChannel->onAvailableChanged.disconnect(boost::bind(&ClientStateManager::handleAvailableChanged, this, _1));
+}
+
+void ClientStateManager::setClientState(ClientState::ClientStateType newState) {
+    if (newState == state) {
+        return;
+    }
+    state = newState;
+    stanzaChannel->setDeferNonUrgentStanzas(state == ClientState::ClientStateType::Inactive);
+    if (stanzaChannel->isClientStateIndicationSupported()) {
+        stanzaChannel->sendClientState(state);
+    }
+}
+
+bool ClientStateManager::isClientStateIndicationSupported() const {
+    return stanzaChannel->isClientStateIndicationSupported();
+}
+
+void ClientStateManager::handleAvailableChanged(bool available) {
+    // Every new session starts out active
+    if (available && state == ClientState::ClientStateType::Inactive && stanzaChannel->isClientStateIndicationSupported()) {
+        stanzaChannel->sendClientState(state);
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Elements/ClientState.h>
+
+namespace Swift {
+    class ClientSessionStanzaChannel;
+
+    /**
+     * Keeps track of whether the user is actively using the client, and
+     * acts on it (XEP-0352).
+     *
+     * While inactive, the server is told so (if it supports client state
+     * indication), so it can hold back traffic. Locally, presence and PEP
+     * notifications are held back as well, and delivered in one batch when
+     * the client becomes active again.
+     */
+    class SWIFTEN_API ClientStateManager {
+        public:
+            ClientStateManager(ClientSessionStanzaChannel* stanzaChannel);
+            ~ClientStateManager();
+
+            void setClientState(ClientState::ClientStateType state);
+
+            ClientState::ClientStateType getClientState() const {
+                return state;
+            }
+
+            /**
+             * Checks whether the server of the current session supports
+             * client state indication.
+             */
+            bool isClientStateIndicationSupported() const;
+
+        private:
+            void handleAvailableChanged(bool available);
+
+        private:
+            ClientSessionStanzaChannel* stanzaChannel;
+            ClientState::ClientStateType state;
+    };
+}
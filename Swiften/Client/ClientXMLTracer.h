@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -10,6 +10,7 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Client/CoreClient.h>
 #include <Swiften/Client/XMLBeautifier.h>
 
@@ -25,7 +26,7 @@ namespace Swift {
         private:
             std::unique_ptr<XMLBeautifier> beautifier_;
             bool bosh_;
-            boost::signals2::scoped_connection onDataReadConnection_;
-            boost::signals2::scoped_connection onDataWrittenConnection_;
+            ScopedSignalConnection onDataReadConnection_;
+            ScopedSignalConnection onDataWrittenConnection_;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,6 +16,7 @@
 #include <Swiften/Base/Log.h>
 #include <Swiften/Client/ClientSession.h>
 #include <Swiften/Client/ClientSessionStanzaChannel.h>
+#include <Swiften/Client/ClientStateManager.h>
 #include <Swiften/Network/ChainedConnector.h>
 #include <Swiften/Network/DomainNameResolveError.h>
 #include <Swiften/Network/HTTPConnectProxiedConnectionFactory.h>
@@ -33,6 +34,8 @@ namespace Swift {
 
 CoreClient::CoreClient(const JID& jid, const SafeByteArray& password, NetworkFactories* networkFactories) : jid_(jid), password_(password), networkFactories(networkFactories), disconnectRequested_(false), certificateTrustChecker(nullptr) {
     stanzaChannel_ = new ClientSessionStanzaChannel();
+    // Created first, so that the server knows the client state before onConnected is emitted
+    clientStateManager_ = new ClientStateManager(stanzaChannel_);
     stanzaChannel_->onMessageReceived.connect(boost::bind(&CoreClient::handleMessageReceived, this, _1));
     stanzaChannel_->onPresenceReceived.connect(boost::bind(&CoreClient::handlePresenceReceived, this, _1));
     stanzaChannel_->onStanzaAcked.connect(boost::bind(&CoreClient::handleStanzaAcked, this, _1));
@@ -40,11 +43,15 @@ CoreClient::CoreClient(const JID& jid, const SafeByteArray& password, NetworkFac
 
     iqRouter_ = new IQRouter(stanzaChannel_);
     iqRouter_->setJID(jid);
+    if (networkFactories->getTimerFactory()) {
+        iqRouter_->setTimerFactory(networkFactories->getTimerFactory());
+    }
 }
 
 CoreClient::~CoreClient() {
     forceReset();
     delete iqRouter_;
+    delete clientStateManager_;
 
     stanzaChannel_->onAvailableChanged.disconnect(boost::bind(&CoreClient::handleStanzaChannelAvailableChanged, this, _1));
     stanzaChannel_->onMessageReceived.disconnect(boost::bind(&CoreClient::handleMessageReceived, this, _1));
@@ -65,6 +72,7 @@ void CoreClient::connect(const ClientOptions& o) {
     // Determine connection types to use
     assert(proxyConnectionFactories.empty());
     bool useDirectConnection = true;
+    std::vector<std::string> proxyIDs;
     HostAddressPort systemSOCKS5Proxy = networkFactories->getProxyProvider()->getSOCKS5Proxy();
     HostAddressPort systemHTTPConnectProxy = networkFactories->getProxyProvider()->getHTTPConnectProxy();
     switch (o.proxyType) {
@@ -76,10 +84,12 @@ void CoreClient::connect(const ClientOptions& o) {
             if (systemSOCKS5Proxy.isValid()) {
                 SWIFT_LOG(debug) << "Found SOCK5 Proxy: " << systemSOCKS5Proxy.getAddress().toString() << ":" << systemSOCKS5Proxy.getPort() << std::endl;
                 proxyConnectionFactories.push_back(new SOCKS5ProxiedConnectionFactory(networkFactories->getDomainNameResolver(), networkFactories->getConnectionFactory(), networkFactories->getTimerFactory(), systemSOCKS5Proxy.getAddress().toString(), systemSOCKS5Proxy.getPort()));
+                proxyIDs.push_back("SOCKS5 " + systemSOCKS5Proxy.toString());
             }
             if (systemHTTPConnectProxy.isValid()) {
                 SWIFT_LOG(debug) << "Found HTTPConnect Proxy: " << systemHTTPConnectProxy.getAddress().toString() << ":" << systemHTTPConnectProxy.getPort() << std::endl;
                 proxyConnectionFactories.push_back(new HTTPConnectProxiedConnectionFactory(networkFactories->getDomainNameResolver(), networkFactories->getConnectionFactory(), networkFactories->getTimerFactory(), systemHTTPConnectProxy.getAddress().toString(), systemHTTPConnectProxy.getPort()));
+                proxyIDs.push_back("HTTPConnect " + systemHTTPConnectProxy.toString());
             }
             break;
         case ClientOptions::SOCKS5Proxy: {
@@ -88,6 +98,7 @@ void CoreClient::connect(const ClientOptions& o) {
             int proxyPort = o.manualProxyPort == -1 ? systemSOCKS5Proxy.getPort() : o.manualProxyPort;
             SWIFT_LOG(debug) << "Proxy: " << proxyHostname << ":" << proxyPort << std::endl;
             proxyConnectionFactories.push_back(new SOCKS5ProxiedConnectionFactory(networkFactories->getDomainNameResolver(), networkFactories->getConnectionFactory(), networkFactories->getTimerFactory(), proxyHostname, proxyPort));
+            proxyIDs.push_back("SOCKS5 " + proxyHostname + ":" + std::to_string(proxyPort));
             useDirectConnection = false;
             break;
         }
@@ -97,13 +108,19 @@ void CoreClient::connect(const ClientOptions& o) {
             int proxyPort = o.manualProxyPort == -1 ? systemHTTPConnectProxy.getPort() : o.manualProxyPort;
             SWIFT_LOG(debug) << "Proxy: " << proxyHostname << ":" << proxyPort << std::endl;
             proxyConnectionFactories.push_back(new HTTPConnectProxiedConnectionFactory(networkFactories->getDomainNameResolver(), networkFactories->getConnectionFactory(), networkFactories->getTimerFactory(), proxyHostname, proxyPort, o.httpTrafficFilter));
+            proxyIDs.push_back("HTTPConnect " + proxyHostname + ":" + std::to_string(proxyPort));
             useDirectConnection = false;
             break;
         }
     }
     std::vector<ConnectionFactory*> connectionFactories(proxyConnectionFactories);
+    connectionFactoryIDs_.clear();
+    for (size_t i = 0; i < proxyConnectionFactories.size(); ++i) {
+        connectionFactoryIDs_.push_back(std::make_pair(proxyConnectionFactories[i], proxyIDs[i]));
+    }
     if (useDirectConnection) {
         connectionFactories.push_back(networkFactories->getConnectionFactory());
+        connectionFactoryIDs_.push_back(std::make_pair(networkFactories->getConnectionFactory(), std::string()));
     }
 
     // Create connector
@@ -118,6 +135,18 @@ void CoreClient::connect(const ClientOptions& o) {
         connector_ = std::make_shared<ChainedConnector>(host, port, serviceLookupPrefix, networkFactories->getDomainNameResolver(), connectionFactories, networkFactories->getTimerFactory());
         connector_->onConnectFinished.connect(boost::bind(&CoreClient::handleConnectorFinished, this, _1, _2));
         connector_->setTimeoutMilliseconds(2*60*1000);
+        if (useDirectConnection && !proxyConnectionFactories.empty()) {
+            // Only fall back to a direct connection when the proxies fail, instead of
+            // racing it against them, which would bypass the proxies
+            connector_->setAttemptDelayMilliseconds(0);
+        }
+        if (lastConnectedEndpoint_) {
+            for (const auto& connectionFactoryID : connectionFactoryIDs_) {
+                if (connectionFactoryID.second == lastConnectedEndpoint_->connectionFactoryID) {
+                    connector_->setPreferredEndpoint(ChainedConnector::Endpoint(lastConnectedEndpoint_->hostname, connectionFactoryID.first, lastConnectedEndpoint_->address));
+                }
+            }
+        }
         connector_->start();
     }
     else {
@@ -173,6 +202,10 @@ void CoreClient::bindSessionToStream() {
             break;
     }
     session_->setUseAcks(options.useAcks);
+    session_->setUseStreamResumption(options.useStreamResumption);
+    if (options.useStreamResumption) {
+        session_->setResumptionState(resumptionState_);
+    }
     stanzaChannel_->setSession(session_);
     session_->onFinished.connect(boost::bind(&CoreClient::handleSessionFinished, this, _1));
     session_->onNeedCredentials.connect(boost::bind(&CoreClient::handleNeedCredentials, this));
@@ -183,6 +216,16 @@ void CoreClient::bindSessionToStream() {
  * Only called for TCP sessions. BOSH is handled inside the BOSHSessionStream.
  */
 void CoreClient::handleConnectorFinished(std::shared_ptr<Connection> connection, std::shared_ptr<Error> error) {
+    if (connection) {
+        // Try the same way of connecting first next time
+        if (boost::optional<ChainedConnector::Endpoint> endpoint = connector_->getConnectedEndpoint()) {
+            for (const auto& connectionFactoryID : connectionFactoryIDs_) {
+                if (connectionFactoryID.first == endpoint->connectionFactory) {
+                    lastConnectedEndpoint_ = ConnectedEndpoint(connectionFactoryID.second, endpoint->hostname, endpoint->address);
+                }
+            }
+        }
+    }
     resetConnector();
     if (!connection) {
         if (options.forgetPassword) {
@@ -221,6 +264,7 @@ void CoreClient::disconnect() {
     // FIXME: We should be able to do without this boolean. We just have to make sure we can tell the difference between
     // connector finishing without a connection due to an error or because of a disconnect.
     disconnectRequested_ = true;
+    resumptionState_.reset();
     if (session_ && !session_->isFinished()) {
         session_->finish();
     }
@@ -237,6 +281,7 @@ void CoreClient::handleSessionFinished(std::shared_ptr<Error> error) {
     if (options.forgetPassword) {
         purgePassword();
     }
+    resumptionState_ = disconnectRequested_ ? std::shared_ptr<ClientSession::ResumptionState>() : session_->getResumptionState();
     resetSession();
 
     boost::optional<ClientError> actualError;
@@ -426,6 +471,10 @@ bool CoreClient::getStreamManagementEnabled() const {
     return stanzaChannel_->getStreamManagementEnabled();
 }
 
+bool CoreClient::isStreamResumed() const {
+    return session_ && session_->getStreamResumed();
+}
+
 bool CoreClient::isStreamEncrypted() const {
     return sessionStream_->isTLSEncrypted();
 }
@@ -454,6 +503,7 @@ void CoreClient::resetConnector() {
         delete f;
     }
     proxyConnectionFactories.clear();
+    connectionFactoryIDs_.clear();
 }
 
 void CoreClient::resetSession() {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,22 +8,29 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <boost/optional.hpp>
 #include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Client/ClientError.h>
 #include <Swiften/Client/ClientOptions.h>
 #include <Swiften/Entity/Entity.h>
 #include <Swiften/JID/JID.h>
+#include <Swiften/Network/HostAddressPort.h>
 #include <Swiften/TLS/CertificateWithKey.h>
 
 namespace Swift {
     class CertificateTrustChecker;
     class ChainedConnector;
     class ClientSession;
+    struct ClientSessionResumptionState;
     class ClientSessionStanzaChannel;
+    class ClientStateManager;
     class Connection;
     class ConnectionFactory;
     class Error;
@@ -88,6 +95,14 @@ namespace Swift {
              */
             void sendData(const std::string& data);
 
+            /**
+             * Returns the manager of the client state (active or inactive)
+             * for this client.
+             */
+            ClientStateManager* getClientStateManager() const {
+                return clientStateManager_;
+            }
+
             /**
              * Returns the IQ router for this client.
              */
@@ -124,6 +139,16 @@ namespace Swift {
              */
             bool getStreamManagementEnabled() const;
 
+            /**
+             * Checks whether the current session resumed the session that
+             * was previously dropped (see ClientOptions::useStreamResumption).
+             *
+             * If it did, the server kept the roster and presence state of
+             * the previous session, and they don't need to be requested
+             * again.
+             */
+            bool isStreamResumed() const;
+
             /**
              * Checks whether stream encryption (TLS) is currently active.
              */
@@ -162,7 +187,7 @@ namespace Swift {
              * This signal is emitted before the XML data is parsed,
              * so this data is unformatted.
              */
-            boost::signals2::signal<void (const SafeByteArray&)> onDataRead;
+            Signal<void (const SafeByteArray&)> onDataRead;
 
             /**
              * Emitted when the client sends data.
@@ -170,17 +195,17 @@ namespace Swift {
              * This signal is emitted after the XML was serialized, and
              * is unformatted.
              */
-            boost::signals2::signal<void (const SafeByteArray&)> onDataWritten;
+            Signal<void (const SafeByteArray&)> onDataWritten;
 
             /**
              * Emitted when a message is received.
              */
-            boost::signals2::signal<void (std::shared_ptr<Message>)> onMessageReceived;
+            Signal<void (std::shared_ptr<Message>)> onMessageReceived;
 
             /**
              * Emitted when a presence stanza is received.
              */
-            boost::signals2::signal<void (std::shared_ptr<Presence>) > onPresenceReceived;
+            Signal<void (std::shared_ptr<Presence>) > onPresenceReceived;
 
             /**
              * Emitted when the server acknowledges receipt of a
@@ -188,7 +213,7 @@ namespace Swift {
              *
              * \see getStreamManagementEnabled()
              */
-            boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
+            Signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
 
         protected:
             std::shared_ptr<ClientSession> getSession() const {
@@ -221,18 +246,38 @@ namespace Swift {
             void resetSession();
             void forceReset();
 
+        private:
+            /**
+             * The endpoint of a connection, with its connection factory identified by
+             * the proxy it connects through, so it can be found again after the proxy
+             * connection factories are recreated.
+             */
+            struct ConnectedEndpoint {
+                ConnectedEndpoint(const std::string& connectionFactoryID, const std::string& hostname, const HostAddressPort& address) : connectionFactoryID(connectionFactoryID), hostname(hostname), address(address) {}
+
+                std::string connectionFactoryID;
+                std::string hostname;
+                HostAddressPort address;
+            };
+
         private:
             JID jid_;
             SafeByteArray password_;
             NetworkFactories* networkFactories;
             ClientSessionStanzaChannel* stanzaChannel_;
             IQRouter* iqRouter_;
+            ClientStateManager* clientStateManager_;
             ClientOptions options;
             std::shared_ptr<ChainedConnector> connector_;
+            boost::optional<ConnectedEndpoint> lastConnectedEndpoint_;
             std::vector<ConnectionFactory*> proxyConnectionFactories;
+            // The connection factories of connector_, with the IDs of their proxies
+            // (empty for the direct connection)
+            std::vector<std::pair<ConnectionFactory*, std::string> > connectionFactoryIDs_;
             std::shared_ptr<Connection> connection_;
             std::shared_ptr<SessionStream> sessionStream_;
             std::shared_ptr<ClientSession> session_;
+            std::shared_ptr<ClientSessionResumptionState> resumptionState_;
             CertificateWithKey::ref certificate_;
             bool disconnectRequested_;
             CertificateTrustChecker* certificateTrustChecker;
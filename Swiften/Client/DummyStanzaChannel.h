@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -97,8 +97,13 @@ namespace Swift {
                 return std::vector<Certificate::ref>();
             }
 
+            virtual bool isStreamResumed() const {
+                return streamResumed_;
+            }
+
             std::vector<std::shared_ptr<Stanza> > sentStanzas;
             bool available_ = true;
+            bool streamResumed_ = false;
             bool uniqueIDs_ = false;
             unsigned int idCounter_ = 0;
     };
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,6 +11,7 @@
 #include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Elements/Message.h>
 #include <Swiften/Elements/Presence.h>
 #include <Swiften/Queries/IQChannel.h>
@@ -25,9 +26,18 @@ namespace Swift {
             virtual bool getStreamManagementEnabled() const = 0;
             virtual std::vector<Certificate::ref> getPeerCertificateChain() const = 0;
 
+            /**
+             * Checks whether the current session resumed a previous one
+             * (XEP-0198), in which case the server does not send the roster
+             * and presence again, and the state from before it is still valid.
+             */
+            virtual bool isStreamResumed() const {
+                return false;
+            }
+
             boost::signals2::signal<void (bool /* isAvailable */)> onAvailableChanged;
-            boost::signals2::signal<void (std::shared_ptr<Message>)> onMessageReceived;
-            boost::signals2::signal<void (std::shared_ptr<Presence>) > onPresenceReceived;
-            boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
+            Signal<void (std::shared_ptr<Message>)> onMessageReceived;
+            Signal<void (std::shared_ptr<Presence>) > onPresenceReceived;
+            Signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
     };
 }
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <deque>
 #include <memory>
+#include <vector>
 
 #include <boost/bind.hpp>
 #include <boost/optional.hpp>
@@ -22,17 +23,21 @@
 #include <Swiften/Elements/AuthFailure.h>
 #include <Swiften/Elements/AuthRequest.h>
 #include <Swiften/Elements/AuthSuccess.h>
+#include <Swiften/Elements/ClientStateIndication.h>
 #include <Swiften/Elements/EnableStreamManagement.h>
 #include <Swiften/Elements/IQ.h>
 #include <Swiften/Elements/Message.h>
 #include <Swiften/Elements/ResourceBind.h>
 #include <Swiften/Elements/StanzaAck.h>
+#include <Swiften/Elements/StanzaAckRequest.h>
 #include <Swiften/Elements/StartTLSFailure.h>
 #include <Swiften/Elements/StartTLSRequest.h>
 #include <Swiften/Elements/StreamError.h>
 #include <Swiften/Elements/StreamFeatures.h>
 #include <Swiften/Elements/StreamManagementEnabled.h>
 #include <Swiften/Elements/StreamManagementFailed.h>
+#include <Swiften/Elements/StreamResume.h>
+#include <Swiften/Elements/StreamResumed.h>
 #include <Swiften/Elements/TLSProceed.h>
 #include <Swiften/IDN/IDNConverter.h>
 #include <Swiften/IDN/PlatformIDNConverter.h>
@@ -60,6 +65,12 @@ class ClientSessionTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testAuthenticate_EXTERNAL);
         CPPUNIT_TEST(testStreamManagement);
         CPPUNIT_TEST(testStreamManagement_Failed);
+        CPPUNIT_TEST(testStreamResumption);
+        CPPUNIT_TEST(testStreamResumption_Failed);
+        CPPUNIT_TEST(testStreamResumption_FailedResendsUnackedStanzas);
+        CPPUNIT_TEST(testStreamResumption_NotSupported);
+        CPPUNIT_TEST(testStreamResumption_NotAfterClose);
+        CPPUNIT_TEST(testClientStateIndication);
         CPPUNIT_TEST(testUnexpectedChallenge);
         CPPUNIT_TEST(testFinishAcksStanzas);
 
@@ -376,6 +387,160 @@ class ClientSessionTest : public CppUnit::TestFixture {
             session->finish();
         }
 
+        void testStreamResumption() {
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            initializeResumableSession(session);
+            session->sendStanza(std::make_shared<Message>());
+            session->sendStanza(std::make_shared<Message>());
+            server->sendMessage();
+            server->sendStanzaAck(1);
+            server->breakConnection();
+
+            std::shared_ptr<ClientSession::ResumptionState> resumptionState = session->getResumptionState();
+            CPPUNIT_ASSERT(resumptionState);
+            CPPUNIT_ASSERT_EQUAL(std::string("session-1"), resumptionState->id);
+            CPPUNIT_ASSERT_EQUAL(1U, resumptionState->receivedStanzasCount);
+            CPPUNIT_ASSERT_EQUAL(1U, resumptionState->ackedStanzasCount);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), resumptionState->unackedStanzas.size());
+
+            server = std::make_shared<MockSessionStream>();
+            std::shared_ptr<ClientSession> resumedSession(createSession());
+            resumedSession->setUseStreamResumption(true);
+            resumedSession->setResumptionState(resumptionState);
+            authenticateSession(resumedSession);
+            server->sendStreamFeaturesWithBindAndStreamManagement();
+            server->receiveStreamResume("session-1", 1);
+            server->sendStreamResumed(1);
+
+            CPPUNIT_ASSERT_EQUAL(ClientSession::State::Initialized, resumedSession->getState());
+            CPPUNIT_ASSERT(resumedSession->getStreamResumed());
+            CPPUNIT_ASSERT(resumedSession->getStreamManagementEnabled());
+            CPPUNIT_ASSERT_EQUAL(JID("foo@bar.com/bla"), resumedSession->getLocalJID());
+            server->receiveMessage();
+            server->receiveAckRequest();
+
+            resumedSession->finish();
+            server->receiveAck(1);
+        }
+
+        void testStreamResumption_Failed() {
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            std::shared_ptr<ClientSession::ResumptionState> resumptionState = std::make_shared<ClientSession::ResumptionState>();
+            resumptionState->id = "session-1";
+            resumptionState->unackedStanzas.push_back(std::make_shared<Message>());
+            session->setResumptionState(resumptionState);
+            authenticateSession(session);
+            server->sendStreamFeaturesWithBindAndStreamManagement();
+            server->receiveStreamResume("session-1", 0);
+            server->sendStreamManagementFailed();
+            server->receiveBind();
+            server->sendBindResult();
+            server->receiveStreamManagementEnable();
+            server->sendStreamManagementEnabled();
+
+            CPPUNIT_ASSERT_EQUAL(ClientSession::State::Initialized, session->getState());
+            CPPUNIT_ASSERT(!session->getStreamResumed());
+            CPPUNIT_ASSERT(session->getStreamManagementEnabled());
+            CPPUNIT_ASSERT(!session->getResumptionState());
+            server->receiveMessage();
+            server->receiveAckRequest();
+
+            session->finish();
+        }
+
+        void testStreamResumption_FailedResendsUnackedStanzas() {
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            initializeResumableSession(session);
+            std::shared_ptr<Message> message1 = std::make_shared<Message>();
+            std::shared_ptr<Message> message2 = std::make_shared<Message>();
+            std::shared_ptr<Message> message3 = std::make_shared<Message>();
+            session->sendStanza(message1);
+            session->sendStanza(message2);
+            session->sendStanza(message3);
+            server->sendStanzaAck(1);
+            server->breakConnection();
+            std::shared_ptr<ClientSession::ResumptionState> resumptionState = session->getResumptionState();
+
+            server = std::make_shared<MockSessionStream>();
+            std::shared_ptr<ClientSession> newSession(createSession());
+            newSession->setUseStreamResumption(true);
+            newSession->setResumptionState(resumptionState);
+            std::vector<std::shared_ptr<Stanza> > ackedStanzas;
+            newSession->onStanzaAcked.connect([&](std::shared_ptr<Stanza> stanza) { ackedStanzas.push_back(stanza); });
+            authenticateSession(newSession);
+            server->sendStreamFeaturesWithBindAndStreamManagement();
+            server->receiveStreamResume("session-1", 0);
+            server->sendStreamManagementFailed();
+            server->receiveBind();
+            server->sendBindResult();
+            server->receiveStreamManagementEnable();
+            server->sendStreamManagementEnabled();
+
+            // The stanzas the old session didn't get acked are sent again,
+            // in order, and are acked by the new session
+            CPPUNIT_ASSERT_EQUAL(ClientSession::State::Initialized, newSession->getState());
+            CPPUNIT_ASSERT(server->popEvent().element == message2);
+            server->receiveAckRequest();
+            CPPUNIT_ASSERT(server->popEvent().element == message3);
+            server->receiveAckRequest();
+            CPPUNIT_ASSERT(server->receivedEvents.empty());
+            server->sendStanzaAck(2);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), ackedStanzas.size());
+            CPPUNIT_ASSERT(ackedStanzas[0] == message2);
+            CPPUNIT_ASSERT(ackedStanzas[1] == message3);
+
+            newSession->finish();
+        }
+
+        void testStreamResumption_NotSupported() {
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            std::shared_ptr<ClientSession::ResumptionState> resumptionState = std::make_shared<ClientSession::ResumptionState>();
+            resumptionState->id = "session-1";
+            resumptionState->unackedStanzas.push_back(std::make_shared<Message>());
+            session->setResumptionState(resumptionState);
+            authenticateSession(session);
+            server->sendStreamFeaturesWithBind();
+            server->receiveBind();
+            server->sendBindResult();
+
+            CPPUNIT_ASSERT_EQUAL(ClientSession::State::Initialized, session->getState());
+            CPPUNIT_ASSERT(!session->getStreamResumed());
+            CPPUNIT_ASSERT(!session->getResumptionState());
+            server->receiveMessage();
+
+            session->finish();
+        }
+
+        void testStreamResumption_NotAfterClose() {
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            initializeResumableSession(session);
+
+            session->finish();
+            server->onStreamEndReceived();
+
+            CPPUNIT_ASSERT_EQUAL(ClientSession::State::Finished, session->getState());
+            CPPUNIT_ASSERT(!session->getResumptionState());
+        }
+
+        void testClientStateIndication() {
+            std::shared_ptr<ClientSession> session(createSession());
+            authenticateSession(session);
+            server->sendStreamFeaturesWithBindAndClientStateIndication();
+            server->receiveBind();
+            server->sendBindResult();
+
+            CPPUNIT_ASSERT(session->getClientStateIndicationSupported());
+            session->sendClientState(ClientState::ClientStateType::Inactive);
+            server->receiveClientStateIndication(ClientState::ClientStateType::Inactive);
+
+            session->finish();
+        }
+
         void testFinishAcksStanzas() {
             std::shared_ptr<ClientSession> session(createSession());
             initializeSession(session);
@@ -432,6 +597,27 @@ class ClientSessionTest : public CppUnit::TestFixture {
             return session;
         }
 
+        void authenticateSession(std::shared_ptr<ClientSession> session) {
+            session->start();
+            server->receiveStreamStart();
+            server->sendStreamStart();
+            server->sendStreamFeaturesWithPLAINAuthentication();
+            session->sendCredentials(createSafeByteArray("mypass"));
+            server->receiveAuthRequest("PLAIN");
+            server->sendAuthSuccess();
+            server->receiveStreamStart();
+            server->sendStreamStart();
+        }
+
+        void initializeResumableSession(std::shared_ptr<ClientSession> session) {
+            authenticateSession(session);
+            server->sendStreamFeaturesWithBindAndStreamManagement();
+            server->receiveBind();
+            server->sendBindResult();
+            CPPUNIT_ASSERT(server->receiveStreamManagementEnable()->getResume());
+            server->sendStreamManagementEnabledWithResumption("session-1");
+        }
+
         void initializeSession(std::shared_ptr<ClientSession> session) {
             session->start();
             server->receiveStreamStart();
@@ -603,6 +789,12 @@ class ClientSessionTest : public CppUnit::TestFixture {
                     onElementReceived(streamFeatures);
                 }
 
+                void sendStreamFeaturesWithBind() {
+                    std::shared_ptr<StreamFeatures> streamFeatures(new StreamFeatures());
+                    streamFeatures->setHasResourceBind();
+                    onElementReceived(streamFeatures);
+                }
+
                 void sendStreamFeaturesWithBindAndStreamManagement() {
                     std::shared_ptr<StreamFeatures> streamFeatures(new StreamFeatures());
                     streamFeatures->setHasResourceBind();
@@ -610,6 +802,13 @@ class ClientSessionTest : public CppUnit::TestFixture {
                     onElementReceived(streamFeatures);
                 }
 
+                void sendStreamFeaturesWithBindAndClientStateIndication() {
+                    std::shared_ptr<StreamFeatures> streamFeatures(new StreamFeatures());
+                    streamFeatures->setHasResourceBind();
+                    streamFeatures->setHasClientStateIndication();
+                    onElementReceived(streamFeatures);
+                }
+
                 void sendEmptyStreamFeatures() {
                     onElementReceived(std::make_shared<StreamFeatures>());
                 }
@@ -626,6 +825,23 @@ class ClientSessionTest : public CppUnit::TestFixture {
                     onElementReceived(std::make_shared<StreamManagementEnabled>());
                 }
 
+                void sendStreamManagementEnabledWithResumption(const std::string& id) {
+                    std::shared_ptr<StreamManagementEnabled> enabled = std::make_shared<StreamManagementEnabled>();
+                    enabled->setResumeSupported();
+                    enabled->setResumeID(id);
+                    onElementReceived(enabled);
+                }
+
+                void sendStreamResumed(unsigned int handledStanzasCount) {
+                    std::shared_ptr<StreamResumed> resumed = std::make_shared<StreamResumed>();
+                    resumed->setHandledStanzasCount(handledStanzasCount);
+                    onElementReceived(resumed);
+                }
+
+                void sendStanzaAck(unsigned int handledStanzasCount) {
+                    onElementReceived(std::make_shared<StanzaAck>(handledStanzasCount));
+                }
+
                 void sendStreamManagementFailed() {
                     onElementReceived(std::make_shared<StreamManagementFailed>());
                 }
@@ -662,10 +878,38 @@ class ClientSessionTest : public CppUnit::TestFixture {
                     CPPUNIT_ASSERT_EQUAL(mech, request->getMechanism());
                 }
 
-                void receiveStreamManagementEnable() {
+                std::shared_ptr<EnableStreamManagement> receiveStreamManagementEnable() {
                     Event event = popEvent();
                     CPPUNIT_ASSERT(event.element);
-                    CPPUNIT_ASSERT(std::dynamic_pointer_cast<EnableStreamManagement>(event.element));
+                    std::shared_ptr<EnableStreamManagement> enable = std::dynamic_pointer_cast<EnableStreamManagement>(event.element);
+                    CPPUNIT_ASSERT(enable);
+                    return enable;
+                }
+
+                void receiveStreamResume(const std::string& id, unsigned int handledStanzasCount) {
+                    Event event = popEvent();
+                    CPPUNIT_ASSERT(event.element);
+                    std::shared_ptr<StreamResume> resume = std::dynamic_pointer_cast<StreamResume>(event.element);
+                    CPPUNIT_ASSERT(resume);
+                    CPPUNIT_ASSERT_EQUAL(id, resume->getResumeID());
+                    CPPUNIT_ASSERT_EQUAL(handledStanzasCount, *resume->getHandledStanzasCount());
+                }
+
+                void receiveClientStateIndication(ClientState::ClientStateType state) {
+                    Event event = popEvent();
+                    std::shared_ptr<ClientStateIndication> indication = std::dynamic_pointer_cast<ClientStateIndication>(event.element);
+                    CPPUNIT_ASSERT(indication);
+                    CPPUNIT_ASSERT(state == indication->getClientState());
+                }
+
+                void receiveAckRequest() {
+                    Event event = popEvent();
+                    CPPUNIT_ASSERT(std::dynamic_pointer_cast<StanzaAckRequest>(event.element));
+                }
+
+                void receiveMessage() {
+                    Event event = popEvent();
+                    CPPUNIT_ASSERT(std::dynamic_pointer_cast<Message>(event.element));
                 }
 
                 void receiveBind() {
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Client/ClientSession.h>
+#include <Swiften/Client/ClientSessionStanzaChannel.h>
+#include <Swiften/Client/ClientStateManager.h>
+#include <Swiften/Elements/MUCUserPayload.h>
+#include <Swiften/Elements/Message.h>
+#include <Swiften/Elements/Presence.h>
+#include <Swiften/Elements/PubSubEvent.h>
+
+using namespace Swift;
+
+class ClientStateManagerTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(ClientStateManagerTest);
+        CPPUNIT_TEST(testActive_DeliversImmediately);
+        CPPUNIT_TEST(testInactive_DefersPresence);
+        CPPUNIT_TEST(testInactive_KeepsLatestPresencePerSender);
+        CPPUNIT_TEST(testInactive_DefersPEPNotifications);
+        CPPUNIT_TEST(testInactive_DeliversUrgentStanzas);
+        CPPUNIT_TEST(testInactive_DeliversWhenTooManyDeferred);
+        CPPUNIT_TEST(testInactive_MUCJoinKeepsOrder);
+        CPPUNIT_TEST(testInactive_DeliversDeferredPresenceBeforeMessageFromSender);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp() {
+            session = ClientSession::create(JID("me@foo.com"), std::shared_ptr<SessionStream>(), nullptr, nullptr, nullptr);
+            stanzaChannel = std::make_shared<ClientSessionStanzaChannel>();
+            stanzaChannel->setSession(session);
+            stanzaChannel->onPresenceReceived.connect(boost::bind(&ClientStateManagerTest::handleStanzaReceived, this, _1));
+            stanzaChannel->onMessageReceived.connect(boost::bind(&ClientStateManagerTest::handleStanzaReceived, this, _1));
+            testling = std::make_shared<ClientStateManager>(stanzaChannel.get());
+        }
+
+        void tearDown() {
+            testling.reset();
+            stanzaChannel.reset();
+            session.reset();
+            receivedStanzas.clear();
+        }
+
+        void testActive_DeliversImmediately() {
+            session->onStanzaReceived(createPresence("alice@wonderland.lit/rabbithole"));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), receivedStanzas.size());
+        }
+
+        void testInactive_DefersPresence() {
+            testling->setClientState(ClientState::ClientStateType::Inactive);
+            session->onStanzaReceived(createPresence("alice@wonderland.lit/rabbithole"));
+            session->onStanzaReceived(createPresence("bob@wonderland.lit/garden"));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), receivedStanzas.size());
+
+            testling->setClientState(ClientState::ClientStateType::Active);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), receivedStanzas.size());
+            CPPUNIT_ASSERT_EQUAL(JID("alice@wonderland.lit/rabbithole"), receivedStanzas[0]->getFrom());
+            CPPUNIT_ASSERT_EQUAL(JID("bob@wonderland.lit/garden"), receivedStanzas[1]->getFrom());
+        }
+
+        void testInactive_KeepsLatestPresencePerSender() {
+            testling->setClientState(ClientState::ClientStateType::Inactive);
+            session->onStanzaReceived(createPresence("alice@wonderland.lit/rabbithole"));
+            Presence::ref latestPresence = createPresence("alice@wonderland.lit/rabbithole");
+            latestPresence->setType(Presence::Unavailable);
+            session->onStanzaReceived(latestPresence);
+
+            testling->setClientState(ClientState::ClientStateType::Active);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), receivedStanzas.size());
+            CPPUNIT_ASSERT(latestPresence == receivedStanzas[0]);
+        }
+
+        void testInactive_DefersPEPNotifications() {
+            testling->setClientState(ClientState::ClientStateType::Inactive);
+            Message::ref message = std::make_shared<Message>();
+            message->setFrom(JID("alice@wonderland.lit"));
+            message->addPayload(std::make_shared<PubSubEvent>());
+            session->onStanzaReceived(message);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), receivedStanzas.size());
+
+            testling->setClientState(ClientState::ClientStateType::Active);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), receivedStanzas.size());
+        }
+
+        void testInactive_DeliversUrgentStanzas() {
+            testling->setClientState(ClientState::ClientStateType::Inactive);
+
+            Message::ref message = std::make_shared<Message>();
+            message->setFrom(JID("alice@wonderland.lit/rabbithole"));
+            message->setBody("Hi");
+            session->onStanzaReceived(message);
+
+            Presence::ref subscription = createPresence("bob@wonderland.lit");
+            subscription->setType(Presence::Subscribe);
+            session->onStanzaReceived(subscription);
+
+            Presence::ref mucSelfPresence = createPresence("room@conference.wonderland.lit/me");
+            MUCUserPayload::ref mucPayload = std::make_shared<MUCUserPayload>();
+            mucPayload->addStatusCode(MUCUserPayload::StatusCode(110));
+            mucSelfPresence->addPayload(mucPayload);
+            session->onStanzaReceived(mucSelfPresence);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), receivedStanzas.size());
+        }
+
+        void testInactive_DeliversWhenTooManyDeferred() {
+            testling->setClientState(ClientState::ClientStateType::Inactive);
+            for (int i = 0; i < 500; ++i) {
+                session->onStanzaReceived(createPresence("alice@wonderland.lit/" + std::to_string(i)));
+            }
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(500), receivedStanzas.size());
+        }
+
+        void testInactive_MUCJoinKeepsOrder() {
+            testling->setClientState(ClientState::ClientStateType::Inactive);
+
+            Presence::ref occupantPresence = createPresence("room@conference.wonderland.lit/alice");
+            occupantPresence->addPayload(std::make_shared<MUCUserPayload>());
+            session->onStanzaReceived(occupantPresence);
+            // Without a MUC payload, the room can't be told apart from a contact
+            Presence::ref otherOccupantPresence = createPresence("room@conference.wonderland.lit/bob");
+            session->onStanzaReceived(otherOccupantPresence);
+            Presence::ref selfPresence = createPresence("room@conference.wonderland.lit/me");
+            MUCUserPayload::ref mucPayload = std::make_shared<MUCUserPayload>();
+            mucPayload->addStatusCode(MUCUserPayload::StatusCode(110));
+            selfPresence->addPayload(mucPayload);
+            session->onStanzaReceived(selfPresence);
+            Message::ref subject = std::make_shared<Message>();
+            subject->setFrom(JID("room@conference.wonderland.lit"));
+            subject->setType(Message::Groupchat);
+            subject->setSubject("Tea party");
+            session->onStanzaReceived(subject);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), receivedStanzas.size());
+            CPPUNIT_ASSERT(occupantPresence == receivedStanzas[0]);
+            CPPUNIT_ASSERT(otherOccupantPresence == receivedStanzas[1]);
+            CPPUNIT_ASSERT(selfPresence == receivedStanzas[2]);
+            CPPUNIT_ASSERT(subject == receivedStanzas[3]);
+        }
+
+        void testInactive_DeliversDeferredPresenceBeforeMessageFromSender() {
+            testling->setClientState(ClientState::ClientStateType::Inactive);
+            Presence::ref alicePresence = createPresence("alice@wonderland.lit/rabbithole");
+            session->onStanzaReceived(alicePresence);
+            Presence::ref bobPresence = createPresence("bob@wonderland.lit/garden");
+            session->onStanzaReceived(bobPresence);
+
+            Message::ref message = std::make_shared<Message>();
+            message->setFrom(JID("alice@wonderland.lit/teaparty"));
+            message->setBody("Hi");
+            session->onStanzaReceived(message);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), receivedStanzas.size());
+            CPPUNIT_ASSERT(alicePresence == receivedStanzas[0]);
+            CPPUNIT_ASSERT(message == receivedStanzas[1]);
+
+            Presence::ref latestAlicePresence = createPresence("alice@wonderland.lit/rabbithole");
+            session->onStanzaReceived(latestAlicePresence);
+            testling->setClientState(ClientState::ClientStateType::Active);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), receivedStanzas.size());
+            CPPUNIT_ASSERT(bobPresence == receivedStanzas[2]);
+            CPPUNIT_ASSERT(latestAlicePresence == receivedStanzas[3]);
+        }
+
+    private:
+        Presence::ref createPresence(const std::string& from) {
+            Presence::ref presence = std::make_shared<Presence>();
+            presence->setFrom(JID(from));
+            return presence;
+        }
+
+        void handleStanzaReceived(std::shared_ptr<Stanza> stanza) {
+            receivedStanzas.push_back(stanza);
+        }
+
+    private:
+        std::shared_ptr<ClientSession> session;
+        std::shared_ptr<ClientSessionStanzaChannel> stanzaChannel;
+        std::shared_ptr<ClientStateManager> testling;
+        std::vector<std::shared_ptr<Stanza> > receivedStanzas;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ClientStateManagerTest);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2017 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -42,6 +42,7 @@ namespace {
                 assert(!finalized);
                 std::vector<unsigned char> result(CC_SHA1_DIGEST_LENGTH);
                 CC_SHA1_Final(vecptr(result), &context);
+                finalized = true;
                 return result;
             }
 
@@ -83,6 +84,7 @@ namespace {
                 assert(!finalized);
                 std::vector<unsigned char> result(CC_MD5_DIGEST_LENGTH);
                 CC_MD5_Final(vecptr(result), &context);
+                finalized = true;
                 return result;
             }
 
@@ -101,6 +103,90 @@ namespace {
             bool finalized;
     };
 
+    class SHA256Hash : public Hash {
+        public:
+            SHA256Hash() : finalized(false) {
+                if (!CC_SHA256_Init(&context)) {
+                    assert(false);
+                }
+            }
+
+            virtual ~SHA256Hash() override {
+            }
+
+            virtual Hash& update(const ByteArray& data) override {
+                return updateInternal(data);
+            }
+
+            virtual Hash& update(const SafeByteArray& data) override {
+                return updateInternal(data);
+            }
+
+            virtual std::vector<unsigned char> getHash() override {
+                assert(!finalized);
+                std::vector<unsigned char> result(CC_SHA256_DIGEST_LENGTH);
+                CC_SHA256_Final(vecptr(result), &context);
+                finalized = true;
+                return result;
+            }
+
+        private:
+            template<typename ContainerType>
+            Hash& updateInternal(const ContainerType& data) {
+                assert(!finalized);
+                if (!CC_SHA256_Update(&context, vecptr(data), boost::numeric_cast<CC_LONG>(data.size()))) {
+                    assert(false);
+                }
+                return *this;
+            }
+
+        private:
+            CC_SHA256_CTX context;
+            bool finalized;
+    };
+
+    class SHA512Hash : public Hash {
+        public:
+            SHA512Hash() : finalized(false) {
+                if (!CC_SHA512_Init(&context)) {
+                    assert(false);
+                }
+            }
+
+            virtual ~SHA512Hash() override {
+            }
+
+            virtual Hash& update(const ByteArray& data) override {
+                return updateInternal(data);
+            }
+
+            virtual Hash& update(const SafeByteArray& data) override {
+                return updateInternal(data);
+            }
+
+            virtual std::vector<unsigned char> getHash() override {
+                assert(!finalized);
+                std::vector<unsigned char> result(CC_SHA512_DIGEST_LENGTH);
+                CC_SHA512_Final(vecptr(result), &context);
+                finalized = true;
+                return result;
+            }
+
+        private:
+            template<typename ContainerType>
+            Hash& updateInternal(const ContainerType& data) {
+                assert(!finalized);
+                if (!CC_SHA512_Update(&context, vecptr(data), boost::numeric_cast<CC_LONG>(data.size()))) {
+                    assert(false);
+                }
+                return *this;
+            }
+
+        private:
+            CC_SHA512_CTX context;
+            bool finalized;
+    };
+
     template<typename T>
     ByteArray getHMACSHA1Internal(const T& key, const ByteArray& data) {
         std::vector<unsigned char> result(CC_SHA1_DIGEST_LENGTH);
@@ -123,6 +209,16 @@ Hash* CommonCryptoCryptoProvider::createMD5() {
     return new MD5Hash();
 }
 
+Hash* CommonCryptoCryptoProvider::createHash(const std::string& algorithm) {
+    if (algorithm == "sha-256") {
+        return new SHA256Hash();
+    }
+    if (algorithm == "sha-512") {
+        return new SHA512Hash();
+    }
+    return CryptoProvider::createHash(algorithm);
+}
+
 ByteArray CommonCryptoCryptoProvider::getHMACSHA1(const SafeByteArray& key, const ByteArray& data) {
     return getHMACSHA1Internal(key, data);
 }
@@ -12,3 +12,13 @@ using namespace Swift;
 
 CryptoProvider::~CryptoProvider() {
 }
+
+Hash* CryptoProvider::createHash(const std::string& algorithm) {
+    if (algorithm == "sha-1") {
+        return createSHA1();
+    }
+    if (algorithm == "md5") {
+        return createMD5();
+    }
+    return nullptr;
+}
@@ -1,11 +1,13 @@
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <string>
+
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/ByteArray.h>
 #include <Swiften/Base/SafeByteArray.h>
@@ -20,6 +22,15 @@ namespace Swift {
 
             virtual Hash* createSHA1() = 0;
             virtual Hash* createMD5() = 0;
+
+            /**
+             * Creates a hash for the algorithm with the XEP-0300 name
+             * \p algorithm (e.g. "sha-256" or "sha3-256").
+             *
+             * Returns a null pointer if the algorithm is not supported.
+             */
+            virtual Hash* createHash(const std::string& algorithm);
+
             virtual ByteArray getHMACSHA1(const SafeByteArray& key, const ByteArray& data) = 0;
             virtual ByteArray getHMACSHA1(const ByteArray& key, const ByteArray& data) = 0;
             virtual bool isMD5AllowedForCrypto() const = 0;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2017 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,6 +9,8 @@
 #include <openssl/sha.h>
 #include <openssl/md5.h>
 #include <openssl/hmac.h>
+#include <openssl/evp.h>
+#include <openssl/opensslv.h>
 #include <cassert>
 #include <boost/numeric/conversion/cast.hpp>
 
@@ -43,6 +45,7 @@ namespace {
                 assert(!finalized);
                 std::vector<unsigned char> result(SHA_DIGEST_LENGTH);
                 SHA1_Final(vecptr(result), &context);
+                finalized = true;
                 return result;
             }
 
@@ -84,6 +87,7 @@ namespace {
                 assert(!finalized);
                 std::vector<unsigned char> result(MD5_DIGEST_LENGTH);
                 MD5_Final(vecptr(result), &context);
+                finalized = true;
                 return result;
             }
 
@@ -102,6 +106,82 @@ namespace {
             bool finalized;
     };
 
+    class EVPHash : public Hash {
+        public:
+            EVPHash(const EVP_MD* md) : finalized(false) {
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+                context = EVP_MD_CTX_new();
+#else
+                context = EVP_MD_CTX_create();
+#endif
+                if (!EVP_DigestInit_ex(context, md, nullptr)) {
+                    assert(false);
+                }
+            }
+
+            ~EVPHash() {
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+                EVP_MD_CTX_free(context);
+#else
+                EVP_MD_CTX_destroy(context);
+#endif
+            }
+
+            virtual Hash& update(const ByteArray& data) override {
+                return updateInternal(data);
+            }
+
+            virtual Hash& update(const SafeByteArray& data) override {
+                return updateInternal(data);
+            }
+
+            virtual std::vector<unsigned char> getHash() override {
+                assert(!finalized);
+                std::vector<unsigned char> result(EVP_MAX_MD_SIZE);
+                unsigned int len = 0;
+                EVP_DigestFinal_ex(context, vecptr(result), &len);
+                result.resize(len);
+                finalized = true;
+                return result;
+            }
+
+        private:
+            template<typename ContainerType>
+            Hash& updateInternal(const ContainerType& data) {
+                assert(!finalized);
+                if (!EVP_DigestUpdate(context, vecptr(data), data.size())) {
+                    assert(false);
+                }
+                return *this;
+            }
+
+        private:
+            EVP_MD_CTX* context;
+            bool finalized;
+    };
+
+    const EVP_MD* getDigest(const std::string& algorithm) {
+        if (algorithm == "sha-256") {
+            return EVP_sha256();
+        }
+        if (algorithm == "sha-512") {
+            return EVP_sha512();
+        }
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+        if (algorithm == "sha3-256") {
+            return EVP_sha3_256();
+        }
+        if (algorithm == "sha3-512") {
+            return EVP_sha3_512();
+        }
+#endif
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined(OPENSSL_NO_BLAKE2)
+        if (algorithm == "blake2b-512") {
+            return EVP_blake2b512();
+        }
+#endif
+        return nullptr;
+    }
 
     template<typename T>
     ByteArray getHMACSHA1Internal(const T& key, const ByteArray& data) {
@@ -126,6 +206,13 @@ Hash* OpenSSLCryptoProvider::createMD5() {
     return new MD5Hash();
 }
 
+Hash* OpenSSLCryptoProvider::createHash(const std::string& algorithm) {
+    if (const EVP_MD* md = getDigest(algorithm)) {
+        return new EVPHash(md);
+    }
+    return CryptoProvider::createHash(algorithm);
+}
+
 ByteArray OpenSSLCryptoProvider::getHMACSHA1(const SafeByteArray& key, const ByteArray& data) {
     return getHMACSHA1Internal(key, data);
 }
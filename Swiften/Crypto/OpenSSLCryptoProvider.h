@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2017 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,6 +16,7 @@ namespace Swift {
 
             virtual Hash* createSHA1() override;
             virtual Hash* createMD5() override;
+            virtual Hash* createHash(const std::string& algorithm) override;
             virtual ByteArray getHMACSHA1(const SafeByteArray& key, const ByteArray& data) override;
             virtual ByteArray getHMACSHA1(const ByteArray& key, const ByteArray& data) override;
             virtual bool isMD5AllowedForCrypto() const override;
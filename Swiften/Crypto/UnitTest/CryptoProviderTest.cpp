@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -42,6 +42,10 @@ class CryptoProviderTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testGetHMACSHA1);
         CPPUNIT_TEST(testGetHMACSHA1_KeyLongerThanBlockSize);
 
+        CPPUNIT_TEST(testCreateHash_SHA1);
+        CPPUNIT_TEST(testCreateHash_SHA256);
+        CPPUNIT_TEST(testCreateHash_UnknownAlgorithm);
+
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -141,6 +145,37 @@ class CryptoProviderTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(createByteArray("\xd6""n""\x8f""P|1""\xd3"",""\x6"" ""\xb9\xe3""gg""\x8e\xcf"" ]+""\xa"), result);
         }
 
+
+
+        ////////////////////////////////////////////////////////////
+        // Hashes by name
+        ////////////////////////////////////////////////////////////
+
+        void testCreateHash_SHA1() {
+            std::shared_ptr<Hash> testling = std::shared_ptr<Hash>(provider->createHash("sha-1"));
+            CPPUNIT_ASSERT(testling);
+            testling->update(createByteArray("client/pc//Exodus 0.9.1<http://jabber.org/protocol/caps<http://jabber.org/protocol/disco#info<http://jabber.org/protocol/disco#items<http://jabber.org/protocol/muc<"));
+
+            CPPUNIT_ASSERT_EQUAL(createByteArray("\x42\x06\xb2\x3c\xa6\xb0\xa6\x43\xd2\x0d\x89\xb0\x4f\xf5\x8c\xf7\x8b\x80\x96\xed"), testling->getHash());
+        }
+
+        void testCreateHash_SHA256() {
+            std::shared_ptr<Hash> testling = std::shared_ptr<Hash>(provider->createHash("sha-256"));
+            if (!testling) {
+                // Not every provider supports SHA-256
+                return;
+            }
+            testling->update(createByteArray("a"));
+            testling->update(createByteArray("bc"));
+
+            CPPUNIT_ASSERT_EQUAL(createByteArray("\xba\x78\x16\xbf\x8f\x01\xcf\xea\x41\x41\x40\xde\x5d\xae\x22\x23\xb0\x03\x61\xa3\x96\x17\x7a\x9c\xb4\x10\xff\x61\xf2\x00\x15\xad", 32), testling->getHash());
+        }
+
+        void testCreateHash_UnknownAlgorithm() {
+            std::shared_ptr<Hash> testling = std::shared_ptr<Hash>(provider->createHash("foo-1"));
+            CPPUNIT_ASSERT(!testling);
+        }
+
     private:
         CryptoProviderType* provider;
 };
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,6 +12,7 @@
 #include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Disco/CapsProvider.h>
 #include <Swiften/Elements/CapsInfo.h>
 #include <Swiften/Elements/DiscoInfo.h>
@@ -50,5 +51,6 @@ namespace Swift {
             std::set<std::string> requestedDiscoInfos;
             std::set< std::pair<JID, std::string> > failingCaps;
             std::map<std::string, std::set< std::pair<JID, std::string> > > fallbacks;
+            ScopedSignalConnection presenceReceivedConnection;
     };
 }
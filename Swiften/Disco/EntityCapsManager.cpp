@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,8 +13,8 @@
 
 namespace Swift {
 
-EntityCapsManager::EntityCapsManager(CapsProvider* capsProvider, StanzaChannel* stanzaChannel) : capsProvider(capsProvider) {
-    stanzaChannel->onPresenceReceived.connect(boost::bind(&EntityCapsManager::handlePresenceReceived, this, _1));
+EntityCapsManager::EntityCapsManager(CapsProvider* capsProvider, StanzaChannel* stanzaChannel) : capsProvider(capsProvider), stanzaChannel(stanzaChannel) {
+    presenceReceivedConnection = stanzaChannel->onPresenceReceived.connect(boost::bind(&EntityCapsManager::handlePresenceReceived, this, _1));
     stanzaChannel->onAvailableChanged.connect(boost::bind(&EntityCapsManager::handleStanzaChannelAvailableChanged, this, _1));
     capsProvider->onCapsAvailable.connect(boost::bind(&EntityCapsManager::handleCapsAvailable, this, _1));
 }
@@ -50,7 +50,7 @@ void EntityCapsManager::handlePresenceReceived(std::shared_ptr<Presence> presenc
 }
 
 void EntityCapsManager::handleStanzaChannelAvailableChanged(bool available) {
-    if (available) {
+    if (available && !stanzaChannel->isStreamResumed()) {
         std::map<JID, std::string> capsCopy;
         capsCopy.swap(caps);
         for (std::map<JID,std::string>::const_iterator i = capsCopy.begin(); i != capsCopy.end(); ++i) {
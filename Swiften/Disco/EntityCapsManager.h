@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,6 +12,7 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/LRUCache.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Disco/EntityCapsProvider.h>
 #include <Swiften/Elements/DiscoInfo.h>
 #include <Swiften/Elements/ErrorPayload.h>
@@ -45,7 +46,9 @@ namespace Swift {
 
         private:
             CapsProvider* capsProvider;
+            StanzaChannel* stanzaChannel;
             std::map<JID, std::string> caps;
             LRUCache<std::string, DiscoInfo::ref, 64> lruDiscoCache;
+            ScopedSignalConnection presenceReceivedConnection;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -31,6 +31,7 @@ class EntityCapsManagerTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testReceiveUnavailablePresenceAfterKnownHashTriggersChangeAndClearsCaps);
         CPPUNIT_TEST(testReconnectTriggersChangeAndClearsCaps);
         CPPUNIT_TEST(testHashAvailable);
+        CPPUNIT_TEST(testDestroyedManagerIsDisconnected);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -93,6 +94,14 @@ class EntityCapsManagerTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(discoInfo1, testling->getCaps(user1));
         }
 
+        void testDestroyedManagerIsDisconnected() {
+            std::shared_ptr<EntityCapsManager> testling = createManager();
+            testling.reset();
+
+            CPPUNIT_ASSERT(stanzaChannel->onPresenceReceived.empty());
+            sendPresenceWithCaps(user1, capsInfo1);
+        }
+
         void testReceiveUnknownHashAfterKnownHashTriggersChangeAndClearsCaps() {
             std::shared_ptr<EntityCapsManager> testling = createManager();
             capsProvider->caps[capsInfo1->getVersion()] = discoInfo1;
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Elements/ClientState.h>
+#include <Swiften/Elements/ToplevelElement.h>
+
+namespace Swift {
+    /**
+     * The <active/> or <inactive/> element that a client sends on the
+     * stream to indicate its state (XEP-0352).
+     */
+    class SWIFTEN_API ClientStateIndication : public ToplevelElement {
+        public:
+            ClientStateIndication(ClientState::ClientStateType state = ClientState::ClientStateType::Active) : state(state) {}
+
+            ClientState::ClientStateType getClientState() const {
+                return state;
+            }
+
+            void setClientState(ClientState::ClientStateType state) {
+                this->state = state;
+            }
+
+        private:
+            ClientState::ClientStateType state;
+    };
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,6 +12,17 @@
 namespace Swift {
     class SWIFTEN_API EnableStreamManagement : public ToplevelElement {
         public:
-            EnableStreamManagement() {}
+            EnableStreamManagement(bool resume = false) : resume(resume) {}
+
+            void setResume(bool b) {
+                resume = b;
+            }
+
+            bool getResume() const {
+                return resume;
+            }
+
+        private:
+            bool resume;
     };
 }
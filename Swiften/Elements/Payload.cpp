@@ -1,14 +1,36 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Elements/Payload.h>
 
+#include <cassert>
+#include <limits>
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
+
 namespace Swift {
 
 Payload::~Payload() {
 }
 
+Payload::TypeID Payload::getTypeID(const std::type_info& type) {
+    static std::mutex mutex;
+    static std::unordered_map<std::type_index, TypeID> typeIDs;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<std::type_index, TypeID>::const_iterator i = typeIDs.find(std::type_index(type));
+    if (i != typeIDs.end()) {
+        return i->second;
+    }
+    assert(typeIDs.size() < std::numeric_limits<TypeID>::max());
+    // 0 is reserved for 'not yet assigned'
+    TypeID typeID = static_cast<TypeID>(typeIDs.size() + 1);
+    typeIDs[std::type_index(type)] = typeID;
+    return typeID;
+}
+
 }
@@ -1,12 +1,14 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <typeinfo>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Elements/Element.h>
@@ -15,11 +17,49 @@ namespace Swift {
     class SWIFTEN_API Payload : public Element {
         public:
             typedef std::shared_ptr<Payload> ref;
+
+            /**
+             * A compact identifier of a payload type, which is cheaper to
+             * compare than the type itself. IDs are assigned on first use,
+             * and are only valid within the running process.
+             */
+            typedef unsigned short TypeID;
+
         public:
-            Payload() {}
-            SWIFTEN_DEFAULT_COPY_CONSTRUCTOR(Payload)
+            Payload() : typeID_(0) {}
+            Payload(const Payload&) : Element(), typeID_(0) {}
             virtual ~Payload();
 
-            SWIFTEN_DEFAULT_COPY_ASSIGMNENT_OPERATOR(Payload)
+            Payload& operator=(const Payload&) {
+                // The dynamic type, and thus the type ID, does not change
+                return *this;
+            }
+
+            /**
+             * Returns the ID of the dynamic type of this payload.
+             */
+            TypeID getTypeID() const {
+                TypeID result = typeID_.load(std::memory_order_relaxed);
+                if (!result) {
+                    result = getTypeID(typeid(*this));
+                    typeID_.store(result, std::memory_order_relaxed);
+                }
+                return result;
+            }
+
+            /**
+             * Returns the ID of payload type \p T.
+             */
+            template<typename T>
+            static TypeID getTypeID() {
+                static const TypeID typeID = getTypeID(typeid(T));
+                return typeID;
+            }
+
+        private:
+            static TypeID getTypeID(const std::type_info& type);
+
+        private:
+            mutable std::atomic<TypeID> typeID_;
     };
 }
@@ -1,15 +1,11 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Elements/Stanza.h>
 
-#include <typeinfo>
-
-#include <boost/bind.hpp>
-
 #include <Swiften/Elements/Delay.h>
 
 namespace Swift {
@@ -19,32 +15,63 @@ Stanza::Stanza() {
 
 Stanza::~Stanza() {
     payloads_.clear();
+    payloadTypeIDs_.clear();
+}
+
+void Stanza::parsePayloads() {
+    const Payload::TypeID unparsedTypeID = Payload::getTypeID<UnparsedPayload>();
+    for (size_t i = 0; i < payloads_.size(); ++i) {
+        if (payloadTypeIDs_[i] == unparsedTypeID) {
+            payloads_[i] = std::static_pointer_cast<UnparsedPayload>(payloads_[i])->getParsedPayload();
+            payloadTypeIDs_[i] = payloads_[i]->getTypeID();
+        }
+    }
+}
+
+std::vector< std::shared_ptr<Payload> > Stanza::getPayloads() const {
+    std::vector< std::shared_ptr<Payload> > results;
+    results.reserve(payloads_.size());
+    for (size_t i = 0; i < payloads_.size(); ++i) {
+        Payload::TypeID typeID;
+        results.push_back(getPayloadAt<Payload>(i, typeID));
+    }
+    return results;
 }
 
 void Stanza::updatePayload(std::shared_ptr<Payload> payload) {
-    for (auto&& i : payloads_) {
-        if (typeid(*i.get()) == typeid(*payload.get())) {
-            i = payload;
+    parsePayloads();
+    const Payload::TypeID typeID = payload->getTypeID();
+    for (size_t i = 0; i < payloads_.size(); ++i) {
+        if (payloadTypeIDs_[i] == typeID) {
+            payloads_[i] = payload;
             return;
         }
     }
     addPayload(payload);
 }
 
-static bool sameType(std::shared_ptr<Payload> a, std::shared_ptr<Payload> b) {
-    return typeid(*a.get()) == typeid(*b.get());
-}
-
 void Stanza::removePayloadOfSameType(std::shared_ptr<Payload> payload) {
-    payloads_.erase(std::remove_if(payloads_.begin(), payloads_.end(),
-        boost::bind<bool>(&sameType, payload, _1)),
-        payloads_.end());
+    parsePayloads();
+    const Payload::TypeID typeID = payload->getTypeID();
+    size_t kept = 0;
+    for (size_t i = 0; i < payloads_.size(); ++i) {
+        if (payloadTypeIDs_[i] != typeID) {
+            payloads_[kept] = payloads_[i];
+            payloadTypeIDs_[kept] = payloadTypeIDs_[i];
+            ++kept;
+        }
+    }
+    payloads_.resize(kept);
+    payloadTypeIDs_.resize(kept);
 }
 
 std::shared_ptr<Payload> Stanza::getPayloadOfSameType(std::shared_ptr<Payload> payload) const {
-    for (const auto& i : payloads_) {
-        if (typeid(*i.get()) == typeid(*payload.get())) {
-            return i;
+    const Payload::TypeID typeID = payload->getTypeID();
+    for (size_t i = 0; i < payloads_.size(); ++i) {
+        Payload::TypeID payloadTypeID;
+        const std::shared_ptr<Payload>& storedPayload = getPayloadAt<Payload>(i, payloadTypeID);
+        if (payloadTypeID == typeID) {
+            return storedPayload;
         }
     }
     return std::shared_ptr<Payload>();
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -14,12 +15,12 @@
 #include <boost/optional/optional.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Elements/Payload.h>
 #include <Swiften/Elements/ToplevelElement.h>
+#include <Swiften/Elements/UnparsedPayload.h>
 #include <Swiften/JID/JID.h>
 
 namespace Swift {
-    class Payload;
-
     class SWIFTEN_API Stanza : public ToplevelElement {
         public:
             typedef std::shared_ptr<Stanza> ref;
@@ -31,46 +32,85 @@ namespace Swift {
             virtual ~Stanza();
             SWIFTEN_DEFAULT_COPY_CONSTRUCTOR(Stanza)
 
+            /**
+             * Returns the first payload of type \p T (or a subclass).
+             *
+             * Unparsed payloads are parsed as they are passed over, so only
+             * the payloads up to the one found are parsed. Payloads can be
+             * looked up from several threads at once, as long as the stanza
+             * is not modified.
+             *
+             * Looking up UnparsedPayload itself returns the first payload
+             * that has not been parsed yet.
+             */
             template<typename T>
             std::shared_ptr<T> getPayload() const {
-                for (const auto& payload : payloads_) {
-                    std::shared_ptr<T> result(std::dynamic_pointer_cast<T>(payload));
-                    if (result) {
-                        return result;
+                const Payload::TypeID typeID = Payload::getTypeID<T>();
+                for (size_t i = 0; i < payloads_.size(); ++i) {
+                    Payload::TypeID payloadTypeID;
+                    const std::shared_ptr<Payload>& payload = getPayloadAt<T>(i, payloadTypeID);
+                    if (payloadTypeID == typeID) {
+                        return std::static_pointer_cast<T>(payload);
+                    }
+                    if (isSubtype<T>(payloadTypeID, payload)) {
+                        return std::dynamic_pointer_cast<T>(payload);
                     }
                 }
                 return std::shared_ptr<T>();
             }
 
+            /**
+             * Returns all payloads of type \p T (or a subclass).
+             * \see getPayload()
+             */
             template<typename T>
             std::vector< std::shared_ptr<T> > getPayloads() const {
+                const Payload::TypeID typeID = Payload::getTypeID<T>();
                 std::vector< std::shared_ptr<T> > results;
-                for (const auto& payload : payloads_) {
-                    std::shared_ptr<T> result(std::dynamic_pointer_cast<T>(payload));
-                    if (result) {
-                        results.push_back(result);
+                for (size_t i = 0; i < payloads_.size(); ++i) {
+                    Payload::TypeID payloadTypeID;
+                    const std::shared_ptr<Payload>& payload = getPayloadAt<T>(i, payloadTypeID);
+                    if (payloadTypeID == typeID) {
+                        results.push_back(std::static_pointer_cast<T>(payload));
+                    }
+                    else if (isSubtype<T>(payloadTypeID, payload)) {
+                        results.push_back(std::dynamic_pointer_cast<T>(payload));
                     }
                 }
                 return results;
             }
 
-
-            const std::vector< std::shared_ptr<Payload> >& getPayloads() const {
+            /**
+             * Returns all payloads, parsing the unparsed ones.
+             * \see getPayload()
+             */
+            std::vector< std::shared_ptr<Payload> > getPayloads() const;
+
+            /**
+             * Returns the payloads as they are stored, so payloads whose
+             * parsing was deferred (see StanzaParser::setLazyPayloadParsing())
+             * are UnparsedPayloads. This is for serializers, which can write
+             * these without parsing them.
+             */
+            const std::vector< std::shared_ptr<Payload> >& getStoredPayloads() const {
                 return payloads_;
             }
 
             void addPayload(std::shared_ptr<Payload> payload) {
+                payloadTypeIDs_.push_back(payload ? payload->getTypeID() : 0);
                 payloads_.push_back(payload);
             }
 
             template<typename InputIterator>
             void addPayloads(InputIterator begin, InputIterator end) {
-                payloads_.insert(payloads_.end(), begin, end);
+                for (InputIterator i = begin; i != end; ++i) {
+                    addPayload(*i);
+                }
             }
 
             template<typename Container>
             void addPayloads(const Container& container) {
-                payloads_.insert(payloads_.end(), std::begin(container), std::end(container));
+                addPayloads(std::begin(container), std::end(container));
             }
 
             void updatePayload(std::shared_ptr<Payload> payload);
@@ -93,9 +133,63 @@ namespace Swift {
             boost::optional<boost::posix_time::ptime> getTimestampFrom(const JID& jid) const;
 
         private:
+            /**
+             * Replaces the unparsed payloads by their parsed form.
+             */
+            void parsePayloads();
+
+            /**
+             * Returns the payload at \p index, and its type ID. Unparsed
+             * payloads are parsed, unless \p T is UnparsedPayload, in which
+             * case the ones that were parsed are returned as null payloads.
+             */
+            template<typename T>
+            const std::shared_ptr<Payload>& getPayloadAt(size_t index, Payload::TypeID& typeID) const {
+                static const Payload::TypeID unparsedTypeID = Payload::getTypeID<UnparsedPayload>();
+                typeID = payloadTypeIDs_[index];
+                if (typeID != unparsedTypeID) {
+                    return payloads_[index];
+                }
+                const UnparsedPayload* unparsedPayload = static_cast<const UnparsedPayload*>(payloads_[index].get());
+                if (Payload::getTypeID<T>() == unparsedTypeID) {
+                    if (unparsedPayload->isParsed()) {
+                        static const std::shared_ptr<Payload> parsedPayload;
+                        typeID = 0;
+                        return parsedPayload;
+                    }
+                    return payloads_[index];
+                }
+                const std::shared_ptr<Payload>& payload = unparsedPayload->getParsedPayload();
+                typeID = payload->getTypeID();
+                return payload;
+            }
+
+            /**
+             * Returns whether a payload of type \p typeID is a subclass of
+             * \p T. Type relations never change, so the result is only
+             * computed (with a dynamic cast) once per payload type.
+             */
+            template<typename T>
+            static bool isSubtype(Payload::TypeID typeID, const std::shared_ptr<Payload>& payload) {
+                static std::atomic<signed char> subtypeCache[MaxCachedSubtypeIDs];
+                if (typeID >= MaxCachedSubtypeIDs) {
+                    return !!std::dynamic_pointer_cast<T>(payload);
+                }
+                signed char cached = subtypeCache[typeID].load(std::memory_order_relaxed);
+                if (!cached) {
+                    cached = std::dynamic_pointer_cast<T>(payload) ? 1 : -1;
+                    subtypeCache[typeID].store(cached, std::memory_order_relaxed);
+                }
+                return cached > 0;
+            }
+
+        private:
+            static const Payload::TypeID MaxCachedSubtypeIDs = 512;
+
             std::string id_;
             JID from_;
             JID to_;
             std::vector< std::shared_ptr<Payload> > payloads_;
+            std::vector<Payload::TypeID> payloadTypeIDs_;
     };
 }
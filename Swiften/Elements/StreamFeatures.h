@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -20,7 +20,7 @@ namespace Swift {
         public:
             typedef std::shared_ptr<StreamFeatures> ref;
 
-            StreamFeatures() : hasStartTLS_(false), hasResourceBind_(false), hasSession_(false), hasStreamManagement_(false), hasRosterVersioning_(false) {}
+            StreamFeatures() : hasStartTLS_(false), hasResourceBind_(false), hasSession_(false), hasStreamManagement_(false), hasRosterVersioning_(false), hasClientStateIndication_(false) {}
 
             void setHasStartTLS() {
                 hasStartTLS_ = true;
@@ -94,6 +94,14 @@ namespace Swift {
                 hasRosterVersioning_ = true;
             }
 
+            bool hasClientStateIndication() const {
+                return hasClientStateIndication_;
+            }
+
+            void setHasClientStateIndication() {
+                hasClientStateIndication_ = true;
+            }
+
         private:
             bool hasStartTLS_;
             std::vector<std::string> compressionMethods_;
@@ -102,6 +110,7 @@ namespace Swift {
             bool hasSession_;
             bool hasStreamManagement_;
             bool hasRosterVersioning_;
+            bool hasClientStateIndication_;
             boost::optional<std::string> authenticationHostname_;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -25,12 +25,15 @@ class StanzaTest : public CppUnit::TestFixture
         CPPUNIT_TEST(testGetPayload);
         CPPUNIT_TEST(testGetPayloads);
         CPPUNIT_TEST(testGetPayload_NoSuchPayload);
+        CPPUNIT_TEST(testGetPayload_Subclass);
+        CPPUNIT_TEST(testGetPayloads_Subclass);
         CPPUNIT_TEST(testDestructor);
         CPPUNIT_TEST(testDestructor_Copy);
         CPPUNIT_TEST(testUpdatePayload_ExistingPayload);
         CPPUNIT_TEST(testUpdatePayload_NewPayload);
         CPPUNIT_TEST(testGetPayloadOfSameType);
         CPPUNIT_TEST(testGetPayloadOfSameType_NoSuchPayload);
+        CPPUNIT_TEST(testRemovePayloadOfSameType);
         CPPUNIT_TEST(testGetTimestamp);
         CPPUNIT_TEST(testGetTimestamp_TimestampWithFrom);
         CPPUNIT_TEST(testGetTimestamp_NoDelay);
@@ -56,6 +59,11 @@ class StanzaTest : public CppUnit::TestFixture
                 MyPayload3() {}
         };
 
+        class MyPayload2Subclass : public MyPayload2 {
+            public:
+                MyPayload2Subclass(const std::string& s = "") : MyPayload2(s) {}
+        };
+
         class DestroyingPayload : public Payload {
             public:
                 DestroyingPayload(bool* alive) : alive_(alive) {
@@ -121,6 +129,32 @@ class StanzaTest : public CppUnit::TestFixture
             CPPUNIT_ASSERT(!p);
         }
 
+        void testGetPayload_Subclass() {
+            Message m;
+            m.addPayload(std::make_shared<MyPayload1>());
+            m.addPayload(std::make_shared<MyPayload2Subclass>("foo"));
+            m.addPayload(std::make_shared<MyPayload2>("bar"));
+
+            std::shared_ptr<MyPayload2> p(m.getPayload<MyPayload2>());
+            CPPUNIT_ASSERT(p);
+            CPPUNIT_ASSERT_EQUAL(std::string("foo"), p->text_);
+            CPPUNIT_ASSERT(m.getPayload<Payload>());
+            CPPUNIT_ASSERT(!m.getPayload<MyPayload3>());
+        }
+
+        void testGetPayloads_Subclass() {
+            Message m;
+            m.addPayload(std::make_shared<MyPayload2>("foo"));
+            m.addPayload(std::make_shared<MyPayload1>());
+            m.addPayload(std::make_shared<MyPayload2Subclass>("bar"));
+
+            std::vector<std::shared_ptr<MyPayload2> > payloads(m.getPayloads<MyPayload2>());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), payloads.size());
+            CPPUNIT_ASSERT_EQUAL(std::string("foo"), payloads[0]->text_);
+            CPPUNIT_ASSERT_EQUAL(std::string("bar"), payloads[1]->text_);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), m.getPayloads<MyPayload2Subclass>().size());
+        }
+
         void testGetPayloads() {
             Message m;
             std::shared_ptr<MyPayload2> payload1(new MyPayload2());
@@ -180,6 +214,21 @@ class StanzaTest : public CppUnit::TestFixture
             CPPUNIT_ASSERT(!m.getPayloadOfSameType(std::make_shared<MyPayload2>("bar")));
         }
 
+        void testRemovePayloadOfSameType() {
+            Message m;
+            m.addPayload(std::make_shared<MyPayload2>("foo"));
+            m.addPayload(std::make_shared<MyPayload1>());
+            m.addPayload(std::make_shared<MyPayload2>("bar"));
+            m.addPayload(std::make_shared<MyPayload3>());
+
+            m.removePayloadOfSameType(std::make_shared<MyPayload2>());
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), m.getPayloads().size());
+            CPPUNIT_ASSERT(!m.getPayload<MyPayload2>());
+            CPPUNIT_ASSERT(m.getPayload<MyPayload1>());
+            CPPUNIT_ASSERT(m.getPayload<MyPayload3>());
+        }
+
         void testGetTimestamp() {
             Message m;
             m.addPayload(std::make_shared<Delay>(boost::posix_time::from_time_t(1)));
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Elements/RawXMLPayload.h>
+
+namespace Swift {
+    /**
+     * A received payload whose parsing has been deferred.
+     *
+     * Stanza parses it when a payload is first looked up by type. Until
+     * then, it is serialized from the XML it was received as.
+     */
+    class SWIFTEN_API UnparsedPayload : public RawXMLPayload {
+        public:
+            typedef std::shared_ptr<UnparsedPayload> ref;
+            typedef std::function<std::shared_ptr<Payload> (const std::string& rawXML)> Parser;
+
+            UnparsedPayload(const std::string& rawXML, const Parser& parser) : RawXMLPayload(rawXML), parser_(parser), parsed_(false) {}
+
+            /**
+             * Returns the parsed payload, parsing it on the first call. If
+             * the XML could not be parsed, this is a RawXMLPayload with the
+             * XML.
+             *
+             * This can be called from several threads at once; the payload
+             * is only parsed once.
+             */
+            const std::shared_ptr<Payload>& getParsedPayload() const {
+                std::call_once(parseOnce_, [this]() {
+                    parsedPayload_ = parser_(getRawXML());
+                    if (!parsedPayload_) {
+                        parsedPayload_ = std::make_shared<RawXMLPayload>(getRawXML());
+                    }
+                    parsed_.store(true, std::memory_order_release);
+                });
+                return parsedPayload_;
+            }
+
+            /**
+             * Checks whether getParsedPayload() has parsed the payload.
+             */
+            bool isParsed() const {
+                return parsed_.load(std::memory_order_acquire);
+            }
+
+        private:
+            Parser parser_;
+            mutable std::once_flag parseOnce_;
+            mutable std::shared_ptr<Payload> parsedPayload_;
+            mutable std::atomic<bool> parsed_;
+    };
+}
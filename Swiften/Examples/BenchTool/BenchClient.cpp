@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Examples/BenchTool/BenchClient.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+#include <boost/bind.hpp>
+
+#include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Client/CoreClient.h>
+#include <Swiften/Elements/MUCPayload.h>
+#include <Swiften/Elements/Presence.h>
+#include <Swiften/Examples/BenchTool/BenchScenario.h>
+#include <Swiften/Network/NetworkFactories.h>
+#include <Swiften/Network/TimerFactory.h>
+#include <Swiften/VCards/GetVCardRequest.h>
+
+namespace Swift {
+
+static const std::string BodyPrefix = "bench ";
+
+static uint64_t getMicroseconds(BenchClient::Clock::time_point time) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count());
+}
+
+static uint64_t getMicrosecondsSince(BenchClient::Clock::time_point time) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(BenchClient::Clock::now() - time).count());
+}
+
+BenchClient::BenchClient(int user, const BenchScenario& scenario, NetworkFactories* networkFactories, CertificateTrustChecker* trustChecker, BenchStatistics* statistics) :
+        user_(user),
+        scenario_(scenario),
+        networkFactories_(networkFactories),
+        statistics_(statistics),
+        random_(static_cast<std::mt19937::result_type>(user)),
+        connected_(false),
+        stopping_(false) {
+    client_ = std::unique_ptr<CoreClient>(new CoreClient(JID(scenario.getJID(user)), createSafeByteArray(scenario.getPassword(user)), networkFactories));
+    client_->setCertificateTrustChecker(trustChecker);
+    client_->onConnected.connect(boost::bind(&BenchClient::handleConnected, this));
+    client_->onDisconnected.connect(boost::bind(&BenchClient::handleDisconnected, this, _1));
+    client_->onMessageReceived.connect(boost::bind(&BenchClient::handleMessageReceived, this, _1));
+}
+
+BenchClient::~BenchClient() {
+    stop();
+}
+
+void BenchClient::start(int loginDelayMilliseconds) {
+    loginTimer_ = networkFactories_->getTimerFactory()->createTimer(loginDelayMilliseconds);
+    loginTimerConnection_ = loginTimer_->onTick.connect(boost::bind(&BenchClient::handleLoginTimerTick, this));
+    loginTimer_->start();
+}
+
+void BenchClient::stop() {
+    if (stopping_) {
+        return;
+    }
+    stopping_ = true;
+    if (loginTimer_) {
+        loginTimer_->stop();
+    }
+    if (trafficTimer_) {
+        trafficTimer_->stop();
+    }
+    if (client_->isActive()) {
+        client_->disconnect();
+    }
+}
+
+void BenchClient::handleLoginTimerTick() {
+    loginStart_ = Clock::now();
+    client_->connect(scenario_.clientOptions);
+}
+
+void BenchClient::handleConnected() {
+    connected_ = true;
+    statistics_->loginsSucceeded++;
+    statistics_->loginLatency.record(getMicrosecondsSince(loginStart_));
+
+    client_->sendPresence(std::make_shared<Presence>());
+    if (scenario_.mucWeight > 0 && !scenario_.mucService.empty()) {
+        std::shared_ptr<Presence> joinPresence = std::make_shared<Presence>();
+        joinPresence->setTo(getRoomJID());
+        std::shared_ptr<MUCPayload> mucPayload = std::make_shared<MUCPayload>();
+        mucPayload->setMaxStanzas(0);
+        joinPresence->addPayload(mucPayload);
+        client_->sendPresence(joinPresence);
+    }
+    scheduleTraffic();
+}
+
+void BenchClient::handleDisconnected(const boost::optional<ClientError>&) {
+    if (stopping_) {
+        return;
+    }
+    if (connected_) {
+        statistics_->disconnects++;
+    }
+    else {
+        statistics_->loginsFailed++;
+    }
+    connected_ = false;
+    if (trafficTimer_) {
+        trafficTimer_->stop();
+    }
+}
+
+void BenchClient::handleMessageReceived(std::shared_ptr<Message> message) {
+    const boost::optional<std::string> body = message->getBody();
+    if (!body || body->compare(0, BodyPrefix.size(), BodyPrefix) != 0) {
+        return;
+    }
+    uint64_t sent = std::strtoull(body->c_str() + BodyPrefix.size(), nullptr, 10);
+    uint64_t now = getMicroseconds(Clock::now());
+    statistics_->messagesReceived++;
+    statistics_->deliveryLatency.record(now > sent ? now - sent : 0);
+}
+
+void BenchClient::scheduleTraffic() {
+    int totalWeight = scenario_.messageWeight + scenario_.presenceWeight + scenario_.iqWeight + scenario_.mucWeight;
+    if (stopping_ || scenario_.stanzasPerSecond <= 0 || totalWeight <= 0) {
+        return;
+    }
+    // Exponentially distributed intervals, so the users do not send in lockstep
+    std::exponential_distribution<double> interval(scenario_.stanzasPerSecond);
+    int milliseconds = std::max(1, static_cast<int>(std::lround(interval(random_) * 1000)));
+    trafficTimer_ = networkFactories_->getTimerFactory()->createTimer(milliseconds);
+    trafficTimerConnection_ = trafficTimer_->onTick.connect(boost::bind(&BenchClient::handleTrafficTimerTick, this));
+    trafficTimer_->start();
+}
+
+void BenchClient::handleTrafficTimerTick() {
+    if (!client_->isAvailable()) {
+        return;
+    }
+    int totalWeight = scenario_.messageWeight + scenario_.presenceWeight + scenario_.iqWeight + scenario_.mucWeight;
+    int choice = std::uniform_int_distribution<int>(0, totalWeight - 1)(random_);
+    if ((choice -= scenario_.messageWeight) < 0) {
+        sendMessage();
+    }
+    else if ((choice -= scenario_.presenceWeight) < 0) {
+        sendPresence();
+    }
+    else if ((choice -= scenario_.iqWeight) < 0) {
+        sendIQ();
+    }
+    else {
+        sendMUCMessage();
+    }
+    scheduleTraffic();
+}
+
+void BenchClient::sendMessage() {
+    int recipient = user_;
+    if (scenario_.userCount > 1) {
+        // Any other user
+        recipient = scenario_.firstUser + std::uniform_int_distribution<int>(0, scenario_.userCount - 2)(random_);
+        if (recipient >= user_) {
+            ++recipient;
+        }
+    }
+    std::shared_ptr<Message> message = std::make_shared<Message>();
+    message->setTo(JID(scenario_.getJID(recipient)));
+    message->setType(Message::Chat);
+    message->setBody(BodyPrefix + std::to_string(getMicroseconds(Clock::now())));
+    client_->sendMessage(message);
+    statistics_->messagesSent++;
+}
+
+void BenchClient::sendPresence() {
+    std::shared_ptr<Presence> presence = std::make_shared<Presence>();
+    if (statistics_->presencesSent % 2 == 0) {
+        presence->setShow(StatusShow::Away);
+        presence->setStatus("Away from the keyboard");
+    }
+    else {
+        presence->setStatus("Available");
+    }
+    client_->sendPresence(presence);
+    statistics_->presencesSent++;
+}
+
+void BenchClient::sendIQ() {
+    // A vCard request for the own account is answered by the server itself
+    GetVCardRequest::ref request = GetVCardRequest::create(JID(), client_->getIQRouter());
+    request->onResponse.connect(boost::bind(&BenchClient::handleVCardResponse, this, Clock::now(), _1, _2));
+    request->send();
+    statistics_->iqsSent++;
+}
+
+void BenchClient::handleVCardResponse(Clock::time_point sent, std::shared_ptr<VCard>, ErrorPayload::ref error) {
+    statistics_->roundTripLatency.record(getMicrosecondsSince(sent));
+    if (error) {
+        statistics_->iqErrors++;
+    }
+}
+
+void BenchClient::sendMUCMessage() {
+    if (scenario_.mucService.empty()) {
+        return;
+    }
+    std::shared_ptr<Message> message = std::make_shared<Message>();
+    message->setTo(getRoomJID().toBare());
+    message->setType(Message::Groupchat);
+    message->setBody(BodyPrefix + std::to_string(getMicroseconds(Clock::now())));
+    client_->sendMessage(message);
+    statistics_->mucMessagesSent++;
+}
+
+JID BenchClient::getRoomJID() const {
+    int room = (user_ - scenario_.firstUser) % std::max(1, scenario_.mucRooms);
+    return JID("bench" + std::to_string(room), scenario_.mucService, client_->getJID().getNode());
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <random>
+
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+#include <boost/signals2.hpp>
+
+#include <Swiften/Client/ClientError.h>
+#include <Swiften/Elements/ErrorPayload.h>
+#include <Swiften/Elements/Message.h>
+#include <Swiften/Elements/VCard.h>
+#include <Swiften/JID/JID.h>
+#include <Swiften/Network/Timer.h>
+
+namespace Swift {
+    class CertificateTrustChecker;
+    class CoreClient;
+    class NetworkFactories;
+    struct BenchScenario;
+    struct BenchStatistics;
+
+    /**
+     * A simulated user, which logs in after a delay and then sends the
+     * traffic of its scenario until it is stopped.
+     *
+     * Messages carry the time at which they were sent, so the user that
+     * receives them can measure the delivery latency. This only works if
+     * sender and receiver run in the same process.
+     */
+    class BenchClient : public boost::noncopyable {
+        public:
+            typedef std::chrono::steady_clock Clock;
+
+            BenchClient(int user, const BenchScenario& scenario, NetworkFactories* networkFactories, CertificateTrustChecker* trustChecker, BenchStatistics* statistics);
+            ~BenchClient();
+
+            void start(int loginDelayMilliseconds);
+            void stop();
+
+        private:
+            void handleLoginTimerTick();
+            void handleConnected();
+            void handleDisconnected(const boost::optional<ClientError>& error);
+            void handleMessageReceived(std::shared_ptr<Message> message);
+            void handleTrafficTimerTick();
+            void handleVCardResponse(Clock::time_point sent, std::shared_ptr<VCard>, ErrorPayload::ref error);
+
+            void scheduleTraffic();
+            void sendMessage();
+            void sendPresence();
+            void sendIQ();
+            void sendMUCMessage();
+            JID getRoomJID() const;
+
+        private:
+            int user_;
+            const BenchScenario& scenario_;
+            NetworkFactories* networkFactories_;
+            BenchStatistics* statistics_;
+            std::unique_ptr<CoreClient> client_;
+            std::shared_ptr<Timer> loginTimer_;
+            std::shared_ptr<Timer> trafficTimer_;
+            boost::signals2::scoped_connection loginTimerConnection_;
+            boost::signals2::scoped_connection trafficTimerConnection_;
+            std::mt19937 random_;
+            Clock::time_point loginStart_;
+            bool connected_;
+            bool stopping_;
+    };
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Examples/BenchTool/BenchScenario.h>
+
+namespace Swift {
+
+static std::string expandPattern(const std::string& pattern, int user) {
+    std::string result = pattern;
+    std::string number = std::to_string(user);
+    for (size_t i = result.find("%d"); i != std::string::npos; i = result.find("%d", i + number.size())) {
+        result.replace(i, 2, number);
+    }
+    return result;
+}
+
+std::string BenchScenario::getJID(int user) const {
+    return expandPattern(jidPattern, user);
+}
+
+std::string BenchScenario::getPassword(int user) const {
+    return expandPattern(passwordPattern, user);
+}
+
+BenchStatistics::BenchStatistics() : loginsSucceeded(0), loginsFailed(0), disconnects(0), messagesSent(0), presencesSent(0), iqsSent(0), iqErrors(0), mucMessagesSent(0), messagesReceived(0) {
+}
+
+void BenchStatistics::merge(const BenchStatistics& other) {
+    loginLatency.merge(other.loginLatency);
+    roundTripLatency.merge(other.roundTripLatency);
+    deliveryLatency.merge(other.deliveryLatency);
+    loginsSucceeded += other.loginsSucceeded;
+    loginsFailed += other.loginsFailed;
+    disconnects += other.disconnects;
+    messagesSent += other.messagesSent;
+    presencesSent += other.presencesSent;
+    iqsSent += other.iqsSent;
+    iqErrors += other.iqErrors;
+    mucMessagesSent += other.mucMessagesSent;
+    messagesReceived += other.messagesReceived;
+}
+
+}
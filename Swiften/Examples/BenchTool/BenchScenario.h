@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <Swiften/Client/ClientOptions.h>
+#include <Swiften/Examples/BenchTool/LatencyHistogram.h>
+
+namespace Swift {
+    /**
+     * What the simulated users do. Patterns may contain "%d", which is
+     * replaced by the number of the user.
+     */
+    struct BenchScenario {
+        std::string jidPattern = "user%d@localhost";
+        std::string passwordPattern = "password";
+        int firstUser = 1;
+        int userCount = 100;
+
+        double loginsPerSecond = 50;
+        int durationSeconds = 60;
+
+        // Average number of stanzas sent per second by each user, and the
+        // relative weights of the types of traffic
+        double stanzasPerSecond = 0.2;
+        int messageWeight = 60;
+        int presenceWeight = 20;
+        int iqWeight = 20;
+        int mucWeight = 0;
+
+        std::string mucService;
+        int mucRooms = 10;
+
+        ClientOptions clientOptions;
+
+        std::string getJID(int user) const;
+        std::string getPassword(int user) const;
+    };
+
+    /**
+     * Latencies are in microseconds.
+     */
+    struct BenchStatistics {
+        BenchStatistics();
+
+        void merge(const BenchStatistics& other);
+
+        LatencyHistogram loginLatency;
+        LatencyHistogram roundTripLatency;
+        LatencyHistogram deliveryLatency;
+
+        uint64_t loginsSucceeded;
+        uint64_t loginsFailed;
+        uint64_t disconnects;
+        uint64_t messagesSent;
+        uint64_t presencesSent;
+        uint64_t iqsSent;
+        uint64_t iqErrors;
+        uint64_t mucMessagesSent;
+        uint64_t messagesReceived;
+    };
+}
@@ -1,67 +1,308 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
+/*
+ * A load generator that logs in a range of users and lets them send a mix of
+ * messages, presences, IQs and MUC messages, and reports the latency of
+ * logins, IQ round trips and message delivery.
+ *
+ * The users are spread over a number of threads, each with its own event
+ * loop. To run it against a local Limber, start Limber with the same number
+ * of users, e.g.
+ *
+ *   limber --users 1000
+ *   BenchTool --users 1000 --host localhost --no-tls --allow-plain-without-tls
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/program_options.hpp>
 
-#include <Swiften/Base/sleep.h>
-#include <Swiften/Client/Client.h>
-#include <Swiften/Client/ClientXMLTracer.h>
-#include <Swiften/EventLoop/EventLoop.h>
 #include <Swiften/EventLoop/SimpleEventLoop.h>
+#include <Swiften/Examples/BenchTool/BenchClient.h>
+#include <Swiften/Examples/BenchTool/BenchScenario.h>
 #include <Swiften/Network/BoostNetworkFactories.h>
 #include <Swiften/Network/TimerFactory.h>
-#include <Swiften/Roster/GetRosterRequest.h>
 #include <Swiften/TLS/BlindCertificateTrustChecker.h>
 
 using namespace Swift;
 
-static SimpleEventLoop eventLoop;
-static BoostNetworkFactories networkFactories(&eventLoop);
-static int numberOfConnectedClients = 0;
-static int numberOfInstances = 100;
+namespace {
+    class BenchWorker : public boost::noncopyable {
+        public:
+            BenchWorker(const BenchScenario& scenario, CertificateTrustChecker* trustChecker) : scenario_(scenario), trustChecker_(trustChecker), networkFactories_(&eventLoop_) {
+            }
+
+            void addClient(int user, int loginDelayMilliseconds) {
+                clients_.push_back(std::unique_ptr<BenchClient>(new BenchClient(user, scenario_, &networkFactories_, trustChecker_, &statistics_)));
+                clients_.back()->start(loginDelayMilliseconds);
+            }
+
+            void start() {
+                thread_ = std::thread(boost::bind(&SimpleEventLoop::run, &eventLoop_));
+            }
+
+            void stop() {
+                eventLoop_.postEvent(boost::bind(&BenchWorker::handleStop, this));
+            }
+
+            void join() {
+                thread_.join();
+            }
+
+            const BenchStatistics& getStatistics() const {
+                return statistics_;
+            }
+
+        private:
+            void handleStop() {
+                for (auto& client : clients_) {
+                    client->stop();
+                }
+                // Give the clients some time to close their streams
+                stopTimer_ = networkFactories_.getTimerFactory()->createTimer(1000);
+                stopTimer_->onTick.connect(boost::bind(&SimpleEventLoop::stop, &eventLoop_));
+                stopTimer_->start();
+            }
+
+        private:
+            const BenchScenario& scenario_;
+            CertificateTrustChecker* trustChecker_;
+            SimpleEventLoop eventLoop_;
+            BoostNetworkFactories networkFactories_;
+            BenchStatistics statistics_;
+            std::vector< std::unique_ptr<BenchClient> > clients_;
+            std::shared_ptr<Timer> stopTimer_;
+            std::thread thread_;
+    };
+
+    struct Metric {
+        Metric(const std::string& name, const LatencyHistogram& histogram) : name(name), histogram(histogram) {}
+
+        std::string name;
+        const LatencyHistogram& histogram;
+    };
+
+    struct Counter {
+        Counter(const std::string& name, uint64_t value) : name(name), value(value) {}
+
+        std::string name;
+        uint64_t value;
+    };
+}
+
+static const double Percentiles[] = { 50, 90, 99, 99.9 };
+
+static std::string getPercentileName(double percentile) {
+    std::string result = std::to_string(percentile);
+    result.erase(result.find_last_not_of('0') + 1);
+    if (result.back() == '.') {
+        result.erase(result.size() - 1);
+    }
+    return "p" + result;
+}
+
+static void writeText(std::ostream& out, double seconds, const std::vector<Counter>& counters, const std::vector<Metric>& metrics) {
+    out << "Ran for " << std::fixed << std::setprecision(1) << seconds << " s" << std::endl;
+    for (const auto& counter : counters) {
+        out << std::left << std::setw(20) << counter.name << std::right << std::setw(12) << counter.value << std::endl;
+    }
+    out << std::endl << std::left << std::setw(20) << "latency (us)" << std::right << std::setw(10) << "count" << std::setw(10) << "min" << std::setw(10) << "mean";
+    for (double percentile : Percentiles) {
+        out << std::setw(10) << getPercentileName(percentile);
+    }
+    out << std::setw(10) << "max" << std::endl;
+    for (const auto& metric : metrics) {
+        out << std::left << std::setw(20) << metric.name << std::right << std::setw(10) << metric.histogram.getCount() << std::setw(10) << metric.histogram.getMin() << std::setw(10) << std::setprecision(0) << metric.histogram.getMean();
+        for (double percentile : Percentiles) {
+            out << std::setw(10) << metric.histogram.getValueAtPercentile(percentile);
+        }
+        out << std::setw(10) << metric.histogram.getMax() << std::endl;
+    }
+}
 
+static void writeCSV(std::ostream& out, double seconds, const std::vector<Counter>& counters, const std::vector<Metric>& metrics) {
+    out << "metric,count,min_us,mean_us";
+    for (double percentile : Percentiles) {
+        out << "," << getPercentileName(percentile) << "_us";
+    }
+    out << ",max_us" << std::endl;
+    out << "duration_s," << std::fixed << std::setprecision(3) << seconds << std::endl;
+    for (const auto& counter : counters) {
+        out << counter.name << "," << counter.value << std::endl;
+    }
+    for (const auto& metric : metrics) {
+        out << metric.name << "," << metric.histogram.getCount() << "," << metric.histogram.getMin() << "," << std::setprecision(1) << metric.histogram.getMean();
+        for (double percentile : Percentiles) {
+            out << "," << metric.histogram.getValueAtPercentile(percentile);
+        }
+        out << "," << metric.histogram.getMax() << std::endl;
+    }
+}
 
-static void handleConnected() {
-    numberOfConnectedClients++;
-    std::cout << "Connected " << numberOfConnectedClients << std::endl;
+static void writeJSON(std::ostream& out, double seconds, const std::vector<Counter>& counters, const std::vector<Metric>& metrics) {
+    out << "{" << std::endl << "  \"duration_s\": " << std::fixed << std::setprecision(3) << seconds << "," << std::endl;
+    out << "  \"counters\": {";
+    for (size_t i = 0; i < counters.size(); ++i) {
+        out << (i ? "," : "") << std::endl << "    \"" << counters[i].name << "\": " << counters[i].value;
+    }
+    out << std::endl << "  }," << std::endl << "  \"latencies_us\": {";
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        const LatencyHistogram& histogram = metrics[i].histogram;
+        out << (i ? "," : "") << std::endl << "    \"" << metrics[i].name << "\": {"
+            << "\"count\": " << histogram.getCount()
+            << ", \"min\": " << histogram.getMin()
+            << ", \"mean\": " << std::setprecision(1) << histogram.getMean();
+        for (double percentile : Percentiles) {
+            out << ", \"" << getPercentileName(percentile) << "\": " << histogram.getValueAtPercentile(percentile);
+        }
+        out << ", \"max\": " << histogram.getMax() << "}";
+    }
+    out << std::endl << "  }" << std::endl << "}" << std::endl;
 }
 
-int main(int, char**) {
-    char* jid = getenv("SWIFT_BENCHTOOL_JID");
-    if (!jid) {
-        std::cerr << "Please set the SWIFT_BENCHTOOL_JID environment variable" << std::endl;
+int main(int argc, char* argv[]) {
+    BenchScenario scenario;
+    // The environment variables of the original tool are still used as defaults
+    if (char* jid = getenv("SWIFT_BENCHTOOL_JID")) {
+        scenario.jidPattern = jid;
+    }
+    if (char* password = getenv("SWIFT_BENCHTOOL_PASS")) {
+        scenario.passwordPattern = password;
+    }
+    int threadCount = 0;
+    std::string host;
+    int port = -1;
+    std::string format;
+    std::string outputFile;
+
+    boost::program_options::options_description desc("Options");
+    desc.add_options()
+        ("help", "Show this help message")
+        ("jid", boost::program_options::value<std::string>(&scenario.jidPattern)->default_value(scenario.jidPattern), "JID of the users, with %d replaced by the number of the user")
+        ("password", boost::program_options::value<std::string>(&scenario.passwordPattern)->default_value(scenario.passwordPattern), "Password of the users, with %d replaced by the number of the user")
+        ("first-user", boost::program_options::value<int>(&scenario.firstUser)->default_value(scenario.firstUser), "Number of the first user")
+        ("users", boost::program_options::value<int>(&scenario.userCount)->default_value(scenario.userCount), "Number of users")
+        ("login-rate", boost::program_options::value<double>(&scenario.loginsPerSecond)->default_value(scenario.loginsPerSecond), "Number of users that log in per second")
+        ("duration", boost::program_options::value<int>(&scenario.durationSeconds)->default_value(scenario.durationSeconds), "Number of seconds to run after all users started logging in")
+        ("rate", boost::program_options::value<double>(&scenario.stanzasPerSecond)->default_value(scenario.stanzasPerSecond), "Average number of stanzas sent per second by each user")
+        ("message-weight", boost::program_options::value<int>(&scenario.messageWeight)->default_value(scenario.messageWeight), "Relative amount of chat messages to other users")
+        ("presence-weight", boost::program_options::value<int>(&scenario.presenceWeight)->default_value(scenario.presenceWeight), "Relative amount of presence changes")
+        ("iq-weight", boost::program_options::value<int>(&scenario.iqWeight)->default_value(scenario.iqWeight), "Relative amount of IQ requests to the server")
+        ("muc-weight", boost::program_options::value<int>(&scenario.mucWeight)->default_value(scenario.mucWeight), "Relative amount of MUC messages")
+        ("muc-service", boost::program_options::value<std::string>(&scenario.mucService), "MUC service to join rooms on")
+        ("muc-rooms", boost::program_options::value<int>(&scenario.mucRooms)->default_value(scenario.mucRooms), "Number of rooms the users are spread over")
+        ("host", boost::program_options::value<std::string>(&host), "Host to connect to, instead of looking up the domain of the users")
+        ("port", boost::program_options::value<int>(&port), "Port to connect to")
+        ("no-tls", "Do not use TLS")
+        ("allow-plain-without-tls", "Allow PLAIN authentication without TLS")
+        ("threads", boost::program_options::value<int>(&threadCount), "Number of event loop threads (default: number of processors)")
+        ("format", boost::program_options::value<std::string>(&format)->default_value("text"), "Output format: text, csv or json")
+        ("output", boost::program_options::value<std::string>(&outputFile), "File to write the results to, instead of stdout")
+        ;
+    boost::program_options::variables_map vm;
+    try {
+        boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
+        boost::program_options::notify(vm);
+    }
+    catch (const boost::program_options::error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
         return -1;
     }
-    char* pass = getenv("SWIFT_BENCHTOOL_PASS");
-    if (!pass) {
-        std::cerr << "Please set the SWIFT_BENCHTOOL_PASS environment variable" << std::endl;
+    if (vm.count("help") > 0) {
+        std::cout << "Usage: " << argv[0] << " [OPTIONS]" << std::endl << desc << std::endl;
+        return 0;
+    }
+    if (format != "text" && format != "csv" && format != "json") {
+        std::cerr << "Error: Unknown output format " << format << std::endl;
         return -1;
     }
+    if (scenario.userCount <= 0 || scenario.loginsPerSecond <= 0 || !JID(scenario.getJID(scenario.firstUser)).isValid()) {
+        std::cerr << "Error: Invalid users" << std::endl;
+        return -1;
+    }
+    scenario.clientOptions.manualHostname = host;
+    scenario.clientOptions.manualPort = port;
+    if (vm.count("no-tls") > 0) {
+        scenario.clientOptions.useTLS = ClientOptions::NeverUseTLS;
+    }
+    scenario.clientOptions.allowPLAINWithoutTLS = vm.count("allow-plain-without-tls") > 0;
+    if (threadCount <= 0) {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
 
     BlindCertificateTrustChecker trustChecker;
-    std::vector<CoreClient*> clients;
-    for (int i = 0; i < numberOfInstances; ++i) {
-        CoreClient* client = new Swift::CoreClient(JID(jid), createSafeByteArray(std::string(pass)), &networkFactories);
-        client->setCertificateTrustChecker(&trustChecker);
-        client->onConnected.connect(&handleConnected);
-        clients.push_back(client);
+    std::vector< std::unique_ptr<BenchWorker> > workers;
+    for (int i = 0; i < threadCount; ++i) {
+        workers.push_back(std::unique_ptr<BenchWorker>(new BenchWorker(scenario, &trustChecker)));
+    }
+    for (int i = 0; i < scenario.userCount; ++i) {
+        int loginDelay = static_cast<int>(i * 1000.0 / scenario.loginsPerSecond);
+        workers[static_cast<size_t>(i % threadCount)]->addClient(scenario.firstUser + i, loginDelay);
     }
 
-    for (auto& client : clients) {
-        client->connect();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (auto& worker : workers) {
+        worker->start();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(scenario.userCount * 1000.0 / scenario.loginsPerSecond)) + std::chrono::seconds(scenario.durationSeconds));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (auto& worker : workers) {
+        worker->stop();
+    }
+    BenchStatistics statistics;
+    for (auto& worker : workers) {
+        worker->join();
+        statistics.merge(worker->getStatistics());
     }
 
-    eventLoop.run();
+    std::vector<Counter> counters;
+    counters.push_back(Counter("logins_succeeded", statistics.loginsSucceeded));
+    counters.push_back(Counter("logins_failed", statistics.loginsFailed));
+    counters.push_back(Counter("disconnects", statistics.disconnects));
+    counters.push_back(Counter("messages_sent", statistics.messagesSent));
+    counters.push_back(Counter("presences_sent", statistics.presencesSent));
+    counters.push_back(Counter("iqs_sent", statistics.iqsSent));
+    counters.push_back(Counter("iq_errors", statistics.iqErrors));
+    counters.push_back(Counter("muc_messages_sent", statistics.mucMessagesSent));
+    counters.push_back(Counter("messages_received", statistics.messagesReceived));
+    std::vector<Metric> metrics;
+    metrics.push_back(Metric("login", statistics.loginLatency));
+    metrics.push_back(Metric("round_trip", statistics.roundTripLatency));
+    metrics.push_back(Metric("delivery", statistics.deliveryLatency));
 
-    for (auto& client : clients) {
-        delete client;
+    std::ofstream file;
+    if (!outputFile.empty()) {
+        file.open(outputFile.c_str());
+        if (!file) {
+            std::cerr << "Error: Unable to write " << outputFile << std::endl;
+            return -1;
+        }
     }
-
-    return 0;
+    std::ostream& out = outputFile.empty() ? std::cout : file;
+    if (format == "csv") {
+        writeCSV(out, seconds, counters, metrics);
+    }
+    else if (format == "json") {
+        writeJSON(out, seconds, counters, metrics);
+    }
+    else {
+        writeText(out, seconds, counters, metrics);
+    }
+    return statistics.loginsSucceeded > 0 ? 0 : 1;
 }
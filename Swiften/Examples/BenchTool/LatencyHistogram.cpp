@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Examples/BenchTool/LatencyHistogram.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Swift {
+
+static const unsigned int SubBucketBits = 7;
+static const uint64_t SubBucketCount = 1 << SubBucketBits;
+
+static unsigned int getMostSignificantBit(uint64_t value) {
+    unsigned int result = 0;
+    while (value >>= 1) {
+        ++result;
+    }
+    return result;
+}
+
+LatencyHistogram::LatencyHistogram() : count_(0), min_(std::numeric_limits<uint64_t>::max()), max_(0), sum_(0) {
+}
+
+/*
+ * Values below SubBucketCount have a bucket each. Larger values are shifted
+ * right until they fit in [SubBucketCount, 2 * SubBucketCount), and every
+ * shift gets its own range of SubBucketCount buckets.
+ */
+size_t LatencyHistogram::getIndex(uint64_t value) {
+    if (value < SubBucketCount) {
+        return static_cast<size_t>(value);
+    }
+    unsigned int shift = getMostSignificantBit(value) - SubBucketBits;
+    return static_cast<size_t>(shift * SubBucketCount + (value >> shift));
+}
+
+uint64_t LatencyHistogram::getHighestValueInBucket(size_t index) {
+    if (index < 2 * SubBucketCount) {
+        return index;
+    }
+    unsigned int shift = static_cast<unsigned int>(index / SubBucketCount - 1);
+    uint64_t subBucket = index - shift * SubBucketCount;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    size_t index = getIndex(value);
+    if (index >= counts_.size()) {
+        counts_.resize(index + 1);
+    }
+    ++counts_[index];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += static_cast<double>(value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.counts_.size() > counts_.size()) {
+        counts_.resize(other.counts_.size());
+    }
+    for (size_t i = 0; i < other.counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+double LatencyHistogram::getMean() const {
+    return count_ ? sum_ / static_cast<double>(count_) : 0.0;
+}
+
+uint64_t LatencyHistogram::getValueAtPercentile(double percentile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(std::min(percentile, 100.0) / 100.0 * static_cast<double>(count_)));
+    target = std::max<uint64_t>(target, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::min(getHighestValueInBucket(i), max_);
+        }
+    }
+    return max_;
+}
+
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Swift {
+    /**
+     * A histogram of latencies with a fixed relative precision, in the style
+     * of HdrHistogram.
+     *
+     * Values below 128 are counted exactly; larger values are counted in
+     * buckets whose width is less than 1% of the value. Recording a value
+     * does not allocate memory once the histogram has seen a value of the
+     * same magnitude, so it can be used while measuring.
+     */
+    class LatencyHistogram {
+        public:
+            LatencyHistogram();
+
+            void record(uint64_t value);
+            void merge(const LatencyHistogram& other);
+
+            uint64_t getCount() const {
+                return count_;
+            }
+
+            uint64_t getMin() const {
+                return count_ ? min_ : 0;
+            }
+
+            uint64_t getMax() const {
+                return max_;
+            }
+
+            double getMean() const;
+
+            /**
+             * Returns the value below which \p percentile percent of the
+             * recorded values are, rounded up to the end of its bucket.
+             */
+            uint64_t getValueAtPercentile(double percentile) const;
+
+        private:
+            static size_t getIndex(uint64_t value);
+            static uint64_t getHighestValueInBucket(size_t index);
+
+        private:
+            std::vector<uint64_t> counts_;
+            uint64_t count_;
+            uint64_t min_;
+            uint64_t max_;
+            double sum_;
+    };
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -17,6 +17,7 @@
 #include <Swiften/Elements/DiscoInfo.h>
 #include <Swiften/Elements/Presence.h>
 #include <Swiften/EventLoop/SimpleEventLoop.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
 #include <Swiften/FileTransfer/FileTransferManager.h>
 #include <Swiften/FileTransfer/FileWriteBytestream.h>
 #include <Swiften/FileTransfer/IncomingFileTransferManager.h>
@@ -38,6 +39,7 @@ class FileReceiver {
     public:
         FileReceiver(const JID& jid, const std::string& password) : jid(jid), password(password) {
             client = new Swift::Client(jid, password, &networkFactories);
+            fileIOWorker = std::make_shared<FileIOWorker>(&eventLoop);
             client->onConnected.connect(boost::bind(&FileReceiver::handleConnected, this));
             client->onDisconnected.connect(boost::bind(&FileReceiver::handleDisconnected, this, _1));
             tracer = new ClientXMLTracer(client);
@@ -82,7 +84,8 @@ class FileReceiver {
         void handleIncomingFileTransfer(IncomingFileTransfer::ref transfer) {
             SWIFT_LOG(debug) << "foo" << std::endl;
             incomingFileTransfers.push_back(transfer);
-            std::shared_ptr<FileWriteBytestream> out = std::make_shared<FileWriteBytestream>("out");
+            std::shared_ptr<FileWriteBytestream> out = std::make_shared<FileWriteBytestream>("out", fileIOWorker);
+            out->setExpectedSize(transfer->getFileSizeInBytes());
             transfer->onFinished.connect(boost::bind(&FileReceiver::handleFileTransferFinished, this, _1, out));
             transfer->accept(out);
         }
@@ -96,8 +99,12 @@ class FileReceiver {
                 const boost::optional<FileTransferError>& error,
                 std::shared_ptr<FileWriteBytestream> out) {
             std::cout << "File transfer finished" << std::endl;
+            out->onClosed.connect(boost::bind(&FileReceiver::handleFileClosed, this, _1, error));
             out->close();
-            if (error) {
+        }
+
+        void handleFileClosed(bool closeError, const boost::optional<FileTransferError>& error) {
+            if (error || closeError) {
                 exit(-1);
             }
             else {
@@ -116,6 +123,7 @@ class FileReceiver {
         std::string password;
         Client* client;
         ClientXMLTracer* tracer;
+        FileIOWorker::ref fileIOWorker;
         std::vector<IncomingFileTransfer::ref> incomingFileTransfers;
 };
 
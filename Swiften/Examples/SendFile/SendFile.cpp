@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -18,8 +18,10 @@
 #include <Swiften/Elements/Presence.h>
 #include <Swiften/EventLoop/EventLoop.h>
 #include <Swiften/EventLoop/SimpleEventLoop.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
 #include <Swiften/FileTransfer/FileReadBytestream.h>
 #include <Swiften/FileTransfer/FileTransferManager.h>
+#include <Swiften/FileTransfer/FileTransferOptions.h>
 #include <Swiften/FileTransfer/OutgoingFileTransfer.h>
 #include <Swiften/FileTransfer/OutgoingFileTransferManager.h>
 #include <Swiften/FileTransfer/SOCKS5BytestreamServer.h>
@@ -44,6 +46,8 @@ class FileSender {
             client->onDisconnected.connect(boost::bind(&FileSender::handleDisconnected, this, _1));
             //tracer = new ClientXMLTracer(client);
             client->getEntityCapsProvider()->onCapsChanged.connect(boost::bind(&FileSender::handleCapsChanged, this, _1));
+            fileIOWorker = std::make_shared<FileIOWorker>(&eventLoop);
+            hashingWorker = std::make_shared<FileIOWorker>(&eventLoop);
         }
 
         ~FileSender() {
@@ -65,9 +69,11 @@ class FileSender {
         void handleCapsChanged(JID jid) {
             if (jid.toBare() == recipient) {
                 // create ReadBytestream from file
-                std::shared_ptr<FileReadBytestream> fileStream = std::make_shared<FileReadBytestream>(file);
+                std::shared_ptr<FileReadBytestream> fileStream = std::make_shared<FileReadBytestream>(file, fileIOWorker);
 
-                outgoingFileTransfer = client->getFileTransferManager()->createOutgoingFileTransfer(recipient, file, "Some File!", fileStream);
+                // hash the file in the background, so the hashes can be sent along with the offer
+                FileTransferOptions options = FileTransferOptions().withHashAlgorithms({"sha-256", "sha-1"}).withHashingWorker(hashingWorker);
+                outgoingFileTransfer = client->getFileTransferManager()->createOutgoingFileTransfer(recipient, file, "Some File!", fileStream, options);
 
                 if (outgoingFileTransfer) {
                     outgoingFileTransfer->onFinished.connect(boost::bind(&FileSender::handleFileTransferFinished, this, _1));
@@ -117,6 +123,8 @@ class FileSender {
         boost::filesystem::path file;
         ClientXMLTracer* tracer;
         std::unique_ptr<Swift::Client> client;
+        FileIOWorker::ref fileIOWorker;
+        FileIOWorker::ref hashingWorker;
 };
 
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/FileTransfer/FileHashCalculator.h>
+
+#include <atomic>
+
+#include <boost/bind.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/numeric/conversion/cast.hpp>
+
+#include <Swiften/FileTransfer/IncrementalBytestreamHashCalculator.h>
+
+namespace Swift {
+
+static const size_t READ_BLOCK_SIZE = 1024 * 1024;
+
+/**
+ * The state of a calculation. The calculator is only accessed from the
+ * worker thread, the owner only from the event loop thread.
+ */
+struct FileHashCalculator::Job {
+    Job(const boost::filesystem::path& file, const std::vector<std::string>& algorithms, CryptoProvider* crypto) : owner(nullptr), file(file), calculator(algorithms, crypto), canceled(false), error(false) {
+    }
+
+    FileHashCalculator* owner;
+    boost::filesystem::path file;
+    IncrementalBytestreamHashCalculator calculator;
+    std::map<std::string, ByteArray> hashes;
+    std::atomic<bool> canceled;
+    bool error;
+};
+
+FileHashCalculator::FileHashCalculator(const boost::filesystem::path& file, const std::vector<std::string>& algorithms, CryptoProvider* crypto, FileIOWorker::ref worker) : worker(worker), finished(false) {
+    job = std::make_shared<Job>(file, algorithms, crypto);
+    job->owner = this;
+}
+
+FileHashCalculator::~FileHashCalculator() {
+    stop();
+}
+
+void FileHashCalculator::start() {
+    worker->post(
+            boost::bind(&FileHashCalculator::hashFile, job),
+            boost::bind(&FileHashCalculator::handleFileHashed, job));
+}
+
+void FileHashCalculator::stop() {
+    job->owner = nullptr;
+    job->canceled = true;
+}
+
+void FileHashCalculator::hashFile(std::shared_ptr<Job> job) {
+    boost::filesystem::ifstream stream(job->file, std::ios_base::in|std::ios_base::binary);
+    if (!stream.is_open()) {
+        job->error = true;
+        return;
+    }
+    ByteArray block(READ_BLOCK_SIZE);
+    while (!job->canceled && stream.good()) {
+        stream.read(reinterpret_cast<char*>(vecptr(block)), boost::numeric_cast<std::streamsize>(block.size()));
+        if (stream.bad()) {
+            job->error = true;
+            return;
+        }
+        if (stream.gcount() < boost::numeric_cast<std::streamsize>(block.size())) {
+            block.resize(boost::numeric_cast<size_t>(stream.gcount()));
+        }
+        job->calculator.feedData(block);
+    }
+    if (!job->canceled) {
+        job->hashes = job->calculator.getHashes();
+    }
+}
+
+void FileHashCalculator::handleFileHashed(std::shared_ptr<Job> job) {
+    FileHashCalculator* owner = job->owner;
+    if (!owner) {
+        return;
+    }
+    owner->finished = true;
+    if (job->error) {
+        owner->onFinished(FileTransferError(FileTransferError::ReadError));
+    }
+    else {
+        owner->hashes = job->hashes;
+        owner->onFinished(boost::optional<FileTransferError>());
+    }
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+#include <boost/signals2.hpp>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Base/ByteArray.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
+#include <Swiften/FileTransfer/FileTransferError.h>
+
+namespace Swift {
+    class CryptoProvider;
+
+    /**
+     * Calculates the hashes of a file on a worker thread, e.g. to have the
+     * hashes of an outgoing file available before it is offered.
+     */
+    class SWIFTEN_API FileHashCalculator {
+        public:
+            typedef std::shared_ptr<FileHashCalculator> ref;
+
+            /**
+             * Creates a calculator for all \p algorithms (using their
+             * XEP-0300 names) that are supported by \p crypto.
+             */
+            FileHashCalculator(const boost::filesystem::path& file, const std::vector<std::string>& algorithms, CryptoProvider* crypto, FileIOWorker::ref worker);
+            ~FileHashCalculator();
+
+            void start();
+
+            /**
+             * Stops calculating. \ref onFinished will not be emitted anymore.
+             */
+            void stop();
+
+            bool isFinished() const {
+                return finished;
+            }
+
+            /**
+             * Returns the calculated hashes by algorithm name, or an empty map
+             * if the calculation did not finish successfully.
+             */
+            const std::map<std::string, ByteArray>& getHashes() const {
+                return hashes;
+            }
+
+        public:
+            boost::signals2::signal<void (boost::optional<FileTransferError>)> onFinished;
+
+        private:
+            struct Job;
+
+            static void hashFile(std::shared_ptr<Job> job);
+            static void handleFileHashed(std::shared_ptr<Job> job);
+
+        private:
+            std::shared_ptr<Job> job;
+            FileIOWorker::ref worker;
+            bool finished;
+            std::map<std::string, ByteArray> hashes;
+    };
+}
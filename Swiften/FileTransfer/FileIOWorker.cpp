@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/FileTransfer/FileIOWorker.h>
+
+#include <boost/bind.hpp>
+
+#include <Swiften/EventLoop/EventLoop.h>
+#include <Swiften/EventLoop/EventOwner.h>
+
+namespace Swift {
+
+FileIOWorker::FileIOWorker(EventLoop* eventLoop) : eventLoop(eventLoop), eventOwner(std::make_shared<EventOwner>()), stopRequested(false), thread(boost::bind(&FileIOWorker::run, this)) {
+}
+
+FileIOWorker::~FileIOWorker() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopRequested = true;
+    }
+    queueNonEmpty.notify_one();
+    thread.join();
+    eventLoop->removeEventsFromOwner(eventOwner);
+}
+
+void FileIOWorker::post(boost::function<void ()> job, boost::function<void ()> completion) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(Job(job, completion));
+    }
+    queueNonEmpty.notify_one();
+}
+
+void FileIOWorker::run() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while (queue.empty() && !stopRequested) {
+                queueNonEmpty.wait(lock);
+            }
+            // Drain the queue before stopping, so no pending writes get lost
+            if (queue.empty()) {
+                return;
+            }
+            job = queue.front();
+            queue.pop_front();
+        }
+        job.first();
+        if (job.second) {
+            eventLoop->postEvent(job.second, eventOwner);
+        }
+    }
+}
+
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <boost/function.hpp>
+
+#include <Swiften/Base/API.h>
+
+namespace Swift {
+    class EventLoop;
+    class EventOwner;
+
+    /**
+     * The FileIOWorker runs blocking jobs (disk reads and writes, hashing)
+     * on a dedicated thread, so they do not stall the event loop.
+     *
+     * Jobs are executed in the order they were posted. The completion
+     * callback of a job is posted back to the event loop after the job
+     * has finished.
+     *
+     * All jobs that were posted before the worker is destroyed are still
+     * executed, but completions that did not get to run yet are dropped.
+     */
+    class SWIFTEN_API FileIOWorker {
+        public:
+            typedef std::shared_ptr<FileIOWorker> ref;
+
+            FileIOWorker(EventLoop* eventLoop);
+            ~FileIOWorker();
+
+            /**
+             * Runs \p job on the worker thread, and afterwards \p completion
+             * (if any) on the event loop thread.
+             */
+            void post(boost::function<void ()> job, boost::function<void ()> completion = boost::function<void ()>());
+
+            EventLoop* getEventLoop() const {
+                return eventLoop;
+            }
+
+        private:
+            void run();
+
+        private:
+            typedef std::pair<boost::function<void ()>, boost::function<void ()> > Job;
+
+            EventLoop* eventLoop;
+            std::shared_ptr<EventOwner> eventOwner;
+            bool stopRequested;
+            std::deque<Job> queue;
+            std::mutex queueMutex;
+            std::condition_variable queueNonEmpty;
+            // Declared last, so the thread only starts when the queue is set up
+            std::thread thread;
+    };
+}
@@ -1,25 +1,61 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/FileTransfer/FileReadBytestream.h>
 
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 
 #include <Swiften/Base/ByteArray.h>
+#include <Swiften/FileTransfer/BytestreamException.h>
 
 namespace Swift {
 
-FileReadBytestream::FileReadBytestream(const boost::filesystem::path& file) : file(file), stream(nullptr) {
+/**
+ * The back buffer of the read-ahead. While a block read is pending, the
+ * stream and block are only accessed from the worker thread; otherwise,
+ * everything is only accessed from the event loop thread.
+ */
+struct FileReadBytestream::ReadAheadBuffer {
+    ReadAheadBuffer(const boost::filesystem::path& file, size_t blockSize) : owner(nullptr), file(file), blockSize(blockSize), stream(nullptr), pending(false), finished(false), error(false) {
+    }
+
+    ~ReadAheadBuffer() {
+        delete stream;
+    }
+
+    FileReadBytestream* owner;
+    boost::filesystem::path file;
+    size_t blockSize;
+    boost::filesystem::ifstream* stream;
+    ByteArray block;
+    bool pending;
+    bool finished;
+    bool error;
+};
+
+FileReadBytestream::FileReadBytestream(const boost::filesystem::path& file) : file(file), stream(nullptr), currentBlockOffset(0), waitingForData(false) {
+}
+
+FileReadBytestream::FileReadBytestream(const boost::filesystem::path& file, FileIOWorker::ref worker, size_t readAheadSize) : file(file), stream(nullptr), worker(worker), currentBlockOffset(0), waitingForData(false) {
+    assert(readAheadSize > 0);
+    readAhead = std::make_shared<ReadAheadBuffer>(file, readAheadSize);
+    readAhead->owner = this;
+    startReadAhead();
 }
 
 FileReadBytestream::~FileReadBytestream() {
+    if (readAhead) {
+        readAhead->owner = nullptr;
+    }
     if (stream) {
         stream->close();
         delete stream;
@@ -28,20 +64,87 @@ FileReadBytestream::~FileReadBytestream() {
 }
 
 std::shared_ptr<ByteArray> FileReadBytestream::read(size_t size)  {
-    if (!stream) {
-        stream = new boost::filesystem::ifstream(file, std::ios_base::in|std::ios_base::binary);
-    }
     std::shared_ptr<ByteArray> result = std::make_shared<ByteArray>();
-    result->resize(size);
-    assert(stream->good());
-    stream->read(reinterpret_cast<char*>(vecptr(*result)), boost::numeric_cast<std::streamsize>(size));
-    result->resize(boost::numeric_cast<size_t>(stream->gcount()));
+    if (!readAhead) {
+        if (!stream) {
+            stream = new boost::filesystem::ifstream(file, std::ios_base::in|std::ios_base::binary);
+        }
+        result->resize(size);
+        assert(stream->good());
+        stream->read(reinterpret_cast<char*>(vecptr(*result)), boost::numeric_cast<std::streamsize>(size));
+        result->resize(boost::numeric_cast<size_t>(stream->gcount()));
+        onRead(*result);
+        return result;
+    }
+
+    if (currentBlockOffset == currentBlock.size() && !readAhead->pending) {
+        if (readAhead->error) {
+            throw BytestreamException();
+        }
+        if (!readAhead->block.empty()) {
+            // Swap buffers, and let the worker fill the one we just drained
+            currentBlock.swap(readAhead->block);
+            readAhead->block.clear();
+            currentBlockOffset = 0;
+            if (!readAhead->finished) {
+                startReadAhead();
+            }
+        }
+    }
+
+    size_t available = currentBlock.size() - currentBlockOffset;
+    if (available == 0) {
+        waitingForData = !isFinished();
+        return result;
+    }
+    size_t count = std::min(size, available);
+    result->assign(currentBlock.begin() + boost::numeric_cast<ptrdiff_t>(currentBlockOffset), currentBlock.begin() + boost::numeric_cast<ptrdiff_t>(currentBlockOffset + count));
+    currentBlockOffset += count;
     onRead(*result);
     return result;
 }
 
 bool FileReadBytestream::isFinished() const {
-    return stream && !stream->good();
+    if (!readAhead) {
+        return stream && !stream->good();
+    }
+    return currentBlockOffset == currentBlock.size() && !readAhead->pending && readAhead->finished && readAhead->block.empty();
+}
+
+void FileReadBytestream::startReadAhead() {
+    readAhead->pending = true;
+    worker->post(
+            boost::bind(&FileReadBytestream::readBlock, readAhead),
+            boost::bind(&FileReadBytestream::handleBlockRead, readAhead));
+}
+
+void FileReadBytestream::readBlock(std::shared_ptr<ReadAheadBuffer> buffer) {
+    if (!buffer->stream) {
+        buffer->stream = new boost::filesystem::ifstream(buffer->file, std::ios_base::in|std::ios_base::binary);
+        if (!buffer->stream->is_open()) {
+            buffer->error = true;
+            return;
+        }
+    }
+    buffer->block.resize(buffer->blockSize);
+    buffer->stream->read(reinterpret_cast<char*>(vecptr(buffer->block)), boost::numeric_cast<std::streamsize>(buffer->blockSize));
+    buffer->block.resize(boost::numeric_cast<size_t>(buffer->stream->gcount()));
+    if (buffer->stream->bad()) {
+        buffer->error = true;
+    }
+    else if (!buffer->stream->good()) {
+        buffer->finished = true;
+        buffer->stream->close();
+    }
+}
+
+void FileReadBytestream::handleBlockRead(std::shared_ptr<ReadAheadBuffer> buffer) {
+    buffer->pending = false;
+    FileReadBytestream* owner = buffer->owner;
+    if (owner && owner->waitingForData) {
+        owner->waitingForData = false;
+        owner->onDataAvailable();
+    }
 }
 
 }
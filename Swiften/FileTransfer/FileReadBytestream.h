@@ -1,28 +1,59 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <memory>
+
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/path.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
 #include <Swiften/FileTransfer/ReadBytestream.h>
 
 namespace Swift {
     class SWIFTEN_API FileReadBytestream : public ReadBytestream {
         public:
+            /**
+             * Creates a bytestream that reads synchronously from \p file on
+             * every call to \ref read.
+             */
             FileReadBytestream(const boost::filesystem::path& file);
+
+            /**
+             * Creates a bytestream that reads ahead from \p file on the
+             * \p worker thread, in blocks of \p readAheadSize bytes.
+             *
+             * While one block is consumed by \ref read, the next one is read
+             * from disk. If no data is buffered, \ref read returns an empty
+             * vector and \ref onDataAvailable is emitted once the next block
+             * is available.
+             */
+            FileReadBytestream(const boost::filesystem::path& file, FileIOWorker::ref worker, size_t readAheadSize = 256 * 1024);
             virtual ~FileReadBytestream();
 
             virtual std::shared_ptr< std::vector<unsigned char> > read(size_t size);
             virtual bool isFinished() const;
 
+        private:
+            struct ReadAheadBuffer;
+
+            void startReadAhead();
+            static void readBlock(std::shared_ptr<ReadAheadBuffer> buffer);
+            static void handleBlockRead(std::shared_ptr<ReadAheadBuffer> buffer);
+
         private:
             boost::filesystem::path file;
             boost::filesystem::ifstream* stream;
+
+            FileIOWorker::ref worker;
+            std::shared_ptr<ReadAheadBuffer> readAhead;
+            std::vector<unsigned char> currentBlock;
+            size_t currentBlockOffset;
+            bool waitingForData;
     };
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -54,7 +54,8 @@ FileTransferManagerImpl::FileTransferManagerImpl(
         CryptoProvider* crypto) :
             iqRouter(router),
             capsProvider(capsProvider),
-            presenceOracle(presOracle) {
+            presenceOracle(presOracle),
+            crypto(crypto) {
     bytestreamRegistry = new SOCKS5BytestreamRegistry();
     s5bServerManager = new SOCKS5BytestreamServerManager(
             bytestreamRegistry, connectionServerFactory, networkEnvironment, natTraverser);
@@ -113,7 +114,17 @@ OutgoingFileTransfer::ref FileTransferManagerImpl::createOutgoingFileTransfer(
 
     boost::uintmax_t sizeInBytes = boost::filesystem::file_size(filepath);
     boost::posix_time::ptime lastModified = boost::posix_time::from_time_t(boost::filesystem::last_write_time(filepath));
-    return createOutgoingFileTransfer(to, filename, description, sizeInBytes, lastModified, bytestream, config);
+
+    // Start hashing the file right away, so the hashes can be part of the offer
+    FileHashCalculator::ref precomputedHashes;
+    if (config.getHashingWorker()) {
+        precomputedHashes = std::make_shared<FileHashCalculator>(filepath, config.getHashAlgorithms(), crypto, config.getHashingWorker());
+    }
+    OutgoingFileTransfer::ref transfer = createOutgoingFileTransfer(to, filename, description, sizeInBytes, lastModified, bytestream, config, precomputedHashes);
+    if (transfer && precomputedHashes) {
+        precomputedHashes->start();
+    }
+    return transfer;
 }
 
 OutgoingFileTransfer::ref FileTransferManagerImpl::createOutgoingFileTransfer(
@@ -124,6 +135,18 @@ OutgoingFileTransfer::ref FileTransferManagerImpl::createOutgoingFileTransfer(
         const boost::posix_time::ptime& lastModified,
         std::shared_ptr<ReadBytestream> bytestream,
         const FileTransferOptions& config) {
+    return createOutgoingFileTransfer(to, filename, description, sizeInBytes, lastModified, bytestream, config, FileHashCalculator::ref());
+}
+
+OutgoingFileTransfer::ref FileTransferManagerImpl::createOutgoingFileTransfer(
+        const JID& to,
+        const std::string& filename,
+        const std::string& description,
+        const boost::uintmax_t sizeInBytes,
+        const boost::posix_time::ptime& lastModified,
+        std::shared_ptr<ReadBytestream> bytestream,
+        const FileTransferOptions& config,
+        FileHashCalculator::ref precomputedHashes) {
     JingleFileTransferFileInfo fileInfo;
     fileInfo.setDate(lastModified);
     fileInfo.setSize(sizeInBytes);
@@ -159,7 +182,7 @@ OutgoingFileTransfer::ref FileTransferManagerImpl::createOutgoingFileTransfer(
         SWIFT_LOG(warning) << "No entity capabilities information for " << receipient.toString() << std::endl;
     }
 
-    return outgoingFTManager->createOutgoingFileTransfer(iqRouter->getJID(), receipient, bytestream, fileInfo, options);
+    return outgoingFTManager->createOutgoingFileTransfer(iqRouter->getJID(), receipient, bytestream, fileInfo, options, precomputedHashes);
 }
 
 }
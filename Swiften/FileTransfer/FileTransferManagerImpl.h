@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2017 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -23,6 +23,7 @@
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/IDGenerator.h>
 #include <Swiften/Elements/S5BProxyRequest.h>
+#include <Swiften/FileTransfer/FileHashCalculator.h>
 #include <Swiften/FileTransfer/FileTransferManager.h>
 #include <Swiften/FileTransfer/FileTransferOptions.h>
 #include <Swiften/FileTransfer/IncomingFileTransfer.h>
@@ -85,6 +86,15 @@ namespace Swift {
             void stop();
 
         private:
+            OutgoingFileTransfer::ref createOutgoingFileTransfer(
+                    const JID& to,
+                    const std::string& filename,
+                    const std::string& description,
+                    const boost::uintmax_t sizeInBytes,
+                    const boost::posix_time::ptime& lastModified,
+                    std::shared_ptr<ReadBytestream> bytestream,
+                    const FileTransferOptions&,
+                    FileHashCalculator::ref precomputedHashes);
             boost::optional<JID> highestPriorityJIDSupportingFileTransfer(const JID& bareJID);
 
         private:
@@ -98,5 +108,6 @@ namespace Swift {
             SOCKS5BytestreamRegistry* bytestreamRegistry;
             SOCKS5BytestreamProxiesManager* bytestreamProxy;
             SOCKS5BytestreamServerManager* s5bServerManager;
+            CryptoProvider* crypto;
     };
 }
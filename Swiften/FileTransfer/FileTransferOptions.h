@@ -1,17 +1,23 @@
 /*
- * Copyright (c) 2013-2017 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <Swiften/Base/API.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
 
 namespace Swift {
     class SWIFTEN_API FileTransferOptions {
         public:
             FileTransferOptions() : allowInBand_(true), allowAssisted_(true), allowProxied_(true), allowDirect_(true) {
+                hashAlgorithms_.push_back("sha-1");
+                hashAlgorithms_.push_back("md5");
             }
             SWIFTEN_DEFAULT_COPY_CONSTRUCTOR(FileTransferOptions)
             ~FileTransferOptions();
@@ -52,6 +58,34 @@ namespace Swift {
                 return allowDirect_;
             }
 
+            /**
+             * Sets the hash algorithms (using their XEP-0300 names) that are
+             * calculated for outgoing files. Defaults to SHA-1 and MD5.
+             */
+            FileTransferOptions& withHashAlgorithms(const std::vector<std::string>& algorithms) {
+                hashAlgorithms_ = algorithms;
+                return *this;
+            }
+
+            const std::vector<std::string>& getHashAlgorithms() const {
+                return hashAlgorithms_;
+            }
+
+            /**
+             * Sets the worker on which file hashes are calculated. Without a
+             * worker, hashes are calculated on the event loop thread.
+             *
+             * For outgoing transfers of files on disk, this also calculates
+             * the hashes in the background before the file is offered.
+             */
+            FileTransferOptions& withHashingWorker(FileIOWorker::ref worker) {
+                hashingWorker_ = worker;
+                return *this;
+            }
+
+            FileIOWorker::ref getHashingWorker() const {
+                return hashingWorker_;
+            }
 
 
             SWIFTEN_DEFAULT_COPY_ASSIGMNENT_OPERATOR(FileTransferOptions)
@@ -61,5 +95,7 @@ namespace Swift {
             bool allowAssisted_;
             bool allowProxied_;
             bool allowDirect_;
+            std::vector<std::string> hashAlgorithms_;
+            FileIOWorker::ref hashingWorker_;
     };
 }
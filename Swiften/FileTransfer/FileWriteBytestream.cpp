@@ -1,51 +1,246 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/FileTransfer/FileWriteBytestream.h>
 
+#include <atomic>
 #include <cassert>
+#include <cstdio>
 
-#include <boost/filesystem/fstream.hpp>
-#include <boost/numeric/conversion/cast.hpp>
+#include <boost/bind.hpp>
+#include <boost/optional.hpp>
+
+#include <Swiften/Base/Platform.h>
+
+#if defined(SWIFTEN_PLATFORM_WINDOWS)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace Swift {
 
-FileWriteBytestream::FileWriteBytestream(const boost::filesystem::path& file) : file(file), stream(nullptr) {
+/**
+ * The file that is written to. When a worker is used, the handle is only
+ * accessed from the worker thread.
+ */
+struct FileWriteBytestream::File {
+    File(const boost::filesystem::path& path) : path(path), handle(nullptr), syncPolicy(NoSync), failed(false), owner(nullptr) {
+    }
+
+    ~File() {
+        if (handle) {
+            fclose(handle);
+        }
+    }
+
+    bool open() {
+#if defined(SWIFTEN_PLATFORM_WINDOWS)
+        handle = _wfopen(path.c_str(), L"wb");
+#else
+        handle = fopen(path.c_str(), "wb");
+#endif
+        if (!handle) {
+            return false;
+        }
+#if defined(SWIFTEN_PLATFORM_LINUX) && defined(FALLOC_FL_KEEP_SIZE)
+        if (expectedSize) {
+            // Reserve the blocks without changing the file size. Not all
+            // file systems support this, so failures are ignored.
+            fallocate(fileno(handle), FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(*expectedSize));
+        }
+#endif
+        return true;
+    }
+
+    bool write(const std::vector<unsigned char>& data) {
+        if (!handle && !open()) {
+            return false;
+        }
+        if (fwrite(&data[0], 1, data.size(), handle) != data.size()) {
+            return false;
+        }
+        return syncPolicy != SyncEveryBlock || sync();
+    }
+
+    bool sync() {
+        if (fflush(handle) != 0) {
+            return false;
+        }
+#if defined(SWIFTEN_PLATFORM_WINDOWS)
+        return _commit(_fileno(handle)) == 0;
+#else
+        return fsync(fileno(handle)) == 0;
+#endif
+    }
+
+    bool close() {
+        bool success = true;
+        if (handle) {
+            if (syncPolicy != NoSync) {
+                success = sync();
+            }
+            success = fclose(handle) == 0 && success;
+            handle = nullptr;
+        }
+        return success;
+    }
+
+    boost::filesystem::path path;
+    FILE* handle;
+    boost::optional<boost::uintmax_t> expectedSize;
+    SyncPolicy syncPolicy;
+
+    // Set from the worker thread when writing or closing the file failed
+    std::atomic<bool> failed;
+
+    // Only accessed from the event loop, and reset when the bytestream is
+    // destroyed before all blocks are written
+    FileWriteBytestream* owner;
+};
+
+FileWriteBytestream::FileWriteBytestream(const boost::filesystem::path& path) : file(std::make_shared<File>(path)), writeBehindSize(0), blocksInFlight(0), error(false), closed(false) {
+}
+
+FileWriteBytestream::FileWriteBytestream(const boost::filesystem::path& path, FileIOWorker::ref worker, size_t writeBehindSize) : file(std::make_shared<File>(path)), worker(worker), writeBehindSize(writeBehindSize), blocksInFlight(0), error(false), closed(false) {
+    assert(writeBehindSize > 0);
+    file->owner = this;
 }
 
 FileWriteBytestream::~FileWriteBytestream() {
-    if (stream) {
-        stream->close();
-        delete stream;
-        stream = nullptr;
+    file->owner = nullptr;
+    if (closed) {
+        return;
     }
+    closed = true;
+    if (!worker) {
+        file->close();
+        return;
+    }
+    // The remaining data is still written, but nobody is notified anymore
+    writeBehind();
+    worker->post(boost::bind(&FileWriteBytestream::closeFile, file));
+}
+
+void FileWriteBytestream::setExpectedSize(boost::uintmax_t size) {
+    file->expectedSize = size;
+}
+
+void FileWriteBytestream::setSyncPolicy(SyncPolicy policy) {
+    file->syncPolicy = policy;
 }
 
 bool FileWriteBytestream::write(const std::vector<unsigned char>& data) {
     if (data.empty()) {
         return true;
     }
-    if (!stream) {
-        stream = new boost::filesystem::ofstream(file, std::ios_base::out|std::ios_base::binary);
+    if (closed || error) {
+        return false;
     }
-    if (stream->good()) {
-        stream->write(reinterpret_cast<const char*>(&data[0]), boost::numeric_cast<std::streamsize>(data.size()));
-        if (stream->good()) {
-            onWrite(data);
-            return true;
+    if (!worker) {
+        if (!file->write(data)) {
+            error = true;
+            return false;
         }
+        onWrite(data);
+        return true;
+    }
+
+    if (!currentBlock) {
+        currentBlock = std::make_shared<std::vector<unsigned char> >();
+        currentBlock->reserve(writeBehindSize);
     }
-    return false;
+    currentBlock->insert(currentBlock->end(), data.begin(), data.end());
+    // Only keep one block in flight. When the disk cannot keep up, the
+    // current block keeps growing, and isWritable() asks the writer to hold
+    // back.
+    if (currentBlock->size() >= writeBehindSize && blocksInFlight == 0) {
+        writeBehind();
+    }
+    onWrite(data);
+    return true;
+}
+
+bool FileWriteBytestream::isWritable() const {
+    return !currentBlock || currentBlock->size() < writeBehindSize || blocksInFlight == 0;
 }
 
 void FileWriteBytestream::close() {
-    if (stream) {
-        stream->close();
-        delete stream;
-        stream = nullptr;
+    if (closed) {
+        return;
+    }
+    closed = true;
+    if (!worker) {
+        bool success = file->close();
+        onClosed(error || !success);
+        return;
+    }
+    writeBehind();
+    worker->post(
+            boost::bind(&FileWriteBytestream::closeFile, file),
+            boost::bind(&FileWriteBytestream::handleFileClosedOnEventLoop, file));
+}
+
+void FileWriteBytestream::writeBehind() {
+    if (!currentBlock || currentBlock->empty()) {
+        return;
+    }
+    blocksInFlight++;
+    worker->post(
+            boost::bind(&FileWriteBytestream::writeBlock, file, currentBlock),
+            boost::bind(&FileWriteBytestream::handleBlockWrittenOnEventLoop, file));
+    currentBlock.reset();
+}
+
+void FileWriteBytestream::handleBlockWritten() {
+    bool wasWritable = isWritable();
+    blocksInFlight--;
+    if (file->failed && !error) {
+        error = true;
+        onError();
+        return;
+    }
+    if (closed || error) {
+        return;
+    }
+    if (currentBlock && currentBlock->size() >= writeBehindSize) {
+        writeBehind();
+    }
+    if (!wasWritable && isWritable()) {
+        onWritable();
+    }
+}
+
+void FileWriteBytestream::handleFileClosed() {
+    error = error || file->failed;
+    onClosed(error);
+}
+
+void FileWriteBytestream::writeBlock(std::shared_ptr<File> file, std::shared_ptr<std::vector<unsigned char> > block) {
+    if (!file->failed && !file->write(*block)) {
+        file->failed = true;
+    }
+}
+
+void FileWriteBytestream::closeFile(std::shared_ptr<File> file) {
+    if (!file->close()) {
+        file->failed = true;
+    }
+}
+
+void FileWriteBytestream::handleBlockWrittenOnEventLoop(std::shared_ptr<File> file) {
+    if (file->owner) {
+        file->owner->handleBlockWritten();
+    }
+}
+
+void FileWriteBytestream::handleFileClosedOnEventLoop(std::shared_ptr<File> file) {
+    if (file->owner) {
+        file->owner->handleFileClosed();
     }
 }
 
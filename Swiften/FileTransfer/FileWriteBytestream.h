@@ -1,28 +1,116 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
-#include <boost/filesystem/fstream.hpp>
+#include <memory>
+
+#include <boost/cstdint.hpp>
 #include <boost/filesystem/path.hpp>
+#include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
 #include <Swiften/FileTransfer/WriteBytestream.h>
 
 namespace Swift {
     class SWIFTEN_API FileWriteBytestream : public WriteBytestream {
         public:
+            enum SyncPolicy {
+                NoSync,         ///< Leave flushing data to disk up to the operating system.
+                SyncOnClose,    ///< Flush all data to disk when the file is closed.
+                SyncEveryBlock  ///< Flush every written block to disk.
+            };
+
+        public:
+            /**
+             * Creates a bytestream that synchronously writes all data to
+             * \p file on every call to \ref write.
+             */
             FileWriteBytestream(const boost::filesystem::path& file);
+
+            /**
+             * Creates a bytestream that collects data in blocks of
+             * \p writeBehindSize bytes, and writes these blocks to \p file
+             * on the \p worker thread.
+             *
+             * While one block is written to disk, the next one is filled.
+             * If a new block is full before the previous one was written,
+             * the bytestream is not writable until the disk has caught up.
+             * Data that is written anyway is added to the current block, so
+             * memory use is only bounded for writers that respect
+             * \ref isWritable.
+             * Write errors are reported through \ref onError, and make the
+             * next call to \ref write fail.
+             */
+            FileWriteBytestream(const boost::filesystem::path& file, FileIOWorker::ref worker, size_t writeBehindSize = 256 * 1024);
             virtual ~FileWriteBytestream();
 
+            /**
+             * Reserves \p size bytes of disk space for the file when it is
+             * opened, e.g. using the file size advertised by the sender.
+             *
+             * Must be called before the first \ref write.
+             */
+            void setExpectedSize(boost::uintmax_t size);
+
+            /**
+             * Sets when written data is explicitly flushed to disk.
+             * Defaults to \ref NoSync.
+             */
+            void setSyncPolicy(SyncPolicy policy);
+
+            /**
+             * Writes data to the file (or to the current block).
+             *
+             * Returns false after \ref close has been called, or after a
+             * write error, instead of reopening the file.
+             */
             virtual bool write(const std::vector<unsigned char>&);
+
+            /**
+             * Closes the file. Data that is still buffered is written to disk
+             * first; \ref onClosed is emitted when the file is closed.
+             *
+             * Without a worker, the file is closed before this method returns.
+             */
             virtual void close();
 
+            virtual bool isWritable() const;
+
+        public:
+            /**
+             * Emitted when writing a block to disk failed.
+             */
+            boost::signals2::signal<void ()> onError;
+
+            /**
+             * Emitted when the file is closed. The argument is true if any of
+             * the data could not be written.
+             */
+            boost::signals2::signal<void (bool /* error */)> onClosed;
+
+        private:
+            struct File;
+
+            void writeBehind();
+            void handleBlockWritten();
+            void handleFileClosed();
+            static void writeBlock(std::shared_ptr<File> file, std::shared_ptr<std::vector<unsigned char> > block);
+            static void closeFile(std::shared_ptr<File> file);
+            static void handleBlockWrittenOnEventLoop(std::shared_ptr<File> file);
+            static void handleFileClosedOnEventLoop(std::shared_ptr<File> file);
+
         private:
-            boost::filesystem::path file;
-            boost::filesystem::ofstream* stream;
+            std::shared_ptr<File> file;
+            FileIOWorker::ref worker;
+            size_t writeBehindSize;
+            std::shared_ptr<std::vector<unsigned char> > currentBlock;
+            int blocksInFlight;
+            bool error;
+            bool closed;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,8 @@
 #include <Swiften/FileTransfer/IBBReceiveSession.h>
 
 #include <cassert>
+#include <string>
+#include <utility>
 
 #include <boost/bind.hpp>
 
@@ -31,6 +33,12 @@ class IBBReceiveSession::IBBResponder : public SetResponder<IBB> {
                         session->bytestream->write(ibb->getData());
                         receivedSize += ibb->getData().size();
                         sequenceNumber++;
+                        if (receivedSize < session->size && !session->bytestream->isWritable()) {
+                            // Hold back the response, so the sender doesn't send the next
+                            // block before the bytestream can take it
+                            deferResponse(from, id);
+                            return true;
+                        }
                         sendResponse(from, id, IBB::ref());
                         if (receivedSize >= session->size) {
                             if (receivedSize > session->size) {
@@ -60,10 +68,26 @@ class IBBReceiveSession::IBBResponder : public SetResponder<IBB> {
             return false;
         }
 
+    private:
+        void deferResponse(const JID& from, const std::string& id) {
+            deferredResponse = std::make_pair(from, id);
+            bytestreamWritableConnection = session->bytestream->onWritable.connect(boost::bind(&IBBResponder::handleBytestreamWritable, this));
+        }
+
+        void handleBytestreamWritable() {
+            bytestreamWritableConnection.disconnect();
+            if (deferredResponse && session->active) {
+                sendResponse(deferredResponse->first, deferredResponse->second, IBB::ref());
+            }
+            deferredResponse.reset();
+        }
+
     private:
         IBBReceiveSession* session;
         int sequenceNumber;
         unsigned long long receivedSize;
+        boost::optional<std::pair<JID, std::string> > deferredResponse;
+        boost::signals2::scoped_connection bytestreamWritableConnection;
 };
 
 
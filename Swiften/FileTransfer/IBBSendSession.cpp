@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -85,6 +85,9 @@ void IBBSendSession::sendMoreData() {
             currentRequest = request;
             onBytesSent(data->size());
         }
+        else if (bytestream->isFinished()) {
+            finish(boost::optional<FileTransferError>());
+        }
         else {
             waitingForData = true;
         }
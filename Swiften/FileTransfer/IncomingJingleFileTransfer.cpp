@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,6 +8,8 @@
 
 #include <memory>
 #include <set>
+#include <string>
+#include <vector>
 
 #include <boost/bind.hpp>
 
@@ -29,6 +31,57 @@
 
 using namespace Swift;
 
+// Hash algorithms to verify the received data with, strongest first
+static const std::vector<std::string> hashAlgorithmsByStrength = {
+    "sha3-512", "blake2b-512", "sha-512", "sha3-256", "sha-256", "sha-1", "md5"
+};
+
+namespace {
+    /**
+     * Passes the data on to another bytestream, and is not writable while
+     * the hash calculator is behind, so the transport holds back data
+     * instead of the hash backlog growing.
+     */
+    class HashThrottledWriteBytestream : public WriteBytestream {
+        public:
+            HashThrottledWriteBytestream(std::shared_ptr<WriteBytestream> stream, std::shared_ptr<IncrementalBytestreamHashCalculator> hashCalculator) : stream(stream), hashCalculator(hashCalculator) {
+                streamWritableConnection = stream->onWritable.connect(
+                        boost::bind(&HashThrottledWriteBytestream::handleWritable, this));
+                hashCalculatorCaughtUpConnection = hashCalculator->onCaughtUp.connect(
+                        boost::bind(&HashThrottledWriteBytestream::handleWritable, this));
+            }
+
+            virtual bool write(const std::vector<unsigned char>& data) override {
+                if (!stream->write(data)) {
+                    return false;
+                }
+                onWrite(data);
+                return true;
+            }
+
+            virtual void close() override {
+                stream->close();
+            }
+
+            virtual bool isWritable() const override {
+                return stream->isWritable() && !hashCalculator->isBehind();
+            }
+
+        private:
+            void handleWritable() {
+                if (isWritable()) {
+                    onWritable();
+                }
+            }
+
+        private:
+            std::shared_ptr<WriteBytestream> stream;
+            std::shared_ptr<IncrementalBytestreamHashCalculator> hashCalculator;
+            boost::signals2::scoped_connection streamWritableConnection;
+            boost::signals2::scoped_connection hashCalculatorCaughtUpConnection;
+    };
+}
+
 // TODO: ALlow terminate when already terminated.
 
 IncomingJingleFileTransfer::IncomingJingleFileTransfer(
@@ -42,8 +95,7 @@ IncomingJingleFileTransfer::IncomingJingleFileTransfer(
             initialContent(content),
             crypto(crypto),
             state(Initial),
-            receivedBytes(0),
-            hashCalculator(nullptr) {
+            receivedBytes(0) {
     description = initialContent->getDescription<JingleFileTransferDescription>();
     assert(description);
     JingleFileTransferFileInfo fileInfo = description->getFileInfo();
@@ -59,9 +111,6 @@ IncomingJingleFileTransfer::~IncomingJingleFileTransfer() {
     if (waitOnHashTimer) {
         waitOnHashTimer->stop();
     }
-
-    delete hashCalculator;
-    hashCalculator = nullptr;
 }
 
 void IncomingJingleFileTransfer::accept(
@@ -71,15 +120,25 @@ void IncomingJingleFileTransfer::accept(
     if (state != Initial) { SWIFT_LOG(warning) << "Incorrect state" << std::endl; return; }
 
     assert(!this->stream);
-    this->stream = stream;
     this->options = options;
 
     assert(!hashCalculator);
 
-    hashCalculator = new IncrementalBytestreamHashCalculator(
-            hashes.find("md5") != hashes.end(), hashes.find("sha-1") != hashes.end(), crypto);
+    // Only the strongest offered hash is verified, so only that one is calculated
+    for (const auto& algorithm : hashAlgorithmsByStrength) {
+        if (hashes.find(algorithm) != hashes.end()) {
+            hashCalculator = std::make_shared<IncrementalBytestreamHashCalculator>(std::vector<std::string>(1, algorithm), crypto, options.getHashingWorker());
+            if (hashCalculator->hasAlgorithm(algorithm)) {
+                break;
+            }
+        }
+    }
+    if (!hashCalculator) {
+        hashCalculator = std::make_shared<IncrementalBytestreamHashCalculator>(std::vector<std::string>(), crypto, options.getHashingWorker());
+    }
 
-    writeStreamDataReceivedConnection = stream->onWrite.connect(
+    this->stream = std::make_shared<HashThrottledWriteBytestream>(stream, hashCalculator);
+    writeStreamDataReceivedConnection = this->stream->onWrite.connect(
             boost::bind(&IncomingJingleFileTransfer::handleWriteStreamDataReceived, this, _1));
 
     JingleS5BTransportPayload::ref s5bTransport = initialContent->getTransport<JingleS5BTransportPayload>();
@@ -100,7 +159,7 @@ void IncomingJingleFileTransfer::accept(
         startTransferring(transporter->createIBBReceiveSession(
             ibbTransport->getSessionID(),
             description->getFileInfo().getSize(),
-            stream));
+            this->stream));
 
         session->sendAccept(getContentID(), initialContent->getDescriptions()[0], ibbTransport);
     }
@@ -146,11 +205,8 @@ void IncomingJingleFileTransfer::handleSessionInfoReceived(JinglePayload::ref ji
     if (transferHash) {
         SWIFT_LOG(debug) << "Received hash information." << std::endl;
         waitOnHashTimer->stop();
-        if (transferHash->getFileInfo().getHashes().find("sha-1") != transferHash->getFileInfo().getHashes().end()) {
-            hashes["sha-1"] = transferHash->getFileInfo().getHash("sha-1").get();
-        }
-        if (transferHash->getFileInfo().getHashes().find("md5") != transferHash->getFileInfo().getHashes().end()) {
-            hashes["md5"] = transferHash->getFileInfo().getHash("md5").get();
+        for (const auto& hash : transferHash->getFileInfo().getHashes()) {
+            hashes[hash.first] = hash.second;
         }
         if (state == WaitingForHash) {
             checkHashAndTerminate();
@@ -183,6 +239,13 @@ void IncomingJingleFileTransfer::handleSessionTerminateReceived(boost::optional<
 }
 
 void IncomingJingleFileTransfer::checkHashAndTerminate() {
+    hashCalculator->finish();
+    if (!hashCalculator->isFinished()) {
+        SWIFT_LOG(debug) << "Waiting for the hashes of the received data." << std::endl;
+        hashesFinishedConnection = hashCalculator->onFinished.connect(
+                boost::bind(&IncomingJingleFileTransfer::handleHashesFinished, this));
+        return;
+    }
     if (verifyData()) {
         terminate(JinglePayload::Reason::Success);
     }
@@ -192,6 +255,14 @@ void IncomingJingleFileTransfer::checkHashAndTerminate() {
     }
 }
 
+void IncomingJingleFileTransfer::handleHashesFinished() {
+    SWIFT_LOG(debug) << std::endl;
+    hashesFinishedConnection.disconnect();
+    if (state != Transferring && state != WaitingForHash) { SWIFT_LOG(warning) << "Incorrect state: " << state << std::endl; return; }
+
+    checkHashAndTerminate();
+}
+
 void IncomingJingleFileTransfer::checkIfAllDataReceived() {
     if (receivedBytes == getFileSizeInBytes()) {
         SWIFT_LOG(debug) << "All data received." << std::endl;
@@ -256,18 +327,17 @@ bool IncomingJingleFileTransfer::verifyData() {
         SWIFT_LOG(debug) << "no verification possible, skipping" << std::endl;
         return true;
     }
-    if (hashes.find("sha-1") != hashes.end()) {
-        SWIFT_LOG(debug) << "Verify SHA-1 hash: " << (hashes["sha-1"] == hashCalculator->getSHA1Hash()) << std::endl;
-        return hashes["sha-1"] == hashCalculator->getSHA1Hash();
-    }
-    else if (hashes.find("md5") != hashes.end()) {
-        SWIFT_LOG(debug) << "Verify MD5 hash: " << (hashes["md5"] == hashCalculator->getMD5Hash()) << std::endl;
-        return hashes["md5"] == hashCalculator->getMD5Hash();
-    }
-    else {
-        SWIFT_LOG(debug) << "Unknown hash, skipping" << std::endl;
-        return true;
+    // Verify the strongest hash that was both announced and calculated
+    for (const auto& algorithm : hashAlgorithmsByStrength) {
+        std::map<std::string, ByteArray>::const_iterator hash = hashes.find(algorithm);
+        if (hash != hashes.end() && !hash->second.empty() && hashCalculator->hasAlgorithm(algorithm)) {
+            bool verified = hash->second == hashCalculator->getHash(algorithm);
+            SWIFT_LOG(debug) << "Verify " << algorithm << " hash: " << verified << std::endl;
+            return verified;
+        }
     }
+    SWIFT_LOG(debug) << "Unknown hash, skipping" << std::endl;
+    return true;
 }
 
 void IncomingJingleFileTransfer::handleWaitOnHashTimerTicked() {
@@ -323,8 +393,7 @@ FileTransfer::State::Type IncomingJingleFileTransfer::getExternalState(State sta
 void IncomingJingleFileTransfer::stopAll() {
     if (state != Initial) {
         writeStreamDataReceivedConnection.disconnect();
-        delete hashCalculator;
-        hashCalculator = nullptr;
+        hashCalculator.reset();
     }
     switch (state) {
         case Initial: break;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -90,6 +90,7 @@ namespace Swift {
             virtual void startTransferViaRemoteCandidate() override;
             virtual void startTransferViaLocalCandidate() override;
             void checkHashAndTerminate();
+            void handleHashesFinished();
             void stopAll();
             void setState(State state);
             void setFinishedState(FileTransfer::State::Type, const boost::optional<FileTransferError>& error);
@@ -114,13 +115,14 @@ namespace Swift {
             std::shared_ptr<JingleFileTransferDescription> description;
             std::shared_ptr<WriteBytestream> stream;
             boost::uintmax_t receivedBytes;
-            IncrementalBytestreamHashCalculator* hashCalculator;
+            std::shared_ptr<IncrementalBytestreamHashCalculator> hashCalculator;
             std::shared_ptr<Timer> waitOnHashTimer;
             std::map<std::string, ByteArray> hashes;
             FileTransferOptions options;
 
             boost::signals2::scoped_connection writeStreamDataReceivedConnection;
             boost::signals2::scoped_connection waitOnHashTimerTickedConnection;
+            boost::signals2::scoped_connection hashesFinishedConnection;
             boost::signals2::connection transferFinishedConnection;
     };
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,27 +13,99 @@
 
 #include <Swiften/FileTransfer/IncrementalBytestreamHashCalculator.h>
 
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include <boost/bind.hpp>
+
 #include <Swiften/Crypto/CryptoProvider.h>
+#include <Swiften/Crypto/Hash.h>
 #include <Swiften/StringCodecs/Hexify.h>
 
 namespace Swift {
 
-IncrementalBytestreamHashCalculator::IncrementalBytestreamHashCalculator(bool doMD5, bool doSHA1, CryptoProvider* crypto) {
-    md5Hasher = doMD5 ? crypto->createMD5() : nullptr;
-    sha1Hasher = doSHA1 ? crypto->createSHA1() : nullptr;
+// Small chunks (e.g. IBB blocks) are collected into blocks of this size
+// before they are handed to the worker.
+static const size_t HASH_BLOCK_SIZE = 64 * 1024;
+
+// The amount of data queued for hashing at which the calculator is behind
+static const size_t MAX_QUEUED_BYTES = 4 * 1024 * 1024;
+
+/**
+ * The hash states. When a worker is used, they are only accessed from the
+ * worker thread until the hashes are finished.
+ */
+struct IncrementalBytestreamHashCalculator::Hashers {
+    Hashers() : calculator(nullptr) {
+    }
+
+    ~Hashers() {
+        for (auto& hasher : hashers) {
+            delete hasher.second;
+        }
+    }
+
+    void update(const ByteArray& data) {
+        for (auto& hasher : hashers) {
+            hasher.second->update(data);
+        }
+    }
+
+    void finish() {
+        for (auto& hasher : hashers) {
+            hashes[hasher.first] = hasher.second->getHash();
+        }
+    }
+
+    std::vector<std::pair<std::string, Hash*> > hashers;
+    std::map<std::string, ByteArray> hashes;
+
+    // Only accessed from the event loop, and reset when the calculator is
+    // destroyed before all blocks are hashed
+    IncrementalBytestreamHashCalculator* calculator;
+};
+
+IncrementalBytestreamHashCalculator::IncrementalBytestreamHashCalculator(bool doMD5, bool doSHA1, CryptoProvider* crypto) : hashers(std::make_shared<Hashers>()), queuedBytes(0), finishing(false), finished(false) {
+    if (doMD5) {
+        hashers->hashers.push_back(std::make_pair("md5", crypto->createMD5()));
+    }
+    if (doSHA1) {
+        hashers->hashers.push_back(std::make_pair("sha-1", crypto->createSHA1()));
+    }
+}
+
+IncrementalBytestreamHashCalculator::IncrementalBytestreamHashCalculator(const std::vector<std::string>& algorithms, CryptoProvider* crypto, FileIOWorker::ref worker) : hashers(std::make_shared<Hashers>()), worker(worker), queuedBytes(0), finishing(false), finished(false) {
+    hashers->calculator = this;
+    for (const auto& algorithm : algorithms) {
+        if (hasAlgorithm(algorithm)) {
+            continue;
+        }
+        if (Hash* hash = crypto->createHash(algorithm)) {
+            hashers->hashers.push_back(std::make_pair(algorithm, hash));
+        }
+    }
 }
 
 IncrementalBytestreamHashCalculator::~IncrementalBytestreamHashCalculator() {
-    delete md5Hasher;
-    delete sha1Hasher;
+    // Blocks that are still queued keep the hashers alive until the worker
+    // is done with them.
+    hashers->calculator = nullptr;
 }
 
 void IncrementalBytestreamHashCalculator::feedData(const ByteArray& data) {
-    if (md5Hasher) {
-        md5Hasher->update(data);
+    assert(!finishing);
+    if (!worker) {
+        hashers->update(data);
+        return;
     }
-    if (sha1Hasher) {
-        sha1Hasher->update(data);
+    if (!currentBlock) {
+        currentBlock = std::make_shared<ByteArray>();
+        currentBlock->reserve(std::max(HASH_BLOCK_SIZE, data.size()));
+    }
+    currentBlock->insert(currentBlock->end(), data.begin(), data.end());
+    if (currentBlock->size() >= HASH_BLOCK_SIZE) {
+        flush();
     }
 }
 /*
@@ -46,30 +118,118 @@ void IncrementalBytestreamHashCalculator::feedData(const SafeByteArray& data) {
     }
 }*/
 
-ByteArray IncrementalBytestreamHashCalculator::getSHA1Hash() {
-    assert(sha1Hasher);
-    if (!sha1Hash) {
-        sha1Hash = sha1Hasher->getHash();
+bool IncrementalBytestreamHashCalculator::isBehind() const {
+    return queuedBytes >= MAX_QUEUED_BYTES;
+}
+
+bool IncrementalBytestreamHashCalculator::hasAlgorithm(const std::string& algorithm) const {
+    for (const auto& hasher : hashers->hashers) {
+        if (hasher.first == algorithm) {
+            return true;
+        }
     }
-    return *sha1Hash;
+    return false;
 }
 
-ByteArray IncrementalBytestreamHashCalculator::getMD5Hash() {
-    assert(md5Hasher);
-    if (!md5Hash) {
-        md5Hash = md5Hasher->getHash();
+void IncrementalBytestreamHashCalculator::finish() {
+    if (finishing) {
+        return;
+    }
+    finishing = true;
+    if (!worker) {
+        hashers->finish();
+        handleHashersFinished();
+        return;
+    }
+    flush();
+    // The worker runs jobs in order, so this runs after all blocks are hashed
+    worker->post(
+            boost::bind(&IncrementalBytestreamHashCalculator::finishHashers, hashers),
+            boost::bind(&IncrementalBytestreamHashCalculator::handleHashersFinishedOnEventLoop, std::weak_ptr<Hashers>(hashers)));
+}
+
+bool IncrementalBytestreamHashCalculator::isFinished() const {
+    return finished;
+}
+
+ByteArray IncrementalBytestreamHashCalculator::getHash(const std::string& algorithm) {
+    assert(hasAlgorithm(algorithm));
+    if (!worker) {
+        finish();
+    }
+    assert(finished);
+    return hashes[algorithm];
+}
+
+std::map<std::string, ByteArray> IncrementalBytestreamHashCalculator::getHashes() {
+    if (!worker) {
+        finish();
     }
-    return *md5Hash;
+    assert(finished);
+    return hashes;
+}
+
+ByteArray IncrementalBytestreamHashCalculator::getSHA1Hash() {
+    return getHash("sha-1");
+}
+
+ByteArray IncrementalBytestreamHashCalculator::getMD5Hash() {
+    return getHash("md5");
 }
 
 std::string IncrementalBytestreamHashCalculator::getSHA1String() {
-    assert(sha1Hasher);
-    return Hexify::hexify(getSHA1Hash());;
+    return Hexify::hexify(getSHA1Hash());
 }
 
 std::string IncrementalBytestreamHashCalculator::getMD5String() {
-    assert(md5Hasher);
-    return Hexify::hexify(getMD5Hash());;
+    return Hexify::hexify(getMD5Hash());
+}
+
+void IncrementalBytestreamHashCalculator::flush() {
+    if (!currentBlock || currentBlock->empty()) {
+        return;
+    }
+    queuedBytes += currentBlock->size();
+    worker->post(
+            boost::bind(&IncrementalBytestreamHashCalculator::hashBlock, hashers, currentBlock),
+            boost::bind(&IncrementalBytestreamHashCalculator::handleBlockHashedOnEventLoop, std::weak_ptr<Hashers>(hashers), currentBlock->size()));
+    currentBlock.reset();
+}
+
+void IncrementalBytestreamHashCalculator::handleBlockHashed(size_t size) {
+    bool wasBehind = isBehind();
+    queuedBytes -= size;
+    if (wasBehind && !isBehind()) {
+        onCaughtUp();
+    }
+}
+
+void IncrementalBytestreamHashCalculator::handleHashersFinished() {
+    hashes = hashers->hashes;
+    finished = true;
+    onFinished();
+}
+
+void IncrementalBytestreamHashCalculator::hashBlock(std::shared_ptr<Hashers> hashers, std::shared_ptr<ByteArray> block) {
+    hashers->update(*block);
+}
+
+void IncrementalBytestreamHashCalculator::finishHashers(std::shared_ptr<Hashers> hashers) {
+    hashers->finish();
+}
+
+void IncrementalBytestreamHashCalculator::handleBlockHashedOnEventLoop(std::weak_ptr<Hashers> weakHashers, size_t size) {
+    std::shared_ptr<Hashers> hashers = weakHashers.lock();
+    if (hashers && hashers->calculator) {
+        hashers->calculator->handleBlockHashed(size);
+    }
+}
+
+void IncrementalBytestreamHashCalculator::handleHashersFinishedOnEventLoop(std::weak_ptr<Hashers> weakHashers) {
+    std::shared_ptr<Hashers> hashers = weakHashers.lock();
+    if (hashers && hashers->calculator) {
+        hashers->calculator->handleHashersFinished();
+    }
 }
 
 }
@@ -5,43 +5,126 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
-#include <boost/optional.hpp>
+#include <boost/signals2.hpp>
 
+#include <Swiften/Base/API.h>
 #include <Swiften/Base/ByteArray.h>
 #include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
 
 namespace Swift {
-    class Hash;
     class CryptoProvider;
 
-    class IncrementalBytestreamHashCalculator {
+    /**
+     * Calculates one or more hashes over a stream of data, passing over
+     * every chunk of data once for all algorithms.
+     *
+     * If a worker is given, the hashing is done on the worker thread, so it
+     * overlaps with the transfer instead of running on the event loop. Data
+     * that is fed faster than the worker can hash it is queued; callers
+     * should stop feeding data while \ref isBehind() returns true.
+     */
+    class SWIFTEN_API IncrementalBytestreamHashCalculator {
     public:
         IncrementalBytestreamHashCalculator(bool doMD5, bool doSHA1, CryptoProvider* crypto);
+
+        /**
+         * Creates a calculator for all \p algorithms (using their XEP-0300
+         * names) that are supported by \p crypto. Unsupported algorithms
+         * are ignored.
+         */
+        IncrementalBytestreamHashCalculator(const std::vector<std::string>& algorithms, CryptoProvider* crypto, FileIOWorker::ref worker = FileIOWorker::ref());
         ~IncrementalBytestreamHashCalculator();
 
         void feedData(const ByteArray& data);
         //void feedData(const SafeByteArray& data);
 
+        /**
+         * Returns whether so much data is queued for hashing that no more
+         * data should be fed until \ref onCaughtUp is emitted. Data that is
+         * fed anyway is still queued.
+         */
+        bool isBehind() const;
+
+        /**
+         * Returns whether \p algorithm is calculated.
+         */
+        bool hasAlgorithm(const std::string& algorithm) const;
+
+        /**
+         * Stops feeding data, and finishes the hashes. Without a worker,
+         * this emits \ref onFinished before returning. With a worker, the
+         * hashes are finished on the worker once all data fed so far is
+         * hashed, and \ref onFinished is emitted on the event loop.
+         */
+        void finish();
+
+        /**
+         * Returns whether the hashes are available.
+         */
+        bool isFinished() const;
+
+        /**
+         * Returns the hash for \p algorithm, which must be calculated.
+         *
+         * Without a worker, this finishes the calculator if needed. With a
+         * worker, this can only be called after \ref onFinished.
+         */
+        ByteArray getHash(const std::string& algorithm);
+
+        /**
+         * Returns the hashes of all calculated algorithms, by algorithm name.
+         */
+        std::map<std::string, ByteArray> getHashes();
+
         ByteArray getSHA1Hash();
         ByteArray getMD5Hash();
 
         std::string getSHA1String();
         std::string getMD5String();
 
+    public:
+        /**
+         * Emitted on the event loop when the calculator is no longer behind.
+         */
+        boost::signals2::signal<void ()> onCaughtUp;
+
+        /**
+         * Emitted when the hashes are available.
+         */
+        boost::signals2::signal<void ()> onFinished;
+
+    private:
+        struct Hashers;
+
+        void flush();
+        void handleBlockHashed(size_t size);
+        void handleHashersFinished();
+        static void hashBlock(std::shared_ptr<Hashers> hashers, std::shared_ptr<ByteArray> block);
+        static void finishHashers(std::shared_ptr<Hashers> hashers);
+        static void handleBlockHashedOnEventLoop(std::weak_ptr<Hashers> hashers, size_t size);
+        static void handleHashersFinishedOnEventLoop(std::weak_ptr<Hashers> hashers);
+
     private:
-        Hash* md5Hasher;
-        Hash* sha1Hasher;
-        boost::optional<ByteArray> md5Hash;
-        boost::optional<ByteArray> sha1Hash;
+        std::shared_ptr<Hashers> hashers;
+        FileIOWorker::ref worker;
+        std::shared_ptr<ByteArray> currentBlock;
+        size_t queuedBytes;
+        std::map<std::string, ByteArray> hashes;
+        bool finishing;
+        bool finished;
     };
 
 }
@@ -46,7 +46,8 @@ std::shared_ptr<OutgoingFileTransfer> OutgoingFileTransferManager::createOutgoin
         const JID& recipient,
         std::shared_ptr<ReadBytestream> readBytestream,
         const JingleFileTransferFileInfo& fileInfo,
-        const FileTransferOptions& config) {
+        const FileTransferOptions& config,
+        FileHashCalculator::ref precomputedHashes) {
     JingleSessionImpl::ref jingleSession = std::make_shared<JingleSessionImpl>(
             from, recipient, idGenerator->generateID(), iqRouter);
     jingleSessionManager->registerOutgoingSession(from, jingleSession);
@@ -59,7 +60,8 @@ std::shared_ptr<OutgoingFileTransfer> OutgoingFileTransferManager::createOutgoin
                 idGenerator,
                 fileInfo,
                 config,
-                crypto));
+                crypto,
+                precomputedHashes));
 }
 
 }
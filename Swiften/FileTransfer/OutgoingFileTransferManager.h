@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -15,6 +15,7 @@
 #include <memory>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/FileTransfer/FileHashCalculator.h>
 
 namespace Swift {
     class JingleSessionManager;
@@ -44,7 +45,8 @@ namespace Swift {
                     const JID& to,
                     std::shared_ptr<ReadBytestream>,
                     const JingleFileTransferFileInfo&,
-                    const FileTransferOptions&);
+                    const FileTransferOptions&,
+                    FileHashCalculator::ref precomputedHashes = FileHashCalculator::ref());
 
         private:
             JingleSessionManager* jingleSessionManager;
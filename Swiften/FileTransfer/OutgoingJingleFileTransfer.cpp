@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -43,6 +43,50 @@ using namespace Swift;
 
 static const int DEFAULT_BLOCK_SIZE = 4096;
 
+namespace {
+    /**
+     * Reads from another bytestream, but has no data available while the
+     * hash calculator is behind, so the transport holds back instead of the
+     * hash backlog growing.
+     */
+    class HashThrottledReadBytestream : public ReadBytestream {
+        public:
+            HashThrottledReadBytestream(std::shared_ptr<ReadBytestream> stream, std::shared_ptr<IncrementalBytestreamHashCalculator> hashCalculator) : stream(stream), hashCalculator(hashCalculator) {
+                streamDataAvailableConnection = stream->onDataAvailable.connect(
+                        boost::bind(&HashThrottledReadBytestream::handleDataAvailable, this));
+                hashCalculatorCaughtUpConnection = hashCalculator->onCaughtUp.connect(
+                        boost::bind(&HashThrottledReadBytestream::handleDataAvailable, this));
+            }
+
+            virtual std::shared_ptr< std::vector<unsigned char> > read(size_t size) override {
+                std::shared_ptr<IncrementalBytestreamHashCalculator> calculator = hashCalculator.lock();
+                if (calculator && calculator->isBehind()) {
+                    return std::make_shared< std::vector<unsigned char> >();
+                }
+                std::shared_ptr< std::vector<unsigned char> > data = stream->read(size);
+                if (!data->empty()) {
+                    onRead(*data);
+                }
+                return data;
+            }
+
+            virtual bool isFinished() const override {
+                return stream->isFinished();
+            }
+
+        private:
+            void handleDataAvailable() {
+                onDataAvailable();
+            }
+
+        private:
+            std::shared_ptr<ReadBytestream> stream;
+            std::weak_ptr<IncrementalBytestreamHashCalculator> hashCalculator;
+            boost::signals2::scoped_connection streamDataAvailableConnection;
+            boost::signals2::scoped_connection hashCalculatorCaughtUpConnection;
+    };
+}
+
 OutgoingJingleFileTransfer::OutgoingJingleFileTransfer(
         const JID& toJID,
         JingleSession::ref session,
@@ -52,22 +96,25 @@ OutgoingJingleFileTransfer::OutgoingJingleFileTransfer(
         IDGenerator* idGenerator,
         const JingleFileTransferFileInfo& fileInfo,
         const FileTransferOptions& options,
-        CryptoProvider* crypto) :
+        CryptoProvider* crypto,
+        FileHashCalculator::ref precomputedHashes) :
             JingleFileTransfer(session, toJID, transporterFactory),
             idGenerator(idGenerator),
             stream(stream),
             fileInfo(fileInfo),
             options(options),
             contentID(idGenerator->generateID(), JingleContentPayload::InitiatorCreator),
+            precomputedHashes(precomputedHashes),
             state(Initial),
             candidateAcknowledged(false) {
 
     setFileInfo(fileInfo.getName(), fileInfo.getSize(), fileInfo.getDescription());
 
-    // calculate both, MD5 and SHA-1 since we don't know which one the other side supports
-    hashCalculator = new IncrementalBytestreamHashCalculator(true, true, crypto);
-    stream->onRead.connect(
-            boost::bind(&IncrementalBytestreamHashCalculator::feedData, hashCalculator, _1));
+    // calculate all configured hashes (by default both, MD5 and SHA-1) since we don't know which one the other side supports
+    hashCalculator = std::make_shared<IncrementalBytestreamHashCalculator>(options.getHashAlgorithms(), crypto, options.getHashingWorker());
+    streamReadConnection = stream->onRead.connect(
+            boost::bind(&IncrementalBytestreamHashCalculator::feedData, hashCalculator.get(), _1));
+    this->stream = std::make_shared<HashThrottledReadBytestream>(stream, hashCalculator);
 
     waitForRemoteTermination = timerFactory->createTimer(5000);
     waitForRemoteTermination->onTick.connect(boost::bind(&OutgoingJingleFileTransfer::handleWaitForRemoteTerminationTimeout, this));
@@ -79,10 +126,10 @@ OutgoingJingleFileTransfer::~OutgoingJingleFileTransfer() {
         waitForRemoteTermination->stop();
     }
 
-    stream->onRead.disconnect(
-            boost::bind(&IncrementalBytestreamHashCalculator::feedData, hashCalculator, _1));
-    delete hashCalculator;
-    hashCalculator = nullptr;
+    precomputedHashesFinishedConnection.disconnect();
+    hashesFinishedConnection.disconnect();
+    streamReadConnection.disconnect();
+    hashCalculator.reset();
     removeTransporter();
 }
 
@@ -184,8 +231,18 @@ void OutgoingJingleFileTransfer::sendSessionInfoHash() {
     SWIFT_LOG(debug) << std::endl;
 
     JingleFileTransferHash::ref hashElement = std::make_shared<JingleFileTransferHash>();
-    hashElement->getFileInfo().addHash(HashElement("sha-1", hashCalculator->getSHA1Hash()));
-    hashElement->getFileInfo().addHash(HashElement("md5", hashCalculator->getMD5Hash()));
+    if (hashCalculator) {
+        for (const auto& hash : hashCalculator->getHashes()) {
+            hashElement->getFileInfo().addHash(HashElement(hash.first, hash.second));
+        }
+    }
+    else {
+        // The precomputed hashes were already offered, but send them again
+        // for peers that only look at the session info.
+        for (const auto& hash : fileInfo.getHashes()) {
+            hashElement->getFileInfo().addHash(HashElement(hash.first, hash.second));
+        }
+    }
     session->sendInfo(hashElement);
 }
 
@@ -196,9 +253,46 @@ void OutgoingJingleFileTransfer::handleLocalTransportCandidatesGenerated(
 
     fillCandidateMap(localCandidates, candidates);
 
+    if (precomputedHashes && !precomputedHashes->isFinished()) {
+        SWIFT_LOG(debug) << "Waiting for file hashes before sending offer." << std::endl;
+        this->s5bSessionID = s5bSessionID;
+        localCandidatesToOffer = candidates;
+        this->dstAddr = dstAddr;
+        precomputedHashesFinishedConnection = precomputedHashes->onFinished.connect(
+                boost::bind(&OutgoingJingleFileTransfer::handlePrecomputedHashesFinished, this));
+        return;
+    }
+    sendInitiate(s5bSessionID, candidates, dstAddr);
+}
+
+void OutgoingJingleFileTransfer::handlePrecomputedHashesFinished() {
+    SWIFT_LOG(debug) << std::endl;
+    precomputedHashesFinishedConnection.disconnect();
+    if (state != GeneratingInitialLocalCandidates) { SWIFT_LOG(warning) << "Incorrect state: " << state << std::endl; return; }
+
+    sendInitiate(s5bSessionID, localCandidatesToOffer, dstAddr);
+}
+
+void OutgoingJingleFileTransfer::sendInitiate(
+        const std::string& s5bSessionID, const std::vector<JingleS5BTransportPayload::Candidate>& candidates, const std::string& dstAddr) {
     JingleFileTransferDescription::ref description = std::make_shared<JingleFileTransferDescription>();
-    fileInfo.addHash(HashElement("sha-1", ByteArray()));
-    fileInfo.addHash(HashElement("md5", ByteArray()));
+    if (precomputedHashes && !precomputedHashes->getHashes().empty()) {
+        for (const auto& hash : precomputedHashes->getHashes()) {
+            fileInfo.addHash(HashElement(hash.first, hash.second));
+        }
+
+        // The hashes are known, so there is no need to hash the data while sending it
+        streamReadConnection.disconnect();
+        hashCalculator.reset();
+    }
+    else {
+        for (const auto& algorithm : options.getHashAlgorithms()) {
+            if (hashCalculator->hasAlgorithm(algorithm)) {
+                fileInfo.addHash(HashElement(algorithm, ByteArray()));
+            }
+        }
+    }
+    precomputedHashes.reset();
     description->setFileInfo(fileInfo);
 
     JingleTransportPayload::ref transport;
@@ -247,7 +341,17 @@ void OutgoingJingleFileTransfer::handleTransferFinished(boost::optional<FileTran
         terminate(JinglePayload::Reason::ConnectivityError);
     }
     else {
-        sendSessionInfoHash();
+        if (hashCalculator) {
+            hashCalculator->finish();
+        }
+        if (hashCalculator && !hashCalculator->isFinished()) {
+            SWIFT_LOG(debug) << "Waiting for the hashes of the sent data." << std::endl;
+            hashesFinishedConnection = hashCalculator->onFinished.connect(
+                    boost::bind(&OutgoingJingleFileTransfer::handleHashesFinished, this));
+        }
+        else {
+            sendSessionInfoHash();
+        }
 
         // wait for other party to terminate session after they have verified the hash
         setInternalState(WaitForTermination);
@@ -255,6 +359,14 @@ void OutgoingJingleFileTransfer::handleTransferFinished(boost::optional<FileTran
     }
 }
 
+void OutgoingJingleFileTransfer::handleHashesFinished() {
+    SWIFT_LOG(debug) << std::endl;
+    hashesFinishedConnection.disconnect();
+    if (state != WaitForTermination) { SWIFT_LOG(warning) << "Incorrect state: " << state << std::endl; return; }
+
+    sendSessionInfoHash();
+}
+
 void OutgoingJingleFileTransfer::startTransferring(std::shared_ptr<TransportSession> transportSession) {
     SWIFT_LOG(debug) << std::endl;
 
@@ -302,6 +414,11 @@ FileTransfer::State::Type OutgoingJingleFileTransfer::getExternalState(State sta
 
 void OutgoingJingleFileTransfer::stopAll() {
     SWIFT_LOG(debug) << state << std::endl;
+    precomputedHashesFinishedConnection.disconnect();
+    if (precomputedHashes) {
+        precomputedHashes->stop();
+        precomputedHashes.reset();
+    }
     switch (state) {
         case Initial: SWIFT_LOG(warning) << "Not yet started" << std::endl; break;
         case GeneratingInitialLocalCandidates: transporter->stopGeneratingLocalCandidates(); break;
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2017 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,11 +13,14 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <boost/optional/optional.hpp>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Elements/JingleFileTransferFileInfo.h>
+#include <Swiften/FileTransfer/FileHashCalculator.h>
 #include <Swiften/FileTransfer/FileTransferOptions.h>
 #include <Swiften/FileTransfer/JingleFileTransfer.h>
 #include <Swiften/FileTransfer/OutgoingFileTransfer.h>
@@ -44,7 +47,8 @@ namespace Swift {
                 IDGenerator*,
                 const JingleFileTransferFileInfo&,
                 const FileTransferOptions&,
-                CryptoProvider*);
+                CryptoProvider*,
+                FileHashCalculator::ref precomputedHashes = FileHashCalculator::ref());
             virtual ~OutgoingJingleFileTransfer() override;
 
             virtual void start() override;
@@ -83,6 +87,9 @@ namespace Swift {
             virtual void fallback() override;
             void handleTransferFinished(boost::optional<FileTransferError>);
 
+            void handlePrecomputedHashesFinished();
+            void handleHashesFinished();
+            void sendInitiate(const std::string& s5bSessionID, const std::vector<JingleS5BTransportPayload::Candidate>&, const std::string& dstAddr);
             void sendSessionInfoHash();
 
             virtual void startTransferring(std::shared_ptr<TransportSession>) override;
@@ -108,14 +115,21 @@ namespace Swift {
             JingleFileTransferFileInfo fileInfo;
             FileTransferOptions options;
             JingleContentID contentID;
-            IncrementalBytestreamHashCalculator* hashCalculator;
+            std::shared_ptr<IncrementalBytestreamHashCalculator> hashCalculator;
+            FileHashCalculator::ref precomputedHashes;
+            std::string s5bSessionID;
+            std::vector<JingleS5BTransportPayload::Candidate> localCandidatesToOffer;
+            std::string dstAddr;
             State state;
             bool candidateAcknowledged;
 
             Timer::ref waitForRemoteTermination;
 
+            boost::signals2::connection streamReadConnection;
             boost::signals2::connection processedBytesConnection;
             boost::signals2::connection transferFinishedConnection;
+            boost::signals2::connection precomputedHashesFinishedConnection;
+            boost::signals2::connection hashesFinishedConnection;
     };
 
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -35,7 +35,8 @@ SOCKS5BytestreamClientSession::SOCKS5BytestreamClientSession(
             addressPort(addressPort),
             destination(destination),
             state(Initial),
-            chunkSize(131072) {
+            chunkSize(131072),
+            waitingForData(false) {
     weFailedTimeout = timerFactory->createTimer(3000);
     weFailedTimeout->onTick.connect(
             boost::bind(&SOCKS5BytestreamClientSession::handleWeFailedTimeout, this));
@@ -165,8 +166,13 @@ void SOCKS5BytestreamClientSession::startReceiving(std::shared_ptr<WriteBytestre
     if (state == Ready) {
         state = Reading;
         writeBytestream = writeStream;
+        writableConnection = writeBytestream->onWritable.connect(
+                boost::bind(&SOCKS5BytestreamClientSession::handleBytestreamWritable, this));
         writeBytestream->write(unprocessedData);
         unprocessedData.clear();
+        if (!writeBytestream->isWritable()) {
+            connection->setReadingPaused(true);
+        }
     } else {
         SWIFT_LOG(debug) << "Session isn't ready for transfer yet!" << std::endl;
     }
@@ -176,6 +182,8 @@ void SOCKS5BytestreamClientSession::startSending(std::shared_ptr<ReadBytestream>
     if (state == Ready) {
         state = Writing;
         readBytestream = readStream;
+        dataAvailableConnection = readBytestream->onDataAvailable.connect(
+                boost::bind(&SOCKS5BytestreamClientSession::handleDataAvailable, this));
         dataWrittenConnection = connection->onDataWritten.connect(
                 boost::bind(&SOCKS5BytestreamClientSession::sendData, this));
         sendData();
@@ -192,8 +200,17 @@ void SOCKS5BytestreamClientSession::sendData() {
     if (!readBytestream->isFinished()) {
         try {
             std::shared_ptr<ByteArray> dataToSend = readBytestream->read(boost::numeric_cast<size_t>(chunkSize));
-            connection->write(createSafeByteArray(*dataToSend));
-            onBytesSent(dataToSend->size());
+            if (!dataToSend->empty()) {
+                connection->write(createSafeByteArray(*dataToSend));
+                onBytesSent(dataToSend->size());
+                waitingForData = false;
+            }
+            else if (readBytestream->isFinished()) {
+                finish(false);
+            }
+            else {
+                waitingForData = true;
+            }
         }
         catch (const BytestreamException&) {
             finish(true);
@@ -250,9 +267,18 @@ void SOCKS5BytestreamClientSession::handleDataRead(std::shared_ptr<SafeByteArray
     else {
         writeBytestream->write(createByteArray(vecptr(*data), data->size()));
         //onBytesReceived(data->size());
+        if (!writeBytestream->isWritable()) {
+            // Let TCP flow control slow down the sender until the data is
+            // written out
+            connection->setReadingPaused(true);
+        }
     }
 }
 
+void SOCKS5BytestreamClientSession::handleBytestreamWritable() {
+    connection->setReadingPaused(false);
+}
+
 void SOCKS5BytestreamClientSession::handleDisconnected(const boost::optional<Connection::Error>& error) {
     SWIFT_LOG(debug) << (error ? (error == Connection::ReadError ? "Read Error" : "Write Error") : "No Error") << std::endl;
     if (error) {
@@ -260,6 +286,12 @@ void SOCKS5BytestreamClientSession::handleDisconnected(const boost::optional<Con
     }
 }
 
+void SOCKS5BytestreamClientSession::handleDataAvailable() {
+    if (waitingForData) {
+        sendData();
+    }
+}
+
 void SOCKS5BytestreamClientSession::handleWeFailedTimeout() {
     SWIFT_LOG(debug) << "Failed due to timeout!" << std::endl;
     finish(true);
@@ -268,8 +300,10 @@ void SOCKS5BytestreamClientSession::handleWeFailedTimeout() {
 void SOCKS5BytestreamClientSession::closeConnection() {
     connectFinishedConnection.disconnect();
     dataWrittenConnection.disconnect();
+    dataAvailableConnection.disconnect();
     dataReadConnection.disconnect();
     disconnectedConnection.disconnect();
+    writableConnection.disconnect();
     connection->disconnect();
 }
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2015-2017 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -18,6 +18,7 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/ByteArray.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/FileTransfer/FileTransferError.h>
 #include <Swiften/FileTransfer/ReadBytestream.h>
 #include <Swiften/FileTransfer/WriteBytestream.h>
@@ -81,6 +82,8 @@ private:
     void handleDataRead(std::shared_ptr<SafeByteArray>);
     void handleDisconnected(const boost::optional<Connection::Error>&);
     void handleWeFailedTimeout();
+    void handleDataAvailable();
+    void handleBytestreamWritable();
 
     void finish(bool error);
     void sendData();
@@ -97,15 +100,18 @@ private:
     ByteArray authenticateAddress;
 
     int chunkSize;
+    bool waitingForData;
     std::shared_ptr<WriteBytestream> writeBytestream;
     std::shared_ptr<ReadBytestream> readBytestream;
 
     Timer::ref weFailedTimeout;
 
     boost::signals2::scoped_connection connectFinishedConnection;
-    boost::signals2::scoped_connection dataWrittenConnection;
-    boost::signals2::scoped_connection dataReadConnection;
+    ScopedSignalConnection dataWrittenConnection;
+    boost::signals2::scoped_connection dataAvailableConnection;
+    ScopedSignalConnection dataReadConnection;
     boost::signals2::scoped_connection disconnectedConnection;
+    boost::signals2::scoped_connection writableConnection;
 };
 
 }
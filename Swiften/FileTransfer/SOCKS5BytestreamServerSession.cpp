@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -66,9 +66,14 @@ void SOCKS5BytestreamServerSession::startReceiving(std::shared_ptr<WriteBytestre
 
     writeBytestream = stream;
     state = ReadingData;
+    writableConnection = writeBytestream->onWritable.connect(
+            boost::bind(&SOCKS5BytestreamServerSession::handleBytestreamWritable, this));
     writeBytestream->write(unprocessedData);
     // onBytesReceived(unprocessedData.size());
     unprocessedData.clear();
+    if (!writeBytestream->isWritable()) {
+        connection->setReadingPaused(true);
+    }
 }
 
 HostAddressPort SOCKS5BytestreamServerSession::getAddressPort() const {
@@ -83,9 +88,18 @@ void SOCKS5BytestreamServerSession::handleDataRead(std::shared_ptr<SafeByteArray
         if (!writeBytestream->write(createByteArray(vecptr(*data), data->size()))) {
             finish(boost::optional<FileTransferError>(FileTransferError::WriteError));
         }
+        else if (!writeBytestream->isWritable()) {
+            // Let TCP flow control slow down the sender until the data is
+            // written out
+            connection->setReadingPaused(true);
+        }
     }
 }
 
+void SOCKS5BytestreamServerSession::handleBytestreamWritable() {
+    connection->setReadingPaused(false);
+}
+
 void SOCKS5BytestreamServerSession::handleDataAvailable() {
     if (waitingForData) {
         sendData();
@@ -187,6 +201,7 @@ void SOCKS5BytestreamServerSession::finish(const boost::optional<FileTransferErr
     dataReadConnection.disconnect();
     dataWrittenConnection.disconnect();
     dataAvailableConnection.disconnect();
+    writableConnection.disconnect();
     readBytestream.reset();
     state = Finished;
     onFinished(error);
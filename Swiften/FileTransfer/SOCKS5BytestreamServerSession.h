@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,6 +11,7 @@
 #include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/FileTransfer/FileTransferError.h>
 #include <Swiften/FileTransfer/ReadBytestream.h>
 #include <Swiften/FileTransfer/WriteBytestream.h>
@@ -62,6 +63,7 @@ namespace Swift {
             void handleDataRead(std::shared_ptr<SafeByteArray>);
             void handleDisconnected(const boost::optional<Connection::Error>&);
             void handleDataAvailable();
+            void handleBytestreamWritable();
             void sendData();
 
         private:
@@ -76,9 +78,10 @@ namespace Swift {
             bool waitingForData;
 
             boost::signals2::connection disconnectedConnection;
-            boost::signals2::connection dataReadConnection;
-            boost::signals2::connection dataWrittenConnection;
+            SignalConnection dataReadConnection;
+            SignalConnection dataWrittenConnection;
             boost::signals2::connection dataAvailableConnection;
+            boost::signals2::connection writableConnection;
 
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -21,11 +21,35 @@
 
 using namespace Swift;
 
+namespace {
+    class ThrottledWriteBytestream : public ByteArrayWriteBytestream {
+        public:
+            ThrottledWriteBytestream() : writable(true) {
+            }
+
+            virtual bool isWritable() const {
+                return writable;
+            }
+
+            void setWritable(bool writable) {
+                this->writable = writable;
+                if (writable) {
+                    onWritable();
+                }
+            }
+
+        private:
+            bool writable;
+    };
+}
+
 class IBBReceiveSessionTest : public CppUnit::TestFixture {
         CPPUNIT_TEST_SUITE(IBBReceiveSessionTest);
         CPPUNIT_TEST(testOpen);
         CPPUNIT_TEST(testReceiveData);
         CPPUNIT_TEST(testReceiveMultipleData);
+        CPPUNIT_TEST(testReceiveData_BytestreamNotWritable);
+        CPPUNIT_TEST(testReceiveLastData_BytestreamNotWritable);
         CPPUNIT_TEST(testReceiveDataForOtherSession);
         CPPUNIT_TEST(testReceiveDataOutOfOrder);
         CPPUNIT_TEST(testReceiveLastData);
@@ -38,7 +62,7 @@ class IBBReceiveSessionTest : public CppUnit::TestFixture {
             stanzaChannel = new DummyStanzaChannel();
             iqRouter = new IQRouter(stanzaChannel);
             finished = false;
-            bytestream = std::make_shared<ByteArrayWriteBytestream>();
+            bytestream = std::make_shared<ThrottledWriteBytestream>();
         }
 
         void tearDown() {
@@ -86,6 +110,40 @@ class IBBReceiveSessionTest : public CppUnit::TestFixture {
             testling->stop();
         }
 
+        void testReceiveData_BytestreamNotWritable() {
+            std::shared_ptr<IBBReceiveSession> testling(createSession("foo@bar.com/baz", "mysession"));
+            testling->start();
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBOpen("mysession", 0x10), "foo@bar.com/baz", "id-open"));
+            bytestream->setWritable(false);
+
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBData("mysession", 0, createByteArray("abc")), "foo@bar.com/baz", "id-a"));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), stanzaChannel->sentStanzas.size());
+            CPPUNIT_ASSERT(createByteArray("abc") == bytestream->getData());
+
+            bytestream->setWritable(true);
+
+            CPPUNIT_ASSERT(stanzaChannel->isResultAtIndex(1, "id-a"));
+            CPPUNIT_ASSERT(!finished);
+
+            testling->stop();
+        }
+
+        void testReceiveLastData_BytestreamNotWritable() {
+            std::shared_ptr<IBBReceiveSession> testling(createSession("foo@bar.com/baz", "mysession", 3));
+            testling->start();
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBOpen("mysession", 0x10), "foo@bar.com/baz", "id-open"));
+            bytestream->setWritable(false);
+
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBData("mysession", 0, createByteArray("abc")), "foo@bar.com/baz", "id-a"));
+
+            CPPUNIT_ASSERT(stanzaChannel->isResultAtIndex(1, "id-a"));
+            CPPUNIT_ASSERT(finished);
+            CPPUNIT_ASSERT(!error);
+
+            testling->stop();
+        }
+
         void testReceiveDataForOtherSession() {
             std::shared_ptr<IBBReceiveSession> testling(createSession("foo@bar.com/baz", "mysession"));
             testling->start();
@@ -181,7 +239,7 @@ class IBBReceiveSessionTest : public CppUnit::TestFixture {
         IQRouter* iqRouter;
         bool finished;
         boost::optional<FileTransferError> error;
-        std::shared_ptr<ByteArrayWriteBytestream> bytestream;
+        std::shared_ptr<ThrottledWriteBytestream> bytestream;
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(IBBReceiveSessionTest);
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include <Swiften/Base/ByteArray.h>
+#include <QA/Checker/IO.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Crypto/CryptoProvider.h>
+#include <Swiften/Crypto/PlatformCryptoProvider.h>
+#include <Swiften/EventLoop/DummyEventLoop.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
+#include <Swiften/FileTransfer/IncrementalBytestreamHashCalculator.h>
+
+using namespace Swift;
+
+class IncrementalBytestreamHashCalculatorTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(IncrementalBytestreamHashCalculatorTest);
+        CPPUNIT_TEST(testGetHash);
+        CPPUNIT_TEST(testGetHash_Worker);
+        CPPUNIT_TEST(testFeedData_WorkerBehind);
+        CPPUNIT_TEST(testGetHashes_SkipsUnsupportedAlgorithms);
+        CPPUNIT_TEST(testLegacyConstructor);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp() {
+            crypto = std::shared_ptr<CryptoProvider>(PlatformCryptoProvider::create());
+            eventLoop = new DummyEventLoop();
+            caughtUp = false;
+            finished = false;
+        }
+
+        void tearDown() {
+            delete eventLoop;
+        }
+
+        void testGetHash() {
+            IncrementalBytestreamHashCalculator testling(std::vector<std::string>{"sha-1", "md5"}, crypto.get());
+            testling.feedData(createByteArray("ABCDEFGHIJKLMNOPQRSTUVWXYZ"));
+            testling.feedData(createByteArray("abcdefghijklmnopqrstuvwxyz0123456789"));
+
+            CPPUNIT_ASSERT_EQUAL(createByteArray("\xd1\x74\xab\x98\xd2\x77\xd9\xf5\xa5\x61\x1c\x2c\x9f\x41\x9d\x9f", 16), testling.getHash("md5"));
+            CPPUNIT_ASSERT_EQUAL(std::string("761c457bf73b14d27e9e9265c46f4b4dda11f940"), testling.getSHA1String());
+        }
+
+        void testGetHash_Worker() {
+            FileIOWorker::ref worker = std::make_shared<FileIOWorker>(eventLoop);
+            IncrementalBytestreamHashCalculator testling(std::vector<std::string>{"sha-1", "md5"}, crypto.get(), worker);
+            IncrementalBytestreamHashCalculator reference(std::vector<std::string>{"sha-1", "md5"}, crypto.get());
+            ByteArray chunk(1000);
+            for (size_t i = 0; i < chunk.size(); ++i) {
+                chunk[i] = static_cast<unsigned char>(i);
+            }
+            for (int i = 0; i < 1000; ++i) {
+                testling.feedData(chunk);
+                reference.feedData(chunk);
+            }
+            testling.onFinished.connect(boost::bind(&IncrementalBytestreamHashCalculatorTest::handleFinished, this));
+            testling.finish();
+
+            for (int i = 0; i < 1000 && !finished; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                eventLoop->processEvents();
+            }
+
+            CPPUNIT_ASSERT(finished);
+            CPPUNIT_ASSERT(testling.isFinished());
+            CPPUNIT_ASSERT(reference.getHashes() == testling.getHashes());
+        }
+
+        void testFeedData_WorkerBehind() {
+            FileIOWorker::ref worker = std::make_shared<FileIOWorker>(eventLoop);
+            IncrementalBytestreamHashCalculator testling(std::vector<std::string>{"sha-1"}, crypto.get(), worker);
+            testling.onCaughtUp.connect(boost::bind(&IncrementalBytestreamHashCalculatorTest::handleCaughtUp, this));
+            ByteArray chunk(64 * 1024);
+            for (int i = 0; i < 64 && !testling.isBehind(); ++i) {
+                testling.feedData(chunk);
+            }
+
+            CPPUNIT_ASSERT(testling.isBehind());
+
+            for (int i = 0; i < 1000 && !caughtUp; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                eventLoop->processEvents();
+            }
+
+            CPPUNIT_ASSERT(caughtUp);
+            CPPUNIT_ASSERT(!testling.isBehind());
+        }
+
+        void testGetHashes_SkipsUnsupportedAlgorithms() {
+            IncrementalBytestreamHashCalculator testling(std::vector<std::string>{"foo-1", "sha-1"}, crypto.get());
+            testling.feedData(createByteArray("foo"));
+
+            CPPUNIT_ASSERT(testling.hasAlgorithm("sha-1"));
+            CPPUNIT_ASSERT(!testling.hasAlgorithm("foo-1"));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getHashes().size());
+        }
+
+        void testLegacyConstructor() {
+            IncrementalBytestreamHashCalculator testling(false, true, crypto.get());
+            testling.feedData(createByteArray("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789"));
+
+            CPPUNIT_ASSERT(!testling.hasAlgorithm("md5"));
+            CPPUNIT_ASSERT_EQUAL(std::string("761c457bf73b14d27e9e9265c46f4b4dda11f940"), testling.getSHA1String());
+        }
+
+    private:
+        void handleCaughtUp() {
+            caughtUp = true;
+        }
+
+        void handleFinished() {
+            finished = true;
+        }
+
+    private:
+        std::shared_ptr<CryptoProvider> crypto;
+        DummyEventLoop* eventLoop;
+        bool caughtUp;
+        bool finished;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IncrementalBytestreamHashCalculatorTest);
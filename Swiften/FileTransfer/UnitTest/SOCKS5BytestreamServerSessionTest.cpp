@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -14,6 +14,7 @@
 #include <Swiften/Base/StartStopper.h>
 #include <Swiften/EventLoop/DummyEventLoop.h>
 #include <Swiften/FileTransfer/ByteArrayReadBytestream.h>
+#include <Swiften/FileTransfer/ByteArrayWriteBytestream.h>
 #include <Swiften/FileTransfer/SOCKS5BytestreamRegistry.h>
 #include <Swiften/FileTransfer/SOCKS5BytestreamServerSession.h>
 #include <Swiften/Network/DummyConnection.h>
@@ -30,8 +31,20 @@ class SOCKS5BytestreamServerSessionTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testReceiveData_Chunked);
         CPPUNIT_TEST(testDataStreamPauseStopsSendingData);
         CPPUNIT_TEST(testDataStreamResumeAfterPauseSendsData);
+        CPPUNIT_TEST(testReceivingPausesReadingWhileStreamIsNotWritable);
         CPPUNIT_TEST_SUITE_END();
 
+        class ThrottledWriteBytestream : public ByteArrayWriteBytestream {
+            public:
+                ThrottledWriteBytestream() : writable(true) {}
+
+                virtual bool isWritable() const {
+                    return writable;
+                }
+
+                bool writable;
+        };
+
     public:
         void setUp() {
             receivedDataChunks = 0;
@@ -160,6 +173,29 @@ class SOCKS5BytestreamServerSessionTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(!error);
         }
 
+        void testReceivingPausesReadingWhileStreamIsNotWritable() {
+            std::shared_ptr<SOCKS5BytestreamServerSession> testling(createSession());
+            StartStopper<SOCKS5BytestreamServerSession> stopper(testling.get());
+            bytestreams->setHasBytestream("abcdef", true);
+            authenticate();
+            request("abcdef");
+            std::shared_ptr<ThrottledWriteBytestream> stream = std::make_shared<ThrottledWriteBytestream>();
+            testling->startReceiving(stream);
+
+            receive(createSafeByteArray("abc"));
+            CPPUNIT_ASSERT(!connection->readingPaused);
+
+            stream->writable = false;
+            receive(createSafeByteArray("def"));
+            CPPUNIT_ASSERT(connection->readingPaused);
+
+            stream->writable = true;
+            stream->onWritable();
+            CPPUNIT_ASSERT(!connection->readingPaused);
+            CPPUNIT_ASSERT(createByteArray("abcdef") == stream->getData());
+            CPPUNIT_ASSERT(!finished);
+        }
+
     private:
         void receive(const SafeByteArray& data) {
             connection->receive(data);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -28,6 +28,18 @@ namespace Swift {
             virtual bool write(const std::vector<unsigned char>&) = 0;
             virtual void close() {}
 
+            /**
+             * Returns whether the bytestream can take more data right away.
+             *
+             * Writers that are able to hold back data should stop writing while
+             * this returns false, until \ref onWritable is emitted. Data that is
+             * written anyway is still accepted.
+             */
+            virtual bool isWritable() const {
+                return true;
+            }
+
             boost::signals2::signal<void (const std::vector<unsigned char>&)> onWrite;
+            boost::signals2::signal<void ()> onWritable;
     };
 }
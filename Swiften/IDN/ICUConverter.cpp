@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2016 Isode Limited.
+ * Copyright (c) 2012-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -136,6 +136,12 @@ SafeByteArray ICUConverter::getStringPrepared(const SafeByteArray& s, StringPrep
 }
 
 boost::optional<std::string> ICUConverter::getIDNAEncoded(const std::string& domain) {
+    switch (checkASCIIDomain(domain)) {
+        case ASCIIPrepared: return domain;
+        case ASCIIProhibited: return boost::none;
+        case NotASCII: break;
+    }
+
     UErrorCode status = U_ZERO_ERROR;
     ICUString icuInput = convertToICUString(domain);
     ICUString icuResult;
@@ -1,14 +1,90 @@
 /*
- * Copyright (c) 2013 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/IDN/IDNConverter.h>
 
+#include <algorithm>
+
 namespace Swift {
 
+// Limit of the IDN libraries, which reject longer strings
+static const size_t MAX_STRINGPREP_SIZE = 1024;
+
 IDNConverter::~IDNConverter() {
 }
 
+boost::optional<std::string> IDNConverter::getStringPreparedIfValid(const std::string& s, StringPrepProfile profile) {
+    std::string result;
+    switch (getASCIIStringPrepared(s, profile, result)) {
+        case ASCIIPrepared: return std::move(result);
+        case ASCIIProhibited: return boost::none;
+        case NotASCII: break;
+    }
+    try {
+        return getStringPrepared(s, profile);
+    }
+    catch (const std::exception&) {
+        return boost::none;
+    }
+}
+
+IDNConverter::ASCIIResult IDNConverter::getASCIIStringPrepared(const std::string& s, StringPrepProfile profile, std::string& result) {
+    if (s.size() >= MAX_STRINGPREP_SIZE) {
+        return NotASCII;
+    }
+    const bool foldCase = (profile == NamePrep || profile == XMPPNodePrep);
+    const bool nodePrep = (profile == XMPPNodePrep);
+    bool hasUpperCase = false;
+    bool prohibited = false;
+    for (char c : s) {
+        if (c < 0x20 || c > 0x7E) {
+            return NotASCII;
+        }
+        if (c >= 'A' && c <= 'Z') {
+            hasUpperCase = true;
+        }
+        // RFC 3454 C.1.1 and the XMPP nodeprep prohibited characters
+        else if (nodePrep && (c == ' ' || c == '"' || c == '&' || c == '\'' || c == '/' || c == ':' || c == '<' || c == '>' || c == '@')) {
+            prohibited = true;
+        }
+    }
+    if (prohibited) {
+        return ASCIIProhibited;
+    }
+    result = s;
+    if (foldCase && hasUpperCase) {
+        for (char& c : result) {
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+        }
+    }
+    return ASCIIPrepared;
+}
+
+IDNConverter::ASCIIResult IDNConverter::checkASCIIDomain(const std::string& domain) {
+    for (char c : domain) {
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '.')) {
+            return NotASCII;
+        }
+    }
+    if (domain.empty() || domain == ".") {
+        return ASCIIPrepared;
+    }
+    size_t start = 0;
+    while (start < domain.size()) {
+        size_t end = std::min(domain.find('.', start), domain.size());
+        size_t length = end - start;
+        if (length < 1 || length > 63 || domain[start] == '-' || domain[end - 1] == '-') {
+            return ASCIIProhibited;
+        }
+        // A trailing dot (i.e. an empty root label) is allowed
+        start = end + 1;
+    }
+    return ASCIIPrepared;
+}
+
 }
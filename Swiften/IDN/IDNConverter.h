@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -25,10 +25,44 @@ namespace Swift {
                 SASLPrep
             };
 
+            /**
+             * Throws std::exception if \p s cannot be prepared.
+             */
             virtual std::string getStringPrepared(const std::string& s, StringPrepProfile profile) = 0;
             virtual SafeByteArray getStringPrepared(const SafeByteArray& s, StringPrepProfile profile) = 0;
 
+            /**
+             * Returns boost::none if \p s cannot be prepared.
+             *
+             * This is the cheaper variant for callers that expect invalid
+             * input, such as JID parsing. Printable ASCII strings are
+             * prepared without the IDN library.
+             */
+            virtual boost::optional<std::string> getStringPreparedIfValid(const std::string& s, StringPrepProfile profile);
+
             // Thread-safe
             virtual boost::optional<std::string> getIDNAEncoded(const std::string& s) = 0;
+
+        protected:
+            enum ASCIIResult {
+                NotASCII,
+                ASCIIPrepared,
+                ASCIIProhibited
+            };
+
+            /**
+             * Prepares strings of printable ASCII characters (as most JIDs
+             * are), for which the profiles only fold case and prohibit some
+             * characters. Anything else is NotASCII, and is left to the
+             * IDN library.
+             */
+            static ASCIIResult getASCIIStringPrepared(const std::string& s, StringPrepProfile profile, std::string& result);
+
+            /**
+             * Checks domains of letters, digits, hyphens and dots, which
+             * ToASCII returns unchanged if they are valid. Anything else is
+             * NotASCII, and is left to the IDN library.
+             */
+            static ASCIIResult checkASCIIDomain(const std::string& domain);
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2016 Isode Limited.
+ * Copyright (c) 2012-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,9 +13,9 @@ extern "C" {
 
 #include <cassert>
 #include <cstdlib>
-#include <vector>
-
+#include <cstring>
 #include <memory>
+#include <vector>
 
 #include <Swiften/Base/ByteArray.h>
 #include <Swiften/Base/SafeAllocator.h>
@@ -24,7 +24,7 @@ extern "C" {
 using namespace Swift;
 
 namespace {
-    static const int MAX_STRINGPREP_SIZE = 1024;
+    static const size_t MAX_STRINGPREP_SIZE = 1024;
 
     const Stringprep_profile* getLibIDNProfile(IDNConverter::StringPrepProfile profile) {
         switch(profile) {
@@ -57,11 +57,31 @@ namespace {
 namespace Swift {
 
 std::string LibIDNConverter::getStringPrepared(const std::string& s, StringPrepProfile profile) {
-    std::vector<char> preparedData = getStringPreparedInternal< std::string, std::vector<char> >(s, profile);
-    if (preparedData.empty()) {
+    boost::optional<std::string> result = getStringPreparedIfValid(s, profile);
+    if (!result) {
         throw std::exception();
     }
-    return std::string(vecptr(preparedData));
+    return *result;
+}
+
+boost::optional<std::string> LibIDNConverter::getStringPreparedIfValid(const std::string& s, StringPrepProfile profile) {
+    std::string result;
+    switch (getASCIIStringPrepared(s, profile, result)) {
+        case ASCIIPrepared: return std::move(result);
+        case ASCIIProhibited: return boost::none;
+        case NotASCII: break;
+    }
+
+    if (s.size() >= MAX_STRINGPREP_SIZE || !UTF8IsValid(s.data(), s.size())) {
+        return boost::none;
+    }
+    char buffer[MAX_STRINGPREP_SIZE];
+    std::memcpy(buffer, s.data(), s.size());
+    buffer[s.size()] = '\0';
+    if (stringprep(buffer, MAX_STRINGPREP_SIZE, static_cast<Stringprep_profile_flags>(0), getLibIDNProfile(profile)) != STRINGPREP_OK) {
+        return boost::none;
+    }
+    return std::string(buffer);
 }
 
 SafeByteArray LibIDNConverter::getStringPrepared(const SafeByteArray& s, StringPrepProfile profile) {
@@ -73,6 +93,12 @@ SafeByteArray LibIDNConverter::getStringPrepared(const SafeByteArray& s, StringP
 }
 
 boost::optional<std::string> LibIDNConverter::getIDNAEncoded(const std::string& domain) {
+    switch (checkASCIIDomain(domain)) {
+        case ASCIIPrepared: return domain;
+        case ASCIIProhibited: return boost::none;
+        case NotASCII: break;
+    }
+
     char* output;
     if (idna_to_ascii_8z(domain.c_str(), &output, IDNA_USE_STD3_ASCII_RULES) == IDNA_SUCCESS) {
         std::string result(output);
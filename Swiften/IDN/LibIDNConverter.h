@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2017 Isode Limited.
+ * Copyright (c) 2012-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,6 +16,7 @@ namespace Swift {
         public:
             virtual std::string getStringPrepared(const std::string& s, StringPrepProfile profile) override;
             virtual SafeByteArray getStringPrepared(const SafeByteArray& s, StringPrepProfile profile) override;
+            virtual boost::optional<std::string> getStringPreparedIfValid(const std::string& s, StringPrepProfile profile) override;
 
             virtual boost::optional<std::string> getIDNAEncoded(const std::string& s) override;
     };
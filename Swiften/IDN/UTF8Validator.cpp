@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/IDN/UTF8Validator.h>
+
+#include <Swiften/Base/ByteScan.h>
+
+namespace Swift {
+
+static size_t getSequenceLength(unsigned char leadByte) {
+    if ((leadByte & 0xE0) == 0xC0) {
+        return 2;
+    }
+    else if ((leadByte & 0xF0) == 0xE0) {
+        return 3;
+    }
+    else if ((leadByte & 0xF8) == 0xF0) {
+        return 4;
+    }
+    // invalid sequences
+    return 0;
+}
+
+bool UTF8IsValid(const unsigned char* data, size_t length) {
+    const unsigned char* current = data;
+    const unsigned char* end = data + length;
+    while (current < end) {
+        // one byte sequences
+        current += ByteScan::findFirst(current, static_cast<size_t>(end - current), ByteScan::NonASCII);
+
+        // longer byte sequences, until the next one byte sequence
+        while (current < end && (*current & 0x80)) {
+            size_t sequenceLength = getSequenceLength(*current);
+            if (sequenceLength == 0 || static_cast<size_t>(end - current) < sequenceLength) {
+                return false;
+            }
+            for (size_t i = 1; i < sequenceLength; ++i) {
+                if ((current[i] & 0xC0) != 0x80) {
+                    return false;
+                }
+            }
+            current += sequenceLength;
+        }
+    }
+    return true;
+}
+
+}
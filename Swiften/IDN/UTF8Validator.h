@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,60 +8,18 @@
 
 #include <cstddef>
 
+#include <Swiften/Base/API.h>
+
 namespace Swift {
 
 // UTF-8 validation based on the description in https://tools.ietf.org/html/rfc3629#section-3 .
+// Runs of ASCII characters are skipped using vector instructions.
+SWIFTEN_API bool UTF8IsValid(const unsigned char* data, size_t length);
+
 template <typename CharType>
 bool UTF8IsValid(const CharType* data, size_t length) {
-    bool isValid = true;
-    const CharType* current = data;
-    const CharType* end = data + length;
-    while (isValid && (current < end)) {
-        // one byte sequences
-        if ((*current & 0x80) == 0x0) {
-            current++;
-            continue;
-        }
-        // longer byte sequences
-        else {
-            // two byte sequences
-            if ((*current & 0xE0) == 0xC0) {
-                current++;
-                if ( (current < end) && ((*current & 0xC0) == 0x80) ) {
-                    current++;
-                    continue;
-                }
-            }
-            // three byte sequences
-            else if ((*current & 0xF0) == 0xE0) {
-                current++;
-                if ( ((current + 1) < end) && ((*current & 0xC0) == 0x80) ) {
-                    current++;
-                    if ((*current & 0xC0) == 0x80) {
-                        current++;
-                        continue;
-                    }
-                }
-            }
-            // four byte sequences
-            else if ((*current & 0xF8) == 0xF0) {
-                current++;
-                if ( ((current + 2) < end) && ((*current & 0xC0) == 0x80) ) {
-                    current++;
-                    if ((*current & 0xC0) == 0x80) {
-                        current++;
-                        if ((*current & 0xC0) == 0x80) {
-                            current++;
-                            continue;
-                        }
-                    }
-                }
-            }
-            // invalid sequences
-            isValid = false;
-        }
-    }
-    return isValid;
+    static_assert(sizeof(CharType) == 1, "UTF-8 is validated byte by byte");
+    return UTF8IsValid(reinterpret_cast<const unsigned char*>(data), length);
 }
 
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -18,9 +18,15 @@ class IDNConverterTest : public CppUnit::TestFixture {
         CPPUNIT_TEST_SUITE(IDNConverterTest);
         CPPUNIT_TEST(testStringPrep);
         CPPUNIT_TEST(testStringPrep_Empty);
+        CPPUNIT_TEST(testStringPrep_ASCII);
+        CPPUNIT_TEST(testStringPrep_ASCIIProhibited);
+        CPPUNIT_TEST(testStringPrep_TooLong);
+        CPPUNIT_TEST(testStringPrepIfValid);
         CPPUNIT_TEST(testGetEncoded);
         CPPUNIT_TEST(testGetEncoded_International);
         CPPUNIT_TEST(testGetEncoded_Invalid);
+        CPPUNIT_TEST(testGetEncoded_ASCII);
+        CPPUNIT_TEST(testGetEncoded_InvalidLabels);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -40,6 +46,34 @@ class IDNConverterTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(std::string(""), testling->getStringPrepared("", IDNConverter::XMPPResourcePrep));
         }
 
+        void testStringPrep_ASCII() {
+            CPPUNIT_ASSERT_EQUAL(std::string("alice"), testling->getStringPrepared("Alice", IDNConverter::XMPPNodePrep));
+            CPPUNIT_ASSERT_EQUAL(std::string("wonderland.lit"), testling->getStringPrepared("WonderLand.LIT", IDNConverter::NamePrep));
+            CPPUNIT_ASSERT_EQUAL(std::string("Rabbit Hole/1"), testling->getStringPrepared("Rabbit Hole/1", IDNConverter::XMPPResourcePrep));
+            CPPUNIT_ASSERT_EQUAL(std::string("Pa$$ word"), testling->getStringPrepared("Pa$$ word", IDNConverter::SASLPrep));
+        }
+
+        void testStringPrep_ASCIIProhibited() {
+            const char* prohibited[] = { "a b", "a\"b", "a&b", "a'b", "a/b", "a:b", "a<b", "a>b", "a@b" };
+            for (const char* node : prohibited) {
+                CPPUNIT_ASSERT_THROW(testling->getStringPrepared(node, IDNConverter::XMPPNodePrep), std::exception);
+            }
+            CPPUNIT_ASSERT_THROW(testling->getStringPrepared("a\x7fb", IDNConverter::XMPPResourcePrep), std::exception);
+            CPPUNIT_ASSERT_EQUAL(std::string("a@b"), testling->getStringPrepared("a@b", IDNConverter::XMPPResourcePrep));
+        }
+
+        void testStringPrep_TooLong() {
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1023), testling->getStringPrepared(std::string(1023, 'a'), IDNConverter::XMPPResourcePrep).size());
+            CPPUNIT_ASSERT_THROW(testling->getStringPrepared(std::string(1024, 'a'), IDNConverter::XMPPResourcePrep), std::exception);
+        }
+
+        void testStringPrepIfValid() {
+            CPPUNIT_ASSERT_EQUAL(std::string("alice"), testling->getStringPreparedIfValid("Alice", IDNConverter::XMPPNodePrep).get_value_or(""));
+            CPPUNIT_ASSERT_EQUAL(std::string("tron\xc3\xa7on"), testling->getStringPreparedIfValid("tron\xc3\x87on", IDNConverter::XMPPNodePrep).get_value_or(""));
+            CPPUNIT_ASSERT(!testling->getStringPreparedIfValid("a@b", IDNConverter::XMPPNodePrep));
+            CPPUNIT_ASSERT(!testling->getStringPreparedIfValid("a\xc3", IDNConverter::XMPPNodePrep));
+        }
+
         void testGetEncoded() {
             boost::optional<std::string> result = testling->getIDNAEncoded("www.swift.im");
             CPPUNIT_ASSERT(!!result);
@@ -57,6 +91,20 @@ class IDNConverterTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(!result);
         }
 
+        void testGetEncoded_ASCII() {
+            CPPUNIT_ASSERT_EQUAL(std::string("Www.Swift.IM"), testling->getIDNAEncoded("Www.Swift.IM").get_value_or(""));
+            CPPUNIT_ASSERT_EQUAL(std::string("swift.im."), testling->getIDNAEncoded("swift.im.").get_value_or(""));
+            CPPUNIT_ASSERT_EQUAL(std::string("xn--tronon-zua.com"), testling->getIDNAEncoded("xn--tronon-zua.com").get_value_or(""));
+        }
+
+        void testGetEncoded_InvalidLabels() {
+            CPPUNIT_ASSERT(!testling->getIDNAEncoded("www..swift.im"));
+            CPPUNIT_ASSERT(!testling->getIDNAEncoded("-swift.im"));
+            CPPUNIT_ASSERT(!testling->getIDNAEncoded("swift-.im"));
+            CPPUNIT_ASSERT(!testling->getIDNAEncoded(std::string(64, 'a') + ".im"));
+            CPPUNIT_ASSERT(!!testling->getIDNAEncoded(std::string(63, 'a') + ".im"));
+        }
+
     private:
         std::shared_ptr<IDNConverter> testling;
 };
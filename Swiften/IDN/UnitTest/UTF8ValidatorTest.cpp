@@ -1,9 +1,12 @@
 /*
- * Copyright (c) 2015 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
+#include <random>
+#include <vector>
+
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
@@ -11,11 +14,51 @@
 
 using namespace Swift;
 
+namespace {
+    // The byte-at-a-time validator UTF8IsValid used to be
+    bool isValidReference(const unsigned char* data, size_t length) {
+        const unsigned char* current = data;
+        const unsigned char* end = data + length;
+        while (current < end) {
+            size_t sequenceLength = 1;
+            if ((*current & 0x80) == 0x0) {
+                sequenceLength = 1;
+            }
+            else if ((*current & 0xE0) == 0xC0) {
+                sequenceLength = 2;
+            }
+            else if ((*current & 0xF0) == 0xE0) {
+                sequenceLength = 3;
+            }
+            else if ((*current & 0xF8) == 0xF0) {
+                sequenceLength = 4;
+            }
+            else {
+                return false;
+            }
+            if (static_cast<size_t>(end - current) < sequenceLength) {
+                return false;
+            }
+            for (size_t i = 1; i < sequenceLength; ++i) {
+                if ((current[i] & 0xC0) != 0x80) {
+                    return false;
+                }
+            }
+            current += sequenceLength;
+        }
+        return true;
+    }
+}
+
 class UTF8ValidatorTest : public CppUnit::TestFixture {
     CPPUNIT_TEST_SUITE(UTF8ValidatorTest);
 
     CPPUNIT_TEST(testValidUTF8Sequences);
     CPPUNIT_TEST(testInvalidUTF8Sequences);
+    CPPUNIT_TEST(testAllTwoByteStrings);
+    CPPUNIT_TEST(testThreeAndFourByteStrings);
+    CPPUNIT_TEST(testRandomStrings);
+    CPPUNIT_TEST(testCharType);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -49,6 +92,74 @@ public:
         }
     }
 
+    // Every string of up to two bytes, preceded and followed by ASCII runs
+    // ending around vector boundaries
+    void testAllTwoByteStrings() {
+        for (size_t prefix : {0, 1, 15, 16, 17, 31, 32, 33}) {
+            for (size_t suffix : {0, 20}) {
+                std::vector<unsigned char> data(prefix + 2 + suffix, 'a');
+                for (int first = 0; first < 256; ++first) {
+                    data[prefix] = static_cast<unsigned char>(first);
+                    CPPUNIT_ASSERT_EQUAL(isValidReference(&data[0], prefix + 1), UTF8IsValid(&data[0], prefix + 1));
+                    for (int second = 0; second < 256; ++second) {
+                        data[prefix + 1] = static_cast<unsigned char>(second);
+                        CPPUNIT_ASSERT_EQUAL(isValidReference(&data[0], data.size()), UTF8IsValid(&data[0], data.size()));
+                    }
+                }
+            }
+        }
+    }
+
+    // Every lead byte, followed by bytes from each range that makes a
+    // difference to the validity
+    void testThreeAndFourByteStrings() {
+        const unsigned char followers[] = { 0x00, 0x41, 0x7F, 0x80, 0x9F, 0xBF, 0xC0, 0xC3, 0xDF, 0xE0, 0xEF, 0xF0, 0xF4, 0xF8, 0xFF };
+        unsigned char data[4];
+        for (int lead = 0; lead < 256; ++lead) {
+            data[0] = static_cast<unsigned char>(lead);
+            for (unsigned char second : followers) {
+                data[1] = second;
+                for (unsigned char third : followers) {
+                    data[2] = third;
+                    CPPUNIT_ASSERT_EQUAL(isValidReference(data, 3), UTF8IsValid(data, 3));
+                    for (unsigned char fourth : followers) {
+                        data[3] = fourth;
+                        CPPUNIT_ASSERT_EQUAL(isValidReference(data, 4), UTF8IsValid(data, 4));
+                    }
+                }
+            }
+        }
+    }
+
+    // Mostly valid text, with ASCII runs spanning several vectors, and the
+    // occasional corrupt byte
+    void testRandomStrings() {
+        const std::vector<std::vector<unsigned char> > pieces = {
+            {'a'}, {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q'},
+            {0xc3, 0xa9}, {0xe2, 0x82, 0xac}, {0xf0, 0x9f, 0x98, 0x80}
+        };
+        std::mt19937 random(0);
+        for (int i = 0; i < 5000; ++i) {
+            std::vector<unsigned char> data;
+            while (data.size() < 200) {
+                const std::vector<unsigned char>& piece = pieces[random() % pieces.size()];
+                data.insert(data.end(), piece.begin(), piece.end());
+            }
+            if (i % 2) {
+                data[random() % data.size()] = static_cast<unsigned char>(random());
+            }
+            size_t length = random() % data.size();
+            CPPUNIT_ASSERT_EQUAL(isValidReference(&data[0], length), UTF8IsValid(&data[0], length));
+        }
+    }
+
+    void testCharType() {
+        std::string valid("tron\xc3\xa7on");
+        std::string invalid("tron\xc3");
+
+        CPPUNIT_ASSERT(UTF8IsValid(valid.data(), valid.size()));
+        CPPUNIT_ASSERT(!UTF8IsValid(invalid.data(), invalid.size()));
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(UTF8ValidatorTest);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,6 +11,7 @@
 #include <vector>
 
 #ifdef SWIFTEN_CACHE_JID_PREP
+#include <algorithm>
 #include <mutex>
 #include <unordered_map>
 #endif
@@ -52,6 +53,50 @@ namespace {
 }
 #endif
 
+static bool prepareComponents(const std::string& node, const std::string& domain, const std::string& resource, std::string& preparedNode, std::string& preparedDomain, std::string& preparedResource) {
+    if (!idnConverter->getIDNAEncoded(domain)) {
+        return false;
+    }
+    boost::optional<std::string> nodeResult = idnConverter->getStringPreparedIfValid(node, IDNConverter::XMPPNodePrep);
+    boost::optional<std::string> domainResult = idnConverter->getStringPreparedIfValid(domain, IDNConverter::NamePrep);
+    boost::optional<std::string> resourceResult = idnConverter->getStringPreparedIfValid(resource, IDNConverter::XMPPResourcePrep);
+    if (!nodeResult || !domainResult || !resourceResult) {
+        return false;
+    }
+    preparedNode = std::move(*nodeResult);
+    preparedDomain = std::move(*domainResult);
+    preparedResource = std::move(*resourceResult);
+    return true;
+}
+
+#ifdef SWIFTEN_CACHE_JID_PREP
+/**
+ * Returns whether \p s is plain ASCII, which the IDN converter prepares
+ * without the IDN library. Preparing such strings is cheaper than looking
+ * them up in the cache.
+ */
+static bool isASCII(const std::string& s) {
+    return std::all_of(s.begin(), s.end(), [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+}
+
+static bool getCachedStringPrepared(PrepCache& cache, const std::string& s, IDNConverter::StringPrepProfile profile, std::string& result) {
+    PrepCache::const_iterator i = cache.find(s);
+    if (i == cache.end()) {
+        // Only valid domains are cached, so they are not encoded again on later lookups
+        if (profile == IDNConverter::NamePrep && !idnConverter->getIDNAEncoded(s)) {
+            return false;
+        }
+        boost::optional<std::string> prepared = idnConverter->getStringPreparedIfValid(s, profile);
+        if (!prepared) {
+            return false;
+        }
+        i = cache.insert(std::make_pair(s, *prepared)).first;
+    }
+    result = i->second;
+    return true;
+}
+#endif
+
 static std::string getEscaped(char c) {
     return makeString() << '\\' << std::hex << static_cast<int>(c);
 }
@@ -115,62 +160,33 @@ void JID::initializeFromString(const std::string& jid) {
 
 
 void JID::nameprepAndSetComponents(const std::string& node, const std::string& domain, const std::string& resource) {
-    if (domain.empty() || !idnConverter->getIDNAEncoded(domain)) {
+    if (domain.empty() || (hasResource_ && resource.empty())) {
         valid_ = false;
         return;
     }
 
-    if (hasResource_ && resource.empty()) {
+#ifndef SWIFTEN_CACHE_JID_PREP
+    if (!prepareComponents(node, domain, resource, node_, domain_, resource_)) {
         valid_ = false;
         return;
     }
-#ifndef SWIFTEN_CACHE_JID_PREP
-    node_ = idnConverter->getStringPrepared(node, IDNConverter::XMPPNodePrep);
-    domain_ = idnConverter->getStringPrepared(domain, IDNConverter::NamePrep);
-    resource_ = idnConverter->getStringPrepared(resource, IDNConverter::XMPPResourcePrep);
 #else
-    std::unique_lock<std::mutex> lock(namePrepCacheMutex);
-
-    std::pair<PrepCache::iterator, bool> r;
-
-    r = nodePrepCache.insert(std::make_pair(node, std::string()));
-    if (r.second) {
-        try {
-            r.first->second = idnConverter->getStringPrepared(node, IDNConverter::XMPPNodePrep);
-        }
-        catch (...) {
-            nodePrepCache.erase(r.first);
+    if (isASCII(node) && isASCII(domain) && isASCII(resource)) {
+        if (!prepareComponents(node, domain, resource, node_, domain_, resource_)) {
             valid_ = false;
             return;
         }
     }
-    node_ = r.first->second;
-
-    r = domainPrepCache.insert(std::make_pair(domain, std::string()));
-    if (r.second) {
-        try {
-            r.first->second = idnConverter->getStringPrepared(domain, IDNConverter::NamePrep);
-        }
-        catch (...) {
-            domainPrepCache.erase(r.first);
-            valid_ = false;
-            return;
-        }
-    }
-    domain_ = r.first->second;
+    else {
+        std::unique_lock<std::mutex> lock(namePrepCacheMutex);
 
-    r = resourcePrepCache.insert(std::make_pair(resource, std::string()));
-    if (r.second) {
-        try {
-            r.first->second = idnConverter->getStringPrepared(resource, IDNConverter::XMPPResourcePrep);
-        }
-        catch (...) {
-            resourcePrepCache.erase(r.first);
+        if (!getCachedStringPrepared(nodePrepCache, node, IDNConverter::XMPPNodePrep, node_)
+                || !getCachedStringPrepared(domainPrepCache, domain, IDNConverter::NamePrep, domain_)
+                || !getCachedStringPrepared(resourcePrepCache, resource, IDNConverter::XMPPResourcePrep, resource_)) {
             valid_ = false;
             return;
         }
     }
-    resource_ = r.first->second;
 #endif
 
     if (domain_.empty()) {
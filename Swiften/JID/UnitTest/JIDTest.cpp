@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -29,6 +29,10 @@ class JIDTest : public CppUnit::TestFixture
         CPPUNIT_TEST(testConstructorWithString_EmptyDomainWithResource);
         CPPUNIT_TEST(testConstructorWithString_IllegalResource);
         CPPUNIT_TEST(testConstructorWithString_SpacesInNode);
+        CPPUNIT_TEST(testConstructorWithString_CanonicalASCII);
+        CPPUNIT_TEST(testConstructorWithString_UpperCaseASCII);
+        CPPUNIT_TEST(testConstructorWithString_InvalidDomainLabels);
+        CPPUNIT_TEST(testConstructorWithString_ProhibitedASCIINode);
         CPPUNIT_TEST(testConstructorWithStrings);
         CPPUNIT_TEST(testConstructorWithStrings_EmptyDomain);
         CPPUNIT_TEST(testConstructorWithStrings_EmptyResource);
@@ -176,6 +180,38 @@ class JIDTest : public CppUnit::TestFixture
             CPPUNIT_ASSERT(!JID("alice   @wonderland.lit").isValid());
         }
 
+        void testConstructorWithString_CanonicalASCII() {
+            JID testling("alice-1@rabbit-hole.wonderland.lit/Tea Party!");
+
+            CPPUNIT_ASSERT(testling.isValid());
+            CPPUNIT_ASSERT_EQUAL(std::string("alice-1"), testling.getNode());
+            CPPUNIT_ASSERT_EQUAL(std::string("rabbit-hole.wonderland.lit"), testling.getDomain());
+            CPPUNIT_ASSERT_EQUAL(std::string("Tea Party!"), testling.getResource());
+        }
+
+        void testConstructorWithString_UpperCaseASCII() {
+            JID testling("Alice@Wonderland.LIT/Home");
+
+            CPPUNIT_ASSERT(testling.isValid());
+            CPPUNIT_ASSERT_EQUAL(std::string("alice"), testling.getNode());
+            CPPUNIT_ASSERT_EQUAL(std::string("wonderland.lit"), testling.getDomain());
+            CPPUNIT_ASSERT_EQUAL(std::string("Home"), testling.getResource());
+        }
+
+        void testConstructorWithString_InvalidDomainLabels() {
+            CPPUNIT_ASSERT(!JID("alice@-wonderland.lit").isValid());
+            CPPUNIT_ASSERT(!JID("alice@wonderland-.lit").isValid());
+            CPPUNIT_ASSERT(!JID("alice@wonderland..lit").isValid());
+            CPPUNIT_ASSERT(!JID("alice@" + std::string(64, 'a') + ".lit").isValid());
+            CPPUNIT_ASSERT(JID("alice@" + std::string(63, 'a') + ".lit").isValid());
+        }
+
+        void testConstructorWithString_ProhibitedASCIINode() {
+            CPPUNIT_ASSERT(!JID("al:ice@wonderland.lit").isValid());
+            CPPUNIT_ASSERT(!JID("al<ice@wonderland.lit").isValid());
+            CPPUNIT_ASSERT(!JID("al\"ice@wonderland.lit").isValid());
+        }
+
         void testConstructorWithStrings() {
             JID testling("foo", "bar", "baz");
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -14,6 +14,7 @@
 #include <boost/signals2/connection.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Elements/Form.h>
 #include <Swiften/Elements/MUCAdminPayload.h>
 #include <Swiften/Elements/MUCOccupant.h>
@@ -119,7 +120,7 @@ namespace Swift {
             std::map<std::string, MUCOccupant> occupants;
             bool joinSucceeded_ = false;
             bool joinComplete_ = false;
-            boost::signals2::scoped_connection scopedConnection_;
+            ScopedSignalConnection scopedConnection_;
             boost::posix_time::ptime joinSince_;
             bool createAsReservedIfNew = false;
             bool unlocking = false;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -52,7 +52,7 @@ class SharedBuffer {
 // -----------------------------------------------------------------------------
 
 BoostConnection::BoostConnection(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop) :
-    eventLoop(eventLoop), ioService(ioService), socket_(*ioService), writing_(false), closeSocketAfterNextWrite_(false) {
+    eventLoop(eventLoop), ioService(ioService), socket_(*ioService), writing_(false), closeSocketAfterNextWrite_(false), readingPaused_(false), readStopped_(false) {
 }
 
 BoostConnection::~BoostConnection() {
@@ -102,6 +102,23 @@ void BoostConnection::write(const SafeByteArray& data) {
     }
 }
 
+void BoostConnection::setReadingPaused(bool paused) {
+    bool resume = false;
+    {
+        std::lock_guard<std::mutex> lock(readPauseMutex_);
+        readingPaused_ = paused;
+        if (!paused && readStopped_) {
+            readStopped_ = false;
+            resume = true;
+        }
+    }
+    // A read that is still pending when pausing completes normally; only
+    // the next one is held back.
+    if (resume) {
+        doRead();
+    }
+}
+
 void BoostConnection::doWrite(const SafeByteArray& data) {
     boost::asio::async_write(socket_, SharedBuffer(data),
             boost::bind(&BoostConnection::handleDataWritten, shared_from_this(), boost::asio::placeholders::error));
@@ -131,6 +148,13 @@ void BoostConnection::handleSocketRead(const boost::system::error_code& error, s
     if (!error) {
         readBuffer_->resize(bytesTransferred);
         eventLoop->postEvent(boost::bind(boost::ref(onDataRead), readBuffer_), shared_from_this());
+        {
+            std::lock_guard<std::mutex> lock(readPauseMutex_);
+            if (readingPaused_) {
+                readStopped_ = true;
+                return;
+            }
+        }
         doRead();
     }
     else if (/*error == boost::asio::error::eof ||*/ error == boost::asio::error::operation_aborted) {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -37,6 +37,7 @@ namespace Swift {
             virtual void connect(const HostAddressPort& address);
             virtual void disconnect();
             virtual void write(const SafeByteArray& data);
+            virtual void setReadingPaused(bool paused);
 
             boost::asio::ip::tcp::socket& getSocket() {
                 return socket_;
@@ -71,5 +72,8 @@ namespace Swift {
             SafeByteArray writeQueue_;
             bool closeSocketAfterNextWrite_;
             std::mutex readCloseMutex_;
+            std::mutex readPauseMutex_;
+            bool readingPaused_;
+            bool readStopped_;
     };
 }
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Network/ChainedConnector.h>
 
+#include <algorithm>
 #include <typeinfo>
 
 #include <boost/bind.hpp>
@@ -13,6 +14,8 @@
 #include <Swiften/Base/Log.h>
 #include <Swiften/Network/ConnectionFactory.h>
 #include <Swiften/Network/Connector.h>
+#include <Swiften/Network/Timer.h>
+#include <Swiften/Network/TimerFactory.h>
 
 using namespace Swift;
 
@@ -29,67 +32,124 @@ ChainedConnector::ChainedConnector(
             resolver(resolver),
             connectionFactories(connectionFactories),
             timerFactory(timerFactory),
-            timeoutMilliseconds(0) {
+            timeoutMilliseconds(0),
+            attemptDelayMilliseconds(2000) {
 }
 
 ChainedConnector::~ChainedConnector() {
-    if (currentConnector) {
-        currentConnector->onConnectFinished.disconnect(boost::bind(&ChainedConnector::handleConnectorFinished, this, _1, _2));
-        currentConnector->stop();
-        currentConnector.reset();
-    }
+    stopConnectors();
 }
 
 void ChainedConnector::setTimeoutMilliseconds(int milliseconds) {
     timeoutMilliseconds = milliseconds;
 }
 
+void ChainedConnector::setAttemptDelayMilliseconds(int milliseconds) {
+    attemptDelayMilliseconds = milliseconds;
+}
+
+void ChainedConnector::setPreferredEndpoint(const boost::optional<Endpoint>& endpoint) {
+    preferredEndpoint = endpoint;
+}
+
 void ChainedConnector::start() {
     SWIFT_LOG(debug) << "Starting queued connector for " << hostname << std::endl;
 
-    connectionFactoryQueue = std::deque<ConnectionFactory*>(connectionFactories.begin(), connectionFactories.end());
+    connectionFactoryQueue.assign(connectionFactories.begin(), connectionFactories.end());
+    if (preferredEndpoint) {
+        auto i = std::find(connectionFactoryQueue.begin(), connectionFactoryQueue.end(), preferredEndpoint->connectionFactory);
+        if (preferredEndpoint->hostname != hostname || i == connectionFactoryQueue.end()) {
+            preferredEndpoint.reset();
+        }
+        else {
+            // Start with the connection factory that connected last time
+            connectionFactoryQueue.erase(i);
+            connectionFactoryQueue.push_front(preferredEndpoint->connectionFactory);
+        }
+    }
     tryNextConnectionFactory();
 }
 
 void ChainedConnector::stop() {
-    if (currentConnector) {
-        currentConnector->onConnectFinished.disconnect(boost::bind(&ChainedConnector::handleConnectorFinished, this, _1, _2));
-        currentConnector->stop();
-        currentConnector.reset();
-    }
+    stopConnectors();
     finish(std::shared_ptr<Connection>(), std::shared_ptr<Error>());
 }
 
+void ChainedConnector::stopConnectors() {
+    if (attemptDelayTimer) {
+        attemptDelayTimer->stop();
+        attemptDelayTimer->onTick.disconnect(boost::bind(&ChainedConnector::handleAttemptDelayTimeout, this));
+        attemptDelayTimer.reset();
+    }
+    std::vector<std::pair<std::shared_ptr<Connector>, ConnectionFactory*> > stoppedConnectors;
+    stoppedConnectors.swap(connectors);
+    for (const auto& connector : stoppedConnectors) {
+        connector.first->onConnectFinished.disconnect(boost::bind(&ChainedConnector::handleConnectorFinished, this, connector.first, _1, _2));
+        connector.first->stop();
+    }
+}
+
 void ChainedConnector::tryNextConnectionFactory() {
-    assert(!currentConnector);
     if (connectionFactoryQueue.empty()) {
-        SWIFT_LOG(debug) << "No more connection factories" << std::endl;
-        finish(std::shared_ptr<Connection>(), lastError);
+        if (connectors.empty()) {
+            SWIFT_LOG(debug) << "No more connection factories" << std::endl;
+            stopConnectors();
+            finish(std::shared_ptr<Connection>(), lastError);
+        }
+        return;
     }
-    else {
-        ConnectionFactory* connectionFactory = connectionFactoryQueue.front();
-        SWIFT_LOG(debug) << "Trying next connection factory: " << typeid(*connectionFactory).name() << std::endl;
-        connectionFactoryQueue.pop_front();
-        currentConnector = Connector::create(hostname, port, serviceLookupPrefix, resolver, connectionFactory, timerFactory);
-        currentConnector->setTimeoutMilliseconds(timeoutMilliseconds);
-        currentConnector->onConnectFinished.connect(boost::bind(&ChainedConnector::handleConnectorFinished, this, _1, _2));
-        currentConnector->start();
+
+    ConnectionFactory* connectionFactory = connectionFactoryQueue.front();
+    SWIFT_LOG(debug) << "Trying next connection factory: " << typeid(*connectionFactory).name() << std::endl;
+    connectionFactoryQueue.pop_front();
+    std::shared_ptr<Connector> connector = Connector::create(hostname, port, serviceLookupPrefix, resolver, connectionFactory, timerFactory);
+    connector->setTimeoutMilliseconds(timeoutMilliseconds);
+    if (preferredEndpoint && preferredEndpoint->connectionFactory == connectionFactory) {
+        connector->setPreferredAddress(preferredEndpoint->address);
     }
+    connector->onConnectFinished.connect(boost::bind(&ChainedConnector::handleConnectorFinished, this, connector, _1, _2));
+    connectors.push_back(std::make_pair(connector, connectionFactory));
+
+    if (attemptDelayMilliseconds > 0 && !connectionFactoryQueue.empty()) {
+        if (!attemptDelayTimer) {
+            attemptDelayTimer = timerFactory->createTimer(attemptDelayMilliseconds);
+            attemptDelayTimer->onTick.connect(boost::bind(&ChainedConnector::handleAttemptDelayTimeout, this));
+        }
+        attemptDelayTimer->stop();
+        attemptDelayTimer->start();
+    }
+    connector->start();
 }
 
-void ChainedConnector::handleConnectorFinished(std::shared_ptr<Connection> connection, std::shared_ptr<Error> error) {
+void ChainedConnector::handleConnectorFinished(std::shared_ptr<Connector> connector, std::shared_ptr<Connection> connection, std::shared_ptr<Error> error) {
     SWIFT_LOG(debug) << "Connector finished" << std::endl;
-    currentConnector->onConnectFinished.disconnect(boost::bind(&ChainedConnector::handleConnectorFinished, this, _1, _2));
+    connector->onConnectFinished.disconnect(boost::bind(&ChainedConnector::handleConnectorFinished, this, connector, _1, _2));
+    auto i = std::find_if(connectors.begin(), connectors.end(), [&](const std::pair<std::shared_ptr<Connector>, ConnectionFactory*>& entry) {
+        return entry.first == connector;
+    });
+    assert(i != connectors.end());
+    ConnectionFactory* connectionFactory = i->second;
+    connectors.erase(i);
     lastError = error;
-    currentConnector.reset();
     if (connection) {
+        if (connector->getConnectedAddress()) {
+            connectedEndpoint = Endpoint(hostname, connectionFactory, *connector->getConnectedAddress());
+        }
+        // Cancel the connectors that lost the race
+        stopConnectors();
         finish(connection, error);
     }
     else {
+        // Try the next connection factory straight away, without waiting for the attempt delay
         tryNextConnectionFactory();
     }
 }
 
+void ChainedConnector::handleAttemptDelayTimeout() {
+    SWIFT_LOG(debug) << "Attempt delay passed" << std::endl;
+    tryNextConnectionFactory();
+}
+
 void ChainedConnector::finish(std::shared_ptr<Connection> connection, std::shared_ptr<Error> error) {
     onConnectFinished(connection, error);
 }
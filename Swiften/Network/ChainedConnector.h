@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,6 +16,7 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/Error.h>
+#include <Swiften/Network/HostAddressPort.h>
 
 namespace Swift {
     class Connection;
@@ -23,22 +24,67 @@ namespace Swift {
     class ConnectionFactory;
     class TimerFactory;
     class DomainNameResolver;
+    class Timer;
 
+    /**
+     * Connects to a host through the first of a list of connection factories (e.g. proxies,
+     * followed by a direct connection) that succeeds.
+     *
+     * When a connection factory hasn't connected within the attempt delay, the next one is
+     * tried in parallel, and the first one to connect wins.
+     */
     class SWIFTEN_API ChainedConnector {
+        public:
+            /**
+             * The connection factory and the address a connection was made with.
+             */
+            struct Endpoint {
+                Endpoint(const std::string& hostname, ConnectionFactory* connectionFactory, const HostAddressPort& address) : hostname(hostname), connectionFactory(connectionFactory), address(address) {}
+
+                std::string hostname;
+                ConnectionFactory* connectionFactory;
+                HostAddressPort address;
+            };
+
         public:
             ChainedConnector(const std::string& hostname, int port, const boost::optional<std::string>& serviceLookupPrefix, DomainNameResolver*, const std::vector<ConnectionFactory*>&, TimerFactory*);
             ~ChainedConnector();
 
             void setTimeoutMilliseconds(int milliseconds);
+
+            /**
+             * Sets how long to wait for a connection factory to connect before trying the
+             * next one in parallel. Connection factories are tried one at a time when this
+             * is 0. Defaults to 2 seconds.
+             */
+            void setAttemptDelayMilliseconds(int milliseconds);
+
+            /**
+             * Sets the endpoint to try first (e.g. the one of the previous successful
+             * connection). It is ignored when it is for a different host, or for a
+             * connection factory that is not in the list of connection factories.
+             */
+            void setPreferredEndpoint(const boost::optional<Endpoint>& endpoint);
+
             void start();
             void stop();
 
+            /**
+             * Returns the endpoint the connection was made with, once the connector
+             * finished successfully.
+             */
+            const boost::optional<Endpoint>& getConnectedEndpoint() const {
+                return connectedEndpoint;
+            }
+
             boost::signals2::signal<void (std::shared_ptr<Connection>, std::shared_ptr<Error>)> onConnectFinished;
 
         private:
             void finish(std::shared_ptr<Connection> connection, std::shared_ptr<Error>);
             void tryNextConnectionFactory();
-            void handleConnectorFinished(std::shared_ptr<Connection>, std::shared_ptr<Error>);
+            void stopConnectors();
+            void handleConnectorFinished(std::shared_ptr<Connector>, std::shared_ptr<Connection>, std::shared_ptr<Error>);
+            void handleAttemptDelayTimeout();
 
         private:
             std::string hostname;
@@ -48,8 +94,12 @@ namespace Swift {
             std::vector<ConnectionFactory*> connectionFactories;
             TimerFactory* timerFactory;
             int timeoutMilliseconds;
+            int attemptDelayMilliseconds;
+            std::shared_ptr<Timer> attemptDelayTimer;
+            boost::optional<Endpoint> preferredEndpoint;
+            boost::optional<Endpoint> connectedEndpoint;
             std::deque<ConnectionFactory*> connectionFactoryQueue;
-            std::shared_ptr<Connector> currentConnector;
+            std::vector<std::pair<std::shared_ptr<Connector>, ConnectionFactory*> > connectors;
             std::shared_ptr<Error> lastError;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,6 +12,7 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Base/Signal.h>
 
 namespace Swift {
     class HostAddressPort;
@@ -33,13 +34,23 @@ namespace Swift {
             virtual void disconnect() = 0;
             virtual void write(const SafeByteArray& data) = 0;
 
+            /**
+             * Stops (or resumes) reading from the connection, so that the
+             * peer is slowed down by flow control while the received data
+             * cannot be processed. Data that was already read is still
+             * delivered through \ref onDataRead.
+             *
+             * Connections that cannot hold back data ignore this.
+             */
+            virtual void setReadingPaused(bool /* paused */) {}
+
             virtual HostAddressPort getLocalAddress() const = 0;
             virtual HostAddressPort getRemoteAddress() const = 0;
 
         public:
             boost::signals2::signal<void (bool /* error */)> onConnectFinished;
             boost::signals2::signal<void (const boost::optional<Error>&)> onDisconnected;
-            boost::signals2::signal<void (std::shared_ptr<SafeByteArray>)> onDataRead;
-            boost::signals2::signal<void ()> onDataWritten;
+            Signal<void (std::shared_ptr<SafeByteArray>)> onDataRead;
+            Signal<void ()> onDataWritten;
     };
 }
@@ -6,6 +6,8 @@
 
 #include <Swiften/Network/Connector.h>
 
+#include <algorithm>
+
 #include <boost/bind.hpp>
 
 #include <Swiften/Base/Log.h>
@@ -17,23 +19,60 @@
 
 namespace Swift {
 
-Connector::Connector(const std::string& hostname, int port, const boost::optional<std::string>& serviceLookupPrefix, DomainNameResolver* resolver, ConnectionFactory* connectionFactory, TimerFactory* timerFactory) : hostname(hostname), port(port), serviceLookupPrefix(serviceLookupPrefix), resolver(resolver), connectionFactory(connectionFactory), timerFactory(timerFactory), timeoutMilliseconds(0), queriedAllServices(true), foundSomeDNS(false) {
+/**
+ * Orders the addresses so that the address families alternate, starting with the family
+ * of the first address (RFC 8305, section 4).
+ */
+static std::deque<HostAddress> interleaveAddressFamilies(const std::vector<HostAddress>& addresses) {
+    std::deque<HostAddress> firstFamily;
+    std::deque<HostAddress> otherFamily;
+    for (const auto& address : addresses) {
+        if (address.getRawAddress().is_v6() == addresses.front().getRawAddress().is_v6()) {
+            firstFamily.push_back(address);
+        }
+        else {
+            otherFamily.push_back(address);
+        }
+    }
+    std::deque<HostAddress> result;
+    while (!firstFamily.empty() || !otherFamily.empty()) {
+        if (!firstFamily.empty()) {
+            result.push_back(firstFamily.front());
+            firstFamily.pop_front();
+        }
+        if (!otherFamily.empty()) {
+            result.push_back(otherFamily.front());
+            otherFamily.pop_front();
+        }
+    }
+    return result;
+}
+
+Connector::Connector(const std::string& hostname, int port, const boost::optional<std::string>& serviceLookupPrefix, DomainNameResolver* resolver, ConnectionFactory* connectionFactory, TimerFactory* timerFactory) : hostname(hostname), port(port), serviceLookupPrefix(serviceLookupPrefix), resolver(resolver), connectionFactory(connectionFactory), timerFactory(timerFactory), timeoutMilliseconds(0), attemptDelayMilliseconds(250), attemptDelayPassed(false), addressQueryPort(-1), queriedAllServices(true), foundSomeDNS(false) {
 }
 
 void Connector::setTimeoutMilliseconds(int milliseconds) {
     timeoutMilliseconds = milliseconds;
 }
 
+void Connector::setAttemptDelayMilliseconds(int milliseconds) {
+    attemptDelayMilliseconds = milliseconds;
+}
+
+void Connector::setPreferredAddress(const HostAddressPort& address) {
+    preferredAddress = address;
+}
+
 void Connector::start() {
     SWIFT_LOG(debug) << "Starting connector for " << hostname << std::endl;
-    assert(!currentConnection);
+    assert(attempts.empty());
     assert(!serviceQuery);
-    assert(!timer);
+    assert(!attemptDelayTimer);
     queriedAllServices = false;
     auto hostAddress = HostAddress::fromString(hostname);
-    if (timeoutMilliseconds > 0) {
-        timer = timerFactory->createTimer(timeoutMilliseconds);
-        timer->onTick.connect(boost::bind(&Connector::handleTimeout, shared_from_this()));
+    if (preferredAddress) {
+        // Race the preferred address against the name lookups
+        tryConnect(*preferredAddress);
     }
     if (serviceLookupPrefix) {
         serviceQuery = resolver->createServiceQuery(*serviceLookupPrefix, hostname);
@@ -43,18 +82,18 @@ void Connector::start() {
     else if (hostAddress) {
         // hostname is already a valid address; skip name lookup.
         foundSomeDNS = true;
+        queriedAllServices = true;
+        addressQueryPort = (port == -1 ? 5222 : port);
         addressQueryResults.push_back(hostAddress.get());
-        tryNextAddress();
+        tryNextAttempt();
     } else {
+        queriedAllServices = true;
+        addressQueryPort = (port == -1 ? 5222 : port);
         queryAddress(hostname);
     }
 }
 
 void Connector::stop() {
-    if (currentConnection) {
-        currentConnection->onConnectFinished.disconnect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), _1));
-        currentConnection->disconnect();
-    }
     finish(std::shared_ptr<Connection>());
 }
 
@@ -72,112 +111,130 @@ void Connector::handleServiceQueryResult(const std::vector<DomainNameServiceQuer
     if (!serviceQueryResults.empty()) {
         foundSomeDNS = true;
     }
-    tryNextServiceOrFallback();
+    tryNextAttempt();
 }
 
 void Connector::tryNextServiceOrFallback() {
-    if (queriedAllServices) {
-        SWIFT_LOG(debug) << "Queried all services" << std::endl;
-        finish(std::shared_ptr<Connection>());
-    }
-    else if (serviceQueryResults.empty()) {
+    if (serviceQueryResults.empty()) {
         SWIFT_LOG(debug) << "Falling back on A resolution" << std::endl;
         // Fall back on simple address resolving
         queriedAllServices = true;
+        addressQueryPort = (port == -1 ? 5222 : port);
         queryAddress(hostname);
     }
     else {
         SWIFT_LOG(debug) << "Querying next address" << std::endl;
-        queryAddress(serviceQueryResults.front().hostname);
+        DomainNameServiceQuery::Result service = serviceQueryResults.front();
+        serviceQueryResults.pop_front();
+        addressQueryPort = service.port;
+        queryAddress(service.hostname);
     }
 }
 
 void Connector::handleAddressQueryResult(const std::vector<HostAddress>& addresses, boost::optional<DomainNameResolveError> error) {
     SWIFT_LOG(debug) << addresses.size() << " addresses" << std::endl;
     addressQuery.reset();
-    if (error || addresses.empty()) {
-        if (!serviceQueryResults.empty()) {
-            serviceQueryResults.pop_front();
-        }
-        tryNextServiceOrFallback();
-    }
-    else {
+    if (!error && !addresses.empty()) {
         foundSomeDNS = true;
-        addressQueryResults = std::deque<HostAddress>(addresses.begin(), addresses.end());
-        tryNextAddress();
+        addressQueryResults = interleaveAddressFamilies(addresses);
     }
+    tryNextAttempt();
 }
 
-void Connector::tryNextAddress() {
-    if (addressQueryResults.empty()) {
-        SWIFT_LOG(debug) << "Done trying addresses. Moving on." << std::endl;
-        // Done trying all addresses. Move on to the next host.
-        if (!serviceQueryResults.empty()) {
-            serviceQueryResults.pop_front();
+void Connector::tryNextAttempt() {
+    while (!addressQueryResults.empty() && std::find(attemptedTargets.begin(), attemptedTargets.end(), HostAddressPort(addressQueryResults.front(), addressQueryPort)) != attemptedTargets.end()) {
+        addressQueryResults.pop_front();
+    }
+    if (!addressQueryResults.empty()) {
+        if (attempts.empty() || (attemptDelayMilliseconds > 0 && attemptDelayPassed)) {
+            SWIFT_LOG(debug) << "Trying next address" << std::endl;
+            HostAddress address = addressQueryResults.front();
+            addressQueryResults.pop_front();
+            tryConnect(HostAddressPort(address, addressQueryPort));
         }
-        tryNextServiceOrFallback();
+        // Otherwise, give the attempts in progress a head start
     }
-    else {
-        SWIFT_LOG(debug) << "Trying next address" << std::endl;
-        HostAddress address = addressQueryResults.front();
-        addressQueryResults.pop_front();
-
-        int connectPort = (port == -1 ? 5222 : port);
-        if (!serviceQueryResults.empty()) {
-            connectPort = serviceQueryResults.front().port;
+    else if (serviceQuery || addressQuery) {
+        // Wait for the name lookup in progress
+    }
+    else if (queriedAllServices) {
+        if (attempts.empty()) {
+            SWIFT_LOG(debug) << "Queried all services" << std::endl;
+            finish(std::shared_ptr<Connection>());
         }
-
-        tryConnect(HostAddressPort(address, connectPort));
+    }
+    else {
+        SWIFT_LOG(debug) << "Done trying addresses. Moving on." << std::endl;
+        // Done trying all addresses of this host. Move on to the next host, while any
+        // attempts still in progress continue.
+        tryNextServiceOrFallback();
     }
 }
 
 void Connector::tryConnect(const HostAddressPort& target) {
-    assert(!currentConnection);
     SWIFT_LOG(debug) << "Trying to connect to " << target.getAddress().toString() << ":" << target.getPort() << std::endl;
-    currentConnection = connectionFactory->createConnection();
-    currentConnection->onConnectFinished.connect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), _1));
-    currentConnection->connect(target);
-    if (timer) {
-        timer->start();
+    std::shared_ptr<ConnectionAttempt> attempt = std::make_shared<ConnectionAttempt>();
+    attempt->target = target;
+    attempt->connection = connectionFactory->createConnection();
+    attempt->connection->onConnectFinished.connect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), attempt, _1));
+    attempts.push_back(attempt);
+    attemptedTargets.push_back(target);
+    if (attemptDelayMilliseconds > 0) {
+        if (!attemptDelayTimer) {
+            attemptDelayTimer = timerFactory->createTimer(attemptDelayMilliseconds);
+            attemptDelayTimer->onTick.connect(boost::bind(&Connector::handleAttemptDelayTimeout, shared_from_this()));
+        }
+        attemptDelayTimer->stop();
+        attemptDelayPassed = false;
+        attemptDelayTimer->start();
+    }
+    attempt->connection->connect(target);
+    if (timeoutMilliseconds > 0 && isAttemptInProgress(attempt)) {
+        attempt->timer = timerFactory->createTimer(timeoutMilliseconds);
+        attempt->timer->onTick.connect(boost::bind(&Connector::handleTimeout, shared_from_this(), attempt));
+        attempt->timer->start();
     }
 }
 
-void Connector::handleConnectionConnectFinished(bool error) {
-    SWIFT_LOG(debug) << "ConnectFinished: " << (error ? "error" : "success") << std::endl;
-    if (timer) {
-            timer->stop();
-            timer.reset();
+void Connector::removeAttempt(std::shared_ptr<ConnectionAttempt> attempt) {
+    attempt->connection->onConnectFinished.disconnect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), attempt, _1));
+    if (attempt->timer) {
+        attempt->timer->stop();
+        attempt->timer->onTick.disconnect(boost::bind(&Connector::handleTimeout, shared_from_this(), attempt));
     }
-    if (!currentConnection) {
+    attempts.erase(std::remove(attempts.begin(), attempts.end(), attempt), attempts.end());
+}
+
+bool Connector::isAttemptInProgress(std::shared_ptr<ConnectionAttempt> attempt) const {
+    return std::find(attempts.begin(), attempts.end(), attempt) != attempts.end();
+}
+
+void Connector::handleConnectionConnectFinished(std::shared_ptr<ConnectionAttempt> attempt, bool error) {
+    SWIFT_LOG(debug) << "ConnectFinished: " << (error ? "error" : "success") << std::endl;
+    if (!isAttemptInProgress(attempt)) {
         // We've hit a race condition where multiple finisheds were on the eventloop queue at once.
         // This is particularly likely on macOS where the hourly momentary wakeup while asleep
         // can cause both a timeout and an onConnectFinished to be queued sequentially (SWIFT-232).
         // Let the first one process as normal, but ignore the second.
         return;
     }
-    currentConnection->onConnectFinished.disconnect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), _1));
+    removeAttempt(attempt);
     if (error) {
-        currentConnection.reset();
-        if (!addressQueryResults.empty()) {
-            tryNextAddress();
-        }
-        else {
-            if (!serviceQueryResults.empty()) {
-                serviceQueryResults.pop_front();
-            }
-            tryNextServiceOrFallback();
-        }
+        // Don't wait for the attempt delay to pass before trying the next address
+        attemptDelayPassed = true;
+        tryNextAttempt();
     }
     else {
-        finish(currentConnection);
+        connectedAddress = attempt->target;
+        finish(attempt->connection);
     }
 }
 
 void Connector::finish(std::shared_ptr<Connection> connection) {
-    if (timer) {
-        timer->stop();
-        timer->onTick.disconnect(boost::bind(&Connector::handleTimeout, shared_from_this()));
-        timer.reset();
+    if (attemptDelayTimer) {
+        attemptDelayTimer->stop();
+        attemptDelayTimer->onTick.disconnect(boost::bind(&Connector::handleAttemptDelayTimeout, shared_from_this()));
+        attemptDelayTimer.reset();
     }
     if (serviceQuery) {
         serviceQuery->onResult.disconnect(boost::bind(&Connector::handleServiceQueryResult, shared_from_this(), _1));
@@ -187,17 +244,30 @@ void Connector::finish(std::shared_ptr<Connection> connection) {
         addressQuery->onResult.disconnect(boost::bind(&Connector::handleAddressQueryResult, shared_from_this(), _1, _2));
         addressQuery.reset();
     }
-    if (currentConnection) {
-        currentConnection->onConnectFinished.disconnect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), _1));
-        currentConnection.reset();
+    // Cancel the attempts that lost the race
+    std::vector<std::shared_ptr<ConnectionAttempt> > cancelledAttempts(attempts);
+    for (const auto& attempt : cancelledAttempts) {
+        removeAttempt(attempt);
+        attempt->connection->disconnect();
     }
     onConnectFinished(connection, (connection || foundSomeDNS) ? std::shared_ptr<Error>() : std::make_shared<DomainNameResolveError>());
 }
 
-void Connector::handleTimeout() {
+void Connector::handleTimeout(std::shared_ptr<ConnectionAttempt> attempt) {
     SWIFT_LOG(debug) << "Timeout" << std::endl;
-    SWIFT_LOG_ASSERT(currentConnection, error) << "Connection not valid but triggered a timeout" <<std::endl;
-    handleConnectionConnectFinished(true);
+    if (!isAttemptInProgress(attempt)) {
+        return;
+    }
+    removeAttempt(attempt);
+    attempt->connection->disconnect();
+    attemptDelayPassed = true;
+    tryNextAttempt();
+}
+
+void Connector::handleAttemptDelayTimeout() {
+    SWIFT_LOG(debug) << "Attempt delay passed" << std::endl;
+    attemptDelayPassed = true;
+    tryNextAttempt();
 }
 
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,6 +9,7 @@
 #include <deque>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/optional.hpp>
 #include <boost/signals2.hpp>
@@ -26,6 +27,14 @@ namespace Swift {
     class ConnectionFactory;
     class TimerFactory;
 
+    /**
+     * Connects to a host, trying the addresses of all its (SRV) targets.
+     *
+     * Connection attempts are staggered rather than made strictly one after another
+     * (RFC 8305): when an attempt hasn't completed within the attempt delay, the next
+     * address is tried in parallel, with address families alternating. The first
+     * attempt to succeed wins, and the others are cancelled.
+     */
     class SWIFTEN_API Connector : public boost::signals2::trackable, public std::enable_shared_from_this<Connector> {
         public:
             typedef std::shared_ptr<Connector> ref;
@@ -35,6 +44,20 @@ namespace Swift {
             }
 
             void setTimeoutMilliseconds(int milliseconds);
+
+            /**
+             * Sets how long to wait for a connection attempt before starting the next one
+             * in parallel. Attempts are made one at a time when this is 0.
+             * Defaults to 250 milliseconds.
+             */
+            void setAttemptDelayMilliseconds(int milliseconds);
+
+            /**
+             * Sets an address to try straight away, in parallel with the name lookups
+             * (e.g. the address of the previous successful connection).
+             */
+            void setPreferredAddress(const HostAddressPort& address);
+
             /**
              * Start the connection attempt.
              * Note that after calling this method, the caller is responsible for calling #stop()
@@ -43,8 +66,23 @@ namespace Swift {
             void start();
             void stop();
 
+            /**
+             * Returns the address the connection was made to, once the connector
+             * finished successfully.
+             */
+            const boost::optional<HostAddressPort>& getConnectedAddress() const {
+                return connectedAddress;
+            }
+
             boost::signals2::signal<void (std::shared_ptr<Connection>, std::shared_ptr<Error>)> onConnectFinished;
 
+        private:
+            struct ConnectionAttempt {
+                HostAddressPort target;
+                std::shared_ptr<Connection> connection;
+                std::shared_ptr<Timer> timer;
+            };
+
         private:
             Connector(const std::string& hostname, int port, const boost::optional<std::string>& serviceLookupPrefix, DomainNameResolver*, ConnectionFactory*, TimerFactory*);
 
@@ -53,13 +91,15 @@ namespace Swift {
             void queryAddress(const std::string& hostname);
 
             void tryNextServiceOrFallback();
-            void tryNextAddress();
+            void tryNextAttempt();
             void tryConnect(const HostAddressPort& target);
+            void removeAttempt(std::shared_ptr<ConnectionAttempt> attempt);
+            bool isAttemptInProgress(std::shared_ptr<ConnectionAttempt> attempt) const;
 
-            void handleConnectionConnectFinished(bool error);
+            void handleConnectionConnectFinished(std::shared_ptr<ConnectionAttempt> attempt, bool error);
             void finish(std::shared_ptr<Connection>);
-            void handleTimeout();
-
+            void handleTimeout(std::shared_ptr<ConnectionAttempt> attempt);
+            void handleAttemptDelayTimeout();
 
         private:
             std::string hostname;
@@ -69,13 +109,19 @@ namespace Swift {
             ConnectionFactory* connectionFactory;
             TimerFactory* timerFactory;
             int timeoutMilliseconds;
-            std::shared_ptr<Timer> timer;
+            int attemptDelayMilliseconds;
+            std::shared_ptr<Timer> attemptDelayTimer;
+            bool attemptDelayPassed;
             std::shared_ptr<DomainNameServiceQuery> serviceQuery;
             std::deque<DomainNameServiceQuery::Result> serviceQueryResults;
             std::shared_ptr<DomainNameAddressQuery> addressQuery;
             std::deque<HostAddress> addressQueryResults;
+            int addressQueryPort;
             bool queriedAllServices;
-            std::shared_ptr<Connection> currentConnection;
+            std::vector<std::shared_ptr<ConnectionAttempt> > attempts;
+            std::vector<HostAddressPort> attemptedTargets;
+            boost::optional<HostAddressPort> preferredAddress;
+            boost::optional<HostAddressPort> connectedAddress;
             bool foundSomeDNS;
     };
 }
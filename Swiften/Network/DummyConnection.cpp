@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,7 +13,7 @@
 
 namespace Swift {
 
-DummyConnection::DummyConnection(EventLoop* eventLoop) : eventLoop(eventLoop) {
+DummyConnection::DummyConnection(EventLoop* eventLoop) : eventLoop(eventLoop), readingPaused(false) {
 }
 
 void DummyConnection::receive(const SafeByteArray& data) {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -31,6 +31,10 @@ namespace Swift {
                 onDataSent(data);
             }
 
+            void setReadingPaused(bool paused) {
+                readingPaused = paused;
+            }
+
             void receive(const SafeByteArray& data);
 
             HostAddressPort getLocalAddress() const {
@@ -46,5 +50,6 @@ namespace Swift {
             EventLoop* eventLoop;
             HostAddressPort localAddress;
             HostAddressPort remoteAddress;
+            bool readingPaused;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,7 @@
 #include <Swiften/Network/DummyTimerFactory.h>
 
 #include <algorithm>
+#include <vector>
 
 #include <Swiften/Network/Timer.h>
 
@@ -48,12 +49,20 @@ std::shared_ptr<Timer> DummyTimerFactory::createTimer(int milliseconds) {
 
 void DummyTimerFactory::setTime(int time) {
     assert(time > currentTime);
+    int previousTime = currentTime;
+    // Advance the time first, so timers restarted from a tick handler run from the new time
+    currentTime = time;
+    std::vector<std::shared_ptr<DummyTimer> > expiredTimers;
     for (auto&& timer : timers) {
-        if (timer->getAlarmTime() > currentTime && timer->getAlarmTime() <= time && timer->isRunning) {
+        if (timer->getAlarmTime() > previousTime && timer->getAlarmTime() <= time && timer->isRunning) {
+            expiredTimers.push_back(timer);
+        }
+    }
+    for (auto&& timer : expiredTimers) {
+        if (timer->isRunning) {
             timer->onTick();
         }
     }
-    currentTime = time;
 }
 
 }
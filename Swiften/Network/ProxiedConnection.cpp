@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2016 Isode Limited.
+ * Copyright (c) 2012-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -78,6 +78,12 @@ void ProxiedConnection::write(const SafeByteArray& data) {
     connection_->write(data);
 }
 
+void ProxiedConnection::setReadingPaused(bool paused) {
+    if (connection_) {
+        connection_->setReadingPaused(paused);
+    }
+}
+
 void ProxiedConnection::handleConnectFinished(Connection::ref connection) {
     cancelConnector();
     if (connection) {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2017 Isode Limited.
+ * Copyright (c) 2012-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -27,6 +27,7 @@ namespace Swift {
             virtual void connect(const HostAddressPort& address);
             virtual void disconnect();
             virtual void write(const SafeByteArray& data);
+            virtual void setReadingPaused(bool paused);
 
             virtual HostAddressPort getLocalAddress() const;
             virtual HostAddressPort getRemoteAddress() const;
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Network/TimingWheel.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace Swift {
+
+// The finest wheel has 256 slots; each coarser wheel has 64 slots, each of
+// which spans a full turn of the wheel below it.
+static const unsigned int FINEST_BITS = 8;
+static const unsigned int COARSE_BITS = 6;
+static const uint64_t FINEST_MASK = (1 << FINEST_BITS) - 1;
+static const uint64_t COARSE_MASK = (1 << COARSE_BITS) - 1;
+
+// Entries that are due further away than the coarsest wheel spans are
+// parked at its far end, and placed again when they are cascaded.
+static const uint64_t MAX_DELTA = (static_cast<uint64_t>(1) << (FINEST_BITS + 4 * COARSE_BITS)) - 1;
+
+static unsigned int getShift(size_t level) {
+    return level == 0 ? 0 : static_cast<unsigned int>(FINEST_BITS + (level - 1) * COARSE_BITS);
+}
+
+TimingWheel::Entry::Entry() : previous_(nullptr), next_(nullptr), slot_(nullptr), level_(0), tick_(0) {
+}
+
+TimingWheel::Entry::~Entry() {
+    assert(!isScheduled());
+}
+
+TimingWheel::TimingWheel(uint64_t currentTick) : currentTick_(currentTick), size_(0) {
+    for (size_t level = 0; level < LEVELS; ++level) {
+        levelSizes_[level] = 0;
+        slots_[level].resize(level == 0 ? (FINEST_MASK + 1) : (COARSE_MASK + 1), nullptr);
+    }
+}
+
+TimingWheel::~TimingWheel() {
+    std::vector<Entry*> removed;
+    removeAll(removed);
+}
+
+void TimingWheel::add(Entry* entry, uint64_t tick) {
+    assert(!entry->isScheduled());
+    entry->tick_ = std::max(tick, currentTick_);
+    insert(entry);
+    size_++;
+}
+
+void TimingWheel::remove(Entry* entry) {
+    if (entry->isScheduled()) {
+        unlink(entry);
+        size_--;
+    }
+}
+
+void TimingWheel::advance(uint64_t tick, std::vector<Entry*>& expired) {
+    while (currentTick_ <= tick) {
+        if (size_ == 0) {
+            currentTick_ = tick + 1;
+            break;
+        }
+        size_t index = currentTick_ & FINEST_MASK;
+        if (index == 0) {
+            // The finest wheel completed a turn; bring down the entries of the
+            // next slot of the coarser wheels, as far up as they turned over.
+            for (size_t level = 1; level < LEVELS; ++level) {
+                cascade(level);
+                if (((currentTick_ >> getShift(level)) & COARSE_MASK) != 0) {
+                    break;
+                }
+            }
+        }
+        if (levelSizes_[0] == 0) {
+            // Nothing can expire before the next turn of the finest wheel
+            currentTick_ = std::min((currentTick_ | FINEST_MASK) + 1, tick + 1);
+            continue;
+        }
+        while (Entry* entry = slots_[0][index]) {
+            unlink(entry);
+            size_--;
+            expired.push_back(entry);
+        }
+        currentTick_++;
+    }
+}
+
+void TimingWheel::removeAll(std::vector<Entry*>& removed) {
+    for (size_t level = 0; level < LEVELS; ++level) {
+        for (Entry*& head : slots_[level]) {
+            while (Entry* entry = head) {
+                unlink(entry);
+                removed.push_back(entry);
+            }
+        }
+    }
+    size_ = 0;
+}
+
+boost::optional<uint64_t> TimingWheel::getNextTick() const {
+    if (size_ == 0) {
+        return boost::optional<uint64_t>();
+    }
+    if (levelSizes_[0] == 0) {
+        return (currentTick_ + FINEST_MASK) & ~FINEST_MASK;
+    }
+    for (uint64_t tick = currentTick_; ; ++tick) {
+        if ((tick & FINEST_MASK) == 0 && size_ > levelSizes_[0]) {
+            // The cascade may bring down entries that expire earlier
+            return tick;
+        }
+        if (slots_[0][tick & FINEST_MASK]) {
+            return tick;
+        }
+    }
+}
+
+void TimingWheel::insert(Entry* entry) {
+    uint64_t delta = entry->tick_ - currentTick_;
+    size_t level = 0;
+    size_t index = entry->tick_ & FINEST_MASK;
+    if (delta > FINEST_MASK) {
+        level = 1;
+        while (level < LEVELS - 1 && delta >= (static_cast<uint64_t>(1) << (getShift(level) + COARSE_BITS))) {
+            level++;
+        }
+        uint64_t tick = currentTick_ + std::min(delta, MAX_DELTA);
+        index = (tick >> getShift(level)) & COARSE_MASK;
+    }
+
+    // Append to the circular list of the slot, so that entries that are due
+    // at the same tick expire in the order they were added
+    Entry*& head = slots_[level][index];
+    if (head) {
+        entry->previous_ = head->previous_;
+        entry->next_ = head;
+        head->previous_->next_ = entry;
+        head->previous_ = entry;
+    }
+    else {
+        entry->previous_ = entry;
+        entry->next_ = entry;
+        head = entry;
+    }
+    entry->slot_ = &head;
+    entry->level_ = level;
+    levelSizes_[level]++;
+}
+
+void TimingWheel::unlink(Entry* entry) {
+    Entry*& head = *entry->slot_;
+    if (entry->next_ == entry) {
+        head = nullptr;
+    }
+    else {
+        entry->previous_->next_ = entry->next_;
+        entry->next_->previous_ = entry->previous_;
+        if (head == entry) {
+            head = entry->next_;
+        }
+    }
+    levelSizes_[entry->level_]--;
+    entry->previous_ = nullptr;
+    entry->next_ = nullptr;
+    entry->slot_ = nullptr;
+}
+
+void TimingWheel::cascade(size_t level) {
+    Entry*& head = slots_[level][(currentTick_ >> getShift(level)) & COARSE_MASK];
+    Entry* entry = head;
+    if (!entry) {
+        return;
+    }
+    head = nullptr;
+    entry->previous_->next_ = nullptr;
+    while (entry) {
+        Entry* next = entry->next_;
+        levelSizes_[level]--;
+        insert(entry);
+        entry = next;
+    }
+}
+
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <Swiften/Base/API.h>
+
+namespace Swift {
+    /**
+     * A hierarchical timing wheel, which keeps track of a large number of
+     * entries that are due at a given tick.
+     *
+     * Adding and removing an entry takes constant time. Entries that are due
+     * within the next 256 ticks are kept in a wheel with one slot per tick;
+     * entries that are due later are kept in coarser wheels, and are moved
+     * to the finer wheels as their expiry tick approaches.
+     *
+     * The wheel does not own its entries, and has no notion of time: ticks
+     * are advanced explicitly with advance(). An entry must not be destroyed
+     * while it is scheduled.
+     */
+    class SWIFTEN_API TimingWheel {
+        public:
+            class SWIFTEN_API Entry {
+                public:
+                    Entry();
+                    virtual ~Entry();
+
+                    bool isScheduled() const {
+                        return slot_ != nullptr;
+                    }
+
+                    /**
+                     * The tick at which the entry is due. Only valid while the
+                     * entry is scheduled.
+                     */
+                    uint64_t getTick() const {
+                        return tick_;
+                    }
+
+                private:
+                    Entry(const Entry&) = delete;
+                    Entry& operator=(const Entry&) = delete;
+
+                private:
+                    friend class TimingWheel;
+                    Entry* previous_;
+                    Entry* next_;
+                    Entry** slot_;
+                    size_t level_;
+                    uint64_t tick_;
+            };
+
+        public:
+            TimingWheel(uint64_t currentTick = 0);
+            ~TimingWheel();
+
+            /**
+             * Schedules \p entry to expire at \p tick. Entries for ticks that
+             * have already passed expire on the next call to advance().
+             *
+             * The entry must not already be scheduled.
+             */
+            void add(Entry* entry, uint64_t tick);
+
+            /**
+             * Unschedules \p entry, if it is scheduled.
+             */
+            void remove(Entry* entry);
+
+            /**
+             * Processes all ticks up to and including \p tick, and appends the
+             * entries that expired (in order of their expiry tick) to
+             * \p expired. Expired entries are no longer scheduled.
+             */
+            void advance(uint64_t tick, std::vector<Entry*>& expired);
+
+            /**
+             * Unschedules all entries, and appends them to \p removed.
+             */
+            void removeAll(std::vector<Entry*>& removed);
+
+            /**
+             * Returns the first tick at which advance() will have work to do,
+             * or nothing if no entries are scheduled.
+             *
+             * The result is exact for entries due within the next 256 ticks;
+             * for later entries, it is the tick at which they are moved to a
+             * finer wheel.
+             */
+            boost::optional<uint64_t> getNextTick() const;
+
+            /**
+             * The first tick that has not been processed yet.
+             */
+            uint64_t getCurrentTick() const {
+                return currentTick_;
+            }
+
+            size_t getSize() const {
+                return size_;
+            }
+
+        private:
+            void insert(Entry* entry);
+            void unlink(Entry* entry);
+            void cascade(size_t level);
+
+        private:
+            static const size_t LEVELS = 5;
+
+            uint64_t currentTick_;
+            size_t size_;
+            size_t levelSizes_[LEVELS];
+            std::vector<Entry*> slots_[LEVELS];
+    };
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Network/TimingWheelTimerFactory.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/asio/basic_waitable_timer.hpp>
+#include <boost/bind.hpp>
+#include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <Swiften/EventLoop/EventLoop.h>
+#include <Swiften/EventLoop/EventOwner.h>
+#include <Swiften/Network/Timer.h>
+#include <Swiften/Network/TimingWheel.h>
+
+namespace Swift {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Owns the timing wheel and the asio timer that drives it. The wheel is
+ * only accessed from the event loop thread; the asio timer is also accessed
+ * from the I/O thread, and is protected by timerMutex.
+ */
+class TimingWheelTimerFactory::Driver : public EventOwner, public std::enable_shared_from_this<Driver> {
+    public:
+        Driver(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop, int resolutionMilliseconds);
+        virtual ~Driver();
+
+        void start(WheelTimer* wheelTimer);
+        void stop(WheelTimer* wheelTimer);
+        void shutdown();
+
+    private:
+        uint64_t getTick(Clock::time_point time) const;
+        void arm();
+        void handleTimerTick(const boost::system::error_code& error);
+        void handleTick();
+
+    private:
+        std::shared_ptr<boost::asio::io_service> ioService;
+        EventLoop* eventLoop;
+        Clock::duration resolution;
+        Clock::time_point epoch;
+        TimingWheel wheel;
+        boost::optional<uint64_t> armedTick;
+        boost::scoped_ptr<boost::asio::basic_waitable_timer<Clock> > timer;
+        std::mutex timerMutex;
+        bool shuttingDown;
+};
+
+class TimingWheelTimerFactory::WheelTimer : public Timer, public TimingWheel::Entry, public std::enable_shared_from_this<WheelTimer> {
+    public:
+        WheelTimer(int milliseconds, std::shared_ptr<Driver> driver) : timeout(milliseconds), driver(driver), expired(false) {
+        }
+
+        virtual void start() {
+            driver->start(this);
+        }
+
+        virtual void stop() {
+            driver->stop(this);
+        }
+
+    private:
+        friend class Driver;
+        int timeout;
+        std::shared_ptr<Driver> driver;
+
+        // Keeps the timer alive while it is scheduled, like the pending
+        // asio operation does for a BoostTimer
+        std::shared_ptr<WheelTimer> self;
+
+        // Set when the timer expired, and its onTick is about to be emitted
+        bool expired;
+};
+
+TimingWheelTimerFactory::Driver::Driver(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop, int resolutionMilliseconds) :
+        ioService(ioService), eventLoop(eventLoop), resolution(std::chrono::milliseconds(std::max(1, resolutionMilliseconds))), epoch(Clock::now()), shuttingDown(false) {
+    timer.reset(new boost::asio::basic_waitable_timer<Clock>(*ioService));
+}
+
+TimingWheelTimerFactory::Driver::~Driver() {
+    {
+        std::unique_lock<std::mutex> lockTimer(timerMutex);
+        timer.reset();
+    }
+}
+
+void TimingWheelTimerFactory::Driver::start(WheelTimer* wheelTimer) {
+    if (shuttingDown) {
+        return;
+    }
+    wheelTimer->expired = false;
+    wheel.remove(wheelTimer);
+
+    Clock::time_point now = Clock::now();
+    if (wheel.getSize() == 0) {
+        // Catch up with the current time, so the wheel does not have to
+        // cascade through the ticks that passed while it was idle.
+        std::vector<TimingWheel::Entry*> expired;
+        wheel.advance(getTick(now), expired);
+        assert(expired.empty());
+    }
+    // Round up, so the timer never fires early
+    Clock::duration expiry = (now - epoch) + std::chrono::milliseconds(std::max(0, wheelTimer->timeout));
+    wheel.add(wheelTimer, static_cast<uint64_t>((expiry + resolution - Clock::duration(1)) / resolution));
+    wheelTimer->self = wheelTimer->shared_from_this();
+    if (!armedTick || wheelTimer->getTick() < *armedTick) {
+        arm();
+    }
+}
+
+void TimingWheelTimerFactory::Driver::stop(WheelTimer* wheelTimer) {
+    // The asio timer is left armed; an early wakeup is cheaper than
+    // re-arming it on every stop.
+    wheelTimer->expired = false;
+    wheel.remove(wheelTimer);
+    wheelTimer->self.reset();
+}
+
+void TimingWheelTimerFactory::Driver::shutdown() {
+    {
+        std::unique_lock<std::mutex> lockTimer(timerMutex);
+        shuttingDown = true;
+        timer->cancel();
+    }
+    eventLoop->removeEventsFromOwner(shared_from_this());
+
+    std::vector<TimingWheel::Entry*> removed;
+    wheel.removeAll(removed);
+    std::vector<std::shared_ptr<WheelTimer> > timers;
+    for (TimingWheel::Entry* entry : removed) {
+        timers.push_back(static_cast<WheelTimer*>(entry)->self);
+        static_cast<WheelTimer*>(entry)->self.reset();
+    }
+}
+
+uint64_t TimingWheelTimerFactory::Driver::getTick(Clock::time_point time) const {
+    return static_cast<uint64_t>((time - epoch) / resolution);
+}
+
+void TimingWheelTimerFactory::Driver::arm() {
+    boost::optional<uint64_t> nextTick = wheel.getNextTick();
+    if (!nextTick || (armedTick && *armedTick <= *nextTick)) {
+        return;
+    }
+    armedTick = nextTick;
+    {
+        std::unique_lock<std::mutex> lockTimer(timerMutex);
+        timer->expires_at(epoch + resolution * static_cast<Clock::rep>(*nextTick));
+        timer->async_wait(boost::bind(&Driver::handleTimerTick, shared_from_this(), boost::asio::placeholders::error));
+    }
+}
+
+void TimingWheelTimerFactory::Driver::handleTimerTick(const boost::system::error_code& error) {
+    if (error) {
+        assert(error == boost::asio::error::operation_aborted);
+    }
+    else {
+        {
+            std::unique_lock<std::mutex> lockTimer(timerMutex);
+            if (shuttingDown) {
+                return;
+            }
+            eventLoop->postEvent(boost::bind(&Driver::handleTick, shared_from_this()), shared_from_this());
+        }
+    }
+}
+
+void TimingWheelTimerFactory::Driver::handleTick() {
+    if (shuttingDown) {
+        return;
+    }
+    armedTick.reset();
+    std::vector<TimingWheel::Entry*> entries;
+    wheel.advance(getTick(Clock::now()), entries);
+
+    std::vector<std::shared_ptr<WheelTimer> > expiredTimers;
+    for (TimingWheel::Entry* entry : entries) {
+        WheelTimer* wheelTimer = static_cast<WheelTimer*>(entry);
+        wheelTimer->expired = true;
+        expiredTimers.push_back(wheelTimer->self);
+        wheelTimer->self.reset();
+    }
+    arm();
+
+    // A timer may be stopped (or restarted) by the onTick of a timer that
+    // expired before it.
+    for (const auto& wheelTimer : expiredTimers) {
+        if (wheelTimer->expired) {
+            wheelTimer->expired = false;
+            wheelTimer->onTick();
+        }
+    }
+}
+
+TimingWheelTimerFactory::TimingWheelTimerFactory(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop, int resolutionMilliseconds) : driver(std::make_shared<Driver>(ioService, eventLoop, resolutionMilliseconds)) {
+}
+
+TimingWheelTimerFactory::~TimingWheelTimerFactory() {
+    driver->shutdown();
+}
+
+std::shared_ptr<Timer> TimingWheelTimerFactory::createTimer(int milliseconds) {
+    return std::make_shared<WheelTimer>(milliseconds, driver);
+}
+
+}
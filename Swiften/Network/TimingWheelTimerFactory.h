@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <boost/asio/io_service.hpp>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Network/TimerFactory.h>
+
+namespace Swift {
+    class EventLoop;
+
+    /**
+     * A TimerFactory for processes that run a large number of timers at
+     * once (e.g. one or more per session).
+     *
+     * Instead of giving every timer its own asio timer, the timers are kept
+     * in a TimingWheel, which is driven by a single asio timer. Starting and
+     * stopping a timer takes constant time, and timers that expire within
+     * the same period of the given resolution are fired together, from a
+     * single event on the event loop. Timers never fire early, but may fire
+     * up to one resolution period late.
+     *
+     * Timers created by the factory must only be started and stopped from
+     * the event loop thread.
+     */
+    class SWIFTEN_API TimingWheelTimerFactory : public TimerFactory {
+        public:
+            TimingWheelTimerFactory(std::shared_ptr<boost::asio::io_service>, EventLoop* eventLoop, int resolutionMilliseconds = 10);
+            virtual ~TimingWheelTimerFactory();
+
+            virtual std::shared_ptr<Timer> createTimer(int milliseconds);
+
+        private:
+            class Driver;
+            class WheelTimer;
+
+            std::shared_ptr<Driver> driver;
+    };
+}
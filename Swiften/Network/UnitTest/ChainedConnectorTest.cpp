@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -29,6 +29,10 @@ class ChainedConnectorTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testConnect_NoConnectorSucceeds);
         CPPUNIT_TEST(testConnect_NoDNS);
         CPPUNIT_TEST(testStop);
+        CPPUNIT_TEST(testConnect_SlowConnectorRacedByNextConnector);
+        CPPUNIT_TEST(testConnect_PreferredEndpointTriedFirst);
+        CPPUNIT_TEST(testConnect_PreferredEndpointForOtherHostIgnored);
+        CPPUNIT_TEST(testConnect_PreferredEndpointForOtherConnectionFactoryIgnored);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -122,6 +126,66 @@ class ChainedConnectorTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(!connections[0]);
         }
 
+        void testConnect_SlowConnectorRacedByNextConnector() {
+            std::shared_ptr<ChainedConnector> testling(createConnector());
+            connectionFactory1->isResponsive = false;
+
+            testling->start();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(connections.size()));
+
+            timerFactory->setTime(2000);
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT_EQUAL(2, connections[0]->id);
+            CPPUNIT_ASSERT(connectionFactory1->createdConnections[0]->disconnected);
+            CPPUNIT_ASSERT(testling->getConnectedEndpoint());
+            CPPUNIT_ASSERT_EQUAL(static_cast<ConnectionFactory*>(connectionFactory2), testling->getConnectedEndpoint()->connectionFactory);
+            CPPUNIT_ASSERT(host == testling->getConnectedEndpoint()->address);
+        }
+
+        void testConnect_PreferredEndpointTriedFirst() {
+            std::shared_ptr<ChainedConnector> testling(createConnector());
+            testling->setPreferredEndpoint(ChainedConnector::Endpoint("foo.com", connectionFactory2, host));
+
+            testling->start();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT_EQUAL(2, connections[0]->id);
+            CPPUNIT_ASSERT(connectionFactory1->createdConnections.empty());
+        }
+
+        void testConnect_PreferredEndpointForOtherHostIgnored() {
+            std::shared_ptr<ChainedConnector> testling(createConnector());
+            testling->setPreferredEndpoint(ChainedConnector::Endpoint("bar.com", connectionFactory2, host));
+
+            testling->start();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT_EQUAL(1, connections[0]->id);
+        }
+
+        void testConnect_PreferredEndpointForOtherConnectionFactoryIgnored() {
+            MockConnectionFactory otherConnectionFactory(eventLoop, 3);
+            std::shared_ptr<ChainedConnector> testling(createConnector());
+            testling->setPreferredEndpoint(ChainedConnector::Endpoint("foo.com", &otherConnectionFactory, host));
+
+            testling->start();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT_EQUAL(1, connections[0]->id);
+            CPPUNIT_ASSERT(otherConnectionFactory.createdConnections.empty());
+        }
+
     private:
         std::shared_ptr<ChainedConnector> createConnector() {
             std::vector<ConnectionFactory*> factories;
@@ -143,35 +207,43 @@ class ChainedConnectorTest : public CppUnit::TestFixture {
 
         struct MockConnection : public Connection {
             public:
-                MockConnection(bool connects, int id, EventLoop* eventLoop) : connects(connects), id(id), eventLoop(eventLoop) {
+                MockConnection(bool connects, bool isResponsive, int id, EventLoop* eventLoop) : connects(connects), isResponsive(isResponsive), id(id), eventLoop(eventLoop), disconnected(false) {
                 }
 
                 void listen() { assert(false); }
                 void connect(const HostAddressPort&) {
-                    eventLoop->postEvent(boost::bind(boost::ref(onConnectFinished), !connects));
+                    if (isResponsive) {
+                        eventLoop->postEvent(boost::bind(boost::ref(onConnectFinished), !connects));
+                    }
                 }
 
                 HostAddressPort getLocalAddress() const { return HostAddressPort(); }
                 HostAddressPort getRemoteAddress() const { return HostAddressPort(); }
-                void disconnect() { assert(false); }
+                void disconnect() { disconnected = true; }
                 void write(const SafeByteArray&) { assert(false); }
 
                 bool connects;
+                bool isResponsive;
                 int id;
                 EventLoop* eventLoop;
+                bool disconnected;
         };
 
         struct MockConnectionFactory : public ConnectionFactory {
-            MockConnectionFactory(EventLoop* eventLoop, int id) : eventLoop(eventLoop), connects(true), id(id) {
+            MockConnectionFactory(EventLoop* eventLoop, int id) : eventLoop(eventLoop), connects(true), isResponsive(true), id(id) {
             }
 
             std::shared_ptr<Connection> createConnection() {
-                return std::make_shared<MockConnection>(connects, id, eventLoop);
+                std::shared_ptr<MockConnection> connection = std::make_shared<MockConnection>(connects, isResponsive, id, eventLoop);
+                createdConnections.push_back(connection);
+                return connection;
             }
 
             EventLoop* eventLoop;
             bool connects;
+            bool isResponsive;
             int id;
+            std::vector<std::shared_ptr<MockConnection> > createdConnections;
         };
 
     private:
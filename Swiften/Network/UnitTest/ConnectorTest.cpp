@@ -1,9 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include <boost/bind.hpp>
 #include <boost/optional.hpp>
 
@@ -18,6 +22,7 @@
 #include <Swiften/Network/DummyTimerFactory.h>
 #include <Swiften/Network/HostAddressPort.h>
 #include <Swiften/Network/StaticDomainNameResolver.h>
+#include <Swiften/Network/Timer.h>
 
 using namespace Swift;
 
@@ -37,6 +42,12 @@ class ConnectorTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testConnect_TimeoutDuringConnectToOnlyCandidate);
         CPPUNIT_TEST(testConnect_TimeoutDuringConnectToCandidateFallsBack);
         CPPUNIT_TEST(testConnect_NoTimeout);
+        CPPUNIT_TEST(testConnect_SlowAddressRacedByNextAddress);
+        CPPUNIT_TEST(testConnect_FirstAttemptToConnectWins);
+        CPPUNIT_TEST(testConnect_SlowSRVHostRacedByNextSRVHost);
+        CPPUNIT_TEST(testConnect_NoParallelAttemptsWithoutAttemptDelay);
+        CPPUNIT_TEST(testConnect_InterleavesAddressFamilies);
+        CPPUNIT_TEST(testConnect_PreferredAddressTriedFirst);
         CPPUNIT_TEST(testStop_DuringSRVQuery);
         CPPUNIT_TEST(testStop_Timeout);
         CPPUNIT_TEST_SUITE_END();
@@ -48,13 +59,13 @@ class ConnectorTest : public CppUnit::TestFixture {
             host3 = HostAddressPort(HostAddress::fromString("3.3.3.3").get(), 5222);
             eventLoop = new DummyEventLoop();
             resolver = new StaticDomainNameResolver(eventLoop);
-            connectionFactory = new MockConnectionFactory(eventLoop);
             timerFactory = new DummyTimerFactory();
+            connectionFactory = new MockConnectionFactory(eventLoop, timerFactory);
         }
 
         void tearDown() {
-            delete timerFactory;
             delete connectionFactory;
+            delete timerFactory;
             delete resolver;
             delete eventLoop;
         }
@@ -280,6 +291,129 @@ class ConnectorTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(!std::dynamic_pointer_cast<DomainNameResolveError>(error));
         }
 
+        void testConnect_SlowAddressRacedByNextAddress() {
+            Connector::ref testling(createConnector());
+            auto address1 = HostAddress::fromString("1.1.1.1").get();
+            auto address2 = HostAddress::fromString("2.2.2.2").get();
+            resolver->addXMPPClientService("foo.com", "host-foo.com", 1234);
+            resolver->addAddress("host-foo.com", address1);
+            resolver->addAddress("host-foo.com", address2);
+            connectionFactory->unresponsivePorts.push_back(HostAddressPort(address1, 1234));
+
+            testling->start();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connectionFactory->createdConnections.size()));
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(connections.size()));
+
+            timerFactory->setTime(250);
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(connectionFactory->createdConnections.size()));
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT(HostAddressPort(address2, 1234) == *(connections[0]->hostAddressPort));
+            CPPUNIT_ASSERT(connectionFactory->createdConnections[0]->disconnected);
+            CPPUNIT_ASSERT(!connections[0]->disconnected);
+        }
+
+        void testConnect_FirstAttemptToConnectWins() {
+            Connector::ref testling(createConnector());
+            auto address1 = HostAddress::fromString("1.1.1.1").get();
+            auto address2 = HostAddress::fromString("2.2.2.2").get();
+            resolver->addXMPPClientService("foo.com", "host-foo.com", 1234);
+            resolver->addAddress("host-foo.com", address1);
+            resolver->addAddress("host-foo.com", address2);
+            connectionFactory->delays.push_back(std::make_pair(HostAddressPort(address1, 1234), 400));
+            connectionFactory->delays.push_back(std::make_pair(HostAddressPort(address2, 1234), 100));
+
+            testling->start();
+            eventLoop->processEvents();
+            timerFactory->setTime(250);
+            eventLoop->processEvents();
+            timerFactory->setTime(350);
+            eventLoop->processEvents();
+            timerFactory->setTime(400);
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT(HostAddressPort(address2, 1234) == *(connections[0]->hostAddressPort));
+            CPPUNIT_ASSERT(connectionFactory->createdConnections[0]->disconnected);
+            CPPUNIT_ASSERT(HostAddressPort(address2, 1234) == *testling->getConnectedAddress());
+        }
+
+        void testConnect_SlowSRVHostRacedByNextSRVHost() {
+            Connector::ref testling(createConnector());
+            resolver->addXMPPClientService("foo.com", host1);
+            resolver->addXMPPClientService("foo.com", host2);
+            connectionFactory->unresponsivePorts.push_back(host1);
+
+            testling->start();
+            eventLoop->processEvents();
+            timerFactory->setTime(250);
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT(host2 == *(connections[0]->hostAddressPort));
+            CPPUNIT_ASSERT(connectionFactory->createdConnections[0]->disconnected);
+        }
+
+        void testConnect_NoParallelAttemptsWithoutAttemptDelay() {
+            Connector::ref testling(createConnector());
+            testling->setAttemptDelayMilliseconds(0);
+            resolver->addXMPPClientService("foo.com", host1);
+            resolver->addXMPPClientService("foo.com", host2);
+            connectionFactory->unresponsivePorts.push_back(host1);
+
+            testling->start();
+            eventLoop->processEvents();
+            timerFactory->setTime(1000);
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connectionFactory->createdConnections.size()));
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(connections.size()));
+        }
+
+        void testConnect_InterleavesAddressFamilies() {
+            Connector::ref testling(createConnector());
+            auto address1 = HostAddress::fromString("2001:db8::1").get();
+            auto address2 = HostAddress::fromString("2001:db8::2").get();
+            auto address3 = HostAddress::fromString("1.1.1.1").get();
+            resolver->addXMPPClientService("foo.com", "host-foo.com", 1234);
+            resolver->addAddress("host-foo.com", address1);
+            resolver->addAddress("host-foo.com", address2);
+            resolver->addAddress("host-foo.com", address3);
+            connectionFactory->failingPorts.push_back(HostAddressPort(address1, 1234));
+            connectionFactory->failingPorts.push_back(HostAddressPort(address3, 1234));
+
+            testling->start();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(3, static_cast<int>(connectionFactory->createdConnections.size()));
+            CPPUNIT_ASSERT(HostAddressPort(address1, 1234) == *(connectionFactory->createdConnections[0]->hostAddressPort));
+            CPPUNIT_ASSERT(HostAddressPort(address3, 1234) == *(connectionFactory->createdConnections[1]->hostAddressPort));
+            CPPUNIT_ASSERT(HostAddressPort(address2, 1234) == *(connectionFactory->createdConnections[2]->hostAddressPort));
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+        }
+
+        void testConnect_PreferredAddressTriedFirst() {
+            Connector::ref testling(createConnector());
+            testling->setPreferredAddress(host2);
+            resolver->addXMPPClientService("foo.com", host1);
+            resolver->addXMPPClientService("foo.com", host2);
+
+            testling->start();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connectionFactory->createdConnections.size()));
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT(host2 == *(connections[0]->hostAddressPort));
+        }
+
         void testStop_DuringSRVQuery() {
             Connector::ref testling(createConnector());
             resolver->addXMPPClientService("foo.com", host1);
@@ -327,41 +461,65 @@ class ConnectorTest : public CppUnit::TestFixture {
             error = resultError;
         }
 
+        struct MockConnectionFactory;
+
         struct MockConnection : public Connection {
             public:
-                MockConnection(const std::vector<HostAddressPort>& failingPorts, bool isResponsive, EventLoop* eventLoop) : eventLoop(eventLoop), failingPorts(failingPorts), isResponsive(isResponsive) {}
+                MockConnection(MockConnectionFactory* factory) : factory(factory), isResponsive(factory->isResponsive), disconnected(false) {}
 
                 void listen() { assert(false); }
                 void connect(const HostAddressPort& address) {
                     hostAddressPort = address;
-                    if (isResponsive) {
-                        bool fail = std::find(failingPorts.begin(), failingPorts.end(), address) != failingPorts.end();
-                        eventLoop->postEvent(boost::bind(boost::ref(onConnectFinished), fail));
+                    if (!isResponsive || std::find(factory->unresponsivePorts.begin(), factory->unresponsivePorts.end(), address) != factory->unresponsivePorts.end()) {
+                        return;
+                    }
+                    bool fail = std::find(factory->failingPorts.begin(), factory->failingPorts.end(), address) != factory->failingPorts.end();
+                    for (const auto& delay : factory->delays) {
+                        if (delay.first == address) {
+                            // Simulate a connection that takes a while to be set up
+                            timer = factory->timerFactory->createTimer(delay.second);
+                            timer->onTick.connect(boost::bind(boost::ref(onConnectFinished), fail));
+                            timer->start();
+                            return;
+                        }
                     }
+                    factory->eventLoop->postEvent(boost::bind(boost::ref(onConnectFinished), fail));
                 }
 
                 HostAddressPort getLocalAddress() const { return HostAddressPort(); }
                 HostAddressPort getRemoteAddress() const { return HostAddressPort(); }
-                void disconnect() { assert(false); }
+                void disconnect() {
+                    disconnected = true;
+                    if (timer) {
+                        timer->stop();
+                    }
+                }
                 void write(const SafeByteArray&) { assert(false); }
 
-                EventLoop* eventLoop;
+                MockConnectionFactory* factory;
                 boost::optional<HostAddressPort> hostAddressPort;
-                std::vector<HostAddressPort> failingPorts;
                 bool isResponsive;
+                bool disconnected;
+                std::shared_ptr<Timer> timer;
         };
 
         struct MockConnectionFactory : public ConnectionFactory {
-            MockConnectionFactory(EventLoop* eventLoop) : eventLoop(eventLoop), isResponsive(true) {
+            MockConnectionFactory(EventLoop* eventLoop, TimerFactory* timerFactory) : eventLoop(eventLoop), timerFactory(timerFactory), isResponsive(true) {
             }
 
             std::shared_ptr<Connection> createConnection() {
-                return std::make_shared<MockConnection>(failingPorts, isResponsive, eventLoop);
+                std::shared_ptr<MockConnection> connection = std::make_shared<MockConnection>(this);
+                createdConnections.push_back(connection);
+                return connection;
             }
 
             EventLoop* eventLoop;
+            TimerFactory* timerFactory;
             bool isResponsive;
             std::vector<HostAddressPort> failingPorts;
+            std::vector<HostAddressPort> unresponsivePorts;
+            std::vector<std::pair<HostAddressPort, int> > delays;
+            std::vector<std::shared_ptr<MockConnection> > createdConnections;
         };
 
     private:
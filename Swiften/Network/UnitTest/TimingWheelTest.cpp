@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Network/TimingWheel.h>
+
+using namespace Swift;
+
+class TimingWheelTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(TimingWheelTest);
+        CPPUNIT_TEST(testAdvance_NoEntries);
+        CPPUNIT_TEST(testAdvance_ExpiresDueEntries);
+        CPPUNIT_TEST(testAdvance_SameTickInOrderAdded);
+        CPPUNIT_TEST(testAdvance_PastTickExpiresNext);
+        CPPUNIT_TEST(testAdvance_CascadesFromCoarserWheels);
+        CPPUNIT_TEST(testAdvance_BeyondCoarsestWheel);
+        CPPUNIT_TEST(testAdvance_RandomEntries);
+        CPPUNIT_TEST(testRemove);
+        CPPUNIT_TEST(testRemove_AfterCascade);
+        CPPUNIT_TEST(testRemoveAll);
+        CPPUNIT_TEST(testGetNextTick);
+        CPPUNIT_TEST(testGetNextTick_CoarserWheel);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void testAdvance_NoEntries() {
+            TimingWheel testling;
+
+            testling.advance(1000000, expired);
+
+            CPPUNIT_ASSERT(expired.empty());
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1000001), testling.getCurrentTick());
+        }
+
+        void testAdvance_ExpiresDueEntries() {
+            TimingWheel::Entry entry1, entry2;
+            TimingWheel testling;
+            testling.add(&entry1, 10);
+            testling.add(&entry2, 20);
+
+            testling.advance(9, expired);
+            CPPUNIT_ASSERT(expired.empty());
+
+            testling.advance(15, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), expired.size());
+            CPPUNIT_ASSERT(expired[0] == &entry1);
+            CPPUNIT_ASSERT(!entry1.isScheduled());
+            CPPUNIT_ASSERT(entry2.isScheduled());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getSize());
+
+            testling.advance(20, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), expired.size());
+            CPPUNIT_ASSERT(expired[1] == &entry2);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), testling.getSize());
+        }
+
+        void testAdvance_SameTickInOrderAdded() {
+            TimingWheel::Entry entry1, entry2, entry3;
+            TimingWheel testling;
+            testling.add(&entry2, 5);
+            testling.add(&entry1, 5);
+            testling.add(&entry3, 5);
+
+            testling.advance(5, expired);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), expired.size());
+            CPPUNIT_ASSERT(expired[0] == &entry2);
+            CPPUNIT_ASSERT(expired[1] == &entry1);
+            CPPUNIT_ASSERT(expired[2] == &entry3);
+        }
+
+        void testAdvance_PastTickExpiresNext() {
+            TimingWheel::Entry entry;
+            TimingWheel testling(100);
+            testling.add(&entry, 50);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(100), entry.getTick());
+            testling.advance(100, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), expired.size());
+        }
+
+        void testAdvance_CascadesFromCoarserWheels() {
+            TimingWheel::Entry entry1, entry2, entry3;
+            TimingWheel testling(3);
+            testling.add(&entry1, 300);
+            testling.add(&entry2, 70000);
+            testling.add(&entry3, 20000000);
+
+            testling.advance(299, expired);
+            CPPUNIT_ASSERT(expired.empty());
+            testling.advance(300, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), expired.size());
+
+            testling.advance(69999, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), expired.size());
+            testling.advance(70000, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), expired.size());
+
+            testling.advance(19999999, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), expired.size());
+            testling.advance(20000000, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), expired.size());
+            CPPUNIT_ASSERT(expired[2] == &entry3);
+        }
+
+        void testAdvance_BeyondCoarsestWheel() {
+            TimingWheel::Entry entry;
+            TimingWheel testling(1);
+            uint64_t tick = (static_cast<uint64_t>(1) << 33) + 12345;
+            testling.add(&entry, tick);
+
+            testling.advance(tick - 1, expired);
+            CPPUNIT_ASSERT(expired.empty());
+            testling.advance(tick, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), expired.size());
+        }
+
+        void testAdvance_RandomEntries() {
+            std::mt19937 random(1);
+            std::uniform_int_distribution<uint64_t> delta(0, 1 << 22);
+            std::uniform_int_distribution<uint64_t> step(1, 5000);
+            std::vector<std::unique_ptr<TimingWheel::Entry> > entries;
+            TimingWheel testling(random());
+            for (size_t i = 0; i < 2000; ++i) {
+                entries.push_back(std::unique_ptr<TimingWheel::Entry>(new TimingWheel::Entry()));
+                testling.add(entries.back().get(), testling.getCurrentTick() + delta(random));
+            }
+
+            while (testling.getSize() > 0) {
+                uint64_t tick = testling.getCurrentTick() + step(random);
+                size_t previousSize = expired.size();
+                testling.advance(tick, expired);
+                for (size_t i = previousSize; i < expired.size(); ++i) {
+                    CPPUNIT_ASSERT(expired[i]->getTick() <= tick);
+                    CPPUNIT_ASSERT(expired[i]->getTick() > tick - step.max());
+                    if (i > previousSize) {
+                        CPPUNIT_ASSERT(expired[i - 1]->getTick() <= expired[i]->getTick());
+                    }
+                }
+                for (const auto& entry : entries) {
+                    CPPUNIT_ASSERT(!entry->isScheduled() || entry->getTick() > tick);
+                }
+            }
+            CPPUNIT_ASSERT_EQUAL(entries.size(), expired.size());
+        }
+
+        void testRemove() {
+            TimingWheel::Entry entry1, entry2, entry3;
+            TimingWheel testling;
+            testling.add(&entry1, 10);
+            testling.add(&entry2, 10);
+            testling.add(&entry3, 10);
+
+            testling.remove(&entry2);
+            testling.remove(&entry2);
+
+            CPPUNIT_ASSERT(!entry2.isScheduled());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), testling.getSize());
+            testling.advance(10, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), expired.size());
+            CPPUNIT_ASSERT(expired[0] == &entry1);
+            CPPUNIT_ASSERT(expired[1] == &entry3);
+        }
+
+        void testRemove_AfterCascade() {
+            TimingWheel::Entry entry1, entry2;
+            TimingWheel testling;
+            testling.add(&entry1, 1000);
+            testling.add(&entry2, 1000);
+
+            testling.advance(800, expired);
+            testling.remove(&entry1);
+            testling.advance(1000, expired);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), expired.size());
+            CPPUNIT_ASSERT(expired[0] == &entry2);
+        }
+
+        void testRemoveAll() {
+            TimingWheel::Entry entry1, entry2;
+            TimingWheel testling;
+            testling.add(&entry1, 10);
+            testling.add(&entry2, 100000);
+
+            std::vector<TimingWheel::Entry*> removed;
+            testling.removeAll(removed);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), removed.size());
+            CPPUNIT_ASSERT(!entry1.isScheduled());
+            CPPUNIT_ASSERT(!entry2.isScheduled());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), testling.getSize());
+            CPPUNIT_ASSERT(!testling.getNextTick());
+        }
+
+        void testGetNextTick() {
+            TimingWheel::Entry entry1, entry2;
+            TimingWheel testling(10);
+            testling.add(&entry1, 200);
+            testling.add(&entry2, 50);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(50), *testling.getNextTick());
+            testling.remove(&entry2);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(200), *testling.getNextTick());
+            testling.remove(&entry1);
+            CPPUNIT_ASSERT(!testling.getNextTick());
+        }
+
+        void testGetNextTick_CoarserWheel() {
+            TimingWheel::Entry entry1, entry2;
+            TimingWheel testling(10);
+            testling.add(&entry1, 300);
+            testling.add(&entry2, 510);
+
+            // entry1 is only moved to the finest wheel at tick 256
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(256), *testling.getNextTick());
+            testling.advance(256, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(300), *testling.getNextTick());
+            testling.advance(300, expired);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(510), *testling.getNextTick());
+        }
+
+    private:
+        std::vector<TimingWheel::Entry*> expired;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TimingWheelTest);
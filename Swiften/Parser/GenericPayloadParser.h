@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -33,6 +33,14 @@ namespace Swift {
                 return payload_;
             }
 
+        protected:
+            /**
+             * Replaces the payload by a new one, for implementing reset().
+             */
+            void resetPayload() {
+                payload_ = std::make_shared<PAYLOAD_TYPE>();
+            }
+
         private:
             std::shared_ptr<PAYLOAD_TYPE> payload_;
     };
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -45,6 +45,16 @@ namespace Swift {
 
             virtual void handleTree(ParserElement::ref root) = 0;
 
+        protected:
+            /**
+             * Discards the tree and the payload, for implementing reset().
+             */
+            void resetTree() {
+                elementStack_.clear();
+                root_.reset();
+                this->resetPayload();
+            }
+
         private:
             std::deque<ParserElement::ref> elementStack_;
             ParserElement::ref root_;
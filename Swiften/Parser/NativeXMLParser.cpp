@@ -0,0 +1,1041 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Parser/NativeXMLParser.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <Swiften/Base/ByteScan.h>
+#include <Swiften/Parser/XMLParserClient.h>
+#include <Swiften/Serializer/XML/XMLEscape.h>
+
+namespace Swift {
+
+namespace {
+    const std::string NoNamespace;
+    const std::string XMLNamespace("http://www.w3.org/XML/1998/namespace");
+    const std::string XMLNSNamespace("http://www.w3.org/2000/xmlns/");
+
+    // Longest entity or character reference (including leading zeros)
+    const size_t MaxReferenceLength = 64;
+
+    enum Result {
+        Done,
+        NeedMoreData,
+        Error
+    };
+
+    inline bool isWhitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // Non-ASCII name characters are not checked against the XML tables
+    inline bool isNameStartChar(unsigned char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || c >= 0x80;
+    }
+
+    inline bool isNameChar(unsigned char c) {
+        return isNameStartChar(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+    }
+
+    inline bool equals(const char* begin, size_t length, const char* literal) {
+        return length == std::strlen(literal) && std::memcmp(begin, literal, length) == 0;
+    }
+
+    inline bool equals(const char* begin, size_t length, const std::string& s) {
+        return length == s.size() && std::memcmp(begin, s.data(), length) == 0;
+    }
+
+    /**
+     * Returns Done if [begin, end) starts with \p literal, NeedMoreData if
+     * it is a prefix of it, and Error otherwise.
+     */
+    Result matchLiteral(const char* begin, const char* end, const char* literal) {
+        size_t length = std::strlen(literal);
+        size_t available = std::min(length, static_cast<size_t>(end - begin));
+        if (std::memcmp(begin, literal, available) != 0) {
+            return Error;
+        }
+        return available == length ? Done : NeedMoreData;
+    }
+
+    const char* skipWhitespace(const char* begin, const char* end) {
+        while (begin < end && isWhitespace(*begin)) {
+            ++begin;
+        }
+        return begin;
+    }
+
+    size_t getUTF8SequenceLength(unsigned char leadByte) {
+        return leadByte >= 0xF0 ? 4 : (leadByte >= 0xE0 ? 3 : 2);
+    }
+
+    /**
+     * Checks that [begin, end) only consists of characters allowed in XML,
+     * encoded as (strict) UTF-8, and reports whether there are carriage
+     * returns to normalize.
+     */
+    bool checkCharacters(const char* begin, const char* end, bool& hasCarriageReturn) {
+        for (const char* i = begin; i < end; ++i) {
+            unsigned char c = static_cast<unsigned char>(*i);
+            if (c < 0x20) {
+                if (c == '\r') {
+                    hasCarriageReturn = true;
+                }
+                else if (c != '\t' && c != '\n') {
+                    return false;
+                }
+            }
+            else if (c >= 0x80) {
+                unsigned char minimum = 0x80;
+                unsigned char maximum = 0xBF;
+                if (c < 0xC2 || c > 0xF4) {
+                    return false;
+                }
+                else if (c == 0xE0) {
+                    minimum = 0xA0;
+                }
+                else if (c == 0xED) {
+                    // Surrogates
+                    maximum = 0x9F;
+                }
+                else if (c == 0xF0) {
+                    minimum = 0x90;
+                }
+                else if (c == 0xF4) {
+                    maximum = 0x8F;
+                }
+                size_t length = getUTF8SequenceLength(c);
+                if (static_cast<size_t>(end - i) < length) {
+                    return false;
+                }
+                unsigned char second = static_cast<unsigned char>(i[1]);
+                if (second < minimum || second > maximum) {
+                    return false;
+                }
+                for (size_t j = 2; j < length; ++j) {
+                    if ((static_cast<unsigned char>(i[j]) & 0xC0) != 0x80) {
+                        return false;
+                    }
+                }
+                // U+FFFE and U+FFFF
+                if (c == 0xEF && second == 0xBF && static_cast<unsigned char>(i[2]) >= 0xBE) {
+                    return false;
+                }
+                i += length - 1;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Returns the end of the name starting at \p begin, or \p begin if
+     * there is no valid name.
+     */
+    const char* scanName(const char* begin, const char* end) {
+        if (begin == end || !isNameStartChar(static_cast<unsigned char>(*begin))) {
+            return begin;
+        }
+        bool isASCII = static_cast<unsigned char>(*begin) < 0x80;
+        const char* i = begin + 1;
+        while (i < end && isNameChar(static_cast<unsigned char>(*i))) {
+            isASCII = isASCII && static_cast<unsigned char>(*i) < 0x80;
+            ++i;
+        }
+        bool hasCarriageReturn = false;
+        if (!isASCII && !checkCharacters(begin, i, hasCarriageReturn)) {
+            return begin;
+        }
+        return i;
+    }
+
+    /**
+     * Appends [begin, end) to \p result, with line ends normalized to '\n'.
+     */
+    void appendNormalizingLineEnds(const char* begin, const char* end, std::string& result) {
+        for (const char* i = begin; i < end; ++i) {
+            if (*i == '\r') {
+                result += '\n';
+                if (i + 1 < end && i[1] == '\n') {
+                    ++i;
+                }
+            }
+            else {
+                result += *i;
+            }
+        }
+    }
+
+    bool isXMLCharacter(unsigned long c) {
+        return c == 0x9 || c == 0xA || c == 0xD || (c >= 0x20 && c <= 0xD7FF) || (c >= 0xE000 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0x10FFFF);
+    }
+
+    void appendUTF8(unsigned long c, std::string& result) {
+        if (c < 0x80) {
+            result += static_cast<char>(c);
+        }
+        else if (c < 0x800) {
+            result += static_cast<char>(0xC0 | (c >> 6));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000) {
+            result += static_cast<char>(0xE0 | (c >> 12));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else {
+            result += static_cast<char>(0xF0 | (c >> 18));
+            result += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+
+    /**
+     * Appends the value of the reference between '&' and ';' to \p result.
+     */
+    bool appendReference(const char* begin, const char* end, std::string& result) {
+        size_t length = static_cast<size_t>(end - begin);
+        if (length >= 2 && begin[0] == '#') {
+            bool hex = begin[1] == 'x';
+            const char* digits = begin + (hex ? 2 : 1);
+            if (digits == end) {
+                return false;
+            }
+            unsigned long value = 0;
+            for (const char* i = digits; i < end; ++i) {
+                int digit = -1;
+                if (*i >= '0' && *i <= '9') {
+                    digit = *i - '0';
+                }
+                else if (hex && *i >= 'a' && *i <= 'f') {
+                    digit = *i - 'a' + 10;
+                }
+                else if (hex && *i >= 'A' && *i <= 'F') {
+                    digit = *i - 'A' + 10;
+                }
+                if (digit < 0) {
+                    return false;
+                }
+                value = value * (hex ? 16 : 10) + static_cast<unsigned long>(digit);
+                if (value > 0x10FFFF) {
+                    return false;
+                }
+            }
+            if (!isXMLCharacter(value)) {
+                return false;
+            }
+            appendUTF8(value, result);
+            return true;
+        }
+        if (equals(begin, length, "lt")) {
+            result += '<';
+        }
+        else if (equals(begin, length, "gt")) {
+            result += '>';
+        }
+        else if (equals(begin, length, "amp")) {
+            result += '&';
+        }
+        else if (equals(begin, length, "quot")) {
+            result += '"';
+        }
+        else if (equals(begin, length, "apos")) {
+            result += '\'';
+        }
+        else {
+            // There is no DTD, so other entities are undefined
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Checks the pseudo-attributes of the XML declaration. The encoding is
+     * not used, as with the other parsers: streams are always UTF-8.
+     */
+    bool checkXMLDeclaration(const char* begin, const char* end) {
+        static const char* names[] = { "version", "encoding", "standalone" };
+        size_t nextName = 0;
+        const char* i = begin;
+        while (true) {
+            const char* nameBegin = skipWhitespace(i, end);
+            if (nameBegin == end) {
+                break;
+            }
+            if (nameBegin == i) {
+                return false;
+            }
+            const char* nameEnd = scanName(nameBegin, end);
+            i = skipWhitespace(nameEnd, end);
+            if (i == end || *i != '=') {
+                return false;
+            }
+            i = skipWhitespace(i + 1, end);
+            if (i == end || (*i != '"' && *i != '\'')) {
+                return false;
+            }
+            const char* valueBegin = i + 1;
+            const char* valueEnd = std::find(valueBegin, end, *i);
+            if (valueEnd == end) {
+                return false;
+            }
+            size_t valueLength = static_cast<size_t>(valueEnd - valueBegin);
+            i = valueEnd + 1;
+
+            while (nextName < 3 && !equals(nameBegin, static_cast<size_t>(nameEnd - nameBegin), names[nextName])) {
+                if (nextName == 0) {
+                    // The version is required
+                    return false;
+                }
+                nextName++;
+            }
+            switch (nextName) {
+                case 0:
+                    if (valueLength < 3 || valueBegin[0] != '1' || valueBegin[1] != '.' || std::find_if(valueBegin + 2, valueEnd, [](char c) { return c < '0' || c > '9'; }) != valueEnd) {
+                        return false;
+                    }
+                    break;
+                case 1:
+                    if (valueLength == 0 || !std::isalpha(static_cast<unsigned char>(valueBegin[0])) || std::find_if(valueBegin, valueEnd, [](char c) { return !std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '_' && c != '-'; }) != valueEnd) {
+                        return false;
+                    }
+                    break;
+                case 2:
+                    if (!equals(valueBegin, valueLength, "yes") && !equals(valueBegin, valueLength, "no")) {
+                        return false;
+                    }
+                    break;
+                default:
+                    return false;
+            }
+            nextName++;
+        }
+        return nextName > 0;
+    }
+}
+
+struct NativeXMLParser::Private {
+    struct Element {
+        std::string qname;
+        std::string name;
+        std::string ns;
+        size_t bindingCount;
+    };
+
+    struct Binding {
+        std::string prefix;
+        std::string uri;
+    };
+
+    struct RawAttribute {
+        const char* qname;
+        size_t qnameLength;
+        std::string value;
+    };
+
+    Private(XMLParserClient* client) : client(client), error(false), rootClosed(false), hasByteOrderMark(false), consumed(0), scanned(0), depth(0), bindingCount(0), rawAttributeCount(0), tokenBegin(nullptr), tokenEnd(nullptr), tokenCaptured(false), reportingStartElement(false), capturing(false), captureDepth(0), captureOuterBindingCount(0), captureDeclarationOffset(0), captureUsesUndeclaredDefaultNamespace(false) {
+    }
+
+    Result parseToken(const char* begin, const char* end, const char*& next);
+    Result parseText(const char* begin, const char* end, const char*& next);
+    Result parseReference(const char* begin, const char* end, const char*& next);
+    Result parseStartTag(const char* begin, const char* end, const char*& next);
+    Result parseEndTag(const char* begin, const char* end, const char*& next);
+    Result parseCommentOrCDATA(const char* begin, const char* end, const char*& next);
+    Result parseProcessingInstruction(const char* begin, const char* end, const char*& next);
+
+    const char* findTerminator(const char* token, size_t offset, const char* end, const char* terminator);
+    bool handleText(const char* begin, const char* end);
+    bool decodeAttributeValue(const char* begin, const char* end, std::string& value);
+    bool startElement(const char* qname, size_t qnameLength, bool isEmpty);
+    void endElement();
+    bool addBinding(const char* prefix, size_t prefixLength, const std::string& uri);
+    bool findBinding(const char* prefix, size_t prefixLength, size_t& index) const;
+    const std::string* getNamespace(const char* prefix, size_t prefixLength) const;
+    bool hasDuplicateAttributes() const;
+    void noteCapturedElement(const char* qname, size_t qnameLength);
+    void noteCapturedPrefix(const char* prefix, size_t prefixLength);
+    void finishCapture();
+
+    XMLParserClient* client;
+    bool error;
+    bool rootClosed;
+    bool hasByteOrderMark;
+    std::string buffer;
+
+    // Bytes of the document consumed so far
+    size_t consumed;
+
+    // Bytes after the start of the current token that do not contain the
+    // terminator being searched for
+    size_t scanned;
+
+    // Open elements and namespace bindings. Entries beyond the current
+    // depth and binding count are kept, so that their buffers are reused.
+    size_t depth;
+    std::vector<Element> elements;
+    size_t bindingCount;
+    std::vector<Binding> bindings;
+    size_t rawAttributeCount;
+    std::vector<RawAttribute> rawAttributes;
+
+    AttributeMap attributes;
+    std::string text;
+
+    // The token being parsed, and whether it was already copied
+    const char* tokenBegin;
+    const char* tokenEnd;
+    bool tokenCaptured;
+    bool reportingStartElement;
+
+    // The element being copied (see XMLParser::startCapture). Bindings
+    // below the outer binding count are declared outside of it; the ones
+    // it uses are declared on its start tag when it ends.
+    bool capturing;
+    size_t captureDepth;
+    size_t captureOuterBindingCount;
+    size_t captureDeclarationOffset;
+    std::string captureContextNamespace;
+    std::vector<size_t> captureOuterBindings;
+    bool captureUsesUndeclaredDefaultNamespace;
+    std::string captured;
+};
+
+Result NativeXMLParser::Private::parseToken(const char* begin, const char* end, const char*& next) {
+    if (consumed == 0 && static_cast<unsigned char>(*begin) == 0xEF) {
+        // Byte order mark
+        Result result = matchLiteral(begin, end, "\xEF\xBB\xBF");
+        if (result != Error) {
+            hasByteOrderMark = result == Done;
+            next = begin + 3;
+            return result;
+        }
+    }
+    switch (*begin) {
+        case '<':
+            if (end - begin < 2) {
+                return NeedMoreData;
+            }
+            switch (begin[1]) {
+                case '/': return parseEndTag(begin, end, next);
+                case '!': return parseCommentOrCDATA(begin, end, next);
+                case '?': return parseProcessingInstruction(begin, end, next);
+                default: return parseStartTag(begin, end, next);
+            }
+        case '&':
+            return parseReference(begin, end, next);
+        default:
+            return parseText(begin, end, next);
+    }
+}
+
+const char* NativeXMLParser::Private::findTerminator(const char* token, size_t offset, const char* end, const char* terminator) {
+    size_t terminatorLength = std::strlen(terminator);
+    const char* result = std::search(token + std::max(offset, scanned), end, terminator, terminator + terminatorLength);
+    if (result == end) {
+        size_t searched = static_cast<size_t>(end - token);
+        scanned = searched >= terminatorLength ? searched - terminatorLength + 1 : 0;
+    }
+    return result;
+}
+
+Result NativeXMLParser::Private::parseText(const char* begin, const char* end, const char*& next) {
+    const char* runEnd = begin;
+    while (true) {
+        runEnd += ByteScan::findFirst(runEnd, static_cast<size_t>(end - runEnd), ByteScan::XMLTextSpecial);
+        if (runEnd == end || *runEnd != '>') {
+            break;
+        }
+        if (runEnd - begin >= 2 && runEnd[-1] == ']' && runEnd[-2] == ']') {
+            return Error;
+        }
+        ++runEnd;
+    }
+
+    if (runEnd == end) {
+        // Keep back what may change meaning with the next data: an incomplete
+        // UTF-8 sequence, a carriage return that may be followed by a line
+        // feed, or the start of ']]>'.
+        for (const char* i = end; i > begin && end - i < 4; ) {
+            unsigned char c = static_cast<unsigned char>(*--i);
+            if (c >= 0xC0) {
+                if (static_cast<size_t>(end - i) < getUTF8SequenceLength(c)) {
+                    runEnd = i;
+                }
+                break;
+            }
+            else if (c < 0x80) {
+                break;
+            }
+        }
+        if (runEnd == end) {
+            if (runEnd[-1] == '\r') {
+                --runEnd;
+            }
+            for (int i = 0; i < 2 && runEnd > begin && runEnd[-1] == ']'; ++i) {
+                --runEnd;
+            }
+        }
+        if (runEnd == begin) {
+            return NeedMoreData;
+        }
+    }
+    if (!handleText(begin, runEnd)) {
+        return Error;
+    }
+    next = runEnd;
+    return Done;
+}
+
+bool NativeXMLParser::Private::handleText(const char* begin, const char* end) {
+    if (depth == 0) {
+        // Outside the root element, only whitespace is allowed
+        return skipWhitespace(begin, end) == end;
+    }
+    bool hasCarriageReturn = false;
+    if (!checkCharacters(begin, end, hasCarriageReturn)) {
+        return false;
+    }
+    if (hasCarriageReturn) {
+        text.clear();
+        appendNormalizingLineEnds(begin, end, text);
+    }
+    else {
+        text.assign(begin, end);
+    }
+    client->handleCharacterData(text);
+    return true;
+}
+
+Result NativeXMLParser::Private::parseReference(const char* begin, const char* end, const char*& next) {
+    if (depth == 0) {
+        return Error;
+    }
+    const char* searchEnd = end - begin > static_cast<std::ptrdiff_t>(MaxReferenceLength) ? begin + MaxReferenceLength : end;
+    const char* semicolon = std::find(begin + 1, searchEnd, ';');
+    if (semicolon == searchEnd) {
+        return searchEnd == end ? NeedMoreData : Error;
+    }
+    text.clear();
+    if (!appendReference(begin + 1, semicolon, text)) {
+        return Error;
+    }
+    client->handleCharacterData(text);
+    next = semicolon + 1;
+    return Done;
+}
+
+Result NativeXMLParser::Private::parseCommentOrCDATA(const char* begin, const char* end, const char*& next) {
+    Result comment = matchLiteral(begin, end, "<!--");
+    if (comment == NeedMoreData) {
+        return NeedMoreData;
+    }
+    else if (comment == Done) {
+        const char* close = findTerminator(begin, 4, end, "--");
+        if (close == end || close + 2 == end) {
+            return NeedMoreData;
+        }
+        bool hasCarriageReturn = false;
+        if (close[2] != '>' || !checkCharacters(begin + 4, close, hasCarriageReturn)) {
+            return Error;
+        }
+        next = close + 3;
+        return Done;
+    }
+
+    // Anything else starting with '<!' is a DTD
+    Result cdata = matchLiteral(begin, end, "<![CDATA[");
+    if (cdata != Done) {
+        return cdata;
+    }
+    if (depth == 0) {
+        return Error;
+    }
+    const char* close = findTerminator(begin, 9, end, "]]>");
+    if (close == end) {
+        return NeedMoreData;
+    }
+    if (close > begin + 9) {
+        bool hasCarriageReturn = false;
+        if (!checkCharacters(begin + 9, close, hasCarriageReturn)) {
+            return Error;
+        }
+        text.clear();
+        appendNormalizingLineEnds(begin + 9, close, text);
+        client->handleCharacterData(text);
+    }
+    next = close + 3;
+    return Done;
+}
+
+Result NativeXMLParser::Private::parseProcessingInstruction(const char* begin, const char* end, const char*& next) {
+    const char* close = findTerminator(begin, 2, end, "?>");
+    if (close == end) {
+        return NeedMoreData;
+    }
+    const char* target = begin + 2;
+    const char* targetEnd = scanName(target, close);
+    if (targetEnd == target || (targetEnd < close && !isWhitespace(*targetEnd))) {
+        return Error;
+    }
+    bool hasCarriageReturn = false;
+    if (!checkCharacters(targetEnd, close, hasCarriageReturn)) {
+        return Error;
+    }
+    size_t targetLength = static_cast<size_t>(targetEnd - target);
+    if (targetLength == 3 && std::tolower(target[0]) == 'x' && std::tolower(target[1]) == 'm' && std::tolower(target[2]) == 'l') {
+        // The XML declaration, which can only be preceded by a byte order
+        // mark
+        bool atStart = consumed == 0 || (consumed == 3 && hasByteOrderMark);
+        if (!equals(target, targetLength, "xml") || !atStart || !checkXMLDeclaration(targetEnd, close)) {
+            return Error;
+        }
+    }
+    next = close + 2;
+    return Done;
+}
+
+Result NativeXMLParser::Private::parseStartTag(const char* begin, const char* end, const char*& next) {
+    if (rootClosed) {
+        return Error;
+    }
+    if (findTerminator(begin, 1, end, ">") == end) {
+        return NeedMoreData;
+    }
+    const char* qname = begin + 1;
+    const char* i = scanName(qname, end);
+    if (i == qname) {
+        return Error;
+    }
+    const char* qnameEnd = i;
+
+    rawAttributeCount = 0;
+    bool isEmpty = false;
+    while (true) {
+        const char* attributeBegin = skipWhitespace(i, end);
+        if (attributeBegin == end) {
+            return NeedMoreData;
+        }
+        if (*attributeBegin == '>') {
+            i = attributeBegin + 1;
+            break;
+        }
+        if (*attributeBegin == '/') {
+            if (attributeBegin + 1 == end) {
+                return NeedMoreData;
+            }
+            if (attributeBegin[1] != '>') {
+                return Error;
+            }
+            i = attributeBegin + 2;
+            isEmpty = true;
+            break;
+        }
+        // Attributes have to be separated by whitespace
+        if (attributeBegin == i) {
+            return Error;
+        }
+        const char* attributeNameEnd = scanName(attributeBegin, end);
+        if (attributeNameEnd == attributeBegin) {
+            return Error;
+        }
+        i = skipWhitespace(attributeNameEnd, end);
+        if (i == end) {
+            return NeedMoreData;
+        }
+        if (*i != '=') {
+            return Error;
+        }
+        i = skipWhitespace(i + 1, end);
+        if (i == end) {
+            return NeedMoreData;
+        }
+        if (*i != '"' && *i != '\'') {
+            return Error;
+        }
+        const char* valueBegin = i + 1;
+        const char* valueEnd = std::find(valueBegin, end, *i);
+        if (std::find(valueBegin, valueEnd, '<') != valueEnd) {
+            return Error;
+        }
+        if (valueEnd == end) {
+            return NeedMoreData;
+        }
+
+        if (rawAttributeCount == rawAttributes.size()) {
+            rawAttributes.push_back(RawAttribute());
+        }
+        RawAttribute& attribute = rawAttributes[rawAttributeCount++];
+        attribute.qname = attributeBegin;
+        attribute.qnameLength = static_cast<size_t>(attributeNameEnd - attributeBegin);
+        if (!decodeAttributeValue(valueBegin, valueEnd, attribute.value)) {
+            return Error;
+        }
+        i = valueEnd + 1;
+    }
+
+    next = i;
+    tokenEnd = i;
+    return startElement(qname, static_cast<size_t>(qnameEnd - qname), isEmpty) ? Done : Error;
+}
+
+bool NativeXMLParser::Private::decodeAttributeValue(const char* begin, const char* end, std::string& value) {
+    bool hasCarriageReturn = false;
+    if (!checkCharacters(begin, end, hasCarriageReturn)) {
+        return false;
+    }
+    value.clear();
+    const char* run = begin;
+    for (const char* i = begin; i < end; ++i) {
+        char c = *i;
+        if (c == '&' || c == '<' || c == '\t' || c == '\n' || c == '\r') {
+            value.append(run, i);
+            if (c == '&') {
+                const char* semicolon = std::find(i + 1, end, ';');
+                if (semicolon == end || !appendReference(i + 1, semicolon, value)) {
+                    return false;
+                }
+                i = semicolon;
+            }
+            else if (c == '<') {
+                return false;
+            }
+            else {
+                // Literal whitespace is normalized to spaces, with line ends
+                // normalized first
+                value += ' ';
+                if (c == '\r' && i + 1 < end && i[1] == '\n') {
+                    ++i;
+                }
+            }
+            run = i + 1;
+        }
+    }
+    value.append(run, end);
+    return true;
+}
+
+bool NativeXMLParser::Private::startElement(const char* qname, size_t qnameLength, bool isEmpty) {
+    if (hasDuplicateAttributes()) {
+        return false;
+    }
+    size_t elementBindingCount = bindingCount;
+    for (size_t i = 0; i < rawAttributeCount; ++i) {
+        const RawAttribute& attribute = rawAttributes[i];
+        if (equals(attribute.qname, attribute.qnameLength, "xmlns")) {
+            if (!addBinding(attribute.qname, 0, attribute.value)) {
+                return false;
+            }
+        }
+        else if (attribute.qnameLength > 6 && std::memcmp(attribute.qname, "xmlns:", 6) == 0) {
+            if (attribute.value.empty() || !addBinding(attribute.qname + 6, attribute.qnameLength - 6, attribute.value)) {
+                return false;
+            }
+        }
+    }
+
+    if (depth == elements.size()) {
+        elements.push_back(Element());
+    }
+    Element& element = elements[depth];
+    element.qname.assign(qname, qnameLength);
+    element.bindingCount = elementBindingCount;
+    // Names with undefined prefixes are passed on unexpanded, as with the
+    // (patched) bundled Expat
+    const char* colon = static_cast<const char*>(std::memchr(qname, ':', qnameLength));
+    const std::string* ns = colon ? &NoNamespace : getNamespace(qname, 0);
+    element.name.assign(qname, qnameLength);
+    if (colon) {
+        size_t prefixLength = static_cast<size_t>(colon - qname);
+        if (prefixLength == 0 || prefixLength + 1 == qnameLength || std::memchr(colon + 1, ':', qnameLength - prefixLength - 1)) {
+            return false;
+        }
+        if (const std::string* prefixNamespace = getNamespace(qname, prefixLength)) {
+            ns = prefixNamespace;
+            element.name.erase(0, prefixLength + 1);
+        }
+    }
+    element.ns = *ns;
+
+    attributes.clear();
+    for (size_t i = 0; i < rawAttributeCount; ++i) {
+        const RawAttribute& attribute = rawAttributes[i];
+        if (equals(attribute.qname, attribute.qnameLength, "xmlns") || (attribute.qnameLength > 6 && std::memcmp(attribute.qname, "xmlns:", 6) == 0)) {
+            continue;
+        }
+        const char* attributeColon = static_cast<const char*>(std::memchr(attribute.qname, ':', attribute.qnameLength));
+        if (attributeColon) {
+            size_t prefixLength = static_cast<size_t>(attributeColon - attribute.qname);
+            size_t nameLength = attribute.qnameLength - prefixLength - 1;
+            if (prefixLength == 0 || nameLength == 0 || std::memchr(attributeColon + 1, ':', nameLength)) {
+                return false;
+            }
+            const std::string* attributeNamespace = getNamespace(attribute.qname, prefixLength);
+            if (!attributeNamespace) {
+                attributes.addAttribute(std::string(attribute.qname, attribute.qnameLength), NoNamespace, attribute.value);
+                continue;
+            }
+            std::string name(attributeColon + 1, nameLength);
+            // Different prefixes can be bound to the same namespace
+            for (const auto& entry : attributes.getEntries()) {
+                if (entry.getAttribute().getName() == name && entry.getAttribute().getNamespace() == *attributeNamespace) {
+                    return false;
+                }
+            }
+            attributes.addAttribute(name, *attributeNamespace, attribute.value);
+        }
+        else {
+            attributes.addAttribute(std::string(attribute.qname, attribute.qnameLength), NoNamespace, attribute.value);
+        }
+    }
+
+    depth++;
+    reportingStartElement = true;
+    client->handleStartElement(element.name, element.ns, attributes);
+    reportingStartElement = false;
+    if (capturing) {
+        noteCapturedElement(qname, qnameLength);
+        captured.append(tokenBegin, tokenEnd);
+        tokenCaptured = true;
+    }
+    if (isEmpty) {
+        endElement();
+    }
+    return true;
+}
+
+void NativeXMLParser::Private::endElement() {
+    const Element& element = elements[depth - 1];
+    if (capturing) {
+        if (!tokenCaptured) {
+            captured.append(tokenBegin, tokenEnd);
+            tokenCaptured = true;
+        }
+        if (depth == captureDepth) {
+            finishCapture();
+        }
+    }
+    client->handleEndElement(element.name, element.ns);
+    bindingCount = element.bindingCount;
+    depth--;
+    if (depth == 0) {
+        rootClosed = true;
+    }
+}
+
+Result NativeXMLParser::Private::parseEndTag(const char* begin, const char* end, const char*& next) {
+    const char* close = findTerminator(begin, 2, end, ">");
+    if (close == end) {
+        return NeedMoreData;
+    }
+    const char* qname = begin + 2;
+    const char* qnameEnd = scanName(qname, close);
+    if (qnameEnd == qname || skipWhitespace(qnameEnd, close) != close) {
+        return Error;
+    }
+    if (depth == 0 || !equals(qname, static_cast<size_t>(qnameEnd - qname), elements[depth - 1].qname)) {
+        return Error;
+    }
+    next = close + 1;
+    tokenEnd = next;
+    endElement();
+    return Done;
+}
+
+bool NativeXMLParser::Private::addBinding(const char* prefix, size_t prefixLength, const std::string& uri) {
+    // The 'xml' prefix is bound to its namespace, and the 'xmlns' prefix
+    // cannot be declared. Neither namespace can be bound to another prefix.
+    bool isXMLPrefix = equals(prefix, prefixLength, "xml");
+    if (isXMLPrefix != (uri == XMLNamespace) || equals(prefix, prefixLength, "xmlns") || uri == XMLNSNamespace) {
+        return false;
+    }
+    if (bindingCount == bindings.size()) {
+        bindings.push_back(Binding());
+    }
+    Binding& binding = bindings[bindingCount++];
+    binding.prefix.assign(prefix, prefixLength);
+    binding.uri = uri;
+    return true;
+}
+
+bool NativeXMLParser::Private::findBinding(const char* prefix, size_t prefixLength, size_t& index) const {
+    for (size_t i = bindingCount; i > 0; --i) {
+        if (equals(prefix, prefixLength, bindings[i - 1].prefix)) {
+            index = i - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::string* NativeXMLParser::Private::getNamespace(const char* prefix, size_t prefixLength) const {
+    size_t index = 0;
+    if (findBinding(prefix, prefixLength, index)) {
+        return &bindings[index].uri;
+    }
+    if (prefixLength == 0) {
+        return &NoNamespace;
+    }
+    if (equals(prefix, prefixLength, "xml")) {
+        return &XMLNamespace;
+    }
+    return nullptr;
+}
+
+bool NativeXMLParser::Private::hasDuplicateAttributes() const {
+    auto qnameLess = [this](size_t a, size_t b) {
+        const RawAttribute& first = rawAttributes[a];
+        const RawAttribute& second = rawAttributes[b];
+        int result = std::memcmp(first.qname, second.qname, std::min(first.qnameLength, second.qnameLength));
+        return result < 0 || (result == 0 && first.qnameLength < second.qnameLength);
+    };
+    if (rawAttributeCount <= 8) {
+        for (size_t i = 0; i < rawAttributeCount; ++i) {
+            for (size_t j = i + 1; j < rawAttributeCount; ++j) {
+                if (!qnameLess(i, j) && !qnameLess(j, i)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    std::vector<size_t> order(rawAttributeCount);
+    for (size_t i = 0; i < rawAttributeCount; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), qnameLess);
+    for (size_t i = 1; i < rawAttributeCount; ++i) {
+        if (!qnameLess(order[i - 1], order[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void NativeXMLParser::Private::noteCapturedElement(const char* qname, size_t qnameLength) {
+    const char* colon = static_cast<const char*>(std::memchr(qname, ':', qnameLength));
+    noteCapturedPrefix(qname, colon ? static_cast<size_t>(colon - qname) : 0);
+    for (size_t i = 0; i < rawAttributeCount; ++i) {
+        const RawAttribute& attribute = rawAttributes[i];
+        const char* attributeColon = static_cast<const char*>(std::memchr(attribute.qname, ':', attribute.qnameLength));
+        if (attributeColon && !(attribute.qnameLength > 6 && std::memcmp(attribute.qname, "xmlns:", 6) == 0)) {
+            noteCapturedPrefix(attribute.qname, static_cast<size_t>(attributeColon - attribute.qname));
+        }
+    }
+}
+
+void NativeXMLParser::Private::noteCapturedPrefix(const char* prefix, size_t prefixLength) {
+    size_t index = 0;
+    if (findBinding(prefix, prefixLength, index)) {
+        if (index < captureOuterBindingCount && std::find(captureOuterBindings.begin(), captureOuterBindings.end(), index) == captureOuterBindings.end()) {
+            captureOuterBindings.push_back(index);
+        }
+    }
+    else if (prefixLength == 0) {
+        captureUsesUndeclaredDefaultNamespace = true;
+    }
+}
+
+void NativeXMLParser::Private::finishCapture() {
+    std::string declarations;
+    for (size_t index : captureOuterBindings) {
+        const Binding& binding = bindings[index];
+        if (binding.prefix.empty()) {
+            if (binding.uri == captureContextNamespace) {
+                continue;
+            }
+            declarations += " xmlns=\"";
+        }
+        else {
+            declarations += " xmlns:" + binding.prefix + "=\"";
+        }
+        declarations += XMLEscape::escapeAttributeValue(binding.uri);
+        declarations += '"';
+    }
+    if (captureUsesUndeclaredDefaultNamespace && !captureContextNamespace.empty()) {
+        declarations += " xmlns=\"\"";
+    }
+    captured.insert(captureDeclarationOffset, declarations);
+    capturing = false;
+}
+
+NativeXMLParser::NativeXMLParser(XMLParserClient* client) : XMLParser(client), p(new Private(client)) {
+}
+
+NativeXMLParser::~NativeXMLParser() {
+}
+
+bool NativeXMLParser::parse(const std::string& data) {
+    if (p->error) {
+        return false;
+    }
+
+    // Only data left over from the previous call (i.e. an incomplete token)
+    // is copied
+    bool buffered = !p->buffer.empty();
+    if (buffered) {
+        p->buffer.append(data);
+    }
+    const char* begin = buffered ? p->buffer.data() : data.data();
+    const char* end = begin + (buffered ? p->buffer.size() : data.size());
+
+    const char* current = begin;
+    while (current < end) {
+        const char* next = current;
+        p->tokenBegin = current;
+        p->tokenCaptured = false;
+        Result result = p->parseToken(current, end, next);
+        if (result == Error) {
+            p->error = true;
+            p->buffer.clear();
+            return false;
+        }
+        if (result == NeedMoreData) {
+            break;
+        }
+        if (p->capturing && !p->tokenCaptured) {
+            p->captured.append(current, next);
+        }
+        p->consumed += static_cast<size_t>(next - current);
+        p->scanned = 0;
+        current = next;
+    }
+
+    if (buffered) {
+        p->buffer.erase(0, static_cast<size_t>(current - begin));
+    }
+    else {
+        p->buffer.assign(current, end);
+    }
+    return true;
+}
+
+bool NativeXMLParser::startCapture(const std::string& contextNamespace) {
+    if (!p->reportingStartElement || p->capturing) {
+        return false;
+    }
+    const Private::Element& element = p->elements[p->depth - 1];
+    p->capturing = true;
+    p->captureDepth = p->depth;
+    p->captureOuterBindingCount = element.bindingCount;
+    p->captureDeclarationOffset = 1 + element.qname.size();
+    p->captureContextNamespace = contextNamespace;
+    p->captureOuterBindings.clear();
+    p->captureUsesUndeclaredDefaultNamespace = false;
+    p->captured.clear();
+    return true;
+}
+
+const std::string& NativeXMLParser::getCapturedXML() const {
+    return p->captured;
+}
+
+}
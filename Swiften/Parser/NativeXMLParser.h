@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Parser/XMLParser.h>
+
+namespace Swift {
+    /**
+     * An XML parser for the subset of XML that is allowed in XMPP streams.
+     *
+     * Documents with a DTD are rejected, and only the predefined entities
+     * and character references are supported. Namespaces are processed as
+     * with the other parsers. Per-element state is kept in buffers that are
+     * reused, so parsing a stanza does not allocate memory for every
+     * element.
+     */
+    class SWIFTEN_API NativeXMLParser : public XMLParser, public boost::noncopyable {
+        public:
+            NativeXMLParser(XMLParserClient* client);
+            ~NativeXMLParser();
+
+            bool parse(const std::string& data);
+
+            bool startCapture(const std::string& contextNamespace);
+            const std::string& getCapturedXML() const;
+
+        private:
+            struct Private;
+            const std::unique_ptr<Private> p;
+    };
+}
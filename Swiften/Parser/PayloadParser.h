@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -46,5 +46,35 @@ namespace Swift {
              * Retrieve a pointer to the payload.
              */
             virtual std::shared_ptr<Payload> getPayload() const = 0;
+
+            /**
+             * Prepares the parser for parsing another payload, after the
+             * previous one was retrieved with getPayload().
+             *
+             * Returns whether the parser supports this. Parsers that do not
+             * (the default) are not reused.
+             */
+            virtual bool reset() {
+                return false;
+            }
+
+            /**
+             * Returns whether the parser would rather get the payload as the
+             * XML it was received as (the default is false).
+             *
+             * If the XML parser can capture it, handleRawXML() is called
+             * with the XML of the whole payload before getPayload(), and
+             * no other events are passed. Otherwise, the events are passed
+             * as usual.
+             */
+            virtual bool wantsRawXML() const {
+                return false;
+            }
+
+            /**
+             * Handle the XML of the whole payload (see wantsRawXML()).
+             */
+            virtual void handleRawXML(const std::string& /* xml */) {
+            }
     };
 }
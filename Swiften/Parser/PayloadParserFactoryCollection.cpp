@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,8 @@
 #include <Swiften/Parser/PayloadParserFactoryCollection.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
 
 #include <boost/bind.hpp>
 
@@ -14,10 +16,35 @@
 
 namespace Swift {
 
-PayloadParserFactoryCollection::PayloadParserFactoryCollection() : defaultFactory_(nullptr) {
+struct PayloadParserFactoryCollection::LifetimeState {
+    LifetimeState() : released(false) {}
+
+    std::mutex mutex;
+    std::condition_variable releasedCondition;
+    bool released;
+};
+
+PayloadParserFactoryCollection::PayloadParserFactoryCollection() : defaultFactory_(nullptr), revision_(0), lifetimeState_(std::make_shared<LifetimeState>()) {
+    std::shared_ptr<LifetimeState> state = lifetimeState_;
+    lifetime_ = std::shared_ptr<bool>(new bool(), [state](bool* lifetime) {
+        delete lifetime;
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->released = true;
+        state->releasedCondition.notify_all();
+    });
 }
 
 PayloadParserFactoryCollection::~PayloadParserFactoryCollection() {
+    endLifetime();
+}
+
+void PayloadParserFactoryCollection::endLifetime() {
+    if (!lifetime_) {
+        return;
+    }
+    lifetime_.reset();
+    std::unique_lock<std::mutex> lock(lifetimeState_->mutex);
+    lifetimeState_->releasedCondition.wait(lock, [this]() { return lifetimeState_->released; });
 }
 
 void PayloadParserFactoryCollection::addFactory(PayloadParserFactory* factory) {
@@ -26,10 +53,12 @@ void PayloadParserFactoryCollection::addFactory(PayloadParserFactory* factory) {
 
 void PayloadParserFactoryCollection::removeFactory(PayloadParserFactory* factory) {
     factories_.erase(std::remove(factories_.begin(), factories_.end(), factory), factories_.end());
+    ++revision_;
 }
 
 void PayloadParserFactoryCollection::setDefaultFactory(PayloadParserFactory* factory) {
     defaultFactory_ = factory;
+    ++revision_;
 }
 
 PayloadParserFactory* PayloadParserFactoryCollection::getPayloadParserFactory(const std::string& element, const std::string& ns, const AttributeMap& attributes) {
@@ -1,20 +1,23 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include <boost/noncopyable.hpp>
+
 #include <Swiften/Base/API.h>
 #include <Swiften/Parser/AttributeMap.h>
 
 namespace Swift {
     class PayloadParserFactory;
 
-    class SWIFTEN_API PayloadParserFactoryCollection {
+    class SWIFTEN_API PayloadParserFactoryCollection : public boost::noncopyable {
         public:
             PayloadParserFactoryCollection();
             virtual ~PayloadParserFactoryCollection();
@@ -25,8 +28,43 @@ namespace Swift {
 
             PayloadParserFactory* getPayloadParserFactory(const std::string& element, const std::string& ns, const AttributeMap& attributes);
 
+            /**
+             * Returns a number that changes whenever a factory is removed or
+             * the default factory is replaced. Code that keeps parsers
+             * around per factory drops them when this changes, as the
+             * factory may be gone, and its address reused by another one.
+             */
+            unsigned int getRevision() const {
+                return revision_;
+            }
+
+            /**
+             * Returns a pointer that expires when this collection is
+             * destroyed, for code that uses the collection after the
+             * element it was used for has been parsed (possibly on another
+             * thread). Such code locks the pointer for as long as it uses
+             * the collection, and the destructor waits until it is
+             * released.
+             */
+            std::weak_ptr<void> getLifetime() const {
+                return lifetime_;
+            }
+
+        protected:
+            /**
+             * Expires the pointer returned by getLifetime(), and waits until
+             * it is no longer locked. Subclasses that own factories call
+             * this before destroying them.
+             */
+            void endLifetime();
+
         private:
+            struct LifetimeState;
+
             std::vector<PayloadParserFactory*> factories_;
             PayloadParserFactory* defaultFactory_;
+            unsigned int revision_;
+            std::shared_ptr<LifetimeState> lifetimeState_;
+            std::shared_ptr<void> lifetime_;
     };
 }
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Parser/PayloadParserPool.h>
+
+#include <Swiften/Parser/PayloadParser.h>
+#include <Swiften/Parser/PayloadParserFactory.h>
+#include <Swiften/Parser/PayloadParserFactoryCollection.h>
+#include <Swiften/Parser/UnknownPayloadParser.h>
+
+namespace Swift {
+
+PayloadParserPool::PayloadParserPool(PayloadParserFactoryCollection* factories) : factories_(factories), factoriesRevision_(factories->getRevision()) {
+}
+
+PayloadParserPool::~PayloadParserPool() {
+}
+
+std::unique_ptr<PayloadParser> PayloadParserPool::acquire(PayloadParserFactory* factory) {
+    dropParsersIfFactoriesChanged();
+    auto i = parsers_.find(factory);
+    if (i != parsers_.end() && i->second) {
+        return std::move(i->second);
+    }
+    if (factory) {
+        return std::unique_ptr<PayloadParser>(factory->createPayloadParser());
+    }
+    return std::unique_ptr<PayloadParser>(new UnknownPayloadParser());
+}
+
+void PayloadParserPool::release(PayloadParserFactory* factory, std::unique_ptr<PayloadParser> parser) {
+    // If a factory was removed while the parser was in use, the parser may
+    // belong to it, so it is not kept
+    if (dropParsersIfFactoriesChanged()) {
+        return;
+    }
+    if (parser->reset()) {
+        parsers_[factory] = std::move(parser);
+    }
+}
+
+bool PayloadParserPool::dropParsersIfFactoriesChanged() {
+    if (factories_->getRevision() == factoriesRevision_) {
+        return false;
+    }
+    parsers_.clear();
+    factoriesRevision_ = factories_->getRevision();
+    return true;
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include <boost/noncopyable.hpp>
+
+#include <Swiften/Base/API.h>
+
+namespace Swift {
+    class PayloadParser;
+    class PayloadParserFactory;
+    class PayloadParserFactoryCollection;
+
+    /**
+     * Keeps payload parsers after use, so that the next payload of the same
+     * kind can be parsed without creating a new parser.
+     *
+     * Only parsers that support PayloadParser::reset() are kept. As a
+     * stanza is parsed one payload at a time, one parser is kept per
+     * factory. Parsers are looked up by the factory that created them.
+     * The pool drops all its parsers when a factory is removed from
+     * \p factories (see PayloadParserFactoryCollection::getRevision()),
+     * so a parser is never handed out for a factory that was destroyed,
+     * or for another factory that got the same address.
+     */
+    class SWIFTEN_API PayloadParserPool : public boost::noncopyable {
+        public:
+            PayloadParserPool(PayloadParserFactoryCollection* factories);
+            ~PayloadParserPool();
+
+            /**
+             * Returns a parser created by \p factory, or an
+             * UnknownPayloadParser if \p factory is null.
+             */
+            std::unique_ptr<PayloadParser> acquire(PayloadParserFactory* factory);
+
+            /**
+             * Takes back \p parser, which was acquired for \p factory and
+             * whose payload has been retrieved.
+             */
+            void release(PayloadParserFactory* factory, std::unique_ptr<PayloadParser> parser);
+
+        private:
+            bool dropParsersIfFactoriesChanged();
+
+        private:
+            PayloadParserFactoryCollection* factories_;
+            unsigned int factoriesRevision_;
+            std::unordered_map<PayloadParserFactory*, std::unique_ptr<PayloadParser> > parsers_;
+    };
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -26,4 +26,11 @@ void BodyParser::handleCharacterData(const std::string& data) {
     text_ += data;
 }
 
+bool BodyParser::reset() {
+    resetPayload();
+    level_ = 0;
+    text_.clear();
+    return true;
+}
+
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -30,4 +30,10 @@ void CapsInfoParser::handleCharacterData(const std::string&) {
 
 }
 
+bool CapsInfoParser::reset() {
+    resetPayload();
+    level = 0;
+    return true;
+}
+
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -38,4 +38,10 @@ void ChatStateParser::handleCharacterData(const std::string&) {
 
 }
 
+bool ChatStateParser::reset() {
+    resetPayload();
+    level_ = 0;
+    return true;
+}
+
 }
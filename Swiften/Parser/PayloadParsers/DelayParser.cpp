@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -33,4 +33,10 @@ void DelayParser::handleCharacterData(const std::string&) {
 
 }
 
+bool DelayParser::reset() {
+    resetPayload();
+    level_ = 0;
+    return true;
+}
+
 }
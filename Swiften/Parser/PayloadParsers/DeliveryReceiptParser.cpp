@@ -4,6 +4,12 @@
  * See http://www.opensource.org/licenses/bsd-license.php for more information.
  */
 
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
 #include <Swiften/Parser/PayloadParsers/DeliveryReceiptParser.h>
 
 #include <boost/optional.hpp>
@@ -32,4 +38,10 @@ void DeliveryReceiptParser::handleCharacterData(const std::string&) {
 
 }
 
+bool DeliveryReceiptParser::reset() {
+    resetPayload();
+    level_ = 0;
+    return true;
+}
+
 }
@@ -4,6 +4,12 @@
  * See http://www.opensource.org/licenses/bsd-license.php for more information.
  */
 
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
 #include <Swiften/Parser/PayloadParsers/DeliveryReceiptRequestParser.h>
 
 #include <boost/optional.hpp>
@@ -27,4 +33,9 @@ void DeliveryReceiptRequestParser::handleCharacterData(const std::string&) {
 
 }
 
+bool DeliveryReceiptRequestParser::reset() {
+    resetPayload();
+    return true;
+}
+
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2015 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -24,5 +24,6 @@ namespace Swift {
             virtual void handleStartElement(const std::string&, const std::string&, const AttributeMap&);
             virtual void handleEndElement(const std::string&, const std::string&);
             virtual void handleCharacterData(const std::string& data);
+            virtual bool reset();
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -198,6 +198,7 @@ FullPayloadParserFactoryCollection::FullPayloadParserFactoryCollection() {
 }
 
 FullPayloadParserFactoryCollection::~FullPayloadParserFactoryCollection() {
+    endLifetime();
     setDefaultFactory(nullptr);
     delete defaultFactory_;
     for (auto& factory : factories_) {
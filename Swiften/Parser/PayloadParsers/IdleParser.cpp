@@ -4,6 +4,12 @@
  * See Documentation/Licenses/BSD-simplified.txt for more information.
  */
 
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
 #include <Swiften/Parser/PayloadParsers/IdleParser.h>
 
 #include <Swiften/Base/DateTime.h>
@@ -29,4 +35,10 @@ void IdleParser::handleCharacterData(const std::string&) {
 
 }
 
+bool IdleParser::reset() {
+    resetPayload();
+    level_ = 0;
+    return true;
+}
+
 }
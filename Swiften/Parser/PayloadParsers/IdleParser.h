@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2015-2016 Isode Limited.
+ * Copyright (c) 2015-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -24,6 +24,7 @@ namespace Swift {
             virtual void handleStartElement(const std::string& element, const std::string&, const AttributeMap& attributes);
             virtual void handleEndElement(const std::string& element, const std::string&);
             virtual void handleCharacterData(const std::string& data);
+            virtual bool reset();
 
         private:
             int level_;
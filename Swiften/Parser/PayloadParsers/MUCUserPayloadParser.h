@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2015 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -19,6 +19,11 @@ namespace Swift {
         public:
             MUCUserPayloadParser(PayloadParserFactoryCollection* collection) : factories(collection) {}
             virtual void handleTree(ParserElement::ref root);
+
+            virtual bool reset() {
+                resetTree();
+                return true;
+            }
         private:
             PayloadParserFactoryCollection* factories;
     };
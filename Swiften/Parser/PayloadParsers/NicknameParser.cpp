@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -26,4 +26,11 @@ void NicknameParser::handleCharacterData(const std::string& data) {
     text += data;
 }
 
+bool NicknameParser::reset() {
+    resetPayload();
+    level = 0;
+    text.clear();
+    return true;
+}
+
 }
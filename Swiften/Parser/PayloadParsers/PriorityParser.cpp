@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -34,4 +34,11 @@ void PriorityParser::handleCharacterData(const std::string& data) {
     text_ += data;
 }
 
+bool PriorityParser::reset() {
+    resetPayload();
+    level_ = 0;
+    text_.clear();
+    return true;
+}
+
 }
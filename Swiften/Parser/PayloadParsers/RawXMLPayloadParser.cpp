@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -30,4 +30,8 @@ void RawXMLPayloadParser::handleCharacterData(const std::string& data) {
     serializingParser_.handleCharacterData(data);
 }
 
+void RawXMLPayloadParser::handleRawXML(const std::string& xml) {
+    getPayloadInternal()->setRawXML(xml);
+}
+
 }
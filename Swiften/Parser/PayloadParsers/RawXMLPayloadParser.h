@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -22,6 +22,12 @@ namespace Swift {
             virtual void handleEndElement(const std::string& element, const std::string&);
             virtual void handleCharacterData(const std::string& data);
 
+            virtual bool wantsRawXML() const {
+                return true;
+            }
+
+            virtual void handleRawXML(const std::string& xml);
+
         private:
             int level_;
             SerializingParser serializingParser_;
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2012 Isode Limited.
+ * Copyright (c) 2012-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -34,4 +34,10 @@ namespace Swift {
     void ReplaceParser::handleCharacterData(const std::string&) {
     }
 
+    bool ReplaceParser::reset() {
+        resetPayload();
+        level_ = 0;
+        return true;
+    }
+
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -40,4 +40,11 @@ void StatusShowParser::handleCharacterData(const std::string& data) {
     text_ += data;
 }
 
+bool StatusShowParser::reset() {
+    resetPayload();
+    level_ = 0;
+    text_.clear();
+    return true;
+}
+
 }
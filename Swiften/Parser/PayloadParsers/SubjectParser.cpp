@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -28,4 +28,11 @@ void SubjectParser::handleCharacterData(const std::string& data) {
     }
 }
 
+bool SubjectParser::reset() {
+    resetPayload();
+    level_ = 0;
+    text_.clear();
+    return true;
+}
+
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,7 +8,9 @@
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
 #include <Swiften/Elements/MUCDestroyPayload.h>
+#include <Swiften/Parser/PayloadParsers/FullPayloadParserFactoryCollection.h>
 #include <Swiften/Parser/PayloadParsers/MUCUserPayloadParser.h>
+#include <Swiften/Parser/PayloadParsers/UnitTest/PayloadParserTester.h>
 #include <Swiften/Parser/PayloadParsers/UnitTest/PayloadsParserTester.h>
 
 using namespace Swift;
@@ -20,6 +22,7 @@ class MUCUserPayloadParserTest : public CppUnit::TestFixture
         CPPUNIT_TEST(testParse);
         CPPUNIT_TEST(testParseDestroy);
         CPPUNIT_TEST(testParseInvite);
+        CPPUNIT_TEST(testParse_AfterReset);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -88,6 +91,22 @@ class MUCUserPayloadParserTest : public CppUnit::TestFixture
             CPPUNIT_ASSERT_EQUAL(JID("alice@wonderland.lit/xxx"), invite.to);
         }
 
+        void testParse_AfterReset() {
+            FullPayloadParserFactoryCollection factories;
+            MUCUserPayloadParser testling(&factories);
+            CPPUNIT_ASSERT(PayloadParserTester(&testling).parse("<x xmlns=\"http://jabber.org/protocol/muc#user\"><status code='110'/></x>"));
+            MUCUserPayload::ref payload1 = std::dynamic_pointer_cast<MUCUserPayload>(testling.getPayload());
+
+            CPPUNIT_ASSERT(testling.reset());
+            CPPUNIT_ASSERT(PayloadParserTester(&testling).parse("<x xmlns=\"http://jabber.org/protocol/muc#user\"><status code='210'/></x>"));
+            MUCUserPayload::ref payload2 = std::dynamic_pointer_cast<MUCUserPayload>(testling.getPayload());
+
+            CPPUNIT_ASSERT(payload1 != payload2);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), payload1->getStatusCodes().size());
+            CPPUNIT_ASSERT_EQUAL(110, payload1->getStatusCodes()[0].code);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), payload2->getStatusCodes().size());
+            CPPUNIT_ASSERT_EQUAL(210, payload2->getStatusCodes()[0].code);
+        }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(MUCUserPayloadParserTest);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -29,4 +29,11 @@ void VCardUpdateParser::handleCharacterData(const std::string& text) {
     currentText_ += text;
 }
 
+bool VCardUpdateParser::reset() {
+    resetPayload();
+    level_ = TopLevel;
+    currentText_.clear();
+    return true;
+}
+
 }
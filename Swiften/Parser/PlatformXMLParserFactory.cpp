@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,7 +8,9 @@
 
 #include <cassert>
 
-#ifdef HAVE_LIBXML
+#if defined(USE_NATIVE_XML_PARSER)
+#include <Swiften/Parser/NativeXMLParser.h>
+#elif defined(HAVE_LIBXML)
 #include <Swiften/Parser/LibXMLParser.h>
 #else
 #include <Swiften/Parser/ExpatParser.h>
@@ -21,7 +23,9 @@ PlatformXMLParserFactory::PlatformXMLParserFactory() {
 }
 
 std::unique_ptr<XMLParser> PlatformXMLParserFactory::createXMLParser(XMLParserClient* client) {
-#ifdef HAVE_LIBXML
+#if defined(USE_NATIVE_XML_PARSER)
+    return std::make_unique<NativeXMLParser>(client);
+#elif defined(HAVE_LIBXML)
     return std::make_unique<LibXMLParser>(client);
 #else
     return std::make_unique<ExpatParser>(client);
@@ -1,50 +1,110 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Parser/SerializingParser.h>
 
+#include <algorithm>
 #include <cassert>
-#include <memory>
 
-#include <Swiften/Serializer/XML/XMLTextNode.h>
+#include <Swiften/Serializer/XML/XMLEscape.h>
 
 namespace Swift {
 
-SerializingParser::SerializingParser() {
+static const std::string XMLNSAttribute = "xmlns";
+static const std::string XMLNamespace = "http://www.w3.org/XML/1998/namespace";
+
+SerializingParser::SerializingParser() : depth_(0), startTagOpen_(false), done_(false) {
 }
 
-void SerializingParser::handleStartElement(const std::string& tag, const std::string&  ns, const AttributeMap& attributes) {
-    std::shared_ptr<XMLElement> element = std::make_shared<XMLElement>(tag, ns);
-    // FIXME: Ignoring attribute namespace
-    for (const auto& e : attributes.getEntries()) {
-        element->setAttribute(e.getAttribute().getName(), e.getValue());
+void SerializingParser::handleStartElement(const std::string& element, const std::string& ns, const AttributeMap& attributes) {
+    if (done_) {
+        return;
     }
+    closeStartTag();
 
-    if (elementStack_.empty()) {
-        rootElement_ = element;
+    // Like XMLElement, a later attribute with the same name (including
+    // 'xmlns') replaces an earlier one. Namespaced attributes get a prefix
+    // that is declared on the element, or 'xml:'.
+    attributes_.clear();
+    if (!ns.empty()) {
+        attributes_.push_back(std::make_pair(XMLNSAttribute, &ns));
     }
-    else {
-        (*(elementStack_.end() - 1))->addNode(element);
+    size_t prefixCount = 0;
+    for (const auto& entry : attributes.getEntries()) {
+        const Attribute& attribute = entry.getAttribute();
+        std::string name;
+        if (attribute.getNamespace() == XMLNamespace) {
+            name = "xml:" + attribute.getName();
+        }
+        else if (!attribute.getNamespace().empty()) {
+            std::string prefix = "ns" + std::to_string(prefixCount++);
+            attributes_.push_back(std::make_pair(XMLNSAttribute + ":" + prefix, &attribute.getNamespace()));
+            name = prefix + ":" + attribute.getName();
+        }
+        else {
+            name = attribute.getName();
+        }
+        auto i = std::find_if(attributes_.begin(), attributes_.end(), [&name](const std::pair<std::string, const std::string*>& existing) { return existing.first == name; });
+        if (i != attributes_.end()) {
+            i->second = &entry.getValue();
+        }
+        else {
+            attributes_.push_back(std::make_pair(name, &entry.getValue()));
+        }
+    }
+    std::sort(attributes_.begin(), attributes_.end(), [](const std::pair<std::string, const std::string*>& a, const std::pair<std::string, const std::string*>& b) { return a.first < b.first; });
+
+    result_ += '<';
+    result_ += element;
+    for (const auto& attribute : attributes_) {
+        result_ += ' ';
+        result_ += attribute.first;
+        result_ += "=\"";
+        result_ += XMLEscape::escapeAttributeValue(*attribute.second);
+        result_ += '"';
     }
-    elementStack_.push_back(element);
+    attributes_.clear();
+    startTagOpen_ = true;
+    ++depth_;
 }
 
-void SerializingParser::handleEndElement(const std::string&, const std::string&) {
-    assert(!elementStack_.empty());
-    elementStack_.pop_back();
+void SerializingParser::handleEndElement(const std::string& element, const std::string&) {
+    if (done_) {
+        return;
+    }
+    assert(depth_ > 0);
+    if (startTagOpen_) {
+        result_ += "/>";
+        startTagOpen_ = false;
+    }
+    else {
+        result_ += "</";
+        result_ += element;
+        result_ += '>';
+    }
+    --depth_;
+    done_ = depth_ == 0;
 }
 
 void SerializingParser::handleCharacterData(const std::string& data) {
-    if (!elementStack_.empty()) {
-        (*(elementStack_.end()-1))->addNode(std::make_shared<XMLTextNode>(data));
+    if (depth_ > 0) {
+        closeStartTag();
+        result_ += XMLEscape::escapeText(data);
+    }
+}
+
+void SerializingParser::closeStartTag() {
+    if (startTagOpen_) {
+        result_ += '>';
+        startTagOpen_ = false;
     }
 }
 
 std::string SerializingParser::getResult() const {
-    return (rootElement_ ? rootElement_->serialize() : "");
+    return result_;
 }
 
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,12 +7,21 @@
 #pragma once
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Parser/AttributeMap.h>
-#include <Swiften/Serializer/XML/XMLElement.h>
 
 namespace Swift {
+    /**
+     * Serializes the parsed element back to XML.
+     *
+     * The XML is written out as the events come in, in the same form as
+     * XMLElement::serialize(): every element declares its namespace, and
+     * attributes are sorted by name. Namespaced attributes are written with
+     * an 'xml:' prefix, or with a prefix declared on their element.
+     */
     class SWIFTEN_API SerializingParser {
         public:
             SerializingParser();
@@ -24,7 +33,13 @@ namespace Swift {
             std::string getResult() const;
 
         private:
-            std::vector< std::shared_ptr<XMLElement> > elementStack_;
-            std::shared_ptr<XMLElement> rootElement_;
+            void closeStartTag();
+
+        private:
+            std::string result_;
+            std::vector< std::pair<std::string, const std::string*> > attributes_;
+            size_t depth_;
+            bool startTagOpen_;
+            bool done_;
     };
 }
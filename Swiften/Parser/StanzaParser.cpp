@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -10,36 +10,143 @@
 
 #include <boost/optional.hpp>
 
+#include <Swiften/Elements/UnparsedPayload.h>
 #include <Swiften/Parser/PayloadParser.h>
 #include <Swiften/Parser/PayloadParserFactory.h>
 #include <Swiften/Parser/PayloadParserFactoryCollection.h>
+#include <Swiften/Parser/PayloadParserPool.h>
+#include <Swiften/Parser/PlatformXMLParserFactory.h>
 #include <Swiften/Parser/UnknownPayloadParser.h>
+#include <Swiften/Parser/XMLParser.h>
+#include <Swiften/Parser/XMLParserClient.h>
+#include <Swiften/Serializer/XML/XMLElement.h>
+#include <Swiften/Serializer/XML/XMLEscape.h>
+#include <Swiften/Serializer/XML/XMLRawTextNode.h>
 
 namespace Swift {
 
+static const std::string XMLNamespace = "http://www.w3.org/XML/1998/namespace";
+
+namespace {
+    /**
+     * Parses the XML of an unparsed payload, which is wrapped in an element
+     * that declares the namespace of its stanza. The payload parser is
+     * looked up when the payload starts, like when receiving it.
+     */
+    class UnparsedPayloadXMLParserClient : public XMLParserClient {
+        public:
+            UnparsedPayloadXMLParserClient(PayloadParserFactoryCollection* factories) : factories_(factories), depth_(0) {
+            }
+
+            virtual void handleStartElement(const std::string& element, const std::string& ns, const AttributeMap& attributes) {
+                if (depth_ == 1 && !parser_) {
+                    if (PayloadParserFactory* factory = factories_->getPayloadParserFactory(element, ns, attributes)) {
+                        parser_.reset(factory->createPayloadParser());
+                    }
+                }
+                if (depth_ > 0 && parser_) {
+                    parser_->handleStartElement(element, ns, attributes);
+                }
+                ++depth_;
+            }
+
+            virtual void handleEndElement(const std::string& element, const std::string& ns) {
+                --depth_;
+                if (depth_ > 0 && parser_) {
+                    parser_->handleEndElement(element, ns);
+                }
+            }
+
+            virtual void handleCharacterData(const std::string& data) {
+                if (depth_ > 1 && parser_) {
+                    parser_->handleCharacterData(data);
+                }
+            }
+
+            std::shared_ptr<Payload> getPayload() const {
+                return parser_ ? parser_->getPayload() : std::shared_ptr<Payload>();
+            }
+
+        private:
+            PayloadParserFactoryCollection* factories_;
+            int depth_;
+            std::unique_ptr<PayloadParser> parser_;
+    };
+}
+
+static std::shared_ptr<Payload> parseUnparsedPayload(const std::weak_ptr<void>& factoriesLifetime, PayloadParserFactoryCollection* factories, const std::string& stanzaNamespace, const std::string& xml) {
+    // Keeps the factories from being destroyed until the payload is parsed
+    std::shared_ptr<void> lifetime = factoriesLifetime.lock();
+    if (!lifetime) {
+        return std::shared_ptr<Payload>();
+    }
+    XMLElement wrapper("payload", stanzaNamespace);
+    wrapper.addNode(std::make_shared<XMLRawTextNode>(xml));
+    UnparsedPayloadXMLParserClient client(factories);
+    PlatformXMLParserFactory xmlParserFactory;
+    if (!xmlParserFactory.createXMLParser(&client)->parse(wrapper.serialize())) {
+        return std::shared_ptr<Payload>();
+    }
+    return client.getPayload();
+}
+
 StanzaParser::StanzaParser(PayloadParserFactoryCollection* factories) :
-        currentDepth_(0), factories_(factories) {
+        currentDepth_(0), factories_(factories), lazyPayloadParsing_(false), payloadParserPool_(nullptr), currentPayloadParserFactory_(nullptr), capturingPayload_(false), xmlParser_(nullptr), capturingRawXML_(false), currentPayloadStartTagOpen_(false) {
 }
 
 StanzaParser::~StanzaParser() {
 }
 
+void StanzaParser::reset() {
+    if (currentPayloadParser_) {
+        releasePayloadParser();
+    }
+    currentPayloadParserFactory_ = nullptr;
+    capturingPayload_ = false;
+    capturingRawXML_ = false;
+    currentPayloadStartTagOpen_ = false;
+    stanzaNamespace_.clear();
+    currentDepth_ = 0;
+}
+
 void StanzaParser::handleStartElement(const std::string& element, const std::string& ns, const AttributeMap& attributes) {
     if (inStanza()) {
         if (!inPayload()) {
-            assert(!currentPayloadParser_);
+            assert(!currentPayloadParser_ && !currentPayloadParserFactory_);
             PayloadParserFactory* payloadParserFactory = factories_->getPayloadParserFactory(element, ns, attributes);
-            if (payloadParserFactory) {
-                currentPayloadParser_.reset(payloadParserFactory->createPayloadParser());
+            currentPayloadParserFactory_ = payloadParserFactory;
+            if (payloadParserFactory && lazyPayloadParsing_) {
+                capturingPayload_ = true;
+                capturingRawXML_ = xmlParser_ && xmlParser_->startCapture(stanzaNamespace_);
+                currentPayloadXML_.clear();
             }
             else {
-                currentPayloadParser_.reset(new UnknownPayloadParser());
+                if (payloadParserPool_) {
+                    currentPayloadParser_ = payloadParserPool_->acquire(payloadParserFactory);
+                }
+                else if (payloadParserFactory) {
+                    currentPayloadParser_.reset(payloadParserFactory->createPayloadParser());
+                }
+                else {
+                    currentPayloadParser_.reset(new UnknownPayloadParser());
+                }
+                capturingRawXML_ = currentPayloadParser_->wantsRawXML() && xmlParser_ && xmlParser_->startCapture(stanzaNamespace_);
             }
         }
-        assert(currentPayloadParser_);
-        currentPayloadParser_->handleStartElement(element, ns, attributes);
+        // While the XML parser captures the payload, its events are ignored
+        if (capturingRawXML_) {
+            // Nothing to do
+        }
+        else if (capturingPayload_) {
+            appendPayloadStartElement(element, ns, attributes);
+        }
+        else {
+            assert(currentPayloadParser_);
+            currentPayloadParser_->handleStartElement(element, ns, attributes);
+        }
     }
     else {
+        stanzaNamespace_ = ns;
         boost::optional<std::string> from = attributes.getAttributeValue("from");
         if (from) {
             getStanza()->setFrom(JID(*from));
@@ -59,16 +166,42 @@ void StanzaParser::handleStartElement(const std::string& element, const std::str
 
 void StanzaParser::handleEndElement(const std::string& element, const std::string& ns) {
     assert(inStanza());
-    if (inPayload()) {
+    if (inPayload() && capturingPayload_) {
+        if (!capturingRawXML_) {
+            appendPayloadEndElement(element);
+        }
+        --currentDepth_;
+        if (!inPayload()) {
+            if (capturingRawXML_) {
+                currentPayloadXML_ = xmlParser_->getCapturedXML();
+                capturingRawXML_ = false;
+            }
+            std::weak_ptr<void> factoriesLifetime = factories_->getLifetime();
+            PayloadParserFactoryCollection* factories = factories_;
+            std::string stanzaNamespace = stanzaNamespace_;
+            getStanza()->addPayload(std::make_shared<UnparsedPayload>(currentPayloadXML_, [factoriesLifetime, factories, stanzaNamespace](const std::string& xml) {
+                return parseUnparsedPayload(factoriesLifetime, factories, stanzaNamespace, xml);
+            }));
+            currentPayloadParserFactory_ = nullptr;
+            capturingPayload_ = false;
+        }
+    }
+    else if (inPayload()) {
         assert(currentPayloadParser_);
-        currentPayloadParser_->handleEndElement(element, ns);
+        if (!capturingRawXML_) {
+            currentPayloadParser_->handleEndElement(element, ns);
+        }
         --currentDepth_;
         if (!inPayload()) {
+            if (capturingRawXML_) {
+                currentPayloadParser_->handleRawXML(xmlParser_->getCapturedXML());
+                capturingRawXML_ = false;
+            }
             std::shared_ptr<Payload> payload(currentPayloadParser_->getPayload());
             if (payload) {
                 getStanza()->addPayload(payload);
             }
-            currentPayloadParser_.reset();
+            releasePayloadParser();
         }
     }
     else {
@@ -76,10 +209,82 @@ void StanzaParser::handleEndElement(const std::string& element, const std::strin
     }
 }
 
+void StanzaParser::releasePayloadParser() {
+    if (payloadParserPool_) {
+        payloadParserPool_->release(currentPayloadParserFactory_, std::move(currentPayloadParser_));
+    }
+    currentPayloadParser_.reset();
+    currentPayloadParserFactory_ = nullptr;
+}
+
 void StanzaParser::handleCharacterData(const std::string& data) {
-    if (currentPayloadParser_) {
+    if (capturingRawXML_) {
+        // Nothing to do
+    }
+    else if (capturingPayload_) {
+        if (currentPayloadStartTagOpen_) {
+            currentPayloadXML_ += '>';
+            currentPayloadStartTagOpen_ = false;
+        }
+        currentPayloadXML_ += XMLEscape::escapeText(data);
+    }
+    else if (currentPayloadParser_) {
         currentPayloadParser_->handleCharacterData(data);
     }
 }
 
+void StanzaParser::appendPayloadStartElement(const std::string& element, const std::string& ns, const AttributeMap& attributes) {
+    // The namespace is declared wherever it differs from the parent's. As
+    // with parsed payloads, payloads in the stanza namespace are serialized
+    // without one.
+    size_t depth = static_cast<size_t>(currentDepth_ - 1);
+    if (currentPayloadStartTagOpen_) {
+        currentPayloadXML_ += '>';
+    }
+    currentPayloadXML_ += '<';
+    currentPayloadXML_ += element;
+    if (ns != (depth == 0 ? stanzaNamespace_ : currentPayloadNamespaces_[depth - 1])) {
+        currentPayloadXML_ += " xmlns=\"";
+        currentPayloadXML_ += XMLEscape::escapeAttributeValue(ns);
+        currentPayloadXML_ += '"';
+    }
+    if (depth < currentPayloadNamespaces_.size()) {
+        currentPayloadNamespaces_[depth] = ns;
+    }
+    else {
+        currentPayloadNamespaces_.push_back(ns);
+    }
+    size_t prefixCount = 0;
+    for (const auto& entry : attributes.getEntries()) {
+        const Attribute& attribute = entry.getAttribute();
+        currentPayloadXML_ += ' ';
+        if (attribute.getNamespace() == XMLNamespace) {
+            currentPayloadXML_ += "xml:";
+        }
+        else if (!attribute.getNamespace().empty()) {
+            std::string prefix = "ns" + std::to_string(prefixCount++);
+            currentPayloadXML_ += "xmlns:" + prefix + "=\"";
+            currentPayloadXML_ += XMLEscape::escapeAttributeValue(attribute.getNamespace());
+            currentPayloadXML_ += "\" " + prefix + ":";
+        }
+        currentPayloadXML_ += attribute.getName();
+        currentPayloadXML_ += "=\"";
+        currentPayloadXML_ += XMLEscape::escapeAttributeValue(entry.getValue());
+        currentPayloadXML_ += '"';
+    }
+    currentPayloadStartTagOpen_ = true;
+}
+
+void StanzaParser::appendPayloadEndElement(const std::string& element) {
+    if (currentPayloadStartTagOpen_) {
+        currentPayloadXML_ += "/>";
+        currentPayloadStartTagOpen_ = false;
+    }
+    else {
+        currentPayloadXML_ += "</";
+        currentPayloadXML_ += element;
+        currentPayloadXML_ += '>';
+    }
+}
+
 }
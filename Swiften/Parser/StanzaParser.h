@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
 
@@ -18,7 +19,10 @@
 
 namespace Swift {
     class PayloadParser;
+    class PayloadParserFactory;
     class PayloadParserFactoryCollection;
+    class PayloadParserPool;
+    class XMLParser;
 
     class SWIFTEN_API StanzaParser : public ElementParser, public boost::noncopyable {
         public:
@@ -29,6 +33,46 @@ namespace Swift {
             void handleEndElement(const std::string& element, const std::string& ns);
             void handleCharacterData(const std::string& data);
 
+            /**
+             * Sets whether the parsing of payloads is deferred until they are
+             * looked up on the stanza (disabled by default).
+             *
+             * When enabled, the XML of each payload is kept in an
+             * UnparsedPayload, and payloads that are never looked up are
+             * serialized from this XML. Payloads that are looked up after the
+             * payload parser factory collection is destroyed are not parsed,
+             * and stay raw XML payloads.
+             */
+            void setLazyPayloadParsing(bool lazy) {
+                lazyPayloadParsing_ = lazy;
+            }
+
+            /**
+             * Sets the pool from which payload parsers are taken, and to
+             * which they are returned after use. Without a pool, a new
+             * payload parser is created for every payload.
+             */
+            void setPayloadParserPool(PayloadParserPool* pool) {
+                payloadParserPool_ = pool;
+            }
+
+            /**
+             * Sets the XML parser that feeds this parser. If it supports
+             * capturing elements (see XMLParser::startCapture()), deferred
+             * payloads and payloads whose parser wants raw XML are taken
+             * as they were received, instead of being serialized from the
+             * parser events.
+             */
+            void setXMLParser(XMLParser* xmlParser) {
+                xmlParser_ = xmlParser;
+            }
+
+            /**
+             * Prepares the parser for parsing another stanza, after the
+             * previous one was retrieved with getElement().
+             */
+            virtual void reset();
+
             virtual std::shared_ptr<ToplevelElement> getElement() const = 0;
             virtual void handleStanzaAttributes(const AttributeMap&) {}
 
@@ -37,6 +81,8 @@ namespace Swift {
             }
 
         private:
+            void releasePayloadParser();
+
             bool inPayload() const {
                 return currentDepth_ > 1;
             }
@@ -45,10 +91,24 @@ namespace Swift {
                 return currentDepth_ > 0;
             }
 
+            void appendPayloadStartElement(const std::string& element, const std::string& ns, const AttributeMap& attributes);
+            void appendPayloadEndElement(const std::string& element);
 
         private:
             int currentDepth_;
             PayloadParserFactoryCollection* factories_;
-            std::shared_ptr<PayloadParser> currentPayloadParser_;
+            std::unique_ptr<PayloadParser> currentPayloadParser_;
+            bool lazyPayloadParsing_;
+            PayloadParserPool* payloadParserPool_;
+            std::string stanzaNamespace_;
+            // The factory of the current payload, or null if it is unknown
+            PayloadParserFactory* currentPayloadParserFactory_;
+            bool capturingPayload_;
+            XMLParser* xmlParser_;
+            // Whether the XML parser is capturing the current payload
+            bool capturingRawXML_;
+            std::string currentPayloadXML_;
+            std::vector<std::string> currentPayloadNamespaces_;
+            bool currentPayloadStartTagOpen_;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2015 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -34,6 +34,9 @@ void StreamFeaturesParser::handleStartElement(const std::string& element, const
         else if (element == "ver" && ns == "urn:xmpp:features:rosterver") {
             getElementGeneric()->setHasRosterVersioning();
         }
+        else if (element == "csi" && ns == "urn:xmpp:csi:0") {
+            getElementGeneric()->setHasClientStateIndication();
+        }
     }
     else if (currentDepth_ == 2) {
         if (inCompression_ && element == "method") {
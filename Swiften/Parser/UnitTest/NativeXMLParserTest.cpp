@@ -0,0 +1,546 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Parser/NativeXMLParser.h>
+#include <Swiften/Parser/XMLParserClient.h>
+#ifdef HAVE_EXPAT
+#include <Swiften/Parser/ExpatParser.h>
+#endif
+#ifdef HAVE_LIBXML
+#include <Swiften/Parser/LibXMLParser.h>
+#endif
+
+using namespace Swift;
+
+#ifdef HAVE_EXPAT
+typedef ExpatParser ReferenceParser;
+#else
+typedef LibXMLParser ReferenceParser;
+#endif
+
+class NativeXMLParserTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(NativeXMLParserTest);
+        CPPUNIT_TEST(testParse_LineEnds);
+        CPPUNIT_TEST(testParse_LineEndSplitAcrossChunks);
+        CPPUNIT_TEST(testParse_AttributeWhitespace);
+        CPPUNIT_TEST(testParse_CharacterReferences);
+        CPPUNIT_TEST(testParse_InvalidCharacterReference);
+        CPPUNIT_TEST(testParse_UndefinedEntity);
+        CPPUNIT_TEST(testParse_CDATA);
+        CPPUNIT_TEST(testParse_CDATAEndInText);
+        CPPUNIT_TEST(testParse_XMLDeclaration);
+        CPPUNIT_TEST(testParse_XMLDeclarationNotAtStart);
+        CPPUNIT_TEST(testParse_ByteOrderMark);
+        CPPUNIT_TEST(testParse_ProcessingInstruction);
+        CPPUNIT_TEST(testParse_XMLNamespace);
+        CPPUNIT_TEST(testParse_DefaultNamespaceUndeclared);
+        CPPUNIT_TEST(testParse_NamespaceScope);
+        CPPUNIT_TEST(testParse_UndefinedPrefix);
+        CPPUNIT_TEST(testParse_EmptyPrefixedNamespace);
+        CPPUNIT_TEST(testParse_DuplicateAttribute);
+        CPPUNIT_TEST(testParse_DuplicateExpandedAttribute);
+        CPPUNIT_TEST(testParse_InvalidUTF8);
+        CPPUNIT_TEST(testParse_UTF8SplitAcrossChunks);
+        CPPUNIT_TEST(testParse_ControlCharacter);
+        CPPUNIT_TEST(testParse_TextOutsideRoot);
+        CPPUNIT_TEST(testParse_SecondRoot);
+        CPPUNIT_TEST(testParse_MismatchedEndTag);
+        CPPUNIT_TEST(testParse_SplitAtEveryByte);
+        CPPUNIT_TEST(testParse_CompareWithReferenceParser);
+        CPPUNIT_TEST(testParse_CompareMutatedWithReferenceParser);
+        CPPUNIT_TEST(testCapture_Verbatim);
+        CPPUNIT_TEST(testCapture_SplitAtEveryByte);
+        CPPUNIT_TEST(testCapture_InheritedNamespaces);
+        CPPUNIT_TEST(testCapture_UndeclaredDefaultNamespace);
+        CPPUNIT_TEST(testCapture_Nested);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void testParse_LineEnds() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a>T(x\ny\nz\n)</a>"), parse("<a>x\r\ny\rz\n</a>"));
+        }
+
+        void testParse_LineEndSplitAcrossChunks() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a>T(x\ny)</a>"), parseChunks({"<a>x\r", "\ny</a>"}));
+        }
+
+        void testParse_AttributeWhitespace() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a b='1 2 3 4 \n5'></a>"), parse("<a b='1\t2\n3\r\n4 &#10;5'/>"));
+        }
+
+        void testParse_CharacterReferences() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a>T(A\xc3\xa9\xf0\x9f\x98\x80)</a>"), parse("<a>&#65;&#xe9;&#x1F600;</a>"));
+        }
+
+        void testParse_InvalidCharacterReference() {
+            CPPUNIT_ASSERT(!isValid("<a>&#0;</a>"));
+            CPPUNIT_ASSERT(!isValid("<a>&#xD800;</a>"));
+            CPPUNIT_ASSERT(!isValid("<a>&#x110000;</a>"));
+            CPPUNIT_ASSERT(!isValid("<a>&#x;</a>"));
+        }
+
+        void testParse_UndefinedEntity() {
+            CPPUNIT_ASSERT(!isValid("<a>&nbsp;</a>"));
+            CPPUNIT_ASSERT(!isValid("<a b='&nbsp;'/>"));
+        }
+
+        void testParse_CDATA() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a>T(x<b>&amp;]]y)</a>"), parse("<a>x<![CDATA[<b>&amp;]]]]><![CDATA[]]>y</a>"));
+            CPPUNIT_ASSERT(!isValid("<![CDATA[x]]><a/>"));
+        }
+
+        void testParse_CDATAEndInText() {
+            CPPUNIT_ASSERT(!isValid("<a>x]]>y</a>"));
+            CPPUNIT_ASSERT(!isValidChunks({"<a>x]", "]", ">y</a>"}));
+            CPPUNIT_ASSERT(isValid("<a>x]]y]></a>"));
+        }
+
+        void testParse_XMLDeclaration() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a></a>"), parse("<?xml version='1.0' encoding='UTF-8' standalone='yes'?><a/>"));
+            CPPUNIT_ASSERT(!isValid("<?xml encoding='UTF-8'?><a/>"));
+            CPPUNIT_ASSERT(!isValid("<?xml version='1.0' foo='bar'?><a/>"));
+        }
+
+        void testParse_XMLDeclarationNotAtStart() {
+            CPPUNIT_ASSERT(!isValid(" <?xml version='1.0'?><a/>"));
+            CPPUNIT_ASSERT(!isValid("<a><?xml version='1.0'?></a>"));
+        }
+
+        void testParse_ByteOrderMark() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a></a>"), parseChunks({"\xef\xbb", "\xbf<?xml version='1.0'?><a/>"}));
+        }
+
+        void testParse_ProcessingInstruction() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a>T(xy)</a>"), parse("<?foo?><a>x<?bar baz?>y</a>"));
+        }
+
+        void testParse_XMLNamespace() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a {http://www.w3.org/XML/1998/namespace}lang='en'></a>"), parse("<a xml:lang='en'/>"));
+            CPPUNIT_ASSERT(!isValid("<a xmlns:xml='urn:foo'/>"));
+            CPPUNIT_ASSERT(!isValid("<a xmlns:foo='http://www.w3.org/XML/1998/namespace'/>"));
+            CPPUNIT_ASSERT(!isValid("<a xmlns:xmlns='urn:foo'/>"));
+        }
+
+        void testParse_DefaultNamespaceUndeclared() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<{urn:a}a><b></b></{urn:a}a>"), parse("<a xmlns='urn:a'><b xmlns=''/></a>"));
+        }
+
+        void testParse_NamespaceScope() {
+            CPPUNIT_ASSERT_EQUAL(
+                std::string("<{urn:a}a><{urn:b}b></{urn:b}b><{urn:a}c></{urn:a}c></{urn:a}a>"),
+                parse("<p:a xmlns:p='urn:a'><p:b xmlns:p='urn:b'/><p:c/></p:a>"));
+        }
+
+        void testParse_UndefinedPrefix() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<foo:bar><bla></bla></foo:bar>"), parse("<foo:bar><bla/></foo:bar>"));
+            CPPUNIT_ASSERT_EQUAL(std::string("<foo bar:baz='bla'></foo>"), parse("<foo bar:baz='bla'/>"));
+        }
+
+        void testParse_EmptyPrefixedNamespace() {
+            CPPUNIT_ASSERT(!isValid("<a xmlns:p=''/>"));
+        }
+
+        void testParse_DuplicateAttribute() {
+            CPPUNIT_ASSERT(!isValid("<a b='1' b='2'/>"));
+            CPPUNIT_ASSERT(!isValid("<a b0='' b1='' b2='' b3='' b4='' b5='' b6='' b7='' b8='' b9='' b5=''/>"));
+        }
+
+        void testParse_DuplicateExpandedAttribute() {
+            CPPUNIT_ASSERT(!isValid("<a xmlns:p='urn:a' xmlns:q='urn:a' p:b='1' q:b='2'/>"));
+        }
+
+        void testParse_InvalidUTF8() {
+            CPPUNIT_ASSERT(!isValid("<a>\xc3</a>"));
+            CPPUNIT_ASSERT(!isValid("<a>\xc0\x80</a>"));
+            CPPUNIT_ASSERT(!isValid("<a>\xed\xa0\x80</a>"));
+            CPPUNIT_ASSERT(!isValid("<a>\xef\xbf\xbf</a>"));
+            CPPUNIT_ASSERT(!isValid("<a b='\xff'/>"));
+        }
+
+        void testParse_UTF8SplitAcrossChunks() {
+            CPPUNIT_ASSERT_EQUAL(std::string("<a>T(\xf0\x9f\x98\x80)</a>"), parseChunks({"<a>\xf0", "\x9f", "\x98\x80</a>"}));
+        }
+
+        void testParse_ControlCharacter() {
+            CPPUNIT_ASSERT(!isValid(std::string("<a>\0</a>", 8)));
+            CPPUNIT_ASSERT(!isValid("<a>\x01</a>"));
+            CPPUNIT_ASSERT(!isValid("<a b='\x1b'/>"));
+        }
+
+        void testParse_TextOutsideRoot() {
+            CPPUNIT_ASSERT(isValid(" \n<a/>\n"));
+            CPPUNIT_ASSERT(!isValid("x<a/>"));
+            CPPUNIT_ASSERT(!isValid("&amp;<a/>"));
+        }
+
+        void testParse_SecondRoot() {
+            CPPUNIT_ASSERT(!isValid("<a/><b/>"));
+        }
+
+        void testParse_MismatchedEndTag() {
+            CPPUNIT_ASSERT(!isValid("<a></b>"));
+            CPPUNIT_ASSERT(!isValid("<p:a xmlns:p='urn:a' xmlns:q='urn:a'></q:a>"));
+            CPPUNIT_ASSERT(!isValid("</a>"));
+        }
+
+        void testParse_SplitAtEveryByte() {
+            std::string document =
+                "\xef\xbb\xbf<?xml version='1.0'?>\r\n"
+                "<stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams' xml:lang='en'>"
+                "<message to='alice@wonderland.lit' type='chat'><body>Hi\r\n&amp; &#x1F600; \xc3\xa9]]</body>"
+                "<!-- comment --><![CDATA[<x>]]><?pi data?></message>"
+                "</stream:stream>";
+            std::string expected = parse(document);
+            for (size_t i = 1; i < document.size(); ++i) {
+                CPPUNIT_ASSERT_EQUAL(expected, parseChunks({document.substr(0, i), document.substr(i)}));
+            }
+            std::vector<std::string> bytes;
+            for (char c : document) {
+                bytes.push_back(std::string(1, c));
+            }
+            CPPUNIT_ASSERT_EQUAL(expected, parseChunks(bytes));
+        }
+
+        void testParse_CompareWithReferenceParser() {
+            std::mt19937 generator(1);
+            for (int i = 0; i < 200; ++i) {
+                std::string document = generateDocument(generator, true);
+                std::string expected;
+                CPPUNIT_ASSERT_MESSAGE(document, parse<ReferenceParser>({document}, expected));
+                std::string actual;
+                CPPUNIT_ASSERT_MESSAGE(document, parse<NativeXMLParser>(split(document, generator), actual));
+                CPPUNIT_ASSERT_EQUAL_MESSAGE(document, expected, actual);
+            }
+        }
+
+        void testParse_CompareMutatedWithReferenceParser() {
+            std::mt19937 generator(2);
+            // Without prefixes (or colons to create them), as the parsers
+            // handle undefined prefixes differently, and without carriage
+            // returns, as LibXML does not normalize them in CDATA sections
+            static const std::string replacements("<>&;'\"=/!?-[]x \0\x80", 17);
+            for (int i = 0; i < 1000; ++i) {
+                std::string document = generateDocument(generator, false);
+                document.erase(std::remove(document.begin(), document.end(), '\r'), document.end());
+                // The declared encoding is ignored, as by Expat (but not by
+                // LibXML)
+                size_t declarationEnd = document.find("?>");
+                size_t start = declarationEnd == std::string::npos ? 0 : declarationEnd + 2;
+                size_t position = std::uniform_int_distribution<size_t>(start, document.size() - 1)(generator);
+                char replacement = replacements[std::uniform_int_distribution<size_t>(0, replacements.size() - 1)(generator)];
+                switch (generator() % 3) {
+                    case 0: document[position] = replacement; break;
+                    case 1: document.insert(position, 1, replacement); break;
+                    case 2: document.erase(position, 1); break;
+                }
+
+                std::string expected;
+                bool expectedComplete = false;
+                bool expectedResult = parse<ReferenceParser>({document}, expected, &expectedComplete);
+                std::string actual;
+                bool actualComplete = false;
+                bool actualResult = parse<NativeXMLParser>(split(document, generator), actual, &actualComplete);
+                // Parsers can differ in how much of an incomplete token (or
+                // of what follows the root element) they look at before
+                // reporting an error
+                if (!expectedResult) {
+                    CPPUNIT_ASSERT_MESSAGE(document, !actualResult || !actualComplete);
+                }
+                else if (expectedComplete) {
+                    CPPUNIT_ASSERT_MESSAGE(document, actualResult || actualComplete);
+                    CPPUNIT_ASSERT_EQUAL_MESSAGE(document, expected, actual);
+                }
+            }
+        }
+
+        void testCapture_Verbatim() {
+            std::vector<std::string> result = capture({"<stream xmlns='jabber:client'><a  y = \"2\" x='&lt;1'>\r\n<![CDATA[<z>]]>&amp;&#65;<b/><?pi x?></a ><c/></stream>"}, "jabber:client");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), result.size());
+            CPPUNIT_ASSERT_EQUAL(std::string("<a  y = \"2\" x='&lt;1'>\r\n<![CDATA[<z>]]>&amp;&#65;<b/><?pi x?></a >"), result[0]);
+            CPPUNIT_ASSERT_EQUAL(std::string("<c/>"), result[1]);
+        }
+
+        void testCapture_SplitAtEveryByte() {
+            std::string document = "<stream xmlns='jabber:client'><a x='1'>x\xc3\xa9<![CDATA[y]]><b/></a></stream>";
+            std::vector<std::string> chunks;
+            for (char c : document) {
+                chunks.push_back(std::string(1, c));
+            }
+
+            std::vector<std::string> result = capture(chunks, "jabber:client");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), result.size());
+            CPPUNIT_ASSERT_EQUAL(std::string("<a x='1'>x\xc3\xa9<![CDATA[y]]><b/></a>"), result[0]);
+        }
+
+        void testCapture_InheritedNamespaces() {
+            std::vector<std::string> result = capture({"<s:stream xmlns:s='urn:s' xmlns='jabber:client' xmlns:p='urn:p' xmlns:q='urn:q'><p:a p:x='1'><b/></p:a></s:stream>"}, "jabber:server");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), result.size());
+            CPPUNIT_ASSERT_EQUAL(std::string("<p:a xmlns:p=\"urn:p\" xmlns=\"jabber:client\" p:x='1'><b/></p:a>"), result[0]);
+        }
+
+        void testCapture_UndeclaredDefaultNamespace() {
+            std::vector<std::string> result = capture({"<s:stream xmlns:s='urn:s'><a/><b xmlns='urn:b'/></s:stream>"}, "jabber:client");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), result.size());
+            CPPUNIT_ASSERT_EQUAL(std::string("<a xmlns=\"\"/>"), result[0]);
+            CPPUNIT_ASSERT_EQUAL(std::string("<b xmlns='urn:b'/>"), result[1]);
+        }
+
+        void testCapture_Nested() {
+            CapturingClient client;
+            NativeXMLParser parser(&client);
+            client.parser = &parser;
+            client.captureNested = true;
+
+            CPPUNIT_ASSERT(parser.parse("<stream><a><b/></a></stream>"));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), client.captured.size());
+            CPPUNIT_ASSERT_EQUAL(std::string("<a><b/></a>"), client.captured[0]);
+            CPPUNIT_ASSERT(client.nestedCaptureRejected);
+        }
+
+    private:
+        /**
+         * Captures the children of the root element.
+         */
+        class CapturingClient : public XMLParserClient {
+            public:
+                virtual void handleStartElement(const std::string&, const std::string&, const AttributeMap&) {
+                    if (depth == 1) {
+                        CPPUNIT_ASSERT(parser->startCapture(contextNamespace));
+                    }
+                    else if (depth > 1 && captureNested) {
+                        nestedCaptureRejected = !parser->startCapture(contextNamespace);
+                    }
+                    depth++;
+                }
+
+                virtual void handleEndElement(const std::string&, const std::string&) {
+                    depth--;
+                    if (depth == 1) {
+                        captured.push_back(parser->getCapturedXML());
+                    }
+                }
+
+                virtual void handleCharacterData(const std::string&) {
+                }
+
+                NativeXMLParser* parser = nullptr;
+                std::string contextNamespace;
+                bool captureNested = false;
+                bool nestedCaptureRejected = false;
+                std::vector<std::string> captured;
+                int depth = 0;
+        };
+
+        static std::vector<std::string> capture(const std::vector<std::string>& chunks, const std::string& contextNamespace) {
+            CapturingClient client;
+            NativeXMLParser parser(&client);
+            client.parser = &parser;
+            client.contextNamespace = contextNamespace;
+            for (const auto& chunk : chunks) {
+                CPPUNIT_ASSERT(parser.parse(chunk));
+            }
+            return client.captured;
+        }
+
+        /**
+         * Records the events as a string, with character data coalesced.
+         */
+        class Client : public XMLParserClient {
+            public:
+                virtual void handleStartElement(const std::string& element, const std::string& ns, const AttributeMap& attributes) {
+                    flushText();
+                    depth++;
+                    std::vector<std::string> attributeStrings;
+                    for (const auto& entry : attributes.getEntries()) {
+                        attributeStrings.push_back(" " + getName(entry.getAttribute().getName(), entry.getAttribute().getNamespace()) + "='" + entry.getValue() + "'");
+                    }
+                    std::sort(attributeStrings.begin(), attributeStrings.end());
+                    result += "<" + getName(element, ns);
+                    for (const auto& attribute : attributeStrings) {
+                        result += attribute;
+                    }
+                    result += ">";
+                }
+
+                virtual void handleEndElement(const std::string& element, const std::string& ns) {
+                    flushText();
+                    depth--;
+                    result += "</" + getName(element, ns) + ">";
+                }
+
+                virtual void handleCharacterData(const std::string& data) {
+                    text += data;
+                }
+
+                void flushText() {
+                    if (!text.empty()) {
+                        result += "T(" + text + ")";
+                        text.clear();
+                    }
+                }
+
+                static std::string getName(const std::string& name, const std::string& ns) {
+                    return ns.empty() ? name : "{" + ns + "}" + name;
+                }
+
+                std::string result;
+                std::string text;
+                int depth = 0;
+        };
+
+        /**
+         * Returns whether all chunks were parsed, and sets \p result to the
+         * events up to the first error. \p complete is set if the root
+         * element was closed.
+         */
+        template<typename ParserType>
+        static bool parse(const std::vector<std::string>& chunks, std::string& result, bool* complete = nullptr) {
+            Client client;
+            ParserType parser(&client);
+            bool success = std::all_of(chunks.begin(), chunks.end(), [&](const std::string& chunk) { return parser.parse(chunk); });
+            client.flushText();
+            result = client.result;
+            if (complete) {
+                *complete = !result.empty() && client.depth == 0;
+            }
+            return success;
+        }
+
+        static std::string parseChunks(const std::vector<std::string>& chunks) {
+            std::string result;
+            if (!parse<NativeXMLParser>(chunks, result)) {
+                return "error";
+            }
+            return result;
+        }
+
+        static std::string parse(const std::string& document) {
+            return parseChunks({document});
+        }
+
+        static bool isValidChunks(const std::vector<std::string>& chunks) {
+            std::string result;
+            return parse<NativeXMLParser>(chunks, result);
+        }
+
+        static bool isValid(const std::string& document) {
+            return isValidChunks({document});
+        }
+
+        static std::vector<std::string> split(const std::string& document, std::mt19937& generator) {
+            std::vector<std::string> chunks;
+            size_t position = 0;
+            while (position < document.size()) {
+                size_t size = std::uniform_int_distribution<size_t>(1, 40)(generator);
+                chunks.push_back(document.substr(position, size));
+                position += size;
+            }
+            return chunks;
+        }
+
+        template<typename T>
+        static const T& pick(const std::vector<T>& values, std::mt19937& generator) {
+            return values[std::uniform_int_distribution<size_t>(0, values.size() - 1)(generator)];
+        }
+
+        static std::string generateText(std::mt19937& generator, bool inAttribute) {
+            static const std::vector<std::string> pieces = {
+                "a", "text", " ", "\t", "\n", "\r\n", "\r", "&amp;", "&lt;", "&gt;", "&quot;", "&apos;",
+                "&#65;", "&#x20AC;", "&#x1F600;", "&#10;", "&#13;", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "]", "]]", ">", "'", "\""
+            };
+            std::string result;
+            int count = std::uniform_int_distribution<int>(0, 6)(generator);
+            for (int i = 0; i < count; ++i) {
+                const std::string& piece = pick(pieces, generator);
+                if (inAttribute && (piece == "'" || piece == "\"")) {
+                    continue;
+                }
+                // Avoid ']]>', also when texts are adjacent
+                if (!inAttribute && piece == ">" && (result.empty() || result.back() == ']')) {
+                    continue;
+                }
+                result += piece;
+            }
+            return result;
+        }
+
+        static void generateElement(std::mt19937& generator, bool usePrefixes, int depth, std::string& result) {
+            static const std::vector<std::string> names = {"a", "message", "body", "x", "stream:stream", "p:item", "q:item"};
+            static const std::vector<std::string> attributeNames = {"to", "from", "type", "xml:lang", "p:id", "q:id"};
+            static const std::vector<std::string> namespaces = {"jabber:client", "urn:a", "urn:b", "http://etherx.jabber.org/streams"};
+
+            std::string name;
+            do {
+                name = pick(names, generator);
+            } while (!usePrefixes && name.find(':') != std::string::npos);
+            std::string tag = "<" + name;
+            if (usePrefixes && depth == 0) {
+                tag += " xmlns:stream='http://etherx.jabber.org/streams' xmlns:p='urn:p' xmlns:q='urn:q'";
+            }
+            if (generator() % 3 == 0) {
+                tag += " xmlns='" + pick(namespaces, generator) + "'";
+            }
+            if (usePrefixes && depth > 0 && generator() % 4 == 0) {
+                tag += std::string(" xmlns:") + (generator() % 2 ? "p" : "q") + "='" + pick(namespaces, generator) + "'";
+            }
+            std::vector<std::string> used;
+            int attributeCount = std::uniform_int_distribution<int>(0, 3)(generator);
+            for (int i = 0; i < attributeCount; ++i) {
+                std::string attributeName = pick(attributeNames, generator);
+                if (!usePrefixes && attributeName.find(':') != std::string::npos) {
+                    continue;
+                }
+                if (std::find(used.begin(), used.end(), attributeName) != used.end() || (attributeName == "q:id" && std::find(used.begin(), used.end(), "p:id") != used.end()) || (attributeName == "p:id" && std::find(used.begin(), used.end(), "q:id") != used.end())) {
+                    continue;
+                }
+                used.push_back(attributeName);
+                std::string quote = generator() % 2 ? "'" : "\"";
+                tag += std::string(generator() % 4 == 0 ? "\n  " : " ") + attributeName + (generator() % 4 == 0 ? " = " : "=") + quote + generateText(generator, true) + quote;
+            }
+            result += tag;
+            if (depth >= 4 || generator() % 4 == 0) {
+                result += generator() % 2 ? "/>" : " />";
+                return;
+            }
+            result += ">";
+            int childCount = std::uniform_int_distribution<int>(0, 4)(generator);
+            for (int i = 0; i < childCount; ++i) {
+                switch (generator() % 5) {
+                    case 0: case 1: generateElement(generator, usePrefixes, depth + 1, result); break;
+                    case 2: result += generateText(generator, false); break;
+                    case 3: result += "<![CDATA[" + std::string(generator() % 2 ? "<x>&amp;]" : "\n]]") + "]]>"; break;
+                    case 4: result += generator() % 2 ? "<!-- comment - -->" : "<?pi data?>"; break;
+                }
+            }
+            result += "</" + name + (generator() % 4 == 0 ? " >" : ">");
+        }
+
+        static std::string generateDocument(std::mt19937& generator, bool usePrefixes) {
+            std::string result;
+            if (generator() % 2) {
+                result += "<?xml version='1.0' encoding='UTF-8'?>";
+            }
+            result += generator() % 2 ? "\n" : "";
+            generateElement(generator, usePrefixes, 0, result);
+            return result;
+        }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(NativeXMLParserTest);
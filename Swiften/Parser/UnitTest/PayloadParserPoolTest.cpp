@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Elements/Body.h>
+#include <Swiften/Parser/PayloadParserFactory.h>
+#include <Swiften/Parser/PayloadParserFactoryCollection.h>
+#include <Swiften/Parser/PayloadParserPool.h>
+#include <Swiften/Parser/PayloadParsers/BodyParser.h>
+#include <Swiften/Parser/UnknownPayloadParser.h>
+
+using namespace Swift;
+
+class PayloadParserPoolTest : public CppUnit::TestFixture
+{
+        CPPUNIT_TEST_SUITE(PayloadParserPoolTest);
+        CPPUNIT_TEST(testAcquire);
+        CPPUNIT_TEST(testAcquire_UnknownPayload);
+        CPPUNIT_TEST(testAcquire_AfterRelease);
+        CPPUNIT_TEST(testAcquire_AfterReleaseOfOtherFactory);
+        CPPUNIT_TEST(testAcquire_AfterReleaseOfNonResettableParser);
+        CPPUNIT_TEST(testRelease_ResetsParser);
+        CPPUNIT_TEST(testAcquire_AfterFactoryRemoved);
+        CPPUNIT_TEST(testAcquire_AfterFactoryRemovedWhileParsing);
+        CPPUNIT_TEST(testAcquire_AfterDefaultFactoryChanged);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void testAcquire() {
+            PayloadParserPool testling(&factories);
+            DummyFactory<BodyParser> factory;
+
+            std::unique_ptr<PayloadParser> parser = testling.acquire(&factory);
+
+            CPPUNIT_ASSERT(dynamic_cast<BodyParser*>(parser.get()));
+            CPPUNIT_ASSERT_EQUAL(1, factory.created);
+        }
+
+        void testAcquire_UnknownPayload() {
+            PayloadParserPool testling(&factories);
+
+            std::unique_ptr<PayloadParser> parser = testling.acquire(nullptr);
+
+            CPPUNIT_ASSERT(dynamic_cast<UnknownPayloadParser*>(parser.get()));
+        }
+
+        void testAcquire_AfterRelease() {
+            PayloadParserPool testling(&factories);
+            DummyFactory<BodyParser> factory;
+            std::unique_ptr<PayloadParser> parser = testling.acquire(&factory);
+            PayloadParser* released = parser.get();
+            testling.release(&factory, std::move(parser));
+
+            parser = testling.acquire(&factory);
+
+            CPPUNIT_ASSERT(parser.get() == released);
+            CPPUNIT_ASSERT_EQUAL(1, factory.created);
+        }
+
+        void testAcquire_AfterReleaseOfOtherFactory() {
+            PayloadParserPool testling(&factories);
+            DummyFactory<BodyParser> factory1;
+            DummyFactory<BodyParser> factory2;
+            testling.release(&factory1, testling.acquire(&factory1));
+
+            std::unique_ptr<PayloadParser> parser = testling.acquire(&factory2);
+
+            CPPUNIT_ASSERT(parser);
+            CPPUNIT_ASSERT_EQUAL(1, factory2.created);
+        }
+
+        void testAcquire_AfterReleaseOfNonResettableParser() {
+            PayloadParserPool testling(&factories);
+            DummyFactory<NonResettableParser> factory;
+            testling.release(&factory, testling.acquire(&factory));
+
+            std::unique_ptr<PayloadParser> parser = testling.acquire(&factory);
+
+            CPPUNIT_ASSERT(parser);
+            CPPUNIT_ASSERT_EQUAL(2, factory.created);
+        }
+
+        void testRelease_ResetsParser() {
+            PayloadParserPool testling(&factories);
+            DummyFactory<BodyParser> factory;
+            std::unique_ptr<PayloadParser> parser = testling.acquire(&factory);
+            parser->handleStartElement("body", "", AttributeMap());
+            parser->handleCharacterData("foo");
+            parser->handleEndElement("body", "");
+            std::shared_ptr<Body> firstBody = std::dynamic_pointer_cast<Body>(parser->getPayload());
+            testling.release(&factory, std::move(parser));
+
+            parser = testling.acquire(&factory);
+            parser->handleStartElement("body", "", AttributeMap());
+            parser->handleCharacterData("bar");
+            parser->handleEndElement("body", "");
+
+            std::shared_ptr<Body> secondBody = std::dynamic_pointer_cast<Body>(parser->getPayload());
+            CPPUNIT_ASSERT(firstBody != secondBody);
+            CPPUNIT_ASSERT_EQUAL(std::string("foo"), firstBody->getText());
+            CPPUNIT_ASSERT_EQUAL(std::string("bar"), secondBody->getText());
+        }
+
+        void testAcquire_AfterFactoryRemoved() {
+            PayloadParserPool testling(&factories);
+            DummyFactory<BodyParser> factory;
+            factories.addFactory(&factory);
+            testling.release(&factory, testling.acquire(&factory));
+            factories.removeFactory(&factory);
+
+            // A new factory at the same address must not get the old parser
+            std::unique_ptr<PayloadParser> parser = testling.acquire(&factory);
+
+            CPPUNIT_ASSERT(parser);
+            CPPUNIT_ASSERT_EQUAL(2, factory.created);
+        }
+
+        void testAcquire_AfterFactoryRemovedWhileParsing() {
+            PayloadParserPool testling(&factories);
+            DummyFactory<BodyParser> factory;
+            factories.addFactory(&factory);
+            std::unique_ptr<PayloadParser> parser = testling.acquire(&factory);
+            factories.removeFactory(&factory);
+            testling.release(&factory, std::move(parser));
+
+            parser = testling.acquire(&factory);
+
+            CPPUNIT_ASSERT(parser);
+            CPPUNIT_ASSERT_EQUAL(2, factory.created);
+        }
+
+        void testAcquire_AfterDefaultFactoryChanged() {
+            PayloadParserPool testling(&factories);
+            DummyFactory<BodyParser> factory;
+            factories.setDefaultFactory(&factory);
+            testling.release(&factory, testling.acquire(&factory));
+            factories.setDefaultFactory(nullptr);
+
+            std::unique_ptr<PayloadParser> parser = testling.acquire(&factory);
+
+            CPPUNIT_ASSERT(parser);
+            CPPUNIT_ASSERT_EQUAL(2, factory.created);
+        }
+
+    private:
+        struct NonResettableParser : public UnknownPayloadParser {
+            virtual bool reset() { return false; }
+        };
+
+        template<typename T>
+        struct DummyFactory : public PayloadParserFactory {
+            DummyFactory() : created(0) {}
+            virtual bool canParse(const std::string&, const std::string&, const AttributeMap&) const {
+                return true;
+            }
+            virtual PayloadParser* createPayloadParser() {
+                ++created;
+                return new T();
+            }
+            int created;
+        };
+
+    private:
+        PayloadParserFactoryCollection factories;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PayloadParserPoolTest);
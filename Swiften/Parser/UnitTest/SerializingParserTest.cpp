@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -18,6 +18,7 @@ class SerializingParserTest : public CppUnit::TestFixture
         CPPUNIT_TEST(testParse);
         CPPUNIT_TEST(testParse_Empty);
         CPPUNIT_TEST(testParse_ToplevelCharacterData);
+        CPPUNIT_TEST(testParse_NamespacedAttributes);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -59,6 +60,15 @@ class SerializingParserTest : public CppUnit::TestFixture
 
             CPPUNIT_ASSERT_EQUAL(std::string("<message/>"), testling.getResult());
         }
+
+        void testParse_NamespacedAttributes() {
+            SerializingParser testling;
+            ParserTester<SerializingParser> parser(&testling);
+
+            CPPUNIT_ASSERT(parser.parse("<a xmlns:p=\"urn:p\" p:x=\"1\" xml:lang=\"en\" y=\"2\"/>"));
+
+            CPPUNIT_ASSERT_EQUAL(std::string("<a ns0:x=\"1\" xml:lang=\"en\" xmlns:ns0=\"urn:p\" y=\"2\"/>"), testling.getResult());
+        }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SerializingParserTest);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,7 +8,9 @@
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
 #include <Swiften/Elements/Payload.h>
+#include <Swiften/Elements/RawXMLPayload.h>
 #include <Swiften/Elements/Stanza.h>
+#include <Swiften/Elements/UnparsedPayload.h>
 #include <Swiften/Parser/GenericPayloadParser.h>
 #include <Swiften/Parser/PayloadParserFactory.h>
 #include <Swiften/Parser/PayloadParserFactoryCollection.h>
@@ -23,6 +25,14 @@ class StanzaParserTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testHandleEndElement_StrayCharacterData);
         CPPUNIT_TEST(testHandleEndElement_UnknownPayload);
         CPPUNIT_TEST(testHandleParse_BasicAttributes);
+        CPPUNIT_TEST(testLazyPayloadParsing_ParsesOnLookup);
+        CPPUNIT_TEST(testLazyPayloadParsing_ParsesAllOnLookupOfAll);
+        CPPUNIT_TEST(testLazyPayloadParsing_GetPayloadsParsesAll);
+        CPPUNIT_TEST(testLazyPayloadParsing_CapturesXML);
+        CPPUNIT_TEST(testLazyPayloadParsing_UnknownPayload);
+        CPPUNIT_TEST(testLazyPayloadParsing_UpdatePayload);
+        CPPUNIT_TEST(testLazyPayloadParsing_KeepsStanzaNamespace);
+        CPPUNIT_TEST(testLazyPayloadParsing_FactoriesDestroyed);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -118,6 +128,178 @@ class StanzaParserTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(std::string("id-123"), testling.getStanza()->getID());
         }
 
+        void testLazyPayloadParsing_ParsesOnLookup() {
+            MyStanzaParser testling(factoryCollection_);
+            testling.setLazyPayloadParsing(true);
+
+            AttributeMap attributes;
+            testling.handleStartElement("mystanza", "", attributes);
+            testling.handleStartElement("mypayload1", "", attributes);
+            testling.handleStartElement("child", "", attributes);
+            testling.handleEndElement("child", "");
+            testling.handleEndElement("mypayload1", "");
+            testling.handleStartElement("mypayload2", "", attributes);
+            testling.handleEndElement("mypayload2", "");
+            testling.handleEndElement("mystanza", "");
+
+            std::shared_ptr<Stanza> stanza = testling.getStanza();
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), stanza->getStoredPayloads().size());
+            std::shared_ptr<UnparsedPayload> unparsedPayload1 = std::dynamic_pointer_cast<UnparsedPayload>(stanza->getStoredPayloads()[0]);
+            std::shared_ptr<UnparsedPayload> unparsedPayload2 = std::dynamic_pointer_cast<UnparsedPayload>(stanza->getStoredPayloads()[1]);
+            CPPUNIT_ASSERT(unparsedPayload1);
+            CPPUNIT_ASSERT(unparsedPayload2);
+
+            std::shared_ptr<MyPayload1> payload = stanza->getPayload<MyPayload1>();
+            CPPUNIT_ASSERT(payload);
+            CPPUNIT_ASSERT(payload->hasChild);
+            CPPUNIT_ASSERT(unparsedPayload1->isParsed());
+            CPPUNIT_ASSERT_EQUAL(std::static_pointer_cast<Payload>(payload), unparsedPayload1->getParsedPayload());
+            CPPUNIT_ASSERT(!unparsedPayload2->isParsed());
+        }
+
+        void testLazyPayloadParsing_GetPayloadsParsesAll() {
+            MyStanzaParser testling(factoryCollection_);
+            testling.setLazyPayloadParsing(true);
+
+            AttributeMap attributes;
+            testling.handleStartElement("mystanza", "", attributes);
+            testling.handleStartElement("mypayload1", "", attributes);
+            testling.handleEndElement("mypayload1", "");
+            testling.handleStartElement("mypayload2", "", attributes);
+            testling.handleEndElement("mypayload2", "");
+            testling.handleEndElement("mystanza", "");
+
+            std::vector<std::shared_ptr<Payload> > payloads = testling.getStanza()->getPayloads();
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), payloads.size());
+            CPPUNIT_ASSERT(std::dynamic_pointer_cast<MyPayload1>(payloads[0]));
+            CPPUNIT_ASSERT(std::dynamic_pointer_cast<MyPayload2>(payloads[1]));
+        }
+
+        void testLazyPayloadParsing_ParsesAllOnLookupOfAll() {
+            MyStanzaParser testling(factoryCollection_);
+            testling.setLazyPayloadParsing(true);
+
+            AttributeMap attributes;
+            testling.handleStartElement("mystanza", "", attributes);
+            testling.handleStartElement("mypayload1", "", attributes);
+            testling.handleEndElement("mypayload1", "");
+            testling.handleStartElement("mypayload1", "", attributes);
+            testling.handleEndElement("mypayload1", "");
+            testling.handleEndElement("mystanza", "");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), testling.getStanza()->getPayloads<MyPayload1>().size());
+            CPPUNIT_ASSERT(!testling.getStanza()->getPayload<UnparsedPayload>());
+        }
+
+        void testLazyPayloadParsing_CapturesXML() {
+            MyStanzaParser testling(factoryCollection_);
+            testling.setLazyPayloadParsing(true);
+
+            AttributeMap stanzaAttributes;
+            AttributeMap payloadAttributes;
+            payloadAttributes.addAttribute("foo", "", "a\"b&c\td");
+            payloadAttributes.addAttribute("lang", "http://www.w3.org/XML/1998/namespace", "en");
+            payloadAttributes.addAttribute("bar", "urn:other", "baz");
+            AttributeMap childAttributes;
+            testling.handleStartElement("mystanza", "jabber:client", stanzaAttributes);
+            testling.handleStartElement("mypayload1", "urn:payload", payloadAttributes);
+            testling.handleCharacterData("x < y & z\n");
+            testling.handleStartElement("child", "urn:payload", childAttributes);
+            testling.handleEndElement("child", "urn:payload");
+            testling.handleStartElement("other", "urn:other", childAttributes);
+            testling.handleCharacterData("text");
+            testling.handleEndElement("other", "urn:other");
+            testling.handleEndElement("mypayload1", "urn:payload");
+            testling.handleStartElement("mypayload2", "jabber:client", childAttributes);
+            testling.handleStartElement("child", "jabber:client", childAttributes);
+            testling.handleEndElement("child", "jabber:client");
+            testling.handleEndElement("mypayload2", "jabber:client");
+            testling.handleEndElement("mystanza", "jabber:client");
+
+            std::shared_ptr<UnparsedPayload> payload = testling.getStanza()->getPayload<UnparsedPayload>();
+            CPPUNIT_ASSERT(payload);
+            CPPUNIT_ASSERT_EQUAL(std::string(
+                "<mypayload1 xmlns=\"urn:payload\" foo=\"a&quot;b&amp;c\td\" xml:lang=\"en\" xmlns:ns0=\"urn:other\" ns0:bar=\"baz\">"
+                    "x &lt; y &amp; z\n"
+                    "<child/>"
+                    "<other xmlns=\"urn:other\">text</other>"
+                "</mypayload1>"), payload->getRawXML());
+            payload = std::dynamic_pointer_cast<UnparsedPayload>(testling.getStanza()->getStoredPayloads()[1]);
+            CPPUNIT_ASSERT(payload);
+            CPPUNIT_ASSERT_EQUAL(std::string("<mypayload2><child/></mypayload2>"), payload->getRawXML());
+        }
+
+        void testLazyPayloadParsing_UnknownPayload() {
+            MyStanzaParser testling(factoryCollection_);
+            testling.setLazyPayloadParsing(true);
+
+            AttributeMap attributes;
+            testling.handleStartElement("mystanza", "", attributes);
+            testling.handleStartElement("unknown-payload", "", attributes);
+            testling.handleStartElement("unknown-payload-child", "", attributes);
+            testling.handleEndElement("unknown-payload-child", "");
+            testling.handleEndElement("unknown-payload", "");
+            testling.handleStartElement("mypayload2", "", attributes);
+            testling.handleEndElement("mypayload2", "");
+            testling.handleEndElement("mystanza", "");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getStanza()->getPayloads().size());
+            CPPUNIT_ASSERT(testling.getStanza()->getPayload<MyPayload2>());
+        }
+
+        void testLazyPayloadParsing_UpdatePayload() {
+            MyStanzaParser testling(factoryCollection_);
+            testling.setLazyPayloadParsing(true);
+
+            AttributeMap attributes;
+            testling.handleStartElement("mystanza", "", attributes);
+            testling.handleStartElement("mypayload2", "", attributes);
+            testling.handleEndElement("mypayload2", "");
+            testling.handleEndElement("mystanza", "");
+
+            std::shared_ptr<MyPayload2> payload = std::make_shared<MyPayload2>();
+            testling.getStanza()->updatePayload(payload);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getStanza()->getPayloads().size());
+            CPPUNIT_ASSERT_EQUAL(payload, testling.getStanza()->getPayload<MyPayload2>());
+        }
+
+        void testLazyPayloadParsing_KeepsStanzaNamespace() {
+            MyStanzaParser testling(factoryCollection_);
+            testling.setLazyPayloadParsing(true);
+
+            AttributeMap attributes;
+            testling.handleStartElement("mystanza", "jabber:client", attributes);
+            testling.handleStartElement("mypayload2", "jabber:client", attributes);
+            testling.handleEndElement("mypayload2", "jabber:client");
+            testling.handleEndElement("mystanza", "jabber:client");
+
+            std::shared_ptr<MyPayload2> payload = testling.getStanza()->getPayload<MyPayload2>();
+            CPPUNIT_ASSERT(payload);
+            CPPUNIT_ASSERT_EQUAL(std::string("jabber:client"), payload->ns);
+        }
+
+        void testLazyPayloadParsing_FactoriesDestroyed() {
+            std::unique_ptr<PayloadParserFactoryCollection> factories(new PayloadParserFactoryCollection());
+            factories->addFactory(&factory1_);
+            MyStanzaParser testling(factories.get());
+            testling.setLazyPayloadParsing(true);
+
+            AttributeMap attributes;
+            testling.handleStartElement("mystanza", "", attributes);
+            testling.handleStartElement("mypayload1", "", attributes);
+            testling.handleEndElement("mypayload1", "");
+            testling.handleEndElement("mystanza", "");
+            std::shared_ptr<Stanza> stanza = testling.getStanza();
+            factories.reset();
+
+            CPPUNIT_ASSERT(!stanza->getPayload<MyPayload1>());
+            std::shared_ptr<RawXMLPayload> payload = stanza->getPayload<RawXMLPayload>();
+            CPPUNIT_ASSERT(payload);
+            CPPUNIT_ASSERT(!std::dynamic_pointer_cast<UnparsedPayload>(payload));
+            CPPUNIT_ASSERT_EQUAL(std::string("<mypayload1/>"), payload->getRawXML());
+        }
+
     private:
         class MyPayload1 : public Payload
         {
@@ -158,6 +340,8 @@ class StanzaParserTest : public CppUnit::TestFixture {
         {
             public:
                 MyPayload2() {}
+
+                std::string ns;
         };
 
         class MyPayload2Parser : public GenericPayloadParser<MyPayload2>
@@ -165,7 +349,11 @@ class StanzaParserTest : public CppUnit::TestFixture {
             public:
                 MyPayload2Parser() {}
 
-            virtual void handleStartElement(const std::string&, const std::string&, const AttributeMap&) {}
+            virtual void handleStartElement(const std::string& element, const std::string& ns, const AttributeMap&) {
+                if (element == "mypayload2") {
+                    getPayloadInternal()->ns = ns;
+                }
+            }
             virtual void handleEndElement(const std::string&, const std::string&) {}
             virtual void handleCharacterData(const std::string&) {}
         };
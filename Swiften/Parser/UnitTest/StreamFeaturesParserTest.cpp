@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -40,6 +40,7 @@ class StreamFeaturesParserTest : public CppUnit::TestFixture {
                     "<sm xmlns='urn:xmpp:sm:2'/>"
                     "<session xmlns=\"urn:ietf:params:xml:ns:xmpp-session\"/>"
                     "<ver xmlns=\"urn:xmpp:features:rosterver\"/>"
+                    "<csi xmlns=\"urn:xmpp:csi:0\"/>"
                 "</stream:features>"));
 
             StreamFeatures::ref element = std::dynamic_pointer_cast<StreamFeatures>(testling.getElement());
@@ -54,6 +55,7 @@ class StreamFeaturesParserTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(!element->getAuthenticationHostname());
             CPPUNIT_ASSERT(element->hasStreamManagement());
             CPPUNIT_ASSERT(element->hasRosterVersioning());
+            CPPUNIT_ASSERT(element->hasClientStateIndication());
         }
 
         void testParse_Empty() {
@@ -67,6 +69,7 @@ class StreamFeaturesParserTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(!element->hasSession());
             CPPUNIT_ASSERT(!element->hasResourceBind());
             CPPUNIT_ASSERT(!element->hasAuthenticationMechanisms());
+            CPPUNIT_ASSERT(!element->hasClientStateIndication());
         }
 
         void testParse_AuthenticationHostname() {
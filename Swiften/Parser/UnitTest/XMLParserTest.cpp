@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include <string>
+#include <Swiften/Parser/NativeXMLParser.h>
 #include <Swiften/Parser/XMLParserClient.h>
 #ifdef HAVE_EXPAT
 #include <Swiften/Parser/ExpatParser.h>
@@ -354,6 +355,7 @@ class XMLParserTest : public CppUnit::TestFixture {
         } client_;
 };
 
+CPPUNIT_TEST_SUITE_REGISTRATION(XMLParserTest<NativeXMLParser>);
 #ifdef HAVE_EXPAT
 CPPUNIT_TEST_SUITE_REGISTRATION(XMLParserTest<ExpatParser>);
 #endif
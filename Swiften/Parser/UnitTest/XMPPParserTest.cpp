@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -10,15 +10,23 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
+#include <Swiften/Elements/Body.h>
 #include <Swiften/Elements/IQ.h>
 #include <Swiften/Elements/Message.h>
 #include <Swiften/Elements/Presence.h>
 #include <Swiften/Elements/ProtocolHeader.h>
+#include <Swiften/Elements/RawXMLPayload.h>
 #include <Swiften/Elements/StreamFeatures.h>
 #include <Swiften/Elements/UnknownElement.h>
+#include <Swiften/Elements/UnparsedPayload.h>
 #include <Swiften/Parser/ElementParser.h>
+#include <Swiften/Parser/NativeXMLParser.h>
+#include <Swiften/Parser/PayloadParserFactory.h>
 #include <Swiften/Parser/PayloadParserFactoryCollection.h>
+#include <Swiften/Parser/PayloadParsers/BodyParser.h>
+#include <Swiften/Parser/PayloadParsers/FullPayloadParserFactoryCollection.h>
 #include <Swiften/Parser/PlatformXMLParserFactory.h>
+#include <Swiften/Parser/XMLParserFactory.h>
 #include <Swiften/Parser/XMPPParser.h>
 #include <Swiften/Parser/XMPPParserClient.h>
 
@@ -31,6 +39,10 @@ class XMPPParserTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testParse_Presence);
         CPPUNIT_TEST(testParse_IQ);
         CPPUNIT_TEST(testParse_Message);
+        CPPUNIT_TEST(testParse_ConsecutiveMessages);
+        CPPUNIT_TEST(testParse_ReusesPayloadParsers);
+        CPPUNIT_TEST(testParse_RawXMLPayloadIsCapturedVerbatim);
+        CPPUNIT_TEST(testParse_LazyPayloadIsCapturedVerbatim);
         CPPUNIT_TEST(testParse_StreamFeatures);
         CPPUNIT_TEST(testParse_UnknownElement);
         CPPUNIT_TEST(testParse_StrayCharacterData);
@@ -104,6 +116,77 @@ class XMPPParserTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(dynamic_cast<Message*>(client_.events[1].element.get()));
         }
 
+        void testParse_ConsecutiveMessages() {
+            FullPayloadParserFactoryCollection factories;
+            XMPPParser testling(&client_, &factories, &xmlParserFactory_);
+
+            CPPUNIT_ASSERT(testling.parse("<stream:stream xmlns:stream='http://etherx.jabber.org/streams'>"));
+            CPPUNIT_ASSERT(testling.parse("<message from='alice@wonderland.lit' type='headline'><body>foo</body></message>"));
+            CPPUNIT_ASSERT(testling.parse("<message><body>bar</body><subject>baz</subject></message>"));
+
+            CPPUNIT_ASSERT_EQUAL(3, static_cast<int>(client_.events.size()));
+            Message::ref message1 = std::dynamic_pointer_cast<Message>(client_.events[1].element);
+            Message::ref message2 = std::dynamic_pointer_cast<Message>(client_.events[2].element);
+            CPPUNIT_ASSERT(message1 && message2 && message1 != message2);
+            CPPUNIT_ASSERT_EQUAL(JID("alice@wonderland.lit"), message1->getFrom());
+            CPPUNIT_ASSERT_EQUAL(Message::Headline, message1->getType());
+            CPPUNIT_ASSERT_EQUAL(std::string("foo"), message1->getBody().get_value_or(""));
+            CPPUNIT_ASSERT(!message1->getSubject().size());
+            CPPUNIT_ASSERT(!message2->getFrom().isValid());
+            CPPUNIT_ASSERT_EQUAL(Message::Chat, message2->getType());
+            CPPUNIT_ASSERT_EQUAL(std::string("bar"), message2->getBody().get_value_or(""));
+            CPPUNIT_ASSERT_EQUAL(std::string("baz"), message2->getSubject());
+        }
+
+        void testParse_ReusesPayloadParsers() {
+            BodyParserFactory factory;
+            factories_.addFactory(&factory);
+            XMPPParser testling(&client_, &factories_, &xmlParserFactory_);
+
+            CPPUNIT_ASSERT(testling.parse("<stream:stream xmlns:stream='http://etherx.jabber.org/streams'>"));
+            CPPUNIT_ASSERT(testling.parse("<message><body>foo</body></message>"));
+            CPPUNIT_ASSERT(testling.parse("<presence><body>bar</body></presence>"));
+            CPPUNIT_ASSERT(testling.parse("<message><body>baz</body></message>"));
+            factories_.removeFactory(&factory);
+
+            CPPUNIT_ASSERT_EQUAL(1, factory.created);
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(client_.events.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("baz"), std::dynamic_pointer_cast<Message>(client_.events[3].element)->getBody().get_value_or(""));
+        }
+
+        void testParse_RawXMLPayloadIsCapturedVerbatim() {
+            FullPayloadParserFactoryCollection factories;
+            NativeXMLParserFactory xmlParserFactory;
+            XMPPParser testling(&client_, &factories, &xmlParserFactory);
+
+            CPPUNIT_ASSERT(testling.parse("<stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams' xmlns:x='urn:x'>"));
+            CPPUNIT_ASSERT(testling.parse("<message><foo xmlns='urn:foo' b='1'  a=\"&lt;2\"><x:bar/>baz</foo></message>"));
+
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(client_.events.size()));
+            std::shared_ptr<RawXMLPayload> payload = std::dynamic_pointer_cast<Message>(client_.events[1].element)->getPayload<RawXMLPayload>();
+            CPPUNIT_ASSERT(payload);
+            CPPUNIT_ASSERT_EQUAL(std::string("<foo xmlns:x=\"urn:x\" xmlns='urn:foo' b='1'  a=\"&lt;2\"><x:bar/>baz</foo>"), payload->getRawXML());
+        }
+
+        void testParse_LazyPayloadIsCapturedVerbatim() {
+            BodyParserFactory factory;
+            factories_.addFactory(&factory);
+            NativeXMLParserFactory xmlParserFactory;
+            XMPPParser testling(&client_, &factories_, &xmlParserFactory);
+            testling.setLazyPayloadParsing(true);
+
+            CPPUNIT_ASSERT(testling.parse("<stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams'>"));
+            CPPUNIT_ASSERT(testling.parse("<message><body >a &amp; <![CDATA[b]]></body></message>"));
+
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(client_.events.size()));
+            std::shared_ptr<Message> message = std::dynamic_pointer_cast<Message>(client_.events[1].element);
+            std::shared_ptr<UnparsedPayload> unparsedPayload = message->getPayload<UnparsedPayload>();
+            CPPUNIT_ASSERT(unparsedPayload);
+            CPPUNIT_ASSERT_EQUAL(std::string("<body >a &amp; <![CDATA[b]]></body>"), unparsedPayload->getRawXML());
+            CPPUNIT_ASSERT_EQUAL(std::string("a & b"), message->getBody().get_value_or(""));
+            factories_.removeFactory(&factory);
+        }
+
         void testParse_StreamFeatures() {
             XMPPParser testling(&client_, &factories_, &xmlParserFactory_);
 
@@ -190,6 +273,24 @@ class XMPPParserTest : public CppUnit::TestFixture {
 
                 std::vector<Event> events;
         } client_;
+        struct BodyParserFactory : public PayloadParserFactory {
+            BodyParserFactory() : created(0) {}
+            virtual bool canParse(const std::string& element, const std::string&, const AttributeMap&) const {
+                return element == "body";
+            }
+            virtual PayloadParser* createPayloadParser() {
+                ++created;
+                return new BodyParser();
+            }
+            int created;
+        };
+
+        struct NativeXMLParserFactory : public XMLParserFactory {
+            virtual std::unique_ptr<XMLParser> createXMLParser(XMLParserClient* client) {
+                return std::unique_ptr<XMLParser>(new NativeXMLParser(client));
+            }
+        };
+
         PayloadParserFactoryCollection factories_;
         PlatformXMLParserFactory xmlParserFactory_;
 };
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -23,5 +23,9 @@ namespace Swift {
             virtual std::shared_ptr<Payload> getPayload() const {
                 return std::shared_ptr<Payload>();
             }
+
+            virtual bool reset() {
+                return true;
+            }
     };
 }
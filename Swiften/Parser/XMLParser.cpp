@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -14,4 +14,13 @@ XMLParser::XMLParser(XMLParserClient* client) : client_(client) {
 XMLParser::~XMLParser() {
 }
 
+bool XMLParser::startCapture(const std::string&) {
+    return false;
+}
+
+const std::string& XMLParser::getCapturedXML() const {
+    static const std::string empty;
+    return empty;
+}
+
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -20,6 +20,29 @@ namespace Swift {
 
             virtual bool parse(const std::string& data) = 0;
 
+            /**
+             * Starts copying the input verbatim, from the start tag that is
+             * being reported to XMLParserClient::handleStartElement up to
+             * and including its end tag. The copy can be retrieved with
+             * getCapturedXML() once the end tag is reported.
+             *
+             * Prefixes that the copied element uses but that are declared
+             * outside it are declared on its start tag. The inherited
+             * default namespace is declared as well, unless it is
+             * \p contextNamespace, i.e. the namespace of the element the copy
+             * will be inserted in.
+             *
+             * Returns false if the parser cannot copy its input (the
+             * default), in which case the XML has to be rebuilt from the
+             * parser events.
+             */
+            virtual bool startCapture(const std::string& contextNamespace);
+
+            /**
+             * Returns the XML copied since the last call to startCapture().
+             */
+            virtual const std::string& getCapturedXML() const;
+
             XMLParserClient* getClient() const {
                 return client_;
             }
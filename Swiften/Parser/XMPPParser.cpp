@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -23,6 +23,7 @@
 #include <Swiften/Parser/EnableStreamManagementParser.h>
 #include <Swiften/Parser/IQParser.h>
 #include <Swiften/Parser/MessageParser.h>
+#include <Swiften/Parser/PayloadParserPool.h>
 #include <Swiften/Parser/PresenceParser.h>
 #include <Swiften/Parser/StanzaAckParser.h>
 #include <Swiften/Parser/StanzaAckRequestParser.h>
@@ -54,12 +55,16 @@ XMPPParser::XMPPParser(
                 payloadParserFactories_(payloadParserFactories),
                 level_(0),
                 currentElementParser_(nullptr),
-                parseErrorOccurred_(false) {
+                parseErrorOccurred_(false),
+                lazyPayloadParsing_(false),
+                payloadParserPool_(new PayloadParserPool(payloadParserFactories)) {
     xmlParser_ = xmlParserFactory->createXMLParser(this);
 }
 
 XMPPParser::~XMPPParser() {
-    delete currentElementParser_;
+    if (currentElementParser_) {
+        releaseElementParser();
+    }
 }
 
 bool XMPPParser::parse(const std::string& data) {
@@ -106,8 +111,7 @@ void XMPPParser::handleEndElement(const std::string& element, const std::string&
             currentElementParser_->handleEndElement(element, ns);
             if (level_ == StreamLevel) {
                 client_->handleElement(currentElementParser_->getElement());
-                delete currentElementParser_;
-                currentElementParser_ = nullptr;
+                releaseElementParser();
             }
         }
     }
@@ -124,15 +128,36 @@ void XMPPParser::handleCharacterData(const std::string& data) {
     }
 }
 
+template<typename T>
+StanzaParser* XMPPParser::getStanzaParser(std::unique_ptr<T>& parser) {
+    if (!parser) {
+        parser = std::unique_ptr<T>(new T(payloadParserFactories_));
+        parser->setPayloadParserPool(payloadParserPool_.get());
+        parser->setXMLParser(xmlParser_.get());
+    }
+    parser->setLazyPayloadParsing(lazyPayloadParsing_);
+    return parser.get();
+}
+
+void XMPPParser::releaseElementParser() {
+    if (currentElementParser_ == presenceParser_.get() || currentElementParser_ == iqParser_.get() || currentElementParser_ == messageParser_.get()) {
+        static_cast<StanzaParser*>(currentElementParser_)->reset();
+    }
+    else {
+        delete currentElementParser_;
+    }
+    currentElementParser_ = nullptr;
+}
+
 ElementParser* XMPPParser::createElementParser(const std::string& element, const std::string& ns) {
     if (element == "presence") {
-        return new PresenceParser(payloadParserFactories_);
+        return getStanzaParser(presenceParser_);
     }
     else if (element == "iq") {
-        return new IQParser(payloadParserFactories_);
+        return getStanzaParser(iqParser_);
     }
     else if (element == "message") {
-        return new MessageParser(payloadParserFactories_);
+        return getStanzaParser(messageParser_);
     }
     else if (element == "features"  && ns == "http://etherx.jabber.org/streams") {
         return new StreamFeaturesParser();
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -19,7 +19,12 @@ namespace Swift {
     class XMPPParserClient;
     class XMLParserFactory;
     class ElementParser;
+    class IQParser;
+    class MessageParser;
     class PayloadParserFactoryCollection;
+    class PayloadParserPool;
+    class PresenceParser;
+    class StanzaParser;
 
     class SWIFTEN_API XMPPParser : public XMLParserClient, boost::noncopyable {
         public:
@@ -31,6 +36,16 @@ namespace Swift {
 
             bool parse(const std::string&);
 
+            /**
+             * Sets whether the parsing of stanza payloads is deferred until
+             * they are looked up.
+             *
+             * \see StanzaParser::setLazyPayloadParsing
+             */
+            void setLazyPayloadParsing(bool lazy) {
+                lazyPayloadParsing_ = lazy;
+            }
+
         private:
             virtual void handleStartElement(
                     const std::string& element,
@@ -40,6 +55,8 @@ namespace Swift {
             virtual void handleCharacterData(const std::string& data);
 
             ElementParser* createElementParser(const std::string& element, const std::string& xmlns);
+            template<typename T> StanzaParser* getStanzaParser(std::unique_ptr<T>& parser);
+            void releaseElementParser();
 
         private:
             std::unique_ptr<XMLParser> xmlParser_;
@@ -53,5 +70,15 @@ namespace Swift {
             int level_;
             ElementParser* currentElementParser_;
             bool parseErrorOccurred_;
+            bool lazyPayloadParsing_;
+            // Stanza and payload parsers are reset and reused for the next
+            // stanzas, so that no parsers are allocated once every kind of
+            // stanza and payload has been seen. This only covers the
+            // parsers: the parsed stanzas and payloads, their strings and
+            // attribute maps are still allocated for every stanza.
+            std::unique_ptr<PayloadParserPool> payloadParserPool_;
+            std::unique_ptr<PresenceParser> presenceParser_;
+            std::unique_ptr<IQParser> iqParser_;
+            std::unique_ptr<MessageParser> messageParser_;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -29,7 +29,7 @@ PresenceOracle::~PresenceOracle() {
 }
 
 void PresenceOracle::handleStanzaChannelAvailableChanged(bool available) {
-    if (available) {
+    if (available && !stanzaChannel_->isStreamResumed()) {
         entries_.clear();
     }
 }
@@ -47,7 +47,8 @@ void PresenceOracle::handleIncomingPresence(Presence::ref presence) {
             passedPresence->setFrom(bareJID);
             passedPresence->setStatus(presence->getStatus());
         }
-        PresenceMap jidMap = entries_[bareJID];
+        // All occupants of a MUC share the same bare JID, so update their map in place rather than copying it
+        PresenceMap& jidMap = entries_[bareJID];
         if (passedPresence->getFrom().isBare() && presence->getType() == Presence::Unavailable) {
             /* Have a bare-JID only presence of offline */
             jidMap.clear();
@@ -60,7 +61,6 @@ void PresenceOracle::handleIncomingPresence(Presence::ref presence) {
         } else {
             jidMap[passedPresence->getFrom()] = passedPresence;
         }
-        entries_[bareJID] = jidMap;
         onPresenceChange(passedPresence);
     }
 }
@@ -84,7 +84,7 @@ Presence::ref PresenceOracle::getLastPresence(const JID& jid) const {
     if (i == entries_.end()) {
         return Presence::ref();
     }
-    PresenceMap presenceMap = i->second;
+    const PresenceMap& presenceMap = i->second;
     PresenceMap::const_iterator j = presenceMap.find(jid);
     if (j != presenceMap.end()) {
         return j->second;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -25,6 +25,7 @@ class PresenceOracleTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testReceivePresenceFromDifferentResources);
         CPPUNIT_TEST(testSubscriptionRequest);
         CPPUNIT_TEST(testReconnectResetsPresences);
+        CPPUNIT_TEST(testResumeKeepsPresences);
         CPPUNIT_TEST(testHighestPresenceSingle);
         CPPUNIT_TEST(testHighestPresenceMultiple);
         CPPUNIT_TEST(testHighestPresenceGlobal);
@@ -154,6 +155,16 @@ class PresenceOracleTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(!oracle_->getLastPresence(user1));
         }
 
+        void testResumeKeepsPresences() {
+            std::shared_ptr<Presence> sentPresence(createPresence(user1));
+            stanzaChannel_->onPresenceReceived(sentPresence);
+            stanzaChannel_->setAvailable(false);
+            stanzaChannel_->streamResumed_ = true;
+            stanzaChannel_->setAvailable(true);
+
+            CPPUNIT_ASSERT_EQUAL(sentPresence, oracle_->getLastPresence(user1));
+        }
+
         void testGetActivePresence() {
             {
                 std::vector<Presence::ref> presenceList;
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures the throughput of scanning text for non-ASCII bytes and for XML
+ * special characters with each ByteScan implementation the CPU supports,
+ * and of UTF-8 validation and XML escaping built on it. For comparison, the
+ * byte-at-a-time UTF-8 validator and the replaceAll based escaping that were
+ * used before are measured as well.
+ *
+ * Usage: ByteScanBenchmark [text-size [iterations]]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <Swiften/Base/ByteScan.h>
+#include <Swiften/Base/String.h>
+#include <Swiften/IDN/UTF8Validator.h>
+#include <Swiften/Serializer/XML/XMLEscape.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static const char* implementationNames[] = { "Scalar", "SSE2", "AVX2", "NEON" };
+
+// Message text, with a non-ASCII character or an XML special character
+// every few hundred bytes
+static std::string createText(size_t size, bool nonASCII) {
+    std::mt19937 random(42);
+    std::string text;
+    while (text.size() < size) {
+        size_t run = 100 + random() % 400;
+        for (size_t i = 0; i < run; ++i) {
+            text += static_cast<char>('a' + random() % 26);
+        }
+        text += nonASCII ? "\xc3\xa9" : (random() % 2 ? "&" : "<");
+    }
+    text.resize(size);
+    return text;
+}
+
+static bool isValidByteAtATime(const unsigned char* data, size_t length) {
+    const unsigned char* current = data;
+    const unsigned char* end = data + length;
+    while (current < end) {
+        size_t sequenceLength = 0;
+        if ((*current & 0x80) == 0x0) {
+            sequenceLength = 1;
+        }
+        else if ((*current & 0xE0) == 0xC0) {
+            sequenceLength = 2;
+        }
+        else if ((*current & 0xF0) == 0xE0) {
+            sequenceLength = 3;
+        }
+        else if ((*current & 0xF8) == 0xF0) {
+            sequenceLength = 4;
+        }
+        if (sequenceLength == 0 || static_cast<size_t>(end - current) < sequenceLength) {
+            return false;
+        }
+        for (size_t i = 1; i < sequenceLength; ++i) {
+            if ((current[i] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        current += sequenceLength;
+    }
+    return true;
+}
+
+static std::string escapeWithReplaceAll(const std::string& text) {
+    std::string result(text);
+    String::replaceAll(result, '&', "&amp;");
+    String::replaceAll(result, '<', "&lt;");
+    String::replaceAll(result, '>', "&gt;");
+    return result;
+}
+
+// Hides the data from the optimizer, so that scanning it is not moved out of
+// the measurement loop
+static const unsigned char* opaque(const std::string& s) {
+    static const unsigned char* volatile data;
+    data = reinterpret_cast<const unsigned char*>(s.data());
+    return data;
+}
+
+template<typename Function>
+static void measure(const std::string& name, size_t bytes, int iterations, Function function) {
+    size_t result = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        result += function();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(10) << (static_cast<double>(bytes) * iterations / seconds / 1e9) << " GB/s"
+        << "    (" << result / static_cast<size_t>(iterations) << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t size = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 1024 * 1024;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    std::string ascii(size, 'a');
+    std::string utf8 = createText(size, true);
+    std::string xml = createText(size, false);
+
+    std::cout << "Scanning " << size << " bytes" << std::endl;
+    for (auto implementation : ByteScan::getSupportedImplementations()) {
+        std::string name = implementationNames[implementation];
+        measure("findFirst NonASCII, " + name, size, iterations, [&]() {
+            return ByteScan::findFirst(opaque(ascii), size, ByteScan::NonASCII, implementation);
+        });
+        measure("findFirst XMLTextSpecial, " + name, size, iterations, [&]() {
+            return ByteScan::findFirst(opaque(ascii), size, ByteScan::XMLTextSpecial, implementation);
+        });
+    }
+
+    measure("UTF8IsValid ASCII, byte at a time", size, iterations, [&]() {
+        return isValidByteAtATime(opaque(ascii), size);
+    });
+    measure("UTF8IsValid ASCII", size, iterations, [&]() {
+        return UTF8IsValid(opaque(ascii), size);
+    });
+    measure("UTF8IsValid text, byte at a time", size, iterations, [&]() {
+        return isValidByteAtATime(opaque(utf8), size);
+    });
+    measure("UTF8IsValid text", size, iterations, [&]() {
+        return UTF8IsValid(opaque(utf8), size);
+    });
+
+    measure("escape text, replaceAll", size, iterations / 10 + 1, [&]() {
+        return escapeWithReplaceAll(xml).size();
+    });
+    measure("escape text, XMLEscape", size, iterations / 10 + 1, [&]() {
+        return XMLEscape::escapeText(xml).size();
+    });
+    return 0;
+}
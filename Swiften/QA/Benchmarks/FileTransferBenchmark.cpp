@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures how long the event loop is blocked while receiving a large file
+ * through FileWriteBytestream (the close column is the time until the file
+ * is closed, not blocked time), and the throughput of the hash algorithms
+ * used to verify transferred files.
+ *
+ * Usage: FileTransferBenchmark [directory [size-in-MB [chunk-size]]]
+ *
+ * Point the directory at a slow device (e.g. a network share or a dm-delay
+ * target) to benchmark a slow disk; the 'sync every block' runs simulate one
+ * on a fast disk by forcing every block to be flushed to disk.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+
+#include <Swiften/Crypto/CryptoProvider.h>
+#include <Swiften/Crypto/Hash.h>
+#include <Swiften/Crypto/PlatformCryptoProvider.h>
+#include <Swiften/EventLoop/DummyEventLoop.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
+#include <Swiften/FileTransfer/FileWriteBytestream.h>
+#include <Swiften/FileTransfer/IncrementalBytestreamHashCalculator.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static double toMilliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+static void handleClosed(bool error, bool* closed) {
+    if (error) {
+        std::cerr << "close failed" << std::endl;
+    }
+    *closed = true;
+}
+
+static void benchmarkReceive(const std::string& name, const boost::filesystem::path& directory, boost::uintmax_t fileSize, size_t chunkSize, FileIOWorker::ref worker, DummyEventLoop* eventLoop, FileWriteBytestream::SyncPolicy syncPolicy) {
+    boost::filesystem::path file = directory / boost::filesystem::unique_path("file_transfer_benchmark_%%%%%%%%.bin");
+    std::shared_ptr<FileWriteBytestream> bytestream = worker ? std::make_shared<FileWriteBytestream>(file, worker) : std::make_shared<FileWriteBytestream>(file);
+    bytestream->setExpectedSize(fileSize);
+    bytestream->setSyncPolicy(syncPolicy);
+
+    std::vector<unsigned char> chunk(chunkSize);
+    for (size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = static_cast<unsigned char>(i);
+    }
+
+    Clock::duration blocked = Clock::duration::zero();
+    Clock::duration maxBlocked = Clock::duration::zero();
+    Clock::time_point start = Clock::now();
+    for (boost::uintmax_t written = 0; written < fileSize; written += chunkSize) {
+        // Hold back while the disk is behind, as the transports do
+        while (!bytestream->isWritable()) {
+            std::this_thread::yield();
+            eventLoop->processEvents();
+        }
+        Clock::time_point writeStart = Clock::now();
+        if (!bytestream->write(chunk)) {
+            std::cerr << name << ": write failed" << std::endl;
+            break;
+        }
+        Clock::duration writeTime = Clock::now() - writeStart;
+        blocked += writeTime;
+        maxBlocked = std::max(maxBlocked, writeTime);
+    }
+    bool closed = false;
+    bytestream->onClosed.connect(boost::bind(&handleClosed, _1, &closed));
+    Clock::time_point closeStart = Clock::now();
+    bytestream->close();
+    while (!closed) {
+        std::this_thread::yield();
+        eventLoop->processEvents();
+    }
+    Clock::time_point end = Clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+        << std::setw(10) << (static_cast<double>(fileSize) / (1024*1024)) / seconds << " MB/s"
+        << std::setw(12) << toMilliseconds(blocked) << " ms"
+        << std::setw(10) << toMilliseconds(maxBlocked) << " ms"
+        << std::setw(10) << toMilliseconds(end - closeStart) << " ms" << std::endl;
+
+    boost::filesystem::remove(file);
+}
+
+static void printHashThroughput(const std::string& name, boost::uintmax_t size, Clock::duration blocked, Clock::duration total) {
+    double seconds = std::chrono::duration<double>(total).count();
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(10) << (static_cast<double>(size) / (1024*1024*1024)) / seconds << " GB/s"
+        << std::setw(12) << std::setprecision(1) << toMilliseconds(blocked) << " ms" << std::endl;
+}
+
+static void benchmarkHash(const std::string& algorithm, CryptoProvider* crypto, boost::uintmax_t size, const ByteArray& chunk) {
+    std::shared_ptr<Hash> hash(crypto->createHash(algorithm));
+    if (!hash) {
+        std::cout << std::left << std::setw(36) << algorithm << "not supported" << std::endl;
+        return;
+    }
+    Clock::time_point start = Clock::now();
+    for (boost::uintmax_t hashed = 0; hashed < size; hashed += chunk.size()) {
+        hash->update(chunk);
+    }
+    hash->getHash();
+    Clock::duration total = Clock::now() - start;
+    printHashThroughput(algorithm, size, total, total);
+}
+
+static void benchmarkHashCalculator(const std::string& name, const std::vector<std::string>& algorithms, CryptoProvider* crypto, FileIOWorker::ref worker, DummyEventLoop* eventLoop, boost::uintmax_t size, const ByteArray& chunk) {
+    IncrementalBytestreamHashCalculator calculator(algorithms, crypto, worker);
+    Clock::duration blocked = Clock::duration::zero();
+    Clock::time_point start = Clock::now();
+    for (boost::uintmax_t hashed = 0; hashed < size; hashed += chunk.size()) {
+        // Hold back while the worker is behind, as the file transfers do
+        while (calculator.isBehind()) {
+            std::this_thread::yield();
+            eventLoop->processEvents();
+        }
+        Clock::time_point feedStart = Clock::now();
+        calculator.feedData(chunk);
+        blocked += Clock::now() - feedStart;
+    }
+    Clock::time_point finishStart = Clock::now();
+    calculator.finish();
+    blocked += Clock::now() - finishStart;
+    // Without a worker, the hashes are finished right away
+    while (!calculator.isFinished()) {
+        std::this_thread::yield();
+        eventLoop->processEvents();
+    }
+    printHashThroughput(name, size, blocked, Clock::now() - start);
+}
+
+int main(int argc, char* argv[]) {
+    boost::filesystem::path directory = argc > 1 ? boost::filesystem::path(argv[1]) : boost::filesystem::temp_directory_path();
+    boost::uintmax_t fileSize = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256) * 1024 * 1024;
+    size_t chunkSize = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 131072;
+
+    DummyEventLoop eventLoop;
+    FileIOWorker::ref worker = std::make_shared<FileIOWorker>(&eventLoop);
+
+    std::cout << "Receiving " << fileSize / (1024*1024) << " MB in chunks of " << chunkSize << " bytes into " << directory.string() << std::endl;
+    std::cout << std::left << std::setw(36) << "" << std::right
+        << std::setw(15) << "throughput"
+        << std::setw(15) << "blocked"
+        << std::setw(13) << "max write"
+        << std::setw(13) << "close" << std::endl;
+
+    benchmarkReceive("synchronous", directory, fileSize, chunkSize, FileIOWorker::ref(), &eventLoop, FileWriteBytestream::NoSync);
+    benchmarkReceive("write-behind", directory, fileSize, chunkSize, worker, &eventLoop, FileWriteBytestream::NoSync);
+    benchmarkReceive("synchronous, sync every block", directory, fileSize, chunkSize, FileIOWorker::ref(), &eventLoop, FileWriteBytestream::SyncEveryBlock);
+    benchmarkReceive("write-behind, sync every block", directory, fileSize, chunkSize, worker, &eventLoop, FileWriteBytestream::SyncEveryBlock);
+
+    std::shared_ptr<CryptoProvider> crypto(PlatformCryptoProvider::create());
+    ByteArray chunk(chunkSize);
+    for (size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = static_cast<unsigned char>(i * 7);
+    }
+
+    std::cout << std::endl << "Hashing " << fileSize / (1024*1024) << " MB in chunks of " << chunkSize << " bytes" << std::endl;
+    std::cout << std::left << std::setw(36) << "" << std::right
+        << std::setw(15) << "throughput"
+        << std::setw(15) << "blocked" << std::endl;
+
+    std::vector<std::string> algorithms = {"md5", "sha-1", "sha-256", "sha-512", "sha3-256", "sha3-512", "blake2b-512"};
+    for (const auto& algorithm : algorithms) {
+        benchmarkHash(algorithm, crypto.get(), fileSize, chunk);
+    }
+
+    std::vector<std::string> legacyAlgorithms = {"sha-1", "md5"};
+    std::vector<std::string> modernAlgorithms = {"sha-256", "sha3-256", "blake2b-512"};
+    benchmarkHashCalculator("sha-1+md5, synchronous", legacyAlgorithms, crypto.get(), FileIOWorker::ref(), &eventLoop, fileSize, chunk);
+    benchmarkHashCalculator("sha-1+md5, worker", legacyAlgorithms, crypto.get(), worker, &eventLoop, fileSize, chunk);
+    benchmarkHashCalculator("sha-256+sha3+blake2b, synchronous", modernAlgorithms, crypto.get(), FileIOWorker::ref(), &eventLoop, fileSize, chunk);
+    benchmarkHashCalculator("sha-256+sha3+blake2b, worker", modernAlgorithms, crypto.get(), worker, &eventLoop, fileSize, chunk);
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures the cost of correlating incoming IQ responses with outstanding
+ * requests, when many requests are in flight at the same time. Responses
+ * arrive in random order. For comparison, the same is done with handlers
+ * that match on the IQ ID themselves and are registered as regular handlers,
+ * which is how requests used to be correlated.
+ *
+ * Usage: IQRouterBenchmark [outstanding-requests] [rounds]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Swiften/Elements/RawXMLPayload.h>
+#include <Swiften/Queries/GenericRequest.h>
+#include <Swiften/Queries/IQChannel.h>
+#include <Swiften/Queries/IQHandler.h>
+#include <Swiften/Queries/IQRouter.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+class BenchmarkIQChannel : public IQChannel {
+    public:
+        BenchmarkIQChannel() : nextID(0) {}
+
+        virtual void sendIQ(std::shared_ptr<IQ>) {
+        }
+
+        virtual std::string getNewIQID() {
+            return std::to_string(nextID++);
+        }
+
+        virtual bool isAvailable() const {
+            return true;
+        }
+
+    private:
+        unsigned long long nextID;
+};
+
+// The way requests used to be correlated, for comparison
+class IDMatchingHandler : public IQHandler {
+    public:
+        IDMatchingHandler(const std::string& id, IQRouter* router) : id(id), router(router) {
+        }
+
+        virtual bool handleIQ(std::shared_ptr<IQ> iq) {
+            if (iq->getType() == IQ::Result && iq->getID() == id) {
+                router->removeHandler(this);
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        std::string id;
+        IQRouter* router;
+};
+
+static size_t responses = 0;
+
+static void handleResponse(std::shared_ptr<RawXMLPayload>, ErrorPayload::ref) {
+    responses++;
+}
+
+static void report(const std::string& name, int count, double seconds) {
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+        << std::setw(12) << seconds * 1e9 / count << " ns/response" << std::endl;
+}
+
+static std::vector<std::shared_ptr<IQ> > createShuffledResponses(const std::vector<std::string>& ids, std::mt19937& random) {
+    std::vector<std::shared_ptr<IQ> > result;
+    for (const auto& id : ids) {
+        result.push_back(IQ::createResult(JID(), id, std::make_shared<RawXMLPayload>("<query/>")));
+    }
+    std::shuffle(result.begin(), result.end(), random);
+    return result;
+}
+
+static double benchmarkRequests(int outstanding, int rounds, std::mt19937& random) {
+    BenchmarkIQChannel channel;
+    IQRouter router(&channel);
+    double seconds = 0;
+    for (int round = 0; round < rounds; ++round) {
+        std::vector<std::string> ids;
+        for (int i = 0; i < outstanding; ++i) {
+            GenericRequest<RawXMLPayload>::ref request = std::make_shared<GenericRequest<RawXMLPayload> >(IQ::Get, JID(), std::make_shared<RawXMLPayload>("<query/>"), &router);
+            request->onResponse.connect(&handleResponse);
+            ids.push_back(request->send());
+        }
+        std::vector<std::shared_ptr<IQ> > iqs = createShuffledResponses(ids, random);
+        Clock::time_point start = Clock::now();
+        for (const auto& iq : iqs) {
+            channel.onIQReceived(iq);
+        }
+        seconds += std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return seconds;
+}
+
+static double benchmarkHandlers(int outstanding, int rounds, std::mt19937& random) {
+    BenchmarkIQChannel channel;
+    IQRouter router(&channel);
+    double seconds = 0;
+    for (int round = 0; round < rounds; ++round) {
+        std::vector<std::string> ids;
+        for (int i = 0; i < outstanding; ++i) {
+            std::string id = router.getNewIQID();
+            router.addHandler(std::make_shared<IDMatchingHandler>(id, &router));
+            ids.push_back(id);
+        }
+        std::vector<std::shared_ptr<IQ> > iqs = createShuffledResponses(ids, random);
+        Clock::time_point start = Clock::now();
+        for (const auto& iq : iqs) {
+            channel.onIQReceived(iq);
+            responses++;
+        }
+        seconds += std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return seconds;
+}
+
+int main(int argc, char* argv[]) {
+    int outstanding = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 3;
+    std::mt19937 random(42);
+
+    std::cout << "Answering " << rounds << " x " << outstanding << " outstanding requests" << std::endl;
+    report("response table", outstanding * rounds, benchmarkRequests(outstanding, rounds, random));
+    report("handler scan", outstanding * rounds, benchmarkHandlers(outstanding, rounds, random));
+
+    return responses == static_cast<size_t>(2 * outstanding * rounds) ? 0 : 1;
+}
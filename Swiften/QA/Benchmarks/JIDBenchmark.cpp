@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures JID construction from strings, as done for the 'from' and 'to'
+ * attributes of every stanza, over a mix of JIDs resembling what a client
+ * sees: mostly lowercase ASCII full and bare JIDs, some with upper case
+ * characters, MUC occupant JIDs with free-form nicknames, and a few
+ * internationalized ones.
+ *
+ * Every JID string is distinct, so the first pass measures preparing new
+ * JIDs, and the second one (with the same strings) measures JIDs that were
+ * seen before. The last pass calls the IDN converter directly, as is done
+ * when JIDs are constructed without the preparation cache.
+ *
+ * Usage: JIDBenchmark [jid-count]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Swiften/IDN/IDNConverter.h>
+#include <Swiften/IDN/PlatformIDNConverter.h>
+#include <Swiften/JID/JID.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static std::vector<std::string> createJIDs(int count) {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> kind(0, 99);
+    std::vector<std::string> jids;
+    for (int i = 0; i < count; ++i) {
+        std::string n = std::to_string(i);
+        int k = kind(random);
+        if (k < 60) {
+            jids.push_back("user" + n + "@example.com/swift-" + n + "abc");
+        }
+        else if (k < 75) {
+            jids.push_back("user" + n + "@example.com");
+        }
+        else if (k < 85) {
+            jids.push_back("room" + std::to_string(i % 100) + "@conference.example.com/Nick Name " + n);
+        }
+        else if (k < 95) {
+            jids.push_back("User" + n + "@Example.COM/Home" + n);
+        }
+        else {
+            jids.push_back("j\xc3\xbcrgen" + n + "@ex\xc3\xa4mple.de/B\xc3\xbcro" + n);
+        }
+    }
+    return jids;
+}
+
+static void report(const std::string& name, Clock::time_point start, size_t count, size_t valid) {
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+        << std::setw(10) << seconds * 1e3 << " ms" << std::setw(12) << seconds * 1e9 / count << " ns/JID"
+        << "    (" << valid << " valid)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+    std::vector<std::string> jids = createJIDs(count);
+    std::cout << "Constructing " << count << " JIDs" << std::endl;
+
+    Clock::time_point start = Clock::now();
+    size_t valid = 0;
+    for (const auto& jid : jids) {
+        valid += JID(jid).isValid();
+    }
+    report("JID, first seen", start, jids.size(), valid);
+
+    start = Clock::now();
+    valid = 0;
+    for (const auto& jid : jids) {
+        valid += JID(jid).isValid();
+    }
+    report("JID, seen before", start, jids.size(), valid);
+
+    std::unique_ptr<IDNConverter> converter(PlatformIDNConverter::create());
+    start = Clock::now();
+    valid = 0;
+    for (const auto& jid : jids) {
+        size_t at = jid.find('@');
+        size_t slash = jid.find('/');
+        std::string node = jid.substr(0, at);
+        std::string domain = jid.substr(at + 1, slash == std::string::npos ? std::string::npos : slash - at - 1);
+        std::string resource = slash == std::string::npos ? "" : jid.substr(slash + 1);
+        try {
+            if (converter->getIDNAEncoded(domain)) {
+                converter->getStringPrepared(node, IDNConverter::XMPPNodePrep);
+                converter->getStringPrepared(domain, IDNConverter::NamePrep);
+                converter->getStringPrepared(resource, IDNConverter::XMPPResourcePrep);
+                valid++;
+            }
+        }
+        catch (const std::exception&) {
+        }
+    }
+    report("IDNConverter", start, jids.size(), valid);
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures the cost of emitting the signals that are emitted for every
+ * received stanza, with boost::signals2 and with Swift::Signal. Each
+ * stanza is passed through a chain of signals similar to the one from the
+ * XMPP layer up to the stanza channel.
+ *
+ * Usage: SignalBenchmark [stanza-count]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/signals2.hpp>
+
+#include <Swiften/Base/Signal.h>
+#include <Swiften/Elements/Message.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static size_t received = 0;
+
+static void handleMessage(std::shared_ptr<Message> message) {
+    received += !!message;
+}
+
+static void traceElement(std::shared_ptr<ToplevelElement> element) {
+    received += !!element;
+}
+
+template<template<typename> class SignalType>
+struct Pipeline {
+    Pipeline() {
+        // Layer, session and client forward the element to each other,
+        // and the client has a few listeners (e.g. tracers, stanza ack
+        // requesters and the stanza channel)
+        layerElement.connect(boost::ref(sessionElement));
+        sessionElement.connect(boost::ref(clientElement));
+        clientElement.connect(&traceElement);
+        clientElement.connect(boost::bind(&Pipeline::handleElement, this, _1));
+        messageReceived.connect(&handleMessage);
+        messageReceived.connect(&handleMessage);
+    }
+
+    void handleElement(std::shared_ptr<ToplevelElement> element) {
+        if (std::shared_ptr<Message> message = std::dynamic_pointer_cast<Message>(element)) {
+            messageReceived(message);
+        }
+    }
+
+    SignalType<void (std::shared_ptr<ToplevelElement>)> layerElement;
+    SignalType<void (std::shared_ptr<ToplevelElement>)> sessionElement;
+    SignalType<void (std::shared_ptr<ToplevelElement>)> clientElement;
+    SignalType<void (std::shared_ptr<Message>)> messageReceived;
+};
+
+template<typename Signature>
+using Signals2Signal = boost::signals2::signal<Signature>;
+
+template<typename Signature>
+using SwiftSignal = Signal<Signature>;
+
+template<template<typename> class SignalType>
+static void benchmark(const std::string& name, int stanzaCount) {
+    Pipeline<SignalType> pipeline;
+    std::shared_ptr<Message> message = std::make_shared<Message>();
+    message->setBody("Hello");
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < stanzaCount; ++i) {
+        pipeline.layerElement(message);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(0)
+        << std::setw(12) << stanzaCount / seconds << " stanzas/s"
+        << std::setw(10) << std::setprecision(1) << seconds * 1e9 / stanzaCount << " ns/stanza" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int stanzaCount = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    std::cout << "Emitting " << stanzaCount << " stanzas through 4 signals with 6 slots" << std::endl;
+    benchmark<Signals2Signal>("boost::signals2", stanzaCount);
+    benchmark<SwiftSignal>("Swift::Signal", stanzaCount);
+
+    // Make sure the emissions are not optimized away
+    return received == 0 ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures the cost of dispatching incoming messages and presences to the
+ * payload lookups done by typical client components, and the cost of a
+ * single payload lookup compared to a scan with a dynamic cast per payload.
+ *
+ * Usage: StanzaDispatchBenchmark [stanza-count]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <Swiften/Chat/ChatStateTracker.h>
+#include <Swiften/Client/DummyStanzaChannel.h>
+#include <Swiften/Crypto/CryptoProvider.h>
+#include <Swiften/Crypto/PlatformCryptoProvider.h>
+#include <Swiften/Disco/CapsManager.h>
+#include <Swiften/Disco/CapsMemoryStorage.h>
+#include <Swiften/Disco/EntityCapsManager.h>
+#include <Swiften/Elements/Body.h>
+#include <Swiften/Elements/CapsInfo.h>
+#include <Swiften/Elements/CarbonsReceived.h>
+#include <Swiften/Elements/ChatState.h>
+#include <Swiften/Elements/Delay.h>
+#include <Swiften/Elements/DeliveryReceipt.h>
+#include <Swiften/Elements/DeliveryReceiptRequest.h>
+#include <Swiften/Elements/Idle.h>
+#include <Swiften/Elements/MUCUserPayload.h>
+#include <Swiften/Elements/Message.h>
+#include <Swiften/Elements/Presence.h>
+#include <Swiften/Elements/Replace.h>
+#include <Swiften/Elements/VCardUpdate.h>
+#include <Swiften/Presence/PresenceOracle.h>
+#include <Swiften/Queries/IQRouter.h>
+#include <Swiften/Roster/XMPPRosterImpl.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static size_t lookups = 0;
+
+// The way payloads used to be looked up, for comparison
+template<typename T>
+static std::shared_ptr<T> getPayloadByDynamicCast(const Stanza& stanza) {
+    for (const auto& payload : stanza.getStoredPayloads()) {
+        std::shared_ptr<T> result(std::dynamic_pointer_cast<T>(payload));
+        if (result) {
+            return result;
+        }
+    }
+    return std::shared_ptr<T>();
+}
+
+// Lookups similar to the ones done by the chat controllers for every message
+static void handleMessageLikeChatController(std::shared_ptr<Message> message) {
+    lookups += !!message->getPayload<Body>();
+    lookups += !!message->getPayload<Delay>();
+    lookups += !!message->getPayload<ChatState>();
+    lookups += !!message->getPayload<Replace>();
+    lookups += !!message->getPayload<DeliveryReceiptRequest>();
+    lookups += !!message->getPayload<DeliveryReceipt>();
+    lookups += !!message->getPayload<CarbonsReceived>();
+    lookups += !!message->getPayload<MUCUserPayload>();
+}
+
+// Lookups similar to the ones done by the roster and MUC controllers for every presence
+static void handlePresenceLikeRosterController(std::shared_ptr<Presence> presence) {
+    lookups += !!presence->getPayload<MUCUserPayload>();
+    lookups += !!presence->getPayload<VCardUpdate>();
+    lookups += !!presence->getPayload<CapsInfo>();
+    lookups += !!presence->getPayload<Idle>();
+    lookups += !!presence->getPayload<Delay>();
+    lookups += presence->getShow();
+    lookups += presence->getStatus().size();
+}
+
+static std::shared_ptr<Message> createMessage(int i) {
+    std::shared_ptr<Message> message = std::make_shared<Message>();
+    message->setFrom(JID("alice@example.com/phone"));
+    message->setTo(JID("bob@example.com/laptop"));
+    message->setType(Message::Chat);
+    message->setBody("Hello there, message " + std::to_string(i));
+    message->addPayload(std::make_shared<ChatState>(ChatState::Active));
+    message->addPayload(std::make_shared<DeliveryReceiptRequest>());
+    if (i % 4 == 0) {
+        message->addPayload(std::make_shared<Delay>(boost::posix_time::second_clock::universal_time()));
+    }
+    if (i % 8 == 0) {
+        message->addPayload(std::make_shared<Replace>("previous"));
+    }
+    return message;
+}
+
+static std::shared_ptr<Presence> createPresence(int i) {
+    std::shared_ptr<Presence> presence = std::make_shared<Presence>();
+    presence->setFrom(JID("room@conference.example.com/user" + std::to_string(i % 100)));
+    presence->setTo(JID("bob@example.com/laptop"));
+    presence->setStatus("Around");
+    presence->setPriority(5);
+    presence->addPayload(std::make_shared<CapsInfo>("https://swift.im", "ver" + std::to_string(i % 10), "sha-1"));
+    presence->addPayload(std::make_shared<VCardUpdate>("0123456789abcdef"));
+    std::shared_ptr<MUCUserPayload> mucPayload = std::make_shared<MUCUserPayload>();
+    mucPayload->addItem(MUCItem(MUCOccupant::Member, MUCOccupant::Participant));
+    presence->addPayload(mucPayload);
+    return presence;
+}
+
+static void benchmarkDispatch(int stanzaCount) {
+    std::shared_ptr<CryptoProvider> crypto(PlatformCryptoProvider::create());
+    DummyStanzaChannel stanzaChannel;
+    IQRouter iqRouter(&stanzaChannel);
+    XMPPRosterImpl roster;
+    PresenceOracle presenceOracle(&stanzaChannel, &roster);
+    CapsMemoryStorage capsStorage;
+    CapsManager capsManager(&capsStorage, &stanzaChannel, &iqRouter, crypto.get());
+    EntityCapsManager entityCapsManager(&capsManager, &stanzaChannel);
+    ChatStateTracker chatStateTracker;
+    stanzaChannel.onMessageReceived.connect(boost::bind(&ChatStateTracker::handleMessageReceived, &chatStateTracker, _1));
+    stanzaChannel.onMessageReceived.connect(&handleMessageLikeChatController);
+    stanzaChannel.onPresenceReceived.connect(&handlePresenceLikeRosterController);
+
+    std::vector<std::shared_ptr<Message> > messages;
+    std::vector<std::shared_ptr<Presence> > presences;
+    for (int i = 0; i < stanzaCount; ++i) {
+        messages.push_back(createMessage(i));
+        presences.push_back(createPresence(i));
+    }
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < stanzaCount; ++i) {
+        stanzaChannel.onMessageReceived(messages[i]);
+        stanzaChannel.onPresenceReceived(presences[i]);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << std::left << std::setw(36) << "dispatch (message + presence)" << std::right << std::fixed << std::setprecision(0)
+        << std::setw(12) << (2 * stanzaCount) / seconds << " stanzas/s"
+        << std::setw(10) << std::setprecision(1) << seconds * 1e9 / (2 * stanzaCount) << " ns/stanza" << std::endl;
+}
+
+template<typename LookupFunction>
+static void benchmarkLookup(const std::string& name, int iterations, LookupFunction lookup) {
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        lookup();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+        << std::setw(12) << seconds * 1e9 / iterations << " ns/lookup" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int stanzaCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    std::cout << "Dispatching " << stanzaCount << " messages and presences" << std::endl;
+    benchmarkDispatch(stanzaCount);
+
+    // A message with the payload that is looked up at the end
+    std::shared_ptr<Message> message = createMessage(1);
+    message->addPayload(std::make_shared<Delay>(boost::posix_time::second_clock::universal_time()));
+    int iterations = stanzaCount * 10;
+    benchmarkLookup("getPayload, present", iterations, [&]() { lookups += !!message->getPayload<Delay>(); });
+    benchmarkLookup("dynamic cast scan, present", iterations, [&]() { lookups += !!getPayloadByDynamicCast<Delay>(*message); });
+    benchmarkLookup("getPayload, absent", iterations, [&]() { lookups += !!message->getPayload<MUCUserPayload>(); });
+    benchmarkLookup("dynamic cast scan, absent", iterations, [&]() { lookups += !!getPayloadByDynamicCast<MUCUserPayload>(*message); });
+
+    // Make sure the lookups are not optimized away
+    return lookups == 0 ? 1 : 0;
+}
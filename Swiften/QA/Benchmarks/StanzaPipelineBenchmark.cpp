@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures the cost per stanza of parsing a client stream with XMPPParser
+ * (XML parser, stanza parsers and payload parsers), with each XML parser,
+ * and of serializing the parsed stanzas again with XMPPSerializer.
+ *
+ * The stanzas come from the files in the Corpus directory, which hold
+ * synthetic traffic of a few typical kinds: presence floods, chat messages,
+ * MUC history, PubSub events, vCards and roster results. Each file is
+ * repeated a number of times, and fed to the parser in chunks as it would be
+ * read from the network.
+ *
+ * Allocations are counted by replacing the global operator new, so memory
+ * that the C XML parsers allocate with malloc() is not included.
+ *
+ * The allocation counts are not expected to reach zero. XMPPParser reuses
+ * its stanza parsers, and the payload parsers of the payloads that support
+ * PayloadParser::reset(), so these are not allocated in the steady state
+ * (XMPPParserTest checks this). The remaining allocations are the parsed
+ * stanzas and payloads themselves, their strings and the attribute maps,
+ * which parser reuse does not avoid, and the parsers of payloads without
+ * reset() support.
+ *
+ * Usage: StanzaPipelineBenchmark [repetitions [corpus-directory]]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <Swiften/Base/ByteArray.h>
+#include <Swiften/Elements/ProtocolHeader.h>
+#include <Swiften/Parser/NativeXMLParser.h>
+#include <Swiften/Parser/PayloadParsers/FullPayloadParserFactoryCollection.h>
+#include <Swiften/Parser/XMLParserFactory.h>
+#include <Swiften/Parser/XMPPParser.h>
+#include <Swiften/Parser/XMPPParserClient.h>
+#include <Swiften/Serializer/PayloadSerializers/FullPayloadSerializerCollection.h>
+#include <Swiften/Serializer/XMPPSerializer.h>
+#ifdef HAVE_EXPAT
+#include <Swiften/Parser/ExpatParser.h>
+#endif
+#ifdef HAVE_LIBXML
+#include <Swiften/Parser/LibXMLParser.h>
+#endif
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* result = std::malloc(size ? size : 1)) {
+        return result;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+namespace {
+    template<typename ParserType>
+    class BackendXMLParserFactory : public XMLParserFactory {
+        public:
+            virtual std::unique_ptr<XMLParser> createXMLParser(XMLParserClient* client) {
+                return std::unique_ptr<XMLParser>(new ParserType(client));
+            }
+    };
+
+    class ElementCollector : public XMPPParserClient {
+        public:
+            ElementCollector(bool keepElements) : keepElements(keepElements), count(0) {
+            }
+
+            virtual void handleStreamStart(const ProtocolHeader&) {
+            }
+
+            virtual void handleElement(std::shared_ptr<ToplevelElement> element) {
+                ++count;
+                if (keepElements) {
+                    elements.push_back(element);
+                }
+            }
+
+            virtual void handleStreamEnd() {
+            }
+
+            bool keepElements;
+            size_t count;
+            std::vector< std::shared_ptr<ToplevelElement> > elements;
+    };
+
+    struct Result {
+        Result() : seconds(-1), bytes(0), stanzas(0), allocations(0) {}
+
+        double seconds;
+        size_t bytes;
+        size_t stanzas;
+        size_t allocations;
+    };
+}
+
+static const std::string StreamHeader = "<?xml version='1.0'?><stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams' from='wonderland.lit' id='stream1' version='1.0'>";
+static const size_t ChunkSize = 4096;
+static const int Runs = 3;
+
+static std::vector<std::string> createChunks(const std::string& corpus, int repetitions) {
+    std::string stream = StreamHeader;
+    for (int i = 0; i < repetitions; ++i) {
+        stream += corpus;
+    }
+    std::vector<std::string> chunks;
+    for (size_t i = 0; i < stream.size(); i += ChunkSize) {
+        chunks.push_back(stream.substr(i, ChunkSize));
+    }
+    return chunks;
+}
+
+static bool parse(const std::vector<std::string>& chunks, XMLParserFactory* xmlParserFactory, PayloadParserFactoryCollection* payloadParserFactories, ElementCollector& collector) {
+    XMPPParser parser(&collector, payloadParserFactories, xmlParserFactory);
+    for (const auto& chunk : chunks) {
+        if (!parser.parse(chunk)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static Result benchmarkParse(const std::vector<std::string>& chunks, XMLParserFactory* xmlParserFactory, PayloadParserFactoryCollection* payloadParserFactories) {
+    Result result;
+    for (const auto& chunk : chunks) {
+        result.bytes += chunk.size();
+    }
+    for (int run = 0; run < Runs; ++run) {
+        ElementCollector collector(false);
+        size_t allocationsBefore = allocations;
+        Clock::time_point start = Clock::now();
+        if (!parse(chunks, xmlParserFactory, payloadParserFactories, collector)) {
+            result.stanzas = 0;
+            return result;
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (result.seconds < 0 || seconds < result.seconds) {
+            result.seconds = seconds;
+        }
+        result.allocations = allocations - allocationsBefore;
+        result.stanzas = collector.count;
+    }
+    return result;
+}
+
+static Result benchmarkSerialize(const std::vector< std::shared_ptr<ToplevelElement> >& elements, PayloadSerializerCollection* payloadSerializers) {
+    XMPPSerializer serializer(payloadSerializers, ClientStreamType, false);
+    Result result;
+    for (int run = 0; run < Runs; ++run) {
+        size_t bytes = 0;
+        size_t allocationsBefore = allocations;
+        Clock::time_point start = Clock::now();
+        for (const auto& element : elements) {
+            bytes += serializer.serializeElement(element).size();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (result.seconds < 0 || seconds < result.seconds) {
+            result.seconds = seconds;
+        }
+        result.allocations = allocations - allocationsBefore;
+        result.bytes = bytes;
+        result.stanzas = elements.size();
+    }
+    return result;
+}
+
+static void printResult(const std::string& corpus, const std::string& stage, const std::string& parser, const Result& result) {
+    std::cout << std::left << std::setw(16) << corpus << std::setw(11) << stage << std::setw(8) << parser << std::right;
+    if (result.stanzas == 0) {
+        std::cout << "  parse error" << std::endl;
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(0)
+        << std::setw(12) << result.stanzas / result.seconds
+        << std::setw(10) << std::setprecision(1) << result.bytes / result.seconds / (1024 * 1024)
+        << std::setw(14) << static_cast<double>(result.allocations) / static_cast<double>(result.stanzas) << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 20;
+    boost::filesystem::path corpusDirectory = argc > 2 ? boost::filesystem::path(argv[2]) : boost::filesystem::path(argv[0]).parent_path() / "Corpus";
+
+    const char* corpora[] = { "presence-flood", "chat", "muc-history", "pubsub-events", "vcards", "roster" };
+
+    FullPayloadParserFactoryCollection payloadParserFactories;
+    FullPayloadSerializerCollection payloadSerializers;
+    BackendXMLParserFactory<NativeXMLParser> nativeXMLParserFactory;
+#ifdef HAVE_LIBXML
+    BackendXMLParserFactory<LibXMLParser> libXMLParserFactory;
+#endif
+#ifdef HAVE_EXPAT
+    BackendXMLParserFactory<ExpatParser> expatParserFactory;
+#endif
+
+    std::cout << "Corpus repeated " << repetitions << " times, best of " << Runs << " runs" << std::endl;
+    std::cout << std::left << std::setw(16) << "corpus" << std::setw(11) << "stage" << std::setw(8) << "parser" << std::right
+        << std::setw(12) << "stanzas/s" << std::setw(10) << "MiB/s" << std::setw(14) << "allocs/stanza" << std::endl;
+    for (const char* corpus : corpora) {
+        ByteArray data;
+        boost::filesystem::path file = corpusDirectory / (std::string(corpus) + ".xml");
+        if (!boost::filesystem::exists(file)) {
+            std::cerr << "Unable to find " << file.string() << std::endl;
+            return -1;
+        }
+        readByteArrayFromFile(data, file);
+        std::vector<std::string> chunks = createChunks(byteArrayToString(data), repetitions);
+
+        printResult(corpus, "parse", "Native", benchmarkParse(chunks, &nativeXMLParserFactory, &payloadParserFactories));
+#ifdef HAVE_LIBXML
+        printResult(corpus, "parse", "LibXML", benchmarkParse(chunks, &libXMLParserFactory, &payloadParserFactories));
+#endif
+#ifdef HAVE_EXPAT
+        printResult(corpus, "parse", "Expat", benchmarkParse(chunks, &expatParserFactory, &payloadParserFactories));
+#endif
+
+        ElementCollector collector(true);
+        if (parse(createChunks(byteArrayToString(data), 1), &nativeXMLParserFactory, &payloadParserFactories, collector)) {
+            std::vector< std::shared_ptr<ToplevelElement> > elements;
+            for (int i = 0; i < repetitions; ++i) {
+                elements.insert(elements.end(), collector.elements.begin(), collector.elements.end());
+            }
+            printResult(corpus, "serialize", "", benchmarkSerialize(elements, &payloadSerializers));
+        }
+    }
+    return 0;
+}
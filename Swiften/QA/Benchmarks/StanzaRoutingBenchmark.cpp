@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures the cost of routing stanzas the way a server or component does:
+ * parsing them from a stream, looking at the addressing, and serializing
+ * them again. Payloads are parsed eagerly, lazily without being looked at,
+ * and lazily with one payload looked up per stanza. Some stanzas carry an
+ * extension payload that Swiften does not know, which is passed through as
+ * raw XML.
+ *
+ * Usage: StanzaRoutingBenchmark [stanza-count]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Swiften/Elements/Body.h>
+#include <Swiften/Elements/CapsInfo.h>
+#include <Swiften/Elements/Message.h>
+#include <Swiften/Elements/Presence.h>
+#include <Swiften/Elements/ProtocolHeader.h>
+#include <Swiften/Elements/RosterPayload.h>
+#include <Swiften/Elements/Stanza.h>
+#include <Swiften/Parser/PayloadParsers/FullPayloadParserFactoryCollection.h>
+#include <Swiften/Parser/PlatformXMLParserFactory.h>
+#include <Swiften/Parser/XMPPParser.h>
+#include <Swiften/Parser/XMPPParserClient.h>
+#include <Swiften/Serializer/PayloadSerializers/FullPayloadSerializerCollection.h>
+#include <Swiften/Serializer/XMPPSerializer.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+    class RoutingClient : public XMPPParserClient {
+        public:
+            RoutingClient(XMPPSerializer* serializer, bool lookupPayload) : serializer(serializer), lookupPayload(lookupPayload) {
+            }
+
+            virtual void handleStreamStart(const ProtocolHeader&) {
+            }
+
+            virtual void handleElement(std::shared_ptr<ToplevelElement> element) {
+                std::shared_ptr<Stanza> stanza = std::dynamic_pointer_cast<Stanza>(element);
+                if (!stanza) {
+                    return;
+                }
+                routed += stanza->getTo().getDomain().size();
+                if (lookupPayload) {
+                    // A filter that only looks at one payload type
+                    routed += !!stanza->getPayload<Body>();
+                }
+                routedBytes += serializer->serializeElement(stanza).size();
+            }
+
+            virtual void handleStreamEnd() {
+            }
+
+            XMPPSerializer* serializer;
+            bool lookupPayload;
+            size_t routed = 0;
+            size_t routedBytes = 0;
+    };
+}
+
+static std::string createStanza(int i) {
+    std::string id = std::to_string(i);
+    switch (i % 4) {
+        case 0:
+            return "<message from='alice@wonderland.lit/rabbithole' to='bob@wonderland.lit' type='chat' id='m" + id + "'>"
+                "<body>Hello Bob, this is message " + id + ". Are you coming to the tea party?</body>"
+                "<active xmlns='http://jabber.org/protocol/chatstates'/>"
+                "<request xmlns='urn:xmpp:receipts'/>"
+                "<delay xmlns='urn:xmpp:delay' from='wonderland.lit' stamp='2018-03-01T12:00:00Z'/>"
+                "</message>";
+        case 1:
+            return "<presence from='contact" + id + "@wonderland.lit/caterpillar' to='alice@wonderland.lit'>"
+                "<show>away</show><status>Smoking a hookah</status><priority>5</priority>"
+                "<c xmlns='http://jabber.org/protocol/caps' hash='sha-1' node='https://swift.im' ver='QgayPKawpkPSDYmwT/WM94uAlu0='/>"
+                "<x xmlns='vcard-temp:x:update'><photo>01b87fcd030b72895ff8e88db57ec525450f000d</photo></x>"
+                "</presence>";
+        case 2:
+            return "<iq type='result' id='i" + id + "' from='wonderland.lit' to='alice@wonderland.lit/rabbithole'>"
+                "<query xmlns='jabber:iq:roster' ver='ver" + id + "'>"
+                "<item jid='contact" + id + "@wonderland.lit' name='Contact " + id + "' subscription='both'><group>Friends</group></item>"
+                "<item jid='hatter@wonderland.lit' name='Hatter' subscription='both'><group>Friends</group><group>Tea</group></item>"
+                "</query></iq>";
+        default:
+            return "<message from='room@conference.wonderland.lit/Hatter' to='alice@wonderland.lit/rabbithole' type='groupchat' id='g" + id + "'>"
+                "<body>Why is a raven like a writing-desk?</body>"
+                "<stanza-id xmlns='urn:xmpp:sid:0' by='room@conference.wonderland.lit' id='" + id + "'/>"
+                "<x xmlns='http://jabber.org/protocol/muc#user'><item affiliation='member' role='participant'/></x>"
+                "<game xmlns='urn:example:chess' xml:lang='en'><move piece='knight' from='g1' to='f3'/><comment>A &lt;solid&gt; opening</comment></game>"
+                "</message>";
+    }
+}
+
+static std::string createStream(int stanzaCount) {
+    std::string stream = "<?xml version='1.0'?><stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams' from='wonderland.lit' id='stream1' version='1.0'>";
+    for (int i = 0; i < stanzaCount; ++i) {
+        stream += createStanza(i);
+    }
+    return stream;
+}
+
+static void benchmark(const std::string& name, const std::vector<std::string>& chunks, int stanzaCount, bool lazy, bool lookupPayload) {
+    FullPayloadParserFactoryCollection parsers;
+    FullPayloadSerializerCollection serializers;
+    PlatformXMLParserFactory xmlParserFactory;
+    XMPPSerializer serializer(&serializers, ClientStreamType, false);
+
+    // Best of a few runs
+    double bestSeconds = -1;
+    size_t routedBytes = 0;
+    for (int run = 0; run < 3; ++run) {
+        RoutingClient client(&serializer, lookupPayload);
+        XMPPParser parser(&client, &parsers, &xmlParserFactory);
+        parser.setLazyPayloadParsing(lazy);
+        Clock::time_point start = Clock::now();
+        for (const auto& chunk : chunks) {
+            if (!parser.parse(chunk)) {
+                std::cerr << name << ": parse error" << std::endl;
+                return;
+            }
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (bestSeconds < 0 || seconds < bestSeconds) {
+            bestSeconds = seconds;
+        }
+        routedBytes = client.routedBytes;
+    }
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(0)
+        << std::setw(12) << stanzaCount / bestSeconds << " stanzas/s"
+        << std::setw(10) << std::setprecision(1) << bestSeconds * 1e9 / stanzaCount << " ns/stanza"
+        << std::setw(12) << routedBytes << " bytes out" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int stanzaCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    // Fed to the parser in chunks, as it would be read from the network
+    std::string stream = createStream(stanzaCount);
+    std::vector<std::string> chunks;
+    for (size_t i = 0; i < stream.size(); i += 4096) {
+        chunks.push_back(stream.substr(i, 4096));
+    }
+
+    std::cout << "Routing " << stanzaCount << " stanzas (" << stream.size() / 1024 << " KiB)" << std::endl;
+    benchmark("eager", chunks, stanzaCount, false, false);
+    benchmark("lazy", chunks, stanzaCount, true, false);
+    benchmark("lazy, one lookup", chunks, stanzaCount, true, true);
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Runs a large number of timers, the way a process that manages many
+ * sessions does (connect timeouts, whitespace pings, ...), with the
+ * BoostTimerFactory and the TimingWheelTimerFactory.
+ *
+ * First, all timers are started with timeouts of up to a minute, and are
+ * then repeatedly restarted in random order (as happens to a ping timer
+ * whenever data is received). Then, all timers are started with timeouts
+ * spread over a short period, and are left to expire; this reports the CPU
+ * time spent, how often the event loop had to run, and how late the timers
+ * fired.
+ *
+ * Usage: TimerBenchmark [timer-count [restart-rounds [expiry-period-ms]]]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/bind.hpp>
+
+#include <Swiften/EventLoop/DummyEventLoop.h>
+#include <Swiften/Network/BoostTimerFactory.h>
+#include <Swiften/Network/Timer.h>
+#include <Swiften/Network/TimingWheelTimerFactory.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+static std::vector<Clock::time_point> fireTimes;
+static size_t fired = 0;
+
+static void handleTick(size_t index) {
+    fireTimes[index] = Clock::now();
+    fired++;
+}
+
+static void report(const std::string& name, const std::string& phase, double seconds, size_t operations, const std::string& details) {
+    std::cout << std::left << std::setw(20) << name << std::setw(10) << phase << std::right
+        << std::setw(10) << std::fixed << std::setprecision(1) << (seconds * 1e3) << " ms"
+        << std::setw(10) << std::setprecision(0) << (seconds * 1e9 / operations) << " ns/op"
+        << "    " << details << std::endl;
+}
+
+static void benchmarkChurn(const std::string& name, TimerFactory& factory, std::shared_ptr<boost::asio::io_service> ioService, size_t timerCount, int rounds) {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> timeout(1000, 60000);
+    std::vector<std::shared_ptr<Timer> > timers;
+    for (size_t i = 0; i < timerCount; ++i) {
+        timers.push_back(factory.createTimer(timeout(random)));
+    }
+    std::vector<size_t> order(timerCount);
+    for (size_t i = 0; i < timerCount; ++i) {
+        order[i] = i;
+    }
+
+    Clock::time_point start = Clock::now();
+    for (const auto& timer : timers) {
+        timer->start();
+    }
+    for (int round = 0; round < rounds; ++round) {
+        std::shuffle(order.begin(), order.end(), random);
+        for (size_t i : order) {
+            timers[i]->stop();
+            timers[i]->start();
+        }
+        // Let asio complete the cancelled waits
+        ioService->poll();
+    }
+    for (const auto& timer : timers) {
+        timer->stop();
+    }
+    ioService->poll();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    report(name, "churn", seconds, timerCount * (2 + 2 * static_cast<size_t>(rounds)), std::to_string(rounds) + " restart rounds");
+}
+
+static void benchmarkExpiry(const std::string& name, TimerFactory& factory, std::shared_ptr<boost::asio::io_service> ioService, DummyEventLoop& eventLoop, size_t timerCount, int periodMilliseconds) {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> timeout(0, periodMilliseconds);
+    std::vector<std::shared_ptr<Timer> > timers;
+    std::vector<int> timeouts;
+    for (size_t i = 0; i < timerCount; ++i) {
+        timeouts.push_back(timeout(random));
+        timers.push_back(factory.createTimer(timeouts.back()));
+        timers.back()->onTick.connect(boost::bind(&handleTick, i));
+    }
+    fireTimes.assign(timerCount, Clock::time_point());
+    fired = 0;
+
+    Clock::time_point start = Clock::now();
+    std::clock_t cpuStart = std::clock();
+    for (const auto& timer : timers) {
+        timer->start();
+    }
+    size_t events = 0;
+    while (fired < timerCount) {
+        ioService->run_one();
+        while (eventLoop.hasEvents()) {
+            eventLoop.processEvents();
+            events++;
+        }
+    }
+    double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+    double totalLateness = 0;
+    double maxLateness = 0;
+    for (size_t i = 0; i < timerCount; ++i) {
+        double lateness = std::chrono::duration<double>(fireTimes[i] - start).count() * 1e3 - timeouts[i];
+        totalLateness += lateness;
+        maxLateness = std::max(maxLateness, lateness);
+    }
+    std::ostringstream details;
+    details << events << " event loop runs, lateness avg " << std::setprecision(2) << (totalLateness / timerCount) << " ms, max " << maxLateness << " ms";
+    report(name, "expiry", cpuSeconds, timerCount, details.str());
+}
+
+int main(int argc, char* argv[]) {
+    size_t timerCount = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 100000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+    int periodMilliseconds = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+    std::cout << "Running " << timerCount << " timers" << std::endl;
+    {
+        std::shared_ptr<boost::asio::io_service> ioService = std::make_shared<boost::asio::io_service>();
+        boost::asio::io_service::work work(*ioService);
+        DummyEventLoop eventLoop;
+        BoostTimerFactory factory(ioService, &eventLoop);
+        benchmarkChurn("BoostTimer", factory, ioService, timerCount, rounds);
+        benchmarkExpiry("BoostTimer", factory, ioService, eventLoop, timerCount, periodMilliseconds);
+    }
+    {
+        std::shared_ptr<boost::asio::io_service> ioService = std::make_shared<boost::asio::io_service>();
+        boost::asio::io_service::work work(*ioService);
+        DummyEventLoop eventLoop;
+        TimingWheelTimerFactory factory(ioService, &eventLoop);
+        benchmarkChurn("TimingWheel (10ms)", factory, ioService, timerCount, rounds);
+        benchmarkExpiry("TimingWheel (10ms)", factory, ioService, eventLoop, timerCount, periodMilliseconds);
+    }
+    return 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Replays concurrent whiteboard operations between a WhiteboardClient and a
+ * WhiteboardServer over a simulated link with latency, and reports the
+ * throughput and the size of the server side history. The same replay is run
+ * against the previous server, which keeps the complete history, for
+ * comparison.
+ *
+ * Most of the time of a replay goes to the client and the simulated link, so
+ * the operations the server received are also recorded, and fed to each
+ * server on its own. All timings are the best of a number of runs.
+ *
+ * Usage: WhiteboardBenchmark [operation-count] [max-latency-in-rounds]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Swiften/Elements/Whiteboard/WhiteboardInsertOperation.h>
+#include <Swiften/Whiteboard/WhiteboardClient.h>
+#include <Swiften/Whiteboard/WhiteboardServer.h>
+#include <Swiften/Whiteboard/WhiteboardTransformer.h>
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+// The previous server, which keeps and scans the complete history
+class ListWhiteboardServer {
+    public:
+        void handleLocalOperationReceived(WhiteboardOperation::ref operation) {
+            operations_.push_back(operation);
+        }
+
+        WhiteboardOperation::ref handleClientOperationReceived(WhiteboardOperation::ref newOperation) {
+            std::list<WhiteboardOperation::ref>::reverse_iterator it;
+            if (operations_.empty() || newOperation->getParentID() == operations_.back()->getID()) {
+                operations_.push_back(newOperation);
+                return newOperation;
+            }
+            for (it = operations_.rbegin(); it != operations_.rend(); ++it) {
+                WhiteboardOperation::ref operation = *it;
+                while (newOperation->getParentID() == operation->getParentID()) {
+                    std::pair<WhiteboardOperation::ref, WhiteboardOperation::ref> tResult = WhiteboardTransformer::transform(newOperation, operation);
+                    if (it == operations_.rbegin()) {
+                        operations_.push_back(tResult.second);
+                        return tResult.second;
+                    }
+                    newOperation = tResult.second;
+                    --it;
+                    operation = *it;
+                }
+            }
+            return WhiteboardOperation::ref();
+        }
+
+        size_t getHistorySize() const {
+            return operations_.size();
+        }
+
+    private:
+        std::list<WhiteboardOperation::ref> operations_;
+};
+
+struct Result {
+    double seconds;
+    size_t historySize;
+    size_t failures;
+};
+
+// An operation as received by the server
+struct ServerInput {
+    bool fromClient;
+    WhiteboardOperation::ref operation;
+};
+
+static const int Runs = 5;
+
+static WhiteboardOperation::ref createOperation(const std::string& id, const std::string& parentID, int pos) {
+    WhiteboardInsertOperation::ref operation = std::make_shared<WhiteboardInsertOperation>();
+    operation->setID(id);
+    operation->setParentID(parentID);
+    operation->setPos(pos);
+    return operation;
+}
+
+// Mirrors what OutgoingWhiteboardSession (server) and IncomingWhiteboardSession (client) do
+template<typename Server>
+static Result replay(int operationCount, int maxLatency, std::vector<ServerInput>* serverInputs) {
+    Server server;
+    WhiteboardClient client;
+    std::string serverLastOpID;
+    std::string clientLastOpID;
+    std::deque<std::pair<int, WhiteboardOperation::ref> > toServer;
+    std::deque<std::pair<int, WhiteboardOperation::ref> > toClient;
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> latencies(1, maxLatency);
+    std::uniform_int_distribution<int> positions(0, 50);
+    std::bernoulli_distribution serverActivity(0.5);
+    // The client only has one operation in flight, so it must not produce them faster than it gets them acknowledged
+    std::bernoulli_distribution clientActivity(0.5 / maxLatency);
+    int round = 0;
+    Result result = Result();
+
+    WhiteboardOperation::ref firstOperation = createOperation("0", "", 0);
+    if (serverInputs) {
+        serverInputs->push_back({false, firstOperation});
+    }
+    server.handleLocalOperationReceived(firstOperation);
+    serverLastOpID = "0";
+    toClient.push_back(std::make_pair(round, firstOperation));
+
+    auto deliverToServer = [&]() {
+        if (serverInputs) {
+            serverInputs->push_back({true, toServer.front().second});
+        }
+        WhiteboardOperation::ref operation = server.handleClientOperationReceived(toServer.front().second);
+        toServer.pop_front();
+        if (!operation) {
+            result.failures++;
+            return;
+        }
+        serverLastOpID = operation->getID();
+        toClient.push_back(std::make_pair(round + latencies(random), operation));
+    };
+    auto deliverToClient = [&]() {
+        WhiteboardClient::Result clientResult = client.handleServerOperationReceived(toClient.front().second);
+        toClient.pop_front();
+        if (clientResult.client) {
+            clientLastOpID = clientResult.client->getID();
+        }
+        if (clientResult.server) {
+            toServer.push_back(std::make_pair(round + latencies(random), clientResult.server));
+        }
+    };
+
+    Clock::time_point start = Clock::now();
+    for (int operations = 0; operations < operationCount; ++round) {
+        if (serverActivity(random)) {
+            WhiteboardOperation::ref operation = createOperation("s" + std::to_string(operations++), serverLastOpID, positions(random));
+            serverLastOpID = operation->getID();
+            if (serverInputs) {
+                serverInputs->push_back({false, operation});
+            }
+            server.handleLocalOperationReceived(operation);
+            toClient.push_back(std::make_pair(round + latencies(random), operation));
+        }
+        if (clientActivity(random)) {
+            WhiteboardOperation::ref operation = createOperation("c" + std::to_string(operations++), clientLastOpID, positions(random));
+            clientLastOpID = operation->getID();
+            WhiteboardOperation::ref sent = client.handleLocalOperationReceived(operation);
+            if (sent) {
+                toServer.push_back(std::make_pair(round + latencies(random), sent));
+            }
+        }
+
+        // Both directions are ordered, like an XMPP stream
+        while (!toServer.empty() && toServer.front().first <= round) {
+            deliverToServer();
+        }
+        while (!toClient.empty() && toClient.front().first <= round) {
+            deliverToClient();
+        }
+    }
+    while (!toServer.empty() || !toClient.empty()) {
+        ++round;
+        while (!toServer.empty() && toServer.front().first <= round) {
+            deliverToServer();
+        }
+        while (!toClient.empty() && toClient.front().first <= round) {
+            deliverToClient();
+        }
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.historySize = server.getHistorySize();
+    return result;
+}
+
+template<typename Server>
+static Result replayBest(int operationCount, int maxLatency) {
+    Result best = Result();
+    for (int run = 0; run < Runs; ++run) {
+        Result result = replay<Server>(operationCount, maxLatency, nullptr);
+        if (run == 0 || result.seconds < best.seconds) {
+            best = result;
+        }
+    }
+    return best;
+}
+
+template<typename Server>
+static Result replayServerInputs(const std::vector<ServerInput>& serverInputs) {
+    Result best = Result();
+    for (int run = 0; run < Runs; ++run) {
+        Server server;
+        Result result = Result();
+        Clock::time_point start = Clock::now();
+        for (const auto& input : serverInputs) {
+            if (!input.fromClient) {
+                server.handleLocalOperationReceived(input.operation);
+            }
+            else if (!server.handleClientOperationReceived(input.operation)) {
+                result.failures++;
+            }
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        result.historySize = server.getHistorySize();
+        if (run == 0 || result.seconds < best.seconds) {
+            best = result;
+        }
+    }
+    return best;
+}
+
+static void report(const std::string& name, int operationCount, const Result& result) {
+    std::cout << std::left << std::setw(24) << name << std::right
+        << std::setw(10) << static_cast<long long>(operationCount / result.seconds) << " ops/s"
+        << std::setw(10) << std::fixed << std::setprecision(1) << (result.seconds * 1e9 / operationCount) << " ns/op"
+        << std::setw(10) << result.historySize << " operations in history"
+        << std::setw(6) << result.failures << " failures" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int operationCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int maxLatency = argc > 2 ? std::atoi(argv[2]) : 4;
+
+    std::vector<ServerInput> serverInputs;
+    replay<WhiteboardServer>(operationCount, maxLatency, &serverInputs);
+
+    std::cout << "Replaying " << operationCount << " concurrent operations, best of " << Runs << " runs" << std::endl;
+    report("compacted history", operationCount, replayBest<WhiteboardServer>(operationCount, maxLatency));
+    report("list history", operationCount, replayBest<ListWhiteboardServer>(operationCount, maxLatency));
+    report("compacted history, server", operationCount, replayServerInputs<WhiteboardServer>(serverInputs));
+    report("list history, server", operationCount, replayServerInputs<ListWhiteboardServer>(serverInputs));
+    return 0;
+}
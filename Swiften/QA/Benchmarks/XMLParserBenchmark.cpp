@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+/*
+ * Measures the throughput of each XML parser on a client stream of mixed
+ * stanzas, fed to the parser in chunks as they would be read from the
+ * network.
+ *
+ * Usage: XMLParserBenchmark [stanza-count [chunk-size]]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Swiften/Parser/NativeXMLParser.h>
+#include <Swiften/Parser/XMLParserClient.h>
+#ifdef HAVE_EXPAT
+#include <Swiften/Parser/ExpatParser.h>
+#endif
+#ifdef HAVE_LIBXML
+#include <Swiften/Parser/LibXMLParser.h>
+#endif
+
+using namespace Swift;
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+    class CountingClient : public XMLParserClient {
+        public:
+            virtual void handleStartElement(const std::string&, const std::string&, const AttributeMap& attributes) {
+                events += 1 + attributes.getEntries().size();
+            }
+
+            virtual void handleEndElement(const std::string&, const std::string&) {
+                events++;
+            }
+
+            virtual void handleCharacterData(const std::string& data) {
+                characters += data.size();
+            }
+
+            size_t events = 0;
+            size_t characters = 0;
+    };
+}
+
+static std::string createStanza(int i) {
+    std::string id = std::to_string(i);
+    switch (i % 4) {
+        case 0:
+            return "<message from='alice@wonderland.lit/rabbithole' to='bob@wonderland.lit' type='chat' id='m" + id + "' xml:lang='en'>"
+                "<body>Hello Bob, this is message " + id + ". Are you coming to the tea party? It starts at 5 &amp; ends late.</body>"
+                "<active xmlns='http://jabber.org/protocol/chatstates'/>"
+                "<request xmlns='urn:xmpp:receipts'/>"
+                "</message>";
+        case 1:
+            return "<presence from='contact" + id + "@wonderland.lit/caterpillar'>"
+                "<show>away</show><status>Smoking a hookah \xe2\x80\x94 back soon</status><priority>5</priority>"
+                "<c xmlns='http://jabber.org/protocol/caps' hash='sha-1' node='https://swift.im' ver='QgayPKawpkPSDYmwT/WM94uAlu0='/>"
+                "</presence>";
+        case 2:
+            return "<iq type='result' id='i" + id + "' from='wonderland.lit' to='alice@wonderland.lit/rabbithole'>"
+                "<query xmlns='jabber:iq:roster' ver='ver" + id + "'>"
+                "<item jid='contact" + id + "@wonderland.lit' name='Contact " + id + "' subscription='both'><group>Friends</group></item>"
+                "</query></iq>";
+        default:
+            return "<message from='room@conference.wonderland.lit/Hatter' to='alice@wonderland.lit/rabbithole' type='groupchat' id='g" + id + "'>"
+                "<body>Why is a raven like a writing-desk?\nNobody knows.</body>"
+                "<stanza-id xmlns='urn:xmpp:sid:0' by='room@conference.wonderland.lit' id='" + id + "'/>"
+                "<x xmlns='jabber:x:event'><composing/></x>"
+                "</message>";
+    }
+}
+
+static std::string createStream(int stanzaCount) {
+    std::string stream = "<?xml version='1.0'?><stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams' from='wonderland.lit' id='stream1' version='1.0'>";
+    for (int i = 0; i < stanzaCount; ++i) {
+        stream += createStanza(i);
+    }
+    return stream;
+}
+
+template<typename ParserType>
+static void benchmark(const std::string& name, const std::string& stream, size_t chunkSize) {
+    std::vector<std::string> chunks;
+    for (size_t i = 0; i < stream.size(); i += chunkSize) {
+        chunks.push_back(stream.substr(i, chunkSize));
+    }
+
+    // Best of a few runs
+    double bestSeconds = -1;
+    CountingClient client;
+    for (int run = 0; run < 5; ++run) {
+        client = CountingClient();
+        ParserType parser(&client);
+        Clock::time_point start = Clock::now();
+        for (const auto& chunk : chunks) {
+            if (!parser.parse(chunk)) {
+                std::cerr << name << ": parse error" << std::endl;
+                return;
+            }
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (bestSeconds < 0 || seconds < bestSeconds) {
+            bestSeconds = seconds;
+        }
+    }
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+        << std::setw(10) << (stream.size() / bestSeconds / (1024 * 1024)) << " MiB/s"
+        << std::setw(12) << client.events << " events"
+        << std::setw(12) << client.characters << " characters" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int stanzaCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+    size_t chunkSize = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : 4096;
+
+    std::string stream = createStream(stanzaCount);
+    std::cout << "Parsing " << stanzaCount << " stanzas (" << stream.size() / 1024 << " KiB) in chunks of " << chunkSize << " bytes" << std::endl;
+    benchmark<NativeXMLParser>("Native", stream, chunkSize);
+#ifdef HAVE_LIBXML
+    benchmark<LibXMLParser>("LibXML", stream, chunkSize);
+#endif
+#ifdef HAVE_EXPAT
+    benchmark<ExpatParser>("Expat", stream, chunkSize);
+#endif
+    return 0;
+}
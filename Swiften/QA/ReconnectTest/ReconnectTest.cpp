@@ -1,74 +1,248 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
-#include <thread>
+/*
+ * Repeatedly drops the TCP connection of a logged in client, and measures the
+ * time it takes until the client is usable again (i.e. the roster is known),
+ * both with and without XEP-0198 stream resumption. With stream resumption,
+ * every reconnect has to resume the session.
+ *
+ * Finally, checks that a client whose session can't be resumed (because
+ * another client took over its resource in the meantime) falls back to a new
+ * session and fetches the roster again.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
 
 #include <boost/bind.hpp>
 
 #include <Swiften/Client/Client.h>
-#include <Swiften/Client/ClientXMLTracer.h>
-#include <Swiften/EventLoop/EventLoop.h>
 #include <Swiften/EventLoop/SimpleEventLoop.h>
-#include <Swiften/Network/BoostIOServiceThread.h>
-#include <Swiften/Network/BoostTimer.h>
-#include <Swiften/Network/MainBoostIOServiceThread.h>
+#include <Swiften/Network/BoostNetworkFactories.h>
+#include <Swiften/Network/Connection.h>
+#include <Swiften/Network/ConnectionFactory.h>
+#include <Swiften/Network/Timer.h>
+#include <Swiften/Network/TimerFactory.h>
 #include <Swiften/Roster/GetRosterRequest.h>
 
 using namespace Swift;
 
-using namespace Swift;
+typedef std::chrono::steady_clock Clock;
+
+class DroppableConnectionFactory : public ConnectionFactory {
+    public:
+        DroppableConnectionFactory(ConnectionFactory* factory) : factory(factory) {
+        }
+
+        virtual std::shared_ptr<Connection> createConnection() override {
+            lastConnection = factory->createConnection();
+            return lastConnection;
+        }
+
+        // Closes the socket without closing the XMPP stream, as happens when the network goes away
+        void dropConnection() {
+            if (lastConnection) {
+                lastConnection->disconnect();
+            }
+        }
+
+    private:
+        ConnectionFactory* factory;
+        std::shared_ptr<Connection> lastConnection;
+};
 
-bool connecting_ = false;
-Client* client_;
-SimpleEventLoop eventLoop_;
-int count = 0;
+class DroppableNetworkFactories : public BoostNetworkFactories {
+    public:
+        DroppableNetworkFactories(EventLoop* eventLoop) : BoostNetworkFactories(eventLoop), connectionFactory(BoostNetworkFactories::getConnectionFactory()) {
+        }
+
+        virtual ConnectionFactory* getConnectionFactory() const override {
+            return &connectionFactory;
+        }
+
+        void dropConnection() {
+            connectionFactory.dropConnection();
+        }
+
+    private:
+        mutable DroppableConnectionFactory connectionFactory;
+};
 
-void handleTick(std::shared_ptr<BoostTimer> timer) {
-    std::cout << "Count " << count++ << std::endl;
-    if (timer) {
-        timer->stop();
+enum Phase {
+    WithoutResumption,
+    WithResumption,
+    FailedResumption
+};
+
+static SimpleEventLoop eventLoop;
+static DroppableNetworkFactories networkFactories(&eventLoop);
+static BoostNetworkFactories otherNetworkFactories(&eventLoop);
+
+static const int reconnectCount = 5;
+static Client* client = nullptr;
+static Client* otherClient = nullptr;
+static std::string password;
+static JID boundJID;
+static ClientOptions options;
+static Phase phase = WithoutResumption;
+static Timer::ref dropTimer;
+static bool dropping = false;
+static Clock::time_point droppedAt;
+static int reconnects = 0;
+static int resumedReconnects = 0;
+static double totalSeconds = 0;
+static bool failed = false;
+
+static void reportAndContinue() {
+    switch (phase) {
+        case WithoutResumption:
+        case WithResumption:
+            std::cout << (phase == WithResumption ? "With" : "Without") << " stream resumption: "
+                << (totalSeconds * 1000 / reconnects) << " ms to usable after a drop (average of " << reconnects << ", "
+                << resumedReconnects << " resumed)" << std::endl;
+            if (phase == WithResumption && resumedReconnects != reconnects) {
+                std::cerr << "Not all sessions were resumed" << std::endl;
+                failed = true;
+            }
+            break;
+        case FailedResumption:
+            std::cout << "Failed stream resumption: " << (totalSeconds * 1000) << " ms to usable after a drop" << std::endl;
+            if (resumedReconnects != 0) {
+                std::cerr << "Session was resumed after it was taken over" << std::endl;
+                failed = true;
+            }
+            break;
     }
-    if (connecting_) {
-        client_->disconnect();
-    } else {
-        if (count > 60) {
-            eventLoop_.stop();
-            return;
+    if (phase == FailedResumption || failed) {
+        eventLoop.stop();
+        return;
+    }
+    phase = static_cast<Phase>(phase + 1);
+    options.useStreamResumption = true;
+    reconnects = 0;
+    resumedReconnects = 0;
+    totalSeconds = 0;
+    client->connect(options);
+}
+
+static void handleDropTimerTick() {
+    dropping = true;
+    droppedAt = Clock::now();
+    networkFactories.dropConnection();
+}
+
+static void handleUsable() {
+    if (dropping) {
+        dropping = false;
+        totalSeconds += std::chrono::duration<double>(Clock::now() - droppedAt).count();
+        reconnects++;
+        if (client->isStreamResumed()) {
+            resumedReconnects++;
         }
-        client_->connect();
     }
-    connecting_ = !connecting_;
+    if (reconnects == (phase == FailedResumption ? 1 : reconnectCount)) {
+        client->disconnect();
+        return;
+    }
+    // Give the server some time to get the session settled before dropping it again
+    dropTimer = networkFactories.getTimerFactory()->createTimer(1000);
+    dropTimer->onTick.connect(&handleDropTimerTick);
+    dropTimer->start();
+}
+
+static void handleRosterReceived(std::shared_ptr<Payload>, ErrorPayload::ref error) {
+    if (error) {
+        std::cerr << "Error receiving roster" << std::endl;
+        failed = true;
+        eventLoop.stop();
+        return;
+    }
+    handleUsable();
+}
+
+static void handleConnected() {
+    boundJID = client->getJID();
+    if (client->isStreamResumed()) {
+        // The server kept our roster and presence
+        handleUsable();
+        return;
+    }
+    GetRosterRequest::ref rosterRequest = GetRosterRequest::create(client->getIQRouter());
+    rosterRequest->onResponse.connect(boost::bind(&handleRosterReceived, _1, _2));
+    rosterRequest->send();
+}
 
-    int delay = 500;
-//    int delay = 0;
-    std::shared_ptr<BoostTimer> newTimer(BoostTimer::create(delay, &MainBoostIOServiceThread::getInstance().getIOService()));
-    newTimer->onTick.connect(boost::bind(&handleTick, timer));
-    newTimer->start();
+static void handleOtherClientConnected() {
+    otherClient->disconnect();
+}
+
+static void handleOtherClientDisconnected(boost::optional<ClientError> error) {
+    if (error) {
+        std::cerr << "Other client disconnected: " << error->getType() << std::endl;
+        failed = true;
+        eventLoop.stop();
+        return;
+    }
+    client->connect(options);
+}
+
+static void handleDisconnected(boost::optional<ClientError> error) {
+    if (dropping && phase == FailedResumption) {
+        // Take over the resource of the dropped session, so that the server discards it
+        otherClient = new Swift::Client(boundJID, password, &otherNetworkFactories);
+        otherClient->onConnected.connect(&handleOtherClientConnected);
+        otherClient->onDisconnected.connect(boost::bind(&handleOtherClientDisconnected, _1));
+        otherClient->setAlwaysTrustCertificates();
+        otherClient->connect();
+    }
+    else if (dropping) {
+        client->connect(options);
+    }
+    else if (error) {
+        std::cerr << "Disconnected: " << error->getType() << std::endl;
+        failed = true;
+        eventLoop.stop();
+    }
+    else {
+        reportAndContinue();
+    }
 }
 
 int main(int, char**) {
-    char* jidChars = getenv("SWIFT_CLIENTTEST_JID");
-    if (!jidChars) {
+    char* jid = getenv("SWIFT_CLIENTTEST_JID");
+    if (!jid) {
         std::cerr << "Please set the SWIFT_CLIENTTEST_JID environment variable" << std::endl;
         return -1;
     }
-    char* passChars = getenv("SWIFT_CLIENTTEST_PASS");
-    if (!passChars) {
+    char* pass = getenv("SWIFT_CLIENTTEST_PASS");
+    if (!pass) {
         std::cerr << "Please set the SWIFT_CLIENTTEST_PASS environment variable" << std::endl;
         return -1;
     }
 
-    JID jid(jidChars);
-    std::string pass(passChars);
+    password = pass;
+    client = new Swift::Client(JID(jid), password, &networkFactories);
+    client->onConnected.connect(&handleConnected);
+    client->onDisconnected.connect(boost::bind(&handleDisconnected, _1));
+    client->setAlwaysTrustCertificates();
+    options.useStreamResumption = false;
+    client->connect(options);
 
-    client_ = new Swift::Client(jid, pass);
-    handleTick(std::shared_ptr<BoostTimer>());
-    eventLoop_.run();
+    {
+        Timer::ref timer = networkFactories.getTimerFactory()->createTimer(5 * 60 * 1000);
+        timer->onTick.connect(boost::bind(&SimpleEventLoop::stop, &eventLoop));
+        timer->start();
 
-    delete client_;
-    return 0;
+        eventLoop.run();
+    }
 
+    dropTimer.reset();
+    delete otherClient;
+    delete client;
+    return failed;
 }
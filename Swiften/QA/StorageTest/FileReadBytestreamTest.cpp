@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,7 +7,13 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
+#include <boost/bind.hpp>
+
+#include <Swiften/Base/Algorithm.h>
 #include <Swiften/Base/ByteArray.h>
+#include <Swiften/Base/sleep.h>
+#include <Swiften/EventLoop/DummyEventLoop.h>
+#include <Swiften/FileTransfer/BytestreamException.h>
 #include <Swiften/FileTransfer/FileReadBytestream.h>
 
 #include <SwifTools/Application/PlatformApplicationPathProvider.h>
@@ -20,14 +26,22 @@ class FileReadBytestreamTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testRead_Twice);
         CPPUNIT_TEST(testIsFinished_NotFinished);
         CPPUNIT_TEST(testIsFinished_IsFinished);
+        CPPUNIT_TEST(testRead_ReadAhead);
+        CPPUNIT_TEST(testRead_ReadAheadUntilFinished);
+        CPPUNIT_TEST(testRead_ReadAheadNonExistingFile);
         CPPUNIT_TEST_SUITE_END();
 
     public:
         void setUp() {
             pathProvider = new PlatformApplicationPathProvider("FileReadBytestreamTest");
+            eventLoop = new DummyEventLoop();
+            worker = std::make_shared<FileIOWorker>(eventLoop);
+            dataAvailable = false;
         }
 
         void tearDown() {
+            worker.reset();
+            delete eventLoop;
             delete pathProvider;
         }
 
@@ -59,17 +73,78 @@ class FileReadBytestreamTest : public CppUnit::TestFixture {
         void testIsFinished_IsFinished() {
             std::shared_ptr<FileReadBytestream> testling(createTestling());
 
-            testling->read(4096);
+            testling->read(65536);
 
             CPPUNIT_ASSERT(testling->isFinished());
         }
 
+        void testRead_ReadAhead() {
+            std::shared_ptr<FileReadBytestream> testling(createReadAheadTestling(16));
+
+            std::shared_ptr< std::vector<unsigned char> > result1 = readNonEmpty(testling, 10);
+            std::shared_ptr< std::vector<unsigned char> > result2 = readNonEmpty(testling, 10);
+            std::shared_ptr< std::vector<unsigned char> > result3 = readNonEmpty(testling, 10);
+
+            CPPUNIT_ASSERT_EQUAL(std::string("/*\n * Copy"), byteArrayToString(*result1));
+            CPPUNIT_ASSERT_EQUAL(std::string("right "), byteArrayToString(*result2));
+            CPPUNIT_ASSERT_EQUAL(std::string("(c) 2010-2"), byteArrayToString(*result3));
+            CPPUNIT_ASSERT(!testling->isFinished());
+        }
+
+        void testRead_ReadAheadUntilFinished() {
+            std::shared_ptr<FileReadBytestream> testling(createReadAheadTestling(1024));
+            ByteArray expected;
+            readByteArrayFromFile(expected, pathProvider->getExecutableDir() / "FileReadBytestreamTest.cpp");
+
+            ByteArray result;
+            while (!testling->isFinished()) {
+                std::shared_ptr< std::vector<unsigned char> > data = readNonEmpty(testling, 100);
+                append(result, *data);
+            }
+
+            CPPUNIT_ASSERT(expected == result);
+        }
+
+        void testRead_ReadAheadNonExistingFile() {
+            std::shared_ptr<FileReadBytestream> testling(new FileReadBytestream(pathProvider->getExecutableDir() / "NonExistingFile", worker));
+
+            CPPUNIT_ASSERT_THROW(readNonEmpty(testling, 10), BytestreamException);
+        }
+
     private:
+        std::shared_ptr< std::vector<unsigned char> > readNonEmpty(std::shared_ptr<FileReadBytestream> testling, size_t size) {
+            boost::signals2::scoped_connection connection = testling->onDataAvailable.connect(boost::bind(&FileReadBytestreamTest::handleDataAvailable, this));
+            for (int i = 0; i < 1000; ++i) {
+                std::shared_ptr< std::vector<unsigned char> > result = testling->read(size);
+                if (!result->empty() || testling->isFinished()) {
+                    return result;
+                }
+                dataAvailable = false;
+                for (int j = 0; j < 1000 && !dataAvailable; ++j) {
+                    Swift::sleep(1);
+                    eventLoop->processEvents();
+                }
+            }
+            CPPUNIT_FAIL("No data available");
+            return std::shared_ptr< std::vector<unsigned char> >();
+        }
+
+        void handleDataAvailable() {
+            dataAvailable = true;
+        }
+
+        FileReadBytestream* createReadAheadTestling(size_t readAheadSize) {
+            return new FileReadBytestream(pathProvider->getExecutableDir() / "FileReadBytestreamTest.cpp", worker, readAheadSize);
+        }
+
         FileReadBytestream* createTestling() {
             return new FileReadBytestream(pathProvider->getExecutableDir() / "FileReadBytestreamTest.cpp");
         }
 
         PlatformApplicationPathProvider* pathProvider;
+        DummyEventLoop* eventLoop;
+        FileIOWorker::ref worker;
+        bool dataAvailable;
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(FileReadBytestreamTest);
@@ -1,17 +1,23 @@
 /*
- * Copyright (c) 2016 Isode Limited.
+ * Copyright (c) 2016-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
+#include <chrono>
+#include <thread>
+
 #include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
 #include <boost/signals2.hpp>
 
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
 #include <Swiften/Base/ByteArray.h>
+#include <Swiften/EventLoop/DummyEventLoop.h>
+#include <Swiften/FileTransfer/FileIOWorker.h>
 #include <Swiften/FileTransfer/FileWriteBytestream.h>
 
 using namespace Swift;
@@ -20,11 +26,23 @@ class FileWriteBytestreamTest : public CppUnit::TestFixture {
         CPPUNIT_TEST_SUITE(FileWriteBytestreamTest);
         CPPUNIT_TEST(testSuccessfulWrite);
         CPPUNIT_TEST(testFailingWrite);
+        CPPUNIT_TEST(testSuccessfulWrite_WriteBehind);
+        CPPUNIT_TEST(testFailingWrite_WriteBehind);
+        CPPUNIT_TEST(testNotWritable_WriteBehind);
+        CPPUNIT_TEST(testSuccessfulWrite_ExpectedSizeAndSync);
         CPPUNIT_TEST_SUITE_END();
 
     public:
         void setUp() {
             onWriteWasCalled = false;
+            errorReported = false;
+            writableReported = false;
+            closed = boost::optional<bool>();
+            worker = std::make_shared<FileIOWorker>(&eventLoop);
+        }
+
+        void tearDown() {
+            worker.reset();
         }
 
         void testSuccessfulWrite() {
@@ -46,13 +64,118 @@ class FileWriteBytestreamTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(false, onWriteWasCalled);
         }
 
+        void testSuccessfulWrite_WriteBehind() {
+            boost::filesystem::path filename = boost::filesystem::unique_path("write_file_bytestream_test_%%%%%%%%%%%%%%%%.bin");
+            std::shared_ptr<FileWriteBytestream> writeBytestream = std::make_shared<FileWriteBytestream>(filename, worker, 8);
+            writeBytestream->onWrite.connect(boost::bind(&FileWriteBytestreamTest::handleOnWrite, this, _1));
+
+            CPPUNIT_ASSERT_EQUAL(true, writeBytestream->write(createByteArray("Some data.")));
+            CPPUNIT_ASSERT_EQUAL(true, writeBytestream->write(createByteArray(" Some")));
+            CPPUNIT_ASSERT_EQUAL(true, writeBytestream->write(createByteArray(" more.")));
+            CPPUNIT_ASSERT_EQUAL(true, onWriteWasCalled);
+            writeBytestream->onClosed.connect(boost::bind(&FileWriteBytestreamTest::handleClosed, this, _1));
+            writeBytestream->close();
+            processEventsUntilClosed();
+
+            CPPUNIT_ASSERT(closed);
+            CPPUNIT_ASSERT(!*closed);
+            ByteArray result;
+            readByteArrayFromFile(result, filename);
+            CPPUNIT_ASSERT_EQUAL(std::string("Some data. Some more."), byteArrayToString(result));
+            boost::filesystem::remove(filename);
+        }
+
+        void testFailingWrite_WriteBehind() {
+            std::shared_ptr<FileWriteBytestream> writeBytestream = std::make_shared<FileWriteBytestream>("", worker, 4);
+            writeBytestream->onError.connect(boost::bind(&FileWriteBytestreamTest::handleError, this));
+            writeBytestream->onClosed.connect(boost::bind(&FileWriteBytestreamTest::handleClosed, this, _1));
+
+            writeBytestream->write(createByteArray("Some data."));
+            processEventsUntil(errorReported);
+
+            CPPUNIT_ASSERT(errorReported);
+            CPPUNIT_ASSERT_EQUAL(false, writeBytestream->write(createByteArray("Even more data.")));
+
+            writeBytestream->close();
+            processEventsUntilClosed();
+
+            CPPUNIT_ASSERT(closed);
+            CPPUNIT_ASSERT(*closed);
+        }
+
+        void testNotWritable_WriteBehind() {
+            boost::filesystem::path filename = boost::filesystem::unique_path("write_file_bytestream_test_%%%%%%%%%%%%%%%%.bin");
+            std::shared_ptr<FileWriteBytestream> writeBytestream = std::make_shared<FileWriteBytestream>(filename, worker, 4);
+            writeBytestream->onWritable.connect(boost::bind(&FileWriteBytestreamTest::handleWritable, this));
+            writeBytestream->onClosed.connect(boost::bind(&FileWriteBytestreamTest::handleClosed, this, _1));
+
+            writeBytestream->write(createByteArray("Some data."));
+            CPPUNIT_ASSERT(writeBytestream->isWritable());
+            writeBytestream->write(createByteArray("Some more data."));
+            CPPUNIT_ASSERT(!writeBytestream->isWritable());
+
+            processEventsUntil(writableReported);
+
+            CPPUNIT_ASSERT(writableReported);
+            CPPUNIT_ASSERT(writeBytestream->isWritable());
+            writeBytestream->close();
+            processEventsUntilClosed();
+            boost::filesystem::remove(filename);
+        }
+
+        void testSuccessfulWrite_ExpectedSizeAndSync() {
+            boost::filesystem::path filename = boost::filesystem::unique_path("write_file_bytestream_test_%%%%%%%%%%%%%%%%.bin");
+            std::shared_ptr<FileWriteBytestream> writeBytestream = std::make_shared<FileWriteBytestream>(filename, worker);
+            writeBytestream->setExpectedSize(1024*1024);
+            writeBytestream->setSyncPolicy(FileWriteBytestream::SyncOnClose);
+
+            CPPUNIT_ASSERT_EQUAL(true, writeBytestream->write(createByteArray("Some data.")));
+            writeBytestream->onClosed.connect(boost::bind(&FileWriteBytestreamTest::handleClosed, this, _1));
+            writeBytestream->close();
+            processEventsUntilClosed();
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<boost::uintmax_t>(10), boost::filesystem::file_size(filename));
+            boost::filesystem::remove(filename);
+        }
 
         void handleOnWrite(const std::vector<unsigned char>& /*data*/) {
             onWriteWasCalled = true;
         }
 
+        void handleError() {
+            errorReported = true;
+        }
+
+        void handleClosed(bool error) {
+            closed = error;
+        }
+
+        void handleWritable() {
+            writableReported = true;
+        }
+
+    private:
+        void processEventsUntil(const bool& condition) {
+            for (int i = 0; i < 1000 && !condition; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                eventLoop.processEvents();
+            }
+        }
+
+        void processEventsUntilClosed() {
+            for (int i = 0; i < 1000 && !closed; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                eventLoop.processEvents();
+            }
+        }
+
     private:
         bool onWriteWasCalled;
+        bool errorReported;
+        bool writableReported;
+        boost::optional<bool> closed;
+        DummyEventLoop eventLoop;
+        FileIOWorker::ref worker;
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(FileWriteBytestreamTest);
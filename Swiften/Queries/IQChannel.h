@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,6 +12,7 @@
 #include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Elements/IQ.h>
 
 namespace Swift {
@@ -24,6 +25,6 @@ namespace Swift {
 
             virtual bool isAvailable() const = 0;
 
-            boost::signals2::signal<void (std::shared_ptr<IQ>)> onIQReceived;
+            Signal<void (std::shared_ptr<IQ>)> onIQReceived;
     };
 }
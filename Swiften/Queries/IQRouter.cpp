@@ -1,15 +1,19 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Queries/IQRouter.h>
 
+#include <cassert>
+
 #include <boost/bind.hpp>
 
 #include <Swiften/Base/Algorithm.h>
 #include <Swiften/Elements/ErrorPayload.h>
+#include <Swiften/Network/Timer.h>
+#include <Swiften/Network/TimerFactory.h>
 #include <Swiften/Queries/IQChannel.h>
 #include <Swiften/Queries/IQHandler.h>
 
@@ -17,11 +21,15 @@ namespace Swift {
 
 static void noop(IQHandler*) {}
 
-IQRouter::IQRouter(IQChannel* channel) : channel_(channel), queueRemoves_(false) {
+IQRouter::IQRouter(IQChannel* channel) : channel_(channel), queueRemoves_(false), timerResolution_(0), timerRunning_(false), ticks_(0) {
     channel->onIQReceived.connect(boost::bind(&IQRouter::handleIQ, this, _1));
 }
 
 IQRouter::~IQRouter() {
+    if (timer_) {
+        timer_->stop();
+        timer_->onTick.disconnect(boost::bind(&IQRouter::handleTimerTick, this));
+    }
     channel_->onIQReceived.disconnect(boost::bind(&IQRouter::handleIQ, this, _1));
 }
 
@@ -33,13 +41,18 @@ void IQRouter::handleIQ(std::shared_ptr<IQ> iq) {
     queueRemoves_ = true;
 
     bool handled = false;
-    // Go through the handlers in reverse order, to give precedence to the last added handler
-    std::vector<std::shared_ptr<IQHandler> >::const_reverse_iterator i = handlers_.rbegin();
-    std::vector<std::shared_ptr<IQHandler> >::const_reverse_iterator rend = handlers_.rend();
-    for (; i != rend; ++i) {
-        handled |= (*i)->handleIQ(iq);
-        if (handled) {
-            break;
+    if (iq->getType() == IQ::Result || iq->getType() == IQ::Error) {
+        handled = handleResponse(iq);
+    }
+    if (!handled) {
+        // Go through the handlers in reverse order, to give precedence to the last added handler
+        std::vector<std::shared_ptr<IQHandler> >::const_reverse_iterator i = handlers_.rbegin();
+        std::vector<std::shared_ptr<IQHandler> >::const_reverse_iterator rend = handlers_.rend();
+        for (; i != rend; ++i) {
+            handled |= (*i)->handleIQ(iq);
+            if (handled) {
+                break;
+            }
         }
     }
     if (!handled && (iq->getType() == IQ::Get || iq->getType() == IQ::Set) ) {
@@ -51,6 +64,21 @@ void IQRouter::handleIQ(std::shared_ptr<IQ> iq) {
     queueRemoves_ = false;
 }
 
+bool IQRouter::handleResponse(std::shared_ptr<IQ> iq) {
+    std::unordered_map<std::string, std::vector<ResponseHandler> >::const_iterator i = responseHandlers_.find(iq->getID());
+    if (i == responseHandlers_.end()) {
+        return false;
+    }
+    // Work on a copy, since handlers remove themselves when handling the response
+    std::vector<ResponseHandler> candidates(i->second);
+    for (std::vector<ResponseHandler>::const_reverse_iterator j = candidates.rbegin(); j != candidates.rend(); ++j) {
+        if (j->handler->handleIQ(iq)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void IQRouter::processPendingRemoves() {
     for (auto&& handler : queuedRemoves_) {
         erase(handlers_, handler);
@@ -79,6 +107,102 @@ void IQRouter::removeHandler(std::shared_ptr<IQHandler> handler) {
     }
 }
 
+void IQRouter::addResponseHandler(const std::string& id, IQHandler* handler, const JID& sender, int timeoutMilliseconds) {
+    addResponseHandler(id, std::shared_ptr<IQHandler>(handler, noop), sender, timeoutMilliseconds);
+}
+
+void IQRouter::addResponseHandler(const std::string& id, std::shared_ptr<IQHandler> handler, const JID& sender, int timeoutMilliseconds) {
+    ResponseHandler responseHandler;
+    responseHandler.handler = handler;
+    responseHandler.sender = sender;
+    responseHandler.deadline = 0;
+    if (timer_ && timeoutMilliseconds > 0) {
+        // A running timer may tick before a full period has passed, so wait one more tick
+        unsigned long long timeoutTicks = static_cast<unsigned long long>((timeoutMilliseconds + timerResolution_ - 1) / timerResolution_);
+        responseHandler.deadline = ticks_ + timeoutTicks + (timerRunning_ ? 1 : 0);
+        timeouts_.insert(std::make_pair(responseHandler.deadline, std::make_pair(id, handler.get())));
+        if (!timerRunning_) {
+            timerRunning_ = true;
+            timer_->start();
+        }
+    }
+    responseHandlers_[id].push_back(responseHandler);
+}
+
+void IQRouter::removeResponseHandler(const std::string& id, IQHandler* handler) {
+    std::unordered_map<std::string, std::vector<ResponseHandler> >::iterator i = responseHandlers_.find(id);
+    if (i == responseHandlers_.end()) {
+        return;
+    }
+    std::vector<ResponseHandler>& handlers = i->second;
+    for (std::vector<ResponseHandler>::iterator j = handlers.begin(); j != handlers.end(); ++j) {
+        if (j->handler.get() == handler) {
+            if (j->deadline) {
+                auto timeouts = timeouts_.equal_range(j->deadline);
+                for (auto k = timeouts.first; k != timeouts.second; ++k) {
+                    if (k->second.second == handler && k->second.first == id) {
+                        timeouts_.erase(k);
+                        break;
+                    }
+                }
+            }
+            handlers.erase(j);
+            break;
+        }
+    }
+    if (handlers.empty()) {
+        responseHandlers_.erase(i);
+    }
+}
+
+void IQRouter::setTimerFactory(TimerFactory* timerFactory, int resolutionMilliseconds) {
+    assert(resolutionMilliseconds > 0);
+    if (timer_) {
+        timer_->stop();
+        timer_->onTick.disconnect(boost::bind(&IQRouter::handleTimerTick, this));
+        timerRunning_ = false;
+    }
+    timerResolution_ = resolutionMilliseconds;
+    timer_ = timerFactory->createTimer(resolutionMilliseconds);
+    timer_->onTick.connect(boost::bind(&IQRouter::handleTimerTick, this));
+    if (!timeouts_.empty()) {
+        timerRunning_ = true;
+        timer_->start();
+    }
+}
+
+void IQRouter::handleTimerTick() {
+    ++ticks_;
+    std::vector<std::pair<std::string, ResponseHandler> > expired;
+    while (!timeouts_.empty() && timeouts_.begin()->first <= ticks_) {
+        const std::string& id = timeouts_.begin()->second.first;
+        std::unordered_map<std::string, std::vector<ResponseHandler> >::const_iterator i = responseHandlers_.find(id);
+        if (i != responseHandlers_.end()) {
+            for (const auto& responseHandler : i->second) {
+                if (responseHandler.handler.get() == timeouts_.begin()->second.second) {
+                    expired.push_back(std::make_pair(id, responseHandler));
+                    break;
+                }
+            }
+        }
+        timeouts_.erase(timeouts_.begin());
+    }
+
+    for (const auto& responseHandler : expired) {
+        std::shared_ptr<IQ> error = IQ::createError(jid_, responseHandler.second.sender, responseHandler.first, ErrorPayload::RemoteServerTimeout, ErrorPayload::Wait);
+        if (!responseHandler.second.handler->handleIQ(error)) {
+            removeResponseHandler(responseHandler.first, responseHandler.second.handler.get());
+        }
+    }
+
+    if (timeouts_.empty()) {
+        timerRunning_ = false;
+    }
+    else {
+        timer_->start();
+    }
+}
+
 void IQRouter::sendIQ(std::shared_ptr<IQ> iq) {
     if (from_.isValid() && !iq->getFrom().isValid()) {
         iq->setFrom(from_);
@@ -1,13 +1,15 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <Swiften/Base/API.h>
@@ -16,6 +18,8 @@
 namespace Swift {
     class IQChannel;
     class IQHandler;
+    class Timer;
+    class TimerFactory;
 
     class SWIFTEN_API IQRouter {
         public:
@@ -52,6 +56,30 @@ namespace Swift {
             void addHandler(std::shared_ptr<IQHandler> handler);
             void removeHandler(std::shared_ptr<IQHandler> handler);
 
+            /**
+             * Adds a handler for the response to the IQ with the given ID.
+             *
+             * Incoming results and errors are looked up by ID, and
+             * offered to the response handlers for that ID before any
+             * of the regular handlers.
+             *
+             * If a timeout is given and a timer factory is set, the
+             * handler gets a remote-server-timeout error from \p sender
+             * when no response has been handled after the timeout.
+             * Handlers must remove themselves once they handled a response.
+             */
+            void addResponseHandler(const std::string& id, IQHandler* handler, const JID& sender = JID(), int timeoutMilliseconds = 0);
+            void addResponseHandler(const std::string& id, std::shared_ptr<IQHandler> handler, const JID& sender = JID(), int timeoutMilliseconds = 0);
+            void removeResponseHandler(const std::string& id, IQHandler* handler);
+
+            /**
+             * Sets the timer factory used for response timeouts.
+             *
+             * All timeouts share a single timer, which ticks every
+             * \p resolutionMilliseconds while timeouts are pending.
+             */
+            void setTimerFactory(TimerFactory* timerFactory, int resolutionMilliseconds = 1000);
+
             /**
              * Sends an IQ stanza.
              *
@@ -75,8 +103,16 @@ namespace Swift {
             }
 
         private:
+            struct ResponseHandler {
+                std::shared_ptr<IQHandler> handler;
+                JID sender;
+                unsigned long long deadline;
+            };
+
             void handleIQ(std::shared_ptr<IQ> iq);
+            bool handleResponse(std::shared_ptr<IQ> iq);
             void processPendingRemoves();
+            void handleTimerTick();
 
         private:
             IQChannel* channel_;
@@ -85,5 +121,11 @@ namespace Swift {
             std::vector< std::shared_ptr<IQHandler> > handlers_;
             std::vector< std::shared_ptr<IQHandler> > queuedRemoves_;
             bool queueRemoves_;
+            std::unordered_map<std::string, std::vector<ResponseHandler> > responseHandlers_;
+            std::multimap<unsigned long long, std::pair<std::string, IQHandler*> > timeouts_;
+            std::shared_ptr<Timer> timer_;
+            int timerResolution_;
+            bool timerRunning_;
+            unsigned long long ticks_;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -40,6 +40,18 @@ namespace Swift {
                 return id_;
             }
 
+            /**
+             * Sets the time to wait for a response.
+             *
+             * If no response arrives in time, the request gets a
+             * remote-server-timeout error. This only has an effect when
+             * the router has a timer factory, and must be called before
+             * send(). By default, a request waits indefinitely.
+             */
+            void setTimeout(int milliseconds) {
+                timeoutMilliseconds_ = milliseconds;
+            }
+
 
         protected:
             /**
@@ -104,5 +116,6 @@ namespace Swift {
             std::shared_ptr<Payload> payload_;
             std::string id_;
             bool sent_;
+            int timeoutMilliseconds_;
     };
 }
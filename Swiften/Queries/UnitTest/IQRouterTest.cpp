@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -28,6 +28,8 @@ class IQRouterTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testSendIQ_WithFrom);
         CPPUNIT_TEST(testSendIQ_WithoutFrom);
         CPPUNIT_TEST(testHandleIQ_WithFrom);
+        CPPUNIT_TEST(testHandleIQ_ResponseHandler);
+        CPPUNIT_TEST(testHandleIQ_ResponseHandlerIgnoresRequests);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -138,6 +140,31 @@ class IQRouterTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(JID("foo@bar.com/baz"), channel_->iqs_[0]->getFrom());
         }
 
+        void testHandleIQ_ResponseHandler() {
+            IQRouter testling(channel_);
+            DummyIQHandler handler(true, &testling);
+            ResponseIQHandler responseHandler1("id-1", &testling);
+            ResponseIQHandler responseHandler2("id-2", &testling);
+
+            channel_->onIQReceived(IQ::createResult(JID(), "id-2"));
+            channel_->onIQReceived(IQ::createResult(JID(), "id-2"));
+
+            CPPUNIT_ASSERT_EQUAL(0, responseHandler1.called);
+            CPPUNIT_ASSERT_EQUAL(1, responseHandler2.called);
+            CPPUNIT_ASSERT_EQUAL(1, handler.called);
+        }
+
+        void testHandleIQ_ResponseHandlerIgnoresRequests() {
+            IQRouter testling(channel_);
+            DummyIQHandler handler(true, &testling);
+            ResponseIQHandler responseHandler("id-1", &testling);
+
+            channel_->onIQReceived(IQ::createRequest(IQ::Get, JID(), "id-1", std::shared_ptr<Payload>()));
+
+            CPPUNIT_ASSERT_EQUAL(0, responseHandler.called);
+            CPPUNIT_ASSERT_EQUAL(1, handler.called);
+        }
+
     private:
         struct DummyIQHandler : public IQHandler {
             DummyIQHandler(bool handle, IQRouter* router) : handle(handle), router(router), called(0) {
@@ -171,6 +198,20 @@ class IQRouterTest : public CppUnit::TestFixture {
             int called;
         };
 
+        struct ResponseIQHandler : public IQHandler {
+            ResponseIQHandler(const std::string& id, IQRouter* router) : id(id), router(router), called(0) {
+                router->addResponseHandler(id, this);
+            }
+
+            virtual bool handleIQ(std::shared_ptr<IQ>) {
+                called++;
+                router->removeResponseHandler(id, this);
+                return true;
+            }
+            std::string id;
+            IQRouter* router;
+            int called;
+        };
 
         DummyIQChannel* channel_;
 };
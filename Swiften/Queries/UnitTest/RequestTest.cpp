@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,6 +13,7 @@
 
 #include <Swiften/Elements/Payload.h>
 #include <Swiften/Elements/RawXMLPayload.h>
+#include <Swiften/Network/DummyTimerFactory.h>
 #include <Swiften/Queries/DummyIQChannel.h>
 #include <Swiften/Queries/GenericRequest.h>
 #include <Swiften/Queries/IQRouter.h>
@@ -39,6 +40,8 @@ class RequestTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testHandleIQ_ServerRespondsWithBareJID);
         CPPUNIT_TEST(testHandleIQ_ServerRespondsWithoutFrom);
         CPPUNIT_TEST(testHandleIQ_ServerRespondsWithFullJID);
+        CPPUNIT_TEST(testTimeout);
+        CPPUNIT_TEST(testTimeout_ResponseBeforeTimeout);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -313,6 +316,46 @@ class RequestTest : public CppUnit::TestFixture {
         }
 
 
+        void testTimeout() {
+            DummyTimerFactory timerFactory;
+            router_->setTimerFactory(&timerFactory);
+            MyRequest testling(IQ::Get, JID("foo@bar.com/baz"), payload_, router_);
+            testling.onResponse.connect(boost::bind(&RequestTest::handleResponse, this, _1, _2));
+            testling.setTimeout(3000);
+            testling.send();
+
+            timerFactory.setTime(1000);
+            timerFactory.setTime(2000);
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(receivedErrors.size()));
+            timerFactory.setTime(3000);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(receivedErrors.size()));
+            CPPUNIT_ASSERT_EQUAL(ErrorPayload::RemoteServerTimeout, receivedErrors[0].getCondition());
+
+            channel_->onIQReceived(createResponse(JID("foo@bar.com/baz"),"test-id"));
+            timerFactory.setTime(4000);
+            CPPUNIT_ASSERT_EQUAL(0, responsesReceived_);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(receivedErrors.size()));
+        }
+
+        void testTimeout_ResponseBeforeTimeout() {
+            DummyTimerFactory timerFactory;
+            router_->setTimerFactory(&timerFactory);
+            MyRequest testling(IQ::Get, JID("foo@bar.com/baz"), payload_, router_);
+            testling.onResponse.connect(boost::bind(&RequestTest::handleResponse, this, _1, _2));
+            testling.setTimeout(3000);
+            testling.send();
+
+            timerFactory.setTime(1000);
+            channel_->onIQReceived(createResponse(JID("foo@bar.com/baz"),"test-id"));
+            timerFactory.setTime(2000);
+            timerFactory.setTime(3000);
+            timerFactory.setTime(4000);
+
+            CPPUNIT_ASSERT_EQUAL(1, responsesReceived_);
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(receivedErrors.size()));
+        }
+
+
 
     private:
         void handleResponse(std::shared_ptr<Payload> p, ErrorPayload::ref e) {
@@ -1,14 +1,44 @@
 /*
- * Copyright (c) 2011 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Roster/RosterStorage.h>
 
+#include <set>
+
 namespace Swift {
 
 RosterStorage::~RosterStorage() {
 }
 
+void RosterStorage::applyRosterPush(std::shared_ptr<RosterPayload> push) {
+    std::shared_ptr<RosterPayload> storedRoster = getRoster();
+    if (!storedRoster) {
+        return;
+    }
+
+    std::set<JID> pushedJIDs;
+    for (const auto& item : push->getItems()) {
+        pushedJIDs.insert(item.getJID());
+    }
+
+    std::shared_ptr<RosterPayload> roster = std::make_shared<RosterPayload>();
+    if (push->getVersion()) {
+        roster->setVersion(*push->getVersion());
+    }
+    for (const auto& item : storedRoster->getItems()) {
+        if (pushedJIDs.find(item.getJID()) == pushedJIDs.end()) {
+            roster->addItem(item);
+        }
+    }
+    for (const auto& item : push->getItems()) {
+        if (item.getSubscription() != RosterItemPayload::Remove) {
+            roster->addItem(item);
+        }
+    }
+    setRoster(roster);
+}
+
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -18,5 +18,17 @@ namespace Swift {
 
             virtual std::shared_ptr<RosterPayload> getRoster() const = 0;
             virtual void setRoster(std::shared_ptr<RosterPayload>) = 0;
+
+            /**
+             * Applies the items of a roster push to the stored roster (items
+             * with subscription Remove are removed), and updates the version
+             * of the stored roster to that of the push. Nothing is stored if
+             * there is no stored roster yet, as the push alone is not a
+             * complete roster.
+             *
+             * The default implementation replaces the whole roster with
+             * setRoster().
+             */
+            virtual void applyRosterPush(std::shared_ptr<RosterPayload> push);
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -21,6 +21,31 @@
 
 using namespace Swift;
 
+class CountingRosterStorage : public RosterMemoryStorage {
+    public:
+        CountingRosterStorage() : setRosterCount(0), pushCount(0), applyingPush(false) {}
+
+        virtual void setRoster(std::shared_ptr<RosterPayload> roster) {
+            if (!applyingPush) {
+                setRosterCount++;
+            }
+            RosterMemoryStorage::setRoster(roster);
+        }
+
+        virtual void applyRosterPush(std::shared_ptr<RosterPayload> push) {
+            pushCount++;
+            applyingPush = true;
+            RosterMemoryStorage::applyRosterPush(push);
+            applyingPush = false;
+        }
+
+        int setRosterCount;
+        int pushCount;
+
+    private:
+        bool applyingPush;
+};
+
 class XMPPRosterControllerTest : public CppUnit::TestFixture {
         CPPUNIT_TEST_SUITE(XMPPRosterControllerTest);
         CPPUNIT_TEST(testGet_Response);
@@ -36,6 +61,8 @@ class XMPPRosterControllerTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testModify);
         CPPUNIT_TEST(testRemove);
         CPPUNIT_TEST(testRemove_RosterStorageUpdated);
+        CPPUNIT_TEST(testPush_RosterStorageUpdatedWithPush);
+        CPPUNIT_TEST(testPush_NoRosterInStorage);
         CPPUNIT_TEST(testMany);
         CPPUNIT_TEST_SUITE_END();
 
@@ -277,6 +304,42 @@ class XMPPRosterControllerTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(rosterStorage_->getRoster()->getItem(jid2_));
         }
 
+        void testPush_RosterStorageUpdatedWithPush() {
+            CountingRosterStorage storage;
+            XMPPRosterController testling(router_, xmppRoster_, &storage);
+            testling.setUseVersioning(true);
+            testling.requestRoster();
+            std::shared_ptr<RosterPayload> serverRoster(new RosterPayload());
+            serverRoster->setVersion("version10");
+            serverRoster->addItem(RosterItemPayload(jid1_, "Bob", RosterItemPayload::Both));
+            channel_->onIQReceived(IQ::createResult("foo@bar.com", channel_->sentStanzas[0]->getID(), serverRoster));
+
+            std::shared_ptr<RosterPayload> payload(new RosterPayload());
+            payload->setVersion("version11");
+            payload->addItem(RosterItemPayload(jid2_, "Alice", RosterItemPayload::Both));
+            channel_->onIQReceived(IQ::createRequest(IQ::Set, JID(), "id2", payload));
+
+            CPPUNIT_ASSERT_EQUAL(1, storage.setRosterCount);
+            CPPUNIT_ASSERT_EQUAL(1, storage.pushCount);
+            CPPUNIT_ASSERT_EQUAL(std::string("version11"), *storage.getRoster()->getVersion());
+            CPPUNIT_ASSERT(storage.getRoster()->getItem(jid1_));
+            CPPUNIT_ASSERT(storage.getRoster()->getItem(jid2_));
+        }
+
+        void testPush_NoRosterInStorage() {
+            CountingRosterStorage storage;
+            XMPPRosterController testling(router_, xmppRoster_, &storage);
+            testling.setUseVersioning(true);
+
+            std::shared_ptr<RosterPayload> payload(new RosterPayload());
+            payload->setVersion("version11");
+            payload->addItem(RosterItemPayload(jid2_, "Alice", RosterItemPayload::Both));
+            channel_->onIQReceived(IQ::createRequest(IQ::Set, JID(), "id2", payload));
+
+            CPPUNIT_ASSERT_EQUAL(1, storage.pushCount);
+            CPPUNIT_ASSERT(!storage.getRoster());
+        }
+
         void testMany() {
             XMPPRosterController controller(router_, xmppRoster_, rosterStorage_);
             std::shared_ptr<RosterPayload> payload1(new RosterPayload());
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -74,7 +74,13 @@ void XMPPRosterController::handleRosterReceived(std::shared_ptr<RosterPayload> r
         xmppRoster_->onInitialRosterPopulated();
     }
     if (rosterPayload && rosterPayload->getVersion() && useVersioning) {
-        saveRoster(*rosterPayload->getVersion());
+        if (initial) {
+            saveRoster(*rosterPayload->getVersion());
+        }
+        else {
+            // Only store what changed, instead of rewriting the whole roster on every push
+            rosterStorage_->applyRosterPush(rosterPayload);
+        }
     }
 }
 
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Elements/ClientStateIndication.h>
+#include <Swiften/Serializer/GenericElementSerializer.h>
+#include <Swiften/Serializer/XML/XMLElement.h>
+
+namespace Swift {
+    class SWIFTEN_API ClientStateIndicationSerializer : public GenericElementSerializer<ClientStateIndication> {
+        public:
+            ClientStateIndicationSerializer() : GenericElementSerializer<ClientStateIndication>() {
+            }
+
+            virtual SafeByteArray serialize(std::shared_ptr<ToplevelElement> element) const {
+                std::shared_ptr<ClientStateIndication> indication(std::dynamic_pointer_cast<ClientStateIndication>(element));
+                std::string tag = indication->getClientState() == ClientState::ClientStateType::Inactive ? "inactive" : "active";
+                return createSafeByteArray(XMLElement(tag, "urn:xmpp:csi:0").serialize());
+            }
+    };
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,6 +12,7 @@
 #include <Swiften/Base/String.h>
 #include <Swiften/Base/Log.h>
 #include <Swiften/Elements/Stanza.h>
+#include <Swiften/Elements/UnparsedPayload.h>
 #include <Swiften/Serializer/PayloadSerializer.h>
 #include <Swiften/Serializer/PayloadSerializerCollection.h>
 #include <Swiften/Serializer/XML/XMLElement.h>
@@ -47,7 +48,16 @@ SafeByteArray StanzaSerializer::serialize(std::shared_ptr<ToplevelElement> eleme
     setStanzaSpecificAttributes(stanza, stanzaElement);
 
     std::string serializedPayloads;
-    for (const auto& payload : stanza->getPayloads()) {
+    // Payloads whose parsing was deferred are written as received, unless
+    // they have been parsed (and possibly changed) in the meantime
+    const Payload::TypeID unparsedTypeID = Payload::getTypeID<UnparsedPayload>();
+    for (auto payload : stanza->getStoredPayloads()) {
+        if (payload && payload->getTypeID() == unparsedTypeID) {
+            const UnparsedPayload* unparsedPayload = static_cast<const UnparsedPayload*>(payload.get());
+            if (unparsedPayload->isParsed()) {
+                payload = unparsedPayload->getParsedPayload();
+            }
+        }
         PayloadSerializer* serializer = payloadSerializers_->getPayloadSerializer(payload);
         if (serializer) {
             serializedPayloads += serializer->serialize(payload);
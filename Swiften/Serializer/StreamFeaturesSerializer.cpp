@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -53,6 +53,9 @@ SafeByteArray StreamFeaturesSerializer::serialize(std::shared_ptr<ToplevelElemen
     if (streamFeatures->hasRosterVersioning()) {
         streamFeaturesElement.addNode(std::make_shared<XMLElement>("ver", "urn:xmpp:features:rosterver"));
     }
+    if (streamFeatures->hasClientStateIndication()) {
+        streamFeaturesElement.addNode(std::make_shared<XMLElement>("csi", "urn:xmpp:csi:0"));
+    }
     return createSafeByteArray(streamFeaturesElement.serialize());
 }
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -34,6 +34,7 @@ class StreamFeaturesSerializerTest : public CppUnit::TestFixture
             streamFeatures->setHasSession();
             streamFeatures->setHasStreamManagement();
             streamFeatures->setHasRosterVersioning();
+            streamFeatures->setHasClientStateIndication();
 
             CPPUNIT_ASSERT_EQUAL(createSafeByteArray(
                 "<stream:features>"
@@ -50,6 +51,7 @@ class StreamFeaturesSerializerTest : public CppUnit::TestFixture
                     "<session xmlns=\"urn:ietf:params:xml:ns:xmpp-session\"/>"
                     "<sm xmlns=\"urn:xmpp:sm:2\"/>"
                     "<ver xmlns=\"urn:xmpp:features:rosterver\"/>"
+                    "<csi xmlns=\"urn:xmpp:csi:0\"/>"
                 "</stream:features>"), testling.serialize(streamFeatures));
         }
 };
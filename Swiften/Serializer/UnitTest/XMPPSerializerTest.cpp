@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,6 +8,7 @@
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
 #include <Swiften/Elements/AuthChallenge.h>
+#include <Swiften/Elements/ClientStateIndication.h>
 #include <Swiften/Elements/ProtocolHeader.h>
 #include <Swiften/Serializer/PayloadSerializerCollection.h>
 #include <Swiften/Serializer/XMPPSerializer.h>
@@ -19,6 +20,7 @@ class XMPPSerializerTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testSerializeHeader_Client);
         CPPUNIT_TEST(testSerializeHeader_Component);
         CPPUNIT_TEST(testSerializeHeader_Server);
+        CPPUNIT_TEST(testSerializeClientStateIndication);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -63,6 +65,13 @@ class XMPPSerializerTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(std::string("<?xml version=\"1.0\"?><stream:stream xmlns=\"jabber:server\" xmlns:stream=\"http://etherx.jabber.org/streams\" from=\"bla@foo.com\" to=\"foo.com\" id=\"myid\" version=\"0.99\">"), testling->serializeHeader(protocolHeader));
         }
 
+        void testSerializeClientStateIndication() {
+            std::shared_ptr<XMPPSerializer> testling(createSerializer(ClientStreamType));
+
+            CPPUNIT_ASSERT_EQUAL(std::string("<inactive xmlns=\"urn:xmpp:csi:0\"/>"), safeByteArrayToString(testling->serializeElement(std::make_shared<ClientStateIndication>(ClientState::ClientStateType::Inactive))));
+            CPPUNIT_ASSERT_EQUAL(std::string("<active xmlns=\"urn:xmpp:csi:0\"/>"), safeByteArrayToString(testling->serializeElement(std::make_shared<ClientStateIndication>(ClientState::ClientStateType::Active))));
+        }
+
     private:
         XMPPSerializer* createSerializer(StreamType type) {
             return new XMPPSerializer(payloadSerializerCollection, type, false);
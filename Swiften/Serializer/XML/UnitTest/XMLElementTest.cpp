@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -21,6 +21,7 @@ class XMLElementTest : public CppUnit::TestFixture
         CPPUNIT_TEST(testSerialize_NoChildren);
         CPPUNIT_TEST(testSerialize_SpecialAttributeCharacters);
         CPPUNIT_TEST(testSerialize_EmptyAttributeValue);
+        CPPUNIT_TEST(testSerialize_LongText);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -65,6 +66,16 @@ class XMLElementTest : public CppUnit::TestFixture
 
             CPPUNIT_ASSERT_EQUAL(std::string("<foo myatt=\"\"/>"), testling.serialize());
         }
+
+        void testSerialize_LongText() {
+            std::string text = std::string(40, 'a') + "<&>'\"" + std::string(40, 'b') + "&";
+            XMLElement testling("foo", "", text);
+            testling.setAttribute("myatt", text);
+
+            std::string escapedText = std::string(40, 'a') + "&lt;&amp;&gt;'\"" + std::string(40, 'b') + "&amp;";
+            std::string escapedAttribute = std::string(40, 'a') + "&lt;&amp;&gt;&apos;&quot;" + std::string(40, 'b') + "&amp;";
+            CPPUNIT_ASSERT_EQUAL("<foo myatt=\"" + escapedAttribute + "\">" + escapedText + "</foo>", testling.serialize());
+        }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(XMLElementTest);
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Serializer/XML/XMLElement.h>
 
+#include <Swiften/Serializer/XML/XMLEscape.h>
 #include <Swiften/Serializer/XML/XMLTextNode.h>
 
 namespace Swift {
@@ -40,13 +41,7 @@ std::string XMLElement::serialize() {
 }
 
 void XMLElement::setAttribute(const std::string& attribute, const std::string& value) {
-    std::string escapedValue(value);
-    String::replaceAll(escapedValue, '&', "&amp;");
-    String::replaceAll(escapedValue, '<', "&lt;");
-    String::replaceAll(escapedValue, '>', "&gt;");
-    String::replaceAll(escapedValue, '\'', "&apos;");
-    String::replaceAll(escapedValue, '"', "&quot;");
-    attributes_[attribute] = escapedValue;
+    attributes_[attribute] = XMLEscape::escapeAttributeValue(value);
 }
 
 void XMLElement::addNode(std::shared_ptr<XMLNode> node) {
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Serializer/XML/XMLEscape.h>
+
+#include <Swiften/Base/ByteScan.h>
+
+namespace Swift {
+
+static std::string escape(const std::string& s, ByteScan::CharacterClass specialCharacters) {
+    size_t position = ByteScan::findFirst(s.data(), s.size(), specialCharacters);
+    if (position == s.size()) {
+        return s;
+    }
+    std::string result;
+    result.reserve(s.size() + 16);
+    size_t start = 0;
+    while (position < s.size()) {
+        result.append(s, start, position - start);
+        switch (s[position]) {
+            case '&': result += "&amp;"; break;
+            case '<': result += "&lt;"; break;
+            case '>': result += "&gt;"; break;
+            case '\'': result += "&apos;"; break;
+            case '"': result += "&quot;"; break;
+        }
+        start = position + 1;
+        position = start + ByteScan::findFirst(s.data() + start, s.size() - start, specialCharacters);
+    }
+    result.append(s, start, std::string::npos);
+    return result;
+}
+
+std::string XMLEscape::escapeText(const std::string& text) {
+    return escape(text, ByteScan::XMLTextSpecial);
+}
+
+std::string XMLEscape::escapeAttributeValue(const std::string& value) {
+    return escape(value, ByteScan::XMLAttributeSpecial);
+}
+
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2018 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <Swiften/Base/API.h>
+
+namespace Swift {
+    namespace XMLEscape {
+        /**
+         * Escapes '&', '<' and '>' for use as character data.
+         */
+        SWIFTEN_API std::string escapeText(const std::string& text);
+
+        /**
+         * Escapes '&', '<', '>', '\'' and '"' for use as an attribute value.
+         */
+        SWIFTEN_API std::string escapeAttributeValue(const std::string& value);
+    }
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,7 +9,7 @@
 #include <memory>
 
 #include <Swiften/Base/API.h>
-#include <Swiften/Base/String.h>
+#include <Swiften/Serializer/XML/XMLEscape.h>
 #include <Swiften/Serializer/XML/XMLNode.h>
 
 namespace Swift {
@@ -17,10 +17,7 @@ namespace Swift {
         public:
             typedef std::shared_ptr<XMLTextNode> ref;
 
-            XMLTextNode(const std::string& text) : text_(text) {
-                String::replaceAll(text_, '&', "&amp;"); // Should come first
-                String::replaceAll(text_, '<', "&lt;");
-                String::replaceAll(text_, '>', "&gt;");
+            XMLTextNode(const std::string& text) : text_(XMLEscape::escapeText(text)) {
             }
 
             std::string serialize() {
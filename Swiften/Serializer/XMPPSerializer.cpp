@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -18,6 +18,7 @@
 #include <Swiften/Serializer/AuthRequestSerializer.h>
 #include <Swiften/Serializer/AuthResponseSerializer.h>
 #include <Swiften/Serializer/AuthSuccessSerializer.h>
+#include <Swiften/Serializer/ClientStateIndicationSerializer.h>
 #include <Swiften/Serializer/ComponentHandshakeSerializer.h>
 #include <Swiften/Serializer/CompressFailureSerializer.h>
 #include <Swiften/Serializer/CompressRequestSerializer.h>
@@ -63,6 +64,7 @@ XMPPSerializer::XMPPSerializer(PayloadSerializerCollection* payloadSerializers,
     serializers_.push_back(std::make_shared<StanzaAckSerializer>());
     serializers_.push_back(std::make_shared<StanzaAckRequestSerializer>());
     serializers_.push_back(std::make_shared<ComponentHandshakeSerializer>());
+    serializers_.push_back(std::make_shared<ClientStateIndicationSerializer>());
 }
 
 std::string XMPPSerializer::serializeHeader(const ProtocolHeader& header) const {
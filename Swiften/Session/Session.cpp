@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -66,6 +66,7 @@ void Session::initializeStreamStack() {
     xmppLayer->onStreamStart.connect(
             boost::bind(&Session::handleStreamStart, this, _1));
     xmppLayer->onElement.connect(boost::bind(&Session::handleElement, this, _1));
+    xmppLayer->onStreamEnd.connect(boost::bind(&Session::handleStreamEnd, this));
     xmppLayer->onError.connect(
             boost::bind(&Session::finishSession, this, XMLError));
     xmppLayer->onDataRead.connect(boost::bind(boost::ref(onDataRead), _1));
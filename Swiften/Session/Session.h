@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2017 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,6 +13,7 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Elements/ToplevelElement.h>
 #include <Swiften/JID/JID.h>
 #include <Swiften/Network/Connection.h>
@@ -62,10 +63,10 @@ namespace Swift {
                 return remoteJID;
             }
 
-            boost::signals2::signal<void (std::shared_ptr<ToplevelElement>)> onElementReceived;
+            Signal<void (std::shared_ptr<ToplevelElement>)> onElementReceived;
             boost::signals2::signal<void (const boost::optional<SessionError>&)> onSessionFinished;
-            boost::signals2::signal<void (const SafeByteArray&)> onDataWritten;
-            boost::signals2::signal<void (const SafeByteArray&)> onDataRead;
+            Signal<void (const SafeByteArray&)> onDataWritten;
+            Signal<void (const SafeByteArray&)> onDataRead;
 
         protected:
             void setRemoteJID(const JID& j) {
@@ -82,6 +83,7 @@ namespace Swift {
             virtual void handleSessionFinished(const boost::optional<SessionError>&) {}
             virtual void handleElement(std::shared_ptr<ToplevelElement>) = 0;
             virtual void handleStreamStart(const ProtocolHeader&) = 0;
+            virtual void handleStreamEnd() {}
 
             void initializeStreamStack();
 
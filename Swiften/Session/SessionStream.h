@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -14,6 +14,7 @@
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/Error.h>
 #include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Elements/ProtocolHeader.h>
 #include <Swiften/Elements/ToplevelElement.h>
 #include <Swiften/TLS/Certificate.h>
@@ -76,11 +77,11 @@ namespace Swift {
 
             boost::signals2::signal<void (const ProtocolHeader&)> onStreamStartReceived;
             boost::signals2::signal<void ()> onStreamEndReceived;
-            boost::signals2::signal<void (std::shared_ptr<ToplevelElement>)> onElementReceived;
+            Signal<void (std::shared_ptr<ToplevelElement>)> onElementReceived;
             boost::signals2::signal<void (std::shared_ptr<Error>)> onClosed;
             boost::signals2::signal<void ()> onTLSEncrypted;
-            boost::signals2::signal<void (const SafeByteArray&)> onDataRead;
-            boost::signals2::signal<void (const SafeByteArray&)> onDataWritten;
+            Signal<void (const SafeByteArray&)> onDataRead;
+            Signal<void (const SafeByteArray&)> onDataWritten;
 
         protected:
             CertificateWithKey::ref getTLSCertificate() const {
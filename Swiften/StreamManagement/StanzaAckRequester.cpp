@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -19,6 +19,9 @@ StanzaAckRequester::StanzaAckRequester() : lastHandledStanzasCount(0) {
 
 }
 
+StanzaAckRequester::StanzaAckRequester(unsigned int handledStanzasCount, const std::deque<std::shared_ptr<Stanza> >& unackedStanzas) : lastHandledStanzasCount(handledStanzasCount), unackedStanzas(unackedStanzas) {
+}
+
 void StanzaAckRequester::handleStanzaSent(std::shared_ptr<Stanza> stanza) {
     unackedStanzas.push_back(stanza);
     if (std::dynamic_pointer_cast<Message>(stanza)) {
@@ -41,4 +44,10 @@ void StanzaAckRequester::handleAckReceived(unsigned int handledStanzasCount) {
     lastHandledStanzasCount = handledStanzasCount;
 }
 
+std::deque<std::shared_ptr<Stanza> > StanzaAckRequester::takeUnackedStanzas() {
+    std::deque<std::shared_ptr<Stanza> > result;
+    result.swap(unackedStanzas);
+    return result;
+}
+
 }
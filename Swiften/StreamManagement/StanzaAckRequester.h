@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -19,9 +19,28 @@ namespace Swift {
         public:
             StanzaAckRequester();
 
+            /**
+             * Continues the counting of a previous (resumed) stream.
+             */
+            StanzaAckRequester(unsigned int handledStanzasCount, const std::deque<std::shared_ptr<Stanza> >& unackedStanzas);
+
             void handleStanzaSent(std::shared_ptr<Stanza> stanza);
             void handleAckReceived(unsigned int handledStanzasCount);
 
+            unsigned int getHandledStanzasCount() const {
+                return lastHandledStanzasCount;
+            }
+
+            const std::deque<std::shared_ptr<Stanza> >& getUnackedStanzas() const {
+                return unackedStanzas;
+            }
+
+            /**
+             * Removes all unacked stanzas, e.g. to resend them on a resumed
+             * stream.
+             */
+            std::deque<std::shared_ptr<Stanza> > takeUnackedStanzas();
+
         public:
             boost::signals2::signal<void ()> onRequestAck;
             boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
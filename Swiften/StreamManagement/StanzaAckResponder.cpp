@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,7 +12,7 @@ namespace Swift {
 
 static const unsigned int MAX_HANDLED_STANZA_COUNT = boost::numeric_cast<unsigned int>((1ULL<<32) - 1);
 
-StanzaAckResponder::StanzaAckResponder() : handledStanzasCount(0) {
+StanzaAckResponder::StanzaAckResponder(unsigned int handledStanzasCount) : handledStanzasCount(handledStanzasCount) {
 }
 
 void StanzaAckResponder::handleStanzaReceived() {
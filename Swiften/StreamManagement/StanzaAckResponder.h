@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,11 +16,15 @@
 namespace Swift {
     class SWIFTEN_API StanzaAckResponder {
         public:
-            StanzaAckResponder();
+            StanzaAckResponder(unsigned int handledStanzasCount = 0);
 
             void handleStanzaReceived();
             void handleAckRequestReceived();
 
+            unsigned int getHandledStanzasCount() const {
+                return handledStanzasCount;
+            }
+
         public:
             boost::signals2::signal<void (unsigned int /* handledStanzaCount */)> onAck;
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -23,7 +23,8 @@ XMPPLayer::XMPPLayer(
             xmlParserFactory_(xmlParserFactory),
             setExplictNSonTopLevelElements_(setExplictNSonTopLevelElements),
             resetParserAfterParse_(false),
-            inParser_(false) {
+            inParser_(false),
+            lazyPayloadParsing_(false) {
     xmppParser_ = new XMPPParser(this, payloadParserFactories_, xmlParserFactory);
     xmppSerializer_ = new XMPPSerializer(payloadSerializers_, streamType, setExplictNSonTopLevelElements);
 }
@@ -74,6 +75,7 @@ void XMPPLayer::handleDataRead(const SafeByteArray& data) {
 void XMPPLayer::doResetParser() {
     delete xmppParser_;
     xmppParser_ = new XMPPParser(this, payloadParserFactories_, xmlParserFactory_);
+    xmppParser_->setLazyPayloadParsing(lazyPayloadParsing_);
     resetParserAfterParse_ = false;
 }
 
@@ -89,6 +91,11 @@ void XMPPLayer::handleStreamEnd() {
     onStreamEnd();
 }
 
+void XMPPLayer::setLazyPayloadParsing(bool lazy) {
+    lazyPayloadParsing_ = lazy;
+    xmppParser_->setLazyPayloadParsing(lazy);
+}
+
 void XMPPLayer::resetParser() {
     if (inParser_) {
         resetParserAfterParse_ = true;
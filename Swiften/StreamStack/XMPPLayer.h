@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,6 +13,7 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Base/Signal.h>
 #include <Swiften/Elements/StreamType.h>
 #include <Swiften/Elements/ToplevelElement.h>
 #include <Swiften/Parser/XMPPParserClient.h>
@@ -45,6 +46,14 @@ namespace Swift {
 
             void resetParser();
 
+            /**
+             * Sets whether the parsing of received stanza payloads is
+             * deferred until they are looked up.
+             *
+             * \see StanzaParser::setLazyPayloadParsing
+             */
+            void setLazyPayloadParsing(bool lazy);
+
         protected:
             void handleDataRead(const SafeByteArray& data);
             void writeDataInternal(const SafeByteArray& data);
@@ -52,9 +61,9 @@ namespace Swift {
         public:
             boost::signals2::signal<void (const ProtocolHeader&)> onStreamStart;
             boost::signals2::signal<void ()> onStreamEnd;
-            boost::signals2::signal<void (std::shared_ptr<ToplevelElement>)> onElement;
-            boost::signals2::signal<void (const SafeByteArray&)> onWriteData;
-            boost::signals2::signal<void (const SafeByteArray&)> onDataRead;
+            Signal<void (std::shared_ptr<ToplevelElement>)> onElement;
+            Signal<void (const SafeByteArray&)> onWriteData;
+            Signal<void (const SafeByteArray&)> onDataRead;
             boost::signals2::signal<void ()> onError;
 
         private:
@@ -73,5 +82,6 @@ namespace Swift {
             bool setExplictNSonTopLevelElements_;
             bool resetParserAfterParse_;
             bool inParser_;
+            bool lazyPayloadParsing_;
     };
 }
@@ -6,6 +6,8 @@
 
 #include <Swiften/TLS/OpenSSL/OpenSSLCertificateFactory.h>
 
+#include <limits>
+
 #include <openssl/pem.h>
 
 namespace Swift {
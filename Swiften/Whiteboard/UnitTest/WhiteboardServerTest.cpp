@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2016 Isode Limited.
+ * Copyright (c) 2016-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -30,6 +30,8 @@ class WhiteboardServerTest : public CppUnit::TestFixture {
     CPPUNIT_TEST(testSimpleOp1);
     CPPUNIT_TEST(testSimpleOp2);
     CPPUNIT_TEST(testFewSimpleOps);
+    CPPUNIT_TEST(testHistoryCompaction);
+    CPPUNIT_TEST(testUnknownParent);
     CPPUNIT_TEST_SUITE_END();
 public:
     void testSimpleOp() {
@@ -130,6 +132,69 @@ public:
         CPPUNIT_ASSERT_EQUAL(1, op->getPos());
         CPPUNIT_ASSERT_EQUAL(clientElement, std::dynamic_pointer_cast<WhiteboardEllipseElement>(op->getElement()));
     }
+    void testHistoryCompaction() {
+        WhiteboardServer server;
+        WhiteboardInsertOperation::ref serverOp = std::make_shared<WhiteboardInsertOperation>();
+        serverOp->setID("0");
+        server.handleLocalOperationReceived(serverOp);
+        std::string parentID = "0";
+        for (const std::string& id : {"a", "b", "c"}) {
+            serverOp = std::make_shared<WhiteboardInsertOperation>();
+            serverOp->setID(id);
+            serverOp->setParentID(parentID);
+            serverOp->setPos(1);
+            server.handleLocalOperationReceived(serverOp);
+            parentID = id;
+        }
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), server.getHistorySize());
+
+        WhiteboardInsertOperation::ref clientOp = std::make_shared<WhiteboardInsertOperation>();
+        clientOp->setID("d");
+        clientOp->setParentID("a");
+        clientOp->setPos(1);
+        WhiteboardOperation::ref op = server.handleClientOperationReceived(clientOp);
+        CPPUNIT_ASSERT_EQUAL(std::string("c"), op->getParentID());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), server.getHistorySize());
+
+        serverOp = std::make_shared<WhiteboardInsertOperation>();
+        serverOp->setID("e");
+        serverOp->setParentID("d");
+        serverOp->setPos(1);
+        server.handleLocalOperationReceived(serverOp);
+        clientOp = std::make_shared<WhiteboardInsertOperation>();
+        clientOp->setID("f");
+        clientOp->setParentID("d");
+        clientOp->setPos(1);
+        op = server.handleClientOperationReceived(clientOp);
+        CPPUNIT_ASSERT_EQUAL(std::string("e"), op->getParentID());
+        CPPUNIT_ASSERT_EQUAL(std::string("f"), op->getID());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), server.getHistorySize());
+
+        clientOp = std::make_shared<WhiteboardInsertOperation>();
+        clientOp->setID("g");
+        clientOp->setParentID("f");
+        clientOp->setPos(1);
+        op = server.handleClientOperationReceived(clientOp);
+        CPPUNIT_ASSERT_EQUAL(std::string("f"), op->getParentID());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), server.getHistorySize());
+    }
+
+    void testUnknownParent() {
+        WhiteboardServer server;
+        WhiteboardInsertOperation::ref firstOp = std::make_shared<WhiteboardInsertOperation>();
+        firstOp->setID("0");
+        server.handleLocalOperationReceived(firstOp);
+        WhiteboardInsertOperation::ref serverOp = std::make_shared<WhiteboardInsertOperation>();
+        serverOp->setID("a");
+        serverOp->setParentID("0");
+        serverOp->setPos(1);
+        server.handleLocalOperationReceived(serverOp);
+        WhiteboardInsertOperation::ref clientOp = std::make_shared<WhiteboardInsertOperation>();
+        clientOp->setID("b");
+        clientOp->setParentID("x");
+        clientOp->setPos(1);
+        CPPUNIT_ASSERT(!server.handleClientOperationReceived(clientOp));
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(WhiteboardServerTest);
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2016 Isode Limited.
+ * Copyright (c) 2016-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -17,41 +17,62 @@
 #include <Swiften/Whiteboard/WhiteboardTransformer.h>
 
 namespace Swift {
+    WhiteboardServer::WhiteboardServer() {
+    }
+
     void WhiteboardServer::handleLocalOperationReceived(WhiteboardOperation::ref operation) {
         operations_.push_back(operation);
     }
 
     WhiteboardOperation::ref WhiteboardServer::handleClientOperationReceived(WhiteboardOperation::ref newOperation) {
-        std::list<WhiteboardOperation::ref>::reverse_iterator it;
         if (operations_.empty() || newOperation->getParentID() == operations_.back()->getID()) {
+            if (!operations_.empty()) {
+                removeOperationsBefore(operations_.size() - 1);
+            }
             operations_.push_back(newOperation);
             return newOperation;
         }
-        for (it = operations_.rbegin(); it != operations_.rend(); ++it) {
-            WhiteboardOperation::ref operation = *it;
-            while (newOperation->getParentID() == operation->getParentID()) {
-                std::pair<WhiteboardOperation::ref, WhiteboardOperation::ref> tResult = WhiteboardTransformer::transform(newOperation, operation);
-
-                if (it == operations_.rbegin()) {
-                    operations_.push_back(tResult.second);
-                    return tResult.second;
-                } else {
-                    newOperation = tResult.second;
-                    --it;
-                    operation = *it;
-                }
 
+        // The first concurrent operation is the one following the client's
+        // parent. Looking for the parent from the end takes as many steps
+        // as transforming against the operations after it, so the history
+        // is not indexed.
+        size_t index = operations_.size();
+        while (index > 0 && operations_[index - 1]->getID() != newOperation->getParentID()) {
+            --index;
+        }
+        if (index > 0) {
+            removeOperationsBefore(index - 1);
+            index = 1;
+        }
+        else if (operations_.front()->getParentID() != newOperation->getParentID()) {
+            return WhiteboardOperation::ref();
+        }
+
+        for (; index < operations_.size(); ++index) {
+            WhiteboardOperation::ref operation = operations_[index];
+            if (newOperation->getParentID() != operation->getParentID()) {
+                return WhiteboardOperation::ref();
             }
+            newOperation = WhiteboardTransformer::transform(newOperation, operation).second;
         }
-        return WhiteboardOperation::ref();
+        operations_.push_back(newOperation);
+        return newOperation;
     }
 
     void WhiteboardServer::print() {
-        std::list<WhiteboardOperation::ref>::iterator it;
         std::cout << "Server:" << std::endl;
-        for(it = operations_.begin(); it != operations_.end(); ++it) {
-            std::cout << (*it)->getID() << " " << (*it)->getPos() << std::endl;
+        for (const auto& operation : operations_) {
+            std::cout << operation->getID() << " " << operation->getPos() << std::endl;
         }
     }
 
+    size_t WhiteboardServer::getHistorySize() const {
+        return operations_.size();
+    }
+
+    void WhiteboardServer::removeOperationsBefore(size_t index) {
+        operations_.erase(operations_.begin(), operations_.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+
 }
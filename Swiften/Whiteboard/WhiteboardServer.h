@@ -5,26 +5,45 @@
  */
 
 /*
- * Copyright (c) 2016 Isode Limited.
+ * Copyright (c) 2016-2018 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
-#include <list>
+#include <cstddef>
+#include <deque>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Elements/Whiteboard/WhiteboardInsertOperation.h>
 
 namespace Swift {
+    /**
+     * Keeps the server side operation history of a whiteboard session.
+     *
+     * Every client operation acknowledges the operation it is based on.
+     * The client never refers to earlier operations after that, so they
+     * are removed from the history, which only holds the operations that
+     * are in flight.
+     */
     class SWIFTEN_API WhiteboardServer {
     public:
+        WhiteboardServer();
+
         void handleLocalOperationReceived(WhiteboardOperation::ref operation);
         WhiteboardOperation::ref handleClientOperationReceived(WhiteboardOperation::ref operation);
         void print();
 
+        /**
+         * Returns the number of operations kept in the history.
+         */
+        size_t getHistorySize() const;
+
+    private:
+        void removeOperationsBefore(size_t index);
+
     private:
-        std::list<WhiteboardOperation::ref> operations_;
+        std::deque<WhiteboardOperation::ref> operations_;
     };
 }